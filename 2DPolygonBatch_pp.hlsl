@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// Batched 2D Polygon Post-Processing Vertex Shader
+//--------------------------------------------------------------------------------------
+// Same as the 2DPolygon_pp shader, but draws many polygons in one draw call using instancing. The points of
+// each polygon come from a structured buffer rather than the constant buffer, one element per instance
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Polygons
+//--------------------------------------------------------------------------------------
+
+// The polygons to draw, filled in by the C++ side (see PolygonBatch.h). Also read by the PolygonBatch_pp pixel shader
+StructuredBuffer<PolygonInstance> PolygonInstances : register(t3);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+// Each instance is a four point polygon, the vertex ID picks the point and the instance ID picks the polygon
+PolygonBatchInput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
+{
+	PolygonBatchInput output;
+
+	// Fixed UVs for the polygon, as in 2DPolygon_pp
+	const float2 polygonUVs[4] = { float2(0.0, 0.0),   // Top-left
+					               float2(0.0, 1.0),   // Bottom-left
+						           float2(1.0, 0.0),   // Top-right
+						           float2(1.0, 1.0) }; // Bottom-right
+
+	output.projectedPosition = PolygonInstances[instanceId].points[vertexId];
+	output.areaUV = polygonUVs[vertexId];
+	output.sceneUV = (output.projectedPosition.xy / output.projectedPosition.w + 1.0f) * 0.5f;
+	output.sceneUV.y = 1.0f - output.sceneUV.y;
+
+	// Pass on which polygon this is so the pixel shader can pick the effect
+	output.polygon = instanceId;
+
+	return output;
+}
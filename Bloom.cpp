@@ -0,0 +1,16 @@
+//--------------------------------------------------------------------------------------
+// Bloom as a chain of smaller images
+//--------------------------------------------------------------------------------------
+
+#include "Bloom.h"
+
+
+BloomDownsampleConstants MakeBloomDownsampleConstants(const PostProcessEffectConstants& settings, bool firstLevel)
+{
+	BloomDownsampleConstants constants = {};
+	constants.bloomThreshold = settings.brightPass.bloomThreshold;
+	constants.bloomKnee      = settings.brightPass.bloomKnee;
+	constants.exposure       = settings.brightPass.exposure;
+	constants.firstLevel     = firstLevel ? 1 : 0;
+	return constants;
+}
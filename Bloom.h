@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// Bloom as a chain of smaller images
+//--------------------------------------------------------------------------------------
+// Bloom used to be five chain entries at full size: a bright pass, a horizontal and a vertical
+// Gaussian blur, the lens star and the final composite, with the first two images kept alive for
+// the last. It is now one effect, which the render graph expands into its own passes (see
+// RenderGraph::Compile):
+//
+// - Downsample: each pass halves the size of the image before it with 13 bilinear taps, spread
+//   over a 4x4 pixel footprint as five overlapping boxes. The first level reads the scene, picks
+//   out its bright parts with the bright pass settings and weights each box by 1 / (1 + luminance)
+//   so single very bright pixels don't flicker as they move. BLOOM_LEVELS levels, from half size.
+// - Upsample: from the smallest level back up to half size, each pass blurs the level below with
+//   a 3x3 tent filter and adds this level's downsample to it. The sum of all the levels is a wide,
+//   smooth glow that no single Gaussian blur at full size could afford.
+// - The lens star is made from the quarter size downsample by a few passes along each of its
+//   streaks, all at quarter size (see LensStar.h).
+// - The composite (Bloom_pp.hlsl) adds the glow and the star to the full size image.
+//
+// Every pass but the last works on an image a quarter of the size of the one before or smaller,
+// so all of them together cost less than a single full size pass. The images between the passes
+// are 16-bit float so the bright parts keep their range.
+//
+// The shaders are BloomDownsample_pp.hlsl and BloomUpsample_pp.hlsl, CPUBloom.h has the CPU
+// versions. No DirectX here
+
+#ifndef _BLOOM_H_INCLUDED_
+#define _BLOOM_H_INCLUDED_
+
+#include "PostProcessConstants.h"
+
+
+// Number of downsampled images, the first at half size and each one after half the size of the one before
+const int BLOOM_LEVELS = 6;
+
+// The size divisor of the downsampled image the lens star reads, and of the images its streak passes write
+const int BLOOM_STAR_SIZE_DIVISOR = 4;
+
+
+// Settings for a downsample pass, from the bright pass settings of the effects. Only the first level (reading the full size
+// image) picks out the bright parts
+BloomDownsampleConstants MakeBloomDownsampleConstants(const PostProcessEffectConstants& settings, bool firstLevel);
+
+
+#endif //_BLOOM_H_INCLUDED_
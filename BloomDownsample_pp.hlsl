@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------------
+// Bloom Downsample Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Writes one of the bloom's downsampled images, half the size of the image it reads (see
+// Bloom.h). 13 bilinear taps spread over 4x4 pixels of the source are averaged as five
+// overlapping boxes of four: the one in the middle weighted 0.5 and the four at the corners
+// 0.125 each. This keeps the glow smooth where a plain 2x2 average would flicker and leave blocks.
+// The first level also picks out the bright parts of the scene with the bright pass settings,
+// weighting each box by 1 / (1 + luminance) so a single very bright pixel can't outweigh the rest
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this pass, must match BloomDownsampleConstants in PostProcessConstants.h
+cbuffer BloomDownsampleConstants : register(b2)
+{
+	float gBloomThreshold;
+	float gBloomKnee;
+	float gExposure;
+	int   gFirstLevel; // 1 when reading the full size image
+}
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SourceTexture : register(t0);
+SamplerState LinearSample  : register(s1); // Bilinear filtering, clamped at the edges
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float Luminance(float3 colour)
+{
+	return dot(colour, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Add the average of four taps to the total with the given weight, reduced for bright boxes on the first level
+void AddBox(float3 a, float3 b, float3 c, float3 d, float boxWeight, inout float3 total, inout float totalWeight)
+{
+	float3 average = (a + b + c + d) * 0.25f;
+	float weight = gFirstLevel ? boxWeight / (1.0f + Luminance(average)) : boxWeight;
+	total += average * weight;
+	totalWeight += weight;
+}
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float2 sourceSize;
+	SourceTexture.GetDimensions(sourceSize.x, sourceSize.y);
+	float2 texel = 1.0f / sourceSize;
+	float2 uv = input.sceneUV;
+
+	// Outer taps two source pixels apart, each reading between four pixels
+	float3 tapA = SourceTexture.Sample(LinearSample, uv + texel * float2(-2, -2)).rgb;
+	float3 tapB = SourceTexture.Sample(LinearSample, uv + texel * float2( 0, -2)).rgb;
+	float3 tapC = SourceTexture.Sample(LinearSample, uv + texel * float2( 2, -2)).rgb;
+	float3 tapD = SourceTexture.Sample(LinearSample, uv + texel * float2(-2,  0)).rgb;
+	float3 tapE = SourceTexture.Sample(LinearSample, uv).rgb;
+	float3 tapF = SourceTexture.Sample(LinearSample, uv + texel * float2( 2,  0)).rgb;
+	float3 tapG = SourceTexture.Sample(LinearSample, uv + texel * float2(-2,  2)).rgb;
+	float3 tapH = SourceTexture.Sample(LinearSample, uv + texel * float2( 0,  2)).rgb;
+	float3 tapI = SourceTexture.Sample(LinearSample, uv + texel * float2( 2,  2)).rgb;
+
+	// Inner taps, the 4x4 pixels around the output pixel
+	float3 tapJ = SourceTexture.Sample(LinearSample, uv + texel * float2(-1, -1)).rgb;
+	float3 tapK = SourceTexture.Sample(LinearSample, uv + texel * float2( 1, -1)).rgb;
+	float3 tapL = SourceTexture.Sample(LinearSample, uv + texel * float2(-1,  1)).rgb;
+	float3 tapM = SourceTexture.Sample(LinearSample, uv + texel * float2( 1,  1)).rgb;
+
+	float3 total = float3(0.0f, 0.0f, 0.0f);
+	float totalWeight = 0.0f;
+	AddBox(tapJ, tapK, tapL, tapM, 0.5f,   total, totalWeight);
+	AddBox(tapA, tapB, tapD, tapE, 0.125f, total, totalWeight);
+	AddBox(tapB, tapC, tapE, tapF, 0.125f, total, totalWeight);
+	AddBox(tapD, tapE, tapG, tapH, 0.125f, total, totalWeight);
+	AddBox(tapE, tapF, tapH, tapI, 0.125f, total, totalWeight);
+	float3 outputColour = total / totalWeight;
+
+	// Keep just the bright parts, as the bright pass does
+	if (gFirstLevel)
+	{
+		outputColour *= gExposure;
+		float soft = smoothstep(gBloomThreshold, gBloomThreshold + gBloomKnee, Luminance(outputColour));
+		outputColour *= soft;
+	}
+
+	return float4(outputColour, 1.0f);
+}
@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// Bloom Upsample Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Writes one of the bloom's upsampled images (see Bloom.h): the upsampled image of the level
+// below, half the size, blurred with a 3x3 tent filter as it is scaled up, plus the downsampled
+// image of this level. Each level below has been blurred once more, so the sum at the top is a
+// wide glow with a bright core
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    LowerTexture : register(t0); // The level below, half the size
+Texture2D    LevelTexture : register(t1); // The downsample of this level, the size of the target
+SamplerState LinearSample : register(s1); // Bilinear filtering, clamped at the edges
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float2 lowerSize;
+	LowerTexture.GetDimensions(lowerSize.x, lowerSize.y);
+	float2 texel = 1.0f / lowerSize;
+
+	// Tent weights 1 2 1 along each axis, 16 in all
+	static const float tentWeights[3] = { 1.0f, 2.0f, 1.0f };
+	float3 lowerColour = float3(0.0f, 0.0f, 0.0f);
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			float weight = tentWeights[x + 1] * tentWeights[y + 1] / 16.0f;
+			lowerColour += LowerTexture.Sample(LinearSample, input.sceneUV + texel * float2(x, y)).rgb * weight;
+		}
+	}
+
+	float3 levelColour = LevelTexture.Sample(LinearSample, input.sceneUV).rgb;
+	return float4(lowerColour + levelColour, 1.0f);
+}
@@ -4,21 +4,33 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match BloomConstants in PostProcessConstants.h
+cbuffer BloomConstants : register(b2)
+{
+	float  gBloomIntensity;
+	float  gStarIntensity;
+	float2 paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
 
-// Scene (original)
+// Image the bloom is added to
 Texture2D SceneTexture : register(t0);
 SamplerState PointSample : register(s0);
 
-// Bloom-blurred texture
+// Glow, the sum of the bloom's levels at half size (see Bloom.h)
 Texture2D BloomTexture : register(t1);
-SamplerState LinearSample : register(s1);
+SamplerState LinearSample : register(s1); // Bilinear filtering, clamped at the edges - the glow and star are smaller than the target
 
-// Lens Star texture
+// Lens star, at quarter size
 Texture2D StarTexture : register(t2);
-SamplerState LinearSample2 : register(s2);
 
 //--------------------------------------------------------------------------------------
 // Shader Code
@@ -33,7 +45,7 @@ float4 main(PostProcessingInput input) : SV_Target
     float3 bloomColour = BloomTexture.Sample(LinearSample, input.sceneUV).rgb;
 
     // Sample the star effect texture
-    float3 starColour = StarTexture.Sample(LinearSample2, input.sceneUV).rgb;
+    float3 starColour = StarTexture.Sample(LinearSample, input.sceneUV).rgb;
 
     // Combine bloom and star effect (Additive Blending)
     float3 outputColour = sceneColour + bloomColour * gBloomIntensity + starColour * gStarIntensity;
@@ -3,6 +3,20 @@
 //--------------------------------------------------------------------------------------
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match BrightPassConstants in PostProcessConstants.h
+cbuffer BrightPassConstants : register(b2)
+{
+	float  gBloomThreshold;
+	float  gExposure;
+	float  gBloomKnee;
+	float  paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
@@ -6,6 +6,18 @@
 #include "Common.hlsli"
 
 
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match BurnConstants in PostProcessConstants.h
+cbuffer BurnConstants : register(b2)
+{
+	float  gBurnHeight;
+	float3 paddingA;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
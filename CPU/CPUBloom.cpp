@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------------------
+// Bloom images on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUBloom.h"
+
+#include <algorithm>
+#include <vector>
+
+
+static CVector3 RGB(const CVector4& colour)  { return { colour.x, colour.y, colour.z }; }
+
+static float Luminance(const CVector3& colour)
+{
+	return Dot(colour, CVector3(0.2126f, 0.7152f, 0.0722f));
+}
+
+static float SmoothStep(float edge0, float edge1, float x)
+{
+	float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+// Fill the target with opaque black, as a pass reading an unbound texture would
+static void FillBlack(CPUImage& target)
+{
+	std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+	for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+}
+
+
+//--------------------------------------------------------------------------------------
+// Passes
+//--------------------------------------------------------------------------------------
+
+// BloomDownsample_pp.hlsl for one pixel
+static CVector3 DownsamplePixel(const BloomDownsampleConstants& constants, const CPUImage& source, const CVector2& uv, const CVector2& texel)
+{
+	auto tap = [&](float x, float y)  { return RGB(source.SampleBilinear(uv + CVector2(x * texel.x, y * texel.y))); };
+	CVector3 tapA = tap(-2, -2), tapB = tap(0, -2), tapC = tap(2, -2);
+	CVector3 tapD = tap(-2,  0), tapE = tap(0,  0), tapF = tap(2,  0);
+	CVector3 tapG = tap(-2,  2), tapH = tap(0,  2), tapI = tap(2,  2);
+	CVector3 tapJ = tap(-1, -1), tapK = tap(1, -1), tapL = tap(-1, 1), tapM = tap(1, 1);
+
+	CVector3 total = { 0.0f, 0.0f, 0.0f };
+	float totalWeight = 0.0f;
+	auto addBox = [&](const CVector3& a, const CVector3& b, const CVector3& c, const CVector3& d, float boxWeight)
+	{
+		CVector3 average = (a + b + c + d) * 0.25f;
+		float weight = constants.firstLevel ? boxWeight / (1.0f + Luminance(average)) : boxWeight;
+		total += average * weight;
+		totalWeight += weight;
+	};
+	addBox(tapJ, tapK, tapL, tapM, 0.5f);
+	addBox(tapA, tapB, tapD, tapE, 0.125f);
+	addBox(tapB, tapC, tapE, tapF, 0.125f);
+	addBox(tapD, tapE, tapG, tapH, 0.125f);
+	addBox(tapE, tapF, tapH, tapI, 0.125f);
+	CVector3 outputColour = total / totalWeight;
+
+	if (constants.firstLevel)
+	{
+		outputColour *= constants.exposure;
+		outputColour *= SmoothStep(constants.bloomThreshold, constants.bloomThreshold + constants.bloomKnee, Luminance(outputColour));
+	}
+	return outputColour;
+}
+
+
+void CPUBloomDownsample(const BloomDownsampleConstants& constants, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* source = context.inputs[0];
+	if (!source)
+	{
+		FillBlack(target);
+		return;
+	}
+
+	CVector2 texel = { 1.0f / source->Width(), 1.0f / source->Height() };
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			for (int x = tile.left; x < tile.right; ++x)
+			{
+				CVector2 uv = { (x + 0.5f) / target.Width(), (y + 0.5f) / target.Height() };
+				rowBuffer[x - tile.left] = CVector4(DownsamplePixel(constants, *source, uv, texel), 1.0f);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
+
+
+void CPUBloomUpsample(const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* lower = context.inputs[0];
+	const CPUImage* level = context.inputs[1];
+	if (!lower || !level)
+	{
+		FillBlack(target);
+		return;
+	}
+
+	// BloomUpsample_pp.hlsl - tent weights 1 2 1 along each axis
+	const float tentWeights[3] = { 1.0f, 2.0f, 1.0f };
+	CVector2 texel = { 1.0f / lower->Width(), 1.0f / lower->Height() };
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			for (int x = tile.left; x < tile.right; ++x)
+			{
+				CVector2 uv = { (x + 0.5f) / target.Width(), (y + 0.5f) / target.Height() };
+				CVector3 lowerColour = { 0.0f, 0.0f, 0.0f };
+				for (int tapY = -1; tapY <= 1; ++tapY)
+				{
+					for (int tapX = -1; tapX <= 1; ++tapX)
+					{
+						float weight = tentWeights[tapX + 1] * tentWeights[tapY + 1] / 16.0f;
+						lowerColour += RGB(lower->SampleBilinear(uv + CVector2(tapX * texel.x, tapY * texel.y))) * weight;
+					}
+				}
+				CVector3 levelColour = RGB(level->SampleBilinear(uv));
+				rowBuffer[x - tile.left] = CVector4(lowerColour + levelColour, 1.0f);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
@@ -0,0 +1,25 @@
+//--------------------------------------------------------------------------------------
+// Bloom images on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU versions of BloomDownsample_pp.hlsl and BloomUpsample_pp.hlsl, which make the bloom's
+// glow (see Bloom.h). Each reads its inputs bilinearly at the same places the shaders do, so the
+// results match them other than rounding. Rows of the target are shared between the threads of
+// the pass's pool.
+
+#ifndef _CPU_BLOOM_H_INCLUDED_
+#define _CPU_BLOOM_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Write the next downsampled image to the whole target from input 0, which should be twice its size
+void CPUBloomDownsample(const BloomDownsampleConstants& constants, const CPUPassContext& context, CPUImage& target);
+
+// Write the next upsampled image to the whole target: input 0 (the level below, half the size) blurred with a tent filter,
+// plus input 1 (the downsample of this level, the same size)
+void CPUBloomUpsample(const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_BLOOM_H_INCLUDED_
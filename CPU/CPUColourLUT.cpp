@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------
+// Baking pure colour effects into 3D colour LUTs
+//--------------------------------------------------------------------------------------
+
+#include "CPUColourLUT.h"
+#include "CPUPostProcess.h"
+
+#include <chrono>
+#include <cstring>
+
+
+// The settings the effect's result depends on, compared to see if the LUT needs baking again. Effects declared with
+// colourLUT that have settings must be listed here
+static ConstantBlock LUTSettings(PostProcess postProcess, const PostProcessEffectConstants& settings)
+{
+	switch (postProcess)
+	{
+	case PostProcess::Tint:  return MakeConstantBlock(settings.tint);
+	default:                 return ConstantBlock(); // Invert, sepia
+	}
+}
+
+
+bool ColourLUT::Update(PostProcess postProcess, const PostProcessEffectConstants& settings, int size /*= COLOUR_LUT_SIZE*/)
+{
+	ConstantBlock block = LUTSettings(postProcess, settings);
+	const uint8_t* blockBytes = static_cast<const uint8_t*>(block.data);
+	if (mNumBakes > 0 && postProcess == mEffect && size == mSize && block.size == static_cast<int>(mBakedSettings.size()) &&
+	    (block.size == 0 || std::memcmp(blockBytes, mBakedSettings.data(), block.size) == 0))
+	{
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Every colour of the grid in one image, size pixels wide and one row for each green and blue: pixel (r, g + size * b)
+	// So the rows of the image are the LUT entries in order
+	CPUImage grid(size, size * size, TargetFormat::RGBA16F);
+	float step = 1.0f / (size - 1);
+	for (int b = 0; b < size; ++b)
+	{
+		for (int g = 0; g < size; ++g)
+		{
+			CVector4* row = grid.Row(g + size * b);
+			for (int r = 0; r < size; ++r)  row[r] = CVector4(r * step, g * step, b * step, 1.0f);
+		}
+	}
+
+	// Run the effect over it. Each pixel only reads its own colour, so the image's layout doesn't matter to the effect
+	CPUPassContext context;
+	context.inputs[0]       = &grid;
+	context.effectConstants = &settings;
+	context.viewportWidth   = grid.Width();
+	context.viewportHeight  = grid.Height();
+	CPUImage results(grid.Width(), grid.Height(), TargetFormat::RGBA16F);
+	CPUFullScreenPostProcess(postProcess, context, results);
+
+	mEntries.resize(static_cast<size_t>(size) * size * size);
+	for (int y = 0; y < results.Height(); ++y)
+	{
+		std::memcpy(&mEntries[static_cast<size_t>(y) * size], results.Row(y), size * sizeof(CVector4));
+	}
+
+	mEffect = postProcess;
+	mSize   = size;
+	mBakedSettings.assign(blockBytes, blockBytes + block.size);
+	++mNumBakes;
+	mLastBakeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------
+// Baking pure colour effects into 3D colour LUTs
+//--------------------------------------------------------------------------------------
+// An effect whose output depends only on the colour of the pixel it is drawing (see colourLUT in
+// PostProcessDeclaration) is a function from one colour to another. Run over a grid of colours,
+// its results make a 3D lookup table (LUT): finding a colour in the grid and blending the nearest
+// entries gives the effect's result without doing any of its maths, however much there is.
+//
+// The LUT is baked by running the effect's own CPU version (CPUPostProcess.h) over an image
+// holding every colour of the grid, so any such effect can be baked without writing it again. It
+// is only baked again when the effect's settings change. The entries are 16-bit floats and are
+// not clamped, so the target clamps the blended result just as it would the effect's own.
+//
+// Blending the entries is exact for effects that are a matrix (tint, invert, sepia), apart from
+// the 16-bit rounding of the entries. For curved effects it is only close, and the sharper the
+// curve the further out it is: the bright pass's soft threshold is out by up to 13 8-bit steps, so
+// it is not declared. Nor are effects with hard steps in their colours (the shades of the Game Boy
+// effect, the retro palette) - blending would put colours between the steps.
+//
+// The CPU applies a LUT with tetrahedral interpolation (four entries per pixel, CPUPostProcess.h),
+// the GPU with a single trilinear fetch from a 3D texture (ColourLUT_pp.hlsl, set up in Scene.cpp)
+
+#ifndef _CPU_COLOUR_LUT_H_INCLUDED_
+#define _CPU_COLOUR_LUT_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "PostProcessConstants.h"
+#include "CVector4.h"
+
+#include <cstdint>
+#include <vector>
+
+
+// Grid points along each side of the LUT. 33 puts a point on every 8th 8-bit step and on 1.0
+const int COLOUR_LUT_SIZE = 33;
+
+
+class ColourLUT
+{
+public:
+	// Bake the LUT for the effect with the given settings, unless it already holds exactly that. The effect must have
+	// colourLUT in its declaration. Returns true if the LUT was baked
+	bool Update(PostProcess postProcess, const PostProcessEffectConstants& settings, int size = COLOUR_LUT_SIZE);
+
+	PostProcess Effect() const  { return mEffect; }
+	int         Size() const    { return mSize; }
+
+	// Size^3 entries, red changing fastest then green then blue (the layout of a D3D 3D texture). The entry for the grid
+	// point (r, g, b) is the effect's result for the colour (r, g, b) / (size - 1)
+	const std::vector<CVector4>& Entries() const  { return mEntries; }
+
+	// Number of times the LUT has been baked and the time the last bake took
+	int    NumBakes() const                  { return mNumBakes; }
+	double LastBakeMilliseconds() const      { return mLastBakeMilliseconds; }
+
+
+private:
+	PostProcess           mEffect = PostProcess::None;
+	int                   mSize   = 0;
+	std::vector<uint8_t>  mBakedSettings; // Copy of the settings the LUT was baked with, to spot changes
+	std::vector<CVector4> mEntries;
+
+	int    mNumBakes = 0;
+	double mLastBakeMilliseconds = 0;
+};
+
+
+#endif //_CPU_COLOUR_LUT_H_INCLUDED_
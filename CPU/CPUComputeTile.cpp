@@ -0,0 +1,159 @@
+//--------------------------------------------------------------------------------------
+// Compute tile shaders on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUComputeTile.h"
+#include "ComputeTile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+// Per-thread memory for the groups
+struct ComputeTileBuffers
+{
+	std::vector<CVector4> tile; // The group shared memory - the tile and its apron, a row at a time
+	std::vector<CVector4> row;  // One row of results
+};
+
+
+// Read the pixels of the given group's tile and apron into the buffer, a row at a time, as the shaders' load loops do
+static void LoadTile(const CPUImage& input, const ComputeTileShape& shape, int groupX, int groupY, ComputeTileBuffers& buffers)
+{
+	const PixelRect& window = input.Window();
+	int spanX = shape.width  + 2 * shape.apronX;
+	int spanY = shape.height + 2 * shape.apronY;
+	int loadLeft = groupX * shape.width  - shape.apronX;
+	int loadTop  = groupY * shape.height - shape.apronY;
+
+	buffers.tile.resize(static_cast<size_t>(spanX) * spanY);
+	for (int y = 0; y < spanY; ++y)
+	{
+		const CVector4* row = input.Row(std::min(std::max(loadTop + y, window.top), window.bottom - 1));
+		for (int x = 0; x < spanX; ++x)
+		{
+			buffers.tile[static_cast<size_t>(y) * spanX + x] = row[std::min(std::max(loadLeft + x, window.left), window.right - 1)];
+		}
+	}
+}
+
+
+// Wireframe_cs.hlsl for one thread, the tile holds luminance in x. The apron is one sample step
+static CVector4 WireframeThread(const WireframeConstants& settings, const ComputeTileShape& shape, const std::vector<CVector4>& tile,
+                                int threadX, int threadY)
+{
+	const float kernelX[9] = { -1.0f, 0.0f, 1.0f, -2.0f, 0.0f, 2.0f, -1.0f, 0.0f, 1.0f };
+	const float kernelY[9] = { -1.0f, -2.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 1.0f };
+	int spanX = shape.width + 2 * shape.apronX;
+
+	float gradientX = 0.0f;
+	float gradientY = 0.0f;
+	int index = 0;
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			int tapX = threadX + shape.apronX + x * shape.apronX;
+			int tapY = threadY + shape.apronY + y * shape.apronY;
+			float gray = tile[static_cast<size_t>(tapY) * spanX + tapX].x;
+			gradientX += gray * kernelX[index];
+			gradientY += gray * kernelY[index];
+			index++;
+		}
+	}
+	float edge = std::sqrt(gradientX * gradientX + gradientY * gradientY);
+
+	edge = std::min(std::max(std::pow(edge, settings.edgePower) * (1.0f / settings.edgeThreshold), 0.0f), 1.0f);
+	return CVector4(edge, edge, edge, 1.0f);
+}
+
+// GaussianHorizontalBlur_cs.hlsl or GaussianVerticalBlur_cs.hlsl for one thread. Neighbours along the blur are the given
+// stride apart in the tile
+static CVector4 GaussianBlurThread(const GaussianBlurConstants& settings, const std::vector<CVector4>& tile, int centre, int stride)
+{
+	auto rgb  = [&](int index)  { return CVector3(tile[index].x, tile[index].y, tile[index].z); };
+	auto lerp = [](const CVector3& a, const CVector3& b, float t)  { return a + t * (b - a); };
+
+	int numTaps = std::min(std::max(settings.numTaps, 1), GAUSSIAN_MAX_TAPS);
+	CVector3 colour = rgb(centre) * settings.taps[0].y;
+	for (int tap = 1; tap < numTaps; tap++)
+	{
+		int   whole    = static_cast<int>(settings.taps[tap].x);
+		float fraction = settings.taps[tap].x - whole;
+		CVector3 after  = lerp(rgb(centre + whole * stride), rgb(centre + (whole + 1) * stride), fraction);
+		CVector3 before = lerp(rgb(centre - whole * stride), rgb(centre - (whole + 1) * stride), fraction);
+		colour += (after + before) * settings.taps[tap].y;
+	}
+	return CVector4(colour, 1.0f);
+}
+
+
+// Run one thread group, writing the part of its tile that is inside the target
+static void RunGroup(PostProcess postProcess, const PostProcessEffectConstants& settings, const ComputeTileShape& shape,
+                     const CPUImage& input, int groupX, int groupY, CPUImage& target, ComputeTileBuffers& buffers)
+{
+	LoadTile(input, shape, groupX, groupY, buffers);
+	int spanX = shape.width + 2 * shape.apronX;
+
+	bool isWireframe = postProcess == PostProcess::Wireframe;
+	if (isWireframe)
+	{
+		for (CVector4& pixel : buffers.tile)  pixel.x = pixel.x * 0.299f + pixel.y * 0.587f + pixel.z * 0.114f;
+	}
+
+	int left   = groupX * shape.width;
+	int top    = groupY * shape.height;
+	int right  = std::min(left + shape.width,  target.Width());
+	int bottom = std::min(top  + shape.height, target.Height());
+	buffers.row.resize(shape.width);
+	for (int y = top; y < bottom; ++y)
+	{
+		for (int x = left; x < right; ++x)
+		{
+			int threadX = x - left;
+			int threadY = y - top;
+			int centre  = (threadY + shape.apronY) * spanX + threadX + shape.apronX;
+			if (isWireframe)
+			{
+				buffers.row[threadX] = WireframeThread(settings.wireframe, shape, buffers.tile, threadX, threadY);
+			}
+			else
+			{
+				int stride = (postProcess == PostProcess::GaussianBlurVertical) ? spanX : 1;
+				buffers.row[threadX] = GaussianBlurThread(settings.gaussianBlur, buffers.tile, centre, stride);
+			}
+		}
+		target.Store(left, y, buffers.row.data(), right - left);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Passes
+//--------------------------------------------------------------------------------------
+
+void CPUComputeTile(PostProcess postProcess, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* input = context.inputs[0];
+	if (!input)
+	{
+		std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+		for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+		return;
+	}
+
+	ComputeTileShape shape = GetComputeTileShape(postProcess, *context.effectConstants, context.passConstants, input->Width(), input->Height());
+	if (shape.width == 0)  return;
+
+	// A dispatch of groups across the target
+	int groupsX = ComputeTileGroupsX(shape, target.Width());
+	int numGroups = groupsX * ComputeTileGroupsY(shape, target.Height());
+	std::vector<ComputeTileBuffers> threadBuffers(context.threadPool ? context.threadPool->NumThreads() : 1);
+	auto runGroup = [&](int group, int thread)
+	{
+		RunGroup(postProcess, *context.effectConstants, shape, *input, group % groupsX, group / groupsX, target, threadBuffers[thread]);
+	};
+	if (context.threadPool)  context.threadPool->ParallelFor(numGroups, runGroup);
+	else                     for (int group = 0; group < numGroups; ++group)  runGroup(group, 0);
+}
@@ -0,0 +1,24 @@
+//--------------------------------------------------------------------------------------
+// Compute tile shaders on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU version of the compute tile shaders (Wireframe_cs.hlsl, GaussianHorizontalBlur_cs.hlsl
+// and GaussianVerticalBlur_cs.hlsl, see ComputeTile.h), following them a thread group at a time.
+// Each group's tile and apron are read into a block of memory standing in for the group shared
+// memory, then each of the group's threads works out its pixel from that block alone. Running
+// this against the pixel shader versions (CPUPostProcess.h) checks the shaders' tile and apron
+// indexing without a GPU. Groups are shared between the threads of the pass's pool.
+
+#ifndef _CPU_COMPUTE_TILE_H_INCLUDED_
+#define _CPU_COMPUTE_TILE_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcess.h"
+
+
+// Run the compute shader of the given effect, which must be declared with computeTile, over the whole target from input 0,
+// which must be the same size. Reads past the edges of the input give the edge pixel, as the shaders do
+void CPUComputeTile(PostProcess postProcess, const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_COMPUTE_TILE_H_INCLUDED_
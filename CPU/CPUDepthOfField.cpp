@@ -0,0 +1,188 @@
+//--------------------------------------------------------------------------------------
+// Depth of field stages on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUDepthOfField.h"
+#include "DepthOfField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+static CVector3 RGB(const CVector4& colour)  { return { colour.x, colour.y, colour.z }; }
+
+static CVector2 Mul(const CVector2& a, const CVector2& b)  { return { a.x * b.x, a.y * b.y }; }
+
+static float Saturate(float x)  { return std::min(std::max(x, 0.0f), 1.0f); }
+
+// Fill the target with opaque black, as a pass reading an unbound texture would
+static void FillBlack(CPUImage& target)
+{
+	std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+	for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+}
+
+// Write every pixel of the target from its UVs, sharing the rows between the threads of the context's pool
+template <typename PixelFunction>
+static void ForEachTargetPixel(const CPUPassContext& context, CPUImage& target, PixelFunction pixel)
+{
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			for (int x = tile.left; x < tile.right; ++x)
+			{
+				CVector2 uv = { (x + 0.5f) / target.Width(), (y + 0.5f) / target.Height() };
+				rowBuffer[x - tile.left] = pixel(x, y, uv);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
+
+
+//--------------------------------------------------------------------------------------
+// Passes
+//--------------------------------------------------------------------------------------
+
+void CPUDepthOfFieldCoC(const DepthOfFieldConstants& constants, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* scene = context.inputs[0];
+	const CPUImage* depth = context.inputs[1];
+	if (!scene || !depth)
+	{
+		FillBlack(target);
+		return;
+	}
+
+	// DepthOfFieldCoC_pp.hlsl
+	ForEachTargetPixel(context, target, [&](int, int, const CVector2& uv)
+	{
+		float linearDepth = (constants.nearClip * constants.farClip) /
+		                    (constants.farClip - depth->SamplePoint(uv).x * (constants.farClip - constants.nearClip));
+		float cocPixels = constants.aperture * (linearDepth - constants.focalDistance) / linearDepth * DOF_COC_PIXELS_PER_UNIT;
+		return CVector4(RGB(scene->SamplePoint(uv)), std::min(std::max(cocPixels / DOF_MAX_COC_PIXELS, -1.0f), 1.0f));
+	});
+}
+
+
+void CPUDepthOfFieldTiles(const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* coc = context.inputs[0];
+	if (!coc)
+	{
+		FillBlack(target);
+		return;
+	}
+
+	// DepthOfFieldTiles_pp.hlsl - the last tiles on each axis take the pixels left over
+	ForEachTargetPixel(context, target, [&](int x, int y, const CVector2&)
+	{
+		int startX = x * coc->Width() / target.Width(),  endX = (x + 1) * coc->Width()  / target.Width();
+		int startY = y * coc->Height() / target.Height(), endY = (y + 1) * coc->Height() / target.Height();
+		float minCoC = 0.0f;
+		float maxCoC = 0.0f;
+		for (int cocY = startY; cocY < endY; ++cocY)
+		{
+			const CVector4* row = coc->Row(cocY);
+			for (int cocX = startX; cocX < endX; ++cocX)
+			{
+				minCoC = std::min(minCoC, row[cocX].w);
+				maxCoC = std::max(maxCoC, row[cocX].w);
+			}
+		}
+		return CVector4(minCoC, maxCoC, 0.0f, 1.0f);
+	});
+}
+
+
+void CPUDepthOfFieldGather(const DepthOfFieldGatherConstants& constants, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* coc   = context.inputs[0];
+	const CPUImage* tiles = context.inputs[1];
+	if (!coc || !tiles)
+	{
+		FillBlack(target);
+		return;
+	}
+
+	// The taps of the bokeh kernel for a radius of 1: the centre, then rings of 8, 16, 24... taps, odd rings turned by half a
+	// tap. Worked out once rather than for every pixel as the shader does
+	struct GatherTap
+	{
+		CVector2 direction; // Unit vector, zero for the centre
+		float    distance;  // Fraction of the radius
+		int      ring;
+		int      share;     // Taken by pixels whose share of the taps is this, -1 for the centre which every pixel takes
+	};
+	int temporalFrames = std::max(constants.temporalFrames, 1);
+	std::vector<GatherTap> taps;
+	for (int ring = 0; ring <= DOF_GATHER_RINGS; ++ring)
+	{
+		int numTaps = (ring == 0) ? 1 : 8 * ring;
+		for (int tap = 0; tap < numTaps; ++tap)
+		{
+			float angle = 6.28318530718f * (tap + 0.5f * (ring % 2)) / numTaps;
+			int share = (ring == 0) ? -1 : (tap + ring) % temporalFrames;
+			taps.push_back({ { std::cos(angle), std::sin(angle) }, static_cast<float>(ring) / DOF_GATHER_RINGS, ring, share });
+		}
+	}
+
+	bool nearField = constants.nearField != 0;
+	const float inFocus = 0.5f / DOF_MAX_COC_PIXELS;
+	CVector2 tapScale = { DOF_MAX_COC_PIXELS / coc->Width(), DOF_MAX_COC_PIXELS / coc->Height() };
+
+	// DepthOfFieldGather_pp.hlsl
+	ForEachTargetPixel(context, target, [&](int pixelX, int pixelY, const CVector2& uv)
+	{
+		int tileX = std::min(static_cast<int>(uv.x * coc->Width())  * tiles->Width()  / coc->Width(),  tiles->Width()  - 1);
+		int tileY = std::min(static_cast<int>(uv.y * coc->Height()) * tiles->Height() / coc->Height(), tiles->Height() - 1);
+		float radius = 0.0f;
+		for (int y = std::max(tileY - 1, 0); y <= std::min(tileY + 1, tiles->Height() - 1); ++y)
+		{
+			for (int x = std::max(tileX - 1, 0); x <= std::min(tileX + 1, tiles->Width() - 1); ++x)
+			{
+				const CVector4& tileCoC = tiles->Row(y)[x];
+				radius = std::max(radius, nearField ? -tileCoC.x : tileCoC.y);
+			}
+		}
+
+		CVector4 centre = coc->SampleBilinear(uv);
+		if (radius < inFocus)  return nearField ? CVector4(0.0f, 0.0f, 0.0f, 0.0f) : CVector4(RGB(centre), 1.0f);
+
+		int share = (constants.frameIndex + (pixelX & 1) + 2 * (pixelY & 1)) % temporalFrames;
+
+		CVector3 totalColour = { 0.0f, 0.0f, 0.0f };
+		float totalWeight = 0.0f;
+		float widestCoC = 0.0f;
+		for (const GatherTap& tap : taps)
+		{
+			if (tap.share >= 0 && tap.share != share)  continue;
+
+			float tapDistance = radius * tap.distance;
+			CVector4 tapColour = coc->SampleBilinear(uv + Mul(tap.direction * tapDistance, tapScale));
+
+			float tapCoC = nearField ? -tapColour.w : tapColour.w;
+			float weight = (tapCoC > 0.0f) ? Saturate((tapCoC - tapDistance) * DOF_MAX_COC_PIXELS + 1.0f) : 0.0f;
+			totalColour += RGB(tapColour) * weight;
+			totalWeight += weight;
+			if (weight > 0.0f)  widestCoC = std::max(widestCoC, tapCoC);
+		}
+
+		if (!nearField)
+		{
+			return CVector4((totalWeight > 0.0f) ? totalColour / totalWeight : RGB(centre), 1.0f);
+		}
+
+		float reachableTaps = 0.0f;
+		for (const GatherTap& tap : taps)
+		{
+			if ((tap.share < 0 || tap.share == share) && radius * tap.ring / DOF_GATHER_RINGS <= widestCoC)  reachableTaps += 1.0f;
+		}
+		float coverage = (totalWeight > 0.0f) ? Saturate(totalWeight / reachableTaps) : 0.0f;
+		return CVector4(totalColour / std::max(totalWeight, 1e-5f) * coverage, coverage);
+	});
+}
@@ -0,0 +1,31 @@
+//--------------------------------------------------------------------------------------
+// Depth of field stages on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU versions of DepthOfFieldCoC_pp.hlsl, DepthOfFieldTiles_pp.hlsl and
+// DepthOfFieldGather_pp.hlsl, which make the images the depth of field's composite reads (see
+// DepthOfField.h). Each reads its inputs at the same places the shaders do, so the results match
+// them other than rounding. Rows of the target are shared between the threads of the pass's pool.
+// The composite itself is the DepthOfField effect in CPUPostProcess.h
+
+#ifndef _CPU_DEPTH_OF_FIELD_H_INCLUDED_
+#define _CPU_DEPTH_OF_FIELD_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Write input 0 with the circle of confusion from the depth in input 1 in alpha to the whole target, which should be 16-bit
+// float. All three the same size
+void CPUDepthOfFieldCoC(const DepthOfFieldConstants& constants, const CPUPassContext& context, CPUImage& target);
+
+// Write the smallest (red) and largest (green) circle of confusion of each tile of input 0, a circle of confusion image, to
+// the whole target, which has a pixel for each tile
+void CPUDepthOfFieldTiles(const CPUPassContext& context, CPUImage& target);
+
+// Write the blurred near or far field of input 0, a circle of confusion image, to the whole target, using the tiles in
+// input 1. The near field is written with its colour multiplied by its coverage, in alpha
+void CPUDepthOfFieldGather(const DepthOfFieldGatherConstants& constants, const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_DEPTH_OF_FIELD_H_INCLUDED_
@@ -0,0 +1,438 @@
+//--------------------------------------------------------------------------------------
+// Images for post-processing on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUImage.h"
+#include "CPUSimd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+//--------------------------------------------------------------------------------------
+// 16-bit floats
+//--------------------------------------------------------------------------------------
+
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	uint32_t absBits = bits & 0x7fffffff;
+
+	if (absBits >= 0x7f800000)  return sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0); // Infinity or NaN
+	if (absBits >= 0x477ff000)  return sign | 0x7c00; // Rounds to more than the largest half (65504)
+
+	uint32_t half;
+	uint32_t remainder, halfway;
+	if (absBits < 0x38800000)
+	{
+		// Too small for a normal half, the result is denormal (or zero)
+		if (absBits < 0x33000000)  return sign;
+		uint32_t exponent = absBits >> 23;
+		uint32_t mantissa = (absBits & 0x7fffff) | 0x800000;
+		uint32_t shift = 126 - exponent;
+		half      = mantissa >> shift;
+		remainder = mantissa & ((1u << shift) - 1);
+		halfway   = 1u << (shift - 1);
+	}
+	else
+	{
+		// Move the exponent from float bias (127) to half bias (15), drop 13 bits of mantissa
+		half      = (absBits - 0x38000000) >> 13;
+		remainder = absBits & 0x1fff;
+		halfway   = 0x1000;
+	}
+
+	// Round to nearest even. Rounding up can carry into the exponent, which gives the right answer
+	if (remainder > halfway || (remainder == halfway && (half & 1)))  ++half;
+	return sign | static_cast<uint16_t>(half);
+}
+
+float HalfToFloat(uint16_t value)
+{
+	uint32_t sign     = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0)
+	{
+		// Zero or denormal, 2^-24 per step
+		float result = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+		return sign ? -result : result;
+	}
+
+	uint32_t bits;
+	if (exponent == 31)  bits = sign | 0x7f800000 | (mantissa << 13); // Infinity or NaN
+	else                 bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rounding to target formats
+//--------------------------------------------------------------------------------------
+
+// Clamp to 0->1 and round to the nearest 1/255, as when writing to an 8-bit UNORM target. NaN becomes 0
+static void RoundToRGBA8(const CVector4* source, CVector4* destination, int count)
+{
+	const float* in  = &source->x;
+	float*       out = &destination->x;
+	int numFloats = count * 4;
+	int i = 0;
+
+#if defined(CPU_SIMD_AVX2)
+	const __m256 zero8  = _mm256_setzero_ps();
+	const __m256 one8   = _mm256_set1_ps(1.0f);
+	const __m256 scale8 = _mm256_set1_ps(255.0f);
+	const __m256 unscale8 = _mm256_set1_ps(1.0f / 255.0f);
+	for (; i + 8 <= numFloats; i += 8)
+	{
+		__m256 v = _mm256_max_ps(_mm256_loadu_ps(in + i), zero8); // Second operand returned for NaN
+		v = _mm256_min_ps(v, one8);
+		__m256i levels = _mm256_cvtps_epi32(_mm256_mul_ps(v, scale8));
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(levels), unscale8));
+	}
+#endif
+#if defined(CPU_SIMD_SSE2)
+	const __m128 zero  = _mm_setzero_ps();
+	const __m128 one   = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 unscale = _mm_set1_ps(1.0f / 255.0f);
+	for (; i + 4 <= numFloats; i += 4)
+	{
+		__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), zero), one);
+		__m128i levels = _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(levels), unscale));
+	}
+#endif
+	for (; i < numFloats; ++i)
+	{
+		float v = in[i] > 0.0f ? in[i] : 0.0f;
+		if (v > 1.0f)  v = 1.0f;
+		out[i] = std::nearbyint(v * 255.0f) * (1.0f / 255.0f);
+	}
+}
+
+// Round to the nearest 16-bit float, as when writing to an RGBA16F target
+static void RoundToRGBA16F(const CVector4* source, CVector4* destination, int count)
+{
+	const float* in  = &source->x;
+	float*       out = &destination->x;
+	int numFloats = count * 4;
+	int i = 0;
+
+#if defined(CPU_SIMD_F16C)
+	for (; i + 4 <= numFloats; i += 4)
+	{
+		__m128i half = _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_ps(out + i, _mm_cvtph_ps(half));
+	}
+#endif
+	for (; i < numFloats; ++i)
+	{
+		out[i] = HalfToFloat(FloatToHalf(in[i]));
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Construction / Usage
+//--------------------------------------------------------------------------------------
+
+void CPUImage::Resize(int width, int height, TargetFormat format)
+{
+	mWidth  = std::max(width,  0);
+	mHeight = std::max(height, 0);
+	mFormat = format;
+	mPixels.assign(static_cast<size_t>(mWidth) * mHeight, CVector4(0, 0, 0, 0));
+
+	mWindow    = { 0, 0, mWidth, mHeight };
+	mRowOffset = 0;
+	mRowPitch  = mWidth;
+}
+
+void CPUImage::ResizeWindow(const PixelRect& window, int fullWidth, int fullHeight, TargetFormat format)
+{
+	mWidth  = std::max(fullWidth,  0);
+	mHeight = std::max(fullHeight, 0);
+	mFormat = format;
+	mWindow = ClipToViewport(window, mWidth, mHeight);
+	if (mWindow.IsEmpty())  mWindow = PixelRect();
+	mPixels.resize(static_cast<size_t>(mWindow.Area()));
+
+	mRowPitch  = mWindow.right - mWindow.left;
+	mRowOffset = -(static_cast<ptrdiff_t>(mWindow.top) * mRowPitch + mWindow.left);
+}
+
+void CPUImage::Fill(const CVector4& colour)
+{
+	std::fill(mPixels.begin(), mPixels.end(), colour);
+}
+
+
+void RoundToFormat(const CVector4* source, CVector4* destination, int count, TargetFormat format)
+{
+	if (format == TargetFormat::RGBA8)
+	{
+		RoundToRGBA8(source, destination, count);
+	}
+	else if (format == TargetFormat::RGBA16F)
+	{
+		RoundToRGBA16F(source, destination, count);
+	}
+	else
+	{
+		// Single channel target, reading the other channels gives 0, 0, 1 as on the GPU
+		for (int i = 0; i < count; ++i)  destination[i] = CVector4(source[i].x, 0, 0, 1);
+	}
+}
+
+
+void CPUImage::Store(int x, int y, const CVector4* pixels, int count)
+{
+	RoundToFormat(pixels, Row(y) + x, count, mFormat);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Loading and saving
+//--------------------------------------------------------------------------------------
+
+void CPUImage::LoadRGBA8(const uint8_t* pixels, int width, int height, int pitch)
+{
+	Resize(width, height, TargetFormat::RGBA8);
+	for (int y = 0; y < mHeight; ++y)
+	{
+		const uint8_t* in  = pixels + static_cast<size_t>(y) * pitch;
+		float*         out = &Row(y)->x;
+		int numBytes = mWidth * 4;
+		int i = 0;
+
+#if defined(CPU_SIMD_SSE2)
+		// One pixel at a time: widen the 4 bytes to 32-bit integers then convert to floats
+		const __m128i zero = _mm_setzero_si128();
+		const __m128  scale = _mm_set1_ps(1.0f / 255.0f);
+		for (; i + 4 <= numBytes; i += 4)
+		{
+			int32_t packed;
+			std::memcpy(&packed, in + i, sizeof(packed));
+			__m128i bytes = _mm_cvtsi32_si128(packed);
+			__m128i words = _mm_unpacklo_epi8(bytes, zero);
+			__m128i dwords = _mm_unpacklo_epi16(words, zero);
+			_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(dwords), scale));
+		}
+#endif
+		for (; i < numBytes; ++i)
+		{
+			out[i] = in[i] * (1.0f / 255.0f);
+		}
+	}
+}
+
+void CPUImage::SaveRGBA8(uint8_t* pixels, int pitch) const
+{
+	for (int y = 0; y < mHeight; ++y)
+	{
+		const float* in  = &Row(y)->x;
+		uint8_t*     out = pixels + static_cast<size_t>(y) * pitch;
+		int numBytes = mWidth * 4;
+		int i = 0;
+
+#if defined(CPU_SIMD_SSE2)
+		// Four pixels at a time, clamped first as the conversion to integers fails for huge values (NaN becomes 0)
+		const __m128 zero  = _mm_setzero_ps();
+		const __m128 one   = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		for (; i + 16 <= numBytes; i += 16)
+		{
+			__m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i     ), zero), one), scale));
+			__m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4 ), zero), one), scale));
+			__m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 8 ), zero), one), scale));
+			__m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 12), zero), one), scale));
+			__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+		}
+#endif
+		for (; i < numBytes; ++i)
+		{
+			float v = in[i] > 0.0f ? in[i] : 0.0f;
+			if (v > 1.0f)  v = 1.0f;
+			out[i] = static_cast<uint8_t>(std::nearbyint(v * 255.0f));
+		}
+	}
+}
+
+
+void CPUImage::LoadRGBA16F(const uint16_t* pixels, int width, int height, int pitch)
+{
+	Resize(width, height, TargetFormat::RGBA16F);
+	for (int y = 0; y < mHeight; ++y)
+	{
+		const uint16_t* in  = reinterpret_cast<const uint16_t*>(reinterpret_cast<const uint8_t*>(pixels) + static_cast<size_t>(y) * pitch);
+		float*          out = &Row(y)->x;
+		int numFloats = mWidth * 4;
+		int i = 0;
+
+#if defined(CPU_SIMD_F16C)
+		for (; i + 4 <= numFloats; i += 4)
+		{
+			_mm_storeu_ps(out + i, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i))));
+		}
+#endif
+		for (; i < numFloats; ++i)  out[i] = HalfToFloat(in[i]);
+	}
+}
+
+void CPUImage::SaveRGBA16F(uint16_t* pixels, int pitch) const
+{
+	for (int y = 0; y < mHeight; ++y)
+	{
+		const float* in  = &Row(y)->x;
+		uint16_t*    out = reinterpret_cast<uint16_t*>(reinterpret_cast<uint8_t*>(pixels) + static_cast<size_t>(y) * pitch);
+		int numFloats = mWidth * 4;
+		int i = 0;
+
+#if defined(CPU_SIMD_F16C)
+		for (; i + 4 <= numFloats; i += 4)
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+		}
+#endif
+		for (; i < numFloats; ++i)  out[i] = FloatToHalf(in[i]);
+	}
+}
+
+
+void CPUImage::LoadRGBA32F(const float* pixels, int width, int height, int pitch)
+{
+	Resize(width, height, TargetFormat::RGBA16F); // No 32-bit colour targets in the pooled formats, the nearest is kept
+	for (int y = 0; y < mHeight; ++y)
+	{
+		const float* in = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pixels) + static_cast<size_t>(y) * pitch);
+		std::copy(in, in + mWidth * 4, &Row(y)->x);
+	}
+}
+
+void CPUImage::SaveRGBA32F(float* pixels, int pitch) const
+{
+	for (int y = 0; y < mHeight; ++y)
+	{
+		float* out = reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(pixels) + static_cast<size_t>(y) * pitch);
+		std::copy(&Row(y)->x, &Row(y)->x + mWidth * 4, out);
+	}
+}
+
+
+void CPUImage::LoadR32F(const float* pixels, int width, int height, int pitch)
+{
+	Resize(width, height, TargetFormat::R32F);
+	for (int y = 0; y < mHeight; ++y)
+	{
+		const float* in  = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(pixels) + static_cast<size_t>(y) * pitch);
+		CVector4*    out = Row(y);
+		for (int x = 0; x < mWidth; ++x)  out[x] = CVector4(in[x], 0, 0, 1);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sampling
+//--------------------------------------------------------------------------------------
+
+// Pixel containing the given UV in an image of the given size, clamped to the pixels from first up to (not including)
+// last. NaN UVs give the first pixel
+static int PointIndex(float uv, int size, int first, int last)
+{
+	float position = std::floor(uv * size);
+	if (!(position >= first))  return first;
+	if (position >= last)      return last - 1;
+	return static_cast<int>(position);
+}
+
+static CVector4 Lerp(const CVector4& a, const CVector4& b, float t)
+{
+	return CVector4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t);
+}
+
+
+CVector4 CPUImage::SamplePoint(CVector2 uv) const
+{
+	return Pixel(PointIndex(uv.x, mWidth, mWindow.left, mWindow.right), PointIndex(uv.y, mHeight, mWindow.top, mWindow.bottom));
+}
+
+
+CVector4 CPUImage::SampleBilinear(CVector2 uv) const
+{
+	// Position relative to pixel centres, limited so the conversion to int can't overflow
+	float fx = std::min(std::max(uv.x * mWidth  - 0.5f, -1.0f), static_cast<float>(mWidth));
+	float fy = std::min(std::max(uv.y * mHeight - 0.5f, -1.0f), static_cast<float>(mHeight));
+	if (fx != fx)  fx = 0.0f;
+	if (fy != fy)  fy = 0.0f;
+
+	float floorX = std::floor(fx);
+	float floorY = std::floor(fy);
+	float tx = fx - floorX;
+	float ty = fy - floorY;
+
+	int x0 = std::min(std::max(static_cast<int>(floorX),     mWindow.left), mWindow.right  - 1);
+	int x1 = std::min(std::max(static_cast<int>(floorX) + 1, mWindow.left), mWindow.right  - 1);
+	int y0 = std::min(std::max(static_cast<int>(floorY),     mWindow.top),  mWindow.bottom - 1);
+	int y1 = std::min(std::max(static_cast<int>(floorY) + 1, mWindow.top),  mWindow.bottom - 1);
+
+	CVector4 top    = Lerp(Pixel(x0, y0), Pixel(x1, y0), tx);
+	CVector4 bottom = Lerp(Pixel(x0, y1), Pixel(x1, y1), tx);
+	return Lerp(top, bottom, ty);
+}
+
+
+CVector4 CPUImage::SampleBilinearWrap(CVector2 uv) const
+{
+	float fx = uv.x * mWidth  - 0.5f;
+	float fy = uv.y * mHeight - 0.5f;
+	if (!std::isfinite(fx))  fx = 0.0f;
+	if (!std::isfinite(fy))  fy = 0.0f;
+
+	// Wrap into the image first so only the right/bottom neighbour can fall off the edge
+	fx -= std::floor(fx / mWidth)  * mWidth;
+	fy -= std::floor(fy / mHeight) * mHeight;
+
+	float floorX = std::floor(fx);
+	float floorY = std::floor(fy);
+	float tx = fx - floorX;
+	float ty = fy - floorY;
+
+	int x0 = std::min(static_cast<int>(floorX), mWidth  - 1);
+	int y0 = std::min(static_cast<int>(floorY), mHeight - 1);
+	int x1 = (x0 + 1) % mWidth;
+	int y1 = (y0 + 1) % mHeight;
+
+	CVector4 top    = Lerp(Pixel(x0, y0), Pixel(x1, y0), tx);
+	CVector4 bottom = Lerp(Pixel(x0, y1), Pixel(x1, y1), tx);
+	return Lerp(top, bottom, ty);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Copies
+//--------------------------------------------------------------------------------------
+
+void CopyImageRect(const CPUImage& source, CPUImage& destination, const PixelRect& rect)
+{
+	const PixelRect& sourceWindow      = source.Window();
+	const PixelRect& destinationWindow = destination.Window();
+	int left   = std::max(rect.left,   std::max(sourceWindow.left,   destinationWindow.left));
+	int top    = std::max(rect.top,    std::max(sourceWindow.top,    destinationWindow.top));
+	int right  = std::min(rect.right,  std::min(sourceWindow.right,  destinationWindow.right));
+	int bottom = std::min(rect.bottom, std::min(sourceWindow.bottom, destinationWindow.bottom));
+	if (right <= left || bottom <= top)  return;
+
+	for (int y = top; y < bottom; ++y)
+	{
+		std::memcpy(destination.Row(y) + left, source.Row(y) + left, static_cast<size_t>(right - left) * sizeof(CVector4));
+	}
+}
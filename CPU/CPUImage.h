@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------------------
+// Images for post-processing on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU version of a texture: a 2D array of RGBA pixels held as floats. Each image remembers
+// the format of the GPU texture it stands in for, and pixels written with Store are rounded to
+// that format. So a chain run on the CPU loses the same precision between passes as it does on
+// the GPU, e.g. an 8-bit target clamps HDR colours to 0->1.
+//
+// Images are read with the same UVs as the shaders use, through the kinds of sampler Scene.cpp
+// binds (see the Sample functions). Depth and other single channel images keep their value in
+// the red channel (x).
+//
+// An image can also be a window onto part of a larger image, used to work on one tile of a frame
+// at a time (see CPUTileFusion.h).
+//
+// No DirectX here, images can be loaded from and saved to packed pixels in memory
+
+#ifndef _CPU_IMAGE_H_INCLUDED_
+#define _CPU_IMAGE_H_INCLUDED_
+
+#include "RenderTargetPool.h"
+#include "PostProcessRegion.h"
+#include "CVector2.h"
+#include "CVector4.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class CPUImage
+{
+public:
+	//-------------------------------------
+	// Construction / Usage
+	//-------------------------------------
+
+	CPUImage() {}
+	CPUImage(int width, int height, TargetFormat format = TargetFormat::RGBA8)  { Resize(width, height, format); }
+
+	// Change the size and format of the image. All pixels are set to transparent black
+	void Resize(int width, int height, TargetFormat format);
+
+	// Make the image a window onto the given rectangle of an image of the given size. Only the pixels inside the window
+	// are stored, but positions, UVs, Width and Height are those of the full image, so effects can read and write the
+	// window just as they would the full image. Reads outside the window give the nearest pixel in it. The pixels are
+	// left undefined, and memory already held is reused so moving from tile to tile doesn't allocate
+	void ResizeWindow(const PixelRect& window, int fullWidth, int fullHeight, TargetFormat format);
+
+	// Set every stored pixel to the given colour (not rounded)
+	void Fill(const CVector4& colour);
+
+
+	//-------------------------------------
+	// Loading and saving
+	//-------------------------------------
+	// The size is taken from the data when loading, the format is set to match. The pitch is the number of
+	// bytes from one row to the next. Saving writes the whole image, so isn't available for windows
+
+	void LoadRGBA8(const uint8_t* pixels, int width, int height, int pitch);
+	void SaveRGBA8(uint8_t* pixels, int pitch) const;
+
+	// 16-bit floats, as stored in an RGBA16F texture
+	void LoadRGBA16F(const uint16_t* pixels, int width, int height, int pitch);
+	void SaveRGBA16F(uint16_t* pixels, int pitch) const;
+
+	void LoadRGBA32F(const float* pixels, int width, int height, int pitch);
+	void SaveRGBA32F(float* pixels, int pitch) const;
+
+	// A single channel of floats, e.g. a depth buffer, is loaded into the red channel
+	void LoadR32F(const float* pixels, int width, int height, int pitch);
+
+
+	//-------------------------------------
+	// Pixel access
+	//-------------------------------------
+
+	int              Width() const   { return mWidth; }
+	int              Height() const  { return mHeight; }
+	TargetFormat     Format() const  { return mFormat; }
+	bool             IsEmpty() const { return mPixels.empty(); }
+	const PixelRect& Window() const  { return mWindow; } // The pixels stored, the whole image unless made a window
+
+	// Row(y)[x] is pixel (x, y). For a window only pixels inside it can be used
+	CVector4*       Row(int y)        { return mPixels.data() + (mRowOffset + static_cast<ptrdiff_t>(y) * mRowPitch); }
+	const CVector4* Row(int y) const  { return mPixels.data() + (mRowOffset + static_cast<ptrdiff_t>(y) * mRowPitch); }
+
+	CVector4&       Pixel(int x, int y)        { return Row(y)[x]; }
+	const CVector4& Pixel(int x, int y) const  { return Row(y)[x]; }
+
+	// Write a run of pixels along a row starting at (x, y), rounded to the format of the image as the GPU does
+	// when writing to a render target
+	void Store(int x, int y, const CVector4* pixels, int count);
+
+
+	//-------------------------------------
+	// Sampling
+	//-------------------------------------
+	// UVs are 0->1 across the image, with pixel centres at half-pixel positions, as in the shaders
+
+	// Nearest pixel, UVs clamped to the edges. As gPointSampler, which all post-processes use in slot s0
+	CVector4 SamplePoint(CVector2 uv) const;
+
+	// Bilinear filtering, UVs clamped to the edges
+	CVector4 SampleBilinear(CVector2 uv) const;
+
+	// Bilinear filtering, UVs wrapped. As gTrilinearSampler on a texture with a single mip-map (used for the noise maps)
+	// Whole images only, not windows
+	CVector4 SampleBilinearWrap(CVector2 uv) const;
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	int                   mWidth  = 0;
+	int                   mHeight = 0;
+	TargetFormat          mFormat = TargetFormat::RGBA8;
+	std::vector<CVector4> mPixels;
+
+	// Where pixel (x, y) is in mPixels: mRowOffset + y * mRowPitch + x
+	PixelRect             mWindow;
+	ptrdiff_t             mRowOffset = 0;
+	ptrdiff_t             mRowPitch  = 0;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Pixel format helpers
+//--------------------------------------------------------------------------------------
+
+// Convert between 32-bit floats and 16-bit floats (round to nearest even, out of range values become infinity)
+uint16_t FloatToHalf(float value);
+float    HalfToFloat(uint16_t value);
+
+// Round colours as writing them to a target of the given format does (see CPUImage::Store). The source and destination
+// can be the same
+void RoundToFormat(const CVector4* source, CVector4* destination, int count, TargetFormat format);
+
+// Copy the given rectangle of pixels from one image to another of the same size, as CopySubresourceRegion does
+// The rectangle is clipped to the pixels stored in both images
+void CopyImageRect(const CPUImage& source, CPUImage& destination, const PixelRect& rect);
+
+
+#endif //_CPU_IMAGE_H_INCLUDED_
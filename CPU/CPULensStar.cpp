@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------------
+// Lens star streaks on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPULensStar.h"
+#include "CPUUVRemap.h" // For CPUGatherBilinear
+#include "LensStar.h"
+
+#include <algorithm>
+#include <vector>
+
+
+// Add the weighted taps along one side of the streak to the sum for each pixel of a row, from the pixels' UVs. The sums are
+// kept component by component, the vector operators aren't inlined
+static void AddTaps(const LensStarStreakConstants& constants, const CPUImage& source, const CVector2& tapStep,
+                    const std::vector<CVector2>& pixelUVs, std::vector<CVector2>& tapUVs, std::vector<CVector4>& reads,
+                    std::vector<CVector4>& sums)
+{
+	int count = static_cast<int>(pixelUVs.size());
+	const float tapWeights[LENS_STAR_MAX_TAPS] = { constants.tapWeights.x, constants.tapWeights.y, constants.tapWeights.z,
+	                                               constants.tapWeights.w };
+	for (int tap = 0; tap < constants.numTaps && tap < LENS_STAR_MAX_TAPS; ++tap)
+	{
+		float offsetX = tapStep.x * (constants.firstTap + tap);
+		float offsetY = tapStep.y * (constants.firstTap + tap);
+		for (int i = 0; i < count; ++i)
+		{
+			tapUVs[i].x = pixelUVs[i].x + offsetX;
+			tapUVs[i].y = pixelUVs[i].y + offsetY;
+		}
+		CPUGatherBilinear(source, tapUVs.data(), count, reads.data());
+
+		float weight = tapWeights[tap];
+		for (int i = 0; i < count; ++i)
+		{
+			sums[i].x += reads[i].x * weight;
+			sums[i].y += reads[i].y * weight;
+			sums[i].z += reads[i].z * weight;
+		}
+	}
+}
+
+
+void CPULensStarStreak(const LensStarStreakConstants& constants, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* forward  = context.inputs[0];
+	const CPUImage* backward = context.inputs[1];
+	const CPUImage* star     = context.inputs[2];
+
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		int count = tile.right - tile.left;
+		std::vector<CVector2> pixelUVs(count), tapUVs(count);
+		std::vector<CVector4> reads(count), sums(count), rowBuffer(count);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				pixelUVs[i] = { (tile.left + i + 0.5f) / target.Width(), (y + 0.5f) / target.Height() };
+				sums[i] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+
+			// A missing input reads as black
+			if (forward)  AddTaps(constants, *forward, constants.tapStep, pixelUVs, tapUVs, reads, sums);
+			if (constants.lastPass == 0)
+			{
+				target.Store(tile.left, y, sums.data(), count);
+				continue;
+			}
+
+			if (backward)  AddTaps(constants, *backward, constants.tapStep * -1.0f, pixelUVs, tapUVs, reads, sums);
+			if (star)      CPUGatherBilinear(*star, pixelUVs.data(), count, reads.data());
+			else           std::fill(reads.begin(), reads.end(), CVector4(0.0f, 0.0f, 0.0f, 0.0f));
+			for (int i = 0; i < count; ++i)
+			{
+				float red   = reads[i].x + sums[i].x * constants.tint.x;
+				float green = reads[i].y + sums[i].y * constants.tint.y;
+				float blue  = reads[i].z + sums[i].z * constants.tint.z;
+				if (constants.lastPass == 2)
+				{
+					red   /= red + 1.0f;
+					green /= green + 1.0f;
+					blue  /= blue + 1.0f;
+				}
+				rowBuffer[i] = CVector4(red, green, blue, 1.0f);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), count);
+		}
+	});
+}
@@ -0,0 +1,23 @@
+//--------------------------------------------------------------------------------------
+// Lens star streaks on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU version of LensStarStreak_pp.hlsl, one pass of one of the lens star's streaks (see
+// LensStar.h). Each tap of a row is read bilinearly for the whole row at once (see
+// CPUGatherBilinear), at the same places the shader reads. Rows of the target are shared between
+// the threads of the pass's pool
+
+#ifndef _CPU_LENS_STAR_H_INCLUDED_
+#define _CPU_LENS_STAR_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Write one pass of a streak to the whole target. Input 0 is the pass before along the side the pass sums (the image the
+// star is made from for a first pass). The last pass of a streak also reads the other side in input 1 and adds the streak to
+// the star so far in input 2 (nullptr for the first streak)
+void CPULensStarStreak(const LensStarStreakConstants& constants, const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_LENS_STAR_H_INCLUDED_
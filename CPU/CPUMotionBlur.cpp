@@ -0,0 +1,136 @@
+//--------------------------------------------------------------------------------------
+// Motion blur on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUMotionBlur.h"
+#include "MotionBlur.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+static CVector3 RGB(const CVector4& colour)  { return { colour.x, colour.y, colour.z }; }
+
+static float Length(const CVector2& v)  { return std::sqrt(Dot(v, v)); }
+
+static float Saturate(float x)  { return std::min(std::max(x, 0.0f), 1.0f); }
+
+static float SmoothStep(float edge0, float edge1, float x)
+{
+	float t = Saturate((x - edge0) / (edge1 - edge0));
+	return t * t * (3.0f - 2.0f * t);
+}
+
+// The blur of a velocity in pixels - the part of the movement the shutter is open for, no longer than the longest blur
+static CVector2 Blur(const CVector2& velocityPixels, float shutter)
+{
+	CVector2 blur = velocityPixels * shutter;
+	float blurLength = Length(blur);
+	return (blurLength > MOTION_BLUR_MAX_PIXELS) ? blur * (MOTION_BLUR_MAX_PIXELS / blurLength) : blur;
+}
+
+// How much a blur of the given length, centred on its pixel, covers a pixel the given distance away
+static float Cone(float distance, float blurLength)      { return Saturate(1.0f - distance / (blurLength * 0.5f)); }
+static float Cylinder(float distance, float blurLength)  { return 1.0f - SmoothStep(0.475f * blurLength, 0.525f * blurLength, distance); }
+
+// 1 if the first depth is in front of the second, fading to 0 as it goes behind
+static float InFront(float depth, float otherDepth)  { return Saturate(1.0f - (depth - otherDepth) / MOTION_BLUR_DEPTH_RANGE); }
+
+
+//--------------------------------------------------------------------------------------
+// Passes
+//--------------------------------------------------------------------------------------
+
+void CPUMotionBlurTiles(const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* velocity = context.inputs[0];
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left, CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			// MotionBlurTiles_pp.hlsl - the last tiles on each axis take the pixels left over. With no velocity nothing moves
+			for (int x = tile.left; velocity && x < tile.right; ++x)
+			{
+				int startX = x * velocity->Width() / target.Width(),  endX = (x + 1) * velocity->Width()  / target.Width();
+				int startY = y * velocity->Height() / target.Height(), endY = (y + 1) * velocity->Height() / target.Height();
+				CVector2 longest = { 0.0f, 0.0f };
+				for (int velocityY = startY; velocityY < endY; ++velocityY)
+				{
+					const CVector4* row = velocity->Row(velocityY);
+					for (int velocityX = startX; velocityX < endX; ++velocityX)
+					{
+						CVector2 pixels = { row[velocityX].x * velocity->Width(), row[velocityX].y * velocity->Height() };
+						if (Dot(pixels, pixels) > Dot(longest, longest))  longest = pixels;
+					}
+				}
+				rowBuffer[x - tile.left] = CVector4(longest.x, longest.y, 0.0f, 1.0f);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
+
+
+CVector4 CPUMotionBlurPixel(const MotionBlurConstants& constants, const CPUPassContext& context, const CVector2& sceneUV)
+{
+	const CPUImage* scene    = context.inputs[0];
+	const CPUImage* velocity = context.inputs[1];
+	const CPUImage* tiles    = context.inputs[2];
+	if (!scene)  return CVector4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// MotionBlur_pp.hlsl
+	int width  = context.viewportWidth;
+	int height = context.viewportHeight;
+	int pixelX = std::min(static_cast<int>(sceneUV.x * width),  width  - 1);
+	int pixelY = std::min(static_cast<int>(sceneUV.y * height), height - 1);
+	CVector3 colour = RGB(scene->Row(pixelY)[pixelX]);
+	if (!velocity || !tiles)  return CVector4(colour, 1.0f);
+
+	// The longest velocity among the tile holding this pixel and the eight around it
+	int tileX = std::min(pixelX * tiles->Width()  / width,  tiles->Width()  - 1);
+	int tileY = std::min(pixelY * tiles->Height() / height, tiles->Height() - 1);
+	CVector2 neighbourhoodVelocity = { 0.0f, 0.0f };
+	for (int nearY = std::max(tileY - 1, 0); nearY <= std::min(tileY + 1, tiles->Height() - 1); ++nearY)
+	{
+		for (int nearX = std::max(tileX - 1, 0); nearX <= std::min(tileX + 1, tiles->Width() - 1); ++nearX)
+		{
+			const CVector4& tileVelocity = tiles->Row(nearY)[nearX];
+			CVector2 velocityPixels = { tileVelocity.x, tileVelocity.y };
+			if (Dot(velocityPixels, velocityPixels) > Dot(neighbourhoodVelocity, neighbourhoodVelocity))  neighbourhoodVelocity = velocityPixels;
+		}
+	}
+	CVector2 neighbourhoodBlur = Blur(neighbourhoodVelocity, constants.shutter);
+	if (Length(neighbourhoodBlur) < 0.5f)  return CVector4(colour, 1.0f);
+
+	auto blurLength = [&](const CVector4& pixelVelocity)
+	{
+		CVector2 velocityPixels = { pixelVelocity.x * width, pixelVelocity.y * height };
+		return std::max(Length(Blur(velocityPixels, constants.shutter)), 1.0f);
+	};
+	const CVector4& centre = velocity->Row(pixelY)[pixelX];
+	float centreLength = blurLength(centre);
+	float totalWeight  = 1.0f / centreLength;
+	CVector3 total = colour * totalWeight;
+
+	for (int sample = 0; sample < MOTION_BLUR_SAMPLES; ++sample)
+	{
+		CVector2 offset = neighbourhoodBlur * ((sample + 0.5f) / MOTION_BLUR_SAMPLES - 0.5f);
+		int sampleX = std::min(std::max(pixelX + static_cast<int>(std::round(offset.x)), 0), width  - 1);
+		int sampleY = std::min(std::max(pixelY + static_cast<int>(std::round(offset.y)), 0), height - 1);
+		float distance = Length(offset);
+
+		const CVector4& sampleVelocity = velocity->Row(sampleY)[sampleX];
+		float sampleLength = blurLength(sampleVelocity);
+
+		float weight = InFront(sampleVelocity.z, centre.z) * Cone(distance, sampleLength) +
+		               InFront(centre.z, sampleVelocity.z) * Cone(distance, centreLength) +
+		               Cylinder(distance, sampleLength) * Cylinder(distance, centreLength) * 2.0f;
+		total       += RGB(scene->Row(sampleY)[sampleX]) * weight;
+		totalWeight += weight;
+	}
+
+	return CVector4(total / totalWeight, 1.0f);
+}
@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// Motion blur on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU versions of MotionBlurTiles_pp.hlsl and MotionBlur_pp.hlsl, the passes blurring the
+// scene along the velocity of each pixel (see MotionBlur.h). Each reads its inputs at the same
+// places the shaders do, so the results match them other than rounding. The tiles pass shares the
+// rows of its target between the threads of the pass's pool, the blur is run a pixel at a time as
+// the MotionBlur effect in CPUPostProcess.h
+
+#ifndef _CPU_MOTION_BLUR_H_INCLUDED_
+#define _CPU_MOTION_BLUR_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Write the longest velocity in pixels of each tile of input 0, a scene velocity image, to the whole target, which has a pixel
+// for each tile
+void CPUMotionBlurTiles(const CPUPassContext& context, CPUImage& target);
+
+// The colour of the pixel at the given scene UV blurred along the velocities near it. Input 0 is the image to blur, input 1 the
+// scene velocity and input 2 the tiles made by CPUMotionBlurTiles
+CVector4 CPUMotionBlurPixel(const MotionBlurConstants& constants, const CPUPassContext& context, const CVector2& sceneUV);
+
+
+#endif //_CPU_MOTION_BLUR_H_INCLUDED_
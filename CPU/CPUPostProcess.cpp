@@ -0,0 +1,1501 @@
+//--------------------------------------------------------------------------------------
+// Post-processes on the CPU
+//--------------------------------------------------------------------------------------
+// The effect functions follow their shaders line by line, see the shader files for how each works
+
+#include "CPUPostProcess.h"
+#include "CPUMotionBlur.h"
+#include "CPUSimd.h"
+#include "DepthOfField.h"
+#include "GaussianKernel.h"
+#include "PaletteIndex.h"
+#include "TemporalHistory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// HLSL helpers
+//--------------------------------------------------------------------------------------
+
+static float Saturate(float x)  { return std::min(std::max(x, 0.0f), 1.0f); }
+static float Frac(float x)      { return x - std::floor(x); }
+
+static float SmoothStep(float edge0, float edge1, float x)
+{
+	float t = Saturate((x - edge0) / (edge1 - edge0));
+	return t * t * (3.0f - 2.0f * t);
+}
+
+static CVector3 RGB(const CVector4& colour)                        { return { colour.x, colour.y, colour.z }; }
+static CVector3 Mul(const CVector3& a, const CVector3& b)          { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+static CVector2 Mul(const CVector2& a, const CVector2& b)          { return { a.x * b.x, a.y * b.y }; }
+static CVector3 Max(const CVector3& a, const CVector3& b)          { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+static CVector3 Lerp(const CVector3& a, const CVector3& b, float t) { return a + t * (b - a); }
+static float    Length(const CVector2& v)                          { return std::sqrt(v.x * v.x + v.y * v.y); }
+
+// Texture reads. A missing image reads as black
+static CVector4 SamplePoint(const CPUImage* image, CVector2 uv)
+{
+	return image ? image->SamplePoint(uv) : CVector4(0, 0, 0, 0);
+}
+static CVector4 SampleLinear(const CPUImage* image, CVector2 uv)
+{
+	return image ? image->SampleBilinear(uv) : CVector4(0, 0, 0, 0);
+}
+static CVector4 SampleWrap(const CPUImage* image, CVector2 uv)
+{
+	return image ? image->SampleBilinearWrap(uv) : CVector4(0, 0, 0, 0);
+}
+
+// Alpha for the effects that fade out in a soft circle in the area
+static float SoftCircleAlpha(const CVector2& areaUV, float softEdge)
+{
+	CVector2 centreVector = areaUV - CVector2(0.5f, 0.5f);
+	float centreLengthSq = Dot(centreVector, centreVector);
+	return 1.0f - Saturate((centreLengthSq - 0.25f + softEdge) / softEdge);
+}
+
+// Depth buffer value to distance from the camera
+static float LinearizeDepth(float depth, float nearClip, float farClip)
+{
+	return (nearClip * farClip) / (farClip - depth * (farClip - nearClip));
+}
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+// One function per pixel shader. Inputs as PostProcessingInput in Common.hlsli, the result is the SV_Target
+
+typedef CVector4 (*CPUPixelShader)(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV);
+
+#define SCENE_TEXTURE  context.inputs[0]
+#define SETTINGS       (*context.effectConstants)
+
+
+static CVector4 CopyShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	return CVector4(RGB(SamplePoint(SCENE_TEXTURE, sceneUV)), 1.0f);
+}
+
+
+static CVector4 TintShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	return CVector4(Mul(RGB(SamplePoint(SCENE_TEXTURE, sceneUV)), SETTINGS.tint.tintColour), 1.0f);
+}
+
+
+static CVector4 GreyNoiseShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	const float NoiseStrength = 0.5f;
+	const GreyNoiseConstants& settings = SETTINGS.greyNoise;
+
+	CVector3 sceneColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	float grey = (sceneColour.x + sceneColour.y + sceneColour.z) / 3.0f;
+
+	CVector2 noiseUV = Mul(sceneUV, settings.noiseScale) + settings.noiseOffset;
+	grey += NoiseStrength * (SampleWrap(context.maps.noiseMap, noiseUV).x - 0.5f);
+
+	return CVector4(grey, grey, grey, SoftCircleAlpha(areaUV, 0.20f));
+}
+
+
+static CVector4 BurnShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	const CVector3 burnColour = { 0.8f, 0.4f, 0.0f };
+	const CVector3 glowColour = { 1.0f, 0.8f, 0.0f };
+	const float glowAmount = 0.25f;
+	const float crinkle = 0.15f;
+	float burnHeight = SETTINGS.burn.burnHeight;
+
+	CVector4 burnTexture = SampleWrap(context.maps.burnMap, areaUV);
+	float burnLevelMax = burnHeight + glowAmount;
+
+	CVector3 outputColour;
+	if (burnTexture.x <= burnHeight)
+	{
+		outputColour = { 0.0f, 0.0f, 0.0f };
+	}
+	else if (burnTexture.x >= burnLevelMax)
+	{
+		outputColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	}
+	else
+	{
+		float glowLevel = 1.0f - (burnTexture.x - burnHeight) / glowAmount;
+
+		CVector2 crinkleVector = CVector2(burnTexture.y, burnTexture.z) - CVector2(0.5f, 0.5f);
+		CVector3 texColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV - glowLevel * crinkle * crinkleVector));
+
+		glowLevel *= 2.0f;
+		if (glowLevel < 1.0f)
+		{
+			outputColour = Lerp(texColour, Mul(burnColour, texColour), glowLevel);
+		}
+		else
+		{
+			outputColour = Lerp(Mul(burnColour, texColour), glowColour, glowLevel - 1.0f);
+		}
+	}
+	return CVector4(outputColour, 1.0f);
+}
+
+
+static CVector4 DistortShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	const float lightStrength = 0.015f;
+	const float glassDarken = 0.8f;
+
+	CVector4 distortTexture = SampleWrap(context.maps.distortMap, areaUV);
+	CVector2 distortVector = CVector2(distortTexture.y, distortTexture.z) - CVector2(0.5f, 0.5f);
+
+	float light = Dot(Normalise(distortVector), CVector2(0.707f, 0.707f)) * lightStrength;
+
+	CVector3 sceneColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV + SETTINGS.distort.distortLevel * distortVector));
+	CVector3 outputColour = sceneColour * glassDarken + CVector3(light, light, light);
+	return CVector4(outputColour, 1.0f);
+}
+
+
+static CVector4 SpiralShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	const PostProcessPassConstants& pass = context.passConstants;
+	float spiralLevel = SETTINGS.spiral.spiralLevel;
+
+	CVector2 centreUV = pass.area2DTopLeft + pass.area2DSize * 0.5f;
+	CVector2 centreOffsetUV = sceneUV - centreUV;
+	float centreDistance = Length(centreOffsetUV);
+
+	float s = std::sin(centreDistance * spiralLevel * spiralLevel);
+	float c = std::cos(centreDistance * spiralLevel * spiralLevel);
+	CVector2 rotatedOffsetUV = { centreOffsetUV.x * c - centreOffsetUV.y * s, centreOffsetUV.x * s + centreOffsetUV.y * c };
+
+	CVector3 outputColour = RGB(SamplePoint(SCENE_TEXTURE, centreUV + rotatedOffsetUV));
+	return CVector4(outputColour, SoftCircleAlpha(areaUV, 0.10f));
+}
+
+
+static CVector4 HeatHazeShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	const float effectStrength = 0.01f;
+	float timer = context.passConstants.timer;
+
+	float alpha = SoftCircleAlpha(areaUV, 0.15f);
+
+	float SinX = std::sin(areaUV.x * ToRadians(1440.0f) + timer * 3.0f);
+	float SinY = std::sin(areaUV.y * ToRadians(3600.0f) + timer * 3.7f);
+	CVector2 hazeOffset = Mul(CVector2(SinY, SinX) * (effectStrength * alpha), context.passConstants.area2DSize);
+
+	CVector3 outputColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV + hazeOffset));
+	alpha *= Saturate(SinX * SinY * 0.33f + 0.66f);
+	return CVector4(outputColour, alpha);
+}
+
+
+// Also the hue vertical gradient, which uses the same shader with colours that change over time
+static CVector4 VerticalGradientShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	const VerticalGradientConstants& settings = SETTINGS.verticalGradient;
+
+	CVector3 sceneColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	CVector3 gradientTint = Lerp(settings.topColour, settings.bottomColour, Saturate(areaUV.y));
+	return CVector4(Mul(sceneColour, gradientTint), 1.0f);
+}
+
+
+static CVector4 UnderwaterShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& areaUV)
+{
+	float timer = context.passConstants.timer;
+
+	CVector2 offset;
+	offset.x = std::sin(areaUV.x * ToRadians(360.0f) + timer * 3.0f);
+	offset.y = std::cos(areaUV.y * ToRadians(360.0f) + timer * 3.0f);
+	CVector2 waterOffset = offset * SETTINGS.underwater.amplitude;
+
+	CVector3 sceneColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV + waterOffset));
+	return CVector4(Mul(sceneColour, CVector3(0.0f, 0.3f, 0.6f)), 1.0f);
+}
+
+
+// Gaussian blur along the given axis (1,0 for horizontal, 0,1 for vertical). The taps are worked out by SetGaussianBlurKernel
+static CVector4 GaussianBlur(const CPUPassContext& context, const CVector2& sceneUV, const CVector2& axis)
+{
+	const GaussianBlurConstants& settings = SETTINGS.gaussianBlur;
+	if (!SCENE_TEXTURE)  return CVector4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Step by the size of a pixel in the image being read, which may be smaller than the viewport
+	CVector2 step = { axis.x / SCENE_TEXTURE->Width(), axis.y / SCENE_TEXTURE->Height() };
+
+	CVector3 outputColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV)) * settings.taps[0].y;
+	for (int i = 1; i < settings.numTaps; i++)
+	{
+		CVector2 offset = step * settings.taps[i].x;
+		outputColour += (RGB(SampleLinear(SCENE_TEXTURE, sceneUV + offset)) + RGB(SampleLinear(SCENE_TEXTURE, sceneUV - offset))) *
+		                settings.taps[i].y;
+	}
+	return CVector4(outputColour, 1.0f);
+}
+
+static CVector4 GaussianBlurHorizontalShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	return GaussianBlur(context, sceneUV, { 1.0f, 0.0f });
+}
+
+static CVector4 GaussianBlurVerticalShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	return GaussianBlur(context, sceneUV, { 0.0f, 1.0f });
+}
+
+
+static CVector4 MotionBlurShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	return CPUMotionBlurPixel(SETTINGS.motionBlur, context, sceneUV);
+}
+
+
+static CVector4 RetroGameShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const RetroGameConstants& settings = SETTINGS.retroGame;
+
+	CVector2 block = { std::floor(sceneUV.x * settings.pixelSize), std::floor(sceneUV.y * settings.pixelSize) };
+	CVector2 blockUV = { block.x / settings.pixelSize, block.y / settings.pixelSize };
+	CVector3 sampledColour = RGB(SamplePoint(SCENE_TEXTURE, blockUV));
+
+	float dither = OrderedDither(static_cast<int>(block.x), static_cast<int>(block.y)) * settings.ditherAmount;
+	sampledColour += CVector3(dither, dither, dither);
+
+	const PaletteIndex& paletteIndex = RetroGamePaletteIndex(settings.paletteSize);
+	int nearest = paletteIndex.Nearest(sampledColour);
+	CVector3 outputColour = nearest >= 0 ? paletteIndex.Palette()[nearest] : CVector3(0.0f, 0.0f, 0.0f);
+	return CVector4(outputColour, 1.0f);
+}
+
+
+static CVector4 BrightPassShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const BrightPassConstants& settings = SETTINGS.brightPass;
+
+	CVector3 sampleColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV)) * settings.exposure;
+	float luminance = Dot(sampleColour, CVector3(0.2126f, 0.7152f, 0.0722f));
+	float soft = SmoothStep(settings.bloomThreshold, settings.bloomThreshold + settings.bloomKnee, luminance);
+	return CVector4(sampleColour * soft, 1.0f);
+}
+
+
+static CVector4 LensStarShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const int numSamples = 6;
+	const CVector2 streakDirections[numSamples] = { {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}, {2.0f, 1.0f}, {-2.0f, 1.0f} };
+	const CVector3 streakColours[numSamples] = { {1.0f, 0.6f, 0.3f}, {0.3f, 1.0f, 0.6f}, {1.0f, 0.8f, 0.5f},
+	                                             {0.5f, 0.8f, 1.0f}, {1.0f, 0.4f, 0.2f}, {0.2f, 0.4f, 1.0f} };
+	const LensStarConstants& settings = SETTINGS.lensStar;
+
+	CVector3 totalStreaks = { 0.0f, 0.0f, 0.0f };
+	for (int streak = 0; streak < numSamples; streak++)
+	{
+		CVector3 colour = { 0.0f, 0.0f, 0.0f };
+		float weightSum = 0.0f;
+		CVector2 direction = Normalise(streakDirections[streak]) * settings.stepSize;
+
+		// The weights are powers of the attenuation, so each is the one before times the attenuation rather than a pow()
+		float weight = 1.0f;
+		for (int i = 1; i <= settings.streakLength; ++i)
+		{
+			weight *= settings.attenuation;
+			CVector3 sampleColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV + direction * static_cast<float>(i))) +
+			                        RGB(SamplePoint(SCENE_TEXTURE, sceneUV - direction * static_cast<float>(i)));
+			colour += Mul(sampleColour * weight, streakColours[streak]);
+			weightSum += 2.0f * weight;
+		}
+		if (weightSum > 0.0f)  totalStreaks += colour / weightSum;
+	}
+
+	CVector3 outputColour = { totalStreaks.x / (totalStreaks.x + 1.0f), totalStreaks.y / (totalStreaks.y + 1.0f),
+	                          totalStreaks.z / (totalStreaks.z + 1.0f) };
+	return CVector4(outputColour, 1.0f);
+}
+
+
+static CVector4 BloomShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const BloomConstants& settings = SETTINGS.bloom;
+
+	CVector3 sceneColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	CVector3 bloomColour = RGB(SampleLinear(context.inputs[1], sceneUV));
+	CVector3 starColour  = RGB(SampleLinear(context.inputs[2], sceneUV));
+	return CVector4(sceneColour + bloomColour * settings.bloomIntensity + starColour * settings.starIntensity, 1.0f);
+}
+
+
+// The composite of the depth of field (see CPUDepthOfField.h for the passes before)
+static CVector4 DepthOfFieldShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	CVector4 scene = SamplePoint(SCENE_TEXTURE, sceneUV);
+	CVector4 near  = SampleLinear(context.inputs[2], sceneUV);
+
+	float farBlend = Saturate(scene.w * DOF_MAX_COC_PIXELS - 0.5f);
+	if (farBlend == 0.0f && near.w == 0.0f)  return CVector4(RGB(scene), 1.0f);
+
+	CVector3 outputColour = Lerp(RGB(scene), RGB(SampleLinear(context.inputs[1], sceneUV)), farBlend);
+	outputColour = outputColour * (1.0f - near.w) + RGB(near);
+	return CVector4(outputColour, 1.0f);
+}
+
+
+static CVector4 WireframeShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const float kernelX[9] = { -1.0f, 0.0f, 1.0f, -2.0f, 0.0f, 2.0f, -1.0f, 0.0f, 1.0f };
+	const float kernelY[9] = { -1.0f, -2.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 1.0f };
+	const WireframeConstants& settings = SETTINGS.wireframe;
+
+	// Sobel edge detection, in the same (column by column) order as the shader
+	float gradientX = 0.0f;
+	float gradientY = 0.0f;
+	int index = 0;
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			CVector2 offset = Mul(CVector2(static_cast<float>(x), static_cast<float>(y)), context.passConstants.texelSize);
+			float gray = Dot(RGB(SamplePoint(SCENE_TEXTURE, sceneUV + offset)), CVector3(0.299f, 0.587f, 0.114f));
+			gradientX += gray * kernelX[index];
+			gradientY += gray * kernelY[index];
+			index++;
+		}
+	}
+	float edge = std::sqrt(gradientX * gradientX + gradientY * gradientY);
+
+	edge = Saturate(std::pow(edge, settings.edgePower) * (1.0f / settings.edgeThreshold));
+	return CVector4(edge, edge, edge, 1.0f);
+}
+
+
+static CVector4 FogShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const FogConstants& settings = SETTINGS.fog;
+
+	CVector3 sampledColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	float depth = SamplePoint(context.inputs[1], sceneUV).x;
+	float linearDepth = LinearizeDepth(depth, settings.nearClip, settings.farClip);
+
+	float fogFactor = std::exp(-linearDepth * settings.fogDensity);
+	float heightFog = Saturate(std::exp(-(linearDepth - settings.fogHeightStart) * settings.fogHeightDensity));
+	float totalFog = Saturate(1.0f - fogFactor * heightFog);
+
+	return CVector4(Lerp(sampledColour, settings.fogColour, totalFog), 1.0f);
+}
+
+
+static CVector4 InvertShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	CVector3 colour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	return CVector4(1.0f - colour.x, 1.0f - colour.y, 1.0f - colour.z, 1.0f);
+}
+
+
+static float NightVisionHash(float n)
+{
+	return Frac(std::sin(n) * 43758.5453123f);
+}
+
+static CVector4 NightVisionShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const NightVisionConstants& settings = SETTINGS.nightVision;
+	float timer = context.passConstants.timer;
+
+	CVector3 sampledColour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	sampledColour += RGB(SamplePoint(SCENE_TEXTURE, sceneUV + CVector2(0.001f, 0.001f)));
+	sampledColour += RGB(SamplePoint(SCENE_TEXTURE, sceneUV + CVector2(-0.002f, -0.002f)));
+	sampledColour += RGB(SamplePoint(SCENE_TEXTURE, sceneUV + CVector2(0.003f, -0.003f)));
+
+	if ((sampledColour.x + sampledColour.y + sampledColour.z) / 3.0f < settings.luminanceThreshold)
+	{
+		sampledColour /= 4.0f;
+	}
+
+	CVector3 stageOneColour = sampledColour + settings.brightnessBoost;
+	float luminance = (stageOneColour.x + stageOneColour.y + stageOneColour.z) / 3.0f;
+	CVector3 combinedColour = CVector3(0.0f, luminance, 0.0f) * settings.intensity;
+
+	float noise = NightVisionHash((NightVisionHash(sceneUV.x) + sceneUV.y) * timer) * settings.noiseIntensity;
+	float flicker = std::sin(NightVisionHash(timer)) * settings.flickerIntensity;
+	combinedColour += CVector3(noise + flicker, noise + flicker, noise + flicker);
+
+	CVector2 coord = sceneUV * 2.0f - CVector2(1.0f, 1.0f);
+	coord.x *= static_cast<float>(context.viewportWidth) / static_cast<float>(context.viewportHeight);
+	CVector2 cubed = Mul(Mul(coord, coord), coord);
+	float vignette = SmoothStep(Length(Mul(cubed, CVector2(0.075f, settings.vignetteIntensity))), 1.0f, 0.4f);
+	combinedColour *= vignette;
+
+	float finalLuminance = Dot(combinedColour, CVector3(0.2126f, 0.7152f, 0.0722f));
+	float tintShift = NightVisionHash(timer) * 0.1f;
+	CVector3 tint = settings.nightVisionTint - CVector3(tintShift, tintShift, tintShift);
+	return CVector4(tint * finalLuminance, 1.0f);
+}
+
+
+static CVector4 GameBoyShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const GameBoyConstants& settings = SETTINGS.gameBoy;
+
+	CVector2 pixel = { std::floor(sceneUV.x * settings.gameBoyPixelSize), std::floor(sceneUV.y * settings.gameBoyPixelSize) };
+	CVector2 pixelatedUV = { pixel.x / settings.gameBoyPixelSize, pixel.y / settings.gameBoyPixelSize };
+	CVector3 sampledColour = RGB(SamplePoint(SCENE_TEXTURE, pixelatedUV));
+
+	float grayscale = 0.299f * sampledColour.x + 0.587f * sampledColour.y + 0.114f * sampledColour.z;
+	float dither = OrderedDither(static_cast<int>(pixel.x), static_cast<int>(pixel.y)) * settings.ditherAmount;
+	grayscale = std::round(grayscale * settings.gameBoyColourDepth + dither) / settings.gameBoyColourDepth;
+	return CVector4(settings.gameBoyColour * grayscale, 1.0f);
+}
+
+
+static CVector4 SepiaShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	CVector3 colour = RGB(SamplePoint(SCENE_TEXTURE, sceneUV));
+	return CVector4(Dot(colour, CVector3(0.393f, 0.769f, 0.189f)),
+	                Dot(colour, CVector3(0.349f, 0.686f, 0.168f)),
+	                Dot(colour, CVector3(0.272f, 0.534f, 0.131f)), 1.0f);
+}
+
+
+static CVector4 ChromaticDistortionShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	const ChromaticDistortionConstants& settings = SETTINGS.chromaticDistortion;
+
+	// Samples outside the screen are black
+	auto safeSampleScene = [&](const CVector2& uv)
+	{
+		if (uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f)  return CVector3(0.0f, 0.0f, 0.0f);
+		return RGB(SamplePoint(SCENE_TEXTURE, uv));
+	};
+
+	CVector2 offset = sceneUV - settings.screenCenter;
+	float dist = Length(offset);
+	float distortedDist = dist * (1.0f + settings.distortionAmount * dist * dist);
+
+	CVector2 direction = Normalise(offset);
+	CVector2 uvDistorted = settings.screenCenter + direction * distortedDist;
+
+	CVector2 uvR = uvDistorted + direction * (settings.chromAbAmount * dist);
+	CVector2 uvB = uvDistorted - direction * (settings.chromAbAmount * dist);
+
+	return CVector4(safeSampleScene(uvR).x, safeSampleScene(uvDistorted).y, safeSampleScene(uvB).z, 1.0f);
+}
+
+
+static CVector4 DilationShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	int kernelRadius = SETTINGS.dilation.kernelRadius;
+	CVector2 pixelSize = { 1.0f / context.viewportWidth, 1.0f / context.viewportHeight };
+
+	CVector3 outputColour = { 0.0f, 0.0f, 0.0f };
+	for (int y = -kernelRadius; y <= kernelRadius; y++)
+	{
+		for (int x = -kernelRadius; x <= kernelRadius; x++)
+		{
+			CVector2 offset = Mul(CVector2(static_cast<float>(x), static_cast<float>(y)), pixelSize);
+			outputColour = Max(outputColour, RGB(SamplePoint(SCENE_TEXTURE, sceneUV + offset)));
+		}
+	}
+	return CVector4(outputColour, 1.0f);
+}
+
+
+static CVector4 OnePassBlurShader(const CPUPassContext& context, const CVector2& sceneUV, const CVector2&)
+{
+	int blurRadius = SETTINGS.onePassBlur.blurRadius;
+	float tapSpacing = static_cast<float>(SETTINGS.onePassBlur.tapSpacing);
+	CVector2 tapSize = { tapSpacing / context.viewportWidth, tapSpacing / context.viewportHeight };
+
+	CVector3 blurredColour = { 0.0f, 0.0f, 0.0f };
+	for (int y = -blurRadius; y <= blurRadius; y++)
+	{
+		for (int x = -blurRadius; x <= blurRadius; x++)
+		{
+			CVector2 offset = Mul(CVector2(static_cast<float>(x), static_cast<float>(y)), tapSize);
+			blurredColour += RGB(SamplePoint(SCENE_TEXTURE, sceneUV + offset));
+		}
+	}
+	float kernelWidth = static_cast<float>(2 * blurRadius + 1);
+	return CVector4(blurredColour / (kernelWidth * kernelWidth), 1.0f);
+}
+
+#undef SCENE_TEXTURE
+#undef SETTINGS
+
+
+// The pixel function for each post-process
+static CPUPixelShader PixelShader(PostProcess postProcess)
+{
+	switch (postProcess)
+	{
+	case PostProcess::Tint:                   return TintShader;
+	case PostProcess::GreyNoise:              return GreyNoiseShader;
+	case PostProcess::Burn:                   return BurnShader;
+	case PostProcess::Distort:                return DistortShader;
+	case PostProcess::Spiral:                 return SpiralShader;
+	case PostProcess::HeatHaze:               return HeatHazeShader;
+	case PostProcess::VerticalGradient:       return VerticalGradientShader;
+	case PostProcess::HueVerticalGradient:    return VerticalGradientShader;
+	case PostProcess::Underwater:             return UnderwaterShader;
+	case PostProcess::GaussianBlurHorizontal: return GaussianBlurHorizontalShader;
+	case PostProcess::GaussianBlurVertical:   return GaussianBlurVerticalShader;
+	case PostProcess::MotionBlur:             return MotionBlurShader;
+	case PostProcess::RetroGame:              return RetroGameShader;
+	case PostProcess::BrightPass:             return BrightPassShader;
+	case PostProcess::LensStar:               return LensStarShader;
+	case PostProcess::Bloom:                  return BloomShader;
+	case PostProcess::DepthOfField:           return DepthOfFieldShader;
+	case PostProcess::Wireframe:              return WireframeShader;
+	case PostProcess::Fog:                    return FogShader;
+	case PostProcess::Invert:                 return InvertShader;
+	case PostProcess::NightVision:            return NightVisionShader;
+	case PostProcess::GameBoy:                return GameBoyShader;
+	case PostProcess::Sepia:                  return SepiaShader;
+	case PostProcess::ChromaticDis:           return ChromaticDistortionShader;
+	case PostProcess::Dilation:               return DilationShader;
+	case PostProcess::OnePassBlur:            return OnePassBlurShader;
+	default:                                  return CopyShader; // None and Copy
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Row versions of simple effects
+//--------------------------------------------------------------------------------------
+// Full screen effects that read each input at the pixel being written, and do the same maths on every
+// pixel, can work along whole rows with vector instructions. Only used when the inputs are the same size
+// as the target (so point and bilinear sampling at pixel centres both give just that pixel)
+
+// Colour = red * column 0 + green * column 1 + blue * column 2 + column 3. The w of columns 0-2 must be 0 and
+// column 3's w 1 so the result is opaque. Covers copy, tint, invert and sepia
+struct ColourMatrix
+{
+	CVector4 columns[4];
+};
+
+static void ColourMatrixRow(const CVector4* in, CVector4* out, int count, const ColourMatrix& matrix)
+{
+	int i = 0;
+
+#if defined(CPU_SIMD_AVX2)
+	// Two pixels at a time, the shuffles copy a channel across its own pixel's half of the register
+	auto broadcast = [](const CVector4& column)
+	{
+		__m128 value = _mm_loadu_ps(&column.x);
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(value), value, 1);
+	};
+	const __m256 wide0 = broadcast(matrix.columns[0]);
+	const __m256 wide1 = broadcast(matrix.columns[1]);
+	const __m256 wide2 = broadcast(matrix.columns[2]);
+	const __m256 wide3 = broadcast(matrix.columns[3]);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m256 colour = _mm256_loadu_ps(&in[i].x);
+		__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_permute_ps(colour, 0x00), wide0), _mm256_mul_ps(_mm256_permute_ps(colour, 0x55), wide1));
+		result = _mm256_add_ps(_mm256_add_ps(result, _mm256_mul_ps(_mm256_permute_ps(colour, 0xAA), wide2)), wide3);
+		_mm256_storeu_ps(&out[i].x, result);
+	}
+#endif
+#if defined(CPU_SIMD_SSE2)
+	const __m128 c0 = _mm_loadu_ps(&matrix.columns[0].x);
+	const __m128 c1 = _mm_loadu_ps(&matrix.columns[1].x);
+	const __m128 c2 = _mm_loadu_ps(&matrix.columns[2].x);
+	const __m128 c3 = _mm_loadu_ps(&matrix.columns[3].x);
+	for (; i < count; ++i)
+	{
+		__m128 colour = _mm_loadu_ps(&in[i].x);
+		__m128 result = _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(colour, colour, 0x00), c0), _mm_mul_ps(_mm_shuffle_ps(colour, colour, 0x55), c1));
+		result = _mm_add_ps(_mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(colour, colour, 0xAA), c2)), c3);
+		_mm_storeu_ps(&out[i].x, result);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		const CVector4& c = in[i];
+		const CVector4* m = matrix.columns;
+		out[i] = CVector4(c.x * m[0].x + c.y * m[1].x + c.z * m[2].x + m[3].x,
+		                  c.x * m[0].y + c.y * m[1].y + c.z * m[2].y + m[3].y,
+		                  c.x * m[0].z + c.y * m[1].z + c.z * m[2].z + m[3].z, 1.0f);
+	}
+}
+
+
+// Colour = a + b * weightB + c * weightC, opaque. Covers bloom
+static void CombineRow(const CVector4* a, const CVector4* b, const CVector4* c, CVector4* out, int count, float addB, float addC)
+{
+	int i = 0;
+
+#if defined(CPU_SIMD_SSE2)
+	// The AVX version gains little here, the loop is limited by memory
+	const __m128 rgbMask  = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alphaOne = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	const __m128 scaleB   = _mm_set1_ps(addB);
+	const __m128 scaleC   = _mm_set1_ps(addC);
+	for (; i < count; ++i)
+	{
+		__m128 colourA = _mm_loadu_ps(&a[i].x);
+		__m128 colourB = _mm_loadu_ps(&b[i].x);
+		__m128 result  = _mm_add_ps(colourA, _mm_mul_ps(colourB, scaleB));
+		if (c)  result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&c[i].x), scaleC));
+		_mm_storeu_ps(&out[i].x, _mm_or_ps(_mm_and_ps(result, rgbMask), alphaOne));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		CVector3 result = RGB(a[i]) + RGB(b[i]) * addB;
+		if (c)  result += RGB(c[i]) * addC;
+		out[i] = CVector4(result, 1.0f);
+	}
+}
+
+
+// The four LUT entries to blend for a colour and their weights, for tetrahedral interpolation. The colour's grid cell is
+// split into six tetrahedra that share the cell's darkest and brightest corners, and the colour is in the one found by
+// stepping along its axes in order of how far into the cell it is on each. Colours outside 0->1 use the nearest entries
+// Takes the cell's first entry and the colour's fractions across the cell on each axis
+static void LUTTetrahedron(const CVector4* cellEntry, const float fraction[3], int size, const CVector4* corners[4], float weights[4])
+{
+	const int step[3] = { 1, size, size * size };
+
+	// Axes sorted by fraction, largest first
+	int first = 0, second = 1, third = 2;
+	if (fraction[first]  < fraction[second])  std::swap(first, second);
+	if (fraction[second] < fraction[third])   std::swap(second, third);
+	if (fraction[first]  < fraction[second])  std::swap(first, second);
+
+	corners[0] = cellEntry;
+	corners[1] = corners[0] + step[first];
+	corners[2] = corners[1] + step[second];
+	corners[3] = corners[2] + step[third];
+	weights[0] = 1.0f - fraction[first];
+	weights[1] = fraction[first]  - fraction[second];
+	weights[2] = fraction[second] - fraction[third];
+	weights[3] = fraction[third];
+}
+
+// Colour = the LUT's result for the colour, opaque
+static void ColourLUTRow(const CVector4* in, CVector4* out, int count, const ColourLUT& lut)
+{
+	const int       size    = lut.Size();
+	const float     scale   = static_cast<float>(size - 1);
+	const CVector4* entries = lut.Entries().data();
+	const CVector4* corners[4];
+	float fraction[4];
+	float weights[4];
+	int i = 0;
+
+#if defined(CPU_SIMD_SSE2)
+	// All channels at once, other than sorting the fractions
+	const __m128 rgbMask  = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alphaOne = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	const __m128 maxPosition = _mm_set1_ps(scale);
+	const __m128 maxCell     = _mm_set1_ps(scale - 1.0f);
+	for (; i < count; ++i)
+	{
+		__m128 position = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[i].x), maxPosition), _mm_setzero_ps()), maxPosition);
+		__m128 cell     = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(position)), maxCell);
+		_mm_storeu_ps(fraction, _mm_sub_ps(position, cell));
+		alignas(16) int cellIndex[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(cellIndex), _mm_cvttps_epi32(cell));
+
+		LUTTetrahedron(entries + cellIndex[0] + size * (cellIndex[1] + size * cellIndex[2]), fraction, size, corners, weights);
+		__m128 result = _mm_mul_ps(_mm_loadu_ps(&corners[0]->x), _mm_set1_ps(weights[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&corners[1]->x), _mm_set1_ps(weights[1])));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&corners[2]->x), _mm_set1_ps(weights[2])));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&corners[3]->x), _mm_set1_ps(weights[3])));
+		_mm_storeu_ps(&out[i].x, _mm_or_ps(_mm_and_ps(result, rgbMask), alphaOne));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		int cellIndex[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float position  = std::min(std::max((&in[i].x)[axis] * scale, 0.0f), scale);
+			cellIndex[axis] = std::min(static_cast<int>(position), size - 2);
+			fraction[axis]  = position - cellIndex[axis];
+		}
+
+		LUTTetrahedron(entries + cellIndex[0] + size * (cellIndex[1] + size * cellIndex[2]), fraction, size, corners, weights);
+		CVector3 result = RGB(*corners[0]) * weights[0] + RGB(*corners[1]) * weights[1] +
+		                  RGB(*corners[2]) * weights[2] + RGB(*corners[3]) * weights[3];
+		out[i] = CVector4(result, 1.0f);
+	}
+}
+
+
+// The weight of each pixel from the centre out in a Gaussian blur kernel, returns the radius. Each tap after the first
+// stands for two pixels, the split between them is given by where the tap sits between the two
+static int GaussianPixelWeights(const GaussianBlurConstants& settings, float weights[2 * GAUSSIAN_MAX_TAPS])
+{
+	int numTaps = std::min(std::max(settings.numTaps, 1), GAUSSIAN_MAX_TAPS);
+	int radius = 0;
+	weights[0] = settings.taps[0].y;
+	for (int tap = 1; tap < numTaps; ++tap)
+	{
+		int   first  = 2 * tap - 1;
+		float weight = settings.taps[tap].y;
+		float second = weight * std::min(std::max(settings.taps[tap].x - first, 0.0f), 1.0f);
+		weights[first]     = weight - second;
+		weights[first + 1] = second;
+		radius = (second > 0.0f) ? first + 1 : first;
+	}
+	return radius;
+}
+
+// Colour = weights[0] * lines[0][x] + weights[i] * (lines[-i][x] + lines[i][x]) for each i up to the radius, opaque. The
+// lines are rows of the image above and below for a vertical blur, or the same row shifted along for a horizontal one
+static void GaussianBlurRow(const CVector4* const* lines, const float* weights, int radius, CVector4* out, int count)
+{
+	int i = 0;
+
+#if defined(CPU_SIMD_AVX2)
+	const __m256 rgbMask2  = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+	const __m256 alphaOne2 = _mm256_set_ps(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m256 result = _mm256_mul_ps(_mm256_loadu_ps(&lines[0][i].x), _mm256_set1_ps(weights[0]));
+		for (int tap = 1; tap <= radius; ++tap)
+		{
+			__m256 pair = _mm256_add_ps(_mm256_loadu_ps(&lines[-tap][i].x), _mm256_loadu_ps(&lines[tap][i].x));
+			result = _mm256_add_ps(result, _mm256_mul_ps(pair, _mm256_set1_ps(weights[tap])));
+		}
+		_mm256_storeu_ps(&out[i].x, _mm256_or_ps(_mm256_and_ps(result, rgbMask2), alphaOne2));
+	}
+#endif
+#if defined(CPU_SIMD_SSE2)
+	const __m128 rgbMask  = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alphaOne = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	for (; i < count; ++i)
+	{
+		__m128 result = _mm_mul_ps(_mm_loadu_ps(&lines[0][i].x), _mm_set1_ps(weights[0]));
+		for (int tap = 1; tap <= radius; ++tap)
+		{
+			__m128 pair = _mm_add_ps(_mm_loadu_ps(&lines[-tap][i].x), _mm_loadu_ps(&lines[tap][i].x));
+			result = _mm_add_ps(result, _mm_mul_ps(pair, _mm_set1_ps(weights[tap])));
+		}
+		_mm_storeu_ps(&out[i].x, _mm_or_ps(_mm_and_ps(result, rgbMask), alphaOne));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		CVector3 result = RGB(lines[0][i]) * weights[0];
+		for (int tap = 1; tap <= radius; ++tap)
+		{
+			result += (RGB(lines[-tap][i]) + RGB(lines[tap][i])) * weights[tap];
+		}
+		out[i] = CVector4(result, 1.0f);
+	}
+}
+
+// Run a Gaussian blur pass over the tile a row at a time. Every pixel is read once for each of its weights, rather than
+// as two bilinear samples of four pixels each. Reads past the edge of the input (or its window) give the edge pixel, as
+// the clamped bilinear sampler does
+static void GaussianBlurRows(bool vertical, const GaussianBlurConstants& settings, const CPUImage& input, const PixelRect& tile,
+                             CPUImage& target, std::vector<CVector4>& rowBuffer)
+{
+	float weights[2 * GAUSSIAN_MAX_TAPS] = {};
+	int radius = GaussianPixelWeights(settings, weights);
+
+	const PixelRect& window = input.Window();
+	int width = tile.right - tile.left;
+	rowBuffer.resize(width);
+
+	const CVector4* lineArray[4 * GAUSSIAN_MAX_TAPS];
+	const CVector4** lines = lineArray + 2 * GAUSSIAN_MAX_TAPS; // So lines[-radius] to lines[radius] can be used
+	std::vector<CVector4> paddedRow(vertical ? 0 : width + 2 * radius);
+	for (int y = tile.top; y < tile.bottom; ++y)
+	{
+		if (vertical)
+		{
+			for (int tap = -radius; tap <= radius; ++tap)
+			{
+				lines[tap] = input.Row(std::min(std::max(y + tap, window.top), window.bottom - 1)) + tile.left;
+			}
+		}
+		else
+		{
+			// Copy the row with the pixels either side of the tile, then each line is the same row starting further along
+			const CVector4* row = input.Row(y);
+			for (int x = 0; x < width + 2 * radius; ++x)
+			{
+				paddedRow[x] = row[std::min(std::max(tile.left - radius + x, window.left), window.right - 1)];
+			}
+			for (int tap = -radius; tap <= radius; ++tap)  lines[tap] = paddedRow.data() + radius + tap;
+		}
+
+		GaussianBlurRow(lines, weights, radius, rowBuffer.data(), width);
+		target.Store(tile.left, y, rowBuffer.data(), width);
+	}
+}
+
+
+// If the effect has a row version that can be used for this draw, run it over the given tile and return true
+static bool RowPostProcess(PostProcess postProcess, const CPUPassContext& context, const PixelRect& tile, CPUImage& target,
+                           std::vector<CVector4>& rowBuffer)
+{
+	// All the images read must match the target's size
+	auto matchesTarget = [&](const CPUImage* image)
+	{
+		return image && image->Width() == target.Width() && image->Height() == target.Height();
+	};
+	if (!matchesTarget(context.inputs[0]))  return false;
+
+	const PostProcessEffectConstants& settings = *context.effectConstants;
+	if (postProcess == PostProcess::GaussianBlurHorizontal || postProcess == PostProcess::GaussianBlurVertical)
+	{
+		GaussianBlurRows(postProcess == PostProcess::GaussianBlurVertical, settings.gaussianBlur, *context.inputs[0], tile, target, rowBuffer);
+		return true;
+	}
+
+	const CPUImage* inputB = nullptr;
+	const CPUImage* inputC = nullptr;
+	ColourMatrix matrix = { { {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1} } };
+	float addB = 0, addC = 0;
+	bool useMatrix = true;
+
+	switch (postProcess)
+	{
+	case PostProcess::None:
+	case PostProcess::Copy:
+		break;
+
+	case PostProcess::Tint:
+		matrix.columns[0].x = settings.tint.tintColour.x;
+		matrix.columns[1].y = settings.tint.tintColour.y;
+		matrix.columns[2].z = settings.tint.tintColour.z;
+		break;
+
+	case PostProcess::Invert:
+		matrix = { { {-1, 0, 0, 0}, {0, -1, 0, 0}, {0, 0, -1, 0}, {1, 1, 1, 1} } };
+		break;
+
+	case PostProcess::Sepia:
+		matrix = { { {0.393f, 0.349f, 0.272f, 0}, {0.769f, 0.686f, 0.534f, 0}, {0.189f, 0.168f, 0.131f, 0}, {0, 0, 0, 1} } };
+		break;
+
+	case PostProcess::Bloom:
+		if (!matchesTarget(context.inputs[1]) || !matchesTarget(context.inputs[2]))  return false;
+		useMatrix = false;
+		inputB = context.inputs[1];
+		inputC = context.inputs[2];
+		addB   = settings.bloom.bloomIntensity;
+		addC   = settings.bloom.starIntensity;
+		break;
+
+	default:
+		return false;
+	}
+
+	int width = tile.right - tile.left;
+	rowBuffer.resize(width);
+	for (int y = tile.top; y < tile.bottom; ++y)
+	{
+		const CVector4* rowA = context.inputs[0]->Row(y) + tile.left;
+		if (useMatrix)
+		{
+			ColourMatrixRow(rowA, rowBuffer.data(), width, matrix);
+		}
+		else
+		{
+			CombineRow(rowA, inputB->Row(y) + tile.left, inputC ? inputC->Row(y) + tile.left : nullptr, rowBuffer.data(), width, addB, addC);
+		}
+		target.Store(tile.left, y, rowBuffer.data(), width);
+	}
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Drawing
+//--------------------------------------------------------------------------------------
+
+// Generated map used for any of the fixed textures that hasn't been given
+static const CPUImage* FallbackMap()
+{
+	static const CPUImage map = []() { CPUImage image; MakeNoiseMap(image, 256, 1); return image; }();
+	return &map;
+}
+
+CPUPassContext WithFallbackMaps(const CPUPassContext& context)
+{
+	CPUPassContext result = context;
+	if (!result.maps.noiseMap)    result.maps.noiseMap   = FallbackMap();
+	if (!result.maps.burnMap)     result.maps.burnMap    = FallbackMap();
+	if (!result.maps.distortMap)  result.maps.distortMap = FallbackMap();
+	return result;
+}
+
+
+void CPUFullScreenPostProcess(PostProcess postProcess, const CPUPassContext& context, CPUImage& target)
+{
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		CPUFullScreenPostProcessRect(postProcess, context, tile, target);
+	});
+}
+
+
+void CPUFullScreenPostProcessRect(PostProcess postProcess, const CPUPassContext& context, const PixelRect& rect, CPUImage& target)
+{
+	if (rect.IsEmpty())  return;
+
+	CPUPassContext drawContext = WithFallbackMaps(context);
+	drawContext.passConstants.area2DTopLeft = { 0, 0 };
+	drawContext.passConstants.area2DSize    = { 1, 1 };
+	drawContext.passConstants.area2DDepth   = 0;
+
+	std::vector<CVector4> rowBuffer;
+	if (RowPostProcess(postProcess, drawContext, rect, target, rowBuffer))  return;
+
+	CPUPixelShader shader = PixelShader(postProcess);
+	float width  = static_cast<float>(target.Width());
+	float height = static_cast<float>(target.Height());
+
+	rowBuffer.resize(rect.right - rect.left);
+	for (int y = rect.top; y < rect.bottom; ++y)
+	{
+		for (int x = rect.left; x < rect.right; ++x)
+		{
+			// The scene and area UVs are the same for a full screen quad
+			CVector2 uv = { (x + 0.5f) / width, (y + 0.5f) / height };
+			rowBuffer[x - rect.left] = shader(drawContext, uv, uv);
+		}
+		target.Store(rect.left, y, rowBuffer.data(), rect.right - rect.left);
+	}
+}
+
+
+void CPUColourTransform(const ColourTransformConstants& constants, TargetFormat stageFormat, const CPUPassContext& context, CPUImage& target)
+{
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		CPUColourTransformRect(constants, stageFormat, context, tile, target);
+	});
+}
+
+
+// The matrix of a colour transform stage in the form used by ColourMatrixRow, lerped from the given top rows to the bottom
+// rows by t
+static ColourMatrix ColourStageMatrix(const CVector4* topRows, const CVector4* bottomRows, float t)
+{
+	ColourMatrix matrix;
+	for (int column = 0; column < 4; ++column)
+	{
+		auto element = [&](int channel)
+		{
+			float top    = (&topRows[channel].x)[column];
+			float bottom = (&bottomRows[channel].x)[column];
+			return top + t * (bottom - top);
+		};
+		matrix.columns[column] = CVector4(element(0), element(1), element(2), column == 3 ? 1.0f : 0.0f);
+	}
+	return matrix;
+}
+
+void CPUColourTransformRect(const ColourTransformConstants& constants, TargetFormat stageFormat, const CPUPassContext& context,
+                            const PixelRect& rect, CPUImage& target)
+{
+	if (rect.IsEmpty() || constants.numStages < 1)  return;
+
+	// Stages before the last are the same everywhere
+	int lastStage = constants.numStages - 1;
+	std::vector<ColourMatrix> stages;
+	for (int stage = 0; stage < lastStage; ++stage)
+	{
+		const CVector4* rows = &constants.stageRows[stage * 3];
+		stages.push_back(ColourStageMatrix(rows, rows, 0.0f));
+	}
+
+	int width = rect.right - rect.left;
+	std::vector<CVector4> rowBuffer(width);
+	for (int y = rect.top; y < rect.bottom; ++y)
+	{
+		const CVector4* row = context.inputs[0]->Row(y) + rect.left;
+		for (const ColourMatrix& matrix : stages)
+		{
+			ColourMatrixRow(row, rowBuffer.data(), width, matrix);
+			RoundToFormat(rowBuffer.data(), rowBuffer.data(), width, stageFormat);
+			row = rowBuffer.data();
+		}
+
+		// The last stage only changes down the screen, so one matrix for the whole row. Full screen, so area V is scene V
+		float t = Saturate((y + 0.5f) / static_cast<float>(target.Height()));
+		ColourMatrixRow(row, rowBuffer.data(), width, ColourStageMatrix(&constants.stageRows[lastStage * 3], constants.lastStageBottom, t));
+		target.Store(rect.left, y, rowBuffer.data(), width);
+	}
+}
+
+
+void CPUColourLUTPostProcess(const ColourLUT& lut, const CPUPassContext& context, CPUImage& target)
+{
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		CPUColourLUTPostProcessRect(lut, context, tile, target);
+	});
+}
+
+void CPUColourLUTPostProcessRect(const ColourLUT& lut, const CPUPassContext& context, const PixelRect& rect, CPUImage& target)
+{
+	if (rect.IsEmpty() || lut.Size() < 2)  return;
+
+	int width = rect.right - rect.left;
+	std::vector<CVector4> rowBuffer(width);
+	for (int y = rect.top; y < rect.bottom; ++y)
+	{
+		ColourLUTRow(context.inputs[0]->Row(y) + rect.left, rowBuffer.data(), width, lut);
+		target.Store(rect.left, y, rowBuffer.data(), width);
+	}
+}
+
+
+// Where a pixel centre of the target falls between two pixels of an image of the given size, as SampleBilinear finds it
+struct ResampleStep
+{
+	int   first;
+	int   second;
+	float fraction;
+};
+
+static ResampleStep FindResampleStep(int position, int targetSize, int imageSize, int windowStart, int windowEnd)
+{
+	float uv = (position + 0.5f) / static_cast<float>(targetSize);
+	float f  = std::min(std::max(uv * imageSize - 0.5f, -1.0f), static_cast<float>(imageSize));
+	float floorF = std::floor(f);
+
+	ResampleStep step;
+	step.first    = std::min(std::max(static_cast<int>(floorF),     windowStart), windowEnd - 1);
+	step.second   = std::min(std::max(static_cast<int>(floorF) + 1, windowStart), windowEnd - 1);
+	step.fraction = f - floorF;
+	return step;
+}
+
+void CPUResample(const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* input = context.inputs[0];
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	if (!input)
+	{
+		std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+		for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+		return;
+	}
+
+	// Every row of the target reads the same columns of the input, so find them once
+	const PixelRect& window = input->Window();
+	std::vector<ResampleStep> columns(target.Width());
+	for (int x = 0; x < target.Width(); ++x)
+	{
+		columns[x] = FindResampleStep(x, target.Width(), input->Width(), window.left, window.right);
+	}
+
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			ResampleStep row = FindResampleStep(y, target.Height(), input->Height(), window.top, window.bottom);
+			const CVector4* top    = input->Row(row.first);
+			const CVector4* bottom = input->Row(row.second);
+			for (int x = tile.left; x < tile.right; ++x)
+			{
+				const ResampleStep& column = columns[x];
+				CVector3 topColour    = Lerp(RGB(top[column.first]),    RGB(top[column.second]),    column.fraction);
+				CVector3 bottomColour = Lerp(RGB(bottom[column.first]), RGB(bottom[column.second]), column.fraction);
+				rowBuffer[x - tile.left] = CVector4(Lerp(topColour, bottomColour, row.fraction), 1.0f);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
+
+
+void CPUReducedResolutionUpsample(const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* image   = context.inputs[0];
+	const CPUImage* changed = context.inputs[1];
+	const CPUImage* source  = context.inputs[2];
+	PixelRect targetRect = { 0, 0, target.Width(), target.Height() };
+	if (!image || !changed || !source)
+	{
+		std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+		for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+		return;
+	}
+
+	// The four small pixels around each target pixel are the ones bilinear filtering would blend, found as for resampling
+	const PixelRect& window = source->Window();
+	std::vector<ResampleStep> columns(target.Width());
+	for (int x = 0; x < target.Width(); ++x)
+	{
+		columns[x] = FindResampleStep(x, target.Width(), source->Width(), window.left, window.right);
+	}
+
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			ResampleStep row = FindResampleStep(y, target.Height(), source->Height(), window.top, window.bottom);
+			const CVector4* imageRow = image->Row(y);
+			for (int x = tile.left; x < tile.right; ++x)
+			{
+				const ResampleStep& column = columns[x];
+				CVector3 colour = RGB(imageRow[x]);
+
+				// ReducedResolutionUpsample_pp.hlsl - bilinear weights scaled by how alike the colours before the effect are
+				const int   tapX[4] = { column.first, column.second, column.first, column.second };
+				const int   tapY[4] = { row.first, row.first, row.second, row.second };
+				const float bilinear[4] = { (1.0f - column.fraction) * (1.0f - row.fraction), column.fraction * (1.0f - row.fraction),
+				                            (1.0f - column.fraction) * row.fraction,          column.fraction * row.fraction };
+				CVector3 change = { 0.0f, 0.0f, 0.0f };
+				float totalWeight = 0.0f;
+				for (int tap = 0; tap < 4; ++tap)
+				{
+					CVector3 sourceColour  = RGB(source->Row(tapY[tap])[tapX[tap]]);
+					CVector3 changedColour = RGB(changed->Row(tapY[tap])[tapX[tap]]);
+					CVector3 difference = colour - sourceColour;
+					float weight = bilinear[tap] * (std::exp(-Dot(difference, difference) * 50.0f) + 0.001f);
+					change += (changedColour - sourceColour) * weight;
+					totalWeight += weight;
+				}
+				rowBuffer[x - tile.left] = CVector4(colour + change / totalWeight, 1.0f);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
+
+
+void CPUAreaPostProcess(PostProcess postProcess, const CPUPassContext& context, const PostProcessRegion& region, CPUImage& target)
+{
+	if (!region.visible)  return;
+
+	CPUPassContext drawContext = WithFallbackMaps(context);
+	drawContext.passConstants.area2DTopLeft = region.area2DTopLeft;
+	drawContext.passConstants.area2DSize    = region.area2DSize;
+	drawContext.passConstants.area2DDepth   = region.area2DDepth;
+
+	CPUPixelShader shader = PixelShader(postProcess);
+	float width  = static_cast<float>(target.Width());
+	float height = static_cast<float>(target.Height());
+
+	// Pixels whose centres are inside the quad, within the scissor rectangle
+	float quadLeft   = region.area2DTopLeft.x * width;
+	float quadTop    = region.area2DTopLeft.y * height;
+	float quadRight  = (region.area2DTopLeft.x + region.area2DSize.x) * width;
+	float quadBottom = (region.area2DTopLeft.y + region.area2DSize.y) * height;
+	PixelRect rect = ClipToViewport(region.pixels, target.Width(), target.Height());
+	rect.left   = std::max(rect.left,   static_cast<int>(std::ceil(quadLeft   - 0.5f)));
+	rect.top    = std::max(rect.top,    static_cast<int>(std::ceil(quadTop    - 0.5f)));
+	rect.right  = std::min(rect.right,  static_cast<int>(std::ceil(quadRight  - 0.5f)));
+	rect.bottom = std::min(rect.bottom, static_cast<int>(std::ceil(quadBottom - 0.5f)));
+	if (rect.IsEmpty())  return;
+
+	ForEachTile(rect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			const CVector4* destination = target.Row(y);
+			const CVector4* depthRow = drawContext.depthTest ? drawContext.depthTest->Row(y) : nullptr;
+
+			for (int x = tile.left; x < tile.right; ++x)
+			{
+				CVector4& result = rowBuffer[x - tile.left];
+				const CVector4& previous = destination[x];
+
+				// Depth test (less than) against the scene - an area behind an object leaves the pixel alone
+				if (depthRow && !(region.area2DDepth < depthRow[x].x))
+				{
+					result = previous;
+					continue;
+				}
+
+				CVector2 sceneUV = { (x + 0.5f) / width, (y + 0.5f) / height };
+				CVector2 areaUV  = { (sceneUV.x - region.area2DTopLeft.x) / region.area2DSize.x,
+				                     (sceneUV.y - region.area2DTopLeft.y) / region.area2DSize.y };
+				CVector4 colour = shader(drawContext, sceneUV, areaUV);
+
+				// Alpha blending (gAlphaBlendingState), the target's alpha is replaced
+				float alpha = colour.w;
+				result = CVector4(colour.x * alpha + previous.x * (1.0f - alpha),
+				                  colour.y * alpha + previous.y * (1.0f - alpha),
+				                  colour.z * alpha + previous.z * (1.0f - alpha), alpha);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), tile.right - tile.left);
+		}
+	});
+}
+
+
+void CPUPolygonPostProcess(PostProcess postProcess, const CPUPassContext& context, const PostProcessRegion& region, CPUImage& target)
+{
+	if (!region.visible)  return;
+	for (int i = 0; i < 4; ++i)
+	{
+		if (!(region.polygon2DPoints[i].w > 0.0f))  return;
+	}
+
+	CPUPassContext drawContext = WithFallbackMaps(context);
+	for (int i = 0; i < 4; ++i)  drawContext.passConstants.polygon2DPoints[i] = region.polygon2DPoints[i];
+
+	CPUPixelShader shader = PixelShader(postProcess);
+	float width  = static_cast<float>(target.Width());
+	float height = static_cast<float>(target.Height());
+
+	// What the 2DPolygon vertex shader outputs for each point: the position on the target in pixels, the values that
+	// are interpolated with perspective correction (divided by w), and the depth
+	struct PolygonVertex
+	{
+		float    x, y;
+		float    invW;
+		CVector2 areaUVOverW;
+		CVector2 sceneUVOverW;
+		float    depth;
+	};
+	const CVector2 polygonUVs[4] = { {0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 0.0f}, {1.0f, 1.0f} };
+	PolygonVertex vertices[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		const CVector4& point = region.polygon2DPoints[i];
+		CVector2 sceneUV = { (point.x / point.w + 1.0f) * 0.5f, 1.0f - (point.y / point.w + 1.0f) * 0.5f };
+
+		PolygonVertex& vertex = vertices[i];
+		vertex.x     = sceneUV.x * width;
+		vertex.y     = sceneUV.y * height;
+		vertex.invW  = 1.0f / point.w;
+		vertex.areaUVOverW  = polygonUVs[i] * vertex.invW;
+		vertex.sceneUVOverW = sceneUV * vertex.invW;
+		vertex.depth = point.z / point.w;
+	}
+
+	// The four points are drawn as a triangle strip: points 0,1,2 then 2,1,3
+	const int triangles[2][3] = { { 0, 1, 2 }, { 2, 1, 3 } };
+
+	PixelRect rect = ClipToViewport(region.pixels, target.Width(), target.Height());
+	if (rect.IsEmpty())  return;
+
+	ForEachTile(rect, context.threadPool, [&](const PixelRect& tile)
+	{
+		std::vector<CVector4> rowBuffer(tile.right - tile.left);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			const CVector4* depthRow = drawContext.depthTest ? drawContext.depthTest->Row(y) : nullptr;
+			int runStart = -1; // Start of the run of covered pixels not yet stored
+
+			for (int x = tile.left; x <= tile.right; ++x)
+			{
+				bool covered = false;
+				if (x < tile.right)
+				{
+					float px = x + 0.5f;
+					float py = y + 0.5f;
+					for (const auto& triangle : triangles)
+					{
+						const PolygonVertex& a = vertices[triangle[0]];
+						const PolygonVertex& b = vertices[triangle[1]];
+						const PolygonVertex& c = vertices[triangle[2]];
+
+						// Barycentric coordinates from edge functions. Either winding is drawn (culling is off)
+						float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+						if (area == 0.0f)  continue;
+						float la = ((c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x)) / area;
+						float lb = ((a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x)) / area;
+						float lc = 1.0f - la - lb;
+						if (la < 0.0f || lb < 0.0f || lc < 0.0f)  continue;
+
+						float depth = la * a.depth + lb * b.depth + lc * c.depth;
+						if (depthRow && !(depth < depthRow[x].x))  break;
+
+						float invW = la * a.invW + lb * b.invW + lc * c.invW;
+						CVector2 areaUV  = (la * a.areaUVOverW  + lb * b.areaUVOverW  + lc * c.areaUVOverW)  / invW;
+						CVector2 sceneUV = (la * a.sceneUVOverW + lb * b.sceneUVOverW + lc * c.sceneUVOverW) / invW;
+
+						// No blending for polygons
+						rowBuffer[x - tile.left] = shader(drawContext, sceneUV, areaUV);
+						covered = true;
+						break;
+					}
+				}
+
+				// Store each run of covered pixels when it ends
+				if (covered && runStart < 0)  runStart = x;
+				if (!covered && runStart >= 0)
+				{
+					target.Store(runStart, y, &rowBuffer[runStart - tile.left], x - runStart);
+					runStart = -1;
+				}
+			}
+		}
+	});
+}
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+void ForEachTile(const PixelRect& rect, CPUThreadPool* threadPool, const std::function<void(const PixelRect&)>& function)
+{
+	if (rect.IsEmpty())  return;
+
+	int numTiles = (rect.bottom - rect.top + CPU_TILE_ROWS - 1) / CPU_TILE_ROWS;
+	auto runTile = [&](int tile, int)
+	{
+		PixelRect tileRect = rect;
+		tileRect.top    = rect.top + tile * CPU_TILE_ROWS;
+		tileRect.bottom = std::min(tileRect.top + CPU_TILE_ROWS, rect.bottom);
+		function(tileRect);
+	};
+
+	if (threadPool)
+	{
+		threadPool->ParallelFor(numTiles, runTile);
+	}
+	else
+	{
+		for (int tile = 0; tile < numTiles; ++tile)  runTile(tile, 0);
+	}
+}
+
+
+PostProcessEffectConstants DefaultPostProcessEffectConstants(int viewportWidth, int viewportHeight, float nearClip, float farClip)
+{
+	PostProcessEffectConstants constants = {};
+
+	constants.verticalGradient.topColour    = { 0.0f, 0.0f, 1.0f };
+	constants.verticalGradient.bottomColour = { 1.0f, 1.0f, 0.0f };
+
+	constants.gaussianBlur.blurSigma = 4.0f;
+	SetGaussianBlurKernel(constants.gaussianBlur, 1);
+
+	constants.underwater.frequency = 2.0f;
+	constants.underwater.amplitude = 0.005f;
+
+	constants.depthOfField.focalDistance = 40.0f;
+	constants.depthOfField.aperture      = 5.0f;
+	constants.depthOfField.nearClip      = nearClip;
+	constants.depthOfField.farClip       = farClip;
+
+	constants.motionBlur.shutter = 0.5f;
+
+	constants.retroGame.pixelSize    = 150.0f;
+	constants.retroGame.paletteSize  = 16; // Scene.cpp picks a random size from 8 to 25
+	constants.retroGame.ditherAmount = 0.0f;
+
+	constants.brightPass.bloomThreshold = 0.6f;
+	constants.brightPass.exposure       = 1.0f;
+	constants.brightPass.bloomKnee      = 0.1f;
+
+	constants.lensStar.stepSize     = 0.007f;
+	constants.lensStar.attenuation  = 0.8f;
+	constants.lensStar.streakLength = 6;
+
+	constants.bloom.bloomIntensity = 0.4f;
+	constants.bloom.starIntensity  = 9.0f;
+
+	constants.tint.tintColour = { 1.0f, 0.0f, 0.0f };
+
+	const float grainSize = 140.0f;
+	constants.greyNoise.noiseScale  = { viewportWidth / grainSize, viewportHeight / grainSize };
+	constants.greyNoise.noiseOffset = { 0.0f, 0.0f };
+
+	constants.burn.burnHeight = 0.0f;
+
+	constants.distort.distortLevel = 0.03f;
+
+	constants.spiral.spiralLevel = 0.0f;
+
+	constants.fog.fogColour        = { 0.7f, 0.8f, 1.0f };
+	constants.fog.fogDensity       = 0.01f;
+	constants.fog.fogHeightStart   = 200.0f;
+	constants.fog.fogHeightDensity = 0.2f;
+	constants.fog.nearClip         = nearClip;
+	constants.fog.farClip          = farClip;
+
+	constants.gameBoy.gameBoyColour      = { 1.0f, 0.5f, 0.5f };
+	constants.gameBoy.gameBoyPixelSize   = 100.0f;
+	constants.gameBoy.gameBoyColourDepth = 5.0f;
+	constants.gameBoy.ditherAmount       = 0.0f;
+
+	constants.nightVision.nightVisionTint    = { 0.2f, 1.5f, 0.4f };
+	constants.nightVision.noiseIntensity     = 0.5f;
+	constants.nightVision.vignetteIntensity  = 0.6f;
+	constants.nightVision.flickerIntensity   = 0.01f;
+	constants.nightVision.brightnessBoost    = { 0.1f, 0.1f, 0.1f };
+	constants.nightVision.luminanceThreshold = 0.9f;
+	constants.nightVision.intensity          = 0.6f;
+
+	constants.chromaticDistortion.chromAbAmount    = 0.1f;
+	constants.chromaticDistortion.distortionAmount = 3.0f;
+	constants.chromaticDistortion.screenCenter     = { 0.5f, 0.5f };
+
+	constants.wireframe.edgeThreshold = 0.3f;
+	constants.wireframe.edgePower     = 1.8f;
+
+	// The original filters - a 7x7 dilation and a 3x3 blur with its taps two pixels apart
+	constants.dilation.kernelRadius  = 3;
+	constants.onePassBlur.blurRadius = 1;
+	constants.onePassBlur.tapSpacing = 2;
+
+	// A still camera, the history lines up with the new image
+	constants.temporal.reprojection       = MatrixIdentity();
+	constants.temporal.nearClip           = nearClip;
+	constants.temporal.farClip            = farClip;
+	constants.temporal.depthTolerance     = TEMPORAL_DEPTH_TOLERANCE;
+	constants.temporal.neighbourhoodClamp = 1;
+
+	return constants;
+}
+
+
+void MakeNoiseMap(CPUImage& image, int size, uint32_t seed)
+{
+	const int cellSize = 16; // Pixels between random values, which are smoothly blended between
+	int numCells = std::max(size / cellSize, 1);
+	size = numCells * cellSize;
+
+	auto hash = [](uint32_t x)
+	{
+		x ^= x >> 16;  x *= 0x7feb352d;
+		x ^= x >> 15;  x *= 0x846ca68b;
+		x ^= x >> 16;
+		return x;
+	};
+	auto randomValue = [&](int cellX, int cellY, int channel)
+	{
+		uint32_t key = static_cast<uint32_t>(((cellY % numCells) * numCells + (cellX % numCells)) * 4 + channel);
+		return static_cast<float>(hash(key ^ hash(seed)) >> 8) / 16777216.0f;
+	};
+
+	image.Resize(size, size, TargetFormat::RGBA8);
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			int cellX = x / cellSize;
+			int cellY = y / cellSize;
+			float tx = static_cast<float>(x % cellSize) / cellSize;
+			float ty = static_cast<float>(y % cellSize) / cellSize;
+			tx = tx * tx * (3.0f - 2.0f * tx);
+			ty = ty * ty * (3.0f - 2.0f * ty);
+
+			float values[4];
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				float top    = randomValue(cellX, cellY,     channel) * (1 - tx) + randomValue(cellX + 1, cellY,     channel) * tx;
+				float bottom = randomValue(cellX, cellY + 1, channel) * (1 - tx) + randomValue(cellX + 1, cellY + 1, channel) * tx;
+				values[channel] = top * (1 - ty) + bottom * ty;
+			}
+			image.Pixel(x, y) = CVector4(values);
+		}
+	}
+}
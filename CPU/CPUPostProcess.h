@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------------
+// Post-processes on the CPU
+//--------------------------------------------------------------------------------------
+// A C++ version of every post-process shader (the *_pp.hlsl files), taking the same settings
+// (PostProcessConstants.h) and giving the same results. Use it as a reference to check the
+// shaders against, or to post-process without a GPU - CPUPostProcessDevice.h runs a whole chain.
+//
+// Each effect is a function working out the colour of one pixel from its UVs, called for every
+// pixel a draw covers just as the pixel shader is. The draw functions below do the job of the
+// 2DQuad / 2DPolygon vertex shaders, the rasteriser and the blend state. The simplest full screen
+// colour effects and the Gaussian blurs also have a version that works on whole rows with SSE/AVX2
+// (see CPUSimd.h), as do colour transform passes, which run several of the colour effects at once,
+// and colour LUTs.
+// Work is split into tiles of rows that are shared between the threads of a CPUThreadPool.
+//
+// Textures are sampled as Scene.cpp samples them: slot t0 and all depth reads with point
+// sampling (other than the taps of the blurs and resamples), other images bilinearly, and the
+// noise, burn and distortion maps wrapped
+
+#ifndef _CPU_POST_PROCESS_H_INCLUDED_
+#define _CPU_POST_PROCESS_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUThreadPool.h"
+#include "CPUColourLUT.h"
+#include "ColourTransform.h"
+#include "PostProcess.h"
+#include "PostProcessConstants.h"
+#include "PostProcessRegion.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+
+//--------------------------------------------------------------------------------------
+// Draw settings
+//--------------------------------------------------------------------------------------
+
+// The fixed textures some effects read in slot t1, loaded by the caller from the files in Media
+// Maps left as nullptr are replaced by a generated noise map (see MakeNoiseMap)
+struct CPUPostProcessMaps
+{
+	const CPUImage* noiseMap   = nullptr; // GreyNoise
+	const CPUImage* burnMap    = nullptr; // Burn
+	const CPUImage* distortMap = nullptr; // Distort
+};
+
+// Everything a post-process reads - the CPU equivalent of the textures and constant buffers bound for a draw
+struct CPUPassContext
+{
+	// Images in texture slots t0, t1 and t2, as chosen by the render graph. A nullptr reads as black, like an unbound texture
+	std::array<const CPUImage*, MAX_PASS_INPUTS> inputs = { { nullptr, nullptr, nullptr } };
+
+	// Scene depth that area and polygon effects are tested against (so they can be hidden behind objects), nullptr for no test
+	const CPUImage* depthTest = nullptr;
+
+	CPUPostProcessMaps maps;
+
+	// Pass constants as sent to the shaders. The draw functions fill in the area/polygon part themselves
+	PostProcessPassConstants          passConstants = {};
+	const PostProcessEffectConstants* effectConstants = nullptr;
+
+	int viewportWidth  = 0; // As gViewportWidth / gViewportHeight in the shaders
+	int viewportHeight = 0;
+
+	// Threads to share the tiles of each draw between, nullptr to do all the work on the calling thread
+	CPUThreadPool* threadPool = nullptr;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Drawing
+//--------------------------------------------------------------------------------------
+// The target must not be one of the inputs (the render graph never does that)
+
+// Run the post-process over the whole target, as FullScreenPostProcess in Scene.cpp
+void CPUFullScreenPostProcess(PostProcess postProcess, const CPUPassContext& context, CPUImage& target);
+
+// Run the post-process over just the given rectangle of the target, all on the calling thread. The target can be a
+// window (see CPUImage::ResizeWindow) as long as it holds the rectangle. Used to run a chain one tile at a time
+void CPUFullScreenPostProcessRect(PostProcess postProcess, const CPUPassContext& context, const PixelRect& rect, CPUImage& target);
+
+// Run a colour transform pass (see ColourTransform.h) over the whole target, as the ColourTransform_pp shader. The result
+// of each stage but the last is rounded to the given format, that of the targets between the effects the pass stands in
+// for. Input 0 must be the same size as the target
+void CPUColourTransform(const ColourTransformConstants& constants, TargetFormat stageFormat, const CPUPassContext& context, CPUImage& target);
+
+// As above but over just the given rectangle of the target, all on the calling thread (see CPUFullScreenPostProcessRect)
+void CPUColourTransformRect(const ColourTransformConstants& constants, TargetFormat stageFormat, const CPUPassContext& context,
+                            const PixelRect& rect, CPUImage& target);
+
+// Run an effect baked into a colour LUT (see CPUColourLUT.h) over the whole target, in place of the effect itself. Input 0
+// must be the same size as the target
+void CPUColourLUTPostProcess(const ColourLUT& lut, const CPUPassContext& context, CPUImage& target);
+
+// As above but over just the given rectangle of the target, all on the calling thread (see CPUFullScreenPostProcessRect)
+void CPUColourLUTPostProcessRect(const ColourLUT& lut, const CPUPassContext& context, const PixelRect& rect, CPUImage& target);
+
+// Copy input 0 over the whole target with bilinear filtering, as Resample_pp.hlsl. For render graph resample passes, where
+// the target is a different size to the input (see GaussianKernel.h)
+void CPUResample(const CPUPassContext& context, CPUImage& target);
+
+// Write input 0 plus the change an effect made at a smaller size - input 1 (its output) minus input 2 (the image it read) -
+// scaled up to the target with the joint bilateral filter of ReducedResolutionUpsample_pp.hlsl. Input 0 must be the same
+// size as the target, inputs 1 and 2 the same size as each other (see RenderPassType::ReducedResolutionUpsample)
+void CPUReducedResolutionUpsample(const CPUPassContext& context, CPUImage& target);
+
+// Run the post-process over an area, alpha blending over the target, as AreaPostProcess in Scene.cpp
+void CPUAreaPostProcess(PostProcess postProcess, const CPUPassContext& context, const PostProcessRegion& region, CPUImage& target);
+
+// Run the post-process over a four-point polygon, as PolygonPostProcess in Scene.cpp. Polygons with any point
+// behind the camera are not drawn - the GPU clips them against the near plane, which isn't reproduced here
+void CPUPolygonPostProcess(PostProcess postProcess, const CPUPassContext& context, const PostProcessRegion& region, CPUImage& target);
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Number of rows in each tile of work
+const int CPU_TILE_ROWS = 32;
+
+// Split the rectangle into tiles of rows and call the function for each, sharing them between the threads of the pool
+// (or all on the calling thread if there is no pool). Returns when all tiles are done
+void ForEachTile(const PixelRect& rect, CPUThreadPool* threadPool, const std::function<void(const PixelRect&)>& function);
+
+// A copy of the context with the generated noise map (see MakeNoiseMap) in place of any fixed texture that hasn't been given
+CPUPassContext WithFallbackMaps(const CPUPassContext& context);
+
+// The settings Scene.cpp uses for each effect (see SelectPostProcessShaderAndTextures). Animated settings (burn
+// height, spiral level, noise offset) start where Scene.cpp starts them, the caller moves them on each frame
+PostProcessEffectConstants DefaultPostProcessEffectConstants(int viewportWidth, int viewportHeight, float nearClip, float farClip);
+
+// Fill the image with smooth random values in each channel that tile when wrapped, similar to the noise maps in Media
+void MakeNoiseMap(CPUImage& image, int size, uint32_t seed);
+
+
+#endif //_CPU_POST_PROCESS_H_INCLUDED_
@@ -0,0 +1,1085 @@
+//--------------------------------------------------------------------------------------
+// Running the post-processing chain on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUPostProcessDevice.h"
+#include "CPUBloom.h"
+#include "CPUComputeTile.h"
+#include "CPUDepthOfField.h"
+#include "CPULensStar.h"
+#include "CPUMotionBlur.h"
+#include "CPUSlidingFilter.h"
+#include "CPUTemporal.h"
+#include "CPUUVRemap.h"
+#include "Bloom.h"
+#include "DepthOfField.h"
+#include "MotionBlur.h"
+#include "GaussianKernel.h"
+#include "SlidingFilter.h"
+#include "UVRemap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+
+//--------------------------------------------------------------------------------------
+// Construction / Usage
+//--------------------------------------------------------------------------------------
+
+CPUPostProcessDevice::CPUPostProcessDevice(int numThreads /*= 0*/)
+	: mThreadPool(numThreads)
+{
+	mTileImages.resize(static_cast<size_t>(mThreadPool.NumThreads()) * 2);
+}
+
+
+PostProcessStats CPUPostProcessDevice::Run(const PostProcessChain& chain, const CPUPostProcessFrame& frame, CPUImage& output)
+{
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty())  return PostProcessStats();
+
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+
+	int blurLevels = GaussianBlurLevels(frame.effectConstants.gaussianBlur.blurSigma);
+	int lensStarPasses = LensStarPasses(frame.effectConstants.lensStar.streakLength);
+	bool slidingBoxBlur = BoxBlurIsSliding(frame.effectConstants.onePassBlur);
+	if (!mGraph.IsCompiledFrom(chain, blurLevels, mUseComputeTiles, mReducedResolution, mTemporalAccumulation, lensStarPasses,
+	                           slidingBoxBlur))
+	{
+		mGraph.Compile(chain, blurLevels, mUseComputeTiles, mReducedResolution, mTemporalAccumulation, lensStarPasses, slidingBoxBlur);
+		mHistoryValid = false;
+		mChain = chain;
+		mFusedGroups = FindFusedGroups(mGraph);
+		ExtendFusedLifetimes(mGraph, mFusedGroups);
+		mColourTransforms.clear();
+	}
+
+	// Plan the targets as Scene.cpp does, then make an image for each slot the allocator has handed out
+	mAllocator.BeginFrame();
+	mGraph.AllocateTargets(mAllocator, width, height);
+	mAllocator.EndFrame();
+
+	const std::vector<PooledTargetSlot>& slots = mAllocator.Slots();
+	mTargets.resize(slots.size());
+	for (size_t slot = 0; slot < slots.size(); ++slot)
+	{
+		const RenderTargetDesc& desc = slots[slot].desc;
+		CPUImage& image = mTargets[slot];
+		if (!slots[slot].alive)
+		{
+			image = CPUImage();
+		}
+		else if (image.Width() != desc.width || image.Height() != desc.height || image.Format() != desc.format)
+		{
+			image.Resize(desc.width, desc.height, desc.format);
+		}
+	}
+
+	// Images that last between frames or come from outside the graph
+	if (mHistory.Width() != width || mHistory.Height() != height)
+	{
+		mHistory.Resize(width, height, TargetFormat::RGBA16F);
+		mHistoryValid = false;
+	}
+	if (frame.sceneDepth == nullptr && (mClearedDepth.Width() != width || mClearedDepth.Height() != height))
+	{
+		mClearedDepth.Resize(width, height, TargetFormat::R32F);
+		mClearedDepth.Fill(CVector4(1, 0, 0, 1));
+	}
+	if (frame.sceneVelocity == nullptr && (mStillVelocity.Width() != width || mStillVelocity.Height() != height))
+	{
+		mStillVelocity.Resize(width, height, TargetFormat::RGBA16F);
+		mStillVelocity.Fill(CVector4(0, 0, 0, 1));
+	}
+	output.Resize(width, height, TargetFormat::RGBA8);
+
+	mFrame  = &frame;
+	mOutput = &output;
+
+	// The scene is rendered into its target before post-processing starts
+	CPUImage& sceneTarget = *Image(SCENE_COLOUR_RESOURCE);
+	for (int y = 0; y < height; ++y)
+	{
+		sceneTarget.Store(0, y, frame.sceneColour->Row(y), width);
+	}
+
+	// Settings shared by all passes
+	mContext = CPUPassContext();
+	mContext.passConstants.timer     = frame.timer;
+	mContext.passConstants.texelSize = { 2.0f / static_cast<float>(width), 2.0f / static_cast<float>(height) }; // As in Scene.cpp
+	mEffectConstants = frame.effectConstants;
+	mContext.effectConstants = &mEffectConstants;
+	mContext.maps            = frame.maps;
+	mContext.viewportWidth   = width;
+	mContext.viewportHeight  = height;
+	mContext.threadPool      = &mThreadPool;
+	UpdateColourTransforms();
+	UpdateColourLUTs();
+
+	// Run the passes, fused groups together
+	PostProcessStats stats;
+	const std::vector<RenderPass>& passes = mGraph.Passes();
+	size_t nextGroup = 0;
+	for (int passIndex = 0; passIndex < static_cast<int>(passes.size()); )
+	{
+		if (mTileFusion && nextGroup < mFusedGroups.size() && mFusedGroups[nextGroup].firstPass == passIndex)
+		{
+			RunFusedGroup(mFusedGroups[nextGroup], stats);
+			passIndex += mFusedGroups[nextGroup].numPasses;
+			++nextGroup;
+			continue;
+		}
+		ExecuteRenderPass(passes[passIndex], *this, stats);
+		++passIndex;
+	}
+	mHistoryValid = true;
+
+	mFrame  = nullptr;
+	mOutput = nullptr;
+	mTarget = nullptr;
+	return stats;
+}
+
+
+//--------------------------------------------------------------------------------------
+// PostProcessDevice
+//--------------------------------------------------------------------------------------
+
+void CPUPostProcessDevice::SetPassResources(const RenderPass& pass)
+{
+	for (int slot = 0; slot < MAX_PASS_INPUTS; ++slot)
+	{
+		mContext.inputs[slot] = InputImage(pass.inputs[slot]);
+	}
+	mContext.depthTest = InputImage(SCENE_DEPTH_RESOURCE); // The scene depth is always bound for testing, see PreparePostProcessPipeline
+	mTarget = Image(pass.output);
+
+	// The blur kernel depends on the size of the image being blurred
+	if (pass.effect == PostProcess::GaussianBlurHorizontal || pass.effect == PostProcess::GaussianBlurVertical)
+	{
+		SetGaussianBlurKernel(mEffectConstants.gaussianBlur, mGraph.Resource(pass.output).sizeDivisor);
+	}
+}
+
+
+void CPUPostProcessDevice::DrawFullScreen(PostProcess postProcess)
+{
+	const ColourLUT* lut = PassColourLUT(postProcess, mContext.inputs[0], *mTarget);
+	if (lut)
+	{
+		CPUColourLUTPostProcess(*lut, mContext, *mTarget);
+	}
+	else
+	{
+		CPUFullScreenPostProcess(postProcess, mContext, *mTarget);
+	}
+}
+
+
+void CPUPostProcessDevice::DrawRegion(const RenderPass& pass)
+{
+	PostProcessRegion region = PassRegion(pass);
+	if (pass.mode == PostProcessMode::Area)
+	{
+		CPUAreaPostProcess(pass.effect, mContext, region, *mTarget);
+	}
+	else
+	{
+		CPUPolygonPostProcess(pass.effect, mContext, region, *mTarget);
+	}
+}
+
+
+void CPUPostProcessDevice::CopyResource(int destination, int source)
+{
+	const CPUImage& sourceImage = *InputImage(source);
+	CopyImageRect(sourceImage, *Image(destination), { 0, 0, sourceImage.Width(), sourceImage.Height() });
+}
+
+
+int CPUPostProcessDevice::CopyRegion(int destination, int source, const RenderPass& pass)
+{
+	// The pixels the effect will read: the region it covers plus the halo around it that it samples
+	PostProcessRegion region = PassRegion(pass);
+	if (!region.visible)  return 0;
+	PixelRect rect = ExpandByFootprint(region.pixels, GetPostProcessDeclaration(pass.effect), mContext.viewportWidth, mContext.viewportHeight);
+	if (rect.IsEmpty())  return 0;
+
+	CopyImageRect(*InputImage(source), *Image(destination), rect);
+	return rect.Area();
+}
+
+
+PostProcessStats CPUPostProcessDevice::DrawPolygonBatch(const RenderPass& pass)
+{
+	// The polygons are run one after another, each reading a fresh copy of its pixels. This is what the batch's single draw
+	// is equivalent to, so it is the reference the batch is checked against
+	PostProcessStats stats;
+	for (int chainIndex = pass.chainIndex; chainIndex < pass.chainIndex + pass.batchSize; ++chainIndex)
+	{
+		RenderPass polygonPass = pass;
+		polygonPass.type       = RenderPassType::PostProcess;
+		polygonPass.effect     = mChain[chainIndex].first;
+		polygonPass.chainIndex = chainIndex;
+		polygonPass.batchSize  = 1;
+
+		stats.regionPixels += CopyRegion(pass.inputs[0], pass.output, polygonPass);
+		++stats.copies;
+
+		SetPassResources(polygonPass);
+		DrawRegion(polygonPass);
+		++stats.draws;
+	}
+	return stats;
+}
+
+
+void CPUPostProcessDevice::DrawColourTransform(const RenderPass& pass)
+{
+	// The targets between the effects would have been the same format as the one the pass writes
+	CPUColourTransform(mColourTransforms[pass.chainIndex], mGraph.Resource(pass.output).format, mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::DrawUVRemap(const RenderPass& pass)
+{
+	UVRemapConstants constants = BuildUVRemap(mChain, pass.chainIndex, pass.batchSize, mEffectConstants);
+	CPUUVRemap(constants, mGraph.Resource(pass.output).format, mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::DrawResample(const RenderPass&)
+{
+	CPUResample(mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::RunSlidingFilter(const RenderPass& pass)
+{
+	bool columns = pass.type == RenderPassType::SlidingFilterColumns;
+	CPUSlidingFilter(MakeSlidingFilterConstants(pass.effect, columns, mEffectConstants), mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::RunComputeTile(const RenderPass& pass)
+{
+	CPUComputeTile(pass.effect, mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::DrawBloomMip(const RenderPass& pass)
+{
+	if (pass.type == RenderPassType::BloomDownsample)
+	{
+		// The first level reads the full size image
+		bool firstLevel = mGraph.Resource(pass.output).sizeDivisor == 2;
+		CPUBloomDownsample(MakeBloomDownsampleConstants(mEffectConstants, firstLevel), mContext, *mTarget);
+	}
+	else
+	{
+		CPUBloomUpsample(mContext, *mTarget);
+	}
+}
+
+
+void CPUPostProcessDevice::DrawLensStarStreak(const RenderPass& pass)
+{
+	CPULensStarStreak(MakeLensStarStreakConstants(mEffectConstants.lensStar, pass.streak, pass.streakPass, pass.streakBackward),
+	                  mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::DrawDepthOfFieldStage(const RenderPass& pass)
+{
+	if (pass.type == RenderPassType::DepthOfFieldCoC)
+	{
+		CPUDepthOfFieldCoC(mEffectConstants.depthOfField, mContext, *mTarget);
+	}
+	else if (pass.type == RenderPassType::DepthOfFieldTiles)
+	{
+		CPUDepthOfFieldTiles(mContext, *mTarget);
+	}
+	else
+	{
+		bool nearField = pass.type == RenderPassType::DepthOfFieldNear;
+		CPUDepthOfFieldGather(MakeDepthOfFieldGatherConstants(nearField, pass.temporalFrames, mEffectConstants.temporal.frameIndex),
+		                      mContext, *mTarget);
+	}
+}
+
+
+void CPUPostProcessDevice::DrawMotionBlurTiles(const RenderPass&)
+{
+	CPUMotionBlurTiles(mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::DrawReducedResolutionUpsample(const RenderPass&)
+{
+	CPUReducedResolutionUpsample(mContext, *mTarget);
+}
+
+
+void CPUPostProcessDevice::DrawTemporalResolve(const RenderPass& pass)
+{
+	CPUTemporalResolve(MakeTemporalResolveConstants(mEffectConstants.temporal, pass.temporalFrames, mHistoryValid),
+	                   mContext, *mTarget);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Private members
+//--------------------------------------------------------------------------------------
+
+void CPUPostProcessDevice::UpdateColourTransforms()
+{
+	for (const RenderPass& pass : mGraph.Passes())
+	{
+		if (pass.type != RenderPassType::ColourTransform)  continue;
+		mColourTransforms[pass.chainIndex] = BuildColourTransform(mChain, pass.chainIndex, pass.batchSize, mFrame->effectConstants);
+	}
+}
+
+
+void CPUPostProcessDevice::UpdateColourLUTs()
+{
+	if (!mUseColourLUTs)  return;
+	for (const RenderPass& pass : mGraph.Passes())
+	{
+		if (pass.type != RenderPassType::PostProcess || pass.mode != PostProcessMode::Fullscreen)  continue;
+		if (!GetPostProcessDeclaration(pass.effect).colourLUT)  continue;
+		mColourLUTs[pass.effect].Update(pass.effect, mFrame->effectConstants);
+	}
+}
+
+
+const ColourLUT* CPUPostProcessDevice::FindColourLUT(PostProcess postProcess) const
+{
+	auto lut = mColourLUTs.find(postProcess);
+	return lut != mColourLUTs.end() ? &lut->second : nullptr;
+}
+
+
+const ColourLUT* CPUPostProcessDevice::PassColourLUT(PostProcess postProcess, const CPUImage* input, const CPUImage& target) const
+{
+	if (!mUseColourLUTs || !input || input->Width() != target.Width() || input->Height() != target.Height())  return nullptr;
+	return FindColourLUT(postProcess); // Only effects with colourLUT are baked
+}
+
+
+void CPUPostProcessDevice::RunFusedGroup(const CPUFusedGroup& group, PostProcessStats& stats)
+{
+	int width    = mContext.viewportWidth;
+	int height   = mContext.viewportHeight;
+	int tileSize = FusedTileSize(mGraph, group, width, height);
+
+	// Fused passes are all at the viewport size
+	SetGaussianBlurKernel(mEffectConstants.gaussianBlur, 1);
+
+	int tilesAcross = (width  + tileSize - 1) / tileSize;
+	int tilesDown   = (height + tileSize - 1) / tileSize;
+	mThreadPool.ParallelFor(tilesAcross * tilesDown, [&](int task, int thread)
+	{
+		PixelRect tile;
+		tile.left   = (task % tilesAcross) * tileSize;
+		tile.top    = (task / tilesAcross) * tileSize;
+		tile.right  = std::min(tile.left + tileSize, width);
+		tile.bottom = std::min(tile.top  + tileSize, height);
+		RunFusedTile(group, tile, thread);
+	});
+
+	const RenderPass& lastPass = mGraph.Passes()[group.firstPass + group.numPasses - 1];
+	stats.passes += group.numPasses;
+	stats.draws  += group.numPasses;
+	if (lastPass.output == BACK_BUFFER_RESOURCE)  ++stats.backBufferDraws;
+}
+
+
+void CPUPostProcessDevice::RunFusedTile(const CPUFusedGroup& group, const PixelRect& tile, int thread)
+{
+	std::vector<PixelRect> rects;
+	FusedPassRects(mGraph, group, tile, mContext.viewportWidth, mContext.viewportHeight, rects);
+
+	CPUPassContext context = mContext;
+	context.threadPool = nullptr; // Already on one of the pool's threads
+
+	const CPUImage* previousOutput = nullptr;
+	for (int i = 0; i < group.numPasses; ++i)
+	{
+		const RenderPass& pass = mGraph.Passes()[group.firstPass + i];
+
+		// The image from the previous pass only exists as this tile's window, everything else is read as normal
+		for (int slot = 0; slot < MAX_PASS_INPUTS; ++slot)
+		{
+			bool fromPrevious = i > 0 && pass.inputs[slot] == mGraph.Passes()[group.firstPass + i - 1].output;
+			context.inputs[slot] = fromPrevious ? previousOutput : InputImage(pass.inputs[slot]);
+		}
+
+		// The last pass writes its real target, the others a window in one of this thread's tile images. Windows have the
+		// format of the image they stand in for, so values are rounded between passes just as without fusion
+		CPUImage* target;
+		if (i == group.numPasses - 1)
+		{
+			target = Image(pass.output);
+		}
+		else
+		{
+			target = &mTileImages[thread * 2 + i % 2];
+			target->ResizeWindow(rects[i], mContext.viewportWidth, mContext.viewportHeight, mGraph.Resource(pass.output).format);
+		}
+
+		if (pass.type == RenderPassType::ColourTransform)
+		{
+			const ColourTransformConstants& constants = mColourTransforms.find(pass.chainIndex)->second;
+			CPUColourTransformRect(constants, mGraph.Resource(pass.output).format, context, rects[i], *target);
+		}
+		else if (const ColourLUT* lut = PassColourLUT(pass.effect, context.inputs[0], *target))
+		{
+			CPUColourLUTPostProcessRect(*lut, context, rects[i], *target);
+		}
+		else
+		{
+			CPUFullScreenPostProcessRect(pass.effect, context, rects[i], *target);
+		}
+		previousOutput = target;
+	}
+}
+
+
+CPUImage* CPUPostProcessDevice::Image(int resource)
+{
+	if (resource < 0)  return nullptr;
+
+	const GraphResource& graphResource = mGraph.Resource(resource);
+	if (graphResource.type == GraphResourceType::History)        return &mHistory;
+	if (graphResource.type == GraphResourceType::BackBuffer)     return mOutput;
+	if (graphResource.type == GraphResourceType::SceneDepth)     return nullptr; // Depth and velocity are only written by the scene rendering
+	if (graphResource.type == GraphResourceType::SceneVelocity)  return nullptr;
+	return &mTargets[graphResource.physical];
+}
+
+const CPUImage* CPUPostProcessDevice::InputImage(int resource)
+{
+	if (resource == SCENE_DEPTH_RESOURCE)     return mFrame->sceneDepth    ? mFrame->sceneDepth    : &mClearedDepth;
+	if (resource == SCENE_VELOCITY_RESOURCE)  return mFrame->sceneVelocity ? mFrame->sceneVelocity : &mStillVelocity;
+	return Image(resource);
+}
+
+
+PostProcessRegion CPUPostProcessDevice::PassRegion(const RenderPass& pass) const
+{
+	if (mFrame->passRegion)  return mFrame->passRegion(pass);
+
+	// The whole screen, as an area and as a polygon in front of the camera
+	PostProcessRegion region;
+	region.visible       = true;
+	region.area2DTopLeft = { 0, 0 };
+	region.area2DSize    = { 1, 1 };
+	region.area2DDepth   = 0;
+	region.polygon2DPoints[0] = { -1.0f,  1.0f, 0.0f, 1.0f };
+	region.polygon2DPoints[1] = { -1.0f, -1.0f, 0.0f, 1.0f };
+	region.polygon2DPoints[2] = {  1.0f,  1.0f, 0.0f, 1.0f };
+	region.polygon2DPoints[3] = {  1.0f, -1.0f, 0.0f, 1.0f };
+	region.pixels = { 0, 0, mContext.viewportWidth, mContext.viewportHeight };
+	return region;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Thread scaling
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUThreadScaling> MeasureThreadScaling(const PostProcessChain& chain, const CPUPostProcessFrame& frame,
+                                                   int maxThreads, int numRuns, bool tileFusion /*= true*/)
+{
+	if (maxThreads <= 0)  maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	std::vector<int> threadCounts;
+	for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)  threadCounts.push_back(numThreads);
+	threadCounts.push_back(maxThreads);
+
+	std::vector<CPUThreadScaling> results;
+	CPUImage output;
+	for (int numThreads : threadCounts)
+	{
+		CPUPostProcessDevice device(numThreads);
+		device.SetTileFusion(tileFusion);
+		device.Run(chain, frame, output); // Compile the graph and allocate the images before timing
+
+		CPUThreadScaling result;
+		result.numThreads = numThreads;
+		for (int run = 0; run < std::max(numRuns, 1); ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			device.Run(chain, frame, output);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (run == 0 || milliseconds < result.milliseconds)  result.milliseconds = milliseconds;
+		}
+		result.speedUp = results.empty() ? 1.0 : results[0].milliseconds / result.milliseconds;
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Colour LUT timing
+//--------------------------------------------------------------------------------------
+
+// Time the work the given number of times (at least once) and return the fastest, in milliseconds
+static double FastestRun(int numRuns, const std::function<void()>& work)
+{
+	double best = 0;
+	for (int run = 0; run < std::max(numRuns, 1); ++run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		work();
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (run == 0 || milliseconds < best)  best = milliseconds;
+	}
+	return best;
+}
+
+// Largest difference between two images of the same size in any colour channel of any pixel, in 8-bit steps
+static int MaxColourDifference(const CPUImage& a, const CPUImage& b)
+{
+	float maxDifference = 0;
+	for (int y = 0; y < a.Height(); ++y)
+	{
+		const CVector4* rowA = a.Row(y);
+		const CVector4* rowB = b.Row(y);
+		for (int x = 0; x < a.Width(); ++x)
+		{
+			maxDifference = std::max({ maxDifference, std::abs(rowA[x].x - rowB[x].x),
+			                           std::abs(rowA[x].y - rowB[x].y), std::abs(rowA[x].z - rowB[x].z) });
+		}
+	}
+	return static_cast<int>(maxDifference * 255.0f + 0.5f);
+}
+
+// Peak signal to noise ratio between two images of the same size over their colour channels, in decibels, taking the
+// images as 8-bit. Identical images give infinity
+static double PeakSignalToNoise(const CPUImage& a, const CPUImage& b)
+{
+	double totalSquared = 0;
+	for (int y = 0; y < a.Height(); ++y)
+	{
+		const CVector4* rowA = a.Row(y);
+		const CVector4* rowB = b.Row(y);
+		for (int x = 0; x < a.Width(); ++x)
+		{
+			CVector3 difference = { rowA[x].x - rowB[x].x, rowA[x].y - rowB[x].y, rowA[x].z - rowB[x].z };
+			totalSquared += Dot(difference, difference);
+		}
+	}
+	double meanSquared = totalSquared / (3.0 * a.Width() * a.Height());
+	return 10.0 * std::log10(1.0 / meanSquared);
+}
+
+
+std::vector<CPUColourLUTTiming> MeasureColourLUTs(const std::vector<PostProcess>& effects, const CPUPostProcessFrame& frame,
+                                                  int numThreads, int numRuns)
+{
+	auto fastest = [numRuns](const std::function<void()>& work)  { return FastestRun(numRuns, work); };
+
+	std::vector<CPUColourLUTTiming> results;
+	for (PostProcess effect : effects)
+	{
+		CPUColourLUTTiming result;
+		result.effect = effect;
+		result.bakeMilliseconds = fastest([&]() { ColourLUT().Update(effect, frame.effectConstants); });
+
+		// The first run of each device compiles the graph, allocates the images and bakes the LUT, so isn't timed
+		PostProcessChain chain = { { effect, PostProcessMode::Fullscreen } };
+		CPUImage effectOutput, lutOutput;
+		CPUPostProcessDevice effectDevice(numThreads);
+		CPUPostProcessDevice lutDevice(numThreads);
+		lutDevice.SetColourLUTs(true);
+		effectDevice.Run(chain, frame, effectOutput);
+		lutDevice.Run(chain, frame, lutOutput);
+		result.effectMilliseconds = fastest([&]() { effectDevice.Run(chain, frame, effectOutput); });
+		result.lutMilliseconds    = fastest([&]() { lutDevice.Run(chain, frame, lutOutput); });
+
+		result.maxDifference = MaxColourDifference(effectOutput, lutOutput);
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Gaussian blur timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUGaussianBlurTiming> MeasureGaussianBlur(const std::vector<float>& sigmas, const CPUPostProcessFrame& frame,
+                                                       int numThreads, int numRuns)
+{
+	PostProcessChain chain = { { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen },
+	                           { PostProcess::GaussianBlurVertical,   PostProcessMode::Fullscreen } };
+
+	std::vector<CPUGaussianBlurTiming> results;
+	CPUImage output;
+	for (float sigma : sigmas)
+	{
+		CPUPostProcessFrame blurFrame = frame;
+		blurFrame.effectConstants.gaussianBlur.blurSigma = sigma;
+
+		CPUGaussianBlurTiming result;
+		result.sigma  = sigma;
+		result.levels = GaussianBlurLevels(sigma);
+		GaussianBlurConstants kernel = blurFrame.effectConstants.gaussianBlur;
+		SetGaussianBlurKernel(kernel, 1 << result.levels);
+		result.numTaps = kernel.numTaps;
+
+		CPUPostProcessDevice device(numThreads);
+		device.Run(chain, blurFrame, output); // Compile the graph and allocate the images before timing
+		for (int run = 0; run < std::max(numRuns, 1); ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			device.Run(chain, blurFrame, output);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (run == 0 || milliseconds < result.milliseconds)  result.milliseconds = milliseconds;
+		}
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sliding window filter timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUSlidingFilterTiming> MeasureSlidingFilters(const std::vector<PostProcess>& effects, const std::vector<int>& radii,
+                                                          const CPUPostProcessFrame& frame, int numThreads, int numRuns)
+{
+	std::vector<CPUSlidingFilterTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty())  return results;
+
+	// The passes are run directly rather than through a device, so only the effect itself is timed, not the copy to the output
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+	CPUThreadPool threadPool(numThreads);
+	CPUImage rowsImage(width, height, TargetFormat::RGBA16F); // As the render graph's image between the passes
+	CPUImage pixelShaderOutput(width, height);
+	CPUImage slidingOutput(width, height);
+
+	for (PostProcess effect : effects)
+	{
+		for (int radius : radii)
+		{
+			PostProcessEffectConstants settings = frame.effectConstants;
+			settings.dilation.kernelRadius  = radius;
+			settings.onePassBlur.blurRadius = radius;
+			settings.onePassBlur.tapSpacing = 1; // A true box, as the sliding passes make
+
+			CPUPassContext context;
+			context.inputs[0]       = frame.sceneColour;
+			context.effectConstants = &settings;
+			context.viewportWidth   = width;
+			context.viewportHeight  = height;
+			context.threadPool      = &threadPool;
+			CPUPassContext columnsContext = context;
+			columnsContext.inputs[0] = &rowsImage;
+
+			CPUSlidingFilterTiming result;
+			result.effect = effect;
+			result.radius = radius;
+			result.pixelShaderMilliseconds = FastestRun(numRuns, [&]() { CPUFullScreenPostProcess(effect, context, pixelShaderOutput); });
+			result.slidingMilliseconds     = FastestRun(numRuns, [&]()
+			{
+				CPUSlidingFilter(MakeSlidingFilterConstants(effect, false, settings), context, rowsImage);
+				CPUSlidingFilter(MakeSlidingFilterConstants(effect, true, settings), columnsContext, slidingOutput);
+			});
+			result.maxDifference = MaxColourDifference(pixelShaderOutput, slidingOutput);
+			results.push_back(result);
+		}
+	}
+	return results;
+}
+
+
+std::vector<CPUComputeTileTiming> MeasureComputeTiles(const std::vector<PostProcess>& effects, const CPUPostProcessFrame& frame,
+                                                      int numThreads, int numRuns)
+{
+	std::vector<CPUComputeTileTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty())  return results;
+
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+	CPUThreadPool threadPool(numThreads);
+	CPUImage pixelShaderOutput(width, height);
+	CPUImage computeTileOutput(width, height);
+
+	PostProcessEffectConstants settings = frame.effectConstants;
+	SetGaussianBlurKernel(settings.gaussianBlur, 1);
+
+	CPUPassContext context;
+	context.inputs[0]       = frame.sceneColour;
+	context.effectConstants = &settings;
+	context.viewportWidth   = width;
+	context.viewportHeight  = height;
+	context.threadPool      = &threadPool;
+	context.passConstants.texelSize = { 2.0f / static_cast<float>(width), 2.0f / static_cast<float>(height) }; // As in Scene.cpp
+
+	for (PostProcess effect : effects)
+	{
+		CPUComputeTileTiming result;
+		result.effect = effect;
+		result.pixelShaderMilliseconds = FastestRun(numRuns, [&]() { CPUFullScreenPostProcess(effect, context, pixelShaderOutput); });
+		result.computeTileMilliseconds = FastestRun(numRuns, [&]() { CPUComputeTile(effect, context, computeTileOutput); });
+		result.maxDifference = MaxColourDifference(pixelShaderOutput, computeTileOutput);
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Depth of field timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUDepthOfFieldTiming> MeasureDepthOfField(const std::vector<float>& apertures, const CPUPostProcessFrame& frame,
+                                                       int numThreads, int numRuns)
+{
+	std::vector<CPUDepthOfFieldTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty() || frame.sceneDepth == nullptr)  return results;
+
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+	CPUThreadPool threadPool(numThreads);
+	CPUImage cocImage(width, height, TargetFormat::RGBA16F);
+	CPUImage tileImage(std::max(width / DOF_TILE_SIZE, 1), std::max(height / DOF_TILE_SIZE, 1), TargetFormat::RGBA16F);
+	CPUImage fieldImage(std::max(width / DOF_GATHER_SIZE_DIVISOR, 1), std::max(height / DOF_GATHER_SIZE_DIVISOR, 1), TargetFormat::RGBA16F);
+
+	PostProcessChain chain = { { PostProcess::DepthOfField, PostProcessMode::Fullscreen } };
+	CPUImage output;
+	for (float aperture : apertures)
+	{
+		CPUPostProcessFrame apertureFrame = frame;
+		apertureFrame.effectConstants.depthOfField.aperture = aperture;
+
+		CPUDepthOfFieldTiming result;
+		result.aperture = aperture;
+
+		CPUPostProcessDevice device(numThreads);
+		device.Run(chain, apertureFrame, output); // Compile the graph and allocate the images before timing
+		result.milliseconds = FastestRun(numRuns, [&]() { device.Run(chain, apertureFrame, output); });
+
+		// The stages on their own, as the device runs them
+		CPUPassContext context;
+		context.effectConstants = &apertureFrame.effectConstants;
+		context.viewportWidth   = width;
+		context.viewportHeight  = height;
+		context.threadPool      = &threadPool;
+		result.cocMilliseconds = FastestRun(numRuns, [&]()
+		{
+			context.inputs = { frame.sceneColour, frame.sceneDepth, nullptr };
+			CPUDepthOfFieldCoC(apertureFrame.effectConstants.depthOfField, context, cocImage);
+			context.inputs = { &cocImage, nullptr, nullptr };
+			CPUDepthOfFieldTiles(context, tileImage);
+		});
+		context.inputs = { &cocImage, &tileImage, nullptr };
+		result.gatherMilliseconds = FastestRun(numRuns, [&]()
+		{
+			CPUDepthOfFieldGather(MakeDepthOfFieldGatherConstants(false), context, fieldImage);
+			CPUDepthOfFieldGather(MakeDepthOfFieldGatherConstants(true),  context, fieldImage);
+		});
+
+		int inFocusTiles = 0;
+		const float inFocus = 0.5f / DOF_MAX_COC_PIXELS;
+		for (int y = 0; y < tileImage.Height(); ++y)
+		{
+			for (int x = 0; x < tileImage.Width(); ++x)
+			{
+				const CVector4& tileCoC = tileImage.Row(y)[x];
+				if (-tileCoC.x < inFocus && tileCoC.y < inFocus)  ++inFocusTiles;
+			}
+		}
+		result.inFocusTiles = static_cast<float>(inFocusTiles) / (tileImage.Width() * tileImage.Height());
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Motion blur timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUMotionBlurTiming> MeasureMotionBlur(const std::vector<float>& shutters, const CPUPostProcessFrame& frame,
+                                                   int numThreads, int numRuns)
+{
+	std::vector<CPUMotionBlurTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty() || frame.sceneVelocity == nullptr)  return results;
+
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+	CPUThreadPool threadPool(numThreads);
+	CPUImage tileImage(std::max(width / MOTION_BLUR_TILE_SIZE, 1), std::max(height / MOTION_BLUR_TILE_SIZE, 1), TargetFormat::RGBA16F);
+
+	PostProcessChain chain = { { PostProcess::MotionBlur, PostProcessMode::Fullscreen } };
+	CPUImage output;
+	for (float shutter : shutters)
+	{
+		CPUPostProcessFrame shutterFrame = frame;
+		shutterFrame.effectConstants.motionBlur.shutter = shutter;
+
+		CPUMotionBlurTiming result;
+		result.shutter = shutter;
+
+		CPUPostProcessDevice device(numThreads);
+		device.Run(chain, shutterFrame, output); // Compile the graph and allocate the images before timing
+		result.milliseconds = FastestRun(numRuns, [&]() { device.Run(chain, shutterFrame, output); });
+
+		CPUPassContext context;
+		context.inputs          = { frame.sceneVelocity, nullptr, nullptr };
+		context.effectConstants = &shutterFrame.effectConstants;
+		context.viewportWidth   = width;
+		context.viewportHeight  = height;
+		context.threadPool      = &threadPool;
+		result.tileMilliseconds = FastestRun(numRuns, [&]() { CPUMotionBlurTiles(context, tileImage); });
+
+		// As the blur decides, from the longest velocity of each tile on its own
+		int stillTiles = 0;
+		for (int y = 0; y < tileImage.Height(); ++y)
+		{
+			for (int x = 0; x < tileImage.Width(); ++x)
+			{
+				const CVector4& tileVelocity = tileImage.Row(y)[x];
+				float blurLength = std::sqrt(tileVelocity.x * tileVelocity.x + tileVelocity.y * tileVelocity.y) * shutter;
+				if (blurLength < 0.5f)  ++stillTiles;
+			}
+		}
+		result.stillTiles = static_cast<float>(stillTiles) / (tileImage.Width() * tileImage.Height());
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reduced resolution timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUReducedResolutionTiming> MeasureReducedResolution(const std::vector<PostProcess>& effects,
+                                                                 const CPUPostProcessFrame& frame, int numThreads, int numRuns)
+{
+	std::vector<CPUReducedResolutionTiming> results;
+	for (PostProcess effect : effects)
+	{
+		CPUReducedResolutionTiming result;
+		result.effect      = effect;
+		result.sizeDivisor = GetPostProcessDeclaration(effect).reducedResolutionDivisor;
+
+		// The first run of each device compiles the graph and allocates the images, so isn't timed
+		PostProcessChain chain = { { effect, PostProcessMode::Fullscreen } };
+		CPUImage fullOutput, reducedOutput;
+		CPUPostProcessDevice fullDevice(numThreads);
+		CPUPostProcessDevice reducedDevice(numThreads);
+		reducedDevice.SetReducedResolution(true);
+		fullDevice.Run(chain, frame, fullOutput);
+		reducedDevice.Run(chain, frame, reducedOutput);
+		result.fullMilliseconds    = FastestRun(numRuns, [&]() { fullDevice.Run(chain, frame, fullOutput); });
+		result.reducedMilliseconds = FastestRun(numRuns, [&]() { reducedDevice.Run(chain, frame, reducedOutput); });
+
+		result.psnr = PeakSignalToNoise(fullOutput, reducedOutput);
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Temporal accumulation timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUTemporalTiming> MeasureTemporalAccumulation(const std::vector<PostProcess>& effects, const CPUPostProcessFrame& frame,
+                                                           int settleFrames, int numThreads, int numRuns)
+{
+	std::vector<CPUTemporalTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty())  return results;
+
+	for (PostProcess effect : effects)
+	{
+		CPUTemporalTiming result;
+		result.effect = effect;
+
+		PostProcessChain chain = { { effect, PostProcessMode::Fullscreen } };
+		CPUImage fullOutput, temporalOutput;
+		CPUPostProcessDevice fullDevice(numThreads);
+		CPUPostProcessDevice temporalDevice(numThreads);
+		temporalDevice.SetTemporalAccumulation(true);
+		fullDevice.Run(chain, frame, fullOutput);
+		result.fullMilliseconds = FastestRun(numRuns, [&]() { fullDevice.Run(chain, frame, fullOutput); });
+
+		// Each run of the temporal device is a new frame, taking the next share of the samples
+		CPUPostProcessFrame temporalFrame = frame;
+		for (int settle = 0; settle < std::max(settleFrames, 1); ++settle)
+		{
+			temporalDevice.Run(chain, temporalFrame, temporalOutput);
+			++temporalFrame.effectConstants.temporal.frameIndex;
+		}
+		result.temporalMilliseconds = FastestRun(numRuns, [&]()
+		{
+			temporalDevice.Run(chain, temporalFrame, temporalOutput);
+			++temporalFrame.effectConstants.temporal.frameIndex;
+		});
+
+		result.samples = ReportTemporalSamples(temporalDevice.Graph(), frame.sceneColour->Width(), frame.sceneColour->Height());
+		result.psnr = PeakSignalToNoise(fullOutput, temporalOutput);
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// UV remap timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPUUVRemapTiming> MeasureUVRemap(const std::vector<PostProcessChain>& chains, const CPUPostProcessFrame& frame,
+                                             int numThreads, int numRuns)
+{
+	std::vector<CPUUVRemapTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty())  return results;
+
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+	CPUThreadPool threadPool(numThreads);
+	CPUImage sequentialImages[2] = { CPUImage(width, height), CPUImage(width, height) };
+	CPUImage fusedOutput(width, height);
+
+	CPUPassContext context;
+	context.maps            = frame.maps;
+	context.effectConstants = &frame.effectConstants;
+	context.viewportWidth   = width;
+	context.viewportHeight  = height;
+	context.threadPool      = &threadPool;
+	context.passConstants.timer = frame.timer;
+
+	for (const PostProcessChain& chain : chains)
+	{
+		CPUUVRemapTiming result;
+		result.chain = chain;
+
+		// Each effect reads the one before's output, the first the scene
+		const CPUImage* sequentialOutput = frame.sceneColour;
+		result.sequentialMilliseconds = FastestRun(numRuns, [&]()
+		{
+			CPUPassContext effectContext = context;
+			effectContext.inputs[0] = frame.sceneColour;
+			for (size_t i = 0; i < chain.size(); ++i)
+			{
+				CPUImage& target = sequentialImages[i % 2];
+				CPUFullScreenPostProcess(chain[i].first, effectContext, target);
+				effectContext.inputs[0] = &target;
+			}
+			sequentialOutput = effectContext.inputs[0];
+		});
+
+		UVRemapConstants constants = BuildUVRemap(chain, 0, static_cast<int>(chain.size()), frame.effectConstants);
+		CPUPassContext fusedContext = context;
+		fusedContext.inputs[0] = frame.sceneColour;
+		result.fusedMilliseconds = FastestRun(numRuns, [&]() { CPUUVRemap(constants, TargetFormat::RGBA8, fusedContext, fusedOutput); });
+
+		result.psnr = PeakSignalToNoise(*sequentialOutput, fusedOutput);
+		result.maxDifference = MaxColourDifference(*sequentialOutput, fusedOutput);
+		results.push_back(result);
+	}
+	return results;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Lens star timing
+//--------------------------------------------------------------------------------------
+
+std::vector<CPULensStarTiming> MeasureLensStar(const std::vector<int>& streakLengths, const CPUPostProcessFrame& frame,
+                                               int numThreads, int numRuns)
+{
+	std::vector<CPULensStarTiming> results;
+	if (frame.sceneColour == nullptr || frame.sceneColour->IsEmpty())  return results;
+
+	int width  = frame.sceneColour->Width();
+	int height = frame.sceneColour->Height();
+	int starWidth  = std::max(width  / BLOOM_STAR_SIZE_DIVISOR, 1);
+	int starHeight = std::max(height / BLOOM_STAR_SIZE_DIVISOR, 1);
+	CPUThreadPool threadPool(numThreads);
+
+	CPUPassContext context;
+	context.effectConstants = &frame.effectConstants;
+	context.viewportWidth   = width;
+	context.viewportHeight  = height;
+	context.threadPool      = &threadPool;
+
+	// The bloom's quarter size image, as its downsample passes make it
+	CPUImage halfImage(std::max(width / 2, 1), std::max(height / 2, 1), TargetFormat::RGBA16F);
+	CPUImage starSource(starWidth, starHeight, TargetFormat::RGBA16F);
+	context.inputs = { frame.sceneColour, nullptr, nullptr };
+	CPUBloomDownsample(MakeBloomDownsampleConstants(frame.effectConstants, true), context, halfImage);
+	context.inputs = { &halfImage, nullptr, nullptr };
+	CPUBloomDownsample(MakeBloomDownsampleConstants(frame.effectConstants, false), context, starSource);
+
+	// The images of the streak passes as the render graph makes them - two for each side to read one and write the other, and
+	// the star after each streak, the last 8-bit
+	CPUImage sideImages[2][2];
+	for (auto& side : sideImages)
+	{
+		for (CPUImage& image : side)  image = CPUImage(starWidth, starHeight, TargetFormat::RGBA16F);
+	}
+	CPUImage stars[LENS_STAR_STREAKS];
+	for (int streak = 0; streak < LENS_STAR_STREAKS; ++streak)
+	{
+		stars[streak] = CPUImage(starWidth, starHeight, streak == LENS_STAR_STREAKS - 1 ? TargetFormat::RGBA8 : TargetFormat::RGBA16F);
+	}
+	CPUImage singlePassStar(starWidth, starHeight);
+
+	for (int streakLength : streakLengths)
+	{
+		PostProcessEffectConstants lengthConstants = frame.effectConstants;
+		lengthConstants.lensStar.streakLength = streakLength;
+
+		CPULensStarTiming result;
+		result.streakLength = streakLength;
+		result.passes       = LensStarPasses(streakLength);
+
+		CPUPassContext starContext = context;
+		starContext.effectConstants = &lengthConstants;
+		starContext.inputs = { &starSource, nullptr, nullptr };
+		result.singlePassMilliseconds = FastestRun(numRuns, [&]() { CPUFullScreenPostProcess(PostProcess::LensStar, starContext, singlePassStar); });
+
+		// One streak's passes, reading the star the streak before left
+		auto runStreak = [&](int streak)
+		{
+			const CPUImage* sides[2] = { &starSource, &starSource };
+			for (int pass = 0; pass < result.passes - 1; ++pass)
+			{
+				for (int side = 0; side < 2; ++side)
+				{
+					CPUImage& output = sideImages[side][pass % 2];
+					starContext.inputs = { sides[side], nullptr, nullptr };
+					CPULensStarStreak(MakeLensStarStreakConstants(lengthConstants.lensStar, streak, pass, side == 1), starContext, output);
+					sides[side] = &output;
+				}
+			}
+			starContext.inputs = { sides[0], sides[1], streak > 0 ? &stars[streak - 1] : nullptr };
+			CPULensStarStreak(MakeLensStarStreakConstants(lengthConstants.lensStar, streak, result.passes - 1, false), starContext, stars[streak]);
+		};
+		result.iterativeMilliseconds = FastestRun(numRuns, [&]()
+		{
+			for (int streak = 0; streak < LENS_STAR_STREAKS; ++streak)  runStreak(streak);
+		});
+		for (int streak = 0; streak < LENS_STAR_STREAKS; ++streak)
+		{
+			result.streakMilliseconds[streak] = FastestRun(numRuns, [&]() { runStreak(streak); });
+		}
+
+		result.psnr = PeakSignalToNoise(singlePassStar, stars[LENS_STAR_STREAKS - 1]);
+		result.maxDifference = MaxColourDifference(singlePassStar, stars[LENS_STAR_STREAKS - 1]);
+		results.push_back(result);
+	}
+	return results;
+}
@@ -0,0 +1,405 @@
+//--------------------------------------------------------------------------------------
+// Running the post-processing chain on the CPU
+//--------------------------------------------------------------------------------------
+// A PostProcessDevice that carries out the render graph's passes with the CPU post-processes
+// (CPUPostProcess.h) instead of DirectX. Run takes the same chain as gActivePostProcesses and a
+// rendered scene, and works out the image that would appear in the back buffer. The graph and
+// its pooled targets are planned exactly as in Scene.cpp, so the same passes, copies and target
+// sharing are tested. The history kept for the next frame (the History input) carries over from one
+// Run to the next.
+//
+// Runs of full screen passes are fused and worked through one cache-sized tile at a time (see
+// CPUTileFusion.h). The tiles are shared between the threads of a pool owned by the device.
+//
+// Runs of full screen distortions are run as one pass reading the image once (see CPUUVRemap.h).
+//
+// Pure colour effects can be switched to colour LUTs (see CPUColourLUT.h), baked by the device
+// when first used and again whenever their settings change.
+//
+// Wide full screen Gaussian blurs are run on a smaller image, as on the GPU (see GaussianKernel.h).
+// Full screen dilations and box blurs are run as two sliding window passes (see CPUSlidingFilter.h).
+// Full screen wireframes and Gaussian blurs can be run as their compute shaders would run them, a
+// tile at a time (see CPUComputeTile.h). Bloom makes its glow from smaller images (see CPUBloom.h)
+// and its lens star from a few passes along each streak (see CPULensStar.h).
+// Depth of field blurs its near and far fields at half size, skipping tiles in focus (see
+// CPUDepthOfField.h). Motion blur follows the velocity of each pixel given with the frame, skipping
+// tiles where nothing moves (see CPUMotionBlur.h).
+// Effects with a smooth change to the image can be run on a smaller image, the change scaled back up
+// (see RenderPassType::ReducedResolutionUpsample). Effects declared with temporalFrames can take a
+// share of their samples each Run, blended with the history reprojected from the Run before (see
+// CPUTemporal.h).
+//
+// Useful for checking the shaders against a reference and for post-processing images in batch
+// jobs on machines without a GPU
+
+#ifndef _CPU_POST_PROCESS_DEVICE_H_INCLUDED_
+#define _CPU_POST_PROCESS_DEVICE_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "CPUThreadPool.h"
+#include "CPUTileFusion.h"
+#include "LensStar.h"
+#include "PostProcessDevice.h"
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+#include "TemporalHistory.h"
+
+#include <functional>
+#include <map>
+#include <vector>
+
+
+// One frame of input for the chain
+struct CPUPostProcessFrame
+{
+	// The rendered scene (required), its size is the viewport size
+	const CPUImage* sceneColour = nullptr;
+
+	// Depth buffer of the scene (0->1 values in the red channel). Read by depth of field and fog, and used to hide area
+	// and polygon effects behind objects. Without it the depth is taken as 1 everywhere, as a cleared depth buffer
+	const CPUImage* sceneDepth = nullptr;
+
+	// Velocity of the scene as the velocity pass writes it (movement since the last frame in UVs in red and green, view space
+	// depth in blue, see MotionBlur.h). Read by motion blur. Without it nothing moves
+	const CPUImage* sceneVelocity = nullptr;
+
+	// Time since the app started and the settings of each effect - see DefaultPostProcessEffectConstants
+	float                      timer = 0.0f;
+	PostProcessEffectConstants effectConstants = {};
+
+	CPUPostProcessMaps maps;
+
+	// Where each area and polygon pass appears on screen (Scene.cpp uses CalculatePassRegion). If not given, area and
+	// polygon passes cover the whole screen
+	std::function<PostProcessRegion(const RenderPass&)> passRegion;
+};
+
+
+class CPUPostProcessDevice : public PostProcessDevice
+{
+public:
+	//-------------------------------------
+	// Construction / Usage
+	//-------------------------------------
+
+	// Work is shared between the given number of threads, 0 to use one for each processor core
+	CPUPostProcessDevice(int numThreads = 0);
+
+	// Run the chain on the given frame. The result is written to output (resized to the scene size, 8-bit as the back
+	// buffer) and the work done is returned. Returns empty statistics without running anything if there is no scene
+	PostProcessStats Run(const PostProcessChain& chain, const CPUPostProcessFrame& frame, CPUImage& output);
+
+	// Forget the history kept for the next frame, e.g. at a cut in a sequence of frames
+	void ClearHistory()  { mHistory.Fill(CVector4(0, 0, 0, 0));  mHistoryValid = false; }
+
+	// Fuse runs of full screen passes (the default) or run every pass over the whole image. The results are the same
+	void SetTileFusion(bool fuse)  { mTileFusion = fuse; }
+	bool TileFusion() const        { return mTileFusion; }
+
+	// Run full screen effects declared with colourLUT from colour LUTs rather than their own code (off by default). The
+	// results are very close, but not always the same
+	void SetColourLUTs(bool useLUTs)  { mUseColourLUTs = useLUTs; }
+	bool ColourLUTs() const           { return mUseColourLUTs; }
+
+	// Run full screen effects declared with computeTile as their compute shaders do (off by default, see ComputeTile.h). The
+	// results are the same as their pixel shaders, other than rounding
+	void SetComputeTiles(bool useComputeTiles)  { mUseComputeTiles = useComputeTiles; }
+	bool ComputeTiles() const                   { return mUseComputeTiles; }
+
+	// Run full screen effects declared with a reducedResolutionDivisor on a smaller image (off by default). Close to the full
+	// size results but not the same, see MeasureReducedResolution
+	void SetReducedResolution(bool reducedResolution)  { mReducedResolution = reducedResolution; }
+	bool ReducedResolution() const                     { return mReducedResolution; }
+
+	// Spread the samples of effects declared with temporalFrames over that many Runs (off by default, see TemporalHistory.h).
+	// Give each frame the camera's reprojection and a new frameIndex in effectConstants.temporal. The first Run after the
+	// chain changes takes a share of the samples with no history to fill in the rest, later Runs converge on the full result
+	void SetTemporalAccumulation(bool temporalAccumulation)  { mTemporalAccumulation = temporalAccumulation; }
+	bool TemporalAccumulation() const                        { return mTemporalAccumulation; }
+
+	// The LUT baked for an effect, nullptr if it hasn't been used with LUTs switched on
+	const ColourLUT* FindColourLUT(PostProcess postProcess) const;
+
+	const RenderGraph&                Graph() const       { return mGraph; }
+	const RenderTargetAllocator&      Allocator() const   { return mAllocator; }
+	const std::vector<CPUFusedGroup>& FusedGroups() const { return mFusedGroups; }
+	int                               NumThreads() const  { return mThreadPool.NumThreads(); }
+
+
+	//-------------------------------------
+	// PostProcessDevice
+	//-------------------------------------
+	// Called by ExecuteRenderGraph during Run
+
+	void SetPassResources(const RenderPass& pass) override;
+	void DrawFullScreen(PostProcess postProcess) override;
+	void DrawRegion(const RenderPass& pass) override;
+	void CopyResource(int destination, int source) override;
+	int  CopyRegion(int destination, int source, const RenderPass& pass) override;
+	PostProcessStats DrawPolygonBatch(const RenderPass& pass) override;
+	void DrawColourTransform(const RenderPass& pass) override;
+	void DrawUVRemap(const RenderPass& pass) override;
+	void DrawResample(const RenderPass& pass) override;
+	void RunSlidingFilter(const RenderPass& pass) override;
+	void RunComputeTile(const RenderPass& pass) override;
+	void DrawBloomMip(const RenderPass& pass) override;
+	void DrawLensStarStreak(const RenderPass& pass) override;
+	void DrawDepthOfFieldStage(const RenderPass& pass) override;
+	void DrawMotionBlurTiles(const RenderPass& pass) override;
+	void DrawReducedResolutionUpsample(const RenderPass& pass) override;
+	void DrawTemporalResolve(const RenderPass& pass) override;
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	// The image backing a graph resource, nullptr for -1. The scene depth and velocity are never written, so are only inputs
+	CPUImage*       Image(int resource);
+	const CPUImage* InputImage(int resource);
+
+	PostProcessRegion PassRegion(const RenderPass& pass) const;
+
+	// Run the passes of a fused group tile by tile, adding them to the statistics as if they had been run one by one
+	void RunFusedGroup(const CPUFusedGroup& group, PostProcessStats& stats);
+	void RunFusedTile(const CPUFusedGroup& group, const PixelRect& tile, int thread);
+
+	// Work out the stages of each colour transform pass from the frame's settings
+	void UpdateColourTransforms();
+
+	// Bake the LUTs of the graph's colour LUT effects if they haven't been, or their settings have changed
+	void UpdateColourLUTs();
+
+	// The LUT to run a full screen pass of the effect from the given input to the given target, nullptr to run the effect
+	const ColourLUT* PassColourLUT(PostProcess postProcess, const CPUImage* input, const CPUImage& target) const;
+
+	CPUThreadPool mThreadPool;
+	bool          mTileFusion = true;
+	bool          mUseColourLUTs = false;
+	bool          mUseComputeTiles = false;
+	bool          mReducedResolution = false;
+	bool          mTemporalAccumulation = false;
+
+	RenderGraph                mGraph;
+	PostProcessChain           mChain;       // The chain the graph was compiled from
+	std::vector<CPUFusedGroup> mFusedGroups; // Found when the graph is compiled
+	RenderTargetAllocator      mAllocator;
+	std::vector<CPUImage>      mTargets;     // One for each slot of the allocator
+
+	// Constants of each colour transform pass for the current frame, by the pass's chain index
+	std::map<int, ColourTransformConstants> mColourTransforms;
+
+	// LUTs of the effects run with colour LUTs, kept between frames
+	std::map<PostProcess, ColourLUT> mColourLUTs;
+
+	// Windows holding the images between the passes of a fused group, two for each thread, used in turn
+	std::vector<CPUImage> mTileImages;
+
+	CPUImage mHistory;
+	bool     mHistoryValid = false; // The history holds the last Run of the current graph
+	CPUImage mClearedDepth;   // Used when the frame has no depth
+	CPUImage mStillVelocity; // Used when the frame has no velocity
+
+	// Set up for the current Run
+	const CPUPostProcessFrame* mFrame  = nullptr;
+	CPUImage*                  mOutput = nullptr;
+	CPUPassContext             mContext; // Inputs and constants selected by the last SetPassResources
+	PostProcessEffectConstants mEffectConstants; // The frame's settings, with the blur kernel for the size of the current pass
+	CPUImage*                  mTarget = nullptr;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Thread scaling
+//--------------------------------------------------------------------------------------
+
+// Time taken to run a chain with a given number of threads
+struct CPUThreadScaling
+{
+	int    numThreads   = 0;
+	double milliseconds = 0; // Fastest of the runs
+	double speedUp      = 0; // Compared to one thread
+};
+
+// Time the chain on the frame with 1, 2, 4... threads up to maxThreads (0 for one per processor core, which is always
+// included), taking the fastest of the given number of runs for each. Use a large frame (e.g. 3840x2160) so the
+// timings aren't swamped by starting up
+std::vector<CPUThreadScaling> MeasureThreadScaling(const PostProcessChain& chain, const CPUPostProcessFrame& frame,
+                                                   int maxThreads, int numRuns, bool tileFusion = true);
+
+
+// Cost of running an effect from a colour LUT compared with running the effect itself
+struct CPUColourLUTTiming
+{
+	PostProcess effect = PostProcess::None;
+	double bakeMilliseconds   = 0; // Baking its LUT
+	double effectMilliseconds = 0; // Running the effect as the only entry in the chain
+	double lutMilliseconds    = 0; // The same from the LUT
+	int    maxDifference      = 0; // Largest difference between the two results in any channel of any pixel, in 8-bit steps
+};
+
+// Time each of the effects, which must be declared with colourLUT, over the whole frame with and without its LUT. The
+// fastest of the given number of runs is taken for each time
+std::vector<CPUColourLUTTiming> MeasureColourLUTs(const std::vector<PostProcess>& effects, const CPUPostProcessFrame& frame,
+                                                  int numThreads, int numRuns);
+
+
+// Cost of a full screen Gaussian blur (horizontal then vertical) of a given width
+struct CPUGaussianBlurTiming
+{
+	float  sigma        = 0; // Width of the blur in pixels
+	int    levels       = 0; // Times the image was halved to run the blur, see GaussianBlurLevels
+	int    numTaps      = 0; // Taps in the kernel at that size
+	double milliseconds = 0; // Running the chain, fastest of the runs
+};
+
+// Time a full screen Gaussian blur of each of the given sigmas over the frame, taking the fastest of the given number of
+// runs. Shows the cost staying about the same as the blur widens
+std::vector<CPUGaussianBlurTiming> MeasureGaussianBlur(const std::vector<float>& sigmas, const CPUPostProcessFrame& frame,
+                                                       int numThreads, int numRuns);
+
+
+
+// Cost of a full screen dilation or box blur of a given radius, run as the pixel shader runs it and as sliding window passes
+struct CPUSlidingFilterTiming
+{
+	PostProcess effect = PostProcess::None;
+	int    radius                  = 0;
+	double pixelShaderMilliseconds = 0; // Reading every pixel of the square around each pixel, as Dilation_pp / OnePassBlur_pp
+	double slidingMilliseconds     = 0; // The rows pass then the columns pass (see SlidingFilter.h)
+	int    maxDifference           = 0; // Largest difference between the two results in any channel of any pixel, in 8-bit steps
+};
+
+// Time each of the effects, which must be declared with slidingFilter, at each of the given radii over the frame's scene,
+// taking the fastest of the given number of runs for each time. The pixel shader version reads (2 * radius + 1)^2 pixels
+// for each one, so use a small frame (e.g. 480x270) for wide radii
+std::vector<CPUSlidingFilterTiming> MeasureSlidingFilters(const std::vector<PostProcess>& effects, const std::vector<int>& radii,
+                                                          const CPUPostProcessFrame& frame, int numThreads, int numRuns);
+
+
+// Cost of a full screen neighbourhood effect run by its pixel shader and by its compute shader a tile at a time
+struct CPUComputeTileTiming
+{
+	PostProcess effect = PostProcess::None;
+	double pixelShaderMilliseconds = 0; // As the pixel shader reads the texture for each pixel (see CPUPostProcess.h)
+	double computeTileMilliseconds = 0; // As the compute shader's thread groups (see CPUComputeTile.h)
+	int    maxDifference           = 0; // Largest difference between the two results in any channel of any pixel, in 8-bit steps
+};
+
+// Time each of the effects, which must be declared with computeTile, over the frame's scene both ways, taking the fastest of
+// the given number of runs for each. Blurs use the frame's sigma limited to what can be run at full size. A difference of
+// more than one step means a shader's tile or apron doesn't cover what its pixel shader reads
+std::vector<CPUComputeTileTiming> MeasureComputeTiles(const std::vector<PostProcess>& effects, const CPUPostProcessFrame& frame,
+                                                      int numThreads, int numRuns);
+
+
+// Cost of the depth of field at a given aperture
+struct CPUDepthOfFieldTiming
+{
+	float  aperture           = 0;
+	float  inFocusTiles       = 0; // Fraction of the tiles with nothing out of focus, where the gathers finish straight away
+	double milliseconds       = 0; // Running the depth of field as the only entry in the chain, fastest of the runs
+	double cocMilliseconds    = 0; // The circle of confusion and tiles passes on their own
+	double gatherMilliseconds = 0; // The near and far gathers on their own
+};
+
+// Time a full screen depth of field over the frame, which needs a depth, with each of the given apertures (other settings
+// from the frame), taking the fastest of the given number of runs for each. Shows the gathers' cost following how much of
+// the image is out of focus rather than how far out of focus it is
+std::vector<CPUDepthOfFieldTiming> MeasureDepthOfField(const std::vector<float>& apertures, const CPUPostProcessFrame& frame,
+                                                       int numThreads, int numRuns);
+
+
+// Cost of the motion blur at a given shutter
+struct CPUMotionBlurTiming
+{
+	float  shutter          = 0;
+	float  stillTiles       = 0; // Fraction of the tiles with no blur of half a pixel or more, which the blur only copies
+	double milliseconds     = 0; // Running the motion blur as the only entry in the chain, fastest of the runs
+	double tileMilliseconds = 0; // The tiles pass on its own
+};
+
+// Time a full screen motion blur over the frame, which needs a velocity, with each of the given shutters (other settings from
+// the frame), taking the fastest of the given number of runs for each. Shows the cost following how much of the image moves,
+// a shutter of 0 being a still image
+std::vector<CPUMotionBlurTiming> MeasureMotionBlur(const std::vector<float>& shutters, const CPUPostProcessFrame& frame,
+                                                   int numThreads, int numRuns);
+
+
+// Cost and quality of running a full screen effect on a smaller image
+struct CPUReducedResolutionTiming
+{
+	PostProcess effect = PostProcess::None;
+	int    sizeDivisor         = 1; // The effect's reducedResolutionDivisor
+	double fullMilliseconds    = 0; // Running the effect as the only entry in the chain at full size
+	double reducedMilliseconds = 0; // The same at reduced resolution, including the resamples and the upsample
+	double psnr                = 0; // Peak signal to noise ratio of the reduced result against the full size one, in decibels
+};
+
+// Time each of the effects, which should be declared with a reducedResolutionDivisor, over the frame at full size and at
+// reduced resolution, taking the fastest of the given number of runs for each. Give the frame a depth for the effects that
+// read it. A PSNR above about 40dB is hard to tell apart from the full size result, under about 30dB the difference shows
+std::vector<CPUReducedResolutionTiming> MeasureReducedResolution(const std::vector<PostProcess>& effects,
+                                                                 const CPUPostProcessFrame& frame, int numThreads, int numRuns);
+
+
+// Cost and quality of spreading an effect's samples over several frames
+struct CPUTemporalTiming
+{
+	PostProcess effect = PostProcess::None;
+	double fullMilliseconds     = 0; // Running the effect as the only entry in the chain, taking all of its samples
+	double temporalMilliseconds = 0; // The same with temporal accumulation, including the resolve and the history copy
+	TemporalSampleReport samples;    // Texture reads each frame with temporal accumulation
+	double psnr                 = 0; // Peak signal to noise ratio of the temporal result against the full one, in decibels
+};
+
+// Time each of the effects, which should be declared with temporalFrames, over the frame with and without temporal
+// accumulation, taking the fastest of the given number of runs for each. The temporal device first runs the given number of
+// frames to settle its history, each with the next frameIndex and the frame's reprojection (identity for a still camera),
+// and the quality is that of the last frame. Give the frame a depth for the effects that read it
+std::vector<CPUTemporalTiming> MeasureTemporalAccumulation(const std::vector<PostProcess>& effects, const CPUPostProcessFrame& frame,
+                                                           int settleFrames, int numThreads, int numRuns);
+
+
+
+// Cost and quality of running a chain of full screen distortions as one UV remap pass
+struct CPUUVRemapTiming
+{
+	PostProcessChain chain;
+	double sequentialMilliseconds = 0; // Running each effect over the whole image in turn, through 8-bit targets
+	double fusedMilliseconds      = 0; // The UV remap pass (see UVRemap.h)
+	double psnr                   = 0; // Peak signal to noise ratio of the fused result against the sequential one, in decibels
+	int    maxDifference          = 0; // Largest difference between the two in any channel of any pixel, in 8-bit steps
+};
+
+// Time each of the chains over the frame's scene run effect by effect and as one pass, taking the fastest of the given number
+// of runs for each. Give chains the render graph would run as one pass - full screen entries declared with a uvRemap, at most
+// MAX_UV_REMAP_EFFECTS, chromatic distortion only first. The results differ where the effects snapped their reads to whole
+// pixels, so expect some difference at sharp edges and at the edge of the black chromatic distortion leaves
+std::vector<CPUUVRemapTiming> MeasureUVRemap(const std::vector<PostProcessChain>& chains, const CPUPostProcessFrame& frame,
+                                             int numThreads, int numRuns);
+
+
+// Cost and quality of the lens star's streaks at a given length
+struct CPULensStarTiming
+{
+	int    streakLength = 0; // Samples along each side of each streak
+	int    passes       = 0; // Passes along each side of each streak, see LensStarPasses
+	double singlePassMilliseconds = 0; // LensStar_pp, reading every sample of every streak for each pixel
+	double iterativeMilliseconds  = 0; // All the streak passes (see LensStar.h)
+	double streakMilliseconds[LENS_STAR_STREAKS] = {}; // The passes of each streak on their own
+	double psnr          = 0; // Peak signal to noise ratio of the iterative star against the single pass one, in decibels
+	int    maxDifference = 0; // Largest difference between the two in any channel of any pixel, in 8-bit steps
+};
+
+// Time the bloom's lens star with each of the given streak lengths (other settings from the frame) over the quarter size
+// image the bloom makes from the frame's scene, made once first. The star is made by LensStar_pp in one pass and by the
+// streak passes, taking the fastest of the given number of runs for each. The single pass's cost grows with the length, the
+// streak passes' only with the number of passes. The two differ a little as the single pass reads whole pixels and the
+// streak passes read bilinearly
+std::vector<CPULensStarTiming> MeasureLensStar(const std::vector<int>& streakLengths, const CPUPostProcessFrame& frame,
+                                               int numThreads, int numRuns);
+
+
+#endif //_CPU_POST_PROCESS_DEVICE_H_INCLUDED_
@@ -0,0 +1,30 @@
+//--------------------------------------------------------------------------------------
+// Vector instruction sets used by the CPU post-processing
+//--------------------------------------------------------------------------------------
+// A pixel is four floats, which is exactly one SSE register, or two pixels to an AVX register.
+// The fast paths in the CPU post-processing are chosen when compiling, from the instruction sets
+// the compiler has been told it can use (e.g. /arch:AVX2 in Visual Studio, -mavx2 -mf16c in GCC).
+// Every fast path has a plain C++ version that gives the same results, used when none are available
+
+#ifndef _CPU_SIMD_H_INCLUDED_
+#define _CPU_SIMD_H_INCLUDED_
+
+// SSE2 is always there on 64-bit x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define CPU_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+	#define CPU_SIMD_AVX2
+	#include <immintrin.h>
+#endif
+
+// Conversion to and from 16-bit floats. Visual Studio has no separate switch for it, every AVX2 processor has it
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+	#define CPU_SIMD_F16C
+	#include <immintrin.h>
+#endif
+
+
+#endif //_CPU_SIMD_H_INCLUDED_
@@ -0,0 +1,281 @@
+//--------------------------------------------------------------------------------------
+// Sliding window filters on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUSlidingFilter.h"
+#include "CPUSimd.h"
+#include "SlidingFilter.h"
+
+#include <algorithm>
+#include <vector>
+
+
+// Columns worked on together by the columns pass. The running results for a strip the height of the screen fit in the cache
+const int SLIDING_FILTER_STRIP_WIDTH = 32;
+
+
+//--------------------------------------------------------------------------------------
+// Combining pixels
+//--------------------------------------------------------------------------------------
+
+// The largest of each channel, for the dilation
+struct SlidingMax
+{
+#if defined(CPU_SIMD_AVX2)
+	static __m256 Combine(__m256 a, __m256 b)  { return _mm256_max_ps(a, b); }
+#endif
+#if defined(CPU_SIMD_SSE2)
+	static __m128 Combine(__m128 a, __m128 b)  { return _mm_max_ps(a, b); }
+#endif
+	static CVector4 Combine(const CVector4& a, const CVector4& b)
+	{
+		return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z), std::max(a.w, b.w) };
+	}
+};
+
+// The sum of each channel, for the box blur
+struct SlidingSum
+{
+#if defined(CPU_SIMD_AVX2)
+	static __m256 Combine(__m256 a, __m256 b)  { return _mm256_add_ps(a, b); }
+#endif
+#if defined(CPU_SIMD_SSE2)
+	static __m128 Combine(__m128 a, __m128 b)  { return _mm_add_ps(a, b); }
+#endif
+	static CVector4 Combine(const CVector4& a, const CVector4& b)
+	{
+		return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+	}
+};
+
+
+// result[i] = Combine(a[i], b[i]) for count pixels. The result can be a or b
+template <class Op>
+static inline void CombineRun(const CVector4* a, const CVector4* b, CVector4* result, int count)
+{
+	int i = 0;
+#if defined(CPU_SIMD_AVX2)
+	for (; i + 2 <= count; i += 2)
+	{
+		_mm256_storeu_ps(&result[i].x, Op::Combine(_mm256_loadu_ps(&a[i].x), _mm256_loadu_ps(&b[i].x)));
+	}
+#endif
+#if defined(CPU_SIMD_SSE2)
+	for (; i < count; ++i)
+	{
+		_mm_storeu_ps(&result[i].x, Op::Combine(_mm_loadu_ps(&a[i].x), _mm_loadu_ps(&b[i].x)));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		result[i] = Op::Combine(a[i], b[i]);
+	}
+}
+
+// Multiply the colour of count pixels by the given scale and make them opaque
+static void ScaleOpaqueRun(CVector4* pixels, float scale, int count)
+{
+	int i = 0;
+#if defined(CPU_SIMD_SSE2)
+	const __m128 rgbMask  = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alphaOne = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	const __m128 scale4   = _mm_set1_ps(scale);
+	for (; i < count; ++i)
+	{
+		__m128 result = _mm_mul_ps(_mm_loadu_ps(&pixels[i].x), scale4);
+		_mm_storeu_ps(&pixels[i].x, _mm_or_ps(_mm_and_ps(result, rgbMask), alphaOne));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		pixels[i] = { pixels[i].x * scale, pixels[i].y * scale, pixels[i].z * scale, 1.0f };
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Lines
+//--------------------------------------------------------------------------------------
+// A line is a run of elements along the direction of the pass - single pixels for the rows pass, rows of a strip for the
+// columns pass. Each element is width pixels, element i is at position start + i along the line
+
+// Fill forward[i] with element i combined with the elements before it in its block, and backward[i] with those after it in its
+// block. Blocks are blockWidth elements long with one starting at position 0. The first and last elements of the line are
+// taken as the start and end of a block, which only affects results that are never used
+template <class Op>
+static void RunningResults(const CVector4* line, int start, int numElements, int width, int blockWidth,
+                           CVector4* forward, CVector4* backward)
+{
+	int phase = start - SlidingFilterBlock(start, blockWidth) * blockWidth; // Position of element 0 within its block
+
+	int position = phase;
+	for (int i = 0; i < numElements; ++i)
+	{
+		const CVector4* element = line + static_cast<ptrdiff_t>(i) * width;
+		CVector4* result = forward + static_cast<ptrdiff_t>(i) * width;
+		if (i == 0 || position == 0)  std::copy(element, element + width, result);
+		else                          CombineRun<Op>(result - width, element, result, width);
+		position = (position + 1 == blockWidth) ? 0 : position + 1;
+	}
+
+	position = (phase + numElements - 1) % blockWidth;
+	for (int i = numElements - 1; i >= 0; --i)
+	{
+		const CVector4* element = line + static_cast<ptrdiff_t>(i) * width;
+		CVector4* result = backward + static_cast<ptrdiff_t>(i) * width;
+		if (i == numElements - 1 || position == blockWidth - 1)  std::copy(element, element + width, result);
+		else                                                     CombineRun<Op>(result + width, element, result, width);
+		position = (position == 0) ? blockWidth - 1 : position - 1;
+	}
+}
+
+// Work out the window around each of count elements, the first of which is radius elements into the line, from the running
+// results. The window of an element starts at the same position in the line as the result written for it
+template <class Op>
+static void FinishWindows(const CVector4* forward, const CVector4* backward, int start, int count, int width, int radius,
+                          bool average, CVector4* out)
+{
+	int blockWidth = 2 * radius + 1;
+	int position = start - SlidingFilterBlock(start, blockWidth) * blockWidth;
+	for (int i = 0; i < count; ++i)
+	{
+		// A window that lines up with a block is the block itself, all of which is in the backward result. Adding the forward
+		// result would count it twice. Taking the largest value twice makes no difference so the dilation doesn't check
+		const CVector4* windowStart = backward + static_cast<ptrdiff_t>(i) * width;
+		const CVector4* windowEnd   = forward  + static_cast<ptrdiff_t>(i + 2 * radius) * width;
+		CVector4* result = out + static_cast<ptrdiff_t>(i) * width;
+		if (average && position == 0)  std::copy(windowStart, windowStart + width, result);
+		else                           CombineRun<Op>(windowStart, windowEnd, result, width);
+		position = (position + 1 == blockWidth) ? 0 : position + 1;
+	}
+	ScaleOpaqueRun(out, average ? 1.0f / blockWidth : 1.0f, count * width);
+}
+
+
+// Per-thread memory for the passes
+struct SlidingFilterBuffers
+{
+	std::vector<CVector4> line;
+	std::vector<CVector4> forward;
+	std::vector<CVector4> backward;
+	std::vector<CVector4> out;
+
+	void Resize(int numElements, int count, int width)
+	{
+		line    .resize(static_cast<size_t>(numElements) * width);
+		forward .resize(static_cast<size_t>(numElements) * width);
+		backward.resize(static_cast<size_t>(numElements) * width);
+		out     .resize(static_cast<size_t>(count) * width);
+	}
+};
+
+
+// Filter each row of the tile along the row
+template <class Op>
+static void FilterRows(int radius, bool average, const CPUImage& input, const PixelRect& tile, CPUImage& target,
+                       SlidingFilterBuffers& buffers)
+{
+	const PixelRect& window = input.Window();
+	int count = tile.right - tile.left;
+	int start = tile.left - radius;
+	int numElements = count + 2 * radius;
+	buffers.Resize(numElements, count, 1);
+
+	for (int y = tile.top; y < tile.bottom; ++y)
+	{
+		const CVector4* row = input.Row(std::min(std::max(y, window.top), window.bottom - 1));
+		for (int i = 0; i < numElements; ++i)
+		{
+			buffers.line[i] = row[std::min(std::max(start + i, window.left), window.right - 1)];
+		}
+
+		RunningResults<Op>(buffers.line.data(), start, numElements, 1, 2 * radius + 1, buffers.forward.data(), buffers.backward.data());
+		FinishWindows<Op>(buffers.forward.data(), buffers.backward.data(), start, count, 1, radius, average, buffers.out.data());
+		target.Store(tile.left, y, buffers.out.data(), count);
+	}
+}
+
+// Filter the given columns of the target down the whole height, a row of the strip at a time
+template <class Op>
+static void FilterColumns(int radius, bool average, const CPUImage& input, int left, int right, CPUImage& target,
+                          SlidingFilterBuffers& buffers)
+{
+	const PixelRect& window = input.Window();
+	int width = right - left;
+	int count = target.Height();
+	int start = -radius;
+	int numElements = count + 2 * radius;
+	buffers.Resize(numElements, count, width);
+
+	for (int i = 0; i < numElements; ++i)
+	{
+		const CVector4* row = input.Row(std::min(std::max(start + i, window.top), window.bottom - 1));
+		CVector4* element = buffers.line.data() + static_cast<ptrdiff_t>(i) * width;
+		for (int x = 0; x < width; ++x)
+		{
+			element[x] = row[std::min(std::max(left + x, window.left), window.right - 1)];
+		}
+	}
+
+	RunningResults<Op>(buffers.line.data(), start, numElements, width, 2 * radius + 1, buffers.forward.data(), buffers.backward.data());
+	FinishWindows<Op>(buffers.forward.data(), buffers.backward.data(), start, count, width, radius, average, buffers.out.data());
+	for (int y = 0; y < count; ++y)
+	{
+		target.Store(left, y, buffers.out.data() + static_cast<ptrdiff_t>(y) * width, width);
+	}
+}
+
+
+template <class Op>
+static void SlidingFilterPass(const SlidingFilterConstants& constants, const CPUImage& input, CPUThreadPool* threadPool, CPUImage& target)
+{
+	int radius = std::min(std::max(constants.radius, 0), SLIDING_FILTER_MAX_RADIUS);
+	bool average = constants.average != 0;
+
+	std::vector<SlidingFilterBuffers> threadBuffers(threadPool ? threadPool->NumThreads() : 1);
+	if (constants.columns == 0)
+	{
+		PixelRect rect = { 0, 0, target.Width(), target.Height() };
+		int numTiles = (rect.bottom + CPU_TILE_ROWS - 1) / CPU_TILE_ROWS;
+		auto runTile = [&](int tile, int thread)
+		{
+			PixelRect tileRect = rect;
+			tileRect.top    = tile * CPU_TILE_ROWS;
+			tileRect.bottom = std::min(tileRect.top + CPU_TILE_ROWS, rect.bottom);
+			FilterRows<Op>(radius, average, input, tileRect, target, threadBuffers[thread]);
+		};
+		if (threadPool)  threadPool->ParallelFor(numTiles, runTile);
+		else             for (int tile = 0; tile < numTiles; ++tile)  runTile(tile, 0);
+	}
+	else
+	{
+		int numStrips = (target.Width() + SLIDING_FILTER_STRIP_WIDTH - 1) / SLIDING_FILTER_STRIP_WIDTH;
+		auto runStrip = [&](int strip, int thread)
+		{
+			int left = strip * SLIDING_FILTER_STRIP_WIDTH;
+			int right = std::min(left + SLIDING_FILTER_STRIP_WIDTH, target.Width());
+			FilterColumns<Op>(radius, average, input, left, right, target, threadBuffers[thread]);
+		};
+		if (threadPool)  threadPool->ParallelFor(numStrips, runStrip);
+		else             for (int strip = 0; strip < numStrips; ++strip)  runStrip(strip, 0);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Passes
+//--------------------------------------------------------------------------------------
+
+void CPUSlidingFilter(const SlidingFilterConstants& constants, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* input = context.inputs[0];
+	if (!input)
+	{
+		std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+		for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+		return;
+	}
+
+	if (constants.average)  SlidingFilterPass<SlidingSum>(constants, *input, context.threadPool, target);
+	else                    SlidingFilterPass<SlidingMax>(constants, *input, context.threadPool, target);
+}
@@ -0,0 +1,23 @@
+//--------------------------------------------------------------------------------------
+// Sliding window filters on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU version of SlidingFilter_cs.hlsl, the two passes a full screen dilation or box blur is
+// run as (see SlidingFilter.h). The rows pass works along one row at a time. The columns pass
+// works on strips of neighbouring columns, taking a whole row of the strip at a time, so every
+// step is the same for each pixel across the strip and runs on several pixels at once with
+// SSE/AVX2 (see CPUSimd.h). Rows and strips are shared between the threads of the pass's pool.
+
+#ifndef _CPU_SLIDING_FILTER_H_INCLUDED_
+#define _CPU_SLIDING_FILTER_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Run one pass of a sliding window filter over the whole target from input 0, which must be the same size. Along the rows
+// or down the columns as the constants say, with reads past the edges giving the edge pixel as the compute shader does
+void CPUSlidingFilter(const SlidingFilterConstants& constants, const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_SLIDING_FILTER_H_INCLUDED_
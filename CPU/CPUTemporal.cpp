@@ -0,0 +1,202 @@
+//--------------------------------------------------------------------------------------
+// Temporal accumulation on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUTemporal.h"
+#include "CPUSimd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+// Fill the target with opaque black, as a pass reading an unbound texture would
+static void FillBlack(CPUImage& target)
+{
+	std::vector<CVector4> blackRow(target.Width(), CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+	for (int y = 0; y < target.Height(); ++y)  target.Store(0, y, blackRow.data(), target.Width());
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reprojection
+//--------------------------------------------------------------------------------------
+
+void CPUReprojectRow(const TemporalResolveConstants& constants, const CPUImage& depth, int left, int y, int count,
+                     CPUReprojection* reprojections)
+{
+	const CMatrix4x4& m = constants.reprojection;
+	const CVector4* depthRow = depth.Row(y);
+	float n = constants.nearClip;
+	float f = constants.farClip;
+	float ndcY = 1.0f - 2.0f * (y + 0.5f) / depth.Height();
+	float ndcXStep = 2.0f / depth.Width();
+	int i = 0;
+
+#if defined(CPU_SIMD_SSE2)
+	// Four pixels at a time, each value of the four in its own register
+	const __m128 nearFar   = _mm_set1_ps(n * f);
+	const __m128 farClip   = _mm_set1_ps(f);
+	const __m128 depthSpan = _mm_set1_ps(f - n);
+	const __m128 ndcY4     = _mm_set1_ps(ndcY);
+	const __m128 half      = _mm_set1_ps(0.5f);
+	const __m128 minusHalf = _mm_set1_ps(-0.5f);
+	for (; i + 4 <= count; i += 4)
+	{
+		int x = left + i;
+		__m128 pixelDepth = _mm_setr_ps(depthRow[x].x, depthRow[x + 1].x, depthRow[x + 2].x, depthRow[x + 3].x);
+		__m128 ndcX = _mm_setr_ps((x + 0.5f) * ndcXStep - 1.0f, (x + 1.5f) * ndcXStep - 1.0f,
+		                          (x + 2.5f) * ndcXStep - 1.0f, (x + 3.5f) * ndcXStep - 1.0f);
+
+		// Clip space position, w being the view space depth
+		__m128 w = _mm_div_ps(nearFar, _mm_sub_ps(farClip, _mm_mul_ps(pixelDepth, depthSpan)));
+		__m128 clipX = _mm_mul_ps(ndcX, w);
+		__m128 clipY = _mm_mul_ps(ndcY4, w);
+		__m128 clipZ = _mm_mul_ps(pixelDepth, w);
+
+		// Each column of the matrix gives one value of the previous clip space position
+		auto column = [&](float m0, float m1, float m2, float m3)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(clipX, _mm_set1_ps(m0)), _mm_mul_ps(clipY, _mm_set1_ps(m1))),
+			                  _mm_add_ps(_mm_mul_ps(clipZ, _mm_set1_ps(m2)), _mm_mul_ps(w,     _mm_set1_ps(m3))));
+		};
+		__m128 previousX = column(m.e00, m.e10, m.e20, m.e30);
+		__m128 previousY = column(m.e01, m.e11, m.e21, m.e31);
+		__m128 previousW = column(m.e03, m.e13, m.e23, m.e33);
+
+		__m128 previousU = _mm_add_ps(_mm_mul_ps(_mm_div_ps(previousX, previousW), half),      half);
+		__m128 previousV = _mm_add_ps(_mm_mul_ps(_mm_div_ps(previousY, previousW), minusHalf), half);
+
+		alignas(16) float u[4], v[4], pw[4], cw[4];
+		_mm_store_ps(u,  previousU);
+		_mm_store_ps(v,  previousV);
+		_mm_store_ps(pw, previousW);
+		_mm_store_ps(cw, w);
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			reprojections[i + lane] = { { u[lane], v[lane] }, pw[lane], cw[lane] };
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		int x = left + i;
+		float pixelDepth = depthRow[x].x;
+		float w = (n * f) / (f - pixelDepth * (f - n));
+		float clipX = ((x + 0.5f) * ndcXStep - 1.0f) * w;
+		float clipY = ndcY * w;
+		float clipZ = pixelDepth * w;
+
+		float previousX = clipX * m.e00 + clipY * m.e10 + clipZ * m.e20 + w * m.e30;
+		float previousY = clipX * m.e01 + clipY * m.e11 + clipZ * m.e21 + w * m.e31;
+		float previousW = clipX * m.e03 + clipY * m.e13 + clipZ * m.e23 + w * m.e33;
+		reprojections[i] = { { previousX / previousW * 0.5f + 0.5f, previousY / previousW * -0.5f + 0.5f }, previousW, w };
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Resolve
+//--------------------------------------------------------------------------------------
+
+void CPUTemporalResolve(const TemporalResolveConstants& constants, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* current = context.inputs[0];
+	const CPUImage* history = context.inputs[1];
+	const CPUImage* depth   = context.inputs[2];
+	if (!current || !depth)
+	{
+		FillBlack(target);
+		return;
+	}
+
+	bool useHistory = constants.historyValid != 0 && history != nullptr;
+	bool clampHistory = constants.neighbourhoodClamp != 0;
+	int width  = target.Width();
+	int height = target.Height();
+
+	// TemporalResolve_pp.hlsl
+	PixelRect targetRect = { 0, 0, width, height };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		int count = tile.right - tile.left;
+		std::vector<CPUReprojection> reprojections(count);
+		std::vector<CVector4> rowBuffer(count);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			CPUReprojectRow(constants, *depth, tile.left, y, count, reprojections.data());
+
+			const CVector4* rows[3] = { current->Row(std::max(y - 1, 0)), current->Row(y), current->Row(std::min(y + 1, height - 1)) };
+			for (int i = 0; i < count; ++i)
+			{
+				int x = tile.left + i;
+				int columns[3] = { std::max(x - 1, 0), x, std::min(x + 1, width - 1) };
+				const CPUReprojection& reprojection = reprojections[i];
+
+				// The history where the pixel was last frame, if it can be trusted
+				bool keepHistory = false;
+				CVector4 historyPixel;
+				if (useHistory && reprojection.previousUV.x >= 0.0f && reprojection.previousUV.x <= 1.0f &&
+				                  reprojection.previousUV.y >= 0.0f && reprojection.previousUV.y <= 1.0f)
+				{
+					historyPixel = history->SampleBilinear(reprojection.previousUV);
+					keepHistory = std::abs(historyPixel.w - reprojection.previousViewDepth) <=
+					              constants.depthTolerance * reprojection.previousViewDepth;
+				}
+
+#if defined(CPU_SIMD_SSE2)
+				// A whole pixel in each register. The range of the new output around the pixel, then the blend
+				__m128 centre  = _mm_loadu_ps(&rows[1][x].x);
+				__m128 nearMin = centre;
+				__m128 nearMax = centre;
+				for (const CVector4* row : rows)
+				{
+					for (int column : columns)
+					{
+						__m128 nearColour = _mm_loadu_ps(&row[column].x);
+						nearMin = _mm_min_ps(nearMin, nearColour);
+						nearMax = _mm_max_ps(nearMax, nearColour);
+					}
+				}
+				__m128 result = centre;
+				if (keepHistory)
+				{
+					__m128 previous = _mm_loadu_ps(&historyPixel.x);
+					if (clampHistory)  previous = _mm_min_ps(_mm_max_ps(previous, nearMin), nearMax);
+					result = _mm_add_ps(previous, _mm_mul_ps(_mm_sub_ps(centre, previous), _mm_set1_ps(constants.currentWeight)));
+				}
+				_mm_storeu_ps(&rowBuffer[i].x, result);
+#else
+				const CVector4& centre = rows[1][x];
+				CVector4 nearMin = centre;
+				CVector4 nearMax = centre;
+				for (const CVector4* row : rows)
+				{
+					for (int column : columns)
+					{
+						const CVector4& nearColour = row[column];
+						nearMin = { std::min(nearMin.x, nearColour.x), std::min(nearMin.y, nearColour.y), std::min(nearMin.z, nearColour.z), 0.0f };
+						nearMax = { std::max(nearMax.x, nearColour.x), std::max(nearMax.y, nearColour.y), std::max(nearMax.z, nearColour.z), 0.0f };
+					}
+				}
+				CVector4 result = centre;
+				if (keepHistory)
+				{
+					CVector4 previous = historyPixel;
+					if (clampHistory)
+					{
+						previous = { std::min(std::max(previous.x, nearMin.x), nearMax.x), std::min(std::max(previous.y, nearMin.y), nearMax.y),
+						             std::min(std::max(previous.z, nearMin.z), nearMax.z), 0.0f };
+					}
+					float weight = constants.currentWeight;
+					result = { previous.x + (centre.x - previous.x) * weight, previous.y + (centre.y - previous.y) * weight,
+					           previous.z + (centre.z - previous.z) * weight, 0.0f };
+				}
+				rowBuffer[i] = result;
+#endif
+				rowBuffer[i].w = reprojection.viewDepth;
+			}
+			target.Store(tile.left, y, rowBuffer.data(), count);
+		}
+	});
+}
@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------------------
+// Temporal accumulation on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU version of TemporalResolve_pp.hlsl, blending an effect's output into its history
+// reprojected from last frame (see TemporalHistory.h). The reprojection of each row is worked out
+// four pixels at a time with SSE, one pixel in each lane, and the neighbourhood clamp and blend one
+// pixel at a time with a pixel in each register (see CPUSimd.h). The plain C++ version gives the
+// same results. Rows of the target are shared between the threads of the pass's pool
+
+#ifndef _CPU_TEMPORAL_H_INCLUDED_
+#define _CPU_TEMPORAL_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Where a pixel was last frame, found from its depth
+struct CPUReprojection
+{
+	CVector2 previousUV;        // Scene UV last frame, outside 0->1 if it was off screen
+	float    previousViewDepth; // View space depth last frame
+	float    viewDepth;         // View space depth this frame
+};
+
+// Reproject the given run of pixels along row y of an image the size of the depth image, which holds 0->1 depths in red
+void CPUReprojectRow(const TemporalResolveConstants& constants, const CPUImage& depth, int left, int y, int count,
+                     CPUReprojection* reprojections);
+
+// Write input 0 blended with the history in input 1, reprojected with the depth in input 2, to the whole target with the view
+// space depth in alpha. All four the same size, the target should be 16-bit float. A history of nullptr is never used
+void CPUTemporalResolve(const TemporalResolveConstants& constants, const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_TEMPORAL_H_INCLUDED_
@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------------------
+// Threads shared by the CPU post-processing
+//--------------------------------------------------------------------------------------
+
+#include "CPUThreadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Construction / Usage
+//--------------------------------------------------------------------------------------
+
+CPUThreadPool::CPUThreadPool(int numThreads /*= 0*/)
+{
+	mNumThreads = numThreads > 0 ? numThreads : static_cast<int>(std::thread::hardware_concurrency());
+	if (mNumThreads < 1)  mNumThreads = 1;
+
+	mBlocks.reset(new TaskBlock[mNumThreads]);
+	for (int thread = 1; thread < mNumThreads; ++thread)
+	{
+		mThreads.emplace_back(&CPUThreadPool::WorkerThread, this, thread);
+	}
+}
+
+CPUThreadPool::~CPUThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mJobStarted.notify_all();
+	for (auto& thread : mThreads)  thread.join();
+}
+
+
+void CPUThreadPool::ParallelFor(int numTasks, const std::function<void(int task, int thread)>& function)
+{
+	if (numTasks <= 0)  return;
+	if (mNumThreads == 1 || numTasks == 1)
+	{
+		for (int task = 0; task < numTasks; ++task)  function(task, 0);
+		return;
+	}
+
+	// Give each thread a block of neighbouring tasks
+	for (int thread = 0; thread < mNumThreads; ++thread)
+	{
+		std::lock_guard<std::mutex> lock(mBlocks[thread].mutex);
+		mBlocks[thread].begin = static_cast<int>(static_cast<int64_t>(numTasks) * thread / mNumThreads);
+		mBlocks[thread].end   = static_cast<int>(static_cast<int64_t>(numTasks) * (thread + 1) / mNumThreads);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFunction    = &function;
+		mBusyWorkers = mNumThreads - 1;
+		++mJob;
+	}
+	mJobStarted.notify_all();
+
+	RunTasks(0);
+
+	// Workers only finish once every block is empty, so when they are all done so are the tasks
+	std::unique_lock<std::mutex> lock(mMutex);
+	mJobFinished.wait(lock, [&]() { return mBusyWorkers == 0; });
+	mFunction = nullptr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Private members
+//--------------------------------------------------------------------------------------
+
+void CPUThreadPool::WorkerThread(int thread)
+{
+	int lastJob = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobStarted.wait(lock, [&]() { return mExit || mJob != lastJob; });
+			if (mExit)  return;
+			lastJob = mJob;
+		}
+
+		RunTasks(thread);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			--mBusyWorkers;
+		}
+		mJobFinished.notify_one();
+	}
+}
+
+
+void CPUThreadPool::RunTasks(int thread)
+{
+	int task;
+	do
+	{
+		while (TakeTask(thread, task))  (*mFunction)(task, thread);
+	}
+	while (StealTasks(thread));
+}
+
+
+bool CPUThreadPool::TakeTask(int thread, int& task)
+{
+	TaskBlock& block = mBlocks[thread];
+	std::lock_guard<std::mutex> lock(block.mutex);
+	if (block.begin >= block.end)  return false;
+	task = block.begin++;
+	return true;
+}
+
+
+// Move the back half of another thread's remaining tasks into this thread's (empty) block. Returns false if no thread
+// had any tasks left
+bool CPUThreadPool::StealTasks(int thread)
+{
+	for (int offset = 1; offset < mNumThreads; ++offset)
+	{
+		TaskBlock& victim = mBlocks[(thread + offset) % mNumThreads];
+		int begin, end;
+		{
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			int remaining = victim.end - victim.begin;
+			if (remaining <= 0)  continue;
+
+			begin = victim.end - (remaining + 1) / 2;
+			end   = victim.end;
+			victim.end = begin;
+		}
+
+		// Only this thread adds to its own block, and it is empty, so no other thread can be holding on to it
+		std::lock_guard<std::mutex> lock(mBlocks[thread].mutex);
+		mBlocks[thread].begin = begin;
+		mBlocks[thread].end   = end;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------------
+// Threads shared by the CPU post-processing
+//--------------------------------------------------------------------------------------
+// A fixed set of worker threads, started once and kept waiting between jobs, so running a pass
+// doesn't pay for creating threads. A job is a number of tasks (e.g. the tiles of an image). Each
+// thread starts with its own block of neighbouring tasks, and a thread that runs out takes half
+// of what is left in another thread's block (work stealing). So threads stay busy even when some
+// tiles cost much more than others (e.g. the part of the screen an area effect covers), while
+// mostly working on tiles that are next to each other in memory
+
+#ifndef _CPU_THREAD_POOL_H_INCLUDED_
+#define _CPU_THREAD_POOL_H_INCLUDED_
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class CPUThreadPool
+{
+public:
+	//-------------------------------------
+	// Construction / Usage
+	//-------------------------------------
+
+	// Use the given number of threads, 0 for one for each processor core. The thread calling ParallelFor is one of
+	// them, so one fewer threads are started
+	CPUThreadPool(int numThreads = 0);
+	~CPUThreadPool();
+
+	CPUThreadPool(const CPUThreadPool&) = delete;
+	CPUThreadPool& operator=(const CPUThreadPool&) = delete;
+
+	int NumThreads() const  { return mNumThreads; }
+
+	// Call function(task, thread) for each task from 0 to numTasks - 1, returning when all are done. The thread index
+	// (0 to NumThreads() - 1, 0 for the calling thread) lets tasks use memory set aside for each thread. Must not be
+	// called from inside a task
+	void ParallelFor(int numTasks, const std::function<void(int task, int thread)>& function);
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	// Tasks from begin up to (not including) end that are waiting to run. The owning thread takes from the front,
+	// other threads steal from the back
+	struct TaskBlock
+	{
+		std::mutex mutex;
+		int        begin = 0;
+		int        end   = 0;
+	};
+
+	void WorkerThread(int thread);
+
+	// Run tasks until there are none left to take or steal
+	void RunTasks(int thread);
+	bool TakeTask(int thread, int& task);
+	bool StealTasks(int thread);
+
+	int                          mNumThreads;
+	std::vector<std::thread>     mThreads;
+	std::unique_ptr<TaskBlock[]> mBlocks; // One for each thread
+
+	// The current job. Workers wait for the job number to change, the caller waits for mBusyWorkers to reach 0
+	std::mutex              mMutex;
+	std::condition_variable mJobStarted;
+	std::condition_variable mJobFinished;
+	int                     mJob = 0;
+	int                     mBusyWorkers = 0;
+	bool                    mExit = false;
+	const std::function<void(int, int)>* mFunction = nullptr;
+};
+
+
+#endif //_CPU_THREAD_POOL_H_INCLUDED_
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------
+// Running chains of full screen passes one tile at a time
+//--------------------------------------------------------------------------------------
+
+#include "CPUTileFusion.h"
+#include "CVector4.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// True if the given pass can follow the one before it in a fused group
+static bool CanFuseWithPrevious(const RenderGraph& graph, int passIndex)
+{
+	const RenderPass& previous = graph.Passes()[passIndex - 1];
+	const RenderPass& pass     = graph.Passes()[passIndex];
+
+	auto isFullScreen = [](const RenderPass& p)
+	{
+		bool isDraw = p.type == RenderPassType::PostProcess || p.type == RenderPassType::ColourTransform;
+		return isDraw && p.mode == PostProcessMode::Fullscreen;
+	};
+	if (!isFullScreen(previous) || !isFullScreen(pass))  return false;
+
+	// The image between the passes must only be needed by this pass, as it is never made in full
+	const GraphResource& between = graph.Resource(previous.output);
+	if (between.type != GraphResourceType::Transient || between.lastUse != passIndex || between.sizeDivisor != 1)  return false;
+
+	// This pass must read only a known distance into it
+	if (GetPostProcessDeclaration(pass.effect).unboundedFootprint)  return false;
+
+	// Tiles are the same for every pass, so the output must be at the viewport size too
+	const GraphResource& output = graph.Resource(pass.output);
+	return output.sizeDivisor == 1;
+}
+
+
+std::vector<CPUFusedGroup> FindFusedGroups(const RenderGraph& graph)
+{
+	std::vector<CPUFusedGroup> groups;
+
+	int numPasses = static_cast<int>(graph.Passes().size());
+	int passIndex = 1;
+	while (passIndex < numPasses)
+	{
+		if (!CanFuseWithPrevious(graph, passIndex))
+		{
+			++passIndex;
+			continue;
+		}
+
+		CPUFusedGroup group;
+		group.firstPass = passIndex - 1;
+		while (passIndex < numPasses && CanFuseWithPrevious(graph, passIndex))  ++passIndex;
+		group.numPasses = passIndex - group.firstPass;
+		groups.push_back(group);
+	}
+	return groups;
+}
+
+
+void ExtendFusedLifetimes(RenderGraph& graph, const std::vector<CPUFusedGroup>& groups)
+{
+	for (const CPUFusedGroup& group : groups)
+	{
+		int lastPass = group.firstPass + group.numPasses - 1;
+		for (int passIndex = group.firstPass; passIndex < lastPass; ++passIndex)
+		{
+			for (int input : graph.Passes()[passIndex].inputs)
+			{
+				if (input >= 0)  graph.ExtendLifetime(input, lastPass);
+			}
+		}
+	}
+}
+
+
+void FusedPassRects(const RenderGraph& graph, const CPUFusedGroup& group, const PixelRect& tile,
+                    int viewportWidth, int viewportHeight, std::vector<PixelRect>& rects)
+{
+	rects.resize(group.numPasses);
+	rects[group.numPasses - 1] = ClipToViewport(tile, viewportWidth, viewportHeight);
+	for (int i = group.numPasses - 2; i >= 0; --i)
+	{
+		const RenderPass& reader = graph.Passes()[group.firstPass + i + 1];
+		rects[i] = ExpandByFootprint(rects[i + 1], GetPostProcessDeclaration(reader.effect), viewportWidth, viewportHeight);
+	}
+}
+
+
+int FusedTileSize(const RenderGraph& graph, const CPUFusedGroup& group, int viewportWidth, int viewportHeight)
+{
+	// Halo around the tile for the first pass, found by growing a single pixel in the middle of the viewport
+	std::vector<PixelRect> rects;
+	PixelRect centre = { viewportWidth / 2, viewportHeight / 2, viewportWidth / 2 + 1, viewportHeight / 2 + 1 };
+	FusedPassRects(graph, group, centre, viewportWidth, viewportHeight, rects);
+	int halo = std::max(centre.left - rects[0].left, centre.top - rects[0].top);
+
+	int imageSide = static_cast<int>(std::sqrt(CPU_TILE_CACHE_BYTES / (2.0 * sizeof(CVector4))));
+	return std::max(imageSide - 2 * halo, CPU_MIN_FUSED_TILE_SIZE);
+}
@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// Running chains of full screen passes one tile at a time
+//--------------------------------------------------------------------------------------
+// Run pass by pass, a chain of full screen effects reads and writes every pixel of the frame for
+// each effect, so the CPU spends its time waiting on memory rather than doing the maths. Instead,
+// a run of full screen passes can be "fused": the frame is split into tiles small enough that the
+// images a tile needs stay in the processor's cache, and each tile goes through the whole run
+// before moving on. The images between the passes of the run only ever exist a tile at a time.
+//
+// Effects that read around each pixel (blurs, edge detection, dilation...) need more of their input
+// than the tile they write. Working back from the last pass, each pass works out its tile grown by
+// the footprint of all the passes after it (see PostProcessDeclaration), so the pixels at the edge
+// of the tile come out just as they do when the whole image is processed.
+//
+// This file only plans the work, CPUPostProcessDevice runs it
+
+#ifndef _CPU_TILE_FUSION_H_INCLUDED_
+#define _CPU_TILE_FUSION_H_INCLUDED_
+
+#include "RenderGraph.h"
+#include "PostProcessRegion.h"
+
+#include <vector>
+
+
+// Tiles are sized so two tile images (the input and output of a pass, each with their halo) fit in this many bytes,
+// leaving room in a typical 1MB L2 cache for the full size images the group reads
+const int CPU_TILE_CACHE_BYTES = 512 * 1024;
+
+// Smallest tile side used, however large the halo. Smaller tiles would spend most of their time on the halo
+const int CPU_MIN_FUSED_TILE_SIZE = 32;
+
+
+// Consecutive passes of a compiled graph that can run together, tile by tile
+struct CPUFusedGroup
+{
+	int firstPass = 0;
+	int numPasses = 0;
+};
+
+// Find the runs of passes in the graph that can be fused. Each is at least two full screen passes at the viewport size,
+// where the image between two passes is only read by the next pass, and all but the first pass have a bounded
+// footprint. The first pass reads complete images, so can read anywhere. Passes not in a group run on their own
+std::vector<CPUFusedGroup> FindFusedGroups(const RenderGraph& graph);
+
+// Some tiles may still be reading a group's inputs after others have written their part of its output, so the images a
+// group reads must not share a target with its output. Extends their lifetimes in the graph to the end of each group
+// Call once after compiling, before allocating targets
+void ExtendFusedLifetimes(RenderGraph& graph, const std::vector<CPUFusedGroup>& groups);
+
+// The rectangle of its output each pass of the group must work out so that the last pass can write the given tile.
+// rects[i] is for the pass firstPass + i, the last is the tile itself. All are clipped to the viewport
+void FusedPassRects(const RenderGraph& graph, const CPUFusedGroup& group, const PixelRect& tile,
+                    int viewportWidth, int viewportHeight, std::vector<PixelRect>& rects);
+
+// Side of the square tiles to use for the group, see CPU_TILE_CACHE_BYTES
+int FusedTileSize(const RenderGraph& graph, const CPUFusedGroup& group, int viewportWidth, int viewportHeight);
+
+
+#endif //_CPU_TILE_FUSION_H_INCLUDED_
@@ -0,0 +1,311 @@
+//--------------------------------------------------------------------------------------
+// UV remap passes on the CPU
+//--------------------------------------------------------------------------------------
+
+#include "CPUUVRemap.h"
+#include "CPUSimd.h"
+#include "UVRemap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Bilinear gather
+//--------------------------------------------------------------------------------------
+
+void CPUGatherBilinear(const CPUImage& image, const CVector2* uvs, int count, CVector4* colours)
+{
+	int i = 0;
+
+#if defined(CPU_SIMD_SSE2)
+	// Positions and weights of four reads at a time, one read in each lane, then each read's four pixels with a whole pixel
+	// in each register
+	const PixelRect& window = image.Window();
+	const __m128 size      = _mm_set_ps(static_cast<float>(image.Height()), static_cast<float>(image.Width()),
+	                                    static_cast<float>(image.Height()), static_cast<float>(image.Width()));
+	const __m128 half      = _mm_set1_ps(0.5f);
+	const __m128 one       = _mm_set1_ps(1.0f);
+	const __m128 minusOne  = _mm_set1_ps(-1.0f);
+	const __m128 xLimits[2] = { _mm_set1_ps(static_cast<float>(window.left)), _mm_set1_ps(static_cast<float>(window.right - 1)) };
+	const __m128 yLimits[2] = { _mm_set1_ps(static_cast<float>(window.top)),  _mm_set1_ps(static_cast<float>(window.bottom - 1)) };
+	for (; i + 4 <= count; i += 4)
+	{
+		// Two UVs to a register, then split into x and y
+		__m128 uvA = _mm_loadu_ps(&uvs[i].x);
+		__m128 uvB = _mm_loadu_ps(&uvs[i + 2].x);
+		__m128 fA = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(uvA, size), half), minusOne), size);
+		__m128 fB = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(uvB, size), half), minusOne), size);
+		__m128 fx = _mm_shuffle_ps(fA, fB, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 fy = _mm_shuffle_ps(fA, fB, _MM_SHUFFLE(3, 1, 3, 1));
+
+		// A UV that isn't a number reads the first pixel (the max above has already replaced it with -1, so test the input)
+		__m128 uvX = _mm_shuffle_ps(uvA, uvB, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 uvY = _mm_shuffle_ps(uvA, uvB, _MM_SHUFFLE(3, 1, 3, 1));
+		fx = _mm_and_ps(fx, _mm_cmpord_ps(uvX, uvX));
+		fy = _mm_and_ps(fy, _mm_cmpord_ps(uvY, uvY));
+
+		// Floor from truncation, one less where that rounded up (negative values)
+		__m128 floorX = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+		__m128 floorY = _mm_cvtepi32_ps(_mm_cvttps_epi32(fy));
+		floorX = _mm_sub_ps(floorX, _mm_and_ps(_mm_cmpgt_ps(floorX, fx), one));
+		floorY = _mm_sub_ps(floorY, _mm_and_ps(_mm_cmpgt_ps(floorY, fy), one));
+
+		alignas(16) float tx[4], ty[4];
+		_mm_store_ps(tx, _mm_sub_ps(fx, floorX));
+		_mm_store_ps(ty, _mm_sub_ps(fy, floorY));
+
+		// Pixel positions limited to the window. They are whole numbers well within float precision, so limit them as floats
+		alignas(16) int x0[4], x1[4], y0[4], y1[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(x0), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(floorX, xLimits[0]), xLimits[1])));
+		_mm_store_si128(reinterpret_cast<__m128i*>(x1), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(floorX, one), xLimits[0]), xLimits[1])));
+		_mm_store_si128(reinterpret_cast<__m128i*>(y0), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(floorY, yLimits[0]), yLimits[1])));
+		_mm_store_si128(reinterpret_cast<__m128i*>(y1), _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(floorY, one), yLimits[0]), yLimits[1])));
+
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const CVector4* row0 = image.Row(y0[lane]);
+			const CVector4* row1 = image.Row(y1[lane]);
+			__m128 topLeft     = _mm_loadu_ps(&row0[x0[lane]].x);
+			__m128 topRight    = _mm_loadu_ps(&row0[x1[lane]].x);
+			__m128 bottomLeft  = _mm_loadu_ps(&row1[x0[lane]].x);
+			__m128 bottomRight = _mm_loadu_ps(&row1[x1[lane]].x);
+
+			__m128 blendX = _mm_set1_ps(tx[lane]);
+			__m128 top    = _mm_add_ps(topLeft,    _mm_mul_ps(_mm_sub_ps(topRight,    topLeft),    blendX));
+			__m128 bottom = _mm_add_ps(bottomLeft, _mm_mul_ps(_mm_sub_ps(bottomRight, bottomLeft), blendX));
+			_mm_storeu_ps(&colours[i + lane].x, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(ty[lane]))));
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		colours[i] = image.SampleBilinear(uvs[i]);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// UV remap
+//--------------------------------------------------------------------------------------
+
+// The UVs a chromatic distortion stage reads each colour channel at for the given UV - red pushed out from the centre and blue
+// pulled in, either side of the lens distortion of green. Returns which of them are on screen, a bit for each channel
+static int ChromaticUVs(const UVRemapStage& s, const CVector2& uv, CVector2* channelUVs)
+{
+	CVector2 offset = uv - s.centre;
+	float dist = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+	CVector2 direction = Normalise(offset);
+	CVector2 uvDistorted = s.centre + direction * (dist * (1.0f + s.amount * dist * dist));
+	CVector2 aberration = direction * (s.chromAb * dist);
+	channelUVs[0] = uvDistorted + aberration;
+	channelUVs[1] = uvDistorted;
+	channelUVs[2] = uvDistorted - aberration;
+
+	int onScreen = 0;
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		const CVector2& channelUV = channelUVs[channel];
+		if (channelUV.x >= 0.0f && channelUV.x <= 1.0f && channelUV.y >= 0.0f && channelUV.y <= 1.0f)  onScreen |= 1 << channel;
+	}
+	return onScreen;
+}
+
+
+// Move a row of UVs back through one stage as UVRemap_pp.hlsl does, for one colour channel (0-2) or for all three together
+// (-1). The fake lighting of a distort stage is written to the channel's part of the stage's row of lights, or all three parts.
+// A channel a chromatic distortion stage reads off screen is black up to that stage, the first such stage found being kept in
+// startStages (0 for none)
+static void StepBackRow(const UVRemapConstants& constants, const CPUPassContext& context, int stage, int channel,
+                        const CVector2& edgeMin, const CVector2& edgeMax, int count, CVector2* uvs, CVector3* lights, int* startStages)
+{
+	const UVRemapStage& s = constants.stages[stage];
+	float timer = context.passConstants.timer;
+	switch (static_cast<UVRemapKind>(s.kind))
+	{
+	case UVRemapKind::Distort:
+		for (int i = 0; i < count; ++i)
+		{
+			CVector4 distortTexture = context.maps.distortMap->SampleBilinearWrap(uvs[i]);
+			CVector2 distortVector = CVector2(distortTexture.y, distortTexture.z) - CVector2(0.5f, 0.5f);
+			CVector2 direction = Normalise(distortVector);
+			float light = (direction.x * 0.707f + direction.y * 0.707f) * UV_REMAP_DISTORT_LIGHT;
+			if (channel < 0)  lights[i] = { light, light, light };
+			else              (&lights[i].x)[channel] = light;
+			uvs[i] = uvs[i] + distortVector * s.amount;
+		}
+		break;
+
+	case UVRemapKind::Spiral:
+		for (int i = 0; i < count; ++i)
+		{
+			CVector2 centreOffsetUV = uvs[i] - s.centre;
+			float angle = std::sqrt(centreOffsetUV.x * centreOffsetUV.x + centreOffsetUV.y * centreOffsetUV.y) * s.amount;
+			float sn = std::sin(angle);
+			float cs = std::cos(angle);
+			uvs[i] = s.centre + CVector2(centreOffsetUV.x * cs - centreOffsetUV.y * sn, centreOffsetUV.x * sn + centreOffsetUV.y * cs);
+		}
+		break;
+
+	case UVRemapKind::HeatHaze:
+		for (int i = 0; i < count; ++i)
+		{
+			CVector2 centreVector = uvs[i] - CVector2(0.5f, 0.5f);
+			float centreLengthSq = centreVector.x * centreVector.x + centreVector.y * centreVector.y;
+			float alpha = 1.0f - std::min(std::max((centreLengthSq - 0.25f + 0.15f) / 0.15f, 0.0f), 1.0f);
+			float SinX = std::sin(uvs[i].x * ToRadians(1440.0f) + timer * 3.0f);
+			float SinY = std::sin(uvs[i].y * ToRadians(3600.0f) + timer * 3.7f);
+			uvs[i] = uvs[i] + CVector2(SinY, SinX) * (s.amount * alpha);
+		}
+		break;
+
+	case UVRemapKind::Underwater:
+		for (int i = 0; i < count; ++i)
+		{
+			CVector2 offset = { std::sin(uvs[i].x * ToRadians(360.0f) + timer * 3.0f), std::cos(uvs[i].y * ToRadians(360.0f) + timer * 3.0f) };
+			uvs[i] = uvs[i] + offset * s.amount;
+		}
+		break;
+
+	case UVRemapKind::ChromaticDistortion:
+		for (int i = 0; i < count; ++i)
+		{
+			CVector2 channelUVs[3];
+			int onScreen = ChromaticUVs(s, uvs[i], channelUVs);
+			uvs[i] = channelUVs[std::max(channel, 0)];
+			if ((onScreen & (1 << std::max(channel, 0))) == 0 && startStages[i] == 0)  startStages[i] = stage + 1;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// The effect before drew whole pixels, so a read past the edge got the edge pixel
+	for (int i = 0; i < count; ++i)
+	{
+		uvs[i] = { std::min(std::max(uvs[i].x, edgeMin.x), edgeMax.x), std::min(std::max(uvs[i].y, edgeMin.y), edgeMax.y) };
+	}
+}
+
+
+void CPUUVRemap(const UVRemapConstants& constants, TargetFormat stageFormat, const CPUPassContext& context, CPUImage& target)
+{
+	const CPUImage* input = context.inputs[0];
+	int numStages = std::min(constants.numStages, MAX_UV_REMAP_EFFECTS);
+	if (numStages < 1)  return;
+
+	CPUPassContext drawContext = WithFallbackMaps(context);
+	int width  = target.Width();
+	int height = target.Height();
+	CVector2 edgeMin = { 0.5f / width, 0.5f / height };
+	CVector2 edgeMax = { 1.0f - edgeMin.x, 1.0f - edgeMin.y };
+
+	// The channels move together back through the stages after the last chromatic distortion stage, if there is one
+	int splitStage = numStages - 1;
+	while (splitStage >= 0 && constants.stages[splitStage].kind != static_cast<int>(UVRemapKind::ChromaticDistortion))  --splitStage;
+
+	PixelRect targetRect = { 0, 0, width, height };
+	ForEachTile(targetRect, context.threadPool, [&](const PixelRect& tile)
+	{
+		// Each row is taken through one stage at a time. UVs, reads and start stages have a row for each channel, lights a row
+		// for each stage
+		int count = tile.right - tile.left;
+		std::vector<CVector2> uvs(count * 3);
+		std::vector<CVector4> reads(count * 3);
+		std::vector<int>      startStages(count * 3);
+		std::vector<CVector3> lights(count * numStages);
+		std::vector<CVector4> rowBuffer(count);
+		for (int y = tile.top; y < tile.bottom; ++y)
+		{
+			std::fill(startStages.begin(), startStages.end(), 0);
+			for (int i = 0; i < count; ++i)  uvs[i] = { (tile.left + i + 0.5f) / width, (y + 0.5f) / height };
+
+			for (int stage = numStages - 1; stage > splitStage; --stage)
+			{
+				StepBackRow(constants, drawContext, stage, -1, edgeMin, edgeMax, count, uvs.data(), &lights[stage * count], startStages.data());
+			}
+
+			// From a chromatic distortion stage on, each channel is followed on its own
+			int numChannels = 1;
+			if (splitStage >= 0)
+			{
+				// The split itself is worked out once for all three
+				numChannels = 3;
+				for (int i = 0; i < count; ++i)
+				{
+					CVector2 channelUVs[3];
+					int onScreen = ChromaticUVs(constants.stages[splitStage], uvs[i], channelUVs);
+					for (int channel = 0; channel < 3; ++channel)
+					{
+						uvs[channel * count + i] = { std::min(std::max(channelUVs[channel].x, edgeMin.x), edgeMax.x),
+						                             std::min(std::max(channelUVs[channel].y, edgeMin.y), edgeMax.y) };
+						if ((onScreen & (1 << channel)) == 0)  startStages[channel * count + i] = splitStage + 1;
+					}
+				}
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					for (int stage = splitStage - 1; stage >= 0; --stage)
+					{
+						StepBackRow(constants, drawContext, stage, channel, edgeMin, edgeMax, count, &uvs[channel * count],
+						            &lights[stage * count], &startStages[channel * count]);
+					}
+				}
+			}
+
+			// One read for each channel followed. A missing input reads as black
+			for (int channel = 0; channel < numChannels; ++channel)
+			{
+				CVector4* channelReads = &reads[channel * count];
+				if (input)  CPUGatherBilinear(*input, &uvs[channel * count], count, channelReads);
+				else        std::fill(channelReads, channelReads + count, CVector4(0.0f, 0.0f, 0.0f, 0.0f));
+			}
+			for (int i = 0; i < count; ++i)
+			{
+				if (numChannels == 1)
+				{
+					rowBuffer[i] = CVector4(reads[i].x, reads[i].y, reads[i].z, 1.0f);
+				}
+				else
+				{
+					rowBuffer[i] = CVector4(startStages[i]             == 0 ? reads[i].x             : 0.0f,
+					                        startStages[count + i]     == 0 ? reads[count + i].y     : 0.0f,
+					                        startStages[count * 2 + i] == 0 ? reads[count * 2 + i].z : 0.0f, 1.0f);
+				}
+			}
+
+			// Forward through the stages' changes to the colour, rounding between them as the targets did. A channel is black
+			// up to the stage it starts at
+			for (int stage = 0; stage < numStages; ++stage)
+			{
+				UVRemapKind kind = static_cast<UVRemapKind>(constants.stages[stage].kind);
+				if (kind == UVRemapKind::Distort)
+				{
+					const CVector3* stageLights = &lights[stage * count];
+					for (int i = 0; i < count; ++i)
+					{
+						CVector4& colour = rowBuffer[i];
+						colour = CVector4(colour.x * UV_REMAP_DISTORT_DARKEN + stageLights[i].x, colour.y * UV_REMAP_DISTORT_DARKEN + stageLights[i].y,
+						                  colour.z * UV_REMAP_DISTORT_DARKEN + stageLights[i].z, 1.0f);
+					}
+				}
+				else if (kind == UVRemapKind::Underwater)
+				{
+					for (int i = 0; i < count; ++i)  rowBuffer[i] = CVector4(0.0f, rowBuffer[i].y * 0.3f, rowBuffer[i].z * 0.6f, 1.0f);
+				}
+				if (numChannels == 3)
+				{
+					for (int i = 0; i < count; ++i)
+					{
+						if (stage < startStages[i])              rowBuffer[i].x = 0.0f;
+						if (stage < startStages[count + i])      rowBuffer[i].y = 0.0f;
+						if (stage < startStages[count * 2 + i])  rowBuffer[i].z = 0.0f;
+					}
+				}
+				if (stage < numStages - 1)  RoundToFormat(rowBuffer.data(), rowBuffer.data(), count, stageFormat);
+			}
+			target.Store(tile.left, y, rowBuffer.data(), count);
+		}
+	});
+}
@@ -0,0 +1,26 @@
+//--------------------------------------------------------------------------------------
+// UV remap passes on the CPU
+//--------------------------------------------------------------------------------------
+// The CPU version of UVRemap_pp.hlsl, running several distortions as one (see UVRemap.h). Each
+// pixel's UV is followed back through the stages one pixel at a time - it is mostly sines and
+// square roots. The one bilinear read of each row is then done four UVs at a time with SSE (see
+// CPUSimd.h), the plain C++ version giving the same results. Rows of the target are shared between
+// the threads of the pass's pool
+
+#ifndef _CPU_UV_REMAP_H_INCLUDED_
+#define _CPU_UV_REMAP_H_INCLUDED_
+
+#include "CPUImage.h"
+#include "CPUPostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Read the image with bilinear filtering at each of the given UVs, exactly as CPUImage::SampleBilinear
+void CPUGatherBilinear(const CPUImage& image, const CVector2* uvs, int count, CVector4* colours);
+
+// Run a UV remap pass over the whole target. The result of each stage but the last is rounded to the given format, that of
+// the targets between the effects the pass stands in for. Input 0 must be the same size as the target
+void CPUUVRemap(const UVRemapConstants& constants, TargetFormat stageFormat, const CPUPassContext& context, CPUImage& target);
+
+
+#endif //_CPU_UV_REMAP_H_INCLUDED_
@@ -57,6 +57,13 @@ public:
 	CMatrix4x4 ProjectionMatrix()      { UpdateMatrices(); return mProjectionMatrix;     }
 	CMatrix4x4 ViewProjectionMatrix()  { UpdateMatrices(); return mViewProjectionMatrix; }
 
+	// The view-projection matrix of the last frame, used to find how far each pixel moved (see Velocity_vs.hlsl).
+	// The same as the current matrix until EndFrame has been called
+	CMatrix4x4 PreviousViewProjectionMatrix()  { return mHasPreviousFrame ? mPreviousViewProjectionMatrix : ViewProjectionMatrix(); }
+
+	// Call when the frame has been rendered, keeps the current view-projection matrix as the previous one for the next frame
+	void EndFrame()  { mPreviousViewProjectionMatrix = ViewProjectionMatrix(); mHasPreviousFrame = true; }
+
 
 	//-------------------------------------
 	// Camera Picking
@@ -100,6 +107,9 @@ private:
 	CMatrix4x4 mProjectionMatrix;     // Projection matrix holds the field of view and near/far clip distances
 	CMatrix4x4 mViewProjectionMatrix; // Combine (multiply) the view and projection matrices together, which
 	                                  // can sometimes save a matrix multiply in the shader (optional)
+
+	CMatrix4x4 mPreviousViewProjectionMatrix; // View-projection matrix of the last frame, see EndFrame
+	bool       mHasPreviousFrame = false;
 };
 
 
@@ -5,6 +5,19 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match ChromaticDistortionConstants in PostProcessConstants.h
+cbuffer ChromaticDistortionConstants : register(b2)
+{
+	float  gChromAbAmount;
+	float  gDistortionAmount;
+	float2 gScreenCenter;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures & Samplers
 //--------------------------------------------------------------------------------------
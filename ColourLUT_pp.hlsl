@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// Colour LUT Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Runs a pure colour effect from a 3D LUT baked from it (see CPUColourLUT.h): one trilinear fetch
+// per pixel in place of the effect's own maths
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Must match ColourLUTConstants in PostProcessConstants.h
+cbuffer ColourLUTConstants : register(b2)
+{
+	float  gLUTScale;  // Maps colours 0->1 to the UVWs of the centres of the first and last texels
+	float  gLUTOffset;
+	float2 paddingA;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SceneTexture : register(t0);
+SamplerState PointSample  : register(s0); // No filtering of the scene texture
+
+Texture3D    ColourLUT    : register(t1);
+SamplerState LUTSampler   : register(s1); // Trilinear, blends the eight entries around the colour
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float3 colour = saturate(SceneTexture.Sample(PointSample, input.sceneUV).rgb);
+	float3 lutUVW = colour * gLUTScale + gLUTOffset;
+	return float4(ColourLUT.SampleLevel(LUTSampler, lutUVW, 0).rgb, 1.0f);
+}
@@ -0,0 +1,157 @@
+//--------------------------------------------------------------------------------------
+// Combining runs of full screen colour effects into one pass
+//--------------------------------------------------------------------------------------
+
+#include "ColourTransform.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//--------------------------------------------------------------------------------------
+// Colour steps
+//--------------------------------------------------------------------------------------
+
+static ColourStep UniformStep(const CVector4& red, const CVector4& green, const CVector4& blue)
+{
+	return { { red, green, blue }, { red, green, blue } };
+}
+
+static ColourStep IdentityStep()
+{
+	return UniformStep({ 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 });
+}
+
+
+// Matrices as used in the shaders of each effect
+ColourStep GetColourStep(PostProcess postProcess, const PostProcessEffectConstants& settings)
+{
+	switch (postProcess)
+	{
+	case PostProcess::Tint:
+	{
+		const CVector3& tint = settings.tint.tintColour;
+		return UniformStep({ tint.x, 0, 0, 0 }, { 0, tint.y, 0, 0 }, { 0, 0, tint.z, 0 });
+	}
+
+	case PostProcess::Invert:
+		return UniformStep({ -1, 0, 0, 1 }, { 0, -1, 0, 1 }, { 0, 0, -1, 1 });
+
+	case PostProcess::Sepia:
+		return UniformStep({ 0.393f, 0.769f, 0.189f, 0 }, { 0.349f, 0.686f, 0.168f, 0 }, { 0.272f, 0.534f, 0.131f, 0 });
+
+	case PostProcess::VerticalGradient:
+	case PostProcess::HueVerticalGradient:
+	{
+		// Scene colour times the gradient colour, which is lerped down the screen
+		const CVector3& top    = settings.verticalGradient.topColour;
+		const CVector3& bottom = settings.verticalGradient.bottomColour;
+		ColourStep step;
+		step.top[0]    = { top.x, 0, 0, 0 };     step.top[1]    = { 0, top.y, 0, 0 };     step.top[2]    = { 0, 0, top.z, 0 };
+		step.bottom[0] = { bottom.x, 0, 0, 0 };  step.bottom[1] = { 0, bottom.y, 0, 0 };  step.bottom[2] = { 0, 0, bottom.z, 0 };
+		return step;
+	}
+
+	default: // Copy
+		return IdentityStep();
+	}
+}
+
+
+// Rows for the result of applying first then second
+static void CombineRows(const CVector4 second[3], const CVector4 first[3], CVector4 result[3])
+{
+	for (int row = 0; row < 3; ++row)
+	{
+		const CVector4& s = second[row];
+		result[row].x = s.x * first[0].x + s.y * first[1].x + s.z * first[2].x;
+		result[row].y = s.x * first[0].y + s.y * first[1].y + s.z * first[2].y;
+		result[row].z = s.x * first[0].z + s.y * first[1].z + s.z * first[2].z;
+		result[row].w = s.x * first[0].w + s.y * first[1].w + s.z * first[2].w + s.w;
+	}
+}
+
+static ColourStep CombineSteps(const ColourStep& second, const ColourStep& first)
+{
+	ColourStep result;
+	CombineRows(second.top,    first.top,    result.top);
+	CombineRows(second.bottom, first.bottom, result.bottom);
+	return result;
+}
+
+
+// True if, for every 8-bit colour, the rows give results that an 8-bit target would store unchanged: within 0->1 and a
+// whole number of 1/255 steps. So integer weights and offsets of whole steps, with each row's smallest result (channels
+// with negative weights at 1, others at 0) and largest (the other way round) in 0->1
+static bool KeepsEightBitColours(const CVector4 rows[3])
+{
+	const float Tolerance = 1e-5f;
+	auto isWhole = [&](float value) { return std::fabs(value - std::round(value)) < Tolerance; };
+	for (int row = 0; row < 3; ++row)
+	{
+		const CVector4& r = rows[row];
+		if (!isWhole(r.x) || !isWhole(r.y) || !isWhole(r.z) || !isWhole(r.w * 255.0f))  return false;
+
+		float lowest  = r.w + std::min(r.x, 0.0f) + std::min(r.y, 0.0f) + std::min(r.z, 0.0f);
+		float highest = r.w + std::max(r.x, 0.0f) + std::max(r.y, 0.0f) + std::max(r.z, 0.0f);
+		if (lowest < -Tolerance || highest > 1.0f + Tolerance)  return false;
+	}
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Building a transform
+//--------------------------------------------------------------------------------------
+
+// Steps whose results an 8-bit target always stores unchanged, the same at the top and bottom of the screen
+static bool IsExactStep(const ColourStep& step)
+{
+	for (int row = 0; row < 3; ++row)
+	{
+		const CVector4& top    = step.top[row];
+		const CVector4& bottom = step.bottom[row];
+		if (top.x != bottom.x || top.y != bottom.y || top.z != bottom.z || top.w != bottom.w)  return false;
+	}
+	return KeepsEightBitColours(step.top);
+}
+
+
+ColourTransformConstants BuildColourTransform(const PostProcessChain& chain, int firstIndex, int count, const PostProcessEffectConstants& settings)
+{
+	ColourTransformConstants constants = {};
+
+	auto addStage = [&](const ColourStep& stage)
+	{
+		CVector4* rows = &constants.stageRows[constants.numStages * 3];
+		for (int row = 0; row < 3; ++row)
+		{
+			rows[row] = stage.top[row];
+			constants.lastStageBottom[row] = stage.bottom[row]; // Only kept from the last stage
+		}
+		++constants.numStages;
+	};
+
+	// Exact steps in a row are combined into one stage. Any other step is a stage of its own, using the effect's own
+	// matrix so its sums are done just as the effect's shader does them
+	ColourStep exactSteps = IdentityStep();
+	bool haveExactSteps = false;
+	for (int i = 0; i < count; ++i)
+	{
+		ColourStep step = GetColourStep(chain[firstIndex + i].first, settings);
+		if (IsExactStep(step))
+		{
+			exactSteps = CombineSteps(step, exactSteps);
+			haveExactSteps = true;
+			continue;
+		}
+
+		if (haveExactSteps)  addStage(exactSteps);
+		exactSteps = IdentityStep();
+		haveExactSteps = false;
+		addStage(step);
+	}
+	if (haveExactSteps)  addStage(exactSteps);
+
+	return constants;
+}
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------------------
+// Combining runs of full screen colour effects into one pass
+//--------------------------------------------------------------------------------------
+// Effects such as tint, invert and sepia only change the colour of each pixel on its own, and each
+// is just a matrix applied to (red, green, blue, 1). Running several in a row reads and writes the
+// whole screen once for every effect. The render graph makes a single ColourTransform pass for
+// each such run instead, which reads each pixel once and does all the maths in registers.
+//
+// Multiplying all the matrices together isn't quite the same as running the effects one by one:
+// between effects the image is stored in an 8-bit target, which clamps every channel to 0->1 and
+// rounds it to the nearest 1/255. Sepia turns white into (1.35, 1.20, 0.94), so a tint after it
+// sees 1.0 where the combined matrix would give it 1.35. And rounding errors grow when a later
+// effect brightens the image, enough to be several 8-bit steps off after a few effects. Baking the
+// run into a 3D LUT doesn't help either - filtering rounds off the corners a clamp makes, and
+// even a 65x65x65 LUT is out by more than one 8-bit step in places.
+//
+// So the pass applies the effects as a short list of stages. Each stage is one matrix, and the
+// stage's result is clamped and rounded just as the target between the effects would do it.
+// Effects in a row are only combined into one stage when the target would not change their
+// results at all: results that are always whole 8-bit steps within 0->1, which is the case for
+// copy, invert and tints of 0 or 1 (e.g. the red tint). Every other effect is a stage of its own
+// with the matrix its shader uses, so the pass gives the same result as running the effects one
+// by one - it only saves the reads and writes between them.
+//
+// Vertical gradients are a matrix that changes down the screen. The last stage has a top and a
+// bottom matrix to lerp between, so the render graph ends a run at a gradient.
+//
+// Colour effects that aren't affine (the bright pass's soft threshold, the colour grading in night
+// vision, which is tied to its offset samples and noise) are not included.
+//
+// No DirectX here - Scene.cpp sends the constants to ColourTransform_pp.hlsl, CPUPostProcess.h has
+// the CPU version
+
+#ifndef _COLOUR_TRANSFORM_H_INCLUDED_
+#define _COLOUR_TRANSFORM_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "PostProcessConstants.h"
+#include "CVector4.h"
+
+
+// The colour change made by one effect: rows giving the new red, green and blue as dot(row, (colour, 1))
+// For vertical gradients top is used at the top of the screen and bottom at the bottom, lerped in between. For all
+// other effects they are the same
+struct ColourStep
+{
+	CVector4 top[3];
+	CVector4 bottom[3];
+};
+
+// The colour step of an effect whose declaration has a colourTransform, using the given settings. Must agree with the
+// effect's shader
+ColourStep GetColourStep(PostProcess postProcess, const PostProcessEffectConstants& settings);
+
+
+// Work out the stages for the given entries of the chain, all of which must have a colourTransform, and at most
+// MAX_COLOUR_TRANSFORM_EFFECTS of them. Only the last may be a vertical gradient
+ColourTransformConstants BuildColourTransform(const PostProcessChain& chain, int firstIndex, int count, const PostProcessEffectConstants& settings);
+
+
+#endif //_COLOUR_TRANSFORM_H_INCLUDED_
@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// Colour Transform Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Several colour effects in a row (tint, invert, sepia, vertical gradient...) run as one. Each
+// stage applies a matrix to the colour, then rounds it as the 8-bit target between the effects
+// would have. See ColourTransform.h for how the effects are split into stages
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Must match MAX_COLOUR_TRANSFORM_EFFECTS in PostProcess.h
+static const int MaxStages = 6;
+
+// Must match ColourTransformConstants in PostProcessConstants.h
+cbuffer ColourTransformConstants : register(b2)
+{
+	float4 gStageRows[MaxStages * 3]; // Rows of each stage's matrix, giving the new red, green and blue from float4(colour, 1)
+	float4 gLastStageBottom[3];       // Rows of the last stage at the bottom of the screen
+	int    gNumStages;
+	float3 paddingA;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SceneTexture : register(t0);
+SamplerState PointSample  : register(s0); // No filtering of the scene texture
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float3 ApplyRows(float4 red, float4 green, float4 blue, float3 colour)
+{
+	float4 colourIn = float4(colour, 1.0f);
+	return float3(dot(red, colourIn), dot(green, colourIn), dot(blue, colourIn));
+}
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float3 colour = SceneTexture.Sample(PointSample, input.sceneUV).rgb;
+
+	int lastStage = (gNumStages - 1) * 3;
+	for (int stage = 0; stage < lastStage; stage += 3)
+	{
+		colour = ApplyRows(gStageRows[stage], gStageRows[stage + 1], gStageRows[stage + 2], colour);
+
+		// Clamp and round to 8 bits, as writing to the target between the effects did
+		colour = floor(saturate(colour) * 255.0f + 0.5f) / 255.0f;
+	}
+
+	// The last stage blends between its top and bottom matrices going down the screen
+	float3 top    = ApplyRows(gStageRows[lastStage], gStageRows[lastStage + 1], gStageRows[lastStage + 2], colour);
+	float3 bottom = ApplyRows(gLastStageBottom[0],   gLastStageBottom[1],       gLastStageBottom[2],       colour);
+	return float4(lerp(top, bottom, saturate(input.areaUV.y)), 1.0f);
+}
@@ -7,8 +7,9 @@
 #include "CVector2.h"
 #include "CVector3.h"
 #include "CMatrix4x4.h"
+#include "PostProcessConstants.h"
 
-#include <d3d11.h>
+#include <d3d11_1.h>
 #include <string>
 
 
@@ -31,6 +32,7 @@ extern int gViewportHeight;
 // Important DirectX variables
 extern ID3D11Device*           gD3DDevice;
 extern ID3D11DeviceContext*    gD3DContext;
+extern ID3D11DeviceContext1*   gD3DContext1; // DirectX 11.1 interface to the same context, needed to bind parts of a constant buffer
 
 extern IDXGISwapChain*           gSwapChain;
 extern ID3D11RenderTargetView*   gBackBufferRenderTarget; // Back buffer is where we render to
@@ -81,10 +83,11 @@ struct PerFrameConstants
 
     CVector3   cameraPosition;
 	float      padding3;
+
+    CMatrix4x4 previousViewProjectionMatrix; // The view-projection matrix of the last frame, for the velocity pass (see RenderGraph.h)
 };
 
-extern PerFrameConstants gPerFrameConstants;      // This variable holds the CPU-side constant buffer described above
-extern ID3D11Buffer*     gPerFrameConstantBuffer; // This variable controls the GPU-side constant buffer matching to the above structure
+extern PerFrameConstants gPerFrameConstants; // This variable holds the CPU-side constant buffer described above, uploaded with gConstantUploader (GraphicsHelpers.h)
 
 
 
@@ -99,140 +102,32 @@ struct PerModelConstants
     CVector3   objectColour;  // Allows each light model to be tinted to match the light colour they cast
 	float      explodeAmount; // Used in the geometry shader to control how much the polygons are exploded outwards
 
+    CMatrix4x4 previousWorldMatrix; // Where the model was last frame, for the velocity pass
+};
+extern PerModelConstants gPerModelConstants; // This variable holds the CPU-side constant buffer described above, uploaded with gConstantUploader (GraphicsHelpers.h)
+
+// The bone matrices of a skinned mesh. These are kept apart from the structure above because they are large (4KB) and
+// only skinned meshes need them - rigid meshes only send the small structure above for each node
+struct PerSkeletonConstants
+{
 	CMatrix4x4 boneMatrices[MAX_BONES];
 };
-extern PerModelConstants gPerModelConstants;      // This variable holds the CPU-side constant buffer described above
-extern ID3D11Buffer*     gPerModelConstantBuffer; // This variable controls the GPU-side constant buffer related to the above structure
+extern PerSkeletonConstants gPerSkeletonConstants; // --"--
+
+// Models drawn with instancing don't use the per-model constants, instead the world matrix and tint of each copy are
+// in this structured buffer (see InstanceBatch.h)
+extern ID3D11Buffer*             gMeshInstanceBuffer;
+extern ID3D11ShaderResourceView* gMeshInstanceSRV;
 
 
 
 
 //**************************
 
-// Settings used by post-processes - must match the similar structure in the Common.hlsli shader file
-struct PostProcessingConstants
-{
-	CVector2 area2DTopLeft; // Top-left of post-process area on screen, provided as coordinate from 0.0->1.0 not as a pixel coordinate
-	CVector2 area2DSize;    // Size of post-process area on screen, provided as sizes from 0.0->1.0 (1 = full screen) not as a size in pixels
-	float    area2DDepth;   // Depth buffer value for area (0.0 nearest to 1.0 furthest). Full screen post-processing uses 0.0f
-	CVector3 paddingA;      // Pad things to collections of 4 floats (see notes in earlier labs to read about padding)
-
-	CVector4 polygon2DPoints[4]; // Four points of a polygon in 2D viewport space for polygon post-processing. Matrix transformations already done on C++ side
-
-	// Tint post-process settings
-	CVector3 tintColour;
-	float    paddingB;
-
-	// Grey noise post-process settings
-    CVector2 noiseScale;
-	CVector2 noiseOffset;
-
-	// Burn post-process settings
-	float    burnHeight;
-	CVector3 paddingC;
-
-	// Distort post-process settings
-	float    distortLevel;
-	CVector3 paddingD;
-
-	// Spiral post-process settings
-	float    spiralLevel;
-	CVector3 paddingE;
-
-	// Heat haze post-process settings
-	float    timer;
-	CVector3 paddingF;
-
-	// Vertical gradient post-process settings
-	CVector3 topColour;
-	float    paddingG;
-
-	CVector3 bottomColour;
-	float    paddingH;
-
-	// Gaussian blur post-process pass settings
-	CVector2 texelSize;
-	float	 blurStrength;
-	float	 paddingI;
-
-	// Underwater post-process pass settings
-	float	 frequency;
-	float	 amplitude;
-	CVector2 paddingJ;
-
-	// Depth of Field post-process pass settings
-	float	 focalDistance;
-	float	 aperture;
-	float	 nearClip;
-	float	 farClip;
-
-	// Motion blur post-process pass settings
-	float	 blendFactor;
-	CVector3 paddingK;
-
-	// Retro game post-process pass settings
-	float	 pixelSize;
-	int		 paletteSize;
-	CVector2 paddingL;
-
-	// Bright pass post-process pass settings
-	float	 bloomThreshold;
-	float	 exposure;
-	float	 bloomKnee;
-	float	 paddingM;
-
-	// Lens star post-process pass settings
-	float	 stepSize;
-	float	 attenuation;
-	CVector2 paddingN;
-
-	// Bloom post-process pass settings
-	float	 bloomIntensity;
-	float	 starIntensity;
-	CVector2 paddingO;
-
-	// Fog post-process pass settings
-	CVector3 fogColour;
-	float    fogDensity;
-	float    fogHeightStart;
-	float    fogHeightDensity;
-	CVector2 paddingP;
-
-	// Game boy post-process pass settings
-	CVector3 gameBoyColour;
-	float    gameBoyPixelSize;
-	float    gameBoyColourDepth;
-	CVector3 paddingQ;
-
-	// Night vision post-process pass settings
-	CVector3 nightVisionTint;
-	float	 noiseIntensity;
-	float	 vignetteIntensity;
-	float	 flickerIntensity;
-	CVector2 paddingR;
-
-	CVector3 brightnessBoost;
-	float    luminanceThreshold;
-	float    intensity;
-	CVector3 paddingS;
-
-	// Chromatic aberration & distortion post-process pass settings
-	float    chromAbAmount;
-	float    distortionAmount;
-	CVector2 screenCenter;
-
-	// Wireframe post-process pass settings
-	float	 edgeThreshold;
-	float	 edgePower;
-	CVector2 paddingT;
-
-	// Dilation post-process pass settings
-	int		 kernelRadius;
-	CVector3 paddingU;
-	
-};
-extern PostProcessingConstants gPostProcessingConstants;      // This variable holds the CPU-side constant buffer described above
-extern ID3D11Buffer*           gPostProcessingConstantBuffer; // This variable controls the GPU-side constant buffer related to the above structure
+// Settings used by post-processes are split into a block shared by every pass and a small block for each effect, see
+// PostProcessConstants.h. The blocks are written one after another into a single buffer (see ConstantUpload.h)
+extern PostProcessPassConstants   gPostProcessPassConstants;   // The CPU-side pass constants, updated for each pass
+extern PostProcessEffectConstants gPostProcessEffectConstants; // The CPU-side settings of every effect
 
 //**************************
 
@@ -37,6 +37,26 @@ struct LightingPixelShaderInput
 };
 
 
+// Models drawn with instancing (PixelLightingInstanced_vs) read the world matrix and tint of each copy from a structured buffer
+// Must match the MeshInstance structure in InstanceBatch.h
+struct MeshInstance
+{
+    float4x4 worldMatrix;
+    float3   tint;
+    float    padding;
+};
+
+// Same as LightingPixelShaderInput, plus the tint of the copy being drawn
+struct InstancedLightingPixelShaderInput
+{
+    float4 projectedPosition : SV_Position;
+    float3 worldPosition     : worldPosition;
+    float3 worldNormal       : worldNormal;
+    float2 uv                : uv;
+    nointerpolation float3 tint : tint;
+};
+
+
 // This structure is similar to the one above but for the light models, which aren't themselves lit
 struct SimplePixelShaderInput
 {
@@ -45,6 +65,15 @@ struct SimplePixelShaderInput
 };
 
 
+// The velocity pass only needs where each vertex is on screen this frame and where it was last frame (see Velocity_vs.hlsl)
+struct VelocityPixelShaderInput
+{
+    float4 projectedPosition : SV_Position;
+    float4 currentPosition   : currentPosition;  // Same as the projected position, but still in projection space
+    float4 previousPosition  : previousPosition; // Where the vertex was in projection space last frame
+};
+
+
 
 //**************************
 
@@ -57,6 +86,26 @@ struct PostProcessingInput
 	float2 areaUV                : areaUV;
 };
 
+
+// Batched polygon post-processing draws many polygons in one go, each with its own effect (see 2DPolygonBatch_pp.hlsl)
+// Each polygon is one element of a structured buffer. Must match the PolygonInstance structure in PolygonBatch.h
+struct PolygonInstance
+{
+	float4 points[4];     // Four points of the polygon in 2D viewport space, as gPolygon2DPoints below
+	int    effect;        // Which effect to apply, see PolygonBatch_pp.hlsl
+	int3   padding;
+	float4 parameters[2]; // Effect settings, layout depends on the effect
+};
+
+// Same as PostProcessingInput, plus the polygon being drawn so the pixel shader can find its effect and settings
+struct PolygonBatchInput
+{
+	float4 projectedPosition     : SV_Position;
+	noperspective float2 sceneUV : sceneUV;
+	float2 areaUV                : areaUV;
+	nointerpolation uint polygon : polygon;
+};
+
 //**************************
 
 
@@ -93,6 +142,8 @@ cbuffer PerFrameConstants : register(b0) // The b0 gives this constant buffer th
 
     float3   gCameraPosition;
     float    padding3;
+
+    float4x4 gPreviousViewProjectionMatrix; // The view-projection matrix of the last frame, for the velocity pass
 }
 // Note constant buffers are not structs: we don't use the name of the constant buffer, these are really just a collection of global variables (hence the 'g')
 
@@ -111,6 +162,13 @@ cbuffer PerModelConstants : register(b1) // The b1 gives this constant buffer th
     float3   gObjectColour;  // Useed for tinting light models
 	float    gExplodeAmount; // Used in the geometry shader to control how much the polygons are exploded outwards
 
+    float4x4 gPreviousWorldMatrix; // Where the model was last frame, for the velocity pass
+}
+
+// Bone matrices for skinned meshes, only sent and bound when rendering a skinned mesh
+// These variables must match exactly the gPerSkeletonConstants structure in Scene.cpp
+cbuffer PerSkeletonConstants : register(b2)
+{
 	float4x4 gBoneMatrices[MAX_BONES];
 }
 
@@ -118,130 +176,33 @@ cbuffer PerModelConstants : register(b1) // The b1 gives this constant buffer th
 //**************************
 
 // This is where we receive post-processing settings from the C++ side
-// These variables must match exactly the gPostProcessingConstants structure in Scene.cpp
+// These variables must match exactly the PostProcessPassConstants structure in PostProcessConstants.h
 // Note that this buffer reuses the same index (register) as the per-model buffer above since they won't be used together
-cbuffer PostProcessingConstants : register(b1) 
+// The settings of each effect are in a separate buffer at register b2 (like the skeleton buffer), declared in that effect's shader
+cbuffer PostProcessPassConstants : register(b1) 
 {
 	float2 gArea2DTopLeft; // Top-left of post-process area on screen, provided as coordinate from 0.0->1.0 not as a pixel coordinate
 	float2 gArea2DSize;    // Size of post-process area on screen, provided as sizes from 0.0->1.0 (1 = full screen) not as a size in pixels
-	float  gArea2DDepth;   // Depth buffer value for area (0.0 nearest to 1.0 furthest). Full screen post-processing uses 0.0f
-	float3 paddingA;       // Pad things to collections of 4 floats (see notes in earlier labs to read about padding)
-
-  	float4 gPolygon2DPoints[4]; // Four points of a polygon in 2D viewport space for polygon post-processing. Matrix transformations already done on C++ side
-
-	// Tint post-process settings
-	float3 gTintColour;
-	float  paddingB;
-
-	// Grey noise post-process settings
-    float2 gNoiseScale;
-	float2 gNoiseOffset;
 
-	// Burn post-process settings
-	float  gBurnHeight;
-	float3 paddingC;
+	float  gArea2DDepth;   // Depth buffer value for area (0.0 nearest to 1.0 furthest). Full screen post-processing uses 0.0f
+	float  gTimer;         // Time since the app started, for animated effects
+	float2 gTexelSize;     // Step between samples for blur and edge effects, in UVs
 
-	// Distort post-process settings
-	float  gDistortLevel;
-	float3 paddingD;
+	float4 gPolygon2DPoints[4]; // Four points of a polygon in 2D viewport space for polygon post-processing. Matrix transformations already done on C++ side
+}
 
-	// Spiral post-process settings
-	float  gSpiralLevel;
-	float3 paddingE;
+//**************************
 
-	// Heat haze post-process settings
-	float  gTimer;
-	float3 paddingF;
-    
-	// Vertical gradient post-process settings
-    float3 gTopColour;
-    float  paddingG;
-    
-    float3 gBottomColour;
-    float  paddingH;
-        
-	// Gaussian blur post-process pass settings
-    float2 gTexelSize;
-    float  gBlurStrength;
-    float  paddingI;
-
-	// Underwater post-process pass settings
-    float  gFrequency;
-    float  gAmplitude;
-    float2 paddingJ;
-    
-	// Depth of Field post-process pass settings
-    float  gFocalDistance;
-    float  gAperture;
-    float  gNearClip;
-    float  gFarClip;
-        
-	// Motion blur post-process pass settings
-    float  gBlendFactor;
-    float3 paddingK;
-
-	// Retro game post-process pass settings
-    float  gPixelSize;
-    int    gPaletteSize;
-    float2 paddingL;
-    
-	// Bright pass post-process pass settings
-    float  gBloomThreshold;
-    float  gExposure;
-    float  gBloomKnee;
-    float  paddingM;
-    
-	// Lens star post-process pass settings
-    float  gStepSize;
-    float  gAttenuation;
-    float2 paddingN;
-    
-	// Bloom post-process pass settings
-    float gBloomIntensity;
-    float gStarIntensity;
-    float2 paddingO;
-    
-	// Fog post-process pass settings
-    float3 gFogColour;
-    float  gFogDensity;
-    float  gFogHeightStart;
-    float  gFogHeightDensity;
-    float2 paddingP;
-    
-	// Game boy post-process pass settings
-    float3 gGameBoyColour;
-    float  gGameBoyPixelSize;
-    float  gGameBoyColourDepth;
-    float3 paddingQ;
-    
-	// Night vision post-process pass settings
-    float3 gNightVisionTint;
-    float  gNoiseIntensity;
-    float  gVignetteIntensity;
-    float  gFlickerIntensity;
-    float2 paddingR;
-    
-    float3 gBrightnessBoost;
-    float  gLuminanceThreshold;
-    float  gIntensity;
-    float3 paddingS;
-    
-	// Chromatic aberration & distortion post-process pass settings
-    float  gChromAbAmount;
-    float  gDistortionAmount;
-    float2 gScreenCenter;
-    
-	// Wireframe post-process pass settings
-    float  gEdgeThreshold;
-    float  gEdgePower;
-    float2 paddingT;
-    
-	// Dilation post-process pass settings
-    int    gKernelRadius;
-    float3 paddingU;
 
+//--------------------------------------------------------------------------------------
+// Helper functions
+//--------------------------------------------------------------------------------------
 
+// Ordered dither offset in -0.5->0.5 for a position on a grid (a pixel, or a block of a pixelated effect), from a 4x4
+// Bayer pattern. Must match OrderedDither in PaletteIndex.cpp
+float OrderedDither(int2 position)
+{
+	static const int bayer[16] = { 0, 8, 2, 10,  12, 4, 14, 6,  3, 11, 1, 9,  15, 7, 13, 5 };
+	int2 cell = position & 3;
+	return (bayer[cell.y * 4 + cell.x] + 0.5f) / 16.0f - 0.5f;
 }
-
-//**************************
-
@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------------------
+// Compute tile versions of neighbourhood effects
+//--------------------------------------------------------------------------------------
+
+#include "ComputeTile.h"
+
+#include <algorithm>
+
+
+ComputeTileShape GetComputeTileShape(PostProcess postProcess, const PostProcessEffectConstants& settings,
+                                     const PostProcessPassConstants& passConstants, int imageWidth, int imageHeight)
+{
+	ComputeTileShape shape;
+	if (postProcess == PostProcess::Wireframe)
+	{
+		// Square tiles, with an apron of one sample step all round
+		shape.width  = 16;
+		shape.height = 16;
+		shape.apronX = std::min(std::max(static_cast<int>(passConstants.texelSize.x * imageWidth  + 0.5f), 0), COMPUTE_TILE_MAX_WIREFRAME_STEP);
+		shape.apronY = std::min(std::max(static_cast<int>(passConstants.texelSize.y * imageHeight + 0.5f), 0), COMPUTE_TILE_MAX_WIREFRAME_STEP);
+	}
+	else if (postProcess == PostProcess::GaussianBlurHorizontal || postProcess == PostProcess::GaussianBlurVertical)
+	{
+		// Tiles long along the blur, so the apron is small compared to the tile. The last tap reads its pixel and the next
+		const GaussianBlurConstants& blur = settings.gaussianBlur;
+		int numTaps = std::min(std::max(blur.numTaps, 1), GAUSSIAN_MAX_TAPS);
+		int apron = std::min(static_cast<int>(blur.taps[numTaps - 1].x) + 1, COMPUTE_TILE_MAX_BLUR_APRON);
+		if (numTaps == 1)  apron = 0;
+
+		bool vertical = postProcess == PostProcess::GaussianBlurVertical;
+		shape.width  = vertical ? 4 : 64;
+		shape.height = vertical ? 64 : 4;
+		shape.apronX = vertical ? 0 : apron;
+		shape.apronY = vertical ? apron : 0;
+	}
+	return shape;
+}
@@ -0,0 +1,51 @@
+//--------------------------------------------------------------------------------------
+// Compute tile versions of neighbourhood effects
+//--------------------------------------------------------------------------------------
+// The pixel shaders of effects such as the wireframe (a 3x3 Sobel filter) and the Gaussian blurs
+// read the neighbourhood of every pixel from the texture, so each pixel is fetched again for every
+// neighbour that uses it. Their compute shader versions (*_cs.hlsl) work a tile at a time instead:
+// each thread group reads its tile of the image plus an apron of the pixels around it into group
+// shared memory once, then each thread works out one pixel of the tile from there. The wireframe
+// also keeps just the luminance of each pixel, so converts each pixel once rather than nine times.
+//
+// The render graph uses them for full screen passes of effects declared with computeTile when it
+// is compiled with compute tiles switched on (see RenderGraph::Compile). CPUComputeTile.h runs the
+// same groups on the CPU, to check the shaders' tiles and aprons against the pixel shaders.
+//
+// No DirectX here
+
+#ifndef _COMPUTE_TILE_H_INCLUDED_
+#define _COMPUTE_TILE_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Widest step between the wireframe's samples, in pixels. Must match MaxStep in Wireframe_cs.hlsl
+const int COMPUTE_TILE_MAX_WIREFRAME_STEP = 4;
+
+// Widest apron of the Gaussian blurs, enough for the furthest tap of the largest kernel and the pixel after it. Must match
+// MaxApron in GaussianHorizontalBlur_cs.hlsl and GaussianVerticalBlur_cs.hlsl
+const int COMPUTE_TILE_MAX_BLUR_APRON = 2 * GAUSSIAN_MAX_TAPS;
+
+
+// The block of pixels worked on by each thread group of an effect's compute shader
+struct ComputeTileShape
+{
+	int width  = 0; // Pixels written by each group, one for each thread. Must match the shader's numthreads
+	int height = 0;
+	int apronX = 0; // Pixels read beyond each side of the tile, left and right then above and below
+	int apronY = 0;
+};
+
+// The tile of the given effect, which must be declared with computeTile, reading an image of the given size with the given
+// settings. The Gaussian blurs' aprons depend on their kernel, the wireframe's on the step between its samples
+ComputeTileShape GetComputeTileShape(PostProcess postProcess, const PostProcessEffectConstants& settings,
+                                     const PostProcessPassConstants& passConstants, int imageWidth, int imageHeight);
+
+// Thread groups to dispatch along x and y to cover an image of the given size
+inline int ComputeTileGroupsX(const ComputeTileShape& shape, int imageWidth)   { return (imageWidth  + shape.width  - 1) / shape.width; }
+inline int ComputeTileGroupsY(const ComputeTileShape& shape, int imageHeight)  { return (imageHeight + shape.height - 1) / shape.height; }
+
+
+#endif //_COMPUTE_TILE_H_INCLUDED_
@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// Ring allocator for constants sent to the GPU
+//--------------------------------------------------------------------------------------
+
+#include "ConstantRing.h"
+
+
+ConstantRingAllocation ConstantRing::Allocate(int bytes)
+{
+	ConstantRingAllocation allocation;
+	allocation.size = AlignedSize(bytes);
+	if (allocation.size > mCapacity)  return allocation;
+
+	// Wrap around to the start if the block doesn't fit in what is left of the buffer
+	if (mOffset + allocation.size > mCapacity)  Wrap();
+
+	allocation.offset  = mOffset;
+	allocation.discard = mNeedsDiscard;
+	mOffset += allocation.size;
+	mNeedsDiscard = false;
+
+	mFrameBytes += bytes;
+	++mFrameBlocks;
+	return allocation;
+}
+
+
+void ConstantRing::BeginFrame()
+{
+	mLastFrameBytes  = mFrameBytes;
+	mLastFrameBlocks = mFrameBlocks;
+	mFrameBytes  = 0;
+	mFrameBlocks = 0;
+}
+
+
+void ConstantRing::Wrap()
+{
+	mOffset = 0;
+	mNeedsDiscard = true;
+	++mNumWraps;
+}
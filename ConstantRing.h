@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------------------
+// Ring allocator for constants sent to the GPU
+//--------------------------------------------------------------------------------------
+// Rather than a separate constant buffer for each block of settings, each updated with a
+// discarding map every time it changes, blocks are written one after another into a single
+// large dynamic buffer. A shader is given just its part of the buffer (an offset and size). When
+// the buffer is full, writing starts again from the beginning with a discarding map - DirectX
+// then hands out fresh memory, so draws still using the old contents are not affected. Until then
+// maps don't discard, so the GPU can keep reading the earlier blocks while new ones are written.
+//
+// ConstantRing only hands out offsets and keeps statistics, it doesn't touch DirectX
+
+#ifndef _CONSTANT_RING_H_INCLUDED_
+#define _CONSTANT_RING_H_INCLUDED_
+
+
+// DirectX 11.1 binds parts of a constant buffer in multiples of 16 constants of 16 bytes, so every block
+// starts on a 256-byte boundary and takes up a multiple of 256 bytes
+const int CONSTANT_RING_ALIGNMENT = 256;
+
+// Bytes in each shader constant (a float4)
+const int CONSTANT_BYTES = 16;
+
+
+// Space reserved in the ring for a block
+struct ConstantRingAllocation
+{
+	int  offset  = -1;    // Byte offset of the block in the buffer, -1 if the block is larger than the whole buffer
+	int  size    = 0;     // Bytes reserved, a multiple of CONSTANT_RING_ALIGNMENT
+	bool discard = false; // True if the buffer must be mapped with a discard to write this block (first use, or the ring wrapped around)
+};
+
+
+class ConstantRing
+{
+public:
+	// Capacity is the size of the GPU buffer in bytes, it should be a multiple of CONSTANT_RING_ALIGNMENT
+	ConstantRing(int capacity) : mCapacity(capacity) {}
+
+	// Reserve space for a block of the given size in bytes
+	ConstantRingAllocation Allocate(int bytes);
+
+	// Start a new frame of statistics
+	void BeginFrame();
+
+	// Start again from the beginning of the buffer, the next block will need a discarding map
+	void Wrap();
+
+	// Bytes reserved for a block of the given size
+	static int AlignedSize(int bytes)  { return (bytes + CONSTANT_RING_ALIGNMENT - 1) / CONSTANT_RING_ALIGNMENT * CONSTANT_RING_ALIGNMENT; }
+
+
+	//-------------------------------------
+	// Data access
+	//-------------------------------------
+
+	int Capacity() const  { return mCapacity; }
+
+	// Bytes left before the ring wraps around
+	int Remaining() const  { return mCapacity - mOffset; }
+
+	// Bytes of constants written in the last complete frame (the sizes of the blocks, not including alignment)
+	int LastFrameBytes() const   { return mLastFrameBytes; }
+
+	// Blocks written in the last complete frame
+	int LastFrameBlocks() const  { return mLastFrameBlocks; }
+
+	// Times the ring has wrapped around to the start since it was created
+	int NumWraps() const  { return mNumWraps; }
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	int  mCapacity;
+	int  mOffset       = 0;    // Where the next block goes
+	bool mNeedsDiscard = true; // A dynamic buffer must be discarded the first time it is mapped
+
+	// Statistics
+	int mFrameBytes      = 0;
+	int mFrameBlocks     = 0;
+	int mLastFrameBytes  = 0;
+	int mLastFrameBlocks = 0;
+	int mNumWraps        = 0;
+};
+
+
+#endif //_CONSTANT_RING_H_INCLUDED_
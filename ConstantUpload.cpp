@@ -0,0 +1,164 @@
+//--------------------------------------------------------------------------------------
+// Uploads of constant buffer data, skipping blocks that haven't changed
+//--------------------------------------------------------------------------------------
+
+#include "ConstantUpload.h"
+
+#include <cstring>
+
+
+uint64_t HashConstants(const void* data, int size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = 14695981039346656037ull;
+	for (int i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Uploads
+//--------------------------------------------------------------------------------------
+
+void ConstantUploader::Upload(ConstantSlot& slot, const void* data, int size)
+{
+	mFrame.requestedBytes += size;
+
+	// Keep a copy of the data even if it doesn't need writing - if the buffer is discarded later in the frame then the
+	// slot's old copy is lost and this one is needed. Only the latest data for each slot is kept, earlier data was for
+	// draws already issued
+	int index;
+	auto found = mFrameBlockIndex.find(&slot);
+	if (found == mFrameBlockIndex.end())
+	{
+		index = static_cast<int>(mFrameBlocks.size());
+		mFrameBlocks.push_back({ &slot, 0, 0, false, false });
+		mFrameBlockIndex[&slot] = index;
+	}
+	else
+	{
+		index = found->second;
+		mFrameBlockBytes -= ConstantRing::AlignedSize(mFrameBlocks[index].size);
+	}
+	FrameBlock& block = mFrameBlocks[index];
+	block.stagingOffset = static_cast<int>(mStaging.size());
+	block.size          = size;
+	mStaging.insert(mStaging.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+	mFrameBlockBytes += ConstantRing::AlignedSize(size);
+
+	uint64_t hash = HashConstants(data, size);
+	bool dirty = slot.generation != mGeneration || slot.hash != hash || slot.dataSize != size;
+	slot.hash     = hash;
+	slot.dataSize = size;
+	block.skipped = !dirty;
+	if (dirty)
+	{
+		Place(index);
+	}
+	else
+	{
+		++mFrame.skippedBlocks;
+	}
+}
+
+
+void ConstantUploader::Place(int frameBlock)
+{
+	ConstantRingAllocation allocation = mRing.Allocate(mFrameBlocks[frameBlock].size);
+	if (allocation.discard || allocation.offset < 0)
+	{
+		// New buffer memory, nothing written before is there any more
+		Discard(frameBlock);
+		return;
+	}
+	Placed(frameBlock, allocation);
+}
+
+
+void ConstantUploader::Placed(int frameBlock, const ConstantRingAllocation& allocation)
+{
+	FrameBlock& block = mFrameBlocks[frameBlock];
+	block.slot->offset     = allocation.offset;
+	block.slot->size       = allocation.size;
+	block.slot->generation = mGeneration;
+	if (!block.pending)
+	{
+		block.pending = true;
+		mPending.push_back(frameBlock);
+	}
+}
+
+
+void ConstantUploader::Discard(int frameBlock)
+{
+	++mGeneration;
+	++mFrame.discards;
+	mDiscardPending = true;
+
+	// Make the buffer larger if this frame's blocks take more than half of it, otherwise the ring would wrap around (and
+	// write every block again) at the start of nearly every frame. The new buffer starts empty. Otherwise start again from
+	// the beginning of the ring, where the block that found the ring full was just placed
+	if (mFrameBlockBytes * 2 > mRing.Capacity())
+	{
+		int capacity = mRing.Capacity();
+		while (capacity < mFrameBlockBytes * 2)  capacity *= 2;
+		mRing = ConstantRing(capacity);
+	}
+	else
+	{
+		mRing.Wrap();
+	}
+
+	// Every block uploaded this frame may already be bound, or be bound again without another upload, so they all need
+	// writing into the new memory. Unchanged blocks were counted as skipped but are written after all
+	Placed(frameBlock, mRing.Allocate(mFrameBlocks[frameBlock].size));
+	for (int index = 0; index < static_cast<int>(mFrameBlocks.size()); ++index)
+	{
+		if (index == frameBlock)  continue;
+		if (mFrameBlocks[index].skipped)
+		{
+			mFrameBlocks[index].skipped = false;
+			--mFrame.skippedBlocks;
+		}
+		Placed(index, mRing.Allocate(mFrameBlocks[index].size));
+	}
+}
+
+
+void ConstantUploader::Flush(void* mappedBuffer)
+{
+	char* buffer = static_cast<char*>(mappedBuffer);
+	for (int index : mPending)
+	{
+		FrameBlock& block = mFrameBlocks[index];
+		if (buffer)  memcpy(buffer + block.slot->offset, mStaging.data() + block.stagingOffset, block.size);
+		mFrame.writtenBytes += block.size;
+		block.pending = false;
+	}
+	if (!mPending.empty())  ++mFrame.maps;
+
+	mPending.clear();
+	mDiscardPending = false;
+}
+
+
+void ConstantUploader::BeginFrame()
+{
+	mLastFrame = mFrame;
+	mFrame = FrameStatistics();
+	mRing.BeginFrame();
+
+	mFrameBlocks.clear();
+	mFrameBlockIndex.clear();
+	mStaging.clear();
+	mFrameBlockBytes = 0;
+
+	// Wrap around now if the ring is getting full, so it is unlikely to fill part way through the frame. The buffer is only
+	// discarded, starting a new generation, when the next changed block is written - until then unchanged blocks can still
+	// use their copies in the old memory
+	if (mRing.Remaining() < mRing.Capacity() / 2)  mRing.Wrap();
+}
@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------------------
+// Uploads of constant buffer data, skipping blocks that haven't changed
+//--------------------------------------------------------------------------------------
+// Every block of constants sent to the GPU (the per-frame constants, each model's matrices,
+// post-process settings...) has a slot that remembers where the block was last written in a
+// ConstantRing buffer and a hash of its contents. When the same data is uploaded again the
+// previous copy is still in the buffer, so nothing is written and the shaders are simply pointed
+// at the old copy. Static models, for example, are written once and never again.
+//
+// Changed blocks are staged in CPU memory and written to the GPU buffer together when Flush is
+// called, so a draw needing several changed blocks maps the buffer once rather than once for
+// each block.
+//
+// The ring only discards the buffer when it wraps around, which loses every earlier block. Each
+// discard starts a new generation and slots from an older generation are written again. Wrapping
+// is done at the start of a frame once half the buffer is used, so it rarely happens part way
+// through a frame. When it does (or on the first upload after the start of frame wrap) every block
+// uploaded so far in the frame is written again into the fresh memory, as earlier draws may have
+// bound it and later ones may still use it. Those blocks have moved, so everything bound must be
+// bound again after the flush - FlushMovesBlocks says when. If the blocks of one frame take more
+// than half the buffer it is made larger (at least twice what the frame needs) and a new GPU buffer
+// of the new Capacity must be created before the flush.
+//
+// No DirectX here - GraphicsHelpers.cpp maps the buffer and binds the slots
+
+#ifndef _CONSTANT_UPLOAD_H_INCLUDED_
+#define _CONSTANT_UPLOAD_H_INCLUDED_
+
+#include "ConstantRing.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+// 64-bit FNV-1a hash of a block of memory, used to spot blocks that haven't changed
+uint64_t HashConstants(const void* data, int size);
+
+
+// Where a block of constants was last written. Keep one for each thing that uploads a block (e.g. each node of a model)
+// and pass it to each upload. A default slot has never been written
+struct ConstantSlot
+{
+	uint64_t hash       = 0;
+	int      offset     = -1; // Byte offset of the block in the buffer
+	int      size       = 0;  // Bytes reserved in the buffer, a multiple of CONSTANT_RING_ALIGNMENT
+	int      dataSize   = 0;  // Bytes of constants in the block
+	int      generation = -1; // Generation of the buffer the block was written in
+};
+
+
+class ConstantUploader
+{
+public:
+	// Capacity is the size of the GPU buffer in bytes
+	ConstantUploader(int capacity) : mRing(capacity) {}
+
+	// Stage a block of constants for the given slot. If the slot already holds the same data nothing needs writing,
+	// otherwise space is reserved in the buffer and the data is copied to be written by the next Flush. The slot's
+	// offset is only final once Flush has been called
+	void Upload(ConstantSlot& slot, const void* data, int size);
+
+	// True if there are staged blocks to write, i.e. the buffer needs mapping
+	bool NeedsFlush() const  { return !mPending.empty(); }
+
+	// True if the buffer must be mapped with a discard for the next Flush (the ring has wrapped around or grown). Blocks
+	// uploaded earlier in the frame are then at new offsets, so every bound block must be bound again after the flush
+	bool FlushNeedsDiscard() const  { return mDiscardPending; }
+
+	// Copy the staged blocks into the mapped buffer memory. With no buffer (nullptr) the blocks are only counted in the
+	// statistics, so uploads can be measured without a GPU
+	void Flush(void* mappedBuffer);
+
+	// Start a new frame, call before any uploads for the frame. Updates the statistics and wraps the ring if it is getting full.
+	// The buffer is only discarded (starting a new generation) when the next changed block is written
+	void BeginFrame();
+
+
+	//-------------------------------------
+	// Data access
+	//-------------------------------------
+
+	// Size the GPU buffer must be, it grows if a frame's blocks don't fit in half of it
+	int Capacity() const  { return mRing.Capacity(); }
+
+	// Generation of the buffer contents, starting again each time the buffer is discarded
+	int Generation() const  { return mGeneration; }
+
+	// Statistics for the last complete frame:
+	int LastFrameRequestedBytes() const  { return mLastFrame.requestedBytes; } // Bytes passed to Upload, i.e. what would be written without tracking
+	int LastFrameWrittenBytes() const    { return mLastFrame.writtenBytes; }   // Bytes actually written to the buffer
+	int LastFrameSkippedBlocks() const   { return mLastFrame.skippedBlocks; }  // Uploads that didn't need writing
+	int LastFrameMaps() const            { return mLastFrame.maps; }           // Calls to Flush that wrote anything, i.e. buffer maps
+	int LastFrameDiscards() const        { return mLastFrame.discards; }       // Times the buffer was discarded
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	// The latest data uploaded for a slot this frame
+	struct FrameBlock
+	{
+		ConstantSlot* slot;
+		int           stagingOffset; // Where the data is in mStaging
+		int           size;
+		bool          pending;       // Waiting to be written by the next flush
+		bool          skipped;       // The latest upload didn't need writing
+	};
+
+	// Reserve space in the ring for a frame block and point its slot at it. Discards the buffer if the ring wraps around
+	void Place(int frameBlock);
+
+	// Point a frame block's slot at space reserved for it and queue it for the next flush
+	void Placed(int frameBlock, const ConstantRingAllocation& allocation);
+
+	// Start a new generation in fresh buffer memory, made larger if the frame's blocks need it, and place every block
+	// uploaded this frame again. The given block is placed first
+	void Discard(int frameBlock);
+
+	struct FrameStatistics
+	{
+		int requestedBytes = 0;
+		int writtenBytes   = 0;
+		int skippedBlocks  = 0;
+		int maps           = 0;
+		int discards       = 0;
+	};
+
+	ConstantRing mRing;
+	int          mGeneration     = 0;
+	bool         mDiscardPending = false;
+
+	std::vector<FrameBlock>                      mFrameBlocks;         // Every slot uploaded this frame, in order
+	std::unordered_map<const ConstantSlot*, int> mFrameBlockIndex;     // Index in mFrameBlocks of each slot uploaded this frame
+	std::vector<char>                            mStaging;             // Copies of the data uploaded this frame
+	std::vector<int>                             mPending;             // Frame blocks to write in the next flush
+	int                                          mFrameBlockBytes = 0; // Ring space needed for all the frame blocks
+
+	FrameStatistics mFrame;
+	FrameStatistics mLastFrame;
+};
+
+
+#endif //_CONSTANT_UPLOAD_H_INCLUDED_
@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// Depth of field as circle of confusion tiles and half size gathers
+//--------------------------------------------------------------------------------------
+
+#include "DepthOfField.h"
+
+
+DepthOfFieldGatherConstants MakeDepthOfFieldGatherConstants(bool nearField, int temporalFrames /*= 1*/, int frameIndex /*= 0*/)
+{
+	DepthOfFieldGatherConstants constants = {};
+	constants.nearField      = nearField ? 1 : 0;
+	constants.temporalFrames = temporalFrames > 1 ? temporalFrames : 1;
+	constants.frameIndex     = frameIndex;
+	return constants;
+}
+
+
+float DepthOfFieldGatherTaps(int temporalFrames /*= 1*/)
+{
+	// Ring n has 8 * n taps, shared evenly between the frames
+	float taps = 1.0f;
+	for (int ring = 1; ring <= DOF_GATHER_RINGS; ++ring)
+	{
+		taps += 8.0f * ring / (temporalFrames > 1 ? temporalFrames : 1);
+	}
+	return taps;
+}
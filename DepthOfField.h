@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// Depth of field as circle of confusion tiles and half size gathers
+//--------------------------------------------------------------------------------------
+// Depth of field used to be a single full size pass running a Gaussian blur whose width came from
+// the depth of each pixel - up to 17x17 taps with an exp() for each, even where nothing near the
+// pixel was out of focus. It is now one effect which the render graph expands into its own passes
+// (see RenderGraph::Compile):
+//
+// - Circle of confusion (CoC): a full size 16-bit float image holding the scene colour and, in
+//   alpha, how far each pixel is out of focus. Negative for pixels in front of the focal distance
+//   (the near field), positive behind it (the far field), as a fraction of DOF_MAX_COC_PIXELS.
+// - Tiles: one pixel for each DOF_TILE_SIZE square of the CoC image, holding the smallest CoC in
+//   the square (the most out of focus near pixel) and the largest (the most out of focus far one).
+// - Far and near gathers: half size images of the blurred far and near fields. Each pixel reads
+//   the tiles around it, and if none of them holds a pixel out of focus it is finished straight
+//   away - most of an image in focus costs almost nothing. Otherwise it reads a disc of taps (the
+//   bokeh kernel) as wide as the largest CoC nearby, keeping each tap whose own CoC reaches this
+//   pixel. The near field spreads over whatever is behind it, so its image also holds how much of
+//   each pixel it covers.
+// - The composite (DepthOfField_pp.hlsl) blends the full size scene towards the far field by its
+//   own CoC, then lays the near field over the top.
+//
+// The cost of the gathers doesn't depend on the aperture, as the number of taps is fixed - a wider
+// CoC only spreads them further apart. The shaders are DepthOfFieldCoC_pp.hlsl,
+// DepthOfFieldTiles_pp.hlsl, DepthOfFieldGather_pp.hlsl and DepthOfField_pp.hlsl, CPUDepthOfField.h
+// has the CPU versions. No DirectX here
+
+#ifndef _DEPTH_OF_FIELD_H_INCLUDED_
+#define _DEPTH_OF_FIELD_H_INCLUDED_
+
+#include "PostProcessConstants.h"
+
+
+// Largest circle of confusion radius in viewport pixels. No larger than a tile, so the tiles next to a pixel's own hold every
+// pixel whose CoC can reach it. Also in the shaders
+const float DOF_MAX_COC_PIXELS = 16.0f;
+
+// CoC radius in viewport pixels for each unit of aperture * distance from focus / distance. Also in DepthOfFieldCoC_pp.hlsl
+const float DOF_COC_PIXELS_PER_UNIT = 4.0f;
+
+// Width and height of the square of viewport pixels each tile covers, and so the size divisor of the tile image
+const int DOF_TILE_SIZE = 16;
+
+// Size divisor of the near and far field images
+const int DOF_GATHER_SIZE_DIVISOR = 2;
+
+// Rings of taps around the centre of the bokeh kernel, ring n has 8 * n taps. Also in DepthOfFieldGather_pp.hlsl
+const int DOF_GATHER_RINGS = 3;
+
+// Frames the gathers' ring taps are spread over with temporal accumulation, a quarter of them each frame (see TemporalHistory.h)
+const int DOF_TEMPORAL_FRAMES = 4;
+
+
+// Settings for a gather pass, of the near field or the far field. With temporal accumulation the taps of the rings are spread
+// over temporalFrames frames - each pixel takes every temporalFrames-th tap of each ring, which ones depending on the frame
+// index and the pixel, so the pixels around it take the rest (see TemporalHistory.h). The centre tap is always taken
+DepthOfFieldGatherConstants MakeDepthOfFieldGatherConstants(bool nearField, int temporalFrames = 1, int frameIndex = 0);
+
+// Taps read by a gather for each pixel out of focus when spread over the given number of frames, averaged over the pixels
+float DepthOfFieldGatherTaps(int temporalFrames = 1);
+
+
+#endif //_DEPTH_OF_FIELD_H_INCLUDED_
@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------------------
+// Depth of Field Circle of Confusion Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// First pass of the depth of field (see DepthOfField.h). Copies the scene colour and puts the
+// pixel's circle of confusion in alpha: how far it is out of focus, negative in front of the focal
+// distance and positive behind it, as a fraction of the largest radius. Written to a 16-bit float
+// target so the sign and the small values near focus are kept
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match DepthOfFieldConstants in PostProcessConstants.h
+cbuffer DepthOfFieldConstants : register(b2)
+{
+	float  gFocalDistance;
+	float  gAperture;
+	float  gNearClip;
+	float  gFarClip;
+}
+
+// As DOF_MAX_COC_PIXELS and DOF_COC_PIXELS_PER_UNIT in DepthOfField.h
+static const float MAX_COC_PIXELS = 16.0f;
+static const float COC_PIXELS_PER_UNIT = 4.0f;
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SceneTexture : register(t0);
+Texture2D    DepthTexture : register(t1); // Depth buffer of the scene
+SamplerState PointSample  : register(s0);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float LinearizeDepth(float depth)
+{
+	return (gNearClip * gFarClip) / (gFarClip - depth * (gFarClip - gNearClip));
+}
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float3 sceneColour = SceneTexture.Sample(PointSample, input.sceneUV).rgb;
+	float linearDepth = LinearizeDepth(DepthTexture.Sample(PointSample, input.sceneUV).r);
+
+	float cocPixels = gAperture * (linearDepth - gFocalDistance) / linearDepth * COC_PIXELS_PER_UNIT;
+	return float4(sceneColour, clamp(cocPixels / MAX_COC_PIXELS, -1.0f, 1.0f));
+}
@@ -0,0 +1,126 @@
+//--------------------------------------------------------------------------------------
+// Depth of Field Gather Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Writes the half size image of the blurred near or far field of the depth of field (see
+// DepthOfField.h). Pixels whose nearby tiles hold nothing out of focus in the field are finished
+// straight away. The rest read a disc of taps in rings around the pixel, as wide as the largest
+// circle of confusion (CoC) in the nearby tiles. A tap is kept if it is in the field and its own
+// CoC is wide enough to reach this pixel - gathering what each pixel would scatter over its CoC.
+//
+// The far field image holds the blurred colour. The near field spreads over the pixels behind it,
+// so its image also holds in alpha how much of this pixel it covers, with the colour multiplied
+// by that so it can be filtered when scaled up.
+//
+// With temporal accumulation each pixel takes only every gTemporalFrames-th tap of each ring, and
+// the history fills in the rest (see TemporalHistory.h). Which taps turns with the frame and differs
+// across each 2x2 block of pixels, so the pixels around any one take the taps it skipped
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this pass, must match DepthOfFieldGatherConstants in PostProcessConstants.h
+cbuffer DepthOfFieldGatherConstants : register(b2)
+{
+	int gNearField;      // 1 for the near field, 0 for the far field
+	int gTemporalFrames; // Frames the taps of the rings are spread over, 1 to take them all
+	int gFrameIndex;
+	int padding;
+}
+
+// As DOF_MAX_COC_PIXELS and DOF_GATHER_RINGS in DepthOfField.h
+static const float MAX_COC_PIXELS = 16.0f;
+static const int   RINGS = 3;
+
+// A CoC less than half a pixel is in focus
+static const float IN_FOCUS = 0.5f / MAX_COC_PIXELS;
+
+static const float TAU = 6.28318530717958647692f;
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    CoCTexture   : register(t0); // Scene colour with its CoC in alpha, viewport size
+Texture2D    TileTexture  : register(t1); // Smallest and largest CoC of each tile
+SamplerState LinearSample : register(s1); // Bilinear filtering, clamped at the edges
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+// Number of the taps of a ring taken by a pixel whose share of them is the given phase. The centre is always taken
+int TapsTaken(int numTaps, int ring, int phase)
+{
+	if (ring == 0)  return 1;
+	int firstTap = (phase - ring % gTemporalFrames + gTemporalFrames) % gTemporalFrames;
+	return (firstTap < numTaps) ? (numTaps - 1 - firstTap) / gTemporalFrames + 1 : 0;
+}
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	int2 viewportSize, numTiles;
+	CoCTexture.GetDimensions(viewportSize.x, viewportSize.y);
+	TileTexture.GetDimensions(numTiles.x, numTiles.y);
+
+	// The widest CoC in the field among the tile holding this pixel and the eight around it
+	int2 tile = min(int2(input.sceneUV * viewportSize) * numTiles / viewportSize, numTiles - 1);
+	float radius = 0.0f;
+	for (int tileY = -1; tileY <= 1; ++tileY)
+	{
+		for (int tileX = -1; tileX <= 1; ++tileX)
+		{
+			float2 tileCoC = TileTexture.Load(int3(clamp(tile + int2(tileX, tileY), int2(0, 0), numTiles - 1), 0)).rg;
+			radius = max(radius, gNearField ? -tileCoC.x : tileCoC.y);
+		}
+	}
+
+	float4 centre = CoCTexture.Sample(LinearSample, input.sceneUV);
+	if (radius < IN_FOCUS)  return gNearField ? float4(0.0f, 0.0f, 0.0f, 0.0f) : float4(centre.rgb, 1.0f);
+
+	int2 pixel = int2(input.projectedPosition.xy);
+	int  phase = (gFrameIndex + (pixel.x & 1) + 2 * (pixel.y & 1)) % gTemporalFrames;
+
+	float3 totalColour = float3(0.0f, 0.0f, 0.0f);
+	float  totalWeight = 0.0f;
+	float  widestCoC   = 0.0f;
+	for (int ring = 0; ring <= RINGS; ++ring)
+	{
+		int   numTaps = (ring == 0) ? 1 : 8 * ring;
+		float ringCoC = radius * ring / RINGS; // Distance of the ring's taps, in the same units as the CoC
+		for (int tap = 0; tap < numTaps; ++tap)
+		{
+			if (ring > 0 && (tap + ring) % gTemporalFrames != phase)  continue;
+
+			float  angle  = TAU * (tap + 0.5f * (ring % 2)) / numTaps;
+			float2 offset = float2(cos(angle), sin(angle)) * ringCoC * MAX_COC_PIXELS / viewportSize;
+			float4 tapColour = CoCTexture.Sample(LinearSample, input.sceneUV + offset);
+
+			// Keep taps in the field whose CoC reaches this pixel, fading out over a pixel
+			float tapCoC = gNearField ? -tapColour.a : tapColour.a;
+			float weight = (tapCoC > 0.0f) ? saturate((tapCoC - ringCoC) * MAX_COC_PIXELS + 1.0f) : 0.0f;
+			totalColour += tapColour.rgb * weight;
+			totalWeight += weight;
+			if (weight > 0.0f)  widestCoC = max(widestCoC, tapCoC);
+		}
+	}
+
+	if (!gNearField)
+	{
+		return float4((totalWeight > 0.0f) ? totalColour / totalWeight : centre.rgb, 1.0f);
+	}
+
+	// The near field covers this pixel by the share of the taps it reached out of those taken within its widest CoC
+	float reachableTaps = 0.0f;
+	for (int ring = 0; ring <= RINGS; ++ring)
+	{
+		if (radius * ring / RINGS <= widestCoC)  reachableTaps += TapsTaken((ring == 0) ? 1 : 8 * ring, ring, phase);
+	}
+	float coverage = (totalWeight > 0.0f) ? saturate(totalWeight / reachableTaps) : 0.0f;
+	return float4(totalColour / max(totalWeight, 1e-5f) * coverage, coverage);
+}
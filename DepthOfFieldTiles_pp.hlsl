@@ -0,0 +1,46 @@
+//--------------------------------------------------------------------------------------
+// Depth of Field Tiles Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Second pass of the depth of field (see DepthOfField.h). Each pixel of the small target covers a
+// square of about 16x16 pixels of the circle of confusion image and finds the smallest and largest
+// circle of confusion in it - the most out of focus near and far pixels. Squares at the right and
+// bottom edges are a little larger where the viewport isn't a multiple of 16 pixels, so every pixel
+// belongs to a tile
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D CoCTexture : register(t0); // Scene colour with its circle of confusion in alpha, viewport size
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	uint2 viewportSize;
+	CoCTexture.GetDimensions(viewportSize.x, viewportSize.y);
+	uint2 numTiles = max(viewportSize / 16, uint2(1, 1)); // As the render graph sizes the tile image
+
+	uint2 tile  = uint2(input.projectedPosition.xy);
+	uint2 start = tile * viewportSize / numTiles;
+	uint2 end   = (tile + 1) * viewportSize / numTiles;
+
+	float minCoC = 0.0f;
+	float maxCoC = 0.0f;
+	for (uint y = start.y; y < end.y; ++y)
+	{
+		for (uint x = start.x; x < end.x; ++x)
+		{
+			float coc = CoCTexture.Load(int3(x, y, 0)).a;
+			minCoC = min(minCoC, coc);
+			maxCoC = max(maxCoC, coc);
+		}
+	}
+	return float4(minCoC, maxCoC, 0.0f, 1.0f);
+}
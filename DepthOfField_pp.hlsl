@@ -1,71 +1,32 @@
 //--------------------------------------------------------------------------------------
 // Depth of Field Post-Processing Pixel Shader
 //--------------------------------------------------------------------------------------
-// Applies a depth of field effect: models at the focal distance are sharp, while nearer or further models are blurred
+// Applies a depth of field effect: models at the focal distance are sharp, while nearer or further models are blurred.
+// This is the last of the depth of field passes (see DepthOfField.h): the full size scene is blended towards the blurred
+// far field by its own circle of confusion, then the near field is laid over the top. Pixels that are in focus and not
+// covered by the near field are just copied
 
 #include "Common.hlsli"
 
-//--------------------------------------------------------------------------------------
-// Constants
-//--------------------------------------------------------------------------------------
-
-static const float TAU = 6.28318530717958647692f;
-static const float GAMMA = 2.2f;
 
 //--------------------------------------------------------------------------------------
-// Textures (texture maps)
+// Constant buffers
 //--------------------------------------------------------------------------------------
 
-Texture2D SceneTexture : register(t0); // Color texture of the rendered scene
-SamplerState PointSample : register(s0); // Point sampling for color texture
+// As DOF_MAX_COC_PIXELS in DepthOfField.h
+static const float MAX_COC_PIXELS = 16.0f;
 
-Texture2D DepthTexture : register(t1); // Depth texture of the rendered scene
-SamplerState LinearSample : register(s1); // Linear sampling for depth interpolation
 
 //--------------------------------------------------------------------------------------
-// Helper Functions
+// Textures (texture maps)
 //--------------------------------------------------------------------------------------
 
-// Correctly linearize depth from non-linear depth buffer to linear distance
-float LinearizeDepth(float depth)
-{
-    return (gNearClip * gFarClip) / (gFarClip - depth * (gFarClip - gNearClip));
-}
-
-// Gaussian blur in linear colour space
-float3 Blur(float2 uv, float blurRadius)
-{
-    int halfKernel = clamp(int(ceil(blurRadius * 2.0f)), 2, 8);
-    float sigma = max(blurRadius, 0.001f);
-    float3 colourAccum = float3(0.0f, 0.0f, 0.0f);
-    float weightAccum = 0.0f;
-    
-    // Loop over a square region
-    for (int y = -halfKernel; y <= halfKernel; ++y)
-    {
-        for (int x = -halfKernel; x <= halfKernel; ++x)
-        {
-            // Distance^2 from the center
-            float dist2 = (float) (x * x + y * y);
-
-            // Gaussian weight for this offset
-            float w = exp(-dist2 / (2.0f * sigma * sigma));
-
-            // Convert (x,y) to a UV offset in screen space
-            // Multiplying offset by 'blurRadius' ensures that bigger radius
-            // means sampling further out from the center.
-            float2 offsetUV = float2(x, y) * gTexelSize * blurRadius;
+Texture2D    CoCTexture   : register(t0); // Scene colour with its circle of confusion in alpha
+Texture2D    FarTexture   : register(t1); // Far field, half size
+Texture2D    NearTexture  : register(t2); // Near field, half size, colour multiplied by its coverage in alpha
+SamplerState PointSample  : register(s0);
+SamplerState LinearSample : register(s1); // Bilinear filtering for the half size images
 
-            // Sample and accumulate
-            float3 sampleColor = SceneTexture.Sample(LinearSample, uv + offsetUV).rgb;
-            colourAccum += sampleColor * w;
-            weightAccum += w;
-        }
-    }
-
-    // Normalize by total weight
-    return colourAccum / max(weightAccum, 1e-5);
-}
 
 //--------------------------------------------------------------------------------------
 // Shader code
@@ -73,19 +34,14 @@ float3 Blur(float2 uv, float blurRadius)
 
 float4 main(PostProcessingInput input) : SV_Target
 {
-    // Sample colour and depth
-    float3 outputColour = SceneTexture.Sample(PointSample, input.sceneUV).rgb;
-    float depth = DepthTexture.Sample(PointSample, input.sceneUV).r;
-    float linearDepth = LinearizeDepth(depth);
+	float4 scene = CoCTexture.Sample(PointSample, input.sceneUV);
+	float4 near  = NearTexture.Sample(LinearSample, input.sceneUV);
 
-    // Calculate blur radius based on depth difference and distance
-    float depthDifference = abs(linearDepth - gFocalDistance);
-    float blurAmount = (gAperture * depthDifference) / linearDepth;
-    
-    if (blurAmount > 0.01f)
-    {
-        outputColour = Blur(input.sceneUV, blurAmount * 0.5f);
-    }
+	// Blend to the far field from a CoC of half a pixel to one and a half
+	float farBlend = saturate(scene.a * MAX_COC_PIXELS - 0.5f);
+	if (farBlend == 0.0f && near.a == 0.0f)  return float4(scene.rgb, 1.0f);
 
-    return float4(outputColour, 1.0f);
-}
\ No newline at end of file
+	float3 outputColour = lerp(scene.rgb, FarTexture.Sample(LinearSample, input.sceneUV).rgb, farBlend);
+	outputColour = outputColour * (1.0f - near.a) + near.rgb;
+	return float4(outputColour, 1.0f);
+}
@@ -2,10 +2,23 @@
 // Dilation Post-Processing Pixel Shader
 //--------------------------------------------------------------------------------------
 // Expands bright areas by finding the maximum color in a neighborhood (a naive approach).
+// Full screen dilations use SlidingFilter_cs.hlsl instead, which costs the same at any radius.
 //--------------------------------------------------------------------------------------
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match DilationConstants in PostProcessConstants.h
+cbuffer DilationConstants : register(b2)
+{
+	int    gKernelRadius;
+	float3 paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures & Samplers
 //--------------------------------------------------------------------------------------
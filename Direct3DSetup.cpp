@@ -5,7 +5,7 @@
 #include "Direct3DSetup.h"
 #include "Shader.h"
 #include "Common.h"
-#include <d3d11.h>
+#include <d3d11_1.h>
 #include <vector>
 
 
@@ -17,6 +17,7 @@
 // The main Direct3D (D3D) variables
 ID3D11Device*        gD3DDevice  = nullptr; // D3D device for overall features
 ID3D11DeviceContext* gD3DContext = nullptr; // D3D context for specific rendering tasks
+ID3D11DeviceContext1* gD3DContext1 = nullptr; // Same context with DirectX 11.1 features
 
 // Swap chain and back buffer
 IDXGISwapChain*         gSwapChain              = nullptr;
@@ -64,6 +65,22 @@ bool InitDirect3D()
         return false;
     }
 
+    // Post-processing constants are written into one large buffer and each shader is given just its part of it (see
+    // ConstantRing.h). That needs DirectX 11.1 (Windows 8 or later) and a driver that supports it
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    hr = gD3DDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+    if (FAILED(hr) || !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+    {
+        gLastError = "Direct3D 11.1 constant buffer offsets are not supported";
+        return false;
+    }
+    hr = gD3DContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&gD3DContext1);
+    if (FAILED(hr))
+    {
+        gLastError = "Error getting Direct3D 11.1 context";
+        return false;
+    }
+
 
     // Get a "render target view" of back-buffer - standard behaviour
     ID3D11Texture2D* backBuffer;
@@ -147,6 +164,7 @@ void ShutdownDirect3D()
         gD3DContext->ClearState(); // This line is also needed to reset the GPU before shutting down DirectX
         gD3DContext->Release();
     }
+    if (gD3DContext1)            gD3DContext1->Release();
     if (gDepthShaderView)        gDepthShaderView->Release();
     if (gDepthStencil)           gDepthStencil->Release();
     if (gDepthStencilTexture)    gDepthStencilTexture->Release();
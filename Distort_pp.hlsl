@@ -6,6 +6,18 @@
 #include "Common.hlsli"
 
 
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match DistortConstants in PostProcessConstants.h
+cbuffer DistortConstants : register(b2)
+{
+	float  gDistortLevel;
+	float3 paddingA;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
@@ -4,6 +4,22 @@
 // Applies an atmospheric fog effect based on depth & height
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match FogConstants in PostProcessConstants.h
+cbuffer FogConstants : register(b2)
+{
+	float3 gFogColour;
+	float  gFogDensity;
+	float  gFogHeightStart;
+	float  gFogHeightDensity;
+	float  gNearClip;
+	float  gFarClip;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
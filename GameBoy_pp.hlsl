@@ -6,6 +6,21 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match GameBoyConstants in PostProcessConstants.h
+cbuffer GameBoyConstants : register(b2)
+{
+	float3 gGameBoyColour;
+	float  gGameBoyPixelSize;
+	float  gGameBoyColourDepth;
+	float  gDitherAmount; // Strength of the ordered dither added before picking a shade, 0 for none
+	float2 paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures & Samplers
 //--------------------------------------------------------------------------------------
@@ -35,9 +50,11 @@ float4 main(PostProcessingInput input) : SV_Target
     // Sample color from the scene texture
     float3 sampledColour = SceneTexture.Sample(PointSample, pixelatedUV).rgb;
 
-    // Convert to grayscale with limited color depth
+    // Convert to grayscale with limited color depth. The dither offsets each big pixel by up to half a shade
+    // so smooth gradients turn into a pattern of the two nearest shades rather than flat bands
     float grayscale = ConvertToGrayscale(sampledColour);
-    grayscale = round(grayscale * gGameBoyColourDepth) / gGameBoyColourDepth;
+    float dither = OrderedDither(int2(floor(input.sceneUV * gGameBoyPixelSize))) * gDitherAmount;
+    grayscale = round(grayscale * gGameBoyColourDepth + dither) / gGameBoyColourDepth;
 
     // Apply the Game Boy color tint
     float3 outputColour = grayscale * gGameBoyColour;
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------------
+// Horizontal Blur Compute Shader
+//--------------------------------------------------------------------------------------
+// The full screen version of GaussianHorizontalBlur_pp.hlsl. Each thread group reads a few rows
+// of the image, plus the pixels either side that the kernel reaches, into group shared memory,
+// then each thread works out its pixel from the taps there (see ComputeTile.h). A tap between two
+// pixels blends them just as the pixel shader's bilinear sample does.
+//--------------------------------------------------------------------------------------
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match GaussianBlurConstants in PostProcessConstants.h
+cbuffer GaussianBlurConstants : register(b2)
+{
+	float  gBlurSigma; // Not needed here, the taps below are worked out from it
+	int    gNumTaps;
+	float2 paddingA;
+	float4 gBlurTaps[7]; // x = offset from the centre in pixels, y = weight. Size must match GAUSSIAN_MAX_TAPS
+}
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+Texture2D<float4>   SceneTexture  : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+//--------------------------------------------------------------------------------------
+// Group shared memory
+//--------------------------------------------------------------------------------------
+
+// Must match GetComputeTileShape in ComputeTile.cpp and COMPUTE_TILE_MAX_BLUR_APRON in ComputeTile.h
+static const int TileWidth  = 64;
+static const int TileHeight = 4;
+static const int MaxApron   = 14;
+
+// Colours of the rows of the tile and the pixels either side, a row at a time
+groupshared float3 gTile[(TileWidth + 2 * MaxApron) * TileHeight];
+
+//--------------------------------------------------------------------------------------
+// Shader Code
+//--------------------------------------------------------------------------------------
+
+[numthreads(TileWidth, TileHeight, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID, uint threadIndex : SV_GroupIndex)
+{
+    uint imageWidth, imageHeight;
+    SceneTexture.GetDimensions(imageWidth, imageHeight);
+    int2 imageSize = int2(imageWidth, imageHeight);
+
+    // The last tap reads its own pixel and the one after
+    int numTaps = clamp(gNumTaps, 1, 7);
+    int apron = (numTaps > 1) ? min(int(gBlurTaps[numTaps - 1].x) + 1, MaxApron) : 0;
+    int span = TileWidth + 2 * apron;
+    int2 loadStart = int2(groupID.xy) * int2(TileWidth, TileHeight) - int2(apron, 0);
+
+    // Load each pixel once, reads past the edges of the image give the edge pixel as the clamped sampler does
+    for (int i = threadIndex; i < span * TileHeight; i += TileWidth * TileHeight)
+    {
+        int2 pixel = clamp(loadStart + int2(i % span, i / span), 0, imageSize - 1);
+        gTile[i] = SceneTexture[pixel].rgb;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    int centre = groupThreadID.y * span + groupThreadID.x + apron;
+    float3 outputColour = gTile[centre] * gBlurTaps[0].y;
+
+    // Each tap after the centre on both sides, blending the two pixels it sits between
+    for (int tap = 1; tap < numTaps; tap++)
+    {
+        int   whole    = int(gBlurTaps[tap].x);
+        float fraction = gBlurTaps[tap].x - whole;
+        float3 right = lerp(gTile[centre + whole], gTile[centre + whole + 1], fraction);
+        float3 left  = lerp(gTile[centre - whole], gTile[centre - whole - 1], fraction);
+        outputColour += (right + left) * gBlurTaps[tap].y;
+    }
+
+    int2 pixel = int2(groupID.xy) * int2(TileWidth, TileHeight) + int2(groupThreadID.xy);
+    if (all(pixel < imageSize))
+    {
+        OutputTexture[pixel] = float4(outputColour, 1.0f);
+    }
+}
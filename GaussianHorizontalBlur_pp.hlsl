@@ -1,11 +1,27 @@
 //--------------------------------------------------------------------------------------
 // Horizontal Blur Post-Processing Pixel Shader
 //--------------------------------------------------------------------------------------
-// The shader samples a set of texel offsets, weighted according to a Gaussian function.
+// The shader samples a line of taps, weighted according to a Gaussian function. The taps are
+// worked out for the blur's width on the C++ side (GaussianKernel.h), each one after the centre
+// is used on both sides and reads two pixels at once with a bilinear sample.
 //--------------------------------------------------------------------------------------
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match GaussianBlurConstants in PostProcessConstants.h
+cbuffer GaussianBlurConstants : register(b2)
+{
+	float  gBlurSigma; // Not needed here, the taps below are worked out from it
+	int    gNumTaps;
+	float2 paddingA;
+	float4 gBlurTaps[7]; // x = offset from the centre in pixels, y = weight. Size must match GAUSSIAN_MAX_TAPS
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
@@ -13,6 +29,7 @@
 // The rendered scene is stored in a texture.
 Texture2D SceneTexture : register(t0);
 SamplerState PointSample : register(s0);
+SamplerState LinearSample : register(s1); // Bilinear filtering, clamped at the edges
 
 //--------------------------------------------------------------------------------------
 // Shader Code
@@ -20,19 +37,21 @@ SamplerState PointSample : register(s0);
 
 float4 main(PostProcessingInput input) : SV_Target
 {
-    const int numTaps = 5;
-    const float weights[numTaps] = { 0.06136f, 0.24477f, 0.38774f, 0.24477f, 0.06136f };
-    const float offsets[numTaps] = { -2.0f, -1.0f, 0.0f, 1.0f, 2.0f };
-    
-    float3 outputColour = float3(0.0f, 0.0f, 0.0f);
-
-    // Loop through each tap
-    for (unsigned int i = 0; i < numTaps; i++)
-    {
-        // Only move horizontally in this pass.
-        float2 offset = float2(offsets[i] * gBlurStrength * gTexelSize.x, 0.0f);
+    // The blur may be run on a smaller copy of the scene, so step by the size of a pixel in the texture being read
+    float2 textureSize;
+    SceneTexture.GetDimensions(textureSize.x, textureSize.y);
+
+    // Only move horizontally in this pass.
+    float2 step = float2(1.0f, 0.0f) / textureSize;
 
-        outputColour += SceneTexture.Sample(PointSample, input.sceneUV + offset).rgb * weights[i];
+    float3 outputColour = SceneTexture.Sample(PointSample, input.sceneUV).rgb * gBlurTaps[0].y;
+
+    // Loop through each tap after the centre, reading it on both sides
+    for (int i = 1; i < gNumTaps; i++)
+    {
+        float2 offset = step * gBlurTaps[i].x;
+        outputColour += (SceneTexture.Sample(LinearSample, input.sceneUV + offset).rgb +
+                         SceneTexture.Sample(LinearSample, input.sceneUV - offset).rgb) * gBlurTaps[i].y;
     }
 
     return float4(outputColour, 1.0f);
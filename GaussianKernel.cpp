@@ -0,0 +1,72 @@
+//--------------------------------------------------------------------------------------
+// Gaussian blur kernels
+//--------------------------------------------------------------------------------------
+
+#include "GaussianKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Sigma to blur with on an image the viewport size divided by sizeDivisor, for a blur of the given sigma on the viewport
+static float LevelSigma(float sigma, int sizeDivisor)
+{
+	if (sizeDivisor <= 1)  return sigma;
+
+	// Shrinking the image averages squares of sizeDivisor pixels, and scaling it back up spreads each small pixel
+	// over a tent twice that wide. Both blur the image a little already, so take their variance off what's needed
+	float d = static_cast<float>(sizeDivisor);
+	float shrinkVariance  = (d * d - 1.0f) / 12.0f;
+	float scaleUpVariance = d * d / 6.0f;
+	float variance = std::max(sigma * sigma - shrinkVariance - scaleUpVariance, 0.0f);
+	return std::sqrt(variance) / d;
+}
+
+
+int GaussianBlurLevels(float sigma)
+{
+	for (int level = 0; level < GAUSSIAN_MAX_LEVELS; ++level)
+	{
+		if (LevelSigma(sigma, 1 << level) <= GAUSSIAN_MAX_LEVEL_SIGMA)  return level;
+	}
+	return GAUSSIAN_MAX_LEVELS;
+}
+
+
+void SetGaussianBlurKernel(GaussianBlurConstants& settings, int sizeDivisor)
+{
+	float sigma = std::min(LevelSigma(settings.blurSigma, sizeDivisor), GAUSSIAN_MAX_LEVEL_SIGMA);
+
+	// Too narrow to make a difference - just copy the pixel
+	if (sigma < 0.3f)
+	{
+		settings.numTaps = 1;
+		settings.taps[0] = { 0.0f, 1.0f, 0.0f, 0.0f };
+		return;
+	}
+
+	// Weight of each pixel out to 3 sigma (where the curve is near zero), scaled so all the weights add up to 1
+	const int maxRadius = 2 * (GAUSSIAN_MAX_TAPS - 1);
+	int radius = std::min(static_cast<int>(std::ceil(3.0f * sigma)), maxRadius);
+	float weights[maxRadius + 2] = {};
+	float total = 0.0f;
+	for (int i = 0; i <= radius; ++i)
+	{
+		weights[i] = std::exp(-static_cast<float>(i * i) / (2.0f * sigma * sigma));
+		total += (i == 0) ? weights[i] : 2.0f * weights[i];
+	}
+	for (int i = 0; i <= radius; ++i)  weights[i] /= total;
+
+	// Centre pixel on its own, then each pair of pixels after it as one tap. A bilinear sample at the point that splits
+	// the gap between them in proportion to their weights, times the sum of the weights, is their weighted sum
+	settings.taps[0] = { 0.0f, weights[0], 0.0f, 0.0f };
+	settings.numTaps = 1;
+	for (int i = 1; i <= radius; i += 2)
+	{
+		float a = weights[i];
+		float b = weights[i + 1]; // 0 past the radius
+		float weight = a + b;
+		float offset = (i * a + (i + 1) * b) / weight;
+		settings.taps[settings.numTaps++] = { offset, weight, 0.0f, 0.0f };
+	}
+}
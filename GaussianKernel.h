@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// Gaussian blur kernels
+//--------------------------------------------------------------------------------------
+// The Gaussian blur runs as two passes, horizontal then vertical, each a line of taps weighted
+// by a Gaussian curve. The kernel for a blur of any width (sigma, in pixels) is worked out here
+// and sent to the shaders in GaussianBlurConstants, so the HLSL and the CPU version of the blur
+// (CPUPostProcess.h) use exactly the same taps.
+//
+// Each tap after the centre one reads two neighbouring pixels at once: sampling bilinearly at the
+// right point between them gives their weighted sum from a single fetch. This halves the fetches,
+// e.g. a sigma of 4 pixels reads 25 pixels along the line in 13 fetches.
+//
+// The kernel still grows with sigma, so wider blurs are run on a smaller image. A full screen
+// blur of a sigma greater than GAUSSIAN_MAX_LEVEL_SIGMA is run on a copy of the image halved in
+// size one or more times, then scaled back up (the render graph adds these passes, see
+// RenderGraph::Compile). Halving the image halves the sigma needed, so the blur never needs more
+// than GAUSSIAN_MAX_TAPS taps and costs about the same however wide it is. Area and polygon blurs
+// are always run at full size, so are limited to GAUSSIAN_MAX_LEVEL_SIGMA.
+//
+// No DirectX here
+
+#ifndef _GAUSSIAN_KERNEL_H_INCLUDED_
+#define _GAUSSIAN_KERNEL_H_INCLUDED_
+
+#include "PostProcessConstants.h"
+
+
+// Widest blur run directly, in pixels of the image being blurred. A kernel covers 3 sigma each side of the centre
+const float GAUSSIAN_MAX_LEVEL_SIGMA = 4.0f;
+
+// Most times a full screen blur's image is halved, so the widest blur is this many halvings of GAUSSIAN_MAX_LEVEL_SIGMA
+const int GAUSSIAN_MAX_LEVELS = 5;
+
+
+// Number of times to halve the image for a full screen blur of the given sigma (in viewport pixels), 0 to blur at full size
+int GaussianBlurLevels(float sigma);
+
+// Fill in the taps of the blur settings for a blur of settings.blurSigma, run on an image the viewport size divided by
+// sizeDivisor (1 for full size, 2^levels for a blur on a halved image). The sigma is limited to what the taps can cover
+void SetGaussianBlurKernel(GaussianBlurConstants& settings, int sizeDivisor);
+
+
+#endif //_GAUSSIAN_KERNEL_H_INCLUDED_
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------------
+// Vertical Blur Compute Shader
+//--------------------------------------------------------------------------------------
+// The full screen version of GaussianVerticalBlur_pp.hlsl. Each thread group reads a few columns
+// of the image, plus the pixels above and below that the kernel reaches, into group shared memory,
+// then each thread works out its pixel from the taps there (see ComputeTile.h). A tap between two
+// pixels blends them just as the pixel shader's bilinear sample does.
+//--------------------------------------------------------------------------------------
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match GaussianBlurConstants in PostProcessConstants.h
+cbuffer GaussianBlurConstants : register(b2)
+{
+	float  gBlurSigma; // Not needed here, the taps below are worked out from it
+	int    gNumTaps;
+	float2 paddingA;
+	float4 gBlurTaps[7]; // x = offset from the centre in pixels, y = weight. Size must match GAUSSIAN_MAX_TAPS
+}
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+Texture2D<float4>   SceneTexture  : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+//--------------------------------------------------------------------------------------
+// Group shared memory
+//--------------------------------------------------------------------------------------
+
+// Must match GetComputeTileShape in ComputeTile.cpp and COMPUTE_TILE_MAX_BLUR_APRON in ComputeTile.h
+static const int TileWidth  = 4;
+static const int TileHeight = 64;
+static const int MaxApron   = 14;
+
+// Colours of the columns of the tile and the pixels above and below, a row at a time
+groupshared float3 gTile[TileWidth * (TileHeight + 2 * MaxApron)];
+
+//--------------------------------------------------------------------------------------
+// Shader Code
+//--------------------------------------------------------------------------------------
+
+[numthreads(TileWidth, TileHeight, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID, uint threadIndex : SV_GroupIndex)
+{
+    uint imageWidth, imageHeight;
+    SceneTexture.GetDimensions(imageWidth, imageHeight);
+    int2 imageSize = int2(imageWidth, imageHeight);
+
+    // The last tap reads its own pixel and the one after
+    int numTaps = clamp(gNumTaps, 1, 7);
+    int apron = (numTaps > 1) ? min(int(gBlurTaps[numTaps - 1].x) + 1, MaxApron) : 0;
+    int span = TileHeight + 2 * apron;
+    int2 loadStart = int2(groupID.xy) * int2(TileWidth, TileHeight) - int2(0, apron);
+
+    // Load each pixel once, reads past the edges of the image give the edge pixel as the clamped sampler does
+    for (int i = threadIndex; i < TileWidth * span; i += TileWidth * TileHeight)
+    {
+        int2 pixel = clamp(loadStart + int2(i % TileWidth, i / TileWidth), 0, imageSize - 1);
+        gTile[i] = SceneTexture[pixel].rgb;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    int centre = (groupThreadID.y + apron) * TileWidth + groupThreadID.x;
+    float3 outputColour = gTile[centre] * gBlurTaps[0].y;
+
+    // Each tap after the centre on both sides, blending the two pixels it sits between
+    for (int tap = 1; tap < numTaps; tap++)
+    {
+        int   whole    = int(gBlurTaps[tap].x);
+        float fraction = gBlurTaps[tap].x - whole;
+        float3 below = lerp(gTile[centre + whole * TileWidth], gTile[centre + (whole + 1) * TileWidth], fraction);
+        float3 above = lerp(gTile[centre - whole * TileWidth], gTile[centre - (whole + 1) * TileWidth], fraction);
+        outputColour += (below + above) * gBlurTaps[tap].y;
+    }
+
+    int2 pixel = int2(groupID.xy) * int2(TileWidth, TileHeight) + int2(groupThreadID.xy);
+    if (all(pixel < imageSize))
+    {
+        OutputTexture[pixel] = float4(outputColour, 1.0f);
+    }
+}
@@ -6,6 +6,18 @@
 #include "Common.hlsli"
 
 
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match GreyNoiseConstants in PostProcessConstants.h
+cbuffer GreyNoiseConstants : register(b2)
+{
+	float2 gNoiseScale;
+	float2 gNoiseOffset;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
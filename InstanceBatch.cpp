@@ -0,0 +1,39 @@
+//--------------------------------------------------------------------------------------
+// Drawing many copies of a mesh with instancing
+//--------------------------------------------------------------------------------------
+
+#include "InstanceBatch.h"
+
+#include <algorithm>
+
+
+void InstanceBatch::Build(const std::vector<MeshInstance>& instances, const std::vector<CMatrix4x4>& nodeMatrices,
+                          const std::vector<bool>& nodeHasGeometry, int maxPerDraw /*= MAX_INSTANCES_PER_DRAW*/)
+{
+	mInstances.clear();
+	mDraws.clear();
+	if (instances.empty() || maxPerDraw <= 0)  return;
+
+	for (unsigned int node = 0; node < nodeMatrices.size(); ++node)
+	{
+		if (!nodeHasGeometry[node])  continue;
+
+		// Same order as Mesh::Render - the node's matrix relative to the root, then the copy's world matrix (the root)
+		int firstInstance = static_cast<int>(mInstances.size());
+		for (const MeshInstance& instance : instances)
+		{
+			MeshInstance packed = instance;
+			if (node != 0)  packed.worldMatrix = nodeMatrices[node] * instance.worldMatrix;
+			mInstances.push_back(packed);
+		}
+
+		for (int first = 0; first < static_cast<int>(instances.size()); first += maxPerDraw)
+		{
+			InstanceDraw draw;
+			draw.node          = node;
+			draw.firstInstance = firstInstance + first;
+			draw.numInstances  = std::min(maxPerDraw, static_cast<int>(instances.size()) - first);
+			mDraws.push_back(draw);
+		}
+	}
+}
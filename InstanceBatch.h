@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------------------------
+// Drawing many copies of a mesh with instancing
+//--------------------------------------------------------------------------------------
+// Rendering each copy of a mesh as its own model costs a constant buffer upload and a draw call
+// for every node of every copy. Instead the world matrix and tint of every copy are put in a
+// structured buffer and each node of the mesh is drawn once for all the copies with
+// DrawIndexedInstanced. The PixelLightingInstanced_vs shader reads the matrix of each instance.
+//
+// A mesh with several nodes needs a matrix for each node of each copy. The instances are packed
+// node by node, each node's matrix in the default pose (relative to the root) combined with the
+// copy's world matrix. Copies drawn this way can't be animated part by part.
+//
+// No DirectX here - this class does the packing and splitting into draws, Mesh::RenderInstanced
+// uploads and draws
+
+#ifndef _INSTANCE_BATCH_H_INCLUDED_
+#define _INSTANCE_BATCH_H_INCLUDED_
+
+#include "CVector3.h"
+#include "CMatrix4x4.h"
+
+#include <vector>
+
+
+// Most instances in one draw, i.e. the number of elements in the structured buffer
+const int MAX_INSTANCES_PER_DRAW = 1024;
+
+
+// One copy of a mesh as seen by the shaders - must match the MeshInstance structure in Common.hlsli
+struct MeshInstance
+{
+	CMatrix4x4 worldMatrix;
+	CVector3   tint;    // Multiplies the lit colour of this copy
+	float      padding;
+};
+
+
+// One draw of the batch: a range of instances, all for the same node of the mesh
+struct InstanceDraw
+{
+	int node          = 0;
+	int firstInstance = 0;
+	int numInstances  = 0;
+};
+
+
+class InstanceBatch
+{
+public:
+	// Pack the given copies for a mesh whose nodes have the given matrices relative to the root (the root's own matrix is
+	// ignored, the copy's world matrix replaces it). Nodes with no geometry are skipped. Each node's instances are split
+	// into draws of at most maxPerDraw instances
+	void Build(const std::vector<MeshInstance>& instances, const std::vector<CMatrix4x4>& nodeMatrices,
+	           const std::vector<bool>& nodeHasGeometry, int maxPerDraw = MAX_INSTANCES_PER_DRAW);
+
+	const std::vector<MeshInstance>& Instances() const  { return mInstances; }
+	const std::vector<InstanceDraw>& Draws() const      { return mDraws; }
+
+private:
+	std::vector<MeshInstance> mInstances;
+	std::vector<InstanceDraw> mDraws;
+};
+
+
+#endif //_INSTANCE_BATCH_H_INCLUDED_
@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------------
+// Lens star streaks as iterative passes
+//--------------------------------------------------------------------------------------
+
+#include "LensStar.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Direction and colour of each streak, as LensStar_pp.hlsl
+static const CVector2 STREAK_DIRECTIONS[LENS_STAR_STREAKS] = { { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f },
+                                                               { -1.0f, 1.0f }, { 2.0f, 1.0f }, { -2.0f, 1.0f } };
+static const CVector3 STREAK_COLOURS[LENS_STAR_STREAKS] = { { 1.0f, 0.6f, 0.3f }, { 0.3f, 1.0f, 0.6f }, { 1.0f, 0.8f, 0.5f },
+                                                            { 0.5f, 0.8f, 1.0f }, { 1.0f, 0.4f, 0.2f }, { 0.2f, 0.4f, 1.0f } };
+
+
+// Split the length into the taps of each pass, fours first then threes then twos. False if it has another factor, or needs
+// more than LENS_STAR_MAX_PASSES passes
+static bool SplitIntoPasses(int length, std::vector<int>& taps)
+{
+	taps.clear();
+	while (length % 4 == 0)  { taps.push_back(4); length /= 4; }
+	while (length % 3 == 0)  { taps.push_back(3); length /= 3; }
+	while (length % 2 == 0)  { taps.push_back(2); length /= 2; }
+	if (taps.empty())  taps.push_back(1);
+	return length == 1 && static_cast<int>(taps.size()) <= LENS_STAR_MAX_PASSES;
+}
+
+
+std::vector<int> LensStarPassTaps(int streakLength)
+{
+	int maxLength = 1;
+	for (int pass = 0; pass < LENS_STAR_MAX_PASSES; ++pass)  maxLength *= LENS_STAR_MAX_TAPS;
+
+	std::vector<int> taps;
+	int length = std::min(std::max(streakLength, 1), maxLength);
+	while (!SplitIntoPasses(length, taps))  ++length;
+	return taps;
+}
+
+
+int LensStarPasses(int streakLength)
+{
+	return static_cast<int>(LensStarPassTaps(streakLength).size());
+}
+
+
+LensStarStreakConstants MakeLensStarStreakConstants(const LensStarConstants& settings, int streak, int pass, bool backward)
+{
+	LensStarStreakConstants constants = {};
+	constants.tapStep    = { 0.0f, 0.0f };
+	constants.tapWeights = { 0.0f, 0.0f, 0.0f, 0.0f };
+	constants.tint       = { 0.0f, 0.0f, 0.0f };
+	std::vector<int> passTaps = LensStarPassTaps(settings.streakLength);
+	if (streak < 0 || streak >= LENS_STAR_STREAKS || pass < 0 || pass >= static_cast<int>(passTaps.size()))  return constants;
+
+	// Samples between this pass's taps - the reach of the passes before
+	int spacing = 1;
+	for (int before = 0; before < pass; ++before)  spacing *= passTaps[before];
+
+	CVector2 step = Normalise(STREAK_DIRECTIONS[streak]) * settings.stepSize;
+	constants.tapStep  = step * static_cast<float>(backward ? -spacing : spacing);
+	constants.firstTap = (pass == 0) ? 1 : 0; // The centre isn't part of the streak
+	constants.numTaps  = passTaps[pass];
+
+	float tapWeights[LENS_STAR_MAX_TAPS] = {};
+	for (int tap = 0; tap < constants.numTaps; ++tap)
+	{
+		tapWeights[tap] = std::pow(settings.attenuation, static_cast<float>((constants.firstTap + tap) * spacing));
+	}
+	constants.tapWeights = { tapWeights[0], tapWeights[1], tapWeights[2], tapWeights[3] };
+
+	if (pass == static_cast<int>(passTaps.size()) - 1)
+	{
+		// Both sides of the streak hold samples 1 to spacing * taps of this pass
+		float weightSum = 0.0f;
+		for (int sample = 1; sample <= spacing * constants.numTaps; ++sample)
+		{
+			weightSum += 2.0f * std::pow(settings.attenuation, static_cast<float>(sample));
+		}
+		constants.tint     = STREAK_COLOURS[streak] / weightSum;
+		constants.lastPass = (streak == LENS_STAR_STREAKS - 1) ? 2 : 1;
+	}
+	return constants;
+}
@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------------------------
+// Lens star streaks as iterative passes
+//--------------------------------------------------------------------------------------
+// The bloom's lens star used to be one pass (LensStar_pp.hlsl) reading 6 streaks x 12 samples for
+// every pixel, with a pow() for the weight of each sample. The render graph now builds each streak
+// from a few passes of its own, in the quarter size image the bloom makes (see Bloom.h):
+//
+// - Each side of a streak is a sum of streakLength samples a step apart, sample i weighted by
+//   attenuation^i. It is made by up to LENS_STAR_MAX_TAPS taps per pass, each pass reading the one
+//   before. The first pass's taps are 1, 2, 3... steps out, and the taps of every pass after are
+//   as far apart as all the passes before reached, so the step grows with each pass (4x with four
+//   taps, as Kawase's light streaks). Pass n's taps, each over the reach of the passes before,
+//   make every sample from 1 to streakLength exactly once, with exactly its weight.
+// - The last pass of a streak reads the two sides' images from the pass before and writes the
+//   star so far (input 2) plus the streak, tinted and divided by the sum of its weights. The last
+//   streak's last pass also compresses the star's brightness, as LensStar_pp.hlsl does.
+//
+// The weights of the taps are worked out here once per pass rather than for each sample. A longer
+// streak takes more passes only every time it grows four times longer, so its cost per pixel
+// barely changes. The lengths the passes make are products of 2, 3 and 4, other lengths are
+// rounded up to the next such length.
+//
+// The shader is LensStarStreak_pp.hlsl, CPULensStar.h has the CPU version. No DirectX here
+
+#ifndef _LENS_STAR_H_INCLUDED_
+#define _LENS_STAR_H_INCLUDED_
+
+#include "PostProcessConstants.h"
+
+#include <vector>
+
+
+// Number of streaks in the star, each through the centre in its own direction. Also in LensStarStreak_pp.hlsl
+const int LENS_STAR_STREAKS = 6;
+
+// Most taps a streak pass reads along each side of its streak. Also in LensStarStreak_pp.hlsl
+const int LENS_STAR_MAX_TAPS = 4;
+
+// Most passes along each side of a streak, making streaks up to LENS_STAR_MAX_TAPS^LENS_STAR_MAX_PASSES samples long
+const int LENS_STAR_MAX_PASSES = 4;
+
+
+// Taps of each pass along one side of a streak of the given length (samples each side), from the first pass. The product of
+// the taps is the length the passes make, the given length rounded up to a product of 2, 3 and 4 if needed
+std::vector<int> LensStarPassTaps(int streakLength);
+
+// Number of passes along each side of a streak of the given length
+int LensStarPasses(int streakLength);
+
+// Settings for one pass of a streak. Passes before the last read one side of the streak, backward for the side against the
+// streak's direction, and the last pass reads both sides. Returns the settings for an empty pass if the pass isn't needed
+// for the settings' streak length
+LensStarStreakConstants MakeLensStarStreakConstants(const LensStarConstants& settings, int streak, int pass, bool backward);
+
+
+#endif //_LENS_STAR_H_INCLUDED_
@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------
+// Lens Star Streak Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// One pass of one of the lens star's streaks (see LensStar.h). A pass before the last sums a few
+// bilinear taps along one side of the streak from the pass before, each further step apart than
+// the last pass's. The last pass does the same for both sides and adds the streak, tinted, to the
+// star so far. The weights of the taps are worked out on the CPU
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Must match LENS_STAR_MAX_TAPS in LensStar.h
+static const int MaxTaps = 4;
+
+// Settings for this pass, must match LensStarStreakConstants in PostProcessConstants.h
+cbuffer LensStarStreakConstants : register(b2)
+{
+	float2 gTapStep;    // UV offset from one tap to the next in the first texture
+	int    gFirstTap;   // Taps are gFirstTap, gFirstTap + 1... steps from the pixel
+	int    gNumTaps;
+	float4 gTapWeights;
+	float3 gTint;       // Last pass only - the streak's colour over the sum of its weights
+	int    gLastPass;   // 0 before the last pass, 1 for the last pass of a streak, 2 for the last pass of the last streak
+}
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    ForwardTexture  : register(t0); // The pass before, along the streak's direction (or the side this pass sums)
+Texture2D    BackwardTexture : register(t1); // Last pass only - the pass before against the streak's direction
+Texture2D    StarTexture     : register(t2); // Last pass only - the star so far, unbound for the first streak so reads black
+SamplerState LinearSample    : register(s1); // Bilinear filtering, clamped at the edges
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float3 SumTaps(Texture2D source, float2 uv, float2 tapStep)
+{
+	float3 colour = float3(0.0f, 0.0f, 0.0f);
+	[unroll] for (int tap = 0; tap < MaxTaps; ++tap)
+	{
+		if (tap < gNumTaps)
+		{
+			colour += source.Sample(LinearSample, uv + tapStep * (gFirstTap + tap)).rgb * gTapWeights[tap];
+		}
+	}
+	return colour;
+}
+
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float3 colour = SumTaps(ForwardTexture, input.sceneUV, gTapStep);
+	if (gLastPass == 0)  return float4(colour, 1.0f);
+
+	colour += SumTaps(BackwardTexture, input.sceneUV, -gTapStep);
+	float3 star = StarTexture.Sample(LinearSample, input.sceneUV).rgb + colour * gTint;
+
+	// Brightness compression, once the whole star is summed
+	if (gLastPass == 2)  star = star / (star + 1.0f);
+
+	return float4(star, 1.0f);
+}
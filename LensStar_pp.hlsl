@@ -3,6 +3,20 @@
 //--------------------------------------------------------------------------------------
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match LensStarConstants in PostProcessConstants.h
+cbuffer LensStarConstants : register(b2)
+{
+	float  gStepSize;
+	float  gAttenuation;
+	int    gStreakLength; // Samples along each side of a streak
+	float  paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
@@ -47,7 +61,7 @@ float3 CalculateStreak(float2 direction, float3 colourTint, float2 uv)
     float weightSum = 0.0f;
     float2 dir = normalize(direction) * gStepSize;
     
-    for (int i = -numSamples; i <= numSamples; ++i)
+    for (int i = -gStreakLength; i <= gStreakLength; ++i)
     {
         if (i == 0) continue; // Skip center
         
@@ -17,6 +17,11 @@
 #include <assimp/DefaultLogger.hpp>
 
 #include <memory>
+#include <cstring>
+
+
+MeshConstantStatistics gMeshConstantStatistics;
+MeshDrawStatistics     gMeshDrawStatistics;
 
 
 // Pass the name of the mesh file to load. Uses assimp (http://www.assimp.org/) to support many file types
@@ -374,7 +379,7 @@ Mesh::~Mesh()
 //--------------------------------------------------------------------------------------
 
 // Helper function for Render function - renders a given sub-mesh. World matrices / textures / states etc. must already be set
-void Mesh::RenderSubMesh(const SubMesh& subMesh)
+void Mesh::RenderSubMesh(const SubMesh& subMesh, int numInstances /*= 1*/)
 {
 	// Set vertex buffer as next data source for GPU
 	UINT stride = subMesh.vertexSize;
@@ -391,7 +396,16 @@ void Mesh::RenderSubMesh(const SubMesh& subMesh)
 	gD3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	// Render mesh
-	gD3DContext->DrawIndexed(subMesh.numIndices, 0, 0);
+	if (numInstances == 1)
+	{
+		gD3DContext->DrawIndexed(subMesh.numIndices, 0, 0);
+	}
+	else
+	{
+		gD3DContext->DrawIndexedInstanced(subMesh.numIndices, numInstances, 0, 0, 0);
+	}
+	++gMeshDrawStatistics.draws;
+	gMeshDrawStatistics.instances += numInstances;
 }
 
 
@@ -399,21 +413,30 @@ void Mesh::RenderSubMesh(const SubMesh& subMesh)
 // Render the mesh with the given matrices
 // Handles rigid body meshes (including single part meshes) as well as skinned meshes
 // LIMITATION: The mesh must use a single texture throughout
-void Mesh::Render(std::vector<CMatrix4x4>& modelMatrices)
+void Mesh::Render(std::vector<CMatrix4x4>& modelMatrices, const std::vector<CMatrix4x4>& previousModelMatrices,
+                  std::vector<ConstantSlot>& nodeConstants, ConstantSlot& skeletonConstants)
 {
 	// Skinning needs all matrices available in the shader at the same time, so first calculate all the absolute
-	// matrices before rendering anything
+	// matrices before rendering anything. The same again for last frame's matrices
 	std::vector<CMatrix4x4> absoluteMatrices(modelMatrices.size());
+	std::vector<CMatrix4x4> previousAbsoluteMatrices(previousModelMatrices.size());
 	absoluteMatrices[0] = modelMatrices[0]; // First matrix for a model is the root matrix, already in world space
+	previousAbsoluteMatrices[0] = previousModelMatrices[0];
 	for (unsigned int nodeIndex = 1; nodeIndex < mNodes.size(); ++nodeIndex)
 	{
 		// Multiply each model matrix by its parent's absolute world matrix (already calculated earlier in this loop)
 		// Same process as for rigid bodies, simply done prior to rendering now
 		absoluteMatrices[nodeIndex] = modelMatrices[nodeIndex] * absoluteMatrices[mNodes[nodeIndex].parentIndex];
+		previousAbsoluteMatrices[nodeIndex] = previousModelMatrices[nodeIndex] * previousAbsoluteMatrices[mNodes[nodeIndex].parentIndex];
 	}
 
 	if (mHasBones) // Render a mesh that uses skinning
 	{
+		// Shaders that don't skin (such as the velocity pass) draw the whole mesh with the root's world matrix, so it matches
+		// the previous world matrix below. Set it before the offsets are applied
+		gPerModelConstants.worldMatrix         = absoluteMatrices[0];
+		gPerModelConstants.previousWorldMatrix = previousAbsoluteMatrices[0];
+
 		// Advanced point: the above loop will get the absolute world matrices **of the bones**. However, they are
 		// not actually rendered, they merely influence the skinned mesh, which has its origin at a particular node.
 		// So for each bone there is a fixed offset (transform) between where that bone is and where the root of the
@@ -426,17 +449,21 @@ void Mesh::Render(std::vector<CMatrix4x4>& modelMatrices)
 		}
 
 		// Send all matrices over to the GPU for skinning via a constant buffer - each matrix can represent a bone which influences nearby vertices
-		// MISSING - code to fill the gPerModelConstants.boneMatrices array with the contents of the absoluteMatrices vector
+		// MISSING - code to fill the gPerSkeletonConstants.boneMatrices array with the contents of the absoluteMatrices vector
 		for (unsigned int nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex)
 		{
-			gPerModelConstants.boneMatrices[nodeIndex] = absoluteMatrices[nodeIndex];
+			gPerSkeletonConstants.boneMatrices[nodeIndex] = absoluteMatrices[nodeIndex];
 		}
-		UpdateConstantBuffer(gPerModelConstantBuffer, gPerModelConstants); // Send to GPU
+		UploadConstants(nodeConstants[0], gPerModelConstants); // Send to GPU, the whole skinned mesh uses the first node's slot
+		UploadConstants(skeletonConstants, gPerSkeletonConstants);
+		gMeshConstantStatistics.modelBytes    += sizeof(gPerModelConstants);
+		gMeshConstantStatistics.skeletonBytes += sizeof(gPerSkeletonConstants);
+		gMeshConstantStatistics.combinedBytes += sizeof(gPerModelConstants) + sizeof(gPerSkeletonConstants);
 
-		// Indicate that the constant buffer we just updated is for use in the vertex shader (VS), geometry shader (GS) and pixel shader (PS)
-		gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer); // First parameter must match constant buffer number in the shader
-		gD3DContext->GSSetConstantBuffers(1, 1, &gPerModelConstantBuffer); // First parameter must match constant buffer number in the shader
-		gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+		// Indicate that the constants we just uploaded are for use in the vertex shader (VS), geometry shader (GS) and pixel shader (PS)
+		// Only the vertex shader does the skinning so only it needs the bones
+		BindConstants(nodeConstants[0], 1, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_PIXEL); // Number must match constant buffer number in the shader
+		BindConstants(skeletonConstants, 2, SHADER_STAGE_VERTEX);
 
 		// Already sent over all the absolute matrices for the entire mesh so we can render sub-meshes directly
 		// rather than iterating through the nodes. 
@@ -453,13 +480,14 @@ void Mesh::Render(std::vector<CMatrix4x4>& modelMatrices)
 		for (unsigned int nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex)
 		{
 			// Send this node's matrix to the GPU via a constant buffer
-			gPerModelConstants.worldMatrix = absoluteMatrices[nodeIndex];
-			UpdateConstantBuffer(gPerModelConstantBuffer, gPerModelConstants); // Send to GPU
+			gPerModelConstants.worldMatrix         = absoluteMatrices[nodeIndex];
+			gPerModelConstants.previousWorldMatrix = previousAbsoluteMatrices[nodeIndex];
+			UploadConstants(nodeConstants[nodeIndex], gPerModelConstants); // Send to GPU, skipped if the node hasn't changed
+			gMeshConstantStatistics.modelBytes    += sizeof(gPerModelConstants);
+			gMeshConstantStatistics.combinedBytes += sizeof(gPerModelConstants) + sizeof(gPerSkeletonConstants);
 
-			// Indicate that the constant buffer we just updated is for use in the vertex shader (VS) and pixel shader (PS)
-			gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer); // First parameter must match constant buffer number in the shader
-			gD3DContext->GSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
-			gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+			// Indicate that the constants we just uploaded are for use in the vertex shader (VS), geometry shader (GS) and pixel shader (PS)
+			BindConstants(nodeConstants[nodeIndex], 1, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_PIXEL); // Number must match constant buffer number in the shader
 
 			// Render the sub-meshes attached to this node (no bones - rigid movement)
 			for (auto& subMeshIndex : mNodes[nodeIndex].subMeshes)
@@ -471,6 +499,44 @@ void Mesh::Render(std::vector<CMatrix4x4>& modelMatrices)
 }
 
 
+// Render many copies of the mesh, each with its own world matrix and tint, using instancing (see InstanceBatch.h)
+void Mesh::RenderInstanced(const std::vector<MeshInstance>& instances)
+{
+	if (mHasBones || instances.empty())  return;
+
+	// Matrix of each node in its default pose relative to the root, the instance's world matrix takes the place of the root
+	std::vector<CMatrix4x4> nodeMatrices(mNodes.size());
+	std::vector<bool>       nodeHasGeometry(mNodes.size());
+	nodeMatrices[0] = MatrixIdentity();
+	for (unsigned int nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex)
+	{
+		if (nodeIndex > 0)  nodeMatrices[nodeIndex] = mNodes[nodeIndex].defaultMatrix * nodeMatrices[mNodes[nodeIndex].parentIndex];
+		nodeHasGeometry[nodeIndex] = !mNodes[nodeIndex].subMeshes.empty();
+	}
+	mInstanceBatch.Build(instances, nodeMatrices, nodeHasGeometry);
+
+	// The vertex shader reads the instances from a structured buffer
+	gD3DContext->VSSetShaderResources(1, 1, &gMeshInstanceSRV);
+
+	for (const InstanceDraw& draw : mInstanceBatch.Draws())
+	{
+		// Send this draw's instances to the GPU, the buffer holds one draw at a time
+		D3D11_MAPPED_SUBRESOURCE mappedBuffer;
+		if (FAILED(gD3DContext->Map(gMeshInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuffer)))  return;
+		memcpy(mappedBuffer.pData, &mInstanceBatch.Instances()[draw.firstInstance], draw.numInstances * sizeof(MeshInstance));
+		gD3DContext->Unmap(gMeshInstanceBuffer, 0);
+
+		for (auto& subMeshIndex : mNodes[draw.node].subMeshes)
+		{
+			RenderSubMesh(mSubMeshes[subMeshIndex], draw.numInstances);
+		}
+	}
+
+	ID3D11ShaderResourceView* nullSRV = nullptr;
+	gD3DContext->VSSetShaderResources(1, 1, &nullSRV);
+}
+
+
 //--------------------------------------------------------------------------------------
 // Helper functions
 //--------------------------------------------------------------------------------------
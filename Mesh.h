@@ -6,6 +6,8 @@
 // expected to select these things
 
 #include "CMatrix4x4.h"
+#include "ConstantUpload.h"
+#include "InstanceBatch.h"
 #define NOMINMAX // Use this to stop Windows headers defining "min" and "max", which breaks some libraries (e.g. assimp)
 #include <d3d11.h>
 #include <assimp/scene.h>
@@ -15,6 +17,24 @@
 #ifndef _MESH_H_INCLUDED_
 #define _MESH_H_INCLUDED_
 
+// Bytes of constants passed for upload by all meshes, reset by the scene each frame. Shows how much is saved by only sending
+// bone matrices for skinned meshes. Counted before the uploader skips unchanged blocks, so needs no GPU
+struct MeshConstantStatistics
+{
+	int modelBytes    = 0; // Per-model constants (world matrix, colour)
+	int skeletonBytes = 0; // Bone matrices
+	int combinedBytes = 0; // What the same draws would need if every per-model block also held the bone matrices
+};
+extern MeshConstantStatistics gMeshConstantStatistics;
+
+// Draw calls made by all meshes, reset by the scene each frame
+struct MeshDrawStatistics
+{
+	int draws     = 0;
+	int instances = 0; // Copies drawn, more than the draws when instancing
+};
+extern MeshDrawStatistics gMeshDrawStatistics;
+
 class Mesh
 {
 //--------------------------------------------------------------------------------------
@@ -37,10 +57,19 @@ public:
     CMatrix4x4 GetNodeDefaultMatrix(unsigned int node) { return mNodes[node].defaultMatrix; }
 
 
-	// Render the mesh with the given matrices
-	// Handles rigid body meshes (including single part meshes) as well as skinned meshes
+	// Render the mesh with the given matrices, and the matrices it had last frame for the velocity pass
+	// Handles rigid body meshes (including single part meshes) as well as skinned meshes. Skinned meshes only send their
+	// previous root matrix, so the velocity pass sees them move as a whole but not their bones
+	// The constant slots (one per node, plus one for the bone matrices of skinned meshes) remember where the constants were
+	// last uploaded so unchanged nodes aren't sent to the GPU again. Each model has its own slots, see ConstantUpload.h
 	// LIMITATION: The mesh must use a single texture throughout
-	void Render(std::vector<CMatrix4x4>& modelMatrices);
+	void Render(std::vector<CMatrix4x4>& modelMatrices, const std::vector<CMatrix4x4>& previousModelMatrices,
+	            std::vector<ConstantSlot>& nodeConstants, ConstantSlot& skeletonConstants);
+
+	// Render many copies of the mesh, each with its own world matrix and tint, using instancing (see InstanceBatch.h)
+	// Each node of the mesh is drawn in its default pose. The PixelLightingInstanced_vs shader must be selected
+	// LIMITATION: Only for meshes without bones, skinned meshes are not drawn
+	void RenderInstanced(const std::vector<MeshInstance>& instances);
 
 
 
@@ -96,7 +125,8 @@ private:
 	unsigned int ReadNodes(aiNode* assimpNode, unsigned int nodeIndex, unsigned int parentIndex);
 
 	// Helper function for Render function - renders a given sub-mesh. World matrices / textures / states etc. must already be set
-	void RenderSubMesh(const SubMesh& subMesh);
+	// With more than one instance the instances must already be in gMeshInstanceBuffer
+	void RenderSubMesh(const SubMesh& subMesh, int numInstances = 1);
 
 
 
@@ -109,6 +139,8 @@ private:
     std::vector<Node>    mNodes;     // The mesh hierarchy. First entry is root. remainder aree stored in depth-first order
 
 	bool mHasBones; // If any submesh has bones, then all submeshes are given bones - makes rendering easier (one shader for the whole mesh)
+
+	InstanceBatch mInstanceBatch; // Instances packed by the last call to RenderInstanced, kept to reuse the memory
 };
 
 
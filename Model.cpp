@@ -17,6 +17,8 @@ Model::Model(Mesh* mesh, CVector3 position /*= { 0,0,0 }*/, CVector3 rotation /*
     mWorldMatrices.resize(mesh->NumberNodes());
     for (int i = 0; i < mWorldMatrices.size(); ++i)
         mWorldMatrices[i] = mesh->GetNodeDefaultMatrix(i);
+    mPreviousWorldMatrices = mWorldMatrices;
+    mNodeConstants.resize(mesh->NumberNodes());
 }
 
 
@@ -25,7 +27,7 @@ Model::Model(Mesh* mesh, CVector3 position /*= { 0,0,0 }*/, CVector3 rotation /*
 // All other per-frame constants must have been set already along with shaders, textures, samplers, states etc.
 void Model::Render()
 {
-    mMesh->Render(mWorldMatrices);
+    mMesh->Render(mWorldMatrices, mPreviousWorldMatrices, mNodeConstants, mSkeletonConstants);
 }
 
 
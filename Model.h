@@ -6,6 +6,7 @@
 
 #include "CVector3.h"
 #include "CMatrix4x4.h"
+#include "ConstantUpload.h"
 #include "Input.h"
 
 #include <vector>
@@ -29,6 +30,10 @@ public:
     // All other per-frame constants must have been set already along with shaders, textures, samplers, states etc.
     void Render();
 
+	// Call when the frame has been rendered, keeps the current matrices as the previous ones for the next frame. The velocity
+	// pass uses both to find how far each pixel moved (see Velocity_vs.hlsl)
+	void EndFrame()  { mPreviousWorldMatrices = mWorldMatrices; }
+
 
 	// Control a given node in the model using keys provided. Amount of motion performed depends on frame time
 	void Control(int node, float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode turnLeft, KeyCode turnRight,  
@@ -85,6 +90,11 @@ private:
     // Now that meshes have multiple parts, we need multiple matrices. The root matrix (the first one) is the world matrix
     // for the entire model. The remaining matrices are relative to their parent part. The hierarchy is defined in the mesh (nodes)
 	std::vector<CMatrix4x4> mWorldMatrices;
+	std::vector<CMatrix4x4> mPreviousWorldMatrices; // The above as they were last frame, see EndFrame
+
+	// Where the constants of each node were last uploaded, so nodes that haven't moved aren't sent to the GPU again
+	std::vector<ConstantSlot> mNodeConstants;
+	ConstantSlot              mSkeletonConstants; // Bone matrices, only used if the mesh is skinned
 };
 
 
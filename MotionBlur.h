@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// Motion blur from the velocity of each pixel
+//--------------------------------------------------------------------------------------
+// Motion blur used to blend each frame with the one before, which needed a full size copy of every
+// frame kept for the next and smeared static parts of the scene as much as moving ones. It now blurs
+// each pixel along its own movement across the screen, found by the scene rather than guessed:
+//
+// - Velocity: when any pass reads it, the scene is drawn a second time after the colour pass into a
+//   16-bit float image holding how far each pixel moved since the last frame (in UVs), worked out
+//   from the camera's view-projection matrix and each model's world matrix this frame and last
+//   frame, plus the pixel's depth in view space (see ScenePass in RenderGraph.h, Velocity_vs.hlsl).
+// - Tiles: one pixel for each MOTION_BLUR_TILE_SIZE square of the velocity image, holding the
+//   longest velocity in the square in pixels.
+// - Reconstruction (MotionBlur_pp.hlsl): each pixel finds the longest velocity among its tile and
+//   the eight around it. If that is under half a pixel nothing nearby moves and the pixel is copied.
+//   Otherwise it reads MOTION_BLUR_SAMPLES pixels along that velocity, weighting each by whether
+//   its own blur or this pixel's reaches between them, and which of the two is in front - so a
+//   moving object smears over a still background and a still object in front stays sharp.
+//
+// The cost depends on how much of the screen moves, not on its size, and static views cost only
+// the tile pass. The shaders are MotionBlurTiles_pp.hlsl and MotionBlur_pp.hlsl, CPUMotionBlur.h
+// has the CPU versions. No DirectX here
+
+#ifndef _MOTION_BLUR_H_INCLUDED_
+#define _MOTION_BLUR_H_INCLUDED_
+
+
+// Width and height of the square of viewport pixels each tile covers, and so the size divisor of the tile image
+const int MOTION_BLUR_TILE_SIZE = 16;
+
+// Longest blur in viewport pixels. No longer than a tile, so the tiles next to a pixel's own hold every pixel whose blur can
+// reach it (blurs are centred on their pixel). Also in MotionBlur_pp.hlsl
+const float MOTION_BLUR_MAX_PIXELS = 16.0f;
+
+// Pixels read along the blur by each moving pixel. Also in MotionBlur_pp.hlsl
+const int MOTION_BLUR_SAMPLES = 12;
+
+// Difference in view space depth over which one pixel goes from being in front of another to behind it. Also in MotionBlur_pp.hlsl
+const float MOTION_BLUR_DEPTH_RANGE = 1.0f;
+
+
+#endif //_MOTION_BLUR_H_INCLUDED_
@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// Motion Blur Tiles Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// First pass of the motion blur (see MotionBlur.h). Each pixel of the small target covers a square
+// of about 16x16 pixels of the velocity image and finds the longest velocity in it, in pixels.
+// Squares at the right and bottom edges are a little larger where the viewport isn't a multiple of
+// 16 pixels, so every pixel belongs to a tile
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D VelocityTexture : register(t0); // Movement since last frame in UVs and view space depth of each pixel, viewport size
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	uint2 viewportSize;
+	VelocityTexture.GetDimensions(viewportSize.x, viewportSize.y);
+	uint2 numTiles = max(viewportSize / 16, uint2(1, 1)); // As the render graph sizes the tile image
+
+	uint2 tile  = uint2(input.projectedPosition.xy);
+	uint2 start = tile * viewportSize / numTiles;
+	uint2 end   = (tile + 1) * viewportSize / numTiles;
+
+	float2 longest = float2(0.0f, 0.0f);
+	for (uint y = start.y; y < end.y; ++y)
+	{
+		for (uint x = start.x; x < end.x; ++x)
+		{
+			float2 velocity = VelocityTexture.Load(int3(x, y, 0)).xy * viewportSize;
+			if (dot(velocity, velocity) > dot(longest, longest))  longest = velocity;
+		}
+	}
+	return float4(longest, 0.0f, 1.0f);
+}
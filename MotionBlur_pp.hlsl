@@ -1,32 +1,117 @@
 //--------------------------------------------------------------------------------------
 // Motion Blur Post-Processing Pixel Shader
 //--------------------------------------------------------------------------------------
-// Blends current frame with previous frame for motion blur effect
+// Blurs each pixel along the way the scene moves near it (see MotionBlur.h). Pixels with nothing
+// moving in the nearby tiles are copied. The rest read a line of pixels along the longest velocity
+// nearby, centred on this pixel. A pixel on the line is kept if it is in front and its own blur
+// reaches this pixel, if it is behind and this pixel's blur reaches it, or if both blurs reach -
+// a gather of what each pixel would spread over its blur, which keeps edges in the right order
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match MotionBlurConstants in PostProcessConstants.h
+cbuffer MotionBlurConstants : register(b2)
+{
+	float  gShutter; // Fraction of its movement since the last frame each pixel is blurred along
+	float3 paddingA;
+}
+
+// As MOTION_BLUR_MAX_PIXELS, MOTION_BLUR_SAMPLES and MOTION_BLUR_DEPTH_RANGE in MotionBlur.h
+static const float MAX_BLUR_PIXELS = 16.0f;
+static const int   SAMPLES = 12;
+static const float DEPTH_RANGE = 1.0f;
+
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
 
-Texture2D SceneTexture : register(t0);
-Texture2D PreviousFrameTexture : register(t1); // The previous frame's back buffer
-SamplerState PointSample : register(s0); // Using point sampling for both textures
+Texture2D SceneTexture    : register(t0);
+Texture2D VelocityTexture : register(t1); // Movement since last frame in UVs and view space depth of each pixel, viewport size
+Texture2D TileTexture     : register(t2); // Longest velocity of each tile in pixels
+
 
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
 
+// The blur of a velocity in pixels - the part of the movement the shutter is open for, no longer than the longest blur
+float2 Blur(float2 velocityPixels)
+{
+	float2 blur = velocityPixels * gShutter;
+	float  blurLength = length(blur);
+	return (blurLength > MAX_BLUR_PIXELS) ? blur * (MAX_BLUR_PIXELS / blurLength) : blur;
+}
+
+// How much a blur of the given length, centred on its pixel, covers a pixel the given distance away. The cone fades out
+// towards the end of the blur, the cylinder covers the whole blur evenly
+float Cone(float distance, float blurLength)
+{
+	return saturate(1.0f - distance / (blurLength * 0.5f));
+}
+float Cylinder(float distance, float blurLength)
+{
+	return 1.0f - smoothstep(0.475f * blurLength, 0.525f * blurLength, distance);
+}
+
+// 1 if the first depth is in front of the second, fading to 0 as it goes behind
+float InFront(float depth, float otherDepth)
+{
+	return saturate(1.0f - (depth - otherDepth) / DEPTH_RANGE);
+}
+
+
 float4 main(PostProcessingInput input) : SV_Target
 {
-    // Sample the current frame
-    float3 currentColour = SceneTexture.Sample(PointSample, input.sceneUV).rgb;
-    
-    // Sample the previous frame
-    float3 previousColour = PreviousFrameTexture.Sample(PointSample, input.sceneUV).rgb;
-    
-    // Blend the current and previous frames with a blend factor
-    float3 outputColour = lerp(currentColour, previousColour, gBlendFactor);
-    
-    return float4(outputColour, 1.0f);
-}
\ No newline at end of file
+	int2 viewportSize, numTiles;
+	VelocityTexture.GetDimensions(viewportSize.x, viewportSize.y);
+	TileTexture.GetDimensions(numTiles.x, numTiles.y);
+
+	int2   pixel  = min(int2(input.sceneUV * viewportSize), viewportSize - 1);
+	float3 colour = SceneTexture.Load(int3(pixel, 0)).rgb;
+
+	// The longest velocity among the tile holding this pixel and the eight around it
+	int2   tile = min(pixel * numTiles / viewportSize, numTiles - 1);
+	float2 neighbourhoodVelocity = float2(0.0f, 0.0f);
+	for (int tileY = -1; tileY <= 1; ++tileY)
+	{
+		for (int tileX = -1; tileX <= 1; ++tileX)
+		{
+			int2 nearTile = clamp(tile + int2(tileX, tileY), int2(0, 0), numTiles - 1);
+			float2 velocity = TileTexture.Load(int3(nearTile, 0)).xy;
+			if (dot(velocity, velocity) > dot(neighbourhoodVelocity, neighbourhoodVelocity))  neighbourhoodVelocity = velocity;
+		}
+	}
+	float2 neighbourhoodBlur = Blur(neighbourhoodVelocity);
+	if (length(neighbourhoodBlur) < 0.5f)  return float4(colour, 1.0f); // Nothing nearby moves far enough to see
+
+	// This pixel counts for more the shorter its own blur, as it covers fewer pixels with the same colour
+	float4 centre = VelocityTexture.Load(int3(pixel, 0));
+	float  centreLength = max(length(Blur(centre.xy * viewportSize)), 1.0f);
+	float  totalWeight  = 1.0f / centreLength;
+	float3 total = colour * totalWeight;
+
+	// Pixels evenly along the blur, from half of it behind this pixel to half ahead (an even count never reads this pixel again)
+	for (int sample = 0; sample < SAMPLES; ++sample)
+	{
+		float2 offset = neighbourhoodBlur * ((sample + 0.5f) / SAMPLES - 0.5f);
+		int2   samplePixel = clamp(pixel + int2(round(offset)), int2(0, 0), viewportSize - 1);
+		float  distance = length(offset);
+
+		float4 sampleVelocity = VelocityTexture.Load(int3(samplePixel, 0));
+		float  sampleLength = max(length(Blur(sampleVelocity.xy * viewportSize)), 1.0f);
+
+		float weight = InFront(sampleVelocity.z, centre.z) * Cone(distance, sampleLength) +
+		               InFront(centre.z, sampleVelocity.z) * Cone(distance, centreLength) +
+		               Cylinder(distance, sampleLength) * Cylinder(distance, centreLength) * 2.0f;
+		total       += SceneTexture.Load(int3(samplePixel, 0)).rgb * weight;
+		totalWeight += weight;
+	}
+
+	return float4(total / totalWeight, 1.0f);
+}
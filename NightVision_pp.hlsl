@@ -7,6 +7,26 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match NightVisionConstants in PostProcessConstants.h
+cbuffer NightVisionConstants : register(b2)
+{
+	float3 gNightVisionTint;
+	float  gNoiseIntensity;
+	float  gVignetteIntensity;
+	float  gFlickerIntensity;
+	float2 paddingA;
+
+	float3 gBrightnessBoost;
+	float  gLuminanceThreshold;
+	float  gIntensity;
+	float3 paddingB;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures & Samplers
 //--------------------------------------------------------------------------------------
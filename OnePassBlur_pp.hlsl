@@ -2,11 +2,26 @@
 // Full-screen Blur Post-Processing Pixel Shader
 //--------------------------------------------------------------------------------------
 // Applies a simple box blur to the scene texture.
-// The shader samples a 3x3 neighborhood around each pixel and averages the result.
+// The shader samples a square of taps around each pixel and averages the result. By default
+// a 3x3 square two pixels apart. Full screen true box blurs (taps one pixel apart) use
+// SlidingFilter_cs.hlsl instead, which costs the same at any radius.
 //--------------------------------------------------------------------------------------
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match OnePassBlurConstants in PostProcessConstants.h
+cbuffer OnePassBlurConstants : register(b2)
+{
+	int    gBlurRadius; // Taps either side of the centre
+	int    gTapSpacing; // Pixels between taps
+	float2 paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
@@ -22,25 +37,25 @@ SamplerState PointSample : register(s0); // Use point sampling for sharp texel f
 // The input structure (PostProcessingInput) is defined in Common.hlsli.
 // It provides at least the sceneUV coordinates for sampling the scene texture.
 float4 main(PostProcessingInput input) : SV_Target
-{    
+{
+    // The size in UV space from one tap to the next.
+    float2 tapSize = float2(gTapSpacing / gViewportWidth, gTapSpacing / gViewportHeight);
+
     // Initialize the output colour to zero.
     float3 blurredColour = float3(0.0f, 0.0f, 0.0f);
-    
-    // Sample a 3x3 grid around the current pixel.
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(-gTexelSize.x, -gTexelSize.y));
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(0.0f, -gTexelSize.y));
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(gTexelSize.x, -gTexelSize.y));
-    
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(-gTexelSize.x, 0.0f));
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV);
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(gTexelSize.x, 0.0f));
-    
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(-gTexelSize.x, gTexelSize.y));
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(0.0f, gTexelSize.y));
-    blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(gTexelSize.x, gTexelSize.y));
-    
-    // Average the 9 samples.
-    blurredColour /= 9.0;
-        
+
+    // Sample a square around the current pixel.
+    for (int y = -gBlurRadius; y <= gBlurRadius; y++)
+    {
+        for (int x = -gBlurRadius; x <= gBlurRadius; x++)
+        {
+            blurredColour += SceneTexture.Sample(PointSample, input.sceneUV + float2(x, y) * tapSize).rgb;
+        }
+    }
+
+    // Average the samples.
+    float kernelWidth = 2 * gBlurRadius + 1;
+    blurredColour /= kernelWidth * kernelWidth;
+
     return float4(blurredColour, 1.0f);
 }
@@ -0,0 +1,208 @@
+//--------------------------------------------------------------------------------------
+// Finding the nearest colour in a palette
+//--------------------------------------------------------------------------------------
+
+#include "PaletteIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+
+
+const CVector3 RETRO_GAME_PALETTE[RETRO_GAME_PALETTE_SIZE] =
+{
+	{1.0f, 0.0f, 0.0f},   {0.0f, 1.0f, 0.0f},   {0.0f, 0.0f, 1.0f},   {1.0f, 1.0f, 0.0f},    {0.0f, 1.0f, 1.0f},
+	{1.0f, 0.0f, 1.0f},   {1.0f, 1.0f, 1.0f},   {0.75f, 0.75f, 0.75f}, {1.0f, 0.65f, 0.0f},  {0.75f, 0.5f, 0.75f},
+	{0.5f, 0.75f, 0.75f}, {0.75f, 0.75f, 0.5f}, {1.0f, 0.87f, 0.68f}, {0.68f, 0.85f, 0.9f},  {0.82f, 0.93f, 0.75f},
+	{1.0f, 0.8f, 0.8f},   {0.5f, 0.0f, 0.0f},   {0.0f, 0.5f, 0.0f},   {0.0f, 0.0f, 0.5f},    {0.6f, 0.4f, 0.2f},
+	{0.4f, 0.2f, 0.6f},   {0.2f, 0.6f, 0.4f},   {0.9f, 0.4f, 0.6f},   {0.95f, 0.9f, 0.1f},   {0.1f, 0.7f, 0.9f},
+};
+
+
+//--------------------------------------------------------------------------------------
+// Palette index
+//--------------------------------------------------------------------------------------
+
+// Distances are found in 32-bit floats when searching, so an entry is kept if it is within this much of being the
+// nearest. Keeps every entry that could come out nearest (or equally near) after rounding
+static const double CandidateTolerance = 1e-5;
+
+void PaletteIndex::Build(const CVector3* palette, int paletteSize)
+{
+	mPalette.assign(palette, palette + std::max(paletteSize, 0));
+
+	const int numCells = PALETTE_GRID_SIZE * PALETTE_GRID_SIZE * PALETTE_GRID_SIZE;
+	mData.assign(numCells, 0);
+	size_t totalCandidates = 0;
+
+	std::vector<double> nearestDistances(mPalette.size());
+	const double cellSize = 1.0 / PALETTE_GRID_SIZE;
+	for (int cell = 0; cell < numCells; ++cell)
+	{
+		const int cellPosition[3] = { cell % PALETTE_GRID_SIZE, (cell / PALETTE_GRID_SIZE) % PALETTE_GRID_SIZE,
+		                              cell / (PALETTE_GRID_SIZE * PALETTE_GRID_SIZE) };
+
+		// For each entry, the distance to the nearest and furthest points of the cell. No colour in the cell is further from
+		// its nearest entry than the smallest of the furthest distances
+		double furthestBound = 1e9;
+		for (size_t entry = 0; entry < mPalette.size(); ++entry)
+		{
+			const float* colour = &mPalette[entry].x;
+			double nearestSq = 0, furthestSq = 0;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				double cellMin = cellPosition[axis] * cellSize;
+				double cellMax = cellMin + cellSize;
+				double below = cellMin - colour[axis];
+				double above = colour[axis] - cellMax;
+				double outside = std::max({ below, above, 0.0 });
+				double furthest = std::max(std::abs(colour[axis] - cellMin), std::abs(colour[axis] - cellMax));
+				nearestSq  += outside * outside;
+				furthestSq += furthest * furthest;
+			}
+			nearestDistances[entry] = std::sqrt(nearestSq);
+			furthestBound = std::min(furthestBound, std::sqrt(furthestSq));
+		}
+
+		mData[cell] = static_cast<uint32_t>(mData.size());
+		mData.push_back(0);
+		size_t countPosition = mData.size() - 1;
+		for (size_t entry = 0; entry < mPalette.size(); ++entry)
+		{
+			if (nearestDistances[entry] <= furthestBound + CandidateTolerance)
+			{
+				mData.push_back(static_cast<uint32_t>(entry));
+				++mData[countPosition];
+			}
+		}
+		totalCandidates += mData[countPosition];
+	}
+
+	mAverageCandidates = static_cast<float>(totalCandidates) / numCells;
+}
+
+
+int PaletteIndex::Nearest(const CVector3& colour) const
+{
+	if (colour.x < 0.0f || colour.x > 1.0f || colour.y < 0.0f || colour.y > 1.0f || colour.z < 0.0f || colour.z > 1.0f)
+	{
+		return NearestPaletteEntry(mPalette.data(), static_cast<int>(mPalette.size()), colour);
+	}
+	if (mData.empty())  return -1;
+
+	int cellX = std::min(static_cast<int>(colour.x * PALETTE_GRID_SIZE), PALETTE_GRID_SIZE - 1);
+	int cellY = std::min(static_cast<int>(colour.y * PALETTE_GRID_SIZE), PALETTE_GRID_SIZE - 1);
+	int cellZ = std::min(static_cast<int>(colour.z * PALETTE_GRID_SIZE), PALETTE_GRID_SIZE - 1);
+	const uint32_t* list = &mData[mData[cellX + PALETTE_GRID_SIZE * (cellY + PALETTE_GRID_SIZE * cellZ)]];
+
+	if (list[0] == 1)  return static_cast<int>(list[1]); // Most cells
+
+	// Same search as NearestPaletteEntry, over the cell's list only
+	float minDistance = 1e9f;
+	int nearest = -1;
+	for (uint32_t i = 1; i <= list[0]; ++i)
+	{
+		float distance = Length(colour - mPalette[list[i]]);
+		if (distance < minDistance)
+		{
+			minDistance = distance;
+			nearest = static_cast<int>(list[i]);
+		}
+	}
+	return nearest;
+}
+
+
+int NearestPaletteEntry(const CVector3* palette, int paletteSize, const CVector3& colour)
+{
+	float minDistance = 1e9f;
+	int nearest = -1;
+	for (int i = 0; i < paletteSize; ++i)
+	{
+		float distance = Length(colour - palette[i]);
+		if (distance < minDistance)
+		{
+			minDistance = distance;
+			nearest = i;
+		}
+	}
+	return nearest;
+}
+
+
+const PaletteIndex& RetroGamePaletteIndex(int paletteSize)
+{
+	static std::once_flag builtFlags[RETRO_GAME_PALETTE_SIZE + 1];
+	static PaletteIndex    indices[RETRO_GAME_PALETTE_SIZE + 1];
+
+	paletteSize = std::min(std::max(paletteSize, 0), RETRO_GAME_PALETTE_SIZE);
+	std::call_once(builtFlags[paletteSize], [paletteSize]() { indices[paletteSize].Build(RETRO_GAME_PALETTE, paletteSize); });
+	return indices[paletteSize];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Dither
+//--------------------------------------------------------------------------------------
+
+float OrderedDither(int x, int y)
+{
+	// 4x4 Bayer matrix, each step in the pattern as far as possible from the ones before
+	static const int bayer[16] = { 0, 8, 2, 10,  12, 4, 14, 6,  3, 11, 1, 9,  15, 7, 13, 5 };
+	return (bayer[(y & 3) * 4 + (x & 3)] + 0.5f) / 16.0f - 0.5f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Timing
+//--------------------------------------------------------------------------------------
+
+PaletteIndexTiming MeasurePaletteIndex(int width, int height, int paletteSize, int numRuns)
+{
+	numRuns = std::max(numRuns, 1);
+	paletteSize = std::min(std::max(paletteSize, 0), RETRO_GAME_PALETTE_SIZE);
+
+	auto milliseconds = [](std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+	std::vector<CVector3> colours(static_cast<size_t>(width) * height);
+	for (CVector3& colour : colours)  colour = { channel(random), channel(random), channel(random) };
+
+	PaletteIndexTiming timing;
+	PaletteIndex index;
+	std::vector<int> bruteForceResults(colours.size()), indexResults(colours.size());
+	for (int run = 0; run < numRuns; ++run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		index.Build(RETRO_GAME_PALETTE, paletteSize);
+		double buildMilliseconds = milliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < colours.size(); ++i)
+		{
+			bruteForceResults[i] = NearestPaletteEntry(RETRO_GAME_PALETTE, paletteSize, colours[i]);
+		}
+		double bruteForceMilliseconds = milliseconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < colours.size(); ++i)  indexResults[i] = index.Nearest(colours[i]);
+		double indexMilliseconds = milliseconds(start);
+
+		if (run == 0 || buildMilliseconds < timing.buildMilliseconds)            timing.buildMilliseconds      = buildMilliseconds;
+		if (run == 0 || bruteForceMilliseconds < timing.bruteForceMilliseconds)  timing.bruteForceMilliseconds = bruteForceMilliseconds;
+		if (run == 0 || indexMilliseconds < timing.indexMilliseconds)            timing.indexMilliseconds      = indexMilliseconds;
+	}
+
+	for (size_t i = 0; i < colours.size(); ++i)
+	{
+		if (bruteForceResults[i] != indexResults[i])  ++timing.mismatches;
+	}
+	timing.averageCandidates = index.AverageCandidates();
+	return timing;
+}
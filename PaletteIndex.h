@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------------------------
+// Finding the nearest colour in a palette
+//--------------------------------------------------------------------------------------
+// The retro game effect replaces each colour with the nearest entry of a palette of up to 25
+// colours. Measuring the distance to every entry for every pixel is slow, so a PaletteIndex is
+// built once for each palette to cut the search down to a few entries.
+//
+// Colour space (0->1 on each channel) is split into a grid of cells. For each cell, the index lists
+// the entries that could be the nearest to some colour inside it: an entry is left out if even its
+// closest approach to the cell is further away than another entry's furthest point from the cell.
+// Most cells have a single entry on their list, so looking up a colour is a constant time grid
+// lookup. Cells on the boundary between two entries keep both, and the search over the short list
+// is done just as the full search was, so the result is always the same as searching the whole
+// palette. Colours outside 0->1 search the whole palette.
+//
+// The same index is used on the CPU and, as a buffer of integers, by RetroGame_pp.hlsl.
+//
+// Also the ordered dither used by the retro game and Game Boy effects: an offset for each pixel
+// from a 4x4 pattern, added before a colour is snapped to a palette or shade so areas of colour
+// between two entries come out as a fine mix of both. No DirectX here
+
+#ifndef _PALETTE_INDEX_H_INCLUDED_
+#define _PALETTE_INDEX_H_INCLUDED_
+
+#include "CVector3.h"
+
+#include <cstdint>
+#include <vector>
+
+
+// The palette of the retro game effect, of which the first RetroGameConstants::paletteSize entries are used
+// Must match gColourPalette in RetroGame_pp.hlsl
+const int RETRO_GAME_PALETTE_SIZE = 25;
+extern const CVector3 RETRO_GAME_PALETTE[RETRO_GAME_PALETTE_SIZE];
+
+// Cells along each side of the grid. Must match PaletteGridSize in RetroGame_pp.hlsl
+const int PALETTE_GRID_SIZE = 32;
+
+
+class PaletteIndex
+{
+public:
+	// Build the index for the given palette
+	void Build(const CVector3* palette, int paletteSize);
+
+	// Position in the palette of the entry nearest to the colour, -1 if the palette is empty. The same as
+	// NearestPaletteEntry below, ties going to the earlier entry
+	int Nearest(const CVector3& colour) const;
+
+	const std::vector<CVector3>& Palette() const  { return mPalette; }
+
+	// The index as sent to the GPU. The first PALETTE_GRID_SIZE^3 values are the start of each cell's list, red changing
+	// fastest. Each list is the number of entries followed by their positions in the palette, in palette order
+	const std::vector<uint32_t>& Data() const  { return mData; }
+
+	// Average length of the cells' lists
+	float AverageCandidates() const  { return mAverageCandidates; }
+
+
+private:
+	std::vector<CVector3> mPalette;
+	std::vector<uint32_t> mData;
+	float                 mAverageCandidates = 0;
+};
+
+
+// Search every entry of the palette for the one nearest to the colour, the first if several are as near. -1 if the
+// palette is empty
+int NearestPaletteEntry(const CVector3* palette, int paletteSize, const CVector3& colour);
+
+// The index for the first paletteSize entries of RETRO_GAME_PALETTE (clamped to 0->RETRO_GAME_PALETTE_SIZE). Each is built
+// the first time it is asked for, and can be used from several threads
+const PaletteIndex& RetroGamePaletteIndex(int paletteSize);
+
+
+// Ordered dither offset in -0.5->0.5 for a position on a grid (a pixel, or a block of a pixelated effect)
+// Must match OrderedDither in Common.hlsli
+float OrderedDither(int x, int y);
+
+
+//--------------------------------------------------------------------------------------
+// Timing
+//--------------------------------------------------------------------------------------
+
+struct PaletteIndexTiming
+{
+	double buildMilliseconds      = 0; // Building the index
+	double bruteForceMilliseconds = 0; // Finding the nearest entry for every pixel by searching the whole palette
+	double indexMilliseconds      = 0; // The same with the index
+	int    mismatches             = 0; // Pixels where the two disagree, should always be 0
+	float  averageCandidates      = 0;
+};
+
+// Time both searches over a frame of random colours of the given size (e.g. 3840x2160), for the first paletteSize entries
+// of the retro game palette. The fastest of the given number of runs is taken for each time
+PaletteIndexTiming MeasurePaletteIndex(int width, int height, int paletteSize, int numRuns);
+
+
+#endif //_PALETTE_INDEX_H_INCLUDED_
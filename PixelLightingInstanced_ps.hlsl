@@ -0,0 +1,52 @@
+//--------------------------------------------------------------------------------------
+// Instanced Per-Pixel Lighting Pixel Shader
+//--------------------------------------------------------------------------------------
+// The same lighting as the PixelLighting_ps shader, with the result tinted by the colour of the
+// instance being drawn (see PixelLightingInstanced_vs)
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D DiffuseSpecularMap : register(t0); // Diffuse map (main colour) in rgb channels and a specular map (shininess) in the a channel
+SamplerState TexSampler      : register(s0);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(InstancedLightingPixelShaderInput input) : SV_Target
+{
+    input.worldNormal = normalize(input.worldNormal);
+    float3 cameraDirection = normalize(gCameraPosition - input.worldPosition);
+
+	//// Light 1 ////
+
+	float3 light1Direction = normalize(gLight1Position - input.worldPosition);
+    float3 light1Dist = length(gLight1Position - input.worldPosition);
+    float3 diffuseLight1 = gLight1Colour * max(dot(input.worldNormal, light1Direction), 0) / light1Dist;
+    float3 halfway = normalize(light1Direction + cameraDirection);
+    float3 specularLight1 = diffuseLight1 * pow(max(dot(input.worldNormal, halfway), 0), gSpecularPower);
+
+	//// Light 2 ////
+
+	float3 light2Direction = normalize(gLight2Position - input.worldPosition);
+    float3 light2Dist = length(gLight2Position - input.worldPosition);
+    float3 diffuseLight2 = gLight2Colour * max(dot(input.worldNormal, light2Direction), 0) / light2Dist;
+    halfway = normalize(light2Direction + cameraDirection);
+    float3 specularLight2 = diffuseLight2 * pow(max(dot(input.worldNormal, halfway), 0), gSpecularPower);
+
+	float3 diffuseLight = gAmbientColour + diffuseLight1 + diffuseLight2;
+	float3 specularLight = specularLight1 + specularLight2;
+
+
+	// Combine lighting with texture colours, then tint
+    float4 textureColour = DiffuseSpecularMap.Sample(TexSampler, input.uv);
+    float3 finalColour = diffuseLight * textureColour.rgb + specularLight * textureColour.a;
+
+    return float4(finalColour * input.tint, 1.0f);
+}
@@ -0,0 +1,44 @@
+//--------------------------------------------------------------------------------------
+// Instanced Per-Pixel Lighting Vertex Shader
+//--------------------------------------------------------------------------------------
+// Same as the PixelLighting_vs shader, but draws many copies of a mesh in one draw call using
+// instancing. The world matrix of each copy comes from a structured buffer rather than the
+// per-model constant buffer, one element per instance
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Instances
+//--------------------------------------------------------------------------------------
+
+// The copies to draw, filled in by the C++ side (see InstanceBatch.h)
+StructuredBuffer<MeshInstance> MeshInstances : register(t1);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+// The instance ID picks the copy of the mesh, otherwise the same transformations as PixelLighting_vs
+InstancedLightingPixelShaderInput main(BasicVertex modelVertex, uint instanceId : SV_InstanceID)
+{
+    InstancedLightingPixelShaderInput output;
+
+    float4x4 worldMatrix = MeshInstances[instanceId].worldMatrix;
+
+    float4 modelPosition = float4(modelVertex.position, 1);
+    precise float4 worldPosition     = mul(worldMatrix,       modelPosition); // 'precise' for the same depth as the velocity pass
+    precise float4 viewPosition      = mul(gViewMatrix,       worldPosition);
+    precise float4 projectedPosition = mul(gProjectionMatrix, viewPosition);
+    output.projectedPosition = projectedPosition;
+
+    float4 modelNormal = float4(modelVertex.normal, 0);
+    output.worldNormal   = mul(worldMatrix, modelNormal).xyz;
+    output.worldPosition = worldPosition.xyz;
+
+    output.uv   = modelVertex.uv;
+    output.tint = MeshInstances[instanceId].tint;
+
+    return output;
+}
@@ -24,9 +24,12 @@ LightingPixelShaderInput main(BasicVertex modelVertex)
     // Multiply by the world matrix passed from C++ to transform the model vertex position into world space. 
     // In a similar way use the view matrix to transform the vertex from world space into view space (camera's point of view)
     // and then use the projection matrix to transform the vertex to 2D projection space (project onto the 2D screen)
-    float4 worldPosition     = mul(gWorldMatrix,      modelPosition);
-    float4 viewPosition      = mul(gViewMatrix,       worldPosition);
-    output.projectedPosition = mul(gProjectionMatrix, viewPosition);
+    // These are 'precise' so the depth comes out exactly the same in every pass that draws the scene, which the velocity pass
+    // relies on when it tests against this pass's depth (see Velocity_vs)
+    precise float4 worldPosition     = mul(gWorldMatrix,      modelPosition);
+    precise float4 viewPosition      = mul(gViewMatrix,       worldPosition);
+    precise float4 projectedPosition = mul(gProjectionMatrix, viewPosition);
+    output.projectedPosition = projectedPosition;
 
     // Also transform model normals into world space using world matrix - lighting will be calculated in world space
     // Pass this normal to the pixel shader as it is needed to calculate per-pixel lighting
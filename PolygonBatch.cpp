@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// Batching several polygon post-processes into one draw
+//--------------------------------------------------------------------------------------
+
+#include "PolygonBatch.h"
+
+#include <algorithm>
+
+
+void PolygonBatch::Build(const std::vector<PolygonBatchItem>& items, const CMatrix4x4& viewProjection, int viewportWidth, int viewportHeight)
+{
+	mInstances.clear();
+	mDraws.clear();
+
+	for (const PolygonBatchItem& item : items)
+	{
+		PostProcessDeclaration declaration = GetPostProcessDeclaration(item.effect);
+		if (declaration.polygonBatchEffect < 0)  continue;
+
+		// Same transform as the single polygon post-process in Scene.cpp
+		PolygonInstance instance = {};
+		for (unsigned int i = 0; i < item.points.size(); ++i)
+		{
+			instance.points[i] = CVector4(item.points[i], 1) * viewProjection;
+		}
+		instance.effect = declaration.polygonBatchEffect;
+		instance.parameters[0] = item.parameters[0];
+		instance.parameters[1] = item.parameters[1];
+
+		PixelRect drawRect = PolygonPixelRect(instance.points, 4, viewportWidth, viewportHeight);
+		if (drawRect.IsEmpty())  continue; // Off screen
+		PixelRect copyRect = ExpandByFootprint(drawRect, declaration, viewportWidth, viewportHeight);
+
+		// Start a new draw if this polygon covers part of a polygon already in the current draw - it must see their result
+		// The rectangles are rounded outwards, so shrink them by a pixel or polygons that share an edge would appear to overlap
+		bool newDraw = mDraws.empty() || mDraws.back().numInstances == MAX_BATCHED_POLYGONS;
+		if (!newDraw)
+		{
+			PixelRect inner = { drawRect.left + 1, drawRect.top + 1, drawRect.right - 1, drawRect.bottom - 1 };
+			for (const PixelRect& written : mDraws.back().drawRects)
+			{
+				PixelRect writtenInner = { written.left + 1, written.top + 1, written.right - 1, written.bottom - 1 };
+				if (RectsOverlap(inner, writtenInner))  newDraw = true;
+			}
+		}
+		if (newDraw)
+		{
+			PolygonBatchDraw draw;
+			draw.firstInstance = static_cast<int>(mInstances.size());
+			mDraws.push_back(draw);
+		}
+
+		PolygonBatchDraw& draw = mDraws.back();
+		++draw.numInstances;
+		draw.copyRects.push_back(copyRect);
+		draw.drawRects.push_back(drawRect);
+		mInstances.push_back(instance);
+	}
+}
+
+
+int PolygonBatch::CopiedPixels() const
+{
+	int pixels = 0;
+	for (const PolygonBatchDraw& draw : mDraws)
+	{
+		for (const PixelRect& rect : draw.copyRects)  pixels += rect.Area();
+	}
+	return pixels;
+}
+
+
+PixelRect BoundingRect(const std::vector<PixelRect>& rects)
+{
+	PixelRect bounds;
+	for (const PixelRect& rect : rects)
+	{
+		if (rect.IsEmpty())  continue;
+		if (bounds.IsEmpty())
+		{
+			bounds = rect;
+			continue;
+		}
+		bounds.left   = std::min(bounds.left,   rect.left);
+		bounds.top    = std::min(bounds.top,    rect.top);
+		bounds.right  = std::max(bounds.right,  rect.right);
+		bounds.bottom = std::max(bounds.bottom, rect.bottom);
+	}
+	return bounds;
+}
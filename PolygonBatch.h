@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// Batching several polygon post-processes into one draw
+//--------------------------------------------------------------------------------------
+// The window polygons each run a different simple effect over a different part of the screen.
+// Rather than a constant buffer upload, state setup and draw for each one, all the polygons are
+// put in a structured buffer and drawn as instances of a single quad. The 2DPolygonBatch_pp vertex
+// shader places each instance and the PolygonBatch_pp pixel shader picks the effect per polygon.
+//
+// Every polygon in a draw reads the same copy of the image, taken before the draw. Where a polygon
+// covers part of an earlier one (e.g. a far window seen through a near one) it needs to see the
+// earlier result, so the batch is split into several draws there. Windows that only share an edge
+// stay in the same draw - the few pixels of the neighbouring window that an effect like the
+// wireframe samples beyond its edge come from the image before the batch.
+//
+// No DirectX here - this class does the projection and packing, Scene.cpp uploads and draws
+
+#ifndef _POLYGON_BATCH_H_INCLUDED_
+#define _POLYGON_BATCH_H_INCLUDED_
+
+#include "PostProcessRegion.h"
+#include "CVector3.h"
+#include "CVector4.h"
+#include "CMatrix4x4.h"
+
+#include <array>
+#include <vector>
+
+
+// Most polygons in one draw, i.e. the number of elements in the structured buffer
+const int MAX_BATCHED_POLYGONS = 32;
+
+
+// One polygon as seen by the shaders - must match the PolygonInstance structure in Common.hlsli
+// Parameters for each effect:
+//   Sepia, Invert - none
+//   Wireframe     - parameters[0] = texel size x, texel size y, edge threshold, edge power
+//   GameBoy       - parameters[0] = colour r, g, b, pixel size. parameters[1].x = colour depth, .y = dither amount
+//   Distort       - parameters[0].x = distort level
+struct PolygonInstance
+{
+	CVector4 points[4];     // Points of the polygon, already transformed by the view-projection matrix
+	int      effect;        // Effect number in PolygonBatch_pp.hlsl (see PostProcessDeclaration::polygonBatchEffect)
+	int      padding[3];
+	CVector4 parameters[2]; // Effect settings, as listed above
+};
+
+
+// A polygon post-process to add to a batch
+struct PolygonBatchItem
+{
+	PostProcess             effect;
+	std::array<CVector3, 4> points;        // World space points, in the order used by the 2DPolygon vertex shader
+	CVector4                parameters[2]; // Effect settings, see PolygonInstance
+};
+
+
+// One draw of the batch: a range of instances and the parts of the image to copy before drawing them
+struct PolygonBatchDraw
+{
+	int firstInstance = 0;
+	int numInstances  = 0;
+	std::vector<PixelRect> copyRects; // Pixels read by the polygons in this draw (each polygon's region plus its halo)
+	std::vector<PixelRect> drawRects; // Pixels written by each polygon, the union is used as the scissor rectangle
+};
+
+
+class PolygonBatch
+{
+public:
+	// Project the given polygons and split them into draws. Polygons that are off screen are left out
+	// Items whose effect has no batched version (see PostProcessDeclaration::polygonBatchEffect) are ignored
+	void Build(const std::vector<PolygonBatchItem>& items, const CMatrix4x4& viewProjection, int viewportWidth, int viewportHeight);
+
+	const std::vector<PolygonInstance>&  Instances() const  { return mInstances; }
+	const std::vector<PolygonBatchDraw>& Draws() const      { return mDraws; }
+
+	// Total pixels covered by the copies of all draws
+	int CopiedPixels() const;
+
+private:
+	std::vector<PolygonInstance>  mInstances;
+	std::vector<PolygonBatchDraw> mDraws;
+};
+
+
+// Smallest rectangle containing all the given rectangles
+PixelRect BoundingRect(const std::vector<PixelRect>& rects);
+
+
+#endif //_POLYGON_BATCH_H_INCLUDED_
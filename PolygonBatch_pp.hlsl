@@ -0,0 +1,144 @@
+//--------------------------------------------------------------------------------------
+// Batched Polygon Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Used with the 2DPolygonBatch_pp vertex shader to draw several polygons in one draw call, each with a
+// different effect. Contains the sepia, wireframe, game boy, invert and distort effects, which work the
+// same as their own shaders (Sepia_pp.hlsl etc.) except that their settings come from the polygon
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures & Samplers
+//--------------------------------------------------------------------------------------
+
+Texture2D    SceneTexture  : register(t0);
+SamplerState PointSample   : register(s0);
+
+// Distortion map for the distort effect
+Texture2D    DistortMap    : register(t1);
+SamplerState TrilinearWrap : register(s1);
+
+// The polygons being drawn, see 2DPolygonBatch_pp.hlsl
+StructuredBuffer<PolygonInstance> PolygonInstances : register(t3);
+
+
+// Effect numbers - must agree with PostProcessDeclaration::polygonBatchEffect in PostProcess.cpp
+static const int EFFECT_SEPIA     = 0;
+static const int EFFECT_WIREFRAME = 1;
+static const int EFFECT_GAMEBOY   = 2;
+static const int EFFECT_INVERT    = 3;
+static const int EFFECT_DISTORT   = 4;
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+
+float3 Sepia(float2 sceneUV)
+{
+	float3 sampledColour = SceneTexture.Sample(PointSample, sceneUV).rgb;
+
+	float3 outputColour;
+	outputColour.r = dot(sampledColour, float3(0.393f, 0.769f, 0.189f));
+	outputColour.g = dot(sampledColour, float3(0.349f, 0.686f, 0.168f));
+	outputColour.b = dot(sampledColour, float3(0.272f, 0.534f, 0.131f));
+	return outputColour;
+}
+
+
+// Parameters: texel size x, texel size y, edge threshold, edge power
+float3 Wireframe(float2 sceneUV, float4 parameters)
+{
+	float2 texelSize     = parameters.xy;
+	float  edgeThreshold = parameters.z;
+	float  edgePower     = parameters.w;
+
+	// Sobel kernels
+	const float kernelX[9] = { -1.0f, 0.0f, 1.0f, -2.0f, 0.0f, 2.0f, -1.0f, 0.0f, 1.0f };
+	const float kernelY[9] = { -1.0f, -2.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 1.0f };
+
+	float gradientX = 0.0f;
+	float gradientY = 0.0f;
+	int index = 0;
+	for (int x = -1; x <= 1; x++)
+	{
+		for (int y = -1; y <= 1; y++)
+		{
+			float3 colour = SceneTexture.Sample(PointSample, sceneUV + float2(x, y) * texelSize).rgb;
+			float gray = dot(colour, float3(0.299f, 0.587f, 0.114f));
+			gradientX += gray * kernelX[index];
+			gradientY += gray * kernelY[index];
+			index++;
+		}
+	}
+	float edge = sqrt(gradientX * gradientX + gradientY * gradientY);
+
+	// White-on-black wireframe
+	edge = saturate(pow(edge, edgePower) * (1.0f / edgeThreshold));
+	return float3(edge, edge, edge);
+}
+
+
+// Parameters: colour r, g, b, pixel size, then colour depth, dither amount
+float3 GameBoy(float2 sceneUV, float4 parameters0, float4 parameters1)
+{
+	float3 colour       = parameters0.rgb;
+	float  pixelSize    = parameters0.w;
+	float  colourDepth  = parameters1.x;
+	float  ditherAmount = parameters1.y;
+
+	float2 pixelatedUV = floor(sceneUV * pixelSize) / pixelSize;
+	float3 sampledColour = SceneTexture.Sample(PointSample, pixelatedUV).rgb;
+
+	// Grayscale with limited colour depth, then tinted
+	float grayscale = 0.299f * sampledColour.r + 0.587f * sampledColour.g + 0.114f * sampledColour.b;
+	float dither = OrderedDither(int2(floor(sceneUV * pixelSize))) * ditherAmount;
+	grayscale = round(grayscale * colourDepth + dither) / colourDepth;
+	return grayscale * colour;
+}
+
+
+float3 Invert(float2 sceneUV)
+{
+	return 1.0f - SceneTexture.Sample(PointSample, sceneUV).rgb;
+}
+
+
+// Parameters: distort level
+float3 Distort(float2 sceneUV, float2 areaUV, float4 parameters)
+{
+	const float lightStrength = 0.015f;
+	const float glassDarken = 0.8f;
+	float distortLevel = parameters.x;
+
+	// Direction to distort UVs, from the g & b components of the distortion texture, in -0.5->0.5 range
+	float2 distortVector = DistortMap.Sample(TrilinearWrap, areaUV).gb - float2(0.5f, 0.5f);
+
+	// Fake diffuse lighting from the top-left plus the scene sampled with the distorted UVs
+	float light = dot(normalize(distortVector), float2(0.707f, 0.707f)) * lightStrength;
+	return light + SceneTexture.Sample(PointSample, sceneUV + distortLevel * distortVector).rgb * glassDarken;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PolygonBatchInput input) : SV_Target
+{
+	PolygonInstance polygon = PolygonInstances[input.polygon];
+
+	float3 outputColour;
+	switch (polygon.effect)
+	{
+	case EFFECT_SEPIA:     outputColour = Sepia(input.sceneUV); break;
+	case EFFECT_WIREFRAME: outputColour = Wireframe(input.sceneUV, polygon.parameters[0]); break;
+	case EFFECT_GAMEBOY:   outputColour = GameBoy(input.sceneUV, polygon.parameters[0], polygon.parameters[1]); break;
+	case EFFECT_INVERT:    outputColour = Invert(input.sceneUV); break;
+	case EFFECT_DISTORT:   outputColour = Distort(input.sceneUV, input.areaUV, polygon.parameters[0]); break;
+	default:               outputColour = SceneTexture.Sample(PointSample, input.sceneUV).rgb; break;
+	}
+
+	return float4(outputColour, 1.0f);
+}
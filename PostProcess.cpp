@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------------------------
+// Post-process effect list and the resources each effect reads
+//--------------------------------------------------------------------------------------
+
+#include "PostProcess.h"
+#include "SlidingFilter.h"
+#include "DepthOfField.h"
+#include "MotionBlur.h"
+
+
+// Return the declaration for the given post-process
+// Must agree with the texture slots used by each _pp.hlsl shader
+PostProcessDeclaration GetPostProcessDeclaration(PostProcess postProcess)
+{
+	PostProcessDeclaration declaration; // Default is to read the previous colour in t0 only
+
+	switch (postProcess)
+	{
+	case PostProcess::DepthOfField:
+		// Depth of field shader: t0 = the scene with its circle of confusion, t1 = the far field, t2 = the near field. The
+		// render graph makes all three from the previous colour and the scene depth with passes of their own (see
+		// DepthOfField.h), which already run the blurs at half size
+		declaration.inputs = { PassInput::DepthOfFieldCoC, PassInput::DepthOfFieldFar, PassInput::DepthOfFieldNear };
+		declaration.unboundedFootprint = true; // Blur radius depends on the depth
+		declaration.temporalFrames = DOF_TEMPORAL_FRAMES; // The gathers can take a share of their taps each frame
+		break;
+
+	case PostProcess::Fog:
+		declaration.inputs[1] = PassInput::SceneDepth;
+		break;
+
+	case PostProcess::MotionBlur:
+		// Motion blur shader: t1 = the scene velocity, t2 = the longest velocity of each tile, made by a pass the render graph
+		// adds (see MotionBlur.h)
+		declaration.inputs[1] = PassInput::SceneVelocity;
+		declaration.inputs[2] = PassInput::MotionBlurTiles;
+		declaration.haloPixels = static_cast<int>(MOTION_BLUR_MAX_PIXELS) / 2 + 1; // Blurs are centred, plus rounding to a pixel
+		break;
+
+	case PostProcess::LensStar:
+		declaration.haloScreenFraction = 0.042f; // 6 steps of 0.007
+		declaration.reducedResolutionDivisor = 2; // Its streaks are smooth, and it reads 72 samples for every pixel
+		break;
+
+	case PostProcess::GaussianBlurHorizontal:
+	case PostProcess::GaussianBlurVertical:
+		declaration.haloPixels = 13; // Widest kernel at full size (3 * GAUSSIAN_MAX_LEVEL_SIGMA) plus the pixel its last bilinear tap reads
+		declaration.computeTile = true;
+		break;
+
+	case PostProcess::Wireframe:
+		declaration.haloPixels = 2; // 1 tap at a texel size of 2 pixels
+		declaration.polygonBatchEffect = 1;
+		declaration.computeTile = true;
+		break;
+
+	case PostProcess::OnePassBlur:
+	case PostProcess::Dilation:
+		declaration.haloPixels = SLIDING_FILTER_MAX_RADIUS; // Widest radius
+		declaration.slidingFilter = true;
+		break;
+
+	case PostProcess::Burn:
+		declaration.haloScreenFraction = 0.075f; // Crinkle 0.15 * largest crinkle vector 0.5
+		break;
+
+	case PostProcess::Distort:
+		declaration.haloScreenFraction = 0.022f; // Distort level 0.03 * largest distortion vector
+		declaration.polygonBatchEffect = 4;
+		declaration.uvRemap = UVRemapKind::Distort;
+		break;
+
+	case PostProcess::HeatHaze:
+		declaration.haloScreenFraction = 0.01f;
+		declaration.uvRemap = UVRemapKind::HeatHaze;
+		break;
+
+	case PostProcess::Underwater:
+		declaration.haloScreenFraction = 0.005f; // Amplitude
+		declaration.uvRemap = UVRemapKind::Underwater;
+		break;
+
+	case PostProcess::NightVision:
+		declaration.haloScreenFraction = 0.003f;
+		break;
+
+	case PostProcess::RetroGame:
+		declaration.haloScreenFraction = 1.0f / 150.0f; // Reads from the top-left of its block
+		break;
+
+	case PostProcess::GameBoy:
+		declaration.haloScreenFraction = 1.0f / 100.0f;
+		declaration.polygonBatchEffect = 2;
+		break;
+
+	case PostProcess::Sepia:
+		declaration.polygonBatchEffect = 0;
+		declaration.colourTransform = ColourTransformKind::Affine;
+		declaration.colourLUT = true;
+		break;
+
+	case PostProcess::Invert:
+		declaration.polygonBatchEffect = 3;
+		declaration.colourTransform = ColourTransformKind::Affine;
+		declaration.colourLUT = true;
+		break;
+
+	case PostProcess::Tint:
+		declaration.colourTransform = ColourTransformKind::Affine;
+		declaration.colourLUT = true;
+		break;
+
+	case PostProcess::Copy:
+		declaration.colourTransform = ColourTransformKind::Affine;
+		break;
+
+	case PostProcess::VerticalGradient:
+	case PostProcess::HueVerticalGradient:
+		declaration.colourTransform = ColourTransformKind::AffineVertical;
+		break;
+
+	case PostProcess::Spiral:
+		declaration.unboundedFootprint = true;
+		declaration.uvRemap = UVRemapKind::Spiral;
+		break;
+
+	case PostProcess::ChromaticDis:
+		declaration.unboundedFootprint = true;
+		declaration.uvRemap = UVRemapKind::ChromaticDistortion;
+		break;
+
+	case PostProcess::Bloom:
+		// Bloom shader: t0 = the image the glow is added to, t1 = the glow, t2 = the lens star. The render graph makes the
+		// last two from the previous colour with passes of their own (see Bloom.h)
+		declaration.inputs = { PassInput::Colour, PassInput::BloomBlur, PassInput::BloomStar };
+		break;
+
+	default:
+		break;
+	}
+
+	return declaration;
+}
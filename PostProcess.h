@@ -0,0 +1,168 @@
+//--------------------------------------------------------------------------------------
+// Post-process effect list and the resources each effect reads
+//--------------------------------------------------------------------------------------
+// The enumerations used to be private to Scene.cpp. They live here so that code which plans
+// post-processing work (see RenderGraph.h) can be used without any DirectX device
+
+#ifndef _POST_PROCESS_H_INCLUDED_
+#define _POST_PROCESS_H_INCLUDED_
+
+#include <array>
+#include <vector>
+#include <utility>
+
+//--------------------------------------------------------------------------------------
+// Available post-processes
+//--------------------------------------------------------------------------------------
+
+enum class PostProcess
+{
+	None,
+	Copy,
+	Tint,
+	GreyNoise,
+	Burn,
+	Distort,
+	Spiral,
+	HeatHaze,
+	VerticalGradient,
+	Underwater,
+	HueVerticalGradient,
+	GaussianBlurHorizontal,
+	GaussianBlurVertical,
+	MotionBlur,
+	RetroGame,
+	BrightPass,
+	LensStar,
+	Bloom,
+	DepthOfField,
+	Wireframe,
+	Fog,
+	Invert,
+	NightVision,
+	GameBoy,
+	Sepia,
+	ChromaticDis,
+	Dilation,
+	OnePassBlur
+};
+
+enum class PostProcessMode
+{
+	Fullscreen,
+	Area,
+	Polygon,
+	WindowPolygon
+};
+
+// The list of post-processes applied to the scene, in order, each with the mode it is applied in
+typedef std::vector<std::pair<PostProcess, PostProcessMode>> PostProcessChain;
+
+
+//--------------------------------------------------------------------------------------
+// Post-process declarations
+//--------------------------------------------------------------------------------------
+// Each post-process declares which images it reads in each texture slot of its pixel shader.
+// Nothing here refers to actual textures, the render graph decides which texture backs each input
+
+// Maximum number of images a post-process reads (texture slots t0, t1, t2 in the shaders)
+const int MAX_PASS_INPUTS = 3;
+
+// An image a post-process can read
+enum class PassInput
+{
+	None,       // Slot is not used (or used for a fixed texture such as the noise map, which the graph doesn't track)
+	Colour,     // The output of the previous post-process in the chain (the scene itself for the first one)
+	SceneDepth, // Depth buffer of the main scene
+	SceneVelocity, // How far each pixel of the main scene moved since the last frame, and its depth (see MotionBlur.h)
+	History,    // The chain's temporal history, its resolved image from the previous frame (see TemporalHistory.h)
+	BloomBlur,  // Glow made by the bloom's downsampled and upsampled images (see Bloom.h)
+	BloomStar,  // Lens star made by the bloom from its quarter size image
+	DepthOfFieldCoC,  // Scene colour with its circle of confusion in alpha, made by the depth of field (see DepthOfField.h)
+	DepthOfFieldFar,  // Blurred far field of the depth of field, half size
+	DepthOfFieldNear, // Blurred near field of the depth of field, half size, with how much of each pixel it covers
+	MotionBlurTiles,  // Longest velocity of each tile of the scene velocity, made by the motion blur
+};
+
+// How an effect changes a pixel's colour, for effects that only read their own pixel and nothing else
+enum class ColourTransformKind
+{
+	None,           // Not a pure colour change (reads other pixels, uses noise or textures, or isn't affine)
+	Affine,         // New colour = 3x4 matrix * (colour, 1), the same everywhere on screen
+	AffineVertical, // As above, but the matrix changes from the top of the area to the bottom (vertical gradients)
+};
+
+// Most chain entries combined into one colour transform pass
+const int MAX_COLOUR_TRANSFORM_EFFECTS = 6;
+
+// How an effect moves the UVs it reads its image at, for effects that read the image once at a moved UV (once for each
+// colour channel for chromatic distortion) and change nothing else but the colour read. Numbers must match UVRemap_pp.hlsl
+enum class UVRemapKind
+{
+	None,
+	Distort,
+	Spiral,
+	HeatHaze,
+	Underwater,
+	ChromaticDistortion,
+};
+
+// Most chain entries combined into one UV remap pass
+const int MAX_UV_REMAP_EFFECTS = 6;
+
+struct PostProcessDeclaration
+{
+	// What is read in each shader texture slot
+	std::array<PassInput, MAX_PASS_INPUTS> inputs = { PassInput::Colour, PassInput::None, PassInput::None };
+
+	// Named images are published by an effect for use by later effects. Set to the PassInput the incoming colour
+	// should be published as, or None. The bloom's own images are named by the render graph as it adds their passes
+	PassInput publishesInputAs = PassInput::None;
+
+	// Frames the effect's samples can be spread over when full screen, 1 if it always takes them all. The render graph, when
+	// compiled with temporal accumulation, blends its output with its history and keeps the result for the next frame (see
+	// TemporalHistory.h). The effect's own passes are told the number of frames, and must take a different share each frame
+	int temporalFrames = 1;
+
+	// Footprint - how far from a pixel the effect may read its Colour input. Area and polygon effects with a
+	// bounded footprint can run in place, only copying the pixels they cover plus this halo. The halo is
+	// given in pixels plus a fraction of the screen size (for shaders that offset UVs by a fixed amount).
+	// Must agree with the parameters set in Scene.cpp
+	bool  unboundedFootprint = false; // True if the effect may read anywhere (e.g. large distortions)
+	int   haloPixels         = 0;
+	float haloScreenFraction = 0.0f;
+
+	// Effect number in the PolygonBatch_pp.hlsl shader, which runs several window polygons in one draw (see PolygonBatch.h)
+	// -1 if the effect has no version in that shader
+	int polygonBatchEffect = -1;
+
+	// Runs of full screen effects that are only colour changes are combined into one pass (see ColourTransform.h)
+	ColourTransformKind colourTransform = ColourTransformKind::None;
+
+	// Runs of full screen effects that only move the UVs they read the image at are combined into one pass, which reads the
+	// image once (see UVRemap.h)
+	UVRemapKind uvRemap = UVRemapKind::None;
+
+	// True if the effect's result depends only on the colour of the pixel it draws, smoothly enough to be baked into a
+	// colour LUT and used from that instead (see CPUColourLUT.h)
+	bool colourLUT = false;
+
+	// True if the effect takes the largest or average value over a square around each pixel, so when full screen it can be
+	// run as a pass along the rows then one down the columns, each costing the same whatever the radius (see SlidingFilter.h)
+	bool slidingFilter = false;
+
+	// True if the effect has a compute shader version that reads each tile of its input into group shared memory once,
+	// used for full screen passes when the render graph is compiled with compute tiles (see ComputeTile.h)
+	bool computeTile = false;
+
+	// Size divisor of the image the effect can be run on when full screen, 1 to always run it at full size. For effects whose
+	// change to the image is smooth, which the render graph runs on a smaller copy of the image when compiled with reduced
+	// resolution, then adds the change they made back on to the full size image (see RenderPassType::ReducedResolutionUpsample)
+	int reducedResolutionDivisor = 1;
+};
+
+// Return the declaration for the given post-process
+PostProcessDeclaration GetPostProcessDeclaration(PostProcess postProcess);
+
+
+#endif //_POST_PROCESS_H_INCLUDED_
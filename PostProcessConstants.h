@@ -0,0 +1,429 @@
+//--------------------------------------------------------------------------------------
+// Constant buffer blocks used by post-processes
+//--------------------------------------------------------------------------------------
+// Each post-process pass sends two small blocks of settings to the GPU rather than one large
+// structure holding the settings of every effect:
+// - The pass constants (register b1), shared by all passes. Where the pass draws on screen,
+//   plus a few values that many effects use (timer, texel size)
+// - The effect constants (register b2), the settings of just the effect being run. Each
+//   effect's shader declares its own matching cbuffer. Effects with no settings have no block
+//
+// The structures must match the cbuffers in the shaders exactly. HLSL packs constants into
+// 16-byte registers and a variable can't straddle two of them, so each structure is padded to
+// a multiple of 16 bytes and float3s are always followed by a single float. The static_asserts
+// below check the sizes when compiling - no DirectX is needed here
+
+#ifndef _POST_PROCESS_CONSTANTS_H_INCLUDED_
+#define _POST_PROCESS_CONSTANTS_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "CVector2.h"
+#include "CVector3.h"
+#include "CVector4.h"
+#include "CMatrix4x4.h"
+
+#include <cstddef>
+
+
+//--------------------------------------------------------------------------------------
+// Pass constants
+//--------------------------------------------------------------------------------------
+
+// Matches the PostProcessPassConstants cbuffer in Common.hlsli
+struct PostProcessPassConstants
+{
+	CVector2 area2DTopLeft; // Top-left of post-process area on screen, provided as coordinate from 0.0->1.0 not as a pixel coordinate
+	CVector2 area2DSize;    // Size of post-process area on screen, provided as sizes from 0.0->1.0 (1 = full screen) not as a size in pixels
+
+	float    area2DDepth;   // Depth buffer value for area (0.0 nearest to 1.0 furthest). Full screen post-processing uses 0.0f
+	float    timer;         // Time since the app started, for animated effects
+	CVector2 texelSize;     // Step between samples for blur and edge effects, in UVs
+
+	CVector4 polygon2DPoints[4]; // Four points of a polygon in 2D viewport space for polygon post-processing. Matrix transformations already done on C++ side
+};
+
+
+//--------------------------------------------------------------------------------------
+// Effect constants
+//--------------------------------------------------------------------------------------
+// One structure for each effect that has settings, each matches a cbuffer at register b2 in that effect's shader
+
+// VerticalGradient_pp.hlsl, also used by the hue vertical gradient
+struct VerticalGradientConstants
+{
+	CVector3 topColour;
+	float    paddingA;
+	CVector3 bottomColour;
+	float    paddingB;
+};
+
+// Most taps in a Gaussian blur kernel, the centre tap plus one each side for each pair of pixels (see GaussianKernel.h)
+const int GAUSSIAN_MAX_TAPS = 7;
+
+// GaussianHorizontalBlur_pp.hlsl and GaussianVerticalBlur_pp.hlsl
+struct GaussianBlurConstants
+{
+	float    blurSigma; // Width of the blur, in pixels of the viewport
+	int      numTaps;   // Taps used below, worked out from the sigma by SetGaussianBlurKernel
+	CVector2 padding;
+	CVector4 taps[GAUSSIAN_MAX_TAPS]; // x = offset from the centre in pixels, y = weight. Taps after the first are also used mirrored
+};
+
+// Underwater_pp.hlsl
+struct UnderwaterConstants
+{
+	float    frequency;
+	float    amplitude;
+	CVector2 padding;
+};
+
+// DepthOfFieldCoC_pp.hlsl, the circle of confusion of the depth of field (see DepthOfField.h)
+struct DepthOfFieldConstants
+{
+	float focalDistance;
+	float aperture;
+	float nearClip;
+	float farClip;
+};
+
+// MotionBlur_pp.hlsl (see MotionBlur.h)
+struct MotionBlurConstants
+{
+	float    shutter; // Fraction of its movement since the last frame each pixel is blurred along (how long the shutter is open)
+	CVector3 padding;
+};
+
+// RetroGame_pp.hlsl
+struct RetroGameConstants
+{
+	float    pixelSize;
+	int      paletteSize;
+	float    ditherAmount; // Strength of the ordered dither added before picking a palette colour, 0 for none
+	float    padding;
+};
+
+// BrightPass_pp.hlsl
+struct BrightPassConstants
+{
+	float bloomThreshold;
+	float exposure;
+	float bloomKnee;
+	float padding;
+};
+
+// LensStar_pp.hlsl
+struct LensStarConstants
+{
+	float stepSize;     // UV distance between the samples of a streak
+	float attenuation;  // Weight of each sample compared with the one before it
+	int   streakLength; // Samples along each side of a streak
+	float padding;
+};
+
+// Bloom_pp.hlsl
+struct BloomConstants
+{
+	float    bloomIntensity; // Scale of the glow, the sum of all the bloom levels (see Bloom.h)
+	float    starIntensity;  // Scale of the lens star
+	CVector2 padding;
+};
+
+// Tint_pp.hlsl
+struct TintConstants
+{
+	CVector3 tintColour;
+	float    padding;
+};
+
+// GreyNoise_pp.hlsl
+struct GreyNoiseConstants
+{
+	CVector2 noiseScale;
+	CVector2 noiseOffset;
+};
+
+// Burn_pp.hlsl
+struct BurnConstants
+{
+	float    burnHeight;
+	CVector3 padding;
+};
+
+// Distort_pp.hlsl
+struct DistortConstants
+{
+	float    distortLevel;
+	CVector3 padding;
+};
+
+// Spiral_pp.hlsl
+struct SpiralConstants
+{
+	float    spiralLevel;
+	CVector3 padding;
+};
+
+// Fog_pp.hlsl
+struct FogConstants
+{
+	CVector3 fogColour;
+	float    fogDensity;
+	float    fogHeightStart;
+	float    fogHeightDensity;
+	float    nearClip;
+	float    farClip;
+};
+
+// GameBoy_pp.hlsl
+struct GameBoyConstants
+{
+	CVector3 gameBoyColour;
+	float    gameBoyPixelSize;
+	float    gameBoyColourDepth;
+	float    ditherAmount; // Strength of the ordered dither added before picking a shade, 0 for none
+	CVector2 padding;
+};
+
+// NightVision_pp.hlsl
+struct NightVisionConstants
+{
+	CVector3 nightVisionTint;
+	float    noiseIntensity;
+	float    vignetteIntensity;
+	float    flickerIntensity;
+	CVector2 paddingA;
+
+	CVector3 brightnessBoost;
+	float    luminanceThreshold;
+	float    intensity;
+	CVector3 paddingB;
+};
+
+// ChromaticDistortion_pp.hlsl
+struct ChromaticDistortionConstants
+{
+	float    chromAbAmount;
+	float    distortionAmount;
+	CVector2 screenCenter;
+};
+
+// Wireframe_pp.hlsl
+struct WireframeConstants
+{
+	float    edgeThreshold;
+	float    edgePower;
+	CVector2 padding;
+};
+
+// Dilation_pp.hlsl
+struct DilationConstants
+{
+	int      kernelRadius;
+	CVector3 padding;
+};
+
+// OnePassBlur_pp.hlsl
+struct OnePassBlurConstants
+{
+	int      blurRadius; // Taps either side of the centre
+	int      tapSpacing; // Pixels between taps, 1 for a true box
+	CVector2 padding;
+};
+
+
+// ColourTransform_pp.hlsl, several colour effects run as one (see ColourTransform.h). Worked out from the settings of the
+// effects it stands in for, so it isn't one of the settings below
+struct ColourTransformConstants
+{
+	CVector4 stageRows[MAX_COLOUR_TRANSFORM_EFFECTS * 3]; // Rows of each stage's matrix, giving red, green and blue as dot(row, float4(colour, 1))
+	CVector4 lastStageBottom[3]; // The last stage's rows at the bottom of the screen, lerped with its rows above going down the screen
+	int      numStages;
+	CVector3 padding;
+};
+
+
+// UVRemap_pp.hlsl, several full screen distortions run as one (see UVRemap.h). Worked out from the settings of the effects
+// it stands in for
+struct UVRemapStage
+{
+	int      kind;     // UVRemapKind of the effect
+	float    amount;   // Distort level, spiral twist (spiral level squared), heat haze strength, underwater amplitude or lens distortion
+	float    chromAb;  // Chromatic distortion only, how far red and blue are spread from green
+	float    padding;
+	CVector2 centre;   // Spiral and chromatic distortion, the UV everything turns or spreads about
+	CVector2 padding2;
+};
+
+struct UVRemapConstants
+{
+	UVRemapStage stages[MAX_UV_REMAP_EFFECTS]; // In chain order
+	int          numStages;
+	CVector3     padding;
+};
+
+
+// ColourLUT_pp.hlsl, an effect run from a colour LUT (see CPUColourLUT.h)
+struct ColourLUTConstants
+{
+	float    lutScale;  // (LUT size - 1) / LUT size
+	float    lutOffset; // 0.5 / LUT size
+	CVector2 padding;
+};
+
+
+// SlidingFilter_cs.hlsl, one pass of a full screen dilation or box blur (see SlidingFilter.h). Worked out from the settings
+// of the effect it runs
+struct SlidingFilterConstants
+{
+	int radius;  // Pixels either side of the centre
+	int columns; // 0 to filter along the rows, 1 down the columns
+	int average; // 0 for the largest value (dilation), 1 for the average (box blur)
+	int padding;
+};
+
+
+// BloomDownsample_pp.hlsl, one level of the bloom's downsampled images (see Bloom.h). The bright pass settings are used by
+// the first level only
+struct BloomDownsampleConstants
+{
+	float bloomThreshold;
+	float bloomKnee;
+	float exposure;
+	int   firstLevel; // 1 when reading the full size image, 0 for the levels after
+};
+
+// LensStarStreak_pp.hlsl, one pass of one of the lens star's streaks (see LensStar.h). Worked out from the lens star settings
+// by MakeLensStarStreakConstants
+struct LensStarStreakConstants
+{
+	CVector2 tapStep;    // UV offset from one tap to the next in input 0. The last pass reads input 1 the opposite way
+	int      firstTap;   // The taps are firstTap, firstTap + 1... steps from the pixel
+	int      numTaps;    // Up to LENS_STAR_MAX_TAPS
+	CVector4 tapWeights; // Weight of each tap
+	CVector3 tint;       // Last pass only - the streak's colour divided by the sum of its weights
+	int      lastPass;   // 0 for a pass before the last, 1 for the last pass of a streak, 2 for the last pass of the last streak
+};
+
+// DepthOfFieldGather_pp.hlsl, the half size image of the near or far field of the depth of field (see DepthOfField.h)
+struct DepthOfFieldGatherConstants
+{
+	int nearField;      // 1 to gather the near field, 0 for the far field
+	int temporalFrames; // Frames the taps are spread over, 1 to take them all every frame (see TemporalHistory.h)
+	int frameIndex;     // Picks which share of the taps this frame takes
+	int padding;
+};
+
+// TemporalResolve_pp.hlsl, blending an effect's output into the history reprojected from last frame (see TemporalHistory.h).
+// The reprojection, clip distances, frame index and clamping are set each frame with the other effects' settings, the rest
+// for each pass by MakeTemporalResolveConstants
+struct TemporalResolveConstants
+{
+	CMatrix4x4 reprojection; // Clip space this frame to clip space last frame, see MakeReprojectionMatrix
+
+	float nearClip;
+	float farClip;
+	float currentWeight;  // Share of the new output in the blend, where the history is kept
+	float depthTolerance; // See TEMPORAL_DEPTH_TOLERANCE
+
+	int   historyValid;       // 0 to ignore the history, e.g. on the first frame
+	int   neighbourhoodClamp; // 1 to clamp the history to the range of colours around each pixel
+	int   frameIndex;         // Counts up every frame, effects taking a share of their samples use it to pick the share
+	int   padding;
+};
+
+
+// The CPU-side settings of every effect. Only the block for the effect being run is sent to the GPU. Settings
+// stay here between frames, so effects that animate (e.g. burn) carry on from where they were
+struct PostProcessEffectConstants
+{
+	VerticalGradientConstants    verticalGradient;
+	GaussianBlurConstants        gaussianBlur;
+	UnderwaterConstants          underwater;
+	DepthOfFieldConstants        depthOfField;
+	MotionBlurConstants          motionBlur;
+	RetroGameConstants           retroGame;
+	BrightPassConstants          brightPass;
+	LensStarConstants            lensStar;
+	BloomConstants               bloom;
+	TintConstants                tint;
+	GreyNoiseConstants           greyNoise;
+	BurnConstants                burn;
+	DistortConstants             distort;
+	SpiralConstants              spiral;
+	FogConstants                 fog;
+	GameBoyConstants             gameBoy;
+	NightVisionConstants         nightVision;
+	ChromaticDistortionConstants chromaticDistortion;
+	WireframeConstants           wireframe;
+	DilationConstants            dilation;
+	OnePassBlurConstants         onePassBlur;
+	TemporalResolveConstants     temporal;
+};
+
+
+// A block of constants to upload, size 0 for effects with no settings
+struct ConstantBlock
+{
+	const void* data = nullptr;
+	int         size = 0;
+};
+
+template <class T>
+ConstantBlock MakeConstantBlock(const T& constants)
+{
+	ConstantBlock block;
+	block.data = &constants;
+	block.size = static_cast<int>(sizeof(T));
+	return block;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Layout checks
+//--------------------------------------------------------------------------------------
+
+// Every block must fill a whole number of 16-byte shader registers
+#define CHECK_CONSTANT_BLOCK(T)  static_assert(sizeof(T) % 16 == 0, #T " must be a multiple of 16 bytes to match its cbuffer")
+
+CHECK_CONSTANT_BLOCK(PostProcessPassConstants);
+CHECK_CONSTANT_BLOCK(VerticalGradientConstants);
+CHECK_CONSTANT_BLOCK(GaussianBlurConstants);
+CHECK_CONSTANT_BLOCK(UnderwaterConstants);
+CHECK_CONSTANT_BLOCK(DepthOfFieldConstants);
+CHECK_CONSTANT_BLOCK(MotionBlurConstants);
+CHECK_CONSTANT_BLOCK(RetroGameConstants);
+CHECK_CONSTANT_BLOCK(BrightPassConstants);
+CHECK_CONSTANT_BLOCK(LensStarConstants);
+CHECK_CONSTANT_BLOCK(BloomConstants);
+CHECK_CONSTANT_BLOCK(TintConstants);
+CHECK_CONSTANT_BLOCK(GreyNoiseConstants);
+CHECK_CONSTANT_BLOCK(BurnConstants);
+CHECK_CONSTANT_BLOCK(DistortConstants);
+CHECK_CONSTANT_BLOCK(SpiralConstants);
+CHECK_CONSTANT_BLOCK(FogConstants);
+CHECK_CONSTANT_BLOCK(GameBoyConstants);
+CHECK_CONSTANT_BLOCK(NightVisionConstants);
+CHECK_CONSTANT_BLOCK(ChromaticDistortionConstants);
+CHECK_CONSTANT_BLOCK(WireframeConstants);
+CHECK_CONSTANT_BLOCK(DilationConstants);
+CHECK_CONSTANT_BLOCK(OnePassBlurConstants);
+CHECK_CONSTANT_BLOCK(SlidingFilterConstants);
+CHECK_CONSTANT_BLOCK(BloomDownsampleConstants);
+CHECK_CONSTANT_BLOCK(LensStarStreakConstants);
+CHECK_CONSTANT_BLOCK(DepthOfFieldGatherConstants);
+CHECK_CONSTANT_BLOCK(TemporalResolveConstants);
+CHECK_CONSTANT_BLOCK(ColourTransformConstants);
+CHECK_CONSTANT_BLOCK(UVRemapConstants);
+CHECK_CONSTANT_BLOCK(ColourLUTConstants);
+
+// Variables that start a new register in the shaders
+static_assert(offsetof(PostProcessPassConstants, area2DDepth)     == 16, "PostProcessPassConstants doesn't match its cbuffer");
+static_assert(offsetof(PostProcessPassConstants, polygon2DPoints) == 32, "PostProcessPassConstants doesn't match its cbuffer");
+static_assert(offsetof(NightVisionConstants, brightnessBoost)     == 32, "NightVisionConstants doesn't match its cbuffer");
+static_assert(offsetof(TemporalResolveConstants, nearClip)        == 64, "TemporalResolveConstants doesn't match its cbuffer");
+static_assert(sizeof(UVRemapStage)                                == 32, "UVRemapStage doesn't match its cbuffer struct");
+
+#undef CHECK_CONSTANT_BLOCK
+
+
+#endif //_POST_PROCESS_CONSTANTS_H_INCLUDED_
@@ -0,0 +1,227 @@
+//--------------------------------------------------------------------------------------
+// Running a compiled render graph on a device
+//--------------------------------------------------------------------------------------
+
+#include "PostProcessDevice.h"
+
+
+//--------------------------------------------------------------------------------------
+// Graph execution
+//--------------------------------------------------------------------------------------
+
+PostProcessStats ExecuteRenderGraph(const RenderGraph& graph, PostProcessDevice& device)
+{
+	PostProcessStats stats;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		ExecuteRenderPass(pass, device, stats);
+	}
+	return stats;
+}
+
+
+void ExecuteRenderPass(const RenderPass& pass, PostProcessDevice& device, PostProcessStats& stats)
+{
+	++stats.passes;
+
+	if (pass.type == RenderPassType::CopyResource)
+	{
+		device.CopyResource(pass.output, pass.inputs[0]);
+		++stats.copies;
+		return;
+	}
+	if (pass.type == RenderPassType::CopyRegion)
+	{
+		stats.regionPixels += device.CopyRegion(pass.output, pass.inputs[0], pass);
+		++stats.copies;
+		return;
+	}
+	if (pass.type == RenderPassType::PolygonBatch)
+	{
+		PostProcessStats batchStats = device.DrawPolygonBatch(pass);
+		stats.draws        += batchStats.draws;
+		stats.copies       += batchStats.copies;
+		stats.regionPixels += batchStats.regionPixels;
+		return;
+	}
+
+	device.SetPassResources(pass);
+
+	int draws = 0;
+	if (pass.type == RenderPassType::ColourTransform)
+	{
+		device.DrawColourTransform(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::UVRemap)
+	{
+		device.DrawUVRemap(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::Resample)
+	{
+		device.DrawResample(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::SlidingFilterRows || pass.type == RenderPassType::SlidingFilterColumns)
+	{
+		device.RunSlidingFilter(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::ComputeTile)
+	{
+		device.RunComputeTile(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::BloomDownsample || pass.type == RenderPassType::BloomUpsample)
+	{
+		device.DrawBloomMip(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::LensStarStreak)
+	{
+		device.DrawLensStarStreak(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::DepthOfFieldCoC || pass.type == RenderPassType::DepthOfFieldTiles ||
+	         pass.type == RenderPassType::DepthOfFieldFar || pass.type == RenderPassType::DepthOfFieldNear)
+	{
+		device.DrawDepthOfFieldStage(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::MotionBlurTiles)
+	{
+		device.DrawMotionBlurTiles(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::TemporalResolve)
+	{
+		device.DrawTemporalResolve(pass);
+		draws = 1;
+	}
+	else if (pass.type == RenderPassType::ReducedResolutionUpsample)
+	{
+		device.DrawReducedResolutionUpsample(pass);
+		draws = 1;
+	}
+	else if (pass.mode == PostProcessMode::Fullscreen)
+	{
+		device.DrawFullScreen(pass.effect);
+		draws = 1;
+	}
+	else if (pass.inPlace)
+	{
+		// The target already holds the image being processed, only the region needs drawing
+		device.DrawRegion(pass);
+		draws = 1;
+	}
+	else
+	{
+		// Area and polygon effects only cover part of the target, so the rest of the target is filled with a copy first
+		// Only needed for effects that might read anywhere in their input, see PostProcessDeclaration
+		device.DrawFullScreen(PostProcess::Copy);
+		device.DrawRegion(pass);
+		draws = 2;
+	}
+
+	stats.draws += draws;
+	if (pass.output == BACK_BUFFER_RESOURCE)  stats.backBufferDraws += draws;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Recording device
+//--------------------------------------------------------------------------------------
+
+void RecordingPostProcessDevice::SetPassResources(const RenderPass& pass)
+{
+	mCurrentPass = pass;
+	mCommands.push_back({ PostProcessCommandType::SetPassResources, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawFullScreen(PostProcess postProcess)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawFullScreen, postProcess, mCurrentPass.output, mCurrentPass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawRegion(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawRegion, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::CopyResource(int destination, int source)
+{
+	mCommands.push_back({ PostProcessCommandType::CopyResource, PostProcess::None, destination, source });
+}
+
+int RecordingPostProcessDevice::CopyRegion(int destination, int source, const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::CopyRegion, pass.effect, destination, source });
+	return 0; // No viewport here to measure the region in
+}
+
+PostProcessStats RecordingPostProcessDevice::DrawPolygonBatch(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawPolygonBatch, pass.effect, pass.output, pass.inputs[0] });
+
+	// Without a camera, assume the polygons are all visible and don't overlap - one copy and one draw
+	PostProcessStats stats;
+	stats.draws  = 1;
+	stats.copies = 1;
+	return stats;
+}
+
+void RecordingPostProcessDevice::DrawColourTransform(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawColourTransform, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawUVRemap(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawUVRemap, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawResample(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawResample, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::RunSlidingFilter(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::RunSlidingFilter, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::RunComputeTile(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::RunComputeTile, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawBloomMip(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawBloomMip, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawLensStarStreak(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawLensStarStreak, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawDepthOfFieldStage(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawDepthOfFieldStage, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawMotionBlurTiles(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawMotionBlurTiles, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawTemporalResolve(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawTemporalResolve, pass.effect, pass.output, pass.inputs[0] });
+}
+
+void RecordingPostProcessDevice::DrawReducedResolutionUpsample(const RenderPass& pass)
+{
+	mCommands.push_back({ PostProcessCommandType::DrawReducedResolutionUpsample, pass.effect, pass.output, pass.inputs[0] });
+}
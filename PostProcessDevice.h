@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------------------------
+// Running a compiled render graph on a device
+//--------------------------------------------------------------------------------------
+// ExecuteRenderGraph walks the passes of a compiled RenderGraph and decides which draws and copies
+// each one needs. The actual work is done through the PostProcessDevice interface - Scene.cpp
+// implements it with DirectX, and RecordingPostProcessDevice below just keeps a list of what it
+// was asked to do, which lets the pass planning be checked without a GPU
+
+#ifndef _POST_PROCESS_DEVICE_H_INCLUDED_
+#define _POST_PROCESS_DEVICE_H_INCLUDED_
+
+#include "RenderGraph.h"
+
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Statistics
+//--------------------------------------------------------------------------------------
+
+// Work issued for the post-processing in one frame
+struct PostProcessStats
+{
+	int passes          = 0; // Graph passes run (including copies)
+	int draws           = 0; // Draw calls (full screen or region) and compute dispatches
+	int copies          = 0; // Resource copies, whole or region
+	int regionPixels    = 0; // Pixels copied by region copies
+	int backBufferDraws = 0; // Draw calls to the back buffer - should only be the final pass
+};
+
+
+//--------------------------------------------------------------------------------------
+// Device interface
+//--------------------------------------------------------------------------------------
+
+class PostProcessDevice
+{
+public:
+	virtual ~PostProcessDevice() {}
+
+	// Select the images read by the given pass and the target it writes. Used by the draws that follow
+	virtual void SetPassResources(const RenderPass& pass) = 0;
+
+	// Draw the given post-process over the whole target
+	virtual void DrawFullScreen(PostProcess postProcess) = 0;
+
+	// Draw the pass's post-process over just its area or polygon, leaving the rest of the target alone
+	virtual void DrawRegion(const RenderPass& pass) = 0;
+
+	// Copy one resource to another without a shader (same size and format)
+	virtual void CopyResource(int destination, int source) = 0;
+
+	// Copy only the pixels the given pass will read - its region grown by the effect's footprint (see PostProcessRegion.h)
+	// Returns the number of pixels copied
+	virtual int CopyRegion(int destination, int source, const RenderPass& pass) = 0;
+
+	// Run all the window polygons of a polygon batch pass, copying the pixels they read into input 0 first
+	// Returns the draws and copies issued (the number of draws depends on where the polygons are on screen)
+	virtual PostProcessStats DrawPolygonBatch(const RenderPass& pass) = 0;
+
+	// Draw all the chain entries of a colour transform pass over the whole target as one combined colour change
+	// (see ColourTransform.h). The pass resources have already been selected
+	virtual void DrawColourTransform(const RenderPass& pass) = 0;
+
+	// Draw all the chain entries of a UV remap pass over the whole target as one combined distortion, reading input 0 once
+	// (see UVRemap.h). The pass resources have already been selected
+	virtual void DrawUVRemap(const RenderPass& pass) = 0;
+
+	// Draw input 0 over the whole target with bilinear filtering, for targets of a different size. The pass resources have
+	// already been selected
+	virtual void DrawResample(const RenderPass& pass) = 0;
+
+	// Run one pass of a full screen dilation or box blur, along the rows or down the columns of input 0 depending on the pass
+	// type (see SlidingFilter.h). The pass resources have already been selected
+	virtual void RunSlidingFilter(const RenderPass& pass) = 0;
+
+	// Run the pass's effect over the whole target with its compute shader, a tile at a time (see ComputeTile.h). The pass
+	// resources have already been selected
+	virtual void RunComputeTile(const RenderPass& pass) = 0;
+
+	// Draw one of the bloom's downsampled or upsampled images over the whole target, depending on the pass type (see Bloom.h).
+	// The pass resources have already been selected
+	virtual void DrawBloomMip(const RenderPass& pass) = 0;
+
+	// Draw one pass of one of the lens star's streaks over the whole target, as chosen by the pass (see LensStar.h). The pass
+	// resources have already been selected
+	virtual void DrawLensStarStreak(const RenderPass& pass) = 0;
+
+	// Draw the depth of field's circle of confusion, tiles, far field or near field over the whole target, depending on the
+	// pass type (see DepthOfField.h). The pass resources have already been selected
+	virtual void DrawDepthOfFieldStage(const RenderPass& pass) = 0;
+
+	// Draw the longest velocity of each tile of the scene velocity over the whole target, for the motion blur (see MotionBlur.h).
+	// The pass resources have already been selected
+	virtual void DrawMotionBlurTiles(const RenderPass& pass) = 0;
+
+	// Draw input 0 blended with the history (input 1) reprojected to this frame with the scene depth (input 2) over the whole
+	// target (see TemporalHistory.h). The pass resources have already been selected
+	virtual void DrawTemporalResolve(const RenderPass& pass) = 0;
+
+	// Draw input 0 plus the change an effect made to a smaller image (input 1 minus input 2) scaled up to the whole target
+	// (see RenderPassType::ReducedResolutionUpsample). The pass resources have already been selected
+	virtual void DrawReducedResolutionUpsample(const RenderPass& pass) = 0;
+};
+
+
+// Run all the passes of a compiled graph on the given device, returns what was issued
+PostProcessStats ExecuteRenderGraph(const RenderGraph& graph, PostProcessDevice& device);
+
+// Run a single pass of a compiled graph, adding what was issued to the given statistics. For devices that run some
+// passes in their own way (e.g. the CPU device runs chains of full screen passes together, see CPUTileFusion.h)
+void ExecuteRenderPass(const RenderPass& pass, PostProcessDevice& device, PostProcessStats& stats);
+
+
+//--------------------------------------------------------------------------------------
+// Recording device
+//--------------------------------------------------------------------------------------
+// Doesn't render anything, only records the commands it receives
+
+enum class PostProcessCommandType
+{
+	SetPassResources,
+	DrawFullScreen,
+	DrawRegion,
+	CopyResource,
+	CopyRegion,
+	DrawPolygonBatch,
+	DrawColourTransform,
+	DrawUVRemap,
+	DrawResample,
+	RunSlidingFilter,
+	RunComputeTile,
+	DrawBloomMip,
+	DrawLensStarStreak,
+	DrawDepthOfFieldStage,
+	DrawMotionBlurTiles,
+	DrawTemporalResolve,
+	DrawReducedResolutionUpsample,
+};
+
+struct PostProcessCommand
+{
+	PostProcessCommandType type;
+	PostProcess            effect = PostProcess::None;
+	int                    target = -1; // Resource written by the command (the pass output for draws)
+	int                    source = -1; // Resource read in slot 0 (or copied from)
+};
+
+class RecordingPostProcessDevice : public PostProcessDevice
+{
+public:
+	void SetPassResources(const RenderPass& pass) override;
+	void DrawFullScreen(PostProcess postProcess) override;
+	void DrawRegion(const RenderPass& pass) override;
+	void CopyResource(int destination, int source) override;
+	int  CopyRegion(int destination, int source, const RenderPass& pass) override;
+	PostProcessStats DrawPolygonBatch(const RenderPass& pass) override;
+	void DrawColourTransform(const RenderPass& pass) override;
+	void DrawUVRemap(const RenderPass& pass) override;
+	void DrawResample(const RenderPass& pass) override;
+	void RunSlidingFilter(const RenderPass& pass) override;
+	void RunComputeTile(const RenderPass& pass) override;
+	void DrawBloomMip(const RenderPass& pass) override;
+	void DrawLensStarStreak(const RenderPass& pass) override;
+	void DrawDepthOfFieldStage(const RenderPass& pass) override;
+	void DrawMotionBlurTiles(const RenderPass& pass) override;
+	void DrawTemporalResolve(const RenderPass& pass) override;
+	void DrawReducedResolutionUpsample(const RenderPass& pass) override;
+
+	const std::vector<PostProcessCommand>& Commands() const  { return mCommands; }
+	void Clear()  { mCommands.clear(); }
+
+private:
+	std::vector<PostProcessCommand> mCommands;
+	RenderPass                      mCurrentPass; // As selected by the last SetPassResources
+};
+
+
+#endif //_POST_PROCESS_DEVICE_H_INCLUDED_
@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------------
+// Screen regions covered by area and polygon post-processes
+//--------------------------------------------------------------------------------------
+
+#include "PostProcessRegion.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+PixelRect ClipToViewport(const PixelRect& rect, int viewportWidth, int viewportHeight)
+{
+	PixelRect clipped;
+	clipped.left   = std::max(rect.left,   0);
+	clipped.top    = std::max(rect.top,    0);
+	clipped.right  = std::min(rect.right,  viewportWidth);
+	clipped.bottom = std::min(rect.bottom, viewportHeight);
+	if (clipped.IsEmpty())  return PixelRect(); // Keep empty rectangles consistent (all zero)
+	return clipped;
+}
+
+
+bool RectsOverlap(const PixelRect& a, const PixelRect& b)
+{
+	if (a.IsEmpty() || b.IsEmpty())  return false;
+	return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+
+PixelRect AreaPixelRect(CVector2 topLeft, CVector2 size, int viewportWidth, int viewportHeight)
+{
+	// Round outwards so partly covered pixels are included
+	PixelRect rect;
+	rect.left   = static_cast<int>(std::floor(topLeft.x * viewportWidth));
+	rect.top    = static_cast<int>(std::floor(topLeft.y * viewportHeight));
+	rect.right  = static_cast<int>(std::ceil((topLeft.x + size.x) * viewportWidth));
+	rect.bottom = static_cast<int>(std::ceil((topLeft.y + size.y) * viewportHeight));
+	return ClipToViewport(rect, viewportWidth, viewportHeight);
+}
+
+
+PixelRect PolygonPixelRect(const CVector4* projectedPoints, int numPoints, int viewportWidth, int viewportHeight)
+{
+	const float minW = 1e-5f; // Points closer to the camera plane than this are treated as behind the camera
+
+	PixelRect fullViewport = { 0, 0, viewportWidth, viewportHeight };
+
+	// Nothing to draw if the whole polygon is behind the camera
+	int numBehind = 0;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		if (projectedPoints[i].w < minW)  ++numBehind;
+	}
+	if (numBehind == numPoints)  return PixelRect();
+	if (numBehind > 0)  return fullViewport;
+
+	float minX =  1e30f, minY =  1e30f;
+	float maxX = -1e30f, maxY = -1e30f;
+	for (int i = 0; i < numPoints; ++i)
+	{
+		const CVector4& point = projectedPoints[i];
+
+		// Same conversion as the 2DPolygon vertex shader: perspective divide to -1->1, then to 0->1 with y flipped, then pixels
+		float x = (point.x / point.w + 1.0f) * 0.5f * viewportWidth;
+		float y = (1.0f - (point.y / point.w + 1.0f) * 0.5f) * viewportHeight;
+		minX = std::min(minX, x);  maxX = std::max(maxX, x);
+		minY = std::min(minY, y);  maxY = std::max(maxY, y);
+	}
+
+	// Don't convert huge values to int - anything well off screen is clipped anyway
+	const float limit = 4.0f * std::max(viewportWidth, viewportHeight);
+	PixelRect rect;
+	rect.left   = static_cast<int>(std::floor(std::max(minX, -limit)));
+	rect.top    = static_cast<int>(std::floor(std::max(minY, -limit)));
+	rect.right  = static_cast<int>(std::ceil(std::min(maxX, limit)));
+	rect.bottom = static_cast<int>(std::ceil(std::min(maxY, limit)));
+	return ClipToViewport(rect, viewportWidth, viewportHeight);
+}
+
+
+PixelRect ExpandByFootprint(const PixelRect& rect, const PostProcessDeclaration& declaration, int viewportWidth, int viewportHeight)
+{
+	if (rect.IsEmpty())  return rect;
+	if (declaration.unboundedFootprint)  return { 0, 0, viewportWidth, viewportHeight };
+
+	int haloX = declaration.haloPixels + static_cast<int>(std::ceil(declaration.haloScreenFraction * viewportWidth));
+	int haloY = declaration.haloPixels + static_cast<int>(std::ceil(declaration.haloScreenFraction * viewportHeight));
+
+	PixelRect expanded = { rect.left - haloX, rect.top - haloY, rect.right + haloX, rect.bottom + haloY };
+	return ClipToViewport(expanded, viewportWidth, viewportHeight);
+}
@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------------------------
+// Screen regions covered by area and polygon post-processes
+//--------------------------------------------------------------------------------------
+// Area and polygon post-processes only change part of the screen. These functions find the
+// rectangle of pixels they cover, which is used as the scissor rectangle for the effect and
+// (grown by the effect's halo) as the part of the image that needs to be copied for it to read.
+// No DirectX here, just maths on the values that are sent to the 2DQuad / 2DPolygon shaders
+
+#ifndef _POST_PROCESS_REGION_H_INCLUDED_
+#define _POST_PROCESS_REGION_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "CVector2.h"
+#include "CVector4.h"
+
+
+// A rectangle of pixels. Right and bottom are exclusive, so the width is right - left
+struct PixelRect
+{
+	int left   = 0;
+	int top    = 0;
+	int right  = 0;
+	int bottom = 0;
+
+	bool IsEmpty() const  { return right <= left || bottom <= top; }
+	int  Area() const     { return IsEmpty() ? 0 : (right - left) * (bottom - top); }
+};
+
+
+// Where an area or polygon post-process appears on screen this frame
+struct PostProcessRegion
+{
+	bool      visible = false;  // False if the region is behind the camera or off screen
+
+	CVector2  area2DTopLeft;    // Area effects, as sent to the 2DQuad vertex shader
+	CVector2  area2DSize;
+	float     area2DDepth = 0;
+
+	CVector4  polygon2DPoints[4]; // Polygon effects, as sent to the 2DPolygon vertex shader
+
+	PixelRect pixels;           // Pixels covered, used as the scissor rectangle
+};
+
+
+// Pixels covered by an area given as top-left and size in 0->1 screen coordinates (as in area2DTopLeft/area2DSize)
+// The result is clipped to the viewport
+PixelRect AreaPixelRect(CVector2 topLeft, CVector2 size, int viewportWidth, int viewportHeight);
+
+// Pixels covered by a polygon given as points already transformed by the view-projection matrix (as in polygon2DPoints)
+// If all the points are behind the camera the result is empty. If only some are, the polygon is clipped by the GPU in
+// ways we don't reproduce here, so the whole viewport is returned to be safe. The result is clipped to the viewport
+PixelRect PolygonPixelRect(const CVector4* projectedPoints, int numPoints, int viewportWidth, int viewportHeight);
+
+// Grow a rectangle to include the halo of pixels the given post-process reads around each pixel it writes
+// Clipped to the viewport. An effect with an unbounded footprint gets the whole viewport
+PixelRect ExpandByFootprint(const PixelRect& rect, const PostProcessDeclaration& declaration, int viewportWidth, int viewportHeight);
+
+// Clip a rectangle to the viewport
+PixelRect ClipToViewport(const PixelRect& rect, int viewportWidth, int viewportHeight);
+
+// True if the two rectangles share any pixels
+bool RectsOverlap(const PixelRect& a, const PixelRect& b);
+
+
+#endif //_POST_PROCESS_REGION_H_INCLUDED_
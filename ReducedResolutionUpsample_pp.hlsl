@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// Reduced Resolution Upsample Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Finishes an effect that was run on a smaller image (see RenderPassType::ReducedResolutionUpsample).
+// The change the effect made - its small output minus the small image it read - is scaled up and
+// added to the full size image, so pixels the effect left alone keep all their detail. The four
+// small pixels that bilinear filtering would blend are each also weighted by how close their colour
+// before the effect is to the full size pixel's colour (a joint bilateral filter), so the change
+// made on one side of an edge doesn't bleed across to the other
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D ImageTexture   : register(t0); // The full size image the effect read, the size of the target
+Texture2D ChangedTexture : register(t1); // The effect's output at the smaller size
+Texture2D SourceTexture  : register(t2); // The smaller image the effect read
+
+// Small pixels whose colour differs from the full size pixel by about 0.1 or more count for little
+static const float COLOUR_WEIGHT_SCALE = 50.0f;
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float3 colour = ImageTexture.Load(int3(input.projectedPosition.xy, 0)).rgb;
+
+	// Find the four small pixels around this one, clamped at the edges
+	float2 smallSize;
+	SourceTexture.GetDimensions(smallSize.x, smallSize.y);
+	float2 position = clamp(input.sceneUV * smallSize - 0.5f, -1.0f, smallSize);
+	float2 fraction = position - floor(position);
+	int2 first  = clamp(int2(floor(position)),     int2(0, 0), int2(smallSize) - 1);
+	int2 second = clamp(int2(floor(position)) + 1, int2(0, 0), int2(smallSize) - 1);
+
+	int2   taps[4]     = { int2(first.x, first.y), int2(second.x, first.y), int2(first.x, second.y), int2(second.x, second.y) };
+	float  bilinear[4] = { (1.0f - fraction.x) * (1.0f - fraction.y), fraction.x * (1.0f - fraction.y),
+	                       (1.0f - fraction.x) * fraction.y,          fraction.x * fraction.y };
+	float3 change = float3(0.0f, 0.0f, 0.0f);
+	float  totalWeight = 0.0f;
+	for (int tap = 0; tap < 4; ++tap)
+	{
+		float3 sourceColour  = SourceTexture.Load(int3(taps[tap], 0)).rgb;
+		float3 changedColour = ChangedTexture.Load(int3(taps[tap], 0)).rgb;
+		float3 difference = colour - sourceColour;
+
+		// The small addition keeps some weight on every pixel, for full size pixels unlike all four
+		float weight = bilinear[tap] * (exp(-dot(difference, difference) * COLOUR_WEIGHT_SCALE) + 0.001f);
+		change += (changedColour - sourceColour) * weight;
+		totalWeight += weight;
+	}
+
+	return float4(colour + change / totalWeight, 1.0f);
+}
@@ -0,0 +1,677 @@
+//--------------------------------------------------------------------------------------
+// Render graph for the post-processing chain
+//--------------------------------------------------------------------------------------
+
+#include "RenderGraph.h"
+#include "Bloom.h"
+#include "LensStar.h"
+#include "DepthOfField.h"
+#include "MotionBlur.h"
+
+#include <algorithm>
+#include <map>
+
+
+// Images written by compute shaders. They are also render targets, for later effects that draw in place into them
+const unsigned int COMPUTE_OUTPUT_BIND = TARGET_BIND_RENDER_TARGET | TARGET_BIND_SHADER_RESOURCE | TARGET_BIND_UNORDERED_ACCESS;
+
+
+//--------------------------------------------------------------------------------------
+// Building the graph
+//--------------------------------------------------------------------------------------
+
+void RenderGraph::Compile(const PostProcessChain& chain, int blurLevels, bool computeTiles, bool reducedResolution,
+                          bool temporalAccumulation, int lensStarPasses, bool slidingBoxBlur)
+{
+	mChain = chain;
+	mBlurLevels = blurLevels;
+	mComputeTiles = computeTiles;
+	mReducedResolution = reducedResolution;
+	mTemporalAccumulation = temporalAccumulation;
+	mLensStarPasses = std::min(std::max(lensStarPasses, 1), LENS_STAR_MAX_PASSES);
+	mSlidingBoxBlur = slidingBoxBlur;
+	mPasses.clear();
+	mResources.clear();
+
+	// Fixed resources, see the constants in the header
+	mResources.push_back({ GraphResourceType::SceneColour });
+	mResources.push_back({ GraphResourceType::SceneDepth });
+	mResources.push_back({ GraphResourceType::History });
+	mResources.push_back({ GraphResourceType::BackBuffer });
+	mResources.push_back({ GraphResourceType::SceneVelocity });
+
+	// Images published by name for later effects (e.g. the glow and lens star made for the bloom)
+	std::map<PassInput, int> namedResources;
+
+	int colour = SCENE_COLOUR_RESOURCE; // The image the next effect will process
+	bool historyUsed = false;           // Only one effect in the chain keeps a history
+	for (int chainIndex = 0; chainIndex < static_cast<int>(chain.size()); ++chainIndex)
+	{
+		PostProcess postProcess = chain[chainIndex].first;
+		PostProcessDeclaration declaration = GetPostProcessDeclaration(postProcess);
+
+		// Area and polygon effects can run in place if they only read close to the pixels they cover. Not possible if the
+		// image has been published for a later effect, which expects it unchanged
+		bool isPublished = false;
+		for (auto& named : namedResources)
+		{
+			if (named.second == colour)  isPublished = true;
+		}
+
+		// Several window polygons in a row are drawn together by one pass, which makes its own region copies into a scratch image
+		int batchSize = isPublished ? 0 : PolygonBatchSize(chainIndex);
+		if (batchSize > 1)
+		{
+			RenderPass batchPass;
+			batchPass.type       = RenderPassType::PolygonBatch;
+			batchPass.effect     = postProcess;
+			batchPass.mode       = PostProcessMode::WindowPolygon;
+			batchPass.chainIndex = chainIndex;
+			batchPass.batchSize  = batchSize;
+			batchPass.inPlace    = true;
+			batchPass.inputs[0]  = AddTransient();
+			batchPass.output     = colour;
+			AddPass(batchPass);
+
+			chainIndex += batchSize - 1;
+			continue;
+		}
+
+		// Several full screen colour effects in a row are combined into one draw. The image they read is left unchanged,
+		// so it doesn't matter if it has been published
+		int transformSize = ColourTransformSize(chainIndex);
+		if (transformSize > 1)
+		{
+			RenderPass transformPass;
+			transformPass.type       = RenderPassType::ColourTransform;
+			transformPass.effect     = postProcess;
+			transformPass.chainIndex = chainIndex;
+			transformPass.batchSize  = transformSize;
+			transformPass.inputs[0]  = colour;
+			transformPass.output     = AddTransient();
+			AddPass(transformPass);
+			colour = transformPass.output;
+
+			chainIndex += transformSize - 1;
+			continue;
+		}
+
+		// Several full screen distortions in a row are combined into one draw, which reads the image they start from once.
+		// That image is left unchanged, as above
+		int remapSize = UVRemapSize(chainIndex);
+		if (remapSize > 1)
+		{
+			RenderPass remapPass;
+			remapPass.type       = RenderPassType::UVRemap;
+			remapPass.effect     = postProcess;
+			remapPass.chainIndex = chainIndex;
+			remapPass.batchSize  = remapSize;
+			remapPass.inputs[0]  = colour;
+			remapPass.output     = AddTransient();
+			AddPass(remapPass);
+			colour = remapPass.output;
+
+			chainIndex += remapSize - 1;
+			continue;
+		}
+
+		// Wide full screen blurs run on a smaller copy of the image. Each resample halves the size, the blur is run at the
+		// smallest size, then one resample scales the result back up. The image they read is left unchanged
+		if (IsBlurPyramid(chainIndex))
+		{
+			RenderPass resamplePass;
+			resamplePass.type       = RenderPassType::Resample;
+			resamplePass.chainIndex = chainIndex;
+
+			int sizeDivisor = 1;
+			for (int level = 0; level < mBlurLevels; ++level)
+			{
+				sizeDivisor *= 2;
+				resamplePass.inputs[0] = colour;
+				resamplePass.output    = AddTransient(sizeDivisor);
+				AddPass(resamplePass);
+				colour = resamplePass.output;
+			}
+
+			for (int blur = 0; blur < 2; ++blur)
+			{
+				RenderPass blurPass;
+				blurPass.type       = mComputeTiles ? RenderPassType::ComputeTile : RenderPassType::PostProcess;
+				blurPass.effect     = chain[chainIndex + blur].first;
+				blurPass.chainIndex = chainIndex + blur;
+				blurPass.inputs[0]  = colour;
+				blurPass.output     = mComputeTiles ? AddTransient(sizeDivisor, TargetFormat::RGBA8, COMPUTE_OUTPUT_BIND) : AddTransient(sizeDivisor);
+				AddPass(blurPass);
+				colour = blurPass.output;
+			}
+
+			resamplePass.chainIndex = chainIndex + 1;
+			resamplePass.inputs[0]  = colour;
+			resamplePass.output     = AddTransient();
+			AddPass(resamplePass);
+			colour = resamplePass.output;
+
+			++chainIndex;
+			continue;
+		}
+
+		// Full screen dilations and box blurs run as two compute passes, the first writing a higher precision image for the
+		// second to read. Box blurs with spread out taps can't, they use their pixel shader
+		bool sliding = declaration.slidingFilter && (postProcess != PostProcess::OnePassBlur || mSlidingBoxBlur);
+		if (sliding && chain[chainIndex].second == PostProcessMode::Fullscreen)
+		{
+			RenderPass rowsPass;
+			rowsPass.type       = RenderPassType::SlidingFilterRows;
+			rowsPass.effect     = postProcess;
+			rowsPass.chainIndex = chainIndex;
+			rowsPass.inputs[0]  = colour;
+			rowsPass.output     = AddTransient(1, TargetFormat::RGBA16F, TARGET_BIND_SHADER_RESOURCE | TARGET_BIND_UNORDERED_ACCESS);
+			AddPass(rowsPass);
+
+			RenderPass columnsPass = rowsPass;
+			columnsPass.type      = RenderPassType::SlidingFilterColumns;
+			columnsPass.inputs[0] = rowsPass.output;
+			columnsPass.output    = AddTransient(1, TargetFormat::RGBA8, COMPUTE_OUTPUT_BIND);
+			AddPass(columnsPass);
+			colour = columnsPass.output;
+			continue;
+		}
+
+		// The first full screen effect that can spread its samples over several frames does so, in all of its passes from here
+		int temporalFrames = 1;
+		if (mTemporalAccumulation && !historyUsed && declaration.temporalFrames > 1 && chain[chainIndex].second == PostProcessMode::Fullscreen)
+		{
+			temporalFrames = declaration.temporalFrames;
+			historyUsed = true;
+		}
+		size_t firstEffectPass = mPasses.size();
+
+		// Bloom makes its glow and lens star from the image it reads, then adds them to it with its own pass below
+		if (postProcess == PostProcess::Bloom)  AddBloomPasses(chainIndex, colour, namedResources);
+
+		// Depth of field makes its circle of confusion and blurred near and far fields, then puts them together with its own pass
+		if (postProcess == PostProcess::DepthOfField)  AddDepthOfFieldPasses(chainIndex, colour, namedResources);
+
+		// Motion blur finds the longest velocity near each pixel from tiles made by a pass of its own
+		if (postProcess == PostProcess::MotionBlur)  AddMotionBlurPasses(chainIndex, namedResources);
+
+		if (declaration.publishesInputAs != PassInput::None)
+		{
+			namedResources[declaration.publishesInputAs] = colour;
+			isPublished = true;
+		}
+
+		RenderPass pass;
+		pass.effect     = postProcess;
+		pass.mode       = chain[chainIndex].second;
+		pass.chainIndex = chainIndex;
+		pass.inPlace = pass.mode != PostProcessMode::Fullscreen && !declaration.unboundedFootprint && !isPublished;
+		if (mComputeTiles && declaration.computeTile && pass.mode == PostProcessMode::Fullscreen)  pass.type = RenderPassType::ComputeTile;
+
+		// Effects with a smooth change to the image can run on a smaller copy of it. Not for effects blended with their history,
+		// which is full size, or whose input is published, which later effects expect at full size
+		int sizeDivisor = 1;
+		if (mReducedResolution && pass.mode == PostProcessMode::Fullscreen && temporalFrames == 1 && !isPublished)
+		{
+			sizeDivisor = declaration.reducedResolutionDivisor;
+		}
+
+		// The image read as Colour - for in-place passes, a copy of the pixels around the region, for reduced resolution
+		// passes the image halved in size until it is small enough
+		int colourInput = colour;
+		if (pass.inPlace)
+		{
+			RenderPass copyPass = pass;
+			copyPass.type      = RenderPassType::CopyRegion;
+			copyPass.inPlace   = false;
+			copyPass.inputs    = { colour, -1, -1 };
+			copyPass.output    = AddTransient();
+			AddPass(copyPass);
+			colourInput = copyPass.output;
+		}
+		for (int resampleDivisor = 2; resampleDivisor <= sizeDivisor; resampleDivisor *= 2)
+		{
+			RenderPass resamplePass;
+			resamplePass.type       = RenderPassType::Resample;
+			resamplePass.chainIndex = chainIndex;
+			resamplePass.inputs[0]  = colourInput;
+			resamplePass.output     = AddTransient(resampleDivisor);
+			AddPass(resamplePass);
+			colourInput = resamplePass.output;
+		}
+
+		for (int slot = 0; slot < MAX_PASS_INPUTS; ++slot)
+		{
+			switch (declaration.inputs[slot])
+			{
+			case PassInput::Colour:        pass.inputs[slot] = colourInput;             break;
+			case PassInput::SceneDepth:    pass.inputs[slot] = SCENE_DEPTH_RESOURCE;    break;
+			case PassInput::SceneVelocity: pass.inputs[slot] = SCENE_VELOCITY_RESOURCE; break;
+			case PassInput::History:       pass.inputs[slot] = HISTORY_RESOURCE;        break;
+			case PassInput::None:          pass.inputs[slot] = -1;                      break;
+
+			default:
+			{
+				// A named image - if nothing published it fall back to the current colour
+				auto named = namedResources.find(declaration.inputs[slot]);
+				pass.inputs[slot] = (named != namedResources.end()) ? named->second : colourInput;
+				break;
+			}
+			}
+		}
+		if      (pass.inPlace)                                pass.output = colour;
+		else if (pass.type == RenderPassType::ComputeTile)  pass.output = AddTransient(sizeDivisor, TargetFormat::RGBA8, COMPUTE_OUTPUT_BIND);
+		else                                                pass.output = AddTransient(sizeDivisor);
+		AddPass(pass);
+
+		// Add the change the reduced resolution pass made back on to the full size image
+		if (sizeDivisor > 1)
+		{
+			RenderPass upsamplePass;
+			upsamplePass.type       = RenderPassType::ReducedResolutionUpsample;
+			upsamplePass.effect     = postProcess;
+			upsamplePass.chainIndex = chainIndex;
+			upsamplePass.inputs     = { colour, pass.output, colourInput };
+			upsamplePass.output     = AddTransient();
+			AddPass(upsamplePass);
+			colour = upsamplePass.output;
+		}
+		else
+		{
+			colour = pass.output;
+		}
+
+		// Blend the effect's output with its history, then keep the result as the history for next frame. The resolved image
+		// holds its view space depth in alpha, which the history needs
+		if (temporalFrames > 1)
+		{
+			for (size_t passIndex = firstEffectPass; passIndex < mPasses.size(); ++passIndex)
+			{
+				mPasses[passIndex].temporalFrames = temporalFrames;
+			}
+
+			RenderPass resolvePass;
+			resolvePass.type           = RenderPassType::TemporalResolve;
+			resolvePass.effect         = postProcess;
+			resolvePass.chainIndex     = chainIndex;
+			resolvePass.temporalFrames = temporalFrames;
+			resolvePass.inputs         = { colour, HISTORY_RESOURCE, SCENE_DEPTH_RESOURCE };
+			resolvePass.output         = AddTransient(1, TargetFormat::RGBA16F);
+			AddPass(resolvePass);
+			colour = resolvePass.output;
+
+			RenderPass copyPass;
+			copyPass.type       = RenderPassType::CopyResource;
+			copyPass.chainIndex = chainIndex;
+			copyPass.inputs[0]  = colour;
+			copyPass.output     = HISTORY_RESOURCE;
+			AddPass(copyPass);
+		}
+	}
+
+	AddPresentStage(colour);
+	mFinalOutput = BACK_BUFFER_RESOURCE;
+
+	ComputeLifetimes();
+	mCompiled = true;
+}
+
+
+int RenderGraph::AddTransient(int sizeDivisor, TargetFormat format, unsigned int bind)
+{
+	GraphResource resource = { GraphResourceType::Transient };
+	resource.sizeDivisor = sizeDivisor;
+	resource.format      = format;
+	resource.bind        = bind;
+	mResources.push_back(resource);
+	return static_cast<int>(mResources.size()) - 1;
+}
+
+void RenderGraph::AddPass(const RenderPass& pass)
+{
+	mPasses.push_back(pass);
+}
+
+
+// Downsampled images from half size, then upsampled images summing them from the smallest back up to half size, all 16-bit
+// float. The lens star's streaks read the quarter size downsample. These are all full screen whatever the bloom's own mode
+void RenderGraph::AddBloomPasses(int chainIndex, int colour, std::map<PassInput, int>& namedResources)
+{
+	RenderPass downsamplePass;
+	downsamplePass.type       = RenderPassType::BloomDownsample;
+	downsamplePass.effect     = PostProcess::Bloom;
+	downsamplePass.chainIndex = chainIndex;
+
+	std::array<int, BLOOM_LEVELS> levels;
+	int starInput = -1;
+	int sizeDivisor = 1;
+	for (int level = 0; level < BLOOM_LEVELS; ++level)
+	{
+		sizeDivisor *= 2;
+		downsamplePass.inputs[0] = (level == 0) ? colour : levels[level - 1];
+		downsamplePass.output    = AddTransient(sizeDivisor, TargetFormat::RGBA16F);
+		AddPass(downsamplePass);
+		levels[level] = downsamplePass.output;
+		if (sizeDivisor == BLOOM_STAR_SIZE_DIVISOR)  starInput = downsamplePass.output;
+	}
+
+	RenderPass upsamplePass = downsamplePass;
+	upsamplePass.type = RenderPassType::BloomUpsample;
+
+	int glow = levels[BLOOM_LEVELS - 1];
+	for (int level = BLOOM_LEVELS - 2; level >= 0; --level)
+	{
+		sizeDivisor /= 2;
+		upsamplePass.inputs = { glow, levels[level], -1 };
+		upsamplePass.output = AddTransient(sizeDivisor, TargetFormat::RGBA16F);
+		AddPass(upsamplePass);
+		glow = upsamplePass.output;
+	}
+	namedResources[PassInput::BloomBlur] = glow;
+
+	namedResources[PassInput::BloomStar] = AddLensStarPasses(chainIndex, starInput);
+}
+
+
+// Each streak in turn: the passes along its two sides, then its last pass adding both to the star so far. The images between
+// the passes and the star so far are 16-bit float, the finished star (after its brightness is compressed) 8-bit
+int RenderGraph::AddLensStarPasses(int chainIndex, int source)
+{
+	RenderPass streakPass;
+	streakPass.type       = RenderPassType::LensStarStreak;
+	streakPass.effect     = PostProcess::Bloom;
+	streakPass.chainIndex = chainIndex;
+
+	int star = -1;
+	for (int streak = 0; streak < LENS_STAR_STREAKS; ++streak)
+	{
+		streakPass.streak = streak;
+
+		int sides[2] = { source, source }; // Along the streak's direction and against it
+		for (int pass = 0; pass < mLensStarPasses - 1; ++pass)
+		{
+			streakPass.streakPass = pass;
+			for (int side = 0; side < 2; ++side)
+			{
+				streakPass.streakBackward = side == 1;
+				streakPass.inputs = { sides[side], -1, -1 };
+				streakPass.output = AddTransient(BLOOM_STAR_SIZE_DIVISOR, TargetFormat::RGBA16F);
+				AddPass(streakPass);
+				sides[side] = streakPass.output;
+			}
+		}
+
+		bool lastStreak = streak == LENS_STAR_STREAKS - 1;
+		streakPass.streakPass     = mLensStarPasses - 1;
+		streakPass.streakBackward = false;
+		streakPass.inputs = { sides[0], sides[1], star };
+		streakPass.output = AddTransient(BLOOM_STAR_SIZE_DIVISOR, lastStreak ? TargetFormat::RGBA8 : TargetFormat::RGBA16F);
+		AddPass(streakPass);
+		star = streakPass.output;
+	}
+	return star;
+}
+
+
+// The circle of confusion image at full size and the near and far fields are 16-bit float, the CoC is signed. These are all
+// full screen whatever the depth of field's own mode
+void RenderGraph::AddDepthOfFieldPasses(int chainIndex, int colour, std::map<PassInput, int>& namedResources)
+{
+	RenderPass cocPass;
+	cocPass.type       = RenderPassType::DepthOfFieldCoC;
+	cocPass.effect     = PostProcess::DepthOfField;
+	cocPass.chainIndex = chainIndex;
+	cocPass.inputs     = { colour, SCENE_DEPTH_RESOURCE, -1 };
+	cocPass.output     = AddTransient(1, TargetFormat::RGBA16F);
+	AddPass(cocPass);
+	namedResources[PassInput::DepthOfFieldCoC] = cocPass.output;
+
+	RenderPass tilesPass = cocPass;
+	tilesPass.type   = RenderPassType::DepthOfFieldTiles;
+	tilesPass.inputs = { cocPass.output, -1, -1 };
+	tilesPass.output = AddTransient(DOF_TILE_SIZE, TargetFormat::RGBA16F);
+	AddPass(tilesPass);
+
+	RenderPass farPass = cocPass;
+	farPass.type   = RenderPassType::DepthOfFieldFar;
+	farPass.inputs = { cocPass.output, tilesPass.output, -1 };
+	farPass.output = AddTransient(DOF_GATHER_SIZE_DIVISOR, TargetFormat::RGBA16F);
+	AddPass(farPass);
+	namedResources[PassInput::DepthOfFieldFar] = farPass.output;
+
+	RenderPass nearPass = farPass;
+	nearPass.type   = RenderPassType::DepthOfFieldNear;
+	nearPass.output = AddTransient(DOF_GATHER_SIZE_DIVISOR, TargetFormat::RGBA16F);
+	AddPass(nearPass);
+	namedResources[PassInput::DepthOfFieldNear] = nearPass.output;
+}
+
+
+// The tile image is 16-bit float, as velocities are signed. Full screen whatever the motion blur's own mode
+void RenderGraph::AddMotionBlurPasses(int chainIndex, std::map<PassInput, int>& namedResources)
+{
+	RenderPass tilesPass;
+	tilesPass.type       = RenderPassType::MotionBlurTiles;
+	tilesPass.effect     = PostProcess::MotionBlur;
+	tilesPass.chainIndex = chainIndex;
+	tilesPass.inputs     = { SCENE_VELOCITY_RESOURCE, -1, -1 };
+	tilesPass.output     = AddTransient(MOTION_BLUR_TILE_SIZE, TargetFormat::RGBA16F);
+	AddPass(tilesPass);
+	namedResources[PassInput::MotionBlurTiles] = tilesPass.output;
+}
+
+
+int RenderGraph::PolygonBatchSize(int chainIndex) const
+{
+	int batchSize = 0;
+	for (int i = chainIndex; i < static_cast<int>(mChain.size()); ++i)
+	{
+		if (mChain[i].second != PostProcessMode::WindowPolygon)  break;
+
+		// Only effects that have a version in the batch shader and only read the colour image near their polygon
+		PostProcessDeclaration declaration = GetPostProcessDeclaration(mChain[i].first);
+		if (declaration.polygonBatchEffect < 0 || declaration.unboundedFootprint ||
+			declaration.publishesInputAs != PassInput::None)  break;
+		++batchSize;
+	}
+	return batchSize;
+}
+
+
+int RenderGraph::ColourTransformSize(int chainIndex) const
+{
+	int transformSize = 0;
+	int lastIndex = std::min(chainIndex + MAX_COLOUR_TRANSFORM_EFFECTS, static_cast<int>(mChain.size()));
+	for (int i = chainIndex; i < lastIndex; ++i)
+	{
+		if (mChain[i].second != PostProcessMode::Fullscreen)  break;
+
+		ColourTransformKind kind = GetPostProcessDeclaration(mChain[i].first).colourTransform;
+		if (kind == ColourTransformKind::None)  break;
+		++transformSize;
+
+		// An effect that changes down the screen must be the last one, only the last stage of the pass can (see ColourTransform.h)
+		if (kind == ColourTransformKind::AffineVertical)  break;
+	}
+	return transformSize;
+}
+
+
+int RenderGraph::UVRemapSize(int chainIndex) const
+{
+	int remapSize = 0;
+	int lastIndex = std::min(chainIndex + MAX_UV_REMAP_EFFECTS, static_cast<int>(mChain.size()));
+	for (int i = chainIndex; i < lastIndex; ++i)
+	{
+		if (mChain[i].second != PostProcessMode::Fullscreen)  break;
+		UVRemapKind kind = GetPostProcessDeclaration(mChain[i].first).uvRemap;
+		if (kind == UVRemapKind::None)  break;
+
+		// Chromatic distortion reads each colour channel at its own UV, so effects before it would have to be followed back
+		// three times. It only starts a run
+		if (kind == UVRemapKind::ChromaticDistortion && i > chainIndex)  break;
+		++remapSize;
+	}
+	return remapSize;
+}
+
+
+bool RenderGraph::IsBlurPyramid(int chainIndex) const
+{
+	if (mBlurLevels <= 0 || chainIndex + 1 >= static_cast<int>(mChain.size()))  return false;
+
+	const auto& horizontal = mChain[chainIndex];
+	const auto& vertical   = mChain[chainIndex + 1];
+	return horizontal.first == PostProcess::GaussianBlurHorizontal && horizontal.second == PostProcessMode::Fullscreen &&
+	       vertical.first   == PostProcess::GaussianBlurVertical   && vertical.second   == PostProcessMode::Fullscreen;
+}
+
+
+// Only the final pass of the chain draws to the back buffer, all earlier passes only write their own targets
+void RenderGraph::AddPresentStage(int finalColour)
+{
+	// Find the pass that wrote the final image, and check nothing reads it afterwards
+	int writer = -1;
+	bool readLater = false;
+	for (int passIndex = 0; passIndex < static_cast<int>(mPasses.size()); ++passIndex)
+	{
+		if (mPasses[passIndex].output == finalColour)  writer = passIndex;
+		for (int input : mPasses[passIndex].inputs)
+		{
+			if (writer >= 0 && input == finalColour)  readLater = true;
+		}
+	}
+
+	bool isDraw = writer >= 0 && (mPasses[writer].type == RenderPassType::PostProcess || mPasses[writer].type == RenderPassType::ColourTransform ||
+	                              mPasses[writer].type == RenderPassType::UVRemap ||
+	                              mPasses[writer].type == RenderPassType::Resample || mPasses[writer].type == RenderPassType::ReducedResolutionUpsample);
+	if (isDraw && !readLater && !mPasses[writer].inPlace)
+	{
+		// Usual case - the last effect draws straight to the screen. The image it was going to write is now unused
+		mPasses[writer].output = BACK_BUFFER_RESOURCE;
+	}
+	else
+	{
+		// No effects at all, the final image is needed again (e.g. kept as the temporal history), or the
+		// last effect only drew its region into the image
+		RenderPass copyPass;
+		copyPass.chainIndex = static_cast<int>(mChain.size());
+		copyPass.inputs[0]  = finalColour;
+		copyPass.output     = BACK_BUFFER_RESOURCE;
+		AddPass(copyPass);
+	}
+}
+
+
+bool RenderGraph::ReadsResource(int resource) const
+{
+	for (auto& pass : mPasses)
+	{
+		for (int input : pass.inputs)
+		{
+			if (input == resource)  return true;
+		}
+	}
+	return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Lifetimes and aliasing
+//--------------------------------------------------------------------------------------
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (auto& resource : mResources)
+	{
+		resource.firstUse = -1;
+		resource.lastUse  = -1;
+	}
+
+	for (int passIndex = 0; passIndex < static_cast<int>(mPasses.size()); ++passIndex)
+	{
+		const RenderPass& pass = mPasses[passIndex];
+		for (int input : pass.inputs)
+		{
+			if (input < 0)  continue;
+			mResources[input].lastUse = passIndex;
+
+			// Polygon batch passes fill their scratch input themselves
+			if (pass.type == RenderPassType::PolygonBatch && mResources[input].type == GraphResourceType::Transient &&
+				mResources[input].firstUse < 0)
+			{
+				mResources[input].firstUse = passIndex;
+			}
+		}
+
+		// Imported resources exist before the graph so are never "first written" by it
+		GraphResource& output = mResources[pass.output];
+		if (output.type == GraphResourceType::Transient && output.firstUse < 0)  output.firstUse = passIndex;
+		output.lastUse = passIndex; // In-place passes write an image after it has been read
+	}
+}
+
+
+void RenderGraph::ExtendLifetime(int resource, int lastUse)
+{
+	GraphResource& graphResource = mResources[resource];
+	graphResource.lastUse = std::max(graphResource.lastUse, lastUse);
+}
+
+
+void RenderGraph::AllocateTargets(RenderTargetAllocator& allocator, int viewportWidth, int viewportHeight)
+{
+	// Resources are created in the order they are written, which is the order the allocator needs. The scene
+	// colour comes first and is written before any pass
+	for (auto& resource : mResources)
+	{
+		if (resource.type != GraphResourceType::SceneColour && resource.type != GraphResourceType::Transient)  continue;
+
+		resource.physical = -1;
+		bool isWritten = resource.type == GraphResourceType::SceneColour || resource.firstUse >= 0;
+		if (!isWritten)  continue; // Not used by any pass (e.g. the output the final pass had before it was sent to the back buffer)
+
+		RenderTargetDesc desc;
+		desc.width  = std::max(viewportWidth  / resource.sizeDivisor, 1);
+		desc.height = std::max(viewportHeight / resource.sizeDivisor, 1);
+		desc.format = resource.format;
+		desc.bind   = resource.bind;
+		resource.physical = allocator.Allocate(desc, resource.firstUse, resource.lastUse);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Scene passes
+//--------------------------------------------------------------------------------------
+
+std::vector<ScenePass> PlanScenePasses(const RenderGraph& graph, bool depthPrePass)
+{
+	bool needsDepth    = graph.ReadsResource(SCENE_DEPTH_RESOURCE);
+	bool needsVelocity = graph.ReadsResource(SCENE_VELOCITY_RESOURCE);
+
+	std::vector<ScenePass> scenePasses;
+	if (depthPrePass)
+	{
+		ScenePass depthPass;
+		depthPass.depthOnly  = true;
+		depthPass.sceneDepth = needsDepth;
+		scenePasses.push_back(depthPass);
+	}
+
+	ScenePass colourPass;
+	colourPass.sceneDepth          = needsDepth;
+	colourPass.depthAlreadyWritten = depthPrePass;
+	scenePasses.push_back(colourPass);
+
+	if (needsVelocity)
+	{
+		ScenePass velocityPass;
+		velocityPass.velocity            = true;
+		velocityPass.sceneDepth          = needsDepth;
+		velocityPass.depthAlreadyWritten = true;
+		scenePasses.push_back(velocityPass);
+	}
+
+	return scenePasses;
+}
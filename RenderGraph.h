@@ -0,0 +1,259 @@
+//--------------------------------------------------------------------------------------
+// Render graph for the post-processing chain
+//--------------------------------------------------------------------------------------
+// Turns the list of active post-processes into an ordered list of passes. Each pass names the
+// images it reads and writes, and the graph decides which physical texture backs each image.
+// Images whose lifetimes don't overlap share a texture (aliasing), so a chain only needs as many
+// textures as it has images alive at the same time, and nothing needs to be copied around to
+// keep an image alive for a later effect (e.g. the original scene that bloom adds its glow to).
+//
+// This class only plans the work, it doesn't touch DirectX. The physical targets are slots of a
+// RenderTargetAllocator (see RenderTargetPool.h), Scene.cpp walks the compiled passes and maps
+// each slot to an actual texture
+
+#ifndef _RENDER_GRAPH_H_INCLUDED_
+#define _RENDER_GRAPH_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "RenderTargetPool.h"
+
+#include <array>
+#include <map>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Graph resources (images)
+//--------------------------------------------------------------------------------------
+
+enum class GraphResourceType
+{
+	SceneColour,    // Scene rendered by the main camera, written before the first pass
+	SceneDepth,     // Depth of the main scene. Imported, never aliased
+	SceneVelocity,  // How far each pixel of the main scene moved since the last frame (see MotionBlur.h). Imported, never aliased
+	History,        // The chain's temporal history, kept from the previous frame (see TemporalHistory.h). Imported, never aliased
+	BackBuffer,     // The swap chain back buffer, i.e. what appears on screen. Imported, only written by the final pass
+	Transient,      // Intermediate image written by one pass and read by later ones
+};
+
+// The first five resources of every graph are always these
+const int SCENE_COLOUR_RESOURCE   = 0;
+const int SCENE_DEPTH_RESOURCE    = 1;
+const int HISTORY_RESOURCE        = 2;
+const int BACK_BUFFER_RESOURCE    = 3;
+const int SCENE_VELOCITY_RESOURCE = 4;
+
+struct GraphResource
+{
+	GraphResourceType type;
+	int firstUse = -1; // Pass that first writes the image (-1 for images that exist before post-processing starts)
+	int lastUse  = -1; // Last pass that reads or writes the image
+	int physical = -1; // Pooled target backing this image (-1 for imported resources and unused images)
+
+	// Size and format of colour images, the size is the viewport size divided by sizeDivisor (e.g. 2 for half resolution)
+	int          sizeDivisor = 1;
+	TargetFormat format      = TargetFormat::RGBA8;
+	unsigned int bind        = TARGET_BIND_RENDER_TARGET | TARGET_BIND_SHADER_RESOURCE; // Ways the image's target is used
+};
+
+
+//--------------------------------------------------------------------------------------
+// Graph passes
+//--------------------------------------------------------------------------------------
+
+enum class RenderPassType
+{
+	PostProcess,  // Run a post-process shader from the inputs to the output
+	CopyResource, // Copy input 0 to the output without running a shader
+	CopyRegion,   // Copy just the pixels the pass's area or polygon effect will read (its region plus halo)
+	PolygonBatch,    // Run several consecutive window polygon effects in place in one draw (see PolygonBatch.h)
+	ColourTransform, // Run several consecutive full screen colour effects as one draw (see ColourTransform.h)
+	UVRemap,         // Run several consecutive full screen distortions as one draw, reading input 0 once (see UVRemap.h)
+	Resample,        // Copy input 0 to an output of a different size with bilinear filtering (see GaussianKernel.h)
+	SlidingFilterRows,    // Full screen dilation or box blur along the rows only, written by a compute shader (see SlidingFilter.h)
+	SlidingFilterColumns, // The same down the columns, finishing the effect
+	ComputeTile,          // Full screen effect written by its compute shader a tile at a time (see ComputeTile.h)
+	BloomDownsample,      // One of the bloom's downsampled images, half the size of input 0 (see Bloom.h)
+	BloomUpsample,        // One of the bloom's upsampled images, input 0 (the level below) blurred up to the size of input 1 and added
+	LensStarStreak,       // One pass of one of the lens star's streaks, reading the pass before (see LensStar.h)
+	DepthOfFieldCoC,      // Input 0 with the circle of confusion from the depth in input 1 (see DepthOfField.h)
+	DepthOfFieldTiles,    // Smallest and largest circle of confusion of each tile of input 0
+	DepthOfFieldFar,      // Blurred far field of input 0, reading the tiles in input 1
+	DepthOfFieldNear,     // Blurred near field of input 0, reading the tiles in input 1
+	MotionBlurTiles,      // Longest velocity of each tile of input 0, the scene velocity (see MotionBlur.h)
+	TemporalResolve,      // Input 0 blended with the history (input 1) reprojected with the depth in input 2 (see TemporalHistory.h)
+
+	// Full size result of an effect run on a smaller image: input 0 (the full size image the effect read) plus the change the
+	// effect made, i.e. input 1 (the effect's smaller output) minus input 2 (the smaller image it read). The change is scaled
+	// up with a joint bilateral filter - each nearby small pixel is weighted by how close its colour before the effect is to
+	// the full size pixel, so the change doesn't bleed across edges. Areas the effect didn't change stay exactly as sharp
+	ReducedResolutionUpsample,
+};
+
+struct RenderPass
+{
+	RenderPassType  type       = RenderPassType::PostProcess;
+	PostProcess     effect     = PostProcess::Copy;
+	PostProcessMode mode       = PostProcessMode::Fullscreen;
+	int             chainIndex = 0; // Position of the effect in the post-process chain (window polygons use this to pick their opening)
+	int             batchSize  = 1; // Polygon batch and colour transform passes only - number of chain entries from chainIndex in the pass
+
+	// Lens star streak passes only - the streak, the pass along it and, for passes before the last, whether the pass is on the
+	// side of the streak against its direction. The last pass of a streak reads both sides (see LensStar.h)
+	int  streak         = 0;
+	int  streakPass     = 0;
+	bool streakBackward = false;
+
+	// Frames the samples of the pass are spread over, for the passes of an effect with temporal accumulation (see TemporalHistory.h)
+	int temporalFrames = 1;
+
+	// Area and polygon effects whose footprint is bounded run in place: they draw only their region into the image they
+	// process, which keeps the rest of it. The pixels they read come from a region copy made by the pass before.
+	// Polygon batch passes are always in place and make their own region copies into input 0
+	bool inPlace = false;
+
+	std::array<int, MAX_PASS_INPUTS> inputs = { -1, -1, -1 }; // Resource read in each texture slot, -1 if unused
+	int output = -1;                                          // Resource written (for in-place passes, the image that was processed)
+};
+
+
+//--------------------------------------------------------------------------------------
+// Render graph class
+//--------------------------------------------------------------------------------------
+
+class RenderGraph
+{
+public:
+	//-------------------------------------
+	// Construction / Usage
+	//-------------------------------------
+
+	// Build the passes for the given chain and find the lifetime of each image. Only needs calling when
+	// the chain changes. The last pass always writes the back buffer - an empty chain gives a single
+	// copy of the scene to the back buffer. Runs of full screen colour effects and of full screen distortions are each run as one
+	// pass - see ColourTransform.h and UVRemap.h. Full screen Gaussian blurs (a horizontal pass then a vertical one) are run on
+	// the image halved in size blurLevels times then scaled back up, for wide blurs - see GaussianBlurLevels. Full screen
+	// dilations are run as a pass along the rows then one down the columns - see SlidingFilter.h - and so are box blurs if
+	// slidingBoxBlur is true, which must be BoxBlurIsSliding of the settings the passes will be run with. Bloom adds the
+	// passes making its glow and lens star before its own - see Bloom.h - and depth of field the passes making its circle of
+	// confusion and its near and far fields - see DepthOfField.h - and motion blur the pass finding the longest velocity of each
+	// tile - see MotionBlur.h. If computeTiles is true, full screen passes of effects
+	// declared with computeTile run their compute shader instead of their pixel shader. If reducedResolution is true, full screen
+	// passes of effects declared with a reducedResolutionDivisor run on a smaller copy of the image and their change is scaled
+	// back up - see RenderPassType::ReducedResolutionUpsample. If temporalAccumulation is true, the first full screen effect
+	// declared with temporalFrames spreads its samples over several frames and is followed by the passes blending it with its
+	// history - see TemporalHistory.h. Each side of each streak of the bloom's lens star takes lensStarPasses passes, which
+	// must be LensStarPasses of the streak length the passes will be run with - see LensStar.h
+	void Compile(const PostProcessChain& chain, int blurLevels = 0, bool computeTiles = false, bool reducedResolution = false,
+	             bool temporalAccumulation = false, int lensStarPasses = 1, bool slidingBoxBlur = false);
+
+	// Request a pooled target for each colour image (the scene and the transients) from the given allocator, which
+	// shares targets between images whose lifetimes don't overlap. Call every frame, between the allocator's
+	// BeginFrame and EndFrame
+	void AllocateTargets(RenderTargetAllocator& allocator, int viewportWidth, int viewportHeight);
+
+	// Keep an image alive until at least the given pass, so its target isn't shared with any image written before then.
+	// For devices that run several passes at once, where the first pass may still be reading its inputs while the last
+	// writes its output (see CPUTileFusion.h). Lasts until the graph is next compiled
+	void ExtendLifetime(int resource, int lastUse);
+
+	// True if the graph has been compiled from the given chain and options, i.e. no need to compile again
+	bool IsCompiledFrom(const PostProcessChain& chain, int blurLevels = 0, bool computeTiles = false, bool reducedResolution = false,
+	                    bool temporalAccumulation = false, int lensStarPasses = 1, bool slidingBoxBlur = false) const
+	{
+		return mCompiled && chain == mChain && blurLevels == mBlurLevels && computeTiles == mComputeTiles &&
+		       reducedResolution == mReducedResolution && temporalAccumulation == mTemporalAccumulation &&
+		       lensStarPasses == mLensStarPasses && slidingBoxBlur == mSlidingBoxBlur;
+	}
+
+
+	//-------------------------------------
+	// Data access
+	//-------------------------------------
+
+	const std::vector<RenderPass>&    Passes() const     { return mPasses; }
+	const std::vector<GraphResource>& Resources() const  { return mResources; }
+	const GraphResource& Resource(int resource) const    { return mResources[resource]; }
+
+	// The resource holding the final image of the chain (always the back buffer once compiled)
+	int FinalOutput() const  { return mFinalOutput; }
+
+	// True if any pass reads the given resource (e.g. to find out if the scene depth is needed)
+	bool ReadsResource(int resource) const;
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	int  AddTransient(int sizeDivisor = 1, TargetFormat format = TargetFormat::RGBA8,
+	                  unsigned int bind = TARGET_BIND_RENDER_TARGET | TARGET_BIND_SHADER_RESOURCE);
+	void AddPass(const RenderPass& pass);
+
+	// Number of consecutive chain entries from the given one that could run as a single polygon batch pass
+	int  PolygonBatchSize(int chainIndex) const;
+
+	// Number of consecutive chain entries from the given one that could run as a single colour transform pass
+	int  ColourTransformSize(int chainIndex) const;
+
+	// Number of consecutive chain entries from the given one that could run as a single UV remap pass
+	int  UVRemapSize(int chainIndex) const;
+
+	// True if the given chain entry and the next are a full screen Gaussian blur to run on a smaller image
+	bool IsBlurPyramid(int chainIndex) const;
+
+	// Add the passes making the images read by the bloom at the given chain entry from the given colour, and name them
+	void AddBloomPasses(int chainIndex, int colour, std::map<PassInput, int>& namedResources);
+
+	// Add the passes of the lens star's streaks for the bloom at the given chain entry, reading the given image. Returns the star
+	int  AddLensStarPasses(int chainIndex, int source);
+
+	// Add the passes making the images read by the depth of field at the given chain entry from the given colour, and name them
+	void AddDepthOfFieldPasses(int chainIndex, int colour, std::map<PassInput, int>& namedResources);
+
+	// Add the pass making the tiles read by the motion blur at the given chain entry, and name it
+	void AddMotionBlurPasses(int chainIndex, std::map<PassInput, int>& namedResources);
+
+	// Send the given image to the back buffer, either by retargeting the pass that writes it, or with a copy pass
+	void AddPresentStage(int finalColour);
+
+	// Fill in firstUse/lastUse for each resource
+	void ComputeLifetimes();
+
+	PostProcessChain           mChain;    // Chain this graph was compiled from
+	int                        mBlurLevels = 0;
+	bool                       mComputeTiles = false;
+	bool                       mReducedResolution = false;
+	bool                       mTemporalAccumulation = false;
+	int                        mLensStarPasses = 1;
+	bool                       mSlidingBoxBlur = false;
+	bool                       mCompiled = false;
+	std::vector<RenderPass>    mPasses;
+	std::vector<GraphResource> mResources;
+	int                        mFinalOutput = SCENE_COLOUR_RESOURCE;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Scene passes
+//--------------------------------------------------------------------------------------
+// The scene is rendered before the graph runs. If any pass reads the scene depth then the scene
+// is rendered straight into the shader-readable depth texture, rather than into the usual depth
+// buffer and then a second time into the depth texture. Optionally a depth-only pre-pass fills the
+// depth first, so the expensive pixel shading of the colour pass only runs for visible pixels (early-Z).
+// If any pass reads the scene velocity, a velocity pass follows the colour pass, drawing the opaque
+// models again with cheap shaders that only write how far each pixel moved (see Velocity_vs.hlsl)
+
+struct ScenePass
+{
+	bool depthOnly           = false; // Only write depth, no pixel shader and no colour target
+	bool velocity            = false; // Only write the scene velocity, testing against the depth already written
+	bool sceneDepth          = false; // Use the shader-readable scene depth texture rather than the usual depth buffer
+	bool depthAlreadyWritten = false; // Depth has been filled by an earlier pass - test against it without writing or clearing
+};
+
+// The scene passes to issue before running the given graph, in order. Depends on the whole chain, not just the last effect added
+std::vector<ScenePass> PlanScenePasses(const RenderGraph& graph, bool depthPrePass);
+
+
+#endif //_RENDER_GRAPH_H_INCLUDED_
@@ -0,0 +1,130 @@
+//--------------------------------------------------------------------------------------
+// Pool of render targets shared between the images used in a frame
+//--------------------------------------------------------------------------------------
+
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+
+
+int BytesPerPixel(TargetFormat format)
+{
+	switch (format)
+	{
+	case TargetFormat::RGBA16F:  return 8;
+	case TargetFormat::R32F:     return 4;
+	case TargetFormat::RGBA8:
+	default:                     return 4;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Allocation
+//--------------------------------------------------------------------------------------
+
+void RenderTargetAllocator::BeginFrame()
+{
+	for (auto& slot : mSlots)
+	{
+		slot.usedThisFrame = false;
+		slot.busyUntil = -1;
+	}
+	mFrameRequestedBytes = 0;
+}
+
+
+int RenderTargetAllocator::Allocate(const RenderTargetDesc& desc, int firstUse, int lastUse)
+{
+	mFrameRequestedBytes += desc.Bytes();
+
+	// Prefer a matching target that already exists, either unused so far this frame or whose last image is finished with
+	int slotIndex = -1;
+	for (int i = 0; i < static_cast<int>(mSlots.size()); ++i)
+	{
+		const PooledTargetSlot& slot = mSlots[i];
+		if (slot.alive && slot.desc == desc && (!slot.usedThisFrame || slot.busyUntil < firstUse))
+		{
+			slotIndex = i;
+			break;
+		}
+	}
+
+	// Otherwise a new target, reusing the number of a reclaimed slot if there is one
+	if (slotIndex < 0)
+	{
+		for (int i = 0; i < static_cast<int>(mSlots.size()); ++i)
+		{
+			if (!mSlots[i].alive)
+			{
+				slotIndex = i;
+				break;
+			}
+		}
+		if (slotIndex < 0)
+		{
+			slotIndex = static_cast<int>(mSlots.size());
+			mSlots.push_back(PooledTargetSlot());
+		}
+
+		mSlots[slotIndex] = PooledTargetSlot();
+		mSlots[slotIndex].desc  = desc;
+		mSlots[slotIndex].alive = true;
+	}
+
+	PooledTargetSlot& slot = mSlots[slotIndex];
+	slot.usedThisFrame = true;
+	slot.busyUntil     = std::max(firstUse, lastUse);
+	slot.idleFrames    = 0;
+	return slotIndex;
+}
+
+
+void RenderTargetAllocator::EndFrame()
+{
+	// Statistics for this frame, the memory held before any targets are reclaimed
+	int64_t pooledBytes = PooledBytes();
+	mPeakBytes = std::max(mPeakBytes, pooledBytes);
+	mTotalBytes += pooledBytes;
+	++mNumFrames;
+	mLastFrameRequestedBytes = mFrameRequestedBytes;
+
+	for (auto& slot : mSlots)
+	{
+		if (!slot.alive || slot.usedThisFrame)  continue;
+
+		++slot.idleFrames;
+		if (slot.idleFrames > mMaxIdleFrames)  slot.alive = false;
+	}
+}
+
+
+void RenderTargetAllocator::Clear()
+{
+	mSlots.clear();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Data access
+//--------------------------------------------------------------------------------------
+
+int RenderTargetAllocator::NumAliveSlots() const
+{
+	int numAlive = 0;
+	for (auto& slot : mSlots)
+	{
+		if (slot.alive)  ++numAlive;
+	}
+	return numAlive;
+}
+
+int64_t RenderTargetAllocator::PooledBytes() const
+{
+	int64_t bytes = 0;
+	for (auto& slot : mSlots)
+	{
+		if (slot.alive)  bytes += slot.desc.Bytes();
+	}
+	return bytes;
+}
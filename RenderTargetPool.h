@@ -0,0 +1,130 @@
+//--------------------------------------------------------------------------------------
+// Pool of render targets shared between the images used in a frame
+//--------------------------------------------------------------------------------------
+// Textures are requested by size, format and binding for the range of passes that use them.
+// Requests that match and whose ranges don't overlap share a pooled target, so memory is only
+// needed for the images alive at the same time. Targets not used in a frame are reclaimed at
+// the end of it, so switching to a different chain of post-processes doesn't keep the textures
+// of the old chain around.
+//
+// RenderTargetAllocator only makes the decisions, it doesn't touch DirectX. Scene.cpp creates and
+// releases a texture for each slot of the allocator as they come and go
+
+#ifndef _RENDER_TARGET_POOL_H_INCLUDED_
+#define _RENDER_TARGET_POOL_H_INCLUDED_
+
+#include <cstdint>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Target description
+//--------------------------------------------------------------------------------------
+
+// Pixel formats a pooled target can have, Scene.cpp converts these to DXGI formats
+enum class TargetFormat
+{
+	RGBA8,   // 8-bit colour, the format of the scene texture
+	RGBA16F, // 16-bit float colour, for high dynamic range images
+	R32F,    // Single 32-bit float channel
+};
+
+// Bytes used by each pixel of the given format
+int BytesPerPixel(TargetFormat format);
+
+
+// Ways a pooled target can be used, combine with |
+const unsigned int TARGET_BIND_RENDER_TARGET    = 1;
+const unsigned int TARGET_BIND_SHADER_RESOURCE  = 2;
+const unsigned int TARGET_BIND_UNORDERED_ACCESS = 4;
+
+struct RenderTargetDesc
+{
+	int          width  = 0;
+	int          height = 0;
+	TargetFormat format = TargetFormat::RGBA8;
+	unsigned int bind   = TARGET_BIND_RENDER_TARGET | TARGET_BIND_SHADER_RESOURCE;
+
+	int64_t Bytes() const  { return static_cast<int64_t>(width) * height * BytesPerPixel(format); }
+
+	bool operator==(const RenderTargetDesc& other) const
+	{
+		return width == other.width && height == other.height && format == other.format && bind == other.bind;
+	}
+	bool operator!=(const RenderTargetDesc& other) const  { return !(*this == other); }
+};
+
+
+//--------------------------------------------------------------------------------------
+// Allocator
+//--------------------------------------------------------------------------------------
+
+// A target held by the pool. The slot number is what the allocator hands out
+struct PooledTargetSlot
+{
+	RenderTargetDesc desc;
+	bool alive         = false; // True if the slot holds a texture. False slots have been reclaimed and may be reused
+	bool usedThisFrame = false;
+	int  busyUntil     = -1;    // Last use in this frame of the image currently in the slot
+	int  idleFrames    = 0;     // Frames in a row the slot hasn't been used
+};
+
+class RenderTargetAllocator
+{
+public:
+	// Targets unused for more than the given number of frames are reclaimed. 0 reclaims them at the end of the first frame they aren't used
+	RenderTargetAllocator(int maxIdleFrames = 0) : mMaxIdleFrames(maxIdleFrames) {}
+
+	// Start allocating for a new frame, all slots become free
+	void BeginFrame();
+
+	// Return the slot of a target matching the given description for use from pass firstUse to pass lastUse (inclusive)
+	// Use -1 for firstUse if the image is written before the first pass. Requests must be made in order of firstUse.
+	// A target can be shared by images whose ranges don't overlap - an image can't be written by the pass that reads the previous one
+	int Allocate(const RenderTargetDesc& desc, int firstUse, int lastUse);
+
+	// Finish the frame - reclaim slots that have been idle for too long and update the statistics
+	void EndFrame();
+
+	// Forget all slots, e.g. when the viewport changes size. All textures should be released
+	void Clear();
+
+
+	//-------------------------------------
+	// Data access
+	//-------------------------------------
+
+	const std::vector<PooledTargetSlot>& Slots() const  { return mSlots; }
+
+	// Number of slots that hold a texture
+	int NumAliveSlots() const;
+
+	// Memory held by the pool now, i.e. the total of all alive slots
+	int64_t PooledBytes() const;
+
+	// Memory requested in the last complete frame, i.e. what would be needed without any sharing
+	int64_t RequestedBytes() const  { return mLastFrameRequestedBytes; }
+
+	// Largest and average memory held by the pool in each frame
+	int64_t PeakBytes() const     { return mPeakBytes; }
+	double  AverageBytes() const  { return mNumFrames > 0 ? static_cast<double>(mTotalBytes) / mNumFrames : 0.0; }
+	int     NumFrames() const     { return mNumFrames; }
+
+
+	//-------------------------------------
+	// Private members
+	//-------------------------------------
+private:
+	std::vector<PooledTargetSlot> mSlots;
+	int mMaxIdleFrames;
+
+	// Statistics
+	int64_t mFrameRequestedBytes     = 0;
+	int64_t mLastFrameRequestedBytes = 0;
+	int64_t mPeakBytes               = 0;
+	int64_t mTotalBytes              = 0; // Sum over frames, for the average
+	int     mNumFrames               = 0;
+};
+
+
+#endif //_RENDER_TARGET_POOL_H_INCLUDED_
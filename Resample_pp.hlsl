@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// Resample Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Copies the scene texture to a target of a different size with bilinear filtering. Halving the
+// size averages each 2x2 square of pixels, doubling it blends between the nearest four. Used to
+// run wide blurs on a smaller image (see GaussianKernel.h)
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SceneTexture : register(t0);
+SamplerState LinearSample : register(s1); // Bilinear filtering, clamped at the edges
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float3 outputColour = SceneTexture.Sample(LinearSample, input.sceneUV).rgb;
+	return float4(outputColour, 1.0f);
+}
@@ -1,5 +1,19 @@
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match RetroGameConstants in PostProcessConstants.h
+cbuffer RetroGameConstants : register(b2)
+{
+	float  gPixelSize;
+	int    gPaletteSize;
+	float  gDitherAmount; // Strength of the ordered dither added before picking a palette colour, 0 for none
+	float  paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures & Samplers
 //--------------------------------------------------------------------------------------
@@ -7,6 +21,10 @@
 Texture2D SceneTexture : register(t0);
 SamplerState PointSample : register(s0);
 
+// Index of the palette, for finding the nearest colour quickly - see PaletteIndex.h. The first PaletteGridSize^3 values
+// are where each cell's list of possible nearest colours starts. A list is its length followed by positions in the palette
+Buffer<uint> PaletteIndex : register(t1);
+
 //--------------------------------------------------------------------------------------
 // Global Variables
 //--------------------------------------------------------------------------------------
@@ -41,6 +59,9 @@ static const float3 gColourPalette[] =
     float3(0.1f, 0.7f, 0.9f) // Turquoise
 };
 
+// Cells along each side of the palette index, must match PALETTE_GRID_SIZE in PaletteIndex.h
+static const int PaletteGridSize = 32;
+
 //--------------------------------------------------------------------------------------
 // Shader Code
 //--------------------------------------------------------------------------------------
@@ -53,17 +74,33 @@ float4 main(PostProcessingInput input) : SV_Target
     // Sample the scene using a point sampler to preserve crisp edges
     float3 sampledColour = SceneTexture.Sample(PointSample, blockUV).rgb;
 
-    // Find the nearest colour in the palette
+    // Ordered dither, the same offset over each big pixel, so areas between two palette colours come out as a mix of both
+    sampledColour += OrderedDither(int2(floor(input.sceneUV * gPixelSize))) * gDitherAmount;
+
+    // Find the nearest colour in the palette. The index gives the few colours that could be nearest to colours in
+    // the same cell as this one, usually just one. Colours outside 0->1 (dithered past the edge) check the whole palette
+    uint first = 0;
+    uint count = gPaletteSize;
+    bool inRange = all(sampledColour >= 0.0f) && all(sampledColour <= 1.0f);
+    if (inRange)
+    {
+        int3 cell = min(int3(sampledColour * PaletteGridSize), PaletteGridSize - 1);
+        first = PaletteIndex[cell.x + PaletteGridSize * (cell.y + PaletteGridSize * cell.z)];
+        count = PaletteIndex[first];
+        first++;
+    }
+
     float minDistance = 1e9;
     float3 outputColour = float3(0.0f, 0.0f, 0.0f);
     
-    for (unsigned int i = 0; i < gPaletteSize; i++)
+    for (uint i = 0; i < count; i++)
     {
-        float distance = length(sampledColour - gColourPalette[i]);
+        float3 paletteColour = gColourPalette[inRange ? PaletteIndex[first + i] : i];
+        float distance = length(sampledColour - paletteColour);
         if (distance < minDistance)
         {
             minDistance = distance;
-            outputColour = gColourPalette[i];
+            outputColour = paletteColour;
         }
     }
 
@@ -11,6 +11,25 @@
 #include "Shader.h"
 #include "Input.h"
 #include "Common.h"
+#include "PostProcess.h"
+#include "RenderGraph.h"
+#include "PostProcessDevice.h"
+#include "PostProcessRegion.h"
+#include "PolygonBatch.h"
+#include "ColourTransform.h"
+#include "UVRemap.h"
+#include "CPUColourLUT.h"
+#include "CPUImage.h"        // For FloatToHalf
+#include "PaletteIndex.h"
+#include "GaussianKernel.h"
+#include "SlidingFilter.h"
+#include "ComputeTile.h"
+#include "Bloom.h"
+#include "LensStar.h"
+#include "DepthOfField.h"
+#include "TemporalHistory.h"
+#include "ConstantUpload.h"
+#include "InstanceBatch.h"
 
 #include "CVector2.h" 
 #include "CVector3.h" 
@@ -18,10 +37,12 @@
 #include "MathHelpers.h"     // Helper functions for maths
 #include "GraphicsHelpers.h" // Helper functions to unclutter the code here
 #include "ColourRGBA.h" 
+#include "Timer.h"
 
 #include <array>
 #include <sstream>
 #include <memory>
+#include <map>
 
 
 //--------------------------------------------------------------------------------------
@@ -29,53 +50,70 @@
 //--------------------------------------------------------------------------------------
 
 //********************
-// Available post-processes
-enum class PostProcess
-{
-	None,
-	Copy,
-	Tint,
-	GreyNoise,
-	Burn,
-	Distort,
-	Spiral,
-	HeatHaze,
-	VerticalGradient,
-	Underwater,
-	HueVerticalGradient,
-	GaussianBlurHorizontal,
-	GaussianBlurVertical,
-	MotionBlur,
-	RetroGame,
-	BrightPass,
-	LensStar,
-	Bloom,
-	DepthOfField,
-	Wireframe, 
-	Fog,
-	Invert,
-	NightVision,
-	GameBoy,
-	Sepia,
-	ChromaticDis,
-	Dilation,
-	OnePassBlur
-};
-
-enum class PostProcessMode
-{
-	Fullscreen,
-	Area,
-	Polygon,
-	WindowPolygon
-};
+// Available post-processes are listed in PostProcess.h
 
 PostProcess		gSelectedPostProcess		= PostProcess::None;
 PostProcessMode gSelectedPostProcessMode    = PostProcessMode::Fullscreen;
 PostProcess     gCurrentPostProcess			= PostProcess::None;
 PostProcessMode gCurrentPostProcessMode		= PostProcessMode::Fullscreen;
 
-std::vector<std::pair<PostProcess, PostProcessMode>> gActivePostProcesses;
+PostProcessChain gActivePostProcesses;
+
+// The passes, and the textures each pass reads and writes, are planned from the chain above (see RenderGraph.h)
+RenderGraph gPostProcessGraph;
+
+// Passes and draws issued for post-processing in the last frame, shown in the window title
+PostProcessStats gPostProcessStats;
+
+// Bytes of model constants passed for upload and the draws made by meshes in the last frame, also shown in the window title
+MeshConstantStatistics gLastFrameMeshConstants;
+MeshDrawStatistics     gLastFrameMeshDraws;
+
+// Render the depth of the scene on its own before the colour, so the lighting shaders only run for visible pixels. Press 'z' to toggle
+bool gDepthPrePass = false;
+
+// Run full screen tint, invert and sepia passes from colour LUTs baked from their settings (see CPUColourLUT.h). Press 'n' to toggle
+bool gUseColourLUTs = false;
+
+// Run full screen wireframes and Gaussian blurs with their compute shaders, which read each tile of the image into group shared
+// memory once, rather than their pixel shaders (see ComputeTile.h). Press Tab to toggle
+bool gUseComputeTiles = false;
+
+// Run full screen effects declared with a reducedResolutionDivisor on a smaller image, then add the change they made back on to
+// the full size scene (see RenderPassType::ReducedResolutionUpsample). Only the lens star (space) declares one. Press F6 to toggle
+bool gUseReducedResolution = false;
+
+// Spread the samples of effects declared with temporalFrames over several frames, blending each frame into the last frame's
+// result reprojected with the camera (see TemporalHistory.h). Press F7 to toggle
+bool gUseTemporalAccumulation = false;
+bool gHistoryValid = false; // The history texture holds the last frame of the current chain
+
+// Add an ordered dither to the retro game and Game Boy effects before their colours are snapped (see PaletteIndex.h). Press 'm' to toggle
+bool gPaletteDither = false;
+
+// Width of the Gaussian blur in pixels. Wide blurs are run on a smaller copy of the scene (see GaussianKernel.h). Press 'e' / 'q' to widen / narrow
+float gBlurSigma = 4.0f;
+
+// Radius of the dilation and box blur in pixels, 0 for the original filters (a 7x7 dilation and a 3x3 blur with its taps two
+// pixels apart). Full screen they cost the same at any radius (see SlidingFilter.h). Press '.' / ',' to grow / shrink
+int gFilterRadius = 0;
+
+
+// Box blur settings from gFilterRadius
+OnePassBlurConstants FilterBlurSettings()
+{
+	OnePassBlurConstants settings = {};
+	settings.blurRadius = (gFilterRadius > 0) ? gFilterRadius : 1;
+	settings.tapSpacing = (gFilterRadius > 0) ? 1 : 2;
+	return settings;
+}
+
+// Samples along each side of the bloom's lens star streaks. Its passes only grow in number every four times longer (see
+// LensStar.h). Press '+' / '-' to lengthen / shorten
+int gLensStarLength = 6;
+
+// Add the statistics of the last frame to the window title (see FormatFrameStats). Press F8 to toggle
+bool gShowStats = false;
 
 //********************
 
@@ -107,6 +145,25 @@ Model* gWall2;
 Camera* gCamera;
 
 
+// Stress test - a field of crates drawn either as a separate model each or all together with instancing
+// Press 'x' to cycle off / models / instanced and compare the draw calls and CPU time in the window title
+enum class StressMode
+{
+	Off,
+	Models,
+	Instanced
+};
+StressMode gStressMode = StressMode::Off;
+
+const int STRESS_CRATE_ROWS = 50; // Rows and columns, so 2500 crates
+
+std::vector<Model*>       gStressCrates;         // For the models stress mode
+std::vector<MeshInstance> gStressCrateInstances; // The same crates for the instanced stress mode
+
+float gStressRenderTime = 0; // CPU time spent submitting the stress crates this frame
+float gLastFrameStressRenderTime = 0;
+
+
 // Store lights in an array in this exercise
 const int NUM_LIGHTS = 2;
 struct Light
@@ -119,6 +176,9 @@ Light gLights[NUM_LIGHTS];
 
 const int NUM_WINDOWS = 5;
 
+// World matrix of the polygon used by polygon post-processes - rotates slowly (see UpdateScene)
+CMatrix4x4 gPolygonMatrix = MatrixTranslation({ 20.0f, 15.0f, 0.0f });
+
 // Additional light information
 CVector3 gAmbientColour = { 0.3f, 0.3f, 0.4f }; // Background level of light (slightly bluish to match the far background, which is dark blue)
 float    gSpecularPower = 256; // Specular power controls shininess - same for all models in this app
@@ -139,15 +199,71 @@ const float gLightOrbitSpeed = 0.7f;
 // IMPORTANT: Any new data you add in C++ code (CPU-side) is not automatically available to the GPU
 //            Anything the shaders need (per-frame or per-model) needs to be sent via a constant buffer
 
-PerFrameConstants gPerFrameConstants;      // The constants (settings) that need to be sent to the GPU each frame (see common.h for structure)
-ID3D11Buffer*     gPerFrameConstantBuffer; // The GPU buffer that will recieve the constants above
+// The constants are uploaded through gConstantUploader (see GraphicsHelpers.h), which only sends them if they have changed.
+// Each block of constants has a slot saying where it was last written in the GPU buffer
+PerFrameConstants gPerFrameConstants;     // The constants (settings) that need to be sent to the GPU each frame (see common.h for structure)
+ConstantSlot      gPerFrameConstantSlot;  // Where the constants above are on the GPU
 
-PerModelConstants gPerModelConstants;      // As above, but constants (settings) that change per-model (e.g. world matrix)
-ID3D11Buffer*     gPerModelConstantBuffer; // --"--
+PerModelConstants gPerModelConstants;     // As above, but constants (settings) that change per-model (e.g. world matrix)
+                                          // Each model keeps its own slots for these (see Model.h)
+
+PerSkeletonConstants gPerSkeletonConstants; // Bone matrices for skinned models, also with a slot in each model
 
 //**************************
-PostProcessingConstants gPostProcessingConstants;       // As above, but constants (settings) for each post-process
-ID3D11Buffer*           gPostProcessingConstantBuffer; // --"--
+PostProcessPassConstants   gPostProcessPassConstants;   // As above, but constants (settings) for each post-process pass
+PostProcessEffectConstants gPostProcessEffectConstants; // --"-- and the settings of each effect (see PostProcessConstants.h)
+ConstantSlot                        gPostProcessPassConstantSlot;    // Where the pass constants are on the GPU
+std::map<PostProcess, ConstantSlot> gPostProcessEffectConstantSlots; // One for each effect, so settings that don't change aren't sent again
+
+// Polygons for batched window polygon post-processing, sent to the GPU in a structured buffer (see PolygonBatch.h)
+PolygonBatch              gPolygonBatch;
+ID3D11Buffer*             gPolygonBatchBuffer = nullptr;
+ID3D11ShaderResourceView* gPolygonBatchSRV    = nullptr;
+
+// Where the constants of each colour transform pass are on the GPU (several colour effects run as one, see ColourTransform.h),
+// by the chain index of the pass's first effect. They aren't the settings of any one effect so have their own slots
+std::map<int, ConstantSlot> gColourTransformConstantSlots;
+
+// The same for each UV remap pass (several distortions run as one, see UVRemap.h)
+std::map<int, ConstantSlot> gUVRemapConstantSlots;
+
+// The colour LUT of each effect that has been run from one, in a 3D texture. Baked on the CPU, and again only when the effect's
+// settings change
+struct ColourLUTTexture
+{
+	ColourLUT                 lut;
+	ID3D11Texture3D*          texture = nullptr;
+	ID3D11ShaderResourceView* srv     = nullptr;
+};
+std::map<PostProcess, ColourLUTTexture> gColourLUTs;
+ConstantSlot                            gColourLUTConstantSlot;
+
+// Where the constants of the sliding window filter passes are on the GPU, one for the rows pass and one for the columns pass
+ConstantSlot gSlidingFilterConstantSlots[2];
+
+// Where the constants of the bloom's downsample passes are on the GPU, one for the first level and one for the levels after
+ConstantSlot gBloomDownsampleConstantSlots[2];
+
+// Where the constants of each pass of the lens star's streaks are on the GPU, by the streak, the pass and the side it reads
+std::map<int, ConstantSlot> gLensStarStreakConstantSlots;
+
+// Where the constants of the depth of field's gather passes are on the GPU, one for the far field and one for the near field
+ConstantSlot gDepthOfFieldGatherConstantSlots[2];
+
+// Where the constants of the temporal resolve pass are on the GPU
+ConstantSlot gTemporalResolveConstantSlot;
+
+// The index of the retro game palette for each palette size used (see PaletteIndex.h), in a buffer of integers
+struct PaletteIndexBuffer
+{
+	ID3D11Buffer*             buffer = nullptr;
+	ID3D11ShaderResourceView* srv    = nullptr;
+};
+std::map<int, PaletteIndexBuffer> gPaletteIndexBuffers;
+
+// Copies of meshes drawn with instancing, sent to the GPU in a structured buffer (see InstanceBatch.h)
+ID3D11Buffer*             gMeshInstanceBuffer = nullptr;
+ID3D11ShaderResourceView* gMeshInstanceSRV    = nullptr;
 //**************************
 
 
@@ -175,28 +291,38 @@ ID3D11ShaderResourceView* gLightDiffuseMapSRV = nullptr;
 //****************************
 // Post processing textures
 
-// This texture will have the scene renderered on it. Then the texture is then used for post-processing
-ID3D11Texture2D*          gSceneTexture      = nullptr; // This object represents the memory used by the texture on the GPU
-ID3D11RenderTargetView*   gSceneRenderTarget = nullptr; // This object is used when we want to render to the texture above
-ID3D11ShaderResourceView* gSceneTextureSRV   = nullptr; // This object is used to give shaders access to the texture above (SRV = shader resource view)
-
-// This texture will have the scene renderered on it. Then the texture is then used for post-processing
-ID3D11Texture2D*		  gSceneTextureTwo		= nullptr; // This object represents the memory used by the texture on the GPU
-ID3D11RenderTargetView*   gSceneRenderTargetTwo = nullptr; // This object is used when we want to render to the texture above
-ID3D11ShaderResourceView* gSceneTextureSRVTwo	= nullptr; // This object is used to give shaders access to the texture above (SRV = shader resource view)
-
-ID3D11Texture2D*		  gSceneTextureThree	 = nullptr;
-ID3D11RenderTargetView*   gSceneRenderTargetThree = nullptr;
-ID3D11ShaderResourceView* gSceneTextureSRVThree	 = nullptr;
+// Textures the scene is rendered to and the post-processes render between. They come from a pool (see RenderTargetPool.h),
+// the render graph asks the allocator below for a target for each image every frame and images whose lifetimes don't
+// overlap share a texture. Each slot of the allocator has a texture here, created and released as the slots come and go
+struct PooledTarget
+{
+	RenderTargetDesc          desc;                   // Description the texture was created with
+	ID3D11Texture2D*          texture      = nullptr; // This object represents the memory used by the texture on the GPU
+	ID3D11RenderTargetView*   renderTarget = nullptr; // This object is used when we want to render to the texture above
+	ID3D11ShaderResourceView* textureSRV   = nullptr; // This object is used to give shaders access to the texture above (SRV = shader resource view)
+	ID3D11UnorderedAccessView* unorderedAccess = nullptr; // Lets compute shaders write to the texture (UAV = unordered access view)
+};
+std::vector<PooledTarget> gPooledTargets;
+RenderTargetAllocator     gRenderTargetAllocator;
 
-ID3D11Texture2D*		  gFeedbackTexture = nullptr;
-ID3D11RenderTargetView*	  gFeedbackRTV	   = nullptr;
-ID3D11ShaderResourceView* gFeedbackSRV	   = nullptr;
+// Last frame's result of the effect spreading its samples over several frames, see TemporalHistory.h
+ID3D11Texture2D*		  gHistoryTexture = nullptr;
+ID3D11RenderTargetView*	  gHistoryRTV     = nullptr;
+ID3D11ShaderResourceView* gHistorySRV     = nullptr;
 
 ID3D11Texture2D*		  gSceneDepthTexture = nullptr;
 ID3D11DepthStencilView*   gSceneDepthDSV = nullptr;
+ID3D11DepthStencilView*   gSceneDepthReadOnlyDSV = nullptr; // Can be bound while post-processes read the depth through the SRV
 ID3D11ShaderResourceView* gSceneDepthSRV = nullptr;
 
+// How far each pixel of the scene moved since the last frame, written by the velocity pass for the motion blur (see MotionBlur.h)
+ID3D11Texture2D*		  gSceneVelocityTexture = nullptr;
+ID3D11RenderTargetView*   gSceneVelocityRTV = nullptr;
+ID3D11ShaderResourceView* gSceneVelocitySRV = nullptr;
+
+// Depth buffer bound during post-processing - the scene depth texture if the scene was rendered into it this frame
+ID3D11DepthStencilView*   gPostProcessDepthStencil = nullptr;
+
 // Additional textures used for specific post-processes
 ID3D11Resource*           gNoiseMap = nullptr;
 ID3D11ShaderResourceView* gNoiseMapSRV = nullptr;
@@ -205,11 +331,13 @@ ID3D11ShaderResourceView* gBurnMapSRV = nullptr;
 ID3D11Resource*           gDistortMap = nullptr;
 ID3D11ShaderResourceView* gDistortMapSRV = nullptr;
 
-ID3D11ShaderResourceView* gSourceSRV = nullptr;
+// Textures read by the current post-process in slots t0, t1... (t0 is the image being processed), and the target it writes to
+ID3D11ShaderResourceView* gPassInputSRVs[MAX_PASS_INPUTS] = {};
 ID3D11RenderTargetView*   gTargetRTV = nullptr;
+int                       gTargetSizeDivisor = 1; // The target's size is the viewport size divided by this, e.g. 2 for half size
 
-// Unbind the input texture after processing
-ID3D11ShaderResourceView* gNullSRV = nullptr;
+// Unbind the input textures after processing
+ID3D11ShaderResourceView* gNullSRVs[MAX_PASS_INPUTS] = {};
 
 //****************************
 
@@ -219,6 +347,71 @@ ID3D11ShaderResourceView* gNullSRV = nullptr;
 // Initialise scene geometry, constant buffers and states
 //--------------------------------------------------------------------------------------
 
+// DirectX format for a pooled target format
+DXGI_FORMAT PooledTargetFormat(TargetFormat format)
+{
+	if (format == TargetFormat::RGBA16F)  return DXGI_FORMAT_R16G16B16A16_FLOAT;
+	if (format == TargetFormat::R32F)     return DXGI_FORMAT_R32_FLOAT;
+	return DXGI_FORMAT_R8G8B8A8_UNORM;
+}
+
+void ReleasePooledTarget(PooledTarget& target)
+{
+	if (target.unorderedAccess)  target.unorderedAccess->Release();
+	if (target.textureSRV)    target.textureSRV->Release();
+	if (target.renderTarget)  target.renderTarget->Release();
+	if (target.texture)       target.texture->Release();
+	target = PooledTarget();
+}
+
+// Create a texture for each slot of the render target allocator that needs one, and release the textures of slots that have been reclaimed
+// Returns true on success
+bool UpdatePooledTargets()
+{
+	const std::vector<PooledTargetSlot>& slots = gRenderTargetAllocator.Slots();
+	if (gPooledTargets.size() < slots.size())  gPooledTargets.resize(slots.size());
+
+	for (unsigned int i = 0; i < gPooledTargets.size(); ++i)
+	{
+		PooledTarget& target = gPooledTargets[i];
+		bool needed = i < slots.size() && slots[i].alive;
+
+		// Release textures no longer needed, or that a reused slot needs in a different size or format
+		if (target.texture && (!needed || target.desc != slots[i].desc))  ReleasePooledTarget(target);
+		if (!needed || target.texture)  continue;
+
+		const RenderTargetDesc& desc = slots[i].desc;
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width = desc.width;
+		textureDesc.Height = desc.height;
+		textureDesc.MipLevels = 1; // No mip-maps when rendering to textures (or we would have to render every level)
+		textureDesc.ArraySize = 1;
+		textureDesc.Format = PooledTargetFormat(desc.format);
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.SampleDesc.Quality = 0;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags = 0;
+		if (desc.bind & TARGET_BIND_RENDER_TARGET)     textureDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+		if (desc.bind & TARGET_BIND_SHADER_RESOURCE)   textureDesc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+		if (desc.bind & TARGET_BIND_UNORDERED_ACCESS)  textureDesc.BindFlags |= D3D11_BIND_UNORDERED_ACCESS;
+		textureDesc.CPUAccessFlags = 0;
+		textureDesc.MiscFlags = 0;
+
+		target.desc = desc;
+		if (FAILED(gD3DDevice->CreateTexture2D(&textureDesc, NULL, &target.texture)) ||
+			((desc.bind & TARGET_BIND_RENDER_TARGET)   && FAILED(gD3DDevice->CreateRenderTargetView(target.texture, NULL, &target.renderTarget))) ||
+			((desc.bind & TARGET_BIND_SHADER_RESOURCE) && FAILED(gD3DDevice->CreateShaderResourceView(target.texture, NULL, &target.textureSRV))) ||
+			((desc.bind & TARGET_BIND_UNORDERED_ACCESS) && FAILED(gD3DDevice->CreateUnorderedAccessView(target.texture, NULL, &target.unorderedAccess))))
+		{
+			ReleasePooledTarget(target);
+			gLastError = "Error creating post-processing texture";
+			return false;
+		}
+	}
+	return true;
+}
+
+
 // Prepare the geometry required for the scene
 // Returns true on success
 bool InitGeometry()
@@ -281,121 +474,74 @@ bool InitGeometry()
 		return false;
 	}
 
-	// Create GPU-side constant buffers to receive the gPerFrameConstants and gPerModelConstants structures above
-	// These allow us to pass data from CPU to shaders such as lighting information or matrices
-	// See the comments above where these variable are declared and also the UpdateScene function
-	gPerFrameConstantBuffer       = CreateConstantBuffer(sizeof(gPerFrameConstants));
-	gPerModelConstantBuffer       = CreateConstantBuffer(sizeof(gPerModelConstants));
-	gPostProcessingConstantBuffer = CreateConstantBuffer(sizeof(gPostProcessingConstants));
-	if (gPerFrameConstantBuffer == nullptr || gPerModelConstantBuffer == nullptr || gPostProcessingConstantBuffer == nullptr)
+	// Create the GPU-side constant buffer to receive the gPerFrameConstants and gPerModelConstants structures above and the
+	// post-processing constants. This allows us to pass data from CPU to shaders such as lighting information or matrices
+	// All constants share one large buffer, see the comments above where these variable are declared and also the UpdateScene function
+	if (!CreateConstantUploadBuffer())
 	{
 		gLastError = "Error creating constant buffers";
 		return false;
 	}
 
-
-
-	//********************************************
-	//**** Create Scene Texture
-
-	// We will render the scene to this texture instead of the back-buffer (screen), then we post-process the texture onto the screen
-	// This is exactly the same code we used in the graphics module when we were rendering the scene onto a cube using a texture
-
-	// Using a helper function to load textures from files above. Here we create the scene texture manually
-	// as we are creating a special kind of texture (one that we can render to). Many settings to prepare:
-	D3D11_TEXTURE2D_DESC sceneTextureDesc = {};
-	sceneTextureDesc.Width = gViewportWidth;  // Full-screen post-processing - use full screen size for texture
-	sceneTextureDesc.Height = gViewportHeight;
-	sceneTextureDesc.MipLevels = 1; // No mip-maps when rendering to textures (or we would have to render every level)
-	sceneTextureDesc.ArraySize = 1;
-	sceneTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM; // RGBA texture (8-bits each)
-	sceneTextureDesc.SampleDesc.Count = 1;
-	sceneTextureDesc.SampleDesc.Quality = 0;
-	sceneTextureDesc.Usage = D3D11_USAGE_DEFAULT;
-	sceneTextureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE; // IMPORTANT: Indicate we will use texture as render target, and pass it to shaders
-	sceneTextureDesc.CPUAccessFlags = 0;
-	sceneTextureDesc.MiscFlags = 0;
-	if (FAILED(gD3DDevice->CreateTexture2D(&sceneTextureDesc, NULL, &gSceneTexture)))
-	{
-		gLastError = "Error creating scene texture";
-		return false;
-	}
-
-	if (FAILED(gD3DDevice->CreateTexture2D(&sceneTextureDesc, NULL, &gSceneTextureTwo)))
-	{
-		gLastError = "Error creating scene texture two";
-		return false;
-	}
-
-	if (FAILED(gD3DDevice->CreateTexture2D(&sceneTextureDesc, NULL, &gSceneTextureThree)))
+	gPolygonBatchBuffer = CreateStructuredBuffer(sizeof(PolygonInstance), MAX_BATCHED_POLYGONS, &gPolygonBatchSRV);
+	if (gPolygonBatchBuffer == nullptr)
 	{
-		gLastError = "Error creating scene texture copy";
+		gLastError = "Error creating polygon batch buffer";
 		return false;
 	}
 
-	// We created the scene texture above, now we get a "view" of it as a render target, i.e. get a special pointer to the texture that
-	// we use when rendering to it (see RenderScene function below)
-	if (FAILED(gD3DDevice->CreateRenderTargetView(gSceneTexture, NULL, &gSceneRenderTarget)))
+	gMeshInstanceBuffer = CreateStructuredBuffer(sizeof(MeshInstance), MAX_INSTANCES_PER_DRAW, &gMeshInstanceSRV);
+	if (gMeshInstanceBuffer == nullptr)
 	{
-		gLastError = "Error creating scene render target view";
+		gLastError = "Error creating mesh instance buffer";
 		return false;
 	}
 
-	if (FAILED(gD3DDevice->CreateRenderTargetView(gSceneTextureTwo, NULL, &gSceneRenderTargetTwo)))
-	{
-		gLastError = "Error creating scene render target view two";
-		return false;
-	}
 
-	if (FAILED(gD3DDevice->CreateRenderTargetView(gSceneTextureThree, NULL, &gSceneRenderTargetThree)))
-	{
-		gLastError = "Error creating scene render target view copy";
-		return false;
-	}
 
-	if (FAILED(gD3DDevice->CreateTexture2D(&sceneTextureDesc, NULL, &gFeedbackTexture)))
-	{
-		gLastError = "Error creating feedback texture";
+	//********************************************
+	//**** Create History Texture
+
+	// The scene texture and the textures the post-processes render between come from the render target pool (see RenderScene)
+	// The history image is kept from one frame to the next so it is not pooled - it is created here instead.
+	// We are creating a special kind of texture (one that we can render to). Many settings to prepare:
+	D3D11_TEXTURE2D_DESC historyTextureDesc = {};
+	historyTextureDesc.Width = gViewportWidth;  // Full-screen post-processing - use full screen size for texture
+	historyTextureDesc.Height = gViewportHeight;
+	historyTextureDesc.MipLevels = 1; // No mip-maps when rendering to textures (or we would have to render every level)
+	historyTextureDesc.ArraySize = 1;
+	historyTextureDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT; // 16-bit float so small changes blended in each frame aren't lost, view space depth in alpha
+	historyTextureDesc.SampleDesc.Count = 1;
+	historyTextureDesc.SampleDesc.Quality = 0;
+	historyTextureDesc.Usage = D3D11_USAGE_DEFAULT;
+	historyTextureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE; // IMPORTANT: Indicate we will use texture as render target, and pass it to shaders
+	historyTextureDesc.CPUAccessFlags = 0;
+	historyTextureDesc.MiscFlags = 0;
+	if (FAILED(gD3DDevice->CreateTexture2D(&historyTextureDesc, NULL, &gHistoryTexture)))
+	{
+		gLastError = "Error creating history texture";
 		return false;
 	}
 
-	if (FAILED(gD3DDevice->CreateRenderTargetView(gFeedbackTexture, NULL, &gFeedbackRTV)))
+	if (FAILED(gD3DDevice->CreateRenderTargetView(gHistoryTexture, NULL, &gHistoryRTV)))
 	{
-		gLastError = "Error creating feedback RTV";
+		gLastError = "Error creating history RTV";
 		return false;
 	}
 
 	// We also need to send this texture (resource) to the shaders. To do that we must create a shader-resource "view"
 	D3D11_SHADER_RESOURCE_VIEW_DESC srDesc = {};
-	srDesc.Format = sceneTextureDesc.Format;
+	srDesc.Format = historyTextureDesc.Format;
 	srDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 	srDesc.Texture2D.MostDetailedMip = 0;
 	srDesc.Texture2D.MipLevels = 1;
-	if (FAILED(gD3DDevice->CreateShaderResourceView(gSceneTexture, &srDesc, &gSceneTextureSRV)))
-	{
-		gLastError = "Error creating scene shader resource view";
-		return false;
-	}
-
-	if (FAILED(gD3DDevice->CreateShaderResourceView(gSceneTextureTwo, &srDesc, &gSceneTextureSRVTwo)))
-	{
-		gLastError = "Error creating scene shader resource view two";
-		return false;
-	}
-
-	if (FAILED(gD3DDevice->CreateShaderResourceView(gSceneTextureThree, &srDesc, &gSceneTextureSRVThree)))
-	{
-		gLastError = "Error creating scene shader resource view copy";
-		return false;
-	}
-
-	if (FAILED(gD3DDevice->CreateShaderResourceView(gFeedbackTexture, &srDesc, &gFeedbackSRV)))
+	if (FAILED(gD3DDevice->CreateShaderResourceView(gHistoryTexture, &srDesc, &gHistorySRV)))
 	{
-		gLastError = "Error creating feedback SRV";
+		gLastError = "Error creating history SRV";
 		return false;
 	}
 
-	// In InitGeometry, after creating gSceneTexture
+	// Depth of the main scene, for the post-processes that read it
 	D3D11_TEXTURE2D_DESC depthTextureDesc = {};
 	depthTextureDesc.Width = gViewportWidth;
 	depthTextureDesc.Height = gViewportHeight;
@@ -427,6 +573,14 @@ bool InitGeometry()
 		return false;
 	}
 
+	// Read-only view of the same depth, a texture can't be read by a shader and bound as a writable depth buffer at the same time
+	dsvDesc.Flags = D3D11_DSV_READ_ONLY_DEPTH;
+	if (FAILED(gD3DDevice->CreateDepthStencilView(gSceneDepthTexture, &dsvDesc, &gSceneDepthReadOnlyDSV)))
+	{
+		gLastError = "Error creating scene read-only depth stencil view";
+		return false;
+	}
+
 	// Create Shader Resource View (SRV) for shader access
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = DXGI_FORMAT_R32_FLOAT; // Shader-readable depth format
@@ -440,6 +594,24 @@ bool InitGeometry()
 		return false;
 	}
 
+	// Velocity of the main scene, for the motion blur. Signed, so a float format
+	D3D11_TEXTURE2D_DESC velocityTextureDesc = historyTextureDesc;
+	if (FAILED(gD3DDevice->CreateTexture2D(&velocityTextureDesc, NULL, &gSceneVelocityTexture)))
+	{
+		gLastError = "Error creating scene velocity texture";
+		return false;
+	}
+	if (FAILED(gD3DDevice->CreateRenderTargetView(gSceneVelocityTexture, NULL, &gSceneVelocityRTV)))
+	{
+		gLastError = "Error creating scene velocity RTV";
+		return false;
+	}
+	if (FAILED(gD3DDevice->CreateShaderResourceView(gSceneVelocityTexture, NULL, &gSceneVelocitySRV)))
+	{
+		gLastError = "Error creating scene velocity SRV";
+		return false;
+	}
+
 	return true;
 }
 
@@ -465,14 +637,6 @@ void RemovePostProcessEffect()
 			gActivePostProcesses.pop_back();
 		}
 	}
-	else if (gActivePostProcesses.back().first == PostProcess::Bloom)
-	{
-		// Remove bloom
-		for (unsigned int i = 0; i < 5; i++)
-		{
-			gActivePostProcesses.pop_back();
-		}
-	}
 	else
 	{
 		// Otherwise, just remove the last effect.
@@ -578,6 +742,28 @@ bool InitScene()
 
 	InitPolygonEffects();
 
+
+	////--------------- Set up stress test ---------------////
+
+	// A grid of crates beyond the far wall, each one turned a little more than the last
+	for (int row = 0; row < STRESS_CRATE_ROWS; ++row)
+	{
+		for (int column = 0; column < STRESS_CRATE_ROWS; ++column)
+		{
+			Model* crate = new Model(gCrateMesh);
+			crate->SetPosition({ -300.0f + column * 12.0f, 0.0f, 150.0f + row * 12.0f });
+			crate->SetRotation({ 0.0f, ToRadians((row * STRESS_CRATE_ROWS + column) * 7.0f), 0.0f });
+			crate->SetScale(1.5f);
+			gStressCrates.push_back(crate);
+
+			MeshInstance instance;
+			instance.worldMatrix = crate->WorldMatrix();
+			instance.tint        = { 1, 1, 1 }; // Untinted to look the same as the models stress mode
+			instance.padding     = 0;
+			gStressCrateInstances.push_back(instance);
+		}
+	}
+
 	return true;
 }
 
@@ -587,26 +773,26 @@ void ReleaseResources()
 {
 	ReleaseStates();
 
-	if (gSceneTextureSRV)              gSceneTextureSRV->Release();
-	if (gSceneRenderTarget)            gSceneRenderTarget->Release();
-	if (gSceneTexture)                 gSceneTexture->Release();
-
-	if (gSceneTextureSRVTwo)              gSceneTextureSRVTwo->Release();
-	if (gSceneRenderTargetTwo)            gSceneRenderTargetTwo->Release();
-	if (gSceneTextureTwo)                 gSceneTextureTwo->Release();
-
-	if (gSceneTextureSRVThree)              gSceneTextureSRVThree->Release();
-	if (gSceneRenderTargetThree)            gSceneRenderTargetThree->Release();
-	if (gSceneTextureThree)                 gSceneTextureThree->Release();
+	for (auto& target : gPooledTargets)
+	{
+		ReleasePooledTarget(target);
+	}
+	gPooledTargets.clear();
+	gRenderTargetAllocator.Clear();
 
-	if (gFeedbackSRV)            gFeedbackSRV->Release();
-	if (gFeedbackRTV)            gFeedbackRTV->Release();
-	if (gFeedbackTexture)        gFeedbackTexture->Release();
+	if (gHistorySRV)            gHistorySRV->Release();
+	if (gHistoryRTV)            gHistoryRTV->Release();
+	if (gHistoryTexture)        gHistoryTexture->Release();
 
 	if (gSceneDepthSRV)			gSceneDepthSRV->Release();
+	if (gSceneDepthReadOnlyDSV)	gSceneDepthReadOnlyDSV->Release();
 	if (gSceneDepthDSV)			gSceneDepthDSV->Release();
 	if (gSceneDepthTexture)		gSceneDepthTexture->Release();
 
+	if (gSceneVelocitySRV)		gSceneVelocitySRV->Release();
+	if (gSceneVelocityRTV)		gSceneVelocityRTV->Release();
+	if (gSceneVelocityTexture)	gSceneVelocityTexture->Release();
+
 	if (gDistortMapSRV)                gDistortMapSRV->Release();
 	if (gDistortMap)                   gDistortMap->Release();
 	if (gBurnMapSRV)                   gBurnMapSRV->Release();
@@ -627,9 +813,25 @@ void ReleaseResources()
 	if (gStarsDiffuseSpecularMapSRV)   gStarsDiffuseSpecularMapSRV->Release();
 	if (gStarsDiffuseSpecularMap)      gStarsDiffuseSpecularMap->Release();
 
-	if (gPostProcessingConstantBuffer)  gPostProcessingConstantBuffer->Release();
-	if (gPerModelConstantBuffer)        gPerModelConstantBuffer->Release();
-	if (gPerFrameConstantBuffer)        gPerFrameConstantBuffer->Release();
+	for (auto& colourLUT : gColourLUTs)
+	{
+		if (colourLUT.second.srv)      colourLUT.second.srv->Release();
+		if (colourLUT.second.texture)  colourLUT.second.texture->Release();
+	}
+	gColourLUTs.clear();
+
+	for (auto& paletteIndex : gPaletteIndexBuffers)
+	{
+		if (paletteIndex.second.srv)     paletteIndex.second.srv->Release();
+		if (paletteIndex.second.buffer)  paletteIndex.second.buffer->Release();
+	}
+	gPaletteIndexBuffers.clear();
+
+	if (gMeshInstanceSRV)               gMeshInstanceSRV->Release();
+	if (gMeshInstanceBuffer)            gMeshInstanceBuffer->Release();
+	if (gPolygonBatchSRV)               gPolygonBatchSRV->Release();
+	if (gPolygonBatchBuffer)            gPolygonBatchBuffer->Release();
+	ReleaseConstantUploadBuffer();
 
 	ReleaseShaders();
 
@@ -645,6 +847,11 @@ void ReleaseResources()
 	delete gStars;   gStars = nullptr;
 	delete gWall;   gWall = nullptr;
 	delete gWall2;   gWall2 = nullptr;
+	for (auto& crate : gStressCrates)
+	{
+		delete crate;
+	}
+	gStressCrates.clear();
 
 	delete gLightMesh;   gLightMesh = nullptr;
 	delete gCrateMesh;   gCrateMesh = nullptr;
@@ -661,34 +868,79 @@ void ReleaseResources()
 // Scene Rendering
 //--------------------------------------------------------------------------------------
 
-// Render everything in the scene from the given camera
-void RenderSceneFromCamera(Camera* camera)
+// Render the stress test crates, either one model at a time or all at once with instancing. The shaders and states for
+// ordinary models must already be set, they are restored afterwards. In the velocity pass those are the velocity shaders
+void RenderStressCrates(ID3D11VertexShader* litVertexShader, ID3D11PixelShader* litPixelShader, bool velocity)
+{
+	if (gStressMode == StressMode::Off)  return;
+
+	Timer stressTimer;
+	gD3DContext->PSSetShaderResources(0, 1, &gCrateDiffuseSpecularMapSRV);
+	if (gStressMode == StressMode::Models)
+	{
+		for (auto& crate : gStressCrates)
+		{
+			crate->Render();
+		}
+	}
+	else
+	{
+		// A depth-only pass has no pixel shader, the velocity pass uses the same pixel shader as for ordinary models (see
+		// RenderSceneFromCamera)
+		ID3D11PixelShader* instancedPixelShader = (litPixelShader && !velocity) ? gPixelLightingInstancedPixelShader : litPixelShader;
+		gD3DContext->VSSetShader(velocity ? gVelocityInstancedVertexShader : gPixelLightingInstancedVertexShader, nullptr, 0);
+		gD3DContext->PSSetShader(instancedPixelShader, nullptr, 0);
+		gCrateMesh->RenderInstanced(gStressCrateInstances);
+		gD3DContext->VSSetShader(litVertexShader, nullptr, 0);
+		gD3DContext->PSSetShader(litPixelShader, nullptr, 0);
+	}
+	gStressRenderTime += stressTimer.GetTime();
+}
+
+
+// Render everything in the scene from the given camera. The scene pass says whether to render depth only (for a
+// depth pre-pass), colour - testing against depth from a pre-pass if there was one, or velocity (see RenderGraph.h)
+void RenderSceneFromCamera(Camera* camera, const ScenePass& scenePass)
 {
 	// Set camera matrices in the constant buffer and send over to GPU
 	gPerFrameConstants.cameraMatrix = camera->WorldMatrix();
 	gPerFrameConstants.viewMatrix = camera->ViewMatrix();
 	gPerFrameConstants.projectionMatrix = camera->ProjectionMatrix();
 	gPerFrameConstants.viewProjectionMatrix = camera->ViewProjectionMatrix();
-	UpdateConstantBuffer(gPerFrameConstantBuffer, gPerFrameConstants);
+	gPerFrameConstants.previousViewProjectionMatrix = camera->PreviousViewProjectionMatrix();
+	UploadConstants(gPerFrameConstantSlot, gPerFrameConstants);
 
-	// Indicate that the constant buffer we just updated is for use in the vertex shader (VS), geometry shader (GS) and pixel shader (PS)
-	gD3DContext->VSSetConstantBuffers(0, 1, &gPerFrameConstantBuffer); // First parameter must match constant buffer number in the shader 
-	gD3DContext->GSSetConstantBuffers(0, 1, &gPerFrameConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(0, 1, &gPerFrameConstantBuffer);
+	// Indicate that the constants we just uploaded are for use in the vertex shader (VS), geometry shader (GS) and pixel shader (PS)
+	BindConstants(gPerFrameConstantSlot, 0, SHADER_STAGE_VERTEX | SHADER_STAGE_GEOMETRY | SHADER_STAGE_PIXEL); // Number must match constant buffer number in the shader
 
 	gD3DContext->PSSetShader(gPixelLightingPixelShader, nullptr, 0);
 
+	// A depth-only pass has no pixel shader, so only the vertex shaders and the depth test do any work. The velocity pass draws
+	// everything with the velocity shaders, which only find where each pixel was last frame
+	ID3D11VertexShader* litVertexShader      = scenePass.velocity ? gVelocityVertexShader : gPixelLightingVertexShader;
+	ID3D11VertexShader* texturedVertexShader = scenePass.velocity ? gVelocityVertexShader : gBasicTransformVertexShader;
+	ID3D11PixelShader*  litPixelShader       = scenePass.velocity ? gVelocityPixelShader  : gPixelLightingPixelShader;
+	ID3D11PixelShader*  texturedPixelShader  = scenePass.velocity ? gVelocityPixelShader  : gTintedTexturePixelShader;
+	if (scenePass.depthOnly)
+	{
+		litPixelShader      = nullptr;
+		texturedPixelShader = nullptr;
+	}
+
+	// After a depth pre-pass the depth buffer is already complete, only draw the pixels that match it
+	ID3D11DepthStencilState* opaqueDepthState = scenePass.depthAlreadyWritten ? gDepthPrePassTestState : gUseDepthBufferState;
+
 
 	////--------------- Render ordinary models ---------------///
 
 	// Select which shaders to use next
-	gD3DContext->VSSetShader(gPixelLightingVertexShader, nullptr, 0);
-	gD3DContext->PSSetShader(gPixelLightingPixelShader, nullptr, 0);
+	gD3DContext->VSSetShader(litVertexShader, nullptr, 0);
+	gD3DContext->PSSetShader(litPixelShader, nullptr, 0);
 	gD3DContext->GSSetShader(nullptr, nullptr, 0);  // Switch off geometry shader when not using it (pass nullptr for first parameter)
 
 	// States - no blending, normal depth buffer and back-face culling (standard set-up for opaque models)
 	gD3DContext->OMSetBlendState(gNoBlendingState, nullptr, 0xffffff);
-	gD3DContext->OMSetDepthStencilState(gUseDepthBufferState, 0);
+	gD3DContext->OMSetDepthStencilState(opaqueDepthState, 0);
 	gD3DContext->RSSetState(gCullBackState);
 
 	// Render lit models, only change textures for each onee
@@ -700,6 +952,8 @@ void RenderSceneFromCamera(Camera* camera)
 	gD3DContext->PSSetShaderResources(0, 1, &gCrateDiffuseSpecularMapSRV); // First parameter must match texture slot number in the shader
 	gCrate->Render();
 
+	RenderStressCrates(litVertexShader, litPixelShader, scenePass.velocity);
+
 	gD3DContext->PSSetShaderResources(0, 1, &gCubeDiffuseSpecularMapSRV); // First parameter must match texture slot number in the shader
 	gCube->Render();
 
@@ -712,8 +966,8 @@ void RenderSceneFromCamera(Camera* camera)
 	////--------------- Render sky ---------------////
 
 	// Select which shaders to use next
-	gD3DContext->VSSetShader(gBasicTransformVertexShader, nullptr, 0);
-	gD3DContext->PSSetShader(gTintedTexturePixelShader, nullptr, 0);
+	gD3DContext->VSSetShader(texturedVertexShader, nullptr, 0);
+	gD3DContext->PSSetShader(texturedPixelShader, nullptr, 0);
 
 	// Using a pixel shader that tints the texture - don't need a tint on the sky so set it to white
 	gPerModelConstants.objectColour = { 1, 1, 1 };
@@ -725,6 +979,10 @@ void RenderSceneFromCamera(Camera* camera)
 	gD3DContext->PSSetShaderResources(0, 1, &gStarsDiffuseSpecularMapSRV);
 	gStars->Render();
 
+	// Lights are blended and don't write depth, so they have nothing to add to a depth-only pass. They don't hide what is behind
+	// them either, so the velocity of the pixels they cover is left as that of the models behind
+	if (scenePass.depthOnly || scenePass.velocity)  return;
+
 
 
 	////--------------- Render lights ---------------////
@@ -783,10 +1041,41 @@ CVector3 HSLToRGB(float h, float s, float l) {
 
 //**************************
 
+// The index of the retro game palette with the given number of colours, for RetroGame_pp.hlsl. Built and sent to the GPU the
+// first time each size is used. Returns nullptr if the buffer couldn't be created, which the shader reads as an empty index
+ID3D11ShaderResourceView* PaletteIndexSRV(int paletteSize)
+{
+	PaletteIndexBuffer& paletteIndex = gPaletteIndexBuffers[paletteSize];
+	if (paletteIndex.srv)  return paletteIndex.srv;
+
+	const std::vector<uint32_t>& data = RetroGamePaletteIndex(paletteSize).Data();
+
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth = static_cast<UINT>(data.size() * sizeof(uint32_t));
+	bufferDesc.Usage     = D3D11_USAGE_IMMUTABLE; // Never changes once made
+	bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	D3D11_SUBRESOURCE_DATA initialData = {};
+	initialData.pSysMem = data.data();
+	if (FAILED(gD3DDevice->CreateBuffer(&bufferDesc, &initialData, &paletteIndex.buffer)))  return nullptr;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format              = DXGI_FORMAT_R32_UINT;
+	srvDesc.ViewDimension       = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements  = static_cast<UINT>(data.size());
+	if (FAILED(gD3DDevice->CreateShaderResourceView(paletteIndex.buffer, &srvDesc, &paletteIndex.srv)))  return nullptr;
+	return paletteIndex.srv;
+}
+
+
 // Select the appropriate shader plus any additional textures required for a given post-process
 // Helper function shared by full-screen, area and polygon post-processing functions below
-void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime)
+// Images produced by the chain (scene depth, history, bloom images) are bound from the render graph, not here
+// Returns the effect's settings, ready to send to the GPU along with the pass constants (see PostProcessConstants.h)
+ConstantBlock SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime)
 {
+	PostProcessEffectConstants& constants = gPostProcessEffectConstants;
+
 	if (postProcess == PostProcess::Copy)
 	{
 		gD3DContext->PSSetShader(gCopyPostProcess, nullptr, 0);
@@ -797,8 +1086,9 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 		gD3DContext->PSSetShader(gVerticalGradientPostProcess, nullptr, 0);
 
 		// Top and bottom colours of the gradient
-		gPostProcessingConstants.topColour = CVector3(0.0f, 0.0f, 1.0f); // Blue at the top.
-		gPostProcessingConstants.bottomColour = CVector3(1.0f, 1.0f, 0.0f); // Yellow at the bottom.
+		constants.verticalGradient.topColour = CVector3(0.0f, 0.0f, 1.0f); // Blue at the top.
+		constants.verticalGradient.bottomColour = CVector3(1.0f, 1.0f, 0.0f); // Yellow at the bottom.
+		return MakeConstantBlock(constants.verticalGradient);
 	}
 
 	else if (postProcess == PostProcess::GaussianBlurHorizontal || postProcess == PostProcess::GaussianBlurVertical)
@@ -808,37 +1098,39 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 		else
 			gD3DContext->PSSetShader(gGaussianVerticalBlurPostProcess, nullptr, 0);
 
-		// Texel size based on render target resolution
-		gPostProcessingConstants.texelSize = {
-			2.0f / static_cast<float>(gViewportWidth),
-			2.0f / static_cast<float>(gViewportHeight)
-		};
-		gPostProcessingConstants.blurStrength = 2.0f;
+		// The taps depend on the size of the image being blurred as well as the width of the blur - wide blurs are run
+		// on a smaller image. Taps after the centre read between two pixels, so need bilinear filtering
+		constants.gaussianBlur.blurSigma = gBlurSigma;
+		SetGaussianBlurKernel(constants.gaussianBlur, gTargetSizeDivisor);
+		gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+		return MakeConstantBlock(constants.gaussianBlur);
 	}
 
 	else if (postProcess == PostProcess::Underwater)
 	{
 		gD3DContext->PSSetShader(gUnderwaterPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.frequency = 2.0f;
-		gPostProcessingConstants.amplitude = 0.005f;
+		constants.underwater.frequency = 2.0f;
+		constants.underwater.amplitude = 0.005f;
+		return MakeConstantBlock(constants.underwater);
 	}
 
 	else if (postProcess == PostProcess::DepthOfField)
 	{
 		gD3DContext->PSSetShader(gDepthOfFieldPostProcess, nullptr, 0);
 
-		// Bind the depth texture to slot t1
-		gD3DContext->PSSetShaderResources(1, 1, &gSceneDepthSRV);
+		// The near and far fields are half size, so are read with bilinear filtering
+		gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
 
 		// DoF parameters
-		if (!gPostProcessingConstants.focalDistance) gPostProcessingConstants.focalDistance = 40.0f; // Focal distance
-		gPostProcessingConstants.aperture = 5.0f; // Aperture
-		gPostProcessingConstants.nearClip = gCamera->NearClip(); // Sync with camera
-		gPostProcessingConstants.farClip = gCamera->FarClip(); // Sync with camera
+		if (!constants.depthOfField.focalDistance) constants.depthOfField.focalDistance = 40.0f; // Focal distance
+		constants.depthOfField.aperture = 5.0f; // Aperture
+		constants.depthOfField.nearClip = gCamera->NearClip(); // Sync with camera
+		constants.depthOfField.farClip = gCamera->FarClip(); // Sync with camera
 
-		if (KeyHit(Key_F4)) gPostProcessingConstants.focalDistance += 2.0f;
-		if (KeyHit(Key_F5)) gPostProcessingConstants.focalDistance -= 2.0f;
+		if (KeyHit(Key_F4)) constants.depthOfField.focalDistance += 2.0f;
+		if (KeyHit(Key_F5)) constants.depthOfField.focalDistance -= 2.0f;
+		return MakeConstantBlock(constants.depthOfField);
 	}
 
 	else if (postProcess == PostProcess::HueVerticalGradient)
@@ -851,64 +1143,70 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 		if (hue > 360.0f) hue = 0.0f;
 
 		// Top and bottom colours of the gradient
-		gPostProcessingConstants.topColour = HSLToRGB(hue, 1.0f, 0.5f);
-		gPostProcessingConstants.bottomColour = HSLToRGB(hue + 180.0f, 1.0f, 0.5f);
+		constants.verticalGradient.topColour = HSLToRGB(hue, 1.0f, 0.5f);
+		constants.verticalGradient.bottomColour = HSLToRGB(hue + 180.0f, 1.0f, 0.5f);
+		return MakeConstantBlock(constants.verticalGradient);
 	}
 
 	else if (postProcess == PostProcess::MotionBlur)
 	{
 		gD3DContext->PSSetShader(gMotionBlurPostProcess, nullptr, 0);
-		gD3DContext->PSSetShaderResources(1, 1, &gFeedbackSRV);
-		
-		gPostProcessingConstants.blendFactor = 0.8f;
+
+		// Blur each pixel along half of its movement since the last frame (a 180 degree shutter)
+		constants.motionBlur.shutter = 0.5f;
+		return MakeConstantBlock(constants.motionBlur);
 	}
 
 	else if (postProcess == PostProcess::RetroGame)
 	{
 		gD3DContext->PSSetShader(gRetroGamePostProcess, nullptr, 0);
 
-		gPostProcessingConstants.pixelSize = 150.0f;
-		if (!gPostProcessingConstants.paletteSize) gPostProcessingConstants.paletteSize = Random(8, 25);
+		constants.retroGame.pixelSize = 150.0f;
+		if (!constants.retroGame.paletteSize) constants.retroGame.paletteSize = Random(8, 25);
+		constants.retroGame.ditherAmount = gPaletteDither ? 0.2f : 0.0f; // A fifth of the colour range spread over the pattern
+
+		ID3D11ShaderResourceView* paletteIndexSRV = PaletteIndexSRV(constants.retroGame.paletteSize);
+		gD3DContext->PSSetShaderResources(1, 1, &paletteIndexSRV);
+		return MakeConstantBlock(constants.retroGame);
 	}
 
 	else if (postProcess == PostProcess::BrightPass)
 	{
 		gD3DContext->PSSetShader(gBrightPassPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.bloomThreshold = 0.6f; // Base threshold for bloom
-		gPostProcessingConstants.exposure = 1.0f; // Exposure adjustment
-		gPostProcessingConstants.bloomKnee = 0.1f; // Soft transition width
+		constants.brightPass.bloomThreshold = 0.6f; // Base threshold for bloom
+		constants.brightPass.exposure = 1.0f; // Exposure adjustment
+		constants.brightPass.bloomKnee = 0.1f; // Soft transition width
+		return MakeConstantBlock(constants.brightPass);
 	}
 
 	else if (postProcess == PostProcess::LensStar)
 	{
 		gD3DContext->PSSetShader(gLensStarPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.texelSize = {
-			2.0f / static_cast<float>(gViewportWidth),
-			2.0f / static_cast<float>(gViewportHeight)
-		};
-		gPostProcessingConstants.stepSize = 0.007f;
-		gPostProcessingConstants.attenuation = 0.8f;
+		constants.lensStar.stepSize = 0.007f;
+		constants.lensStar.attenuation = 0.8f;
+		constants.lensStar.streakLength = gLensStarLength;
+		return MakeConstantBlock(constants.lensStar);
 	}
 
 	else if (postProcess == PostProcess::Bloom)
 	{
 		gD3DContext->PSSetShader(gBloomPostProcess, nullptr, 0);
 
-		// Bind the blurred bright-pass textures to slots t1 and t2.
-		ID3D11ShaderResourceView* textures[3] = { gSceneTextureSRVThree, gSceneTextureSRV, gSceneTextureSRVTwo };
-		gD3DContext->PSSetShaderResources(0, 3, textures);
-
-		gPostProcessingConstants.bloomIntensity = 9.0f;
-		gPostProcessingConstants.starIntensity = 2.5f;
+		// The glow and star are smaller than the target, so are read with bilinear filtering
+		gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+		constants.bloom.bloomIntensity = 0.4f; // The glow is the sum of all the bloom levels
+		constants.bloom.starIntensity = 9.0f;
+		return MakeConstantBlock(constants.bloom);
 	}
 
 	else if (postProcess == PostProcess::Tint)
 	{
 		gD3DContext->PSSetShader(gTintPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.tintColour = CVector3(1.0f, 0.0f, 0.0f); // Colour for tint shader
+		constants.tint.tintColour = CVector3(1.0f, 0.0f, 0.0f); // Colour for tint shader
+		return MakeConstantBlock(constants.tint);
 	}
 
 	else if (postProcess == PostProcess::GreyNoise)
@@ -921,10 +1219,11 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 
 		// Noise scaling adjusts how fine the grey noise is.
 		const float grainSize = 140.0f; // Fineness of the noise grain
-		gPostProcessingConstants.noiseScale = { gViewportWidth / grainSize, gViewportHeight / grainSize };
+		constants.greyNoise.noiseScale = { gViewportWidth / grainSize, gViewportHeight / grainSize };
 
 		// The noise offset is randomised to give a constantly changing noise effect (like tv static)
-		gPostProcessingConstants.noiseOffset = { Random(0.0f, 1.0f), Random(0.0f, 1.0f) };
+		constants.greyNoise.noiseOffset = { Random(0.0f, 1.0f), Random(0.0f, 1.0f) };
+		return MakeConstantBlock(constants.greyNoise);
 	}
 
 	else if (postProcess == PostProcess::Burn)
@@ -937,7 +1236,8 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 
 		// Set and increase the burn level (cycling back to 0 when it reaches 1.0f)
 		const float burnSpeed = 0.2f;
-		gPostProcessingConstants.burnHeight = fmod(gPostProcessingConstants.burnHeight + burnSpeed * frameTime, 1.0f);
+		constants.burn.burnHeight = fmod(constants.burn.burnHeight + burnSpeed * frameTime, 1.0f);
+		return MakeConstantBlock(constants.burn);
 	}
 
 	else if (postProcess == PostProcess::Distort)
@@ -949,7 +1249,8 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 		gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
 
 		// Set the level of distortion
-		gPostProcessingConstants.distortLevel = 0.03f;
+		constants.distort.distortLevel = 0.03f;
+		return MakeConstantBlock(constants.distort);
 	}
 
 	else if (postProcess == PostProcess::Spiral)
@@ -959,8 +1260,9 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 		// Set and increase the amount of spiral - use a tweaked cos wave to animate
 		static float wiggle = 0.0f;
 		const float wiggleSpeed = 1.0f;
-		gPostProcessingConstants.spiralLevel = ((1.0f - cos(wiggle)) * 4.0f);
+		constants.spiral.spiralLevel = ((1.0f - cos(wiggle)) * 4.0f);
 		wiggle += wiggleSpeed * frameTime;
+		return MakeConstantBlock(constants.spiral);
 	}
 
 	else if (postProcess == PostProcess::HeatHaze)
@@ -972,58 +1274,57 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 	{
 		gD3DContext->PSSetShader(gFogPostProcess, nullptr, 0);
 
-		// Bind the depth texture to slot t1
-		gD3DContext->PSSetShaderResources(1, 1, &gSceneDepthSRV);
-
-		gPostProcessingConstants.nearClip = gCamera->NearClip(); // Sync with camera
-		gPostProcessingConstants.farClip = gCamera->FarClip(); // Sync with camera
-		gPostProcessingConstants.fogColour = CVector3(0.7f, 0.8f, 1.0f); // Light blue fog (sky-like)
-		gPostProcessingConstants.fogDensity = 0.01f; // Lower values = lighter fog, higher = dense fog
-		gPostProcessingConstants.fogHeightStart = 200.0f; // Ground level where fog starts
-		gPostProcessingConstants.fogHeightDensity = 0.2f; // Higher values = more ground fog
+		constants.fog.nearClip = gCamera->NearClip(); // Sync with camera
+		constants.fog.farClip = gCamera->FarClip(); // Sync with camera
+		constants.fog.fogColour = CVector3(0.7f, 0.8f, 1.0f); // Light blue fog (sky-like)
+		constants.fog.fogDensity = 0.01f; // Lower values = lighter fog, higher = dense fog
+		constants.fog.fogHeightStart = 200.0f; // Ground level where fog starts
+		constants.fog.fogHeightDensity = 0.2f; // Higher values = more ground fog
+		return MakeConstantBlock(constants.fog);
 	}
 
 	else if (postProcess == PostProcess::GameBoy)
 	{
 		gD3DContext->PSSetShader(gGameBoyPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.gameBoyColour = CVector3(1.0f, 0.5f, 0.5f); // Game Boy-style tint
-		gPostProcessingConstants.gameBoyPixelSize = 100.0f; // Pixelation intensity
-		gPostProcessingConstants.gameBoyColourDepth = 5.0f; // Number of shades for grayscale effect
+		constants.gameBoy.gameBoyColour = CVector3(1.0f, 0.5f, 0.5f); // Game Boy-style tint
+		constants.gameBoy.gameBoyPixelSize = 100.0f; // Pixelation intensity
+		constants.gameBoy.gameBoyColourDepth = 5.0f; // Number of shades for grayscale effect
+		constants.gameBoy.ditherAmount = gPaletteDither ? 1.0f : 0.0f; // Up to half a shade either way
+		return MakeConstantBlock(constants.gameBoy);
 	}
 
 	else if (postProcess == PostProcess::NightVision)
 	{
 		gD3DContext->PSSetShader(gNightVisionPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.nightVisionTint = CVector3(0.2f, 1.5f, 0.4f); // Night vision green tint
-		gPostProcessingConstants.noiseIntensity = 0.5f; // Controls noise/grain strength
-		gPostProcessingConstants.vignetteIntensity = 0.6f; // Controls vignette darkness
-		gPostProcessingConstants.flickerIntensity = 0.01f; // Controls flickering brightness variation
-		gPostProcessingConstants.brightnessBoost = CVector3(0.1f, 0.1f, 0.1f); // Brightness boost
-		gPostProcessingConstants.luminanceThreshold = 0.9f; // Threshold for dark areas
-		gPostProcessingConstants.intensity = 0.6f; // Intensity
+		constants.nightVision.nightVisionTint = CVector3(0.2f, 1.5f, 0.4f); // Night vision green tint
+		constants.nightVision.noiseIntensity = 0.5f; // Controls noise/grain strength
+		constants.nightVision.vignetteIntensity = 0.6f; // Controls vignette darkness
+		constants.nightVision.flickerIntensity = 0.01f; // Controls flickering brightness variation
+		constants.nightVision.brightnessBoost = CVector3(0.1f, 0.1f, 0.1f); // Brightness boost
+		constants.nightVision.luminanceThreshold = 0.9f; // Threshold for dark areas
+		constants.nightVision.intensity = 0.6f; // Intensity
+		return MakeConstantBlock(constants.nightVision);
 	}
 
 	else if (postProcess == PostProcess::ChromaticDis)
 	{
 		gD3DContext->PSSetShader(gChromaticDistortionPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.chromAbAmount = 0.1f; // Chromatic Aberration Intensity
-		gPostProcessingConstants.distortionAmount = 3.0f; // Lens Distortion Strength
-		gPostProcessingConstants.screenCenter = CVector2(0.5f, 0.5f);
+		constants.chromaticDistortion.chromAbAmount = 0.1f; // Chromatic Aberration Intensity
+		constants.chromaticDistortion.distortionAmount = 3.0f; // Lens Distortion Strength
+		constants.chromaticDistortion.screenCenter = CVector2(0.5f, 0.5f);
+		return MakeConstantBlock(constants.chromaticDistortion);
 	}
 
 	else if (postProcess == PostProcess::Wireframe)
 	{
 		gD3DContext->PSSetShader(gWireframePostProcess, nullptr, 0);
 
-		gPostProcessingConstants.texelSize = {
-			2.0f / static_cast<float>(gViewportWidth),
-			2.0f / static_cast<float>(gViewportHeight)
-		};
-		gPostProcessingConstants.edgeThreshold = 0.3; // sensitivity
-		gPostProcessingConstants.edgePower = 1.8; // line sharpness
+		constants.wireframe.edgeThreshold = 0.3f; // sensitivity
+		constants.wireframe.edgePower = 1.8f; // line sharpness
+		return MakeConstantBlock(constants.wireframe);
 	}
 
 	else if (postProcess == PostProcess::Invert)
@@ -1040,29 +1341,71 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess, float frameTime
 	{
 		gD3DContext->PSSetShader(gDilationPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.kernelRadius = 3;
+		constants.dilation.kernelRadius = (gFilterRadius > 0) ? gFilterRadius : 3;
+		return MakeConstantBlock(constants.dilation);
 	}
 
 	else if (postProcess == PostProcess::OnePassBlur)
 	{
 		gD3DContext->PSSetShader(gBlurPostProcess, nullptr, 0);
 
-		gPostProcessingConstants.texelSize = {
-			2.0f / static_cast<float>(gViewportWidth),
-			2.0f / static_cast<float>(gViewportHeight)
-		};
+		constants.onePassBlur = FilterBlurSettings();
+		return MakeConstantBlock(constants.onePassBlur);
+	}
+
+	// No settings other than the pass constants
+	return ConstantBlock();
+}
+
+// The polygon and settings for a window polygon post-process drawn in a polygon batch
+// The settings are the same as those used by SelectPostProcessShaderAndTextures above, packed as described in PolygonBatch.h
+PolygonBatchItem WindowPolygonBatchItem(PostProcess postProcess, int chainIndex)
+{
+	PolygonBatchItem item;
+	item.effect = postProcess;
+	item.points = GetWallOpeningCoords(chainIndex);
+	item.parameters[0] = { 0, 0, 0, 0 };
+	item.parameters[1] = { 0, 0, 0, 0 };
+
+	if (postProcess == PostProcess::Wireframe)
+	{
+		// Texel size, edge threshold and edge power
+		item.parameters[0] = { 2.0f / static_cast<float>(gViewportWidth), 2.0f / static_cast<float>(gViewportHeight), 0.3f, 1.8f };
+	}
+	else if (postProcess == PostProcess::GameBoy)
+	{
+		// Tint colour and pixel size, then colour depth and dither amount
+		item.parameters[0] = { 1.0f, 0.5f, 0.5f, 100.0f };
+		item.parameters[1] = { 5.0f, gPaletteDither ? 1.0f : 0.0f, 0.0f, 0.0f };
 	}
+	else if (postProcess == PostProcess::Distort)
+	{
+		// Distort level
+		item.parameters[0] = { 0.03f, 0.0f, 0.0f, 0.0f };
+	}
+
+	return item;
 }
 
-// Perform a full-screen post process from "scene texture" to back buffer
-void FullScreenPostProcess(PostProcess postProcess, float frameTime, int ppIndex = 0)
+
+// Set up the pipeline for a post-process from the pass inputs (gPassInputSRVs) to the pass target (gTargetRTV)
+// Shared by the full-screen, area and polygon post-processing functions below
+void PreparePostProcessPipeline()
 {
-	// Determine source and target based on ping-pong index
-	gSourceSRV = (ppIndex % 2 == 0) ? gSceneTextureSRV : gSceneTextureSRVTwo;
-	gTargetRTV = (ppIndex % 2 == 0) ? gSceneRenderTargetTwo : gSceneRenderTarget;
+	// Targets smaller than the viewport can't use the depth buffer, only full screen passes are drawn to them
+	ID3D11DepthStencilView* depthStencil = (gTargetSizeDivisor == 1) ? gPostProcessDepthStencil : nullptr;
+	gD3DContext->OMSetRenderTargets(1, &gTargetRTV, depthStencil);
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gPassInputSRVs);
 
-	gD3DContext->OMSetRenderTargets(1, &gTargetRTV, gDepthStencil);
-	gD3DContext->PSSetShaderResources(0, 1, &gSourceSRV);
+	// Draw over the whole target, whatever its size
+	D3D11_VIEWPORT vp;
+	vp.Width    = static_cast<FLOAT>(gViewportWidth  / gTargetSizeDivisor);
+	vp.Height   = static_cast<FLOAT>(gViewportHeight / gTargetSizeDivisor);
+	vp.MinDepth = 0.0f;
+	vp.MaxDepth = 1.0f;
+	vp.TopLeftX = 0;
+	vp.TopLeftY = 0;
+	gD3DContext->RSSetViewports(1, &vp);
 
 	// Using special vertex shader that creates its own data for a 2D screen quad
 	gD3DContext->VSSetShader(g2DQuadVertexShader, nullptr, 0);
@@ -1078,74 +1421,122 @@ void FullScreenPostProcess(PostProcess postProcess, float frameTime, int ppIndex
 	// No need to set vertex/index buffer (see 2D quad vertex shader), just indicate that the quad will be created as a triangle strip
 	gD3DContext->IASetInputLayout(NULL); // No vertex data
 	gD3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+}
 
 
-	// Select shader and textures needed for the required post-processes (helper function above)
-	SelectPostProcessShaderAndTextures(postProcess, frameTime);
-
-
-	// Set 2D area for full-screen post-processing (coordinates in 0->1 range)
-	gPostProcessingConstants.area2DTopLeft = { 0, 0 }; // Top-left of entire screen
-	gPostProcessingConstants.area2DSize    = { 1, 1 }; // Full size of screen
-	gPostProcessingConstants.area2DDepth   = 0;        // Depth buffer value for full screen is as close as possible
+// Send the pass constants (gPostProcessPassConstants) and the settings of the given effect to the shaders
+// Blocks that haven't changed since they were last sent aren't written again, those that have are written with a single map
+void SetPostProcessConstants(PostProcess postProcess, ConstantBlock effectConstants)
+{
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	ConstantSlot& effectSlot = gPostProcessEffectConstantSlots[postProcess];
+	if (effectConstants.size > 0)  gConstantUploader.Upload(effectSlot, effectConstants.data, effectConstants.size);
 
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+	if (effectConstants.size > 0)  BindConstants(effectSlot, 2, SHADER_STAGE_PIXEL);
+}
 
-	// Pass over the above post-processing settings (also the per-process settings prepared in UpdateScene function below)
-	UpdateConstantBuffer(gPostProcessingConstantBuffer, gPostProcessingConstants);
-	gD3DContext->VSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
 
+// Bake the colour LUT of an effect if its settings have changed, and send it to the LUT's texture (see CPUColourLUT.h)
+// Returns false if the texture couldn't be created
+bool UpdateColourLUTTexture(PostProcess postProcess, ColourLUTTexture& colourLUT)
+{
+	if (!colourLUT.lut.Update(postProcess, gPostProcessEffectConstants) && colourLUT.texture)  return true;
 
-	// Draw a quad
-	gD3DContext->Draw(4, 0);
+	int size = colourLUT.lut.Size();
+	if (!colourLUT.texture)
+	{
+		D3D11_TEXTURE3D_DESC lutDesc = {};
+		lutDesc.Width     = size;
+		lutDesc.Height    = size;
+		lutDesc.Depth     = size;
+		lutDesc.MipLevels = 1;
+		lutDesc.Format    = DXGI_FORMAT_R16G16B16A16_FLOAT; // Results outside 0->1 are kept, they are clamped after blending
+		lutDesc.Usage     = D3D11_USAGE_DEFAULT;
+		lutDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		if (FAILED(gD3DDevice->CreateTexture3D(&lutDesc, nullptr, &colourLUT.texture)))  return false;
+		if (FAILED(gD3DDevice->CreateShaderResourceView(colourLUT.texture, nullptr, &colourLUT.srv)))  return false;
+	}
 
-	// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-	gD3DContext->OMSetRenderTargets(1, &gBackBufferRenderTarget, gDepthStencil);
+	// The baked entries already have 16-bit float precision, so this doesn't change them
+	std::vector<uint16_t> halfEntries;
+	halfEntries.reserve(colourLUT.lut.Entries().size() * 4);
+	for (const CVector4& entry : colourLUT.lut.Entries())
+	{
+		halfEntries.insert(halfEntries.end(), { FloatToHalf(entry.x), FloatToHalf(entry.y), FloatToHalf(entry.z), FloatToHalf(entry.w) });
+	}
+	UINT rowPitch = size * 4 * sizeof(uint16_t);
+	gD3DContext->UpdateSubresource(colourLUT.texture, 0, nullptr, halfEntries.data(), rowPitch, rowPitch * size);
+	return true;
+}
 
-	// Draw a quad
-	gD3DContext->Draw(4, 0);
 
-	// Comment
-	gD3DContext->PSSetShaderResources(0, 1, &gNullSRV);
-	gD3DContext->PSSetShaderResources(1, 1, &gNullSRV);
+// Replace the shader and settings selected for a full screen pass of an effect with its colour LUT, a single trilinear fetch
+// per pixel. Returns false, changing nothing, if the LUT can't be used
+bool SelectColourLUT(PostProcess postProcess)
+{
+	ColourLUTTexture& colourLUT = gColourLUTs[postProcess];
+	if (!UpdateColourLUTTexture(postProcess, colourLUT))  return false;
+
+	gD3DContext->PSSetShader(gColourLUTPostProcess, nullptr, 0);
+	gD3DContext->PSSetShaderResources(1, 1, &colourLUT.srv);
+	gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
+
+	// Sample at the centres of the texels at the edges for colours of 0 and 1
+	float size = static_cast<float>(colourLUT.lut.Size());
+	ColourLUTConstants constants = {};
+	constants.lutScale  = (size - 1.0f) / size;
+	constants.lutOffset = 0.5f / size;
+
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	gConstantUploader.Upload(gColourLUTConstantSlot, &constants, sizeof(constants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+	BindConstants(gColourLUTConstantSlot, 2, SHADER_STAGE_PIXEL);
+	return true;
 }
 
 
-// Perform an area post process from "scene texture" to back buffer at a given point in the world, with a given size (world units)
-void AreaPostProcess(PostProcess postProcess, CVector3 worldPoint, CVector2 areaSize, float frameTime, int ppIndex)
+// Perform a full-screen post process from the pass inputs (gPassInputSRVs) to the pass target (gTargetRTV)
+// The render graph decides the target, only the final pass of the chain targets the back buffer
+void FullScreenPostProcess(PostProcess postProcess, float frameTime)
 {
-	// First perform a full-screen copy of the scene to back-buffer
-	FullScreenPostProcess(PostProcess::Copy, frameTime, ppIndex);
+	PreparePostProcessPipeline();
+
+	// Select shader and textures needed for the required post-processes (helper function above)
+	ConstantBlock effectConstants = SelectPostProcessShaderAndTextures(postProcess, frameTime);
 
-	gSourceSRV = (ppIndex % 2 == 0) ? gSceneTextureSRV : gSceneTextureSRVTwo;
-	gTargetRTV = (ppIndex % 2 == 0) ? gSceneRenderTargetTwo : gSceneRenderTarget;
 
-	gD3DContext->OMSetRenderTargets(1, &gTargetRTV, gDepthStencil);
-	gD3DContext->PSSetShaderResources(0, 1, &gSourceSRV);
+	// Set 2D area for full-screen post-processing (coordinates in 0->1 range)
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 }; // Top-left of entire screen
+	gPostProcessPassConstants.area2DSize    = { 1, 1 }; // Full size of screen
+	gPostProcessPassConstants.area2DDepth   = 0;        // Depth buffer value for full screen is as close as possible
 
-	gD3DContext->PSSetSamplers(0, 1, &gPointSampler);
 
-	// Now perform a post-process of a portion of the scene to the back-buffer (overwriting some of the copy above)
-	// Note: The following code relies on many of the settings that were prepared in the FullScreenPostProcess call above, it only
-	//       updates a few things that need to be changed for an area process. If you tinker with the code structure you need to be
-	//       aware of all the work that the above function did that was also preparation for this post-process area step
+	// Pass over the above post-processing settings along with the settings of the effect - or run it from its colour LUT
+	bool useColourLUT = gUseColourLUTs && GetPostProcessDeclaration(postProcess).colourLUT && SelectColourLUT(postProcess);
+	if (!useColourLUT)  SetPostProcessConstants(postProcess, effectConstants);
 
-	// Select shader/textures needed for required post-process
-	SelectPostProcessShaderAndTextures(postProcess, frameTime);
 
-	// Enable alpha blending - area effects need to fade out at the edges or the hard edge of the area is visible
-	// A couple of the shaders have been updated to put the effect into a soft circle
-	// Alpha blending isn't enabled for fullscreen and polygon effects so it doesn't affect those (except heat-haze, which works a bit differently)
-	gD3DContext->OMSetBlendState(gAlphaBlendingState, nullptr, 0xffffff);
+	// Draw a quad
+	gD3DContext->Draw(4, 0);
+
+	// Unbind the inputs, one of them may be the target of the next pass
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
 
 
+// Find the region on screen of an area at a given point in the world, with a given size (world units)
+PostProcessRegion CalculateAreaRegion(CVector3 worldPoint, CVector2 areaSize)
+{
+	PostProcessRegion region;
+
 	// Use picking methods to find the 2D position of the 3D point at the centre of the area effect
 	auto worldPointTo2D = gCamera->PixelFromWorldPt(worldPoint, gViewportWidth, gViewportHeight);
 	CVector2 area2DCentre = { worldPointTo2D.x, worldPointTo2D.y };
 	float areaDistance = worldPointTo2D.z;
 
 	// Nothing to do if given 3D point is behind the camera
-	if (areaDistance < gCamera->NearClip())  return;
+	if (areaDistance < gCamera->NearClip())  return region;
 
 	// Convert pixel coordinates to 0->1 coordinates as used by the shader
 	area2DCentre.x /= gViewportWidth;
@@ -1164,53 +1555,26 @@ void AreaPostProcess(PostProcess postProcess, CVector3 worldPoint, CVector2 area
 
 
 
-	// Send the area top-left and size into the constant buffer - the 2DQuad vertex shader will use this to create a quad in the right place
-	gPostProcessingConstants.area2DTopLeft = area2DCentre - 0.5f * area2DSize; // Top-left of area is centre - half the size
-	gPostProcessingConstants.area2DSize = area2DSize;
+	// Top-left of area is centre - half the size
+	region.area2DTopLeft = area2DCentre - 0.5f * area2DSize;
+	region.area2DSize = area2DSize;
 
 	// Manually calculate depth buffer value from Z distance to the 3D point and camera near/far clip values. Result is 0->1 depth value
 	// We've never seen this full calculation before, it's occasionally useful. It is derived from the material in the Picking lecture
 	// Having the depth allows us to have area effects behind normal objects
-	gPostProcessingConstants.area2DDepth = gCamera->FarClip() * (areaDistance - gCamera->NearClip()) / (gCamera->FarClip() - gCamera->NearClip());
-	gPostProcessingConstants.area2DDepth /= areaDistance;
-
-	// Pass over this post-processing area to shaders (also sends the per-process settings prepared in UpdateScene function below)
-	UpdateConstantBuffer(gPostProcessingConstantBuffer, gPostProcessingConstants);
-	gD3DContext->VSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
+	region.area2DDepth = gCamera->FarClip() * (areaDistance - gCamera->NearClip()) / (gCamera->FarClip() - gCamera->NearClip());
+	region.area2DDepth /= areaDistance;
 
-	// Draw a quad
-	gD3DContext->Draw(4, 0);
-
-	// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-	gD3DContext->OMSetRenderTargets(1, &gBackBufferRenderTarget, gDepthStencil);
-
-	// Draw a quad
-	gD3DContext->Draw(4, 0);
+	region.pixels = AreaPixelRect(region.area2DTopLeft, region.area2DSize, gViewportWidth, gViewportHeight);
+	region.visible = !region.pixels.IsEmpty();
+	return region;
 }
 
 
-// Perform an post process from "scene texture" to back buffer within the given four-point polygon and a world matrix to position/rotate/scale the polygon
-void PolygonPostProcess(PostProcess postProcess, const std::array<CVector3, 4>& points, const CMatrix4x4& worldMatrix, float frameTime, int ppIndex)
+// Find the region on screen of the given four-point polygon and a world matrix to position/rotate/scale the polygon
+PostProcessRegion CalculatePolygonRegion(const std::array<CVector3, 4>& points, const CMatrix4x4& worldMatrix)
 {
-	// First perform a full-screen copy of the scene to back-buffer
-	FullScreenPostProcess(PostProcess::Copy, frameTime, ppIndex);
-
-	gSourceSRV = (ppIndex % 2 == 0) ? gSceneTextureSRV : gSceneTextureSRVTwo;
-	gTargetRTV = (ppIndex % 2 == 0) ? gSceneRenderTargetTwo : gSceneRenderTarget;
-
-	gD3DContext->OMSetRenderTargets(1, &gTargetRTV, gDepthStencil);
-	gD3DContext->PSSetShaderResources(0, 1, &gSourceSRV);
-
-	gD3DContext->PSSetSamplers(0, 1, &gPointSampler);
-
-	// Now perform a post-process of a portion of the scene to the back-buffer (overwriting some of the copy above)
-	// Note: The following code relies on many of the settings that were prepared in the FullScreenPostProcess call above, it only
-	//       updates a few things that need to be changed for an area process. If you tinker with the code structure you need to be
-	//       aware of all the work that the above function did that was also preparation for this post-process area step
-
-	// Select shader/textures needed for required post-process
-	SelectPostProcessShaderAndTextures(postProcess, frameTime);
+	PostProcessRegion region;
 
 	// Loop through the given points, transform each to 2D (this is what the vertex shader normally does in most labs)
 	for (unsigned int i = 0; i < points.size(); ++i)
@@ -1219,41 +1583,677 @@ void PolygonPostProcess(PostProcess postProcess, const std::array<CVector3, 4>&
 		CVector4 worldPosition = modelPosition * worldMatrix;
 		CVector4 viewportPosition = worldPosition * gCamera->ViewProjectionMatrix();
 
-		gPostProcessingConstants.polygon2DPoints[i] = viewportPosition;
+		region.polygon2DPoints[i] = viewportPosition;
 	}
 
-	// Pass over the polygon points to the shaders (also sends the per-process settings prepared in UpdateScene function below)
-	UpdateConstantBuffer(gPostProcessingConstantBuffer, gPostProcessingConstants);
-	gD3DContext->VSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
+	region.pixels = PolygonPixelRect(region.polygon2DPoints, 4, gViewportWidth, gViewportHeight);
+	region.visible = !region.pixels.IsEmpty();
+	return region;
+}
 
-	// Select the special 2D polygon post-processing vertex shader and draw the polygon
-	gD3DContext->VSSetShader(g2DPolygonVertexShader, nullptr, 0);
 
-	// Draw a quad
-	gD3DContext->Draw(4, 0);
+// Find the region on screen covered by an area or polygon pass
+PostProcessRegion CalculatePassRegion(const RenderPass& pass)
+{
+	if (pass.mode == PostProcessMode::Area)
+	{
+		// Pass a 3D point for the centre of the affected area and the size of the (rectangular) area in world units
+		return CalculateAreaRegion(gLights[0].model->Position(), { 10, 10 });
+	}
+	else if (pass.mode == PostProcessMode::Polygon)
+	{
+		// An array of four points in world space - a tapered square centred at the origin
+		const std::array<CVector3, 4> points = { { {-3.0f, 5.0f, 0.0f}, {-5.0f, -5.0f, 0.0f}, 
+			{3.0f, 5.0f, 0.0f}, {5.0f, -5.0f, 0.0f} } };
 
-	// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-	gD3DContext->OMSetRenderTargets(1, &gBackBufferRenderTarget, gDepthStencil);
+		// Pass an array of 4 points and a matrix (rotated in UpdateScene). Only supports 4 points.
+		return CalculatePolygonRegion(points, gPolygonMatrix);
+	}
+	else if (pass.mode == PostProcessMode::WindowPolygon)
+	{
+		// Wall openings are already in world space
+		return CalculatePolygonRegion(GetWallOpeningCoords(pass.chainIndex), MatrixTranslation({ 0.0f, 0.0f, 0.0f }));
+	}
 
-	// Draw a quad
-	gD3DContext->Draw(4, 0);
+	// Full screen
+	PostProcessRegion region;
+	region.visible = true;
+	region.area2DTopLeft = { 0, 0 };
+	region.area2DSize = { 1, 1 };
+	region.pixels = { 0, 0, static_cast<int>(gViewportWidth), static_cast<int>(gViewportHeight) };
+	return region;
 }
 
 
-//**************************
-
-void RenderDepthBufferFromCamera(Camera* camera)
+// Restrict drawing to the given pixels - the rest of the target keeps its previous contents
+void SetScissor(const PixelRect& pixels)
 {
-	// Bind our scene render target and bind the custom depth-stencil view that will receive the depth data.
-	gD3DContext->OMSetRenderTargets(1, &gSceneRenderTarget, gSceneDepthDSV);
+	D3D11_RECT scissorRect = { pixels.left, pixels.top, pixels.right, pixels.bottom };
+	gD3DContext->RSSetScissorRects(1, &scissorRect);
+	gD3DContext->RSSetState(gCullNoneScissorState);
+}
 
-	// Clear the render target to the background colour and clear the custom depth buffer;
-	gD3DContext->ClearRenderTargetView(gSceneRenderTarget, &gBackgroundColor.r);
-	gD3DContext->ClearDepthStencilView(gSceneDepthDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
-	RenderSceneFromCamera(camera);
-}
+// Perform an area post process from the pass inputs to the pass target in the given region
+// Only the region is drawn, the rest of the target is left as it is (either the image being processed for in-place passes, or a full copy of it)
+void AreaPostProcess(PostProcess postProcess, const PostProcessRegion& region, float frameTime)
+{
+	if (!region.visible)  return;
+
+	PreparePostProcessPipeline();
+	SetScissor(region.pixels);
+
+	gD3DContext->PSSetSamplers(0, 1, &gPointSampler);
+
+	// Select shader/textures needed for required post-process
+	ConstantBlock effectConstants = SelectPostProcessShaderAndTextures(postProcess, frameTime);
+
+	// Enable alpha blending - area effects need to fade out at the edges or the hard edge of the area is visible
+	// A couple of the shaders have been updated to put the effect into a soft circle
+	// Alpha blending isn't enabled for fullscreen and polygon effects so it doesn't affect those (except heat-haze, which works a bit differently)
+	gD3DContext->OMSetBlendState(gAlphaBlendingState, nullptr, 0xffffff);
+
+	// Send the area top-left and size into the constant buffer - the 2DQuad vertex shader will use this to create a quad in the right place
+	gPostProcessPassConstants.area2DTopLeft = region.area2DTopLeft;
+	gPostProcessPassConstants.area2DSize    = region.area2DSize;
+	gPostProcessPassConstants.area2DDepth   = region.area2DDepth;
+
+	// Pass over this post-processing area to shaders along with the settings of the effect
+	SetPostProcessConstants(postProcess, effectConstants);
+
+	// Draw a quad
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Perform a polygon post process from the pass inputs to the pass target in the given region
+// Only the polygon is drawn, the rest of the target is left as it is (either the image being processed for in-place passes, or a full copy of it)
+void PolygonPostProcess(PostProcess postProcess, const PostProcessRegion& region, float frameTime)
+{
+	if (!region.visible)  return;
+
+	PreparePostProcessPipeline();
+	SetScissor(region.pixels);
+
+	gD3DContext->PSSetSamplers(0, 1, &gPointSampler);
+
+	// Select shader/textures needed for required post-process
+	ConstantBlock effectConstants = SelectPostProcessShaderAndTextures(postProcess, frameTime);
+
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		gPostProcessPassConstants.polygon2DPoints[i] = region.polygon2DPoints[i];
+	}
+
+	// Pass over the polygon points to the shaders along with the settings of the effect
+	SetPostProcessConstants(postProcess, effectConstants);
+
+	// Select the special 2D polygon post-processing vertex shader and draw the polygon
+	gD3DContext->VSSetShader(g2DPolygonVertexShader, nullptr, 0);
+
+	// Draw a quad
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Perform a colour transform pass from the pass inputs to the pass target - all the chain entries of the pass as one full
+// screen draw (see ColourTransform.h)
+void ColourTransformPostProcess(const RenderPass& pass, float frameTime)
+{
+	// Update the settings of each effect just as running it on its own would (e.g. the hue gradient moves on each frame)
+	// This also selects each effect's shader, replaced below
+	for (int chainIndex = pass.chainIndex; chainIndex < pass.chainIndex + pass.batchSize; ++chainIndex)
+	{
+		SelectPostProcessShaderAndTextures(gActivePostProcesses[chainIndex].first, frameTime);
+	}
+	ColourTransformConstants constants = BuildColourTransform(gActivePostProcesses, pass.chainIndex, pass.batchSize, gPostProcessEffectConstants);
+
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetShader(gColourTransformPostProcess, nullptr, 0);
+	gD3DContext->PSSetSamplers(0, 1, &gPointSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+
+	ConstantSlot& constantSlot = gColourTransformConstantSlots[pass.chainIndex];
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	gConstantUploader.Upload(constantSlot, &constants, sizeof(constants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+	BindConstants(constantSlot, 2, SHADER_STAGE_PIXEL);
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Perform a UV remap pass from the pass inputs to the pass target - all the chain entries of the pass as one full screen
+// draw reading the pass input once (see UVRemap.h)
+void UVRemapPostProcess(const RenderPass& pass, float frameTime)
+{
+	// Update the settings of each effect as running it on its own would (the spiral winds up each frame)
+	for (int chainIndex = pass.chainIndex; chainIndex < pass.chainIndex + pass.batchSize; ++chainIndex)
+	{
+		SelectPostProcessShaderAndTextures(gActivePostProcesses[chainIndex].first, frameTime);
+	}
+	UVRemapConstants constants = BuildUVRemap(gActivePostProcesses, pass.chainIndex, pass.batchSize, gPostProcessEffectConstants);
+
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetShader(gUVRemapPostProcess, nullptr, 0);
+	gD3DContext->PSSetShaderResources(1, 1, &gDistortMapSRV);
+	gD3DContext->PSSetSamplers(0, 1, &gBilinearClampSampler);
+	gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+
+	ConstantSlot& constantSlot = gUVRemapConstantSlots[pass.chainIndex];
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	gConstantUploader.Upload(constantSlot, &constants, sizeof(constants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+	BindConstants(constantSlot, 2, SHADER_STAGE_PIXEL);
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Draw the pass input over the whole pass target with bilinear filtering, for a target of a different size to the input
+void ResamplePostProcess()
+{
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetShader(gResamplePostProcess, nullptr, 0);
+	gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Draw one of the bloom's downsampled or upsampled images from the pass inputs over the whole pass target, depending on the
+// pass type (see Bloom.h)
+void BloomMipPostProcess(const RenderPass& pass, float frameTime)
+{
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+	if (pass.type == RenderPassType::BloomDownsample)
+	{
+		// The bright pass settings pick out the bright parts on the first level. Selecting them also selects the bright pass
+		// shader, replaced here
+		SelectPostProcessShaderAndTextures(PostProcess::BrightPass, frameTime);
+		gD3DContext->PSSetShader(gBloomDownsamplePostProcess, nullptr, 0);
+
+		bool firstLevel = gTargetSizeDivisor == 2;
+		BloomDownsampleConstants constants = MakeBloomDownsampleConstants(gPostProcessEffectConstants, firstLevel);
+		ConstantSlot& constantSlot = gBloomDownsampleConstantSlots[firstLevel ? 0 : 1];
+		gConstantUploader.Upload(constantSlot, &constants, sizeof(constants));
+		BindConstants(constantSlot, 2, SHADER_STAGE_PIXEL);
+	}
+	else
+	{
+		gD3DContext->PSSetShader(gBloomUpsamplePostProcess, nullptr, 0);
+	}
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Draw one pass of one of the lens star's streaks from the pass inputs over the whole pass target (see LensStar.h)
+void LensStarStreakPostProcess(const RenderPass& pass, float frameTime)
+{
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+	// Selecting the lens star sets its settings, and its shader, replaced here
+	SelectPostProcessShaderAndTextures(PostProcess::LensStar, frameTime);
+	gD3DContext->PSSetShader(gLensStarStreakPostProcess, nullptr, 0);
+
+	LensStarStreakConstants constants = MakeLensStarStreakConstants(gPostProcessEffectConstants.lensStar, pass.streak, pass.streakPass,
+	                                                                pass.streakBackward);
+	int slotKey = (pass.streak * LENS_STAR_MAX_PASSES + pass.streakPass) * 2 + (pass.streakBackward ? 1 : 0);
+	ConstantSlot& constantSlot = gLensStarStreakConstantSlots[slotKey];
+	gConstantUploader.Upload(constantSlot, &constants, sizeof(constants));
+	BindConstants(constantSlot, 2, SHADER_STAGE_PIXEL);
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Draw one of the depth of field's circle of confusion, tiles, far field or near field images from the pass inputs over the
+// whole pass target, depending on the pass type (see DepthOfField.h)
+void DepthOfFieldStagePostProcess(const RenderPass& pass, float frameTime)
+{
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+
+	if (pass.type == RenderPassType::DepthOfFieldCoC)
+	{
+		// The circle of confusion uses the depth of field's settings. Selecting them also selects the composite shader,
+		// replaced here
+		ConstantBlock effectConstants = SelectPostProcessShaderAndTextures(PostProcess::DepthOfField, frameTime);
+		gD3DContext->PSSetShader(gDepthOfFieldCoCPostProcess, nullptr, 0);
+		SetPostProcessConstants(PostProcess::DepthOfField, effectConstants);
+	}
+	else
+	{
+		gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+		BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+		if (pass.type == RenderPassType::DepthOfFieldTiles)
+		{
+			gD3DContext->PSSetShader(gDepthOfFieldTilesPostProcess, nullptr, 0);
+		}
+		else
+		{
+			gD3DContext->PSSetShader(gDepthOfFieldGatherPostProcess, nullptr, 0);
+
+			bool nearField = pass.type == RenderPassType::DepthOfFieldNear;
+			DepthOfFieldGatherConstants constants = MakeDepthOfFieldGatherConstants(nearField, pass.temporalFrames,
+			                                                                        gPostProcessEffectConstants.temporal.frameIndex);
+			ConstantSlot& constantSlot = gDepthOfFieldGatherConstantSlots[nearField ? 1 : 0];
+			gConstantUploader.Upload(constantSlot, &constants, sizeof(constants));
+			BindConstants(constantSlot, 2, SHADER_STAGE_PIXEL);
+		}
+	}
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Draw the longest velocity of each tile of the scene velocity over the whole pass target, for the motion blur (see MotionBlur.h)
+void MotionBlurTilesPostProcess()
+{
+	PreparePostProcessPipeline();
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+	gD3DContext->PSSetShader(gMotionBlurTilesPostProcess, nullptr, 0);
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Blend an effect's output into the history reprojected from last frame, over the whole pass target (see TemporalHistory.h)
+void TemporalResolvePostProcess(const RenderPass& pass)
+{
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetShader(gTemporalResolvePostProcess, nullptr, 0);
+	gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+	TemporalResolveConstants constants = MakeTemporalResolveConstants(gPostProcessEffectConstants.temporal, pass.temporalFrames,
+	                                                                  gHistoryValid);
+	gConstantUploader.Upload(gTemporalResolveConstantSlot, &constants, sizeof(constants));
+	BindConstants(gTemporalResolveConstantSlot, 2, SHADER_STAGE_PIXEL);
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Draw the pass's first input plus the change an effect made to a smaller image, scaled up, over the whole pass target (see
+// RenderPassType::ReducedResolutionUpsample)
+void ReducedResolutionUpsamplePostProcess()
+{
+	PreparePostProcessPipeline();
+	gD3DContext->PSSetShader(gReducedResolutionUpsamplePostProcess, nullptr, 0);
+
+	gPostProcessPassConstants.area2DTopLeft = { 0, 0 };
+	gPostProcessPassConstants.area2DSize    = { 1, 1 };
+	gPostProcessPassConstants.area2DDepth   = 0;
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_VERTEX | SHADER_STAGE_PIXEL);
+
+	gD3DContext->Draw(4, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+// Run one pass of a full screen dilation or box blur from the pass input to the given view of the pass target with the
+// sliding window compute shader, along the rows or down the columns depending on the pass type (see SlidingFilter.h)
+void SlidingFilterPostProcess(const RenderPass& pass, ID3D11UnorderedAccessView* target, float frameTime)
+{
+	// Update the effect's settings just as running its pixel shader would. This also selects the pixel shader, which isn't used
+	SelectPostProcessShaderAndTextures(pass.effect, frameTime);
+	bool columns = pass.type == RenderPassType::SlidingFilterColumns;
+	SlidingFilterConstants constants = MakeSlidingFilterConstants(pass.effect, columns, gPostProcessEffectConstants);
+
+	// The input may still be bound as the render target of the pass before, which would stop the compute shader reading it
+	gD3DContext->OMSetRenderTargets(0, nullptr, nullptr);
+
+	gD3DContext->CSSetShader(gSlidingFilterComputeShader, nullptr, 0);
+	gD3DContext->CSSetShaderResources(0, 1, &gPassInputSRVs[0]);
+	gD3DContext->CSSetUnorderedAccessViews(0, 1, &target, nullptr);
+
+	ConstantSlot& constantSlot = gSlidingFilterConstantSlots[columns ? 1 : 0];
+	gConstantUploader.Upload(constantSlot, &constants, sizeof(constants));
+	BindConstants(constantSlot, 2, SHADER_STAGE_COMPUTE);
+
+	// A thread group for each chunk of each line
+	int lineLength = columns ? gViewportHeight : gViewportWidth;
+	int numLines   = columns ? gViewportWidth  : gViewportHeight;
+	gD3DContext->Dispatch((lineLength + SLIDING_FILTER_LINE_CHUNK - 1) / SLIDING_FILTER_LINE_CHUNK, numLines, 1);
+
+	// Unbind so the next pass can read the target and write to the input
+	ID3D11UnorderedAccessView* nullUAV = nullptr;
+	gD3DContext->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+	gD3DContext->CSSetShaderResources(0, 1, gNullSRVs);
+}
+
+
+// Run a full screen neighbourhood effect from the pass input to the given view of the pass target with its compute shader,
+// which works a tile at a time (see ComputeTile.h)
+void ComputeTilePostProcess(const RenderPass& pass, ID3D11UnorderedAccessView* target, float frameTime)
+{
+	// Update the effect's settings just as running its pixel shader would. This also selects the pixel shader, which isn't used
+	ConstantBlock effectConstants = SelectPostProcessShaderAndTextures(pass.effect, frameTime);
+
+	ID3D11ComputeShader* computeShader = gWireframeComputeShader;
+	if      (pass.effect == PostProcess::GaussianBlurHorizontal)  computeShader = gGaussianHorizontalBlurComputeShader;
+	else if (pass.effect == PostProcess::GaussianBlurVertical)    computeShader = gGaussianVerticalBlurComputeShader;
+
+	// The input may still be bound as the render target of the pass before, which would stop the compute shader reading it
+	gD3DContext->OMSetRenderTargets(0, nullptr, nullptr);
+
+	gD3DContext->CSSetShader(computeShader, nullptr, 0);
+	gD3DContext->CSSetShaderResources(0, 1, &gPassInputSRVs[0]);
+	gD3DContext->CSSetUnorderedAccessViews(0, 1, &target, nullptr);
+
+	// The wireframe reads its sample step from the pass constants
+	gConstantUploader.Upload(gPostProcessPassConstantSlot, &gPostProcessPassConstants, sizeof(gPostProcessPassConstants));
+	BindConstants(gPostProcessPassConstantSlot, 1, SHADER_STAGE_COMPUTE);
+	ConstantSlot& effectSlot = gPostProcessEffectConstantSlots[pass.effect];
+	gConstantUploader.Upload(effectSlot, effectConstants.data, effectConstants.size);
+	BindConstants(effectSlot, 2, SHADER_STAGE_COMPUTE);
+
+	// A thread group for each tile of the target, which may be smaller than the viewport (blurs of a halved image)
+	int width  = gViewportWidth  / gTargetSizeDivisor;
+	int height = gViewportHeight / gTargetSizeDivisor;
+	ComputeTileShape shape = GetComputeTileShape(pass.effect, gPostProcessEffectConstants, gPostProcessPassConstants, width, height);
+	gD3DContext->Dispatch(ComputeTileGroupsX(shape, width), ComputeTileGroupsY(shape, height), 1);
+
+	// Unbind so the next pass can read the target and write to the input
+	ID3D11UnorderedAccessView* nullUAV = nullptr;
+	gD3DContext->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+	gD3DContext->CSSetShaderResources(0, 1, gNullSRVs);
+}
+
+
+// Draw one draw of a polygon batch from the pass inputs to the pass target. The polygons must already be in gPolygonBatchBuffer
+// Every polygon in the draw reads the same input, see PolygonBatch.h
+void PolygonBatchPostProcess(const PolygonBatchDraw& draw)
+{
+	PreparePostProcessPipeline();
+	SetScissor(BoundingRect(draw.drawRects));
+
+	// Polygons are placed by the batch vertex shader, which reads them from the structured buffer, as does the pixel shader
+	gD3DContext->VSSetShader(g2DPolygonBatchVertexShader, nullptr, 0);
+	gD3DContext->PSSetShader(gPolygonBatchPostProcess, nullptr, 0);
+	gD3DContext->VSSetShaderResources(3, 1, &gPolygonBatchSRV);
+	gD3DContext->PSSetShaderResources(3, 1, &gPolygonBatchSRV);
+
+	// Point sampling for the scene, trilinear for the distortion map (used by the distort effect)
+	gD3DContext->PSSetSamplers(0, 1, &gPointSampler);
+	gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
+
+	// One quad for each polygon
+	gD3DContext->DrawInstanced(4, draw.numInstances, 0, 0);
+
+	gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, gNullSRVs);
+}
+
+
+//**************************
+
+// Textures and views backing a render graph resource
+ID3D11Texture2D* GraphTexture(int resource)
+{
+	const GraphResource& graphResource = gPostProcessGraph.Resource(resource);
+	if (graphResource.type == GraphResourceType::SceneDepth)     return gSceneDepthTexture;
+	if (graphResource.type == GraphResourceType::SceneVelocity)  return gSceneVelocityTexture;
+	if (graphResource.type == GraphResourceType::History)        return gHistoryTexture;
+	if (graphResource.type == GraphResourceType::BackBuffer)     return nullptr; // Graph only draws to the back buffer, never copies
+	return gPooledTargets[graphResource.physical].texture;
+}
+
+ID3D11ShaderResourceView* GraphTextureSRV(int resource)
+{
+	if (resource < 0)  return nullptr;
+	const GraphResource& graphResource = gPostProcessGraph.Resource(resource);
+	if (graphResource.type == GraphResourceType::SceneDepth)     return gSceneDepthSRV;
+	if (graphResource.type == GraphResourceType::SceneVelocity)  return gSceneVelocitySRV;
+	if (graphResource.type == GraphResourceType::History)        return gHistorySRV;
+	if (graphResource.type == GraphResourceType::BackBuffer)     return nullptr;
+	return gPooledTargets[graphResource.physical].textureSRV;
+}
+
+ID3D11UnorderedAccessView* GraphUnorderedAccess(int resource)
+{
+	const GraphResource& graphResource = gPostProcessGraph.Resource(resource);
+	if (graphResource.type != GraphResourceType::Transient)  return nullptr; // Compute shaders only write the graph's own images
+	return gPooledTargets[graphResource.physical].unorderedAccess;
+}
+
+ID3D11RenderTargetView* GraphRenderTarget(int resource)
+{
+	const GraphResource& graphResource = gPostProcessGraph.Resource(resource);
+	if (graphResource.type == GraphResourceType::SceneDepth)     return nullptr; // Depth and velocity are only written by the scene rendering
+	if (graphResource.type == GraphResourceType::SceneVelocity)  return nullptr;
+	if (graphResource.type == GraphResourceType::History)        return gHistoryRTV;
+	if (graphResource.type == GraphResourceType::BackBuffer)     return gBackBufferRenderTarget;
+	return gPooledTargets[graphResource.physical].renderTarget;
+}
+
+
+// Runs the render graph passes with DirectX using the post-processing functions above
+class D3DPostProcessDevice : public PostProcessDevice
+{
+public:
+	D3DPostProcessDevice(float frameTime) : mFrameTime(frameTime) {}
+
+	void SetPassResources(const RenderPass& pass) override
+	{
+		// Select the images the graph has given to this pass
+		for (int slot = 0; slot < MAX_PASS_INPUTS; ++slot)
+		{
+			gPassInputSRVs[slot] = GraphTextureSRV(pass.inputs[slot]);
+		}
+		gTargetRTV = GraphRenderTarget(pass.output);
+		gTargetSizeDivisor = gPostProcessGraph.Resource(pass.output).sizeDivisor;
+
+		gCurrentPostProcess = pass.effect;
+		gCurrentPostProcessMode = pass.mode;
+	}
+
+	void DrawFullScreen(PostProcess postProcess) override
+	{
+		FullScreenPostProcess(postProcess, mFrameTime);
+	}
+
+	void DrawRegion(const RenderPass& pass) override
+	{
+		PostProcessRegion region = CalculatePassRegion(pass);
+		if (pass.mode == PostProcessMode::Area)
+		{
+			AreaPostProcess(pass.effect, region, mFrameTime);
+		}
+		else
+		{
+			PolygonPostProcess(pass.effect, region, mFrameTime);
+		}
+	}
+
+	void CopyResource(int destination, int source) override
+	{
+		gD3DContext->CopyResource(GraphTexture(destination), GraphTexture(source));
+	}
+
+	int CopyRegion(int destination, int source, const RenderPass& pass) override
+	{
+		// Copy the pixels the effect will read: the region it covers plus the halo around it that it samples
+		PostProcessRegion region = CalculatePassRegion(pass);
+		if (!region.visible)  return 0;
+		PixelRect rect = ExpandByFootprint(region.pixels, GetPostProcessDeclaration(pass.effect), gViewportWidth, gViewportHeight);
+		if (rect.IsEmpty())  return 0;
+
+		// Copied to the same place in the destination so the effect can use its usual UVs
+		D3D11_BOX box = { static_cast<UINT>(rect.left), static_cast<UINT>(rect.top), 0, static_cast<UINT>(rect.right), static_cast<UINT>(rect.bottom), 1 };
+		gD3DContext->CopySubresourceRegion(GraphTexture(destination), 0, rect.left, rect.top, 0, GraphTexture(source), 0, &box);
+		return rect.Area();
+	}
+
+	PostProcessStats DrawPolygonBatch(const RenderPass& pass) override
+	{
+		PostProcessStats stats;
+
+		// Project the polygons and split them into draws where one reads what another has written
+		std::vector<PolygonBatchItem> items;
+		for (int chainIndex = pass.chainIndex; chainIndex < pass.chainIndex + pass.batchSize; ++chainIndex)
+		{
+			items.push_back(WindowPolygonBatchItem(gActivePostProcesses[chainIndex].first, chainIndex));
+		}
+		gPolygonBatch.Build(items, gCamera->ViewProjectionMatrix(), gViewportWidth, gViewportHeight);
+
+		// Input 0 is the scratch image for the copies, input 1 the distortion map. The polygons are drawn in place
+		gPassInputSRVs[0] = GraphTextureSRV(pass.inputs[0]);
+		gPassInputSRVs[1] = gDistortMapSRV;
+		gPassInputSRVs[2] = nullptr;
+		gTargetRTV = GraphRenderTarget(pass.output);
+		gTargetSizeDivisor = 1;
+		gCurrentPostProcess = pass.effect;
+		gCurrentPostProcessMode = pass.mode;
+
+		for (const PolygonBatchDraw& draw : gPolygonBatch.Draws())
+		{
+			// Copy the pixels read by this draw, in the same place in the scratch image
+			for (const PixelRect& rect : draw.copyRects)
+			{
+				D3D11_BOX box = { static_cast<UINT>(rect.left), static_cast<UINT>(rect.top), 0, static_cast<UINT>(rect.right), static_cast<UINT>(rect.bottom), 1 };
+				gD3DContext->CopySubresourceRegion(GraphTexture(pass.inputs[0]), 0, rect.left, rect.top, 0, GraphTexture(pass.output), 0, &box);
+				++stats.copies;
+				stats.regionPixels += rect.Area();
+			}
+
+			// One upload of all the polygons in the draw
+			D3D11_MAPPED_SUBRESOURCE mappedBuffer;
+			gD3DContext->Map(gPolygonBatchBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuffer);
+			memcpy(mappedBuffer.pData, &gPolygonBatch.Instances()[draw.firstInstance], draw.numInstances * sizeof(PolygonInstance));
+			gD3DContext->Unmap(gPolygonBatchBuffer, 0);
+
+			PolygonBatchPostProcess(draw);
+			++stats.draws;
+		}
+
+		return stats;
+	}
+
+	void DrawColourTransform(const RenderPass& pass) override
+	{
+		ColourTransformPostProcess(pass, mFrameTime);
+	}
+
+	void DrawUVRemap(const RenderPass& pass) override
+	{
+		UVRemapPostProcess(pass, mFrameTime);
+	}
+
+	void DrawResample(const RenderPass&) override
+	{
+		ResamplePostProcess();
+	}
+
+	void RunSlidingFilter(const RenderPass& pass) override
+	{
+		SlidingFilterPostProcess(pass, GraphUnorderedAccess(pass.output), mFrameTime);
+	}
+
+	void RunComputeTile(const RenderPass& pass) override
+	{
+		ComputeTilePostProcess(pass, GraphUnorderedAccess(pass.output), mFrameTime);
+	}
+
+	void DrawBloomMip(const RenderPass& pass) override
+	{
+		BloomMipPostProcess(pass, mFrameTime);
+	}
+
+	void DrawLensStarStreak(const RenderPass& pass) override
+	{
+		LensStarStreakPostProcess(pass, mFrameTime);
+	}
+
+	void DrawDepthOfFieldStage(const RenderPass& pass) override
+	{
+		DepthOfFieldStagePostProcess(pass, mFrameTime);
+	}
+
+	void DrawMotionBlurTiles(const RenderPass&) override
+	{
+		MotionBlurTilesPostProcess();
+	}
+
+	void DrawReducedResolutionUpsample(const RenderPass&) override
+	{
+		ReducedResolutionUpsamplePostProcess();
+	}
+
+	void DrawTemporalResolve(const RenderPass& pass) override
+	{
+		TemporalResolvePostProcess(pass);
+	}
+
+private:
+	float mFrameTime;
+};
 
 
 // Rendering the scene
@@ -1261,6 +2261,15 @@ void RenderScene(float frameTime)
 {
 	//// Common settings ////
 
+	// Start a new frame of constant uploads, before anything is uploaded
+	BeginConstantUploadFrame();
+	gLastFrameMeshConstants = gMeshConstantStatistics;
+	gMeshConstantStatistics = MeshConstantStatistics();
+	gLastFrameMeshDraws = gMeshDrawStatistics;
+	gMeshDrawStatistics = MeshDrawStatistics();
+	gLastFrameStressRenderTime = gStressRenderTime;
+	gStressRenderTime = 0;
+
 	// Set up the light information in the constant buffer
 	// Don't send to the GPU yet, the function RenderSceneFromCamera will do that
 	gPerFrameConstants.light1Colour   = gLights[0].colour * gLights[0].strength;
@@ -1275,16 +2284,42 @@ void RenderScene(float frameTime)
 	gPerFrameConstants.viewportWidth  = static_cast<float>(gViewportWidth);
 	gPerFrameConstants.viewportHeight = static_cast<float>(gViewportHeight);
 
+	// Edge effects step two pixels between samples (the Gaussian blur works out its own steps)
+	gPostProcessPassConstants.texelSize = { 2.0f / static_cast<float>(gViewportWidth), 2.0f / static_cast<float>(gViewportHeight) };
 
 
-	////--------------- Main scene rendering ---------------////
 
-	// Set the target for rendering and select the main depth buffer.
-	// If using post-processing then render to the scene texture, otherwise to the usual back buffer
-	// Also clear the render target to a fixed colour and the depth buffer to the far distance
-	gD3DContext->OMSetRenderTargets(1, &gSceneRenderTarget, gDepthStencil);
-	gD3DContext->ClearRenderTargetView(gSceneRenderTarget, &gBackgroundColor.r);
-	gD3DContext->ClearDepthStencilView(gDepthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	////--------------- Post-processing targets ---------------////
+
+	// The render graph only needs rebuilding when the chain of post-processes changes, or a blur needs a different size image
+	int blurLevels = GaussianBlurLevels(gBlurSigma);
+	int lensStarPasses = LensStarPasses(gLensStarLength);
+	bool slidingBoxBlur = BoxBlurIsSliding(FilterBlurSettings());
+	if (!gPostProcessGraph.IsCompiledFrom(gActivePostProcesses, blurLevels, gUseComputeTiles, gUseReducedResolution, gUseTemporalAccumulation,
+	                                      lensStarPasses, slidingBoxBlur))
+	{
+		gPostProcessGraph.Compile(gActivePostProcesses, blurLevels, gUseComputeTiles, gUseReducedResolution, gUseTemporalAccumulation,
+		                          lensStarPasses, slidingBoxBlur);
+		gHistoryValid = false;
+	}
+
+	// Get the textures for this frame from the pool, including the scene texture
+	gRenderTargetAllocator.BeginFrame();
+	gPostProcessGraph.AllocateTargets(gRenderTargetAllocator, gViewportWidth, gViewportHeight);
+	if (!UpdatePooledTargets())
+	{
+		// Out of memory for this chain (UpdatePooledTargets has set gLastError) - skip post-processing this frame and show the
+		// plain scene, which needs the fewest textures. The chain itself is kept, so the next frame compiles it and tries again
+		gPostProcessGraph.Compile(PostProcessChain());
+		gHistoryValid = false;
+		gRenderTargetAllocator.BeginFrame();
+		gPostProcessGraph.AllocateTargets(gRenderTargetAllocator, gViewportWidth, gViewportHeight);
+		if (!UpdatePooledTargets())  return;
+	}
+	ID3D11RenderTargetView* sceneRenderTarget = GraphRenderTarget(SCENE_COLOUR_RESOURCE);
+
+
+	////--------------- Main scene rendering ---------------////
 
 	// Setup the viewport to the size of the main window
 	D3D11_VIEWPORT vp;
@@ -1296,73 +2331,67 @@ void RenderScene(float frameTime)
 	vp.TopLeftY = 0;
 	gD3DContext->RSSetViewports(1, &vp);
 
-	// Render the scene from the main camera
-	RenderSceneFromCamera(gCamera);
-
-	// Render the scene normally.
-	if (gCurrentPostProcess == PostProcess::Fog || gCurrentPostProcess == PostProcess::DepthOfField)
+	// Render the scene from the main camera into the scene texture. If any post-process in the chain reads the depth then
+	// the scene is rendered straight into the shader-readable depth texture, otherwise into the usual depth buffer
+	for (const ScenePass& scenePass : PlanScenePasses(gPostProcessGraph, gDepthPrePass))
 	{
-		RenderDepthBufferFromCamera(gCamera);
-	}
+		ID3D11DepthStencilView* depthStencil = scenePass.sceneDepth ? gSceneDepthDSV : gDepthStencil;
+		if (scenePass.depthOnly)
+		{
+			gD3DContext->OMSetRenderTargets(0, nullptr, depthStencil);
+		}
+		else if (scenePass.velocity)
+		{
+			// Nothing moves where no model is drawn
+			const float stillVelocity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			gD3DContext->OMSetRenderTargets(1, &gSceneVelocityRTV, depthStencil);
+			gD3DContext->ClearRenderTargetView(gSceneVelocityRTV, stillVelocity);
+		}
+		else
+		{
+			// Clear the render target to a fixed colour
+			gD3DContext->OMSetRenderTargets(1, &sceneRenderTarget, depthStencil);
+			gD3DContext->ClearRenderTargetView(sceneRenderTarget, &gBackgroundColor.r);
+		}
 
-	////--------------- Scene completion ---------------////
+		// Clear the depth buffer to the far distance, unless a pre-pass has just filled it
+		if (!scenePass.depthAlreadyWritten)
+		{
+			gD3DContext->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
+		}
 
-    if (!gActivePostProcesses.empty())
-    {
-		int ppIndex = 0;
+		RenderSceneFromCamera(gCamera, scenePass);
 
-		for (std::pair<PostProcess, PostProcessMode> postProcessAndMode : gActivePostProcesses)
-		{
-			gCurrentPostProcess = postProcessAndMode.first;
-			gCurrentPostProcessMode = postProcessAndMode.second;
-
-            if (gCurrentPostProcessMode == PostProcessMode::Fullscreen)
-            {	
-				if (gCurrentPostProcess == PostProcess::BrightPass)
-				{
-					gD3DContext->CopyResource(gSceneTextureThree, gSceneTexture);
-					FullScreenPostProcess(PostProcess::Copy, frameTime, ppIndex);
-					gD3DContext->CopyResource(gSceneTextureTwo, gSceneTexture);
-				}
-
-				FullScreenPostProcess(gCurrentPostProcess, frameTime, ppIndex++);
-
-				if (gCurrentPostProcess == PostProcess::MotionBlur)
-				{
-					gD3DContext->CopyResource(gFeedbackTexture, gSceneTexture);
-				}
-            }
-            else if (gCurrentPostProcessMode == PostProcessMode::Area)
-            {
-				// Pass a 3D point for the centre of the affected area and the size of the (rectangular) area in world units
-                AreaPostProcess(gCurrentPostProcess, gLights[0].model->Position(), { 10, 10 }, frameTime, ppIndex++);
-            }
-            else if (gCurrentPostProcessMode == PostProcessMode::Polygon)
-            {
-				// An array of four points in world space - a tapered square centred at the origin
-				const std::array<CVector3, 4> points = { { {-3.0f, 5.0f, 0.0f}, {-5.0f, -5.0f, 0.0f}, 
-					{3.0f, 5.0f, 0.0f}, {5.0f, -5.0f, 0.0f} } };
-				// A rotating matrix placing the model above in the scene
-                static CMatrix4x4 polyMatrix = MatrixTranslation({ 20.0f, 15.0f, 0.0f });
-				polyMatrix = MatrixRotationY(ToRadians(0.2f)) * polyMatrix;
-
-				// Pass an array of 4 points and a matrix. Only supports 4 points.
-                PolygonPostProcess(gCurrentPostProcess, points, polyMatrix, frameTime, ppIndex++);
-            }
-			else if (gCurrentPostProcessMode == PostProcessMode::WindowPolygon)
-			{
-				// A rotating matrix placing the model above in the scene
-				static CMatrix4x4 polyMatrix = MatrixTranslation({ 0.0f, 0.0f, 0.0f });
-				PolygonPostProcess(gCurrentPostProcess, GetWallOpeningCoords(ppIndex), polyMatrix, frameTime, ppIndex++);
-			}
-        }
-    }
-	else
-	{
-		//Use a simple FullScreenPostProcess
-		FullScreenPostProcess(PostProcess::Copy, frameTime);
+		// Post-processes can't write the depth they read, so they get a read-only view of it
+		gPostProcessDepthStencil = scenePass.sceneDepth ? gSceneDepthReadOnlyDSV : gDepthStencil;
 	}
 
+	////--------------- Scene completion ---------------////
+
+	// Where this frame's pixels were last frame, for the temporal resolve. Each frame takes the next share of the samples
+	TemporalResolveConstants& temporal = gPostProcessEffectConstants.temporal;
+	temporal.reprojection       = MakeReprojectionMatrix(gCamera->ViewMatrix(), gCamera->ProjectionMatrix(), gCamera->PreviousViewProjectionMatrix());
+	temporal.nearClip           = gCamera->NearClip();
+	temporal.farClip            = gCamera->FarClip();
+	temporal.depthTolerance     = TEMPORAL_DEPTH_TOLERANCE;
+	temporal.neighbourhoodClamp = 1;
+	++temporal.frameIndex;
+
+	// Run the passes, the final one draws to the back buffer
+	D3DPostProcessDevice postProcessDevice(frameTime);
+	gPostProcessStats = ExecuteRenderGraph(gPostProcessGraph, postProcessDevice);
+	gHistoryValid = true;
+
+	// This frame's matrices are the previous ones for the velocity pass of the next frame
+	gCamera->EndFrame();
+	for (Model* model : { gGround, gCrate, gCube, gWall, gWall2, gStars })  model->EndFrame();
+	for (Model* crate : gStressCrates)  crate->EndFrame();
+	for (int i = 0; i < NUM_LIGHTS; ++i)  gLights[i].model->EndFrame();
+
+	// Textures not used this frame go back to the GPU
+	gRenderTargetAllocator.EndFrame();
+	UpdatePooledTargets();
+
 	// When drawing to the off-screen back buffer is complete, we "present" the image to the front buffer (the screen)
 	// Set first parameter to 1 to lock to vsync
 	gSwapChain->Present(lockFPS ? 1 : 0, 0);
@@ -1374,6 +2403,56 @@ void RenderScene(float frameTime)
 //--------------------------------------------------------------------------------------
 
 
+// Statistics of the last frame and the current settings as one line of text, shown in the window title when gShowStats is on
+std::string FormatFrameStats()
+{
+	std::ostringstream stats;
+	stats.precision(1);
+	stats << std::fixed;
+
+	// Post-processing passes and the constants they uploaded
+	stats << "Passes: " << gPostProcessStats.passes << ", Draws: " << gPostProcessStats.draws <<
+		", Copied pixels: " << gPostProcessStats.regionPixels <<
+		", Constants: " << gConstantUploader.LastFrameWrittenBytes() << "/" << gConstantUploader.LastFrameRequestedBytes() << " bytes, " <<
+		gConstantUploader.LastFrameSkippedBlocks() << " unchanged, " << gConstantUploader.LastFrameMaps() << " maps" <<
+		", Model constants: " << gLastFrameMeshConstants.modelBytes + gLastFrameMeshConstants.skeletonBytes << " bytes (" <<
+		gLastFrameMeshConstants.combinedBytes << " unsplit)";
+
+	// Render target pool memory in MB: now, peak and average over all frames
+	const double bytesPerMB = 1024.0 * 1024.0;
+	stats << ", Targets: " << gRenderTargetAllocator.NumAliveSlots() << " " << gRenderTargetAllocator.PooledBytes() / bytesPerMB <<
+		"MB (peak " << gRenderTargetAllocator.PeakBytes() / bytesPerMB << ", avg " << gRenderTargetAllocator.AverageBytes() / bytesPerMB << ")";
+
+	stats << ", Scene draws: " << gLastFrameMeshDraws.draws << " (" << gLastFrameMeshDraws.instances << " copies)";
+
+	// Options switched on
+	if (gDepthPrePass)          stats << ", Depth pre-pass";
+	if (gUseColourLUTs)         stats << ", Colour LUTs";
+	if (gUseComputeTiles)       stats << ", Compute tiles";
+	if (gUseReducedResolution)  stats << ", Reduced resolution";
+	if (gUseTemporalAccumulation)
+	{
+		// Share of the texture reads saved by temporal accumulation
+		TemporalSampleReport samples = ReportTemporalSamples(gPostProcessGraph, gViewportWidth, gViewportHeight);
+		stats << ", Temporal: " << static_cast<int>(samples.Savings() * 100.0 + 0.5) << "% fewer reads";
+	}
+	if (gPaletteDither)         stats << ", Dither";
+
+	// Effect sizes
+	stats << ", Blur sigma: " << static_cast<int>(gBlurSigma) << " (" << GaussianBlurLevels(gBlurSigma) << " halvings)" <<
+		", Filter radius: " << (gFilterRadius > 0 ? std::to_string(gFilterRadius) : std::string("original")) <<
+		", Star length: " << gLensStarLength << " (" << LensStarPasses(gLensStarLength) << " passes)";
+
+	// CPU time to submit the stress test crates in milliseconds
+	if (gStressMode != StressMode::Off)
+	{
+		stats.precision(2);
+		stats << (gStressMode == StressMode::Models ? ", Stress: models " : ", Stress: instanced ") << gLastFrameStressRenderTime * 1000 << "ms CPU";
+	}
+	return stats.str();
+}
+
+
 // Update models and camera. frameTime is the time passed since the last frame
 void UpdateScene(float frameTime)
 {
@@ -1417,12 +2496,12 @@ void UpdateScene(float frameTime)
 	}
 	if (KeyHit(Key_8)) 
 	{
-		AddPostProcessEffect(PostProcess::BrightPass, gSelectedPostProcessMode);
-		AddPostProcessEffect(PostProcess::GaussianBlurHorizontal, gSelectedPostProcessMode);
-		AddPostProcessEffect(PostProcess::GaussianBlurVertical, gSelectedPostProcessMode);
-		AddPostProcessEffect(PostProcess::LensStar, gSelectedPostProcessMode);
 		AddPostProcessEffect(PostProcess::Bloom, gSelectedPostProcessMode);
 	}
+	if (KeyHit(Key_Space))
+	{
+		AddPostProcessEffect(PostProcess::LensStar, gSelectedPostProcessMode);
+	}
 	if (KeyHit(Key_9))
 	{
 		AddPostProcessEffect(PostProcess::Tint, gSelectedPostProcessMode);
@@ -1492,7 +2571,10 @@ void UpdateScene(float frameTime)
 	}
 
 	// Update timer
-	gPostProcessingConstants.timer += frameTime;
+	gPostProcessPassConstants.timer += frameTime;
+
+	// Rotate the polygon used for polygon post-processing
+	gPolygonMatrix = MatrixRotationY(ToRadians(0.2f)) * gPolygonMatrix;
 
 	//***********
 
@@ -1510,6 +2592,47 @@ void UpdateScene(float frameTime)
 	// Toggle FPS limiting
 	if (KeyHit(Key_P))  lockFPS = !lockFPS;
 
+	// Toggle the depth pre-pass
+	if (KeyHit(Key_Z))  gDepthPrePass = !gDepthPrePass;
+
+	// Toggle colour LUTs
+	if (KeyHit(Key_N))  gUseColourLUTs = !gUseColourLUTs;
+
+	// Toggle compute tile versions of the neighbourhood effects
+	if (KeyHit(Key_Tab))  gUseComputeTiles = !gUseComputeTiles;
+
+	// Toggle running the smooth effects on a smaller image
+	if (KeyHit(Key_F6))  gUseReducedResolution = !gUseReducedResolution;
+
+	// Toggle spreading samples over several frames
+	if (KeyHit(Key_F7))  gUseTemporalAccumulation = !gUseTemporalAccumulation;
+
+	// Toggle dithering of the palette effects
+	if (KeyHit(Key_M))  gPaletteDither = !gPaletteDither;
+
+	// Widen / narrow the Gaussian blur
+	if (KeyHit(Key_E) && gBlurSigma < 128.0f)  gBlurSigma *= 2.0f;
+	if (KeyHit(Key_Q) && gBlurSigma > 1.0f)    gBlurSigma *= 0.5f;
+
+	// Grow / shrink the dilation and box blur, shrinking from a radius of 1 goes back to the original filters
+	if (KeyHit(Key_Period) && gFilterRadius < SLIDING_FILTER_MAX_RADIUS)  gFilterRadius = (gFilterRadius > 0) ? gFilterRadius * 2 : 1;
+	if (KeyHit(Key_Comma)  && gFilterRadius > 0)                          gFilterRadius /= 2;
+
+	// Lengthen / shorten the lens star's streaks
+	if (KeyHit(Key_Plus)  && gLensStarLength < 192)  gLensStarLength *= 2;
+	if (KeyHit(Key_Minus) && gLensStarLength > 3)    gLensStarLength /= 2;
+
+	// Cycle the stress test: off, a model for each crate, instanced crates
+	if (KeyHit(Key_X))
+	{
+		if      (gStressMode == StressMode::Off)     gStressMode = StressMode::Models;
+		else if (gStressMode == StressMode::Models)  gStressMode = StressMode::Instanced;
+		else                                         gStressMode = StressMode::Off;
+	}
+
+	// Toggle the frame statistics in the window title
+	if (KeyHit(Key_F8))  gShowStats = !gShowStats;
+
 	// Show frame time / FPS in the window title //
 	const float fpsUpdateTime = 0.5f; // How long between updates (in seconds)
 	static float totalFrameTime = 0;
@@ -1525,6 +2648,7 @@ void UpdateScene(float frameTime)
 		frameTimeMs << std::fixed << avgFrameTime * 1000;
 		std::string windowTitle = "CO3303 Week 14: Area Post Processing - Frame Time: " + frameTimeMs.str() +
 			"ms, FPS: " + std::to_string(static_cast<int>(1 / avgFrameTime + 0.5f));
+		if (gShowStats)  windowTitle += " - " + FormatFrameStats();
 		SetWindowTextA(gHWnd, windowTitle.c_str());
 		totalFrameTime = 0;
 		frameCount = 0;
@@ -18,8 +18,13 @@
 // Vertex and pixel shader DirectX objects
 ID3D11VertexShader*   gBasicTransformVertexShader = nullptr;
 ID3D11VertexShader*   gPixelLightingVertexShader  = nullptr;
+ID3D11VertexShader*   gPixelLightingInstancedVertexShader = nullptr;
+ID3D11PixelShader*    gPixelLightingInstancedPixelShader  = nullptr;
 ID3D11PixelShader*    gTintedTexturePixelShader   = nullptr;
 ID3D11PixelShader*    gPixelLightingPixelShader   = nullptr;
+ID3D11VertexShader*   gVelocityVertexShader          = nullptr;
+ID3D11VertexShader*   gVelocityInstancedVertexShader = nullptr;
+ID3D11PixelShader*    gVelocityPixelShader           = nullptr;
 
 
 //*******************************
@@ -27,6 +32,7 @@ ID3D11PixelShader*    gPixelLightingPixelShader   = nullptr;
 // These are also added to Shader.h
 ID3D11VertexShader* g2DQuadVertexShader    = nullptr;
 ID3D11VertexShader* g2DPolygonVertexShader = nullptr;
+ID3D11VertexShader* g2DPolygonBatchVertexShader = nullptr;
 ID3D11PixelShader*  gCopyPostProcess       = nullptr;
 ID3D11PixelShader*  gTintPostProcess       = nullptr;
 ID3D11PixelShader*  gGreyNoisePostProcess  = nullptr;
@@ -53,6 +59,24 @@ ID3D11PixelShader*  gGameBoyPostProcess = nullptr;
 ID3D11PixelShader*  gSepiaPostProcess = nullptr;
 ID3D11PixelShader*  gChromaticDistortionPostProcess = nullptr;
 ID3D11PixelShader*  gDilationPostProcess = nullptr;
+ID3D11PixelShader*  gPolygonBatchPostProcess = nullptr;
+ID3D11PixelShader*  gColourTransformPostProcess = nullptr;
+ID3D11PixelShader*  gUVRemapPostProcess = nullptr;
+ID3D11PixelShader*  gColourLUTPostProcess = nullptr;
+ID3D11PixelShader*  gResamplePostProcess = nullptr;
+ID3D11PixelShader*  gBloomDownsamplePostProcess = nullptr;
+ID3D11PixelShader*  gBloomUpsamplePostProcess = nullptr;
+ID3D11PixelShader*  gLensStarStreakPostProcess = nullptr;
+ID3D11PixelShader*  gDepthOfFieldCoCPostProcess = nullptr;
+ID3D11PixelShader*  gDepthOfFieldTilesPostProcess = nullptr;
+ID3D11PixelShader*  gDepthOfFieldGatherPostProcess = nullptr;
+ID3D11PixelShader*  gMotionBlurTilesPostProcess = nullptr;
+ID3D11PixelShader*  gReducedResolutionUpsamplePostProcess = nullptr;
+ID3D11PixelShader*  gTemporalResolvePostProcess = nullptr;
+ID3D11ComputeShader* gSlidingFilterComputeShader = nullptr;
+ID3D11ComputeShader* gWireframeComputeShader = nullptr;
+ID3D11ComputeShader* gGaussianHorizontalBlurComputeShader = nullptr;
+ID3D11ComputeShader* gGaussianVerticalBlurComputeShader = nullptr;
 
 //--------------------------------------------------------------------------------------
 // Shader creation / destruction
@@ -68,6 +92,11 @@ bool LoadShaders()
 	gPixelLightingVertexShader    = LoadVertexShader  ("PixelLighting_vs"   );
 	gTintedTexturePixelShader     = LoadPixelShader   ("TintedTexture_ps"   );
 	gPixelLightingPixelShader     = LoadPixelShader   ("PixelLighting_ps"   );
+	gPixelLightingInstancedVertexShader = LoadVertexShader("PixelLightingInstanced_vs");
+	gPixelLightingInstancedPixelShader  = LoadPixelShader ("PixelLightingInstanced_ps");
+	gVelocityVertexShader          = LoadVertexShader("Velocity_vs");
+	gVelocityInstancedVertexShader = LoadVertexShader("VelocityInstanced_vs");
+	gVelocityPixelShader           = LoadPixelShader ("Velocity_ps");
 
 	//***************************************
 	//**** Post processing shaders
@@ -100,9 +129,29 @@ bool LoadShaders()
 	gSepiaPostProcess = LoadPixelShader ("Sepia_pp");
 	gChromaticDistortionPostProcess = LoadPixelShader ("ChromaticDistortion_pp");
 	gDilationPostProcess = LoadPixelShader ("Dilation_pp");
+	g2DPolygonBatchVertexShader = LoadVertexShader("2DPolygonBatch_pp");
+	gPolygonBatchPostProcess = LoadPixelShader ("PolygonBatch_pp");
+	gColourTransformPostProcess = LoadPixelShader ("ColourTransform_pp");
+	gColourLUTPostProcess = LoadPixelShader ("ColourLUT_pp");
+	gUVRemapPostProcess = LoadPixelShader ("UVRemap_pp");
+	gResamplePostProcess = LoadPixelShader ("Resample_pp");
+	gBloomDownsamplePostProcess = LoadPixelShader ("BloomDownsample_pp");
+	gBloomUpsamplePostProcess = LoadPixelShader ("BloomUpsample_pp");
+	gLensStarStreakPostProcess = LoadPixelShader ("LensStarStreak_pp");
+	gDepthOfFieldCoCPostProcess = LoadPixelShader ("DepthOfFieldCoC_pp");
+	gDepthOfFieldTilesPostProcess = LoadPixelShader ("DepthOfFieldTiles_pp");
+	gDepthOfFieldGatherPostProcess = LoadPixelShader ("DepthOfFieldGather_pp");
+	gMotionBlurTilesPostProcess = LoadPixelShader ("MotionBlurTiles_pp");
+	gReducedResolutionUpsamplePostProcess = LoadPixelShader ("ReducedResolutionUpsample_pp");
+	gTemporalResolvePostProcess = LoadPixelShader ("TemporalResolve_pp");
+	gSlidingFilterComputeShader = LoadComputeShader("SlidingFilter_cs");
+	gWireframeComputeShader = LoadComputeShader("Wireframe_cs");
+	gGaussianHorizontalBlurComputeShader = LoadComputeShader("GaussianHorizontalBlur_cs");
+	gGaussianVerticalBlurComputeShader = LoadComputeShader("GaussianVerticalBlur_cs");
 
 	if (gBasicTransformVertexShader == nullptr || gPixelLightingVertexShader == nullptr ||
 		gTintedTexturePixelShader   == nullptr || gPixelLightingPixelShader  == nullptr ||
+		gPixelLightingInstancedVertexShader == nullptr || gPixelLightingInstancedPixelShader == nullptr ||
 		g2DQuadVertexShader         == nullptr || gCopyPostProcess           == nullptr ||
 		gTintPostProcess            == nullptr || gHeatHazePostProcess       == nullptr ||
 		gGreyNoisePostProcess       == nullptr || gBurnPostProcess           == nullptr ||
@@ -116,7 +165,17 @@ bool LoadShaders()
 		gWireframePostProcess		== nullptr || gFogPostProcess			 == nullptr || 
 		gInvertPostProcess			== nullptr || gNightVisionPostProcess	 == nullptr ||
 		gGameBoyPostProcess			== nullptr || gSepiaPostProcess			 == nullptr ||
-		gChromaticDistortionPostProcess == nullptr || gDilationPostProcess	 == nullptr )
+		gChromaticDistortionPostProcess == nullptr || gDilationPostProcess	 == nullptr ||
+		g2DPolygonBatchVertexShader == nullptr || gPolygonBatchPostProcess	 == nullptr ||
+		gColourTransformPostProcess == nullptr || gColourLUTPostProcess	 == nullptr ||
+		gResamplePostProcess        == nullptr || gSlidingFilterComputeShader == nullptr || gUVRemapPostProcess == nullptr ||
+		gWireframeComputeShader     == nullptr || gGaussianHorizontalBlurComputeShader == nullptr ||
+		gGaussianVerticalBlurComputeShader == nullptr || gBloomDownsamplePostProcess == nullptr ||
+		gBloomUpsamplePostProcess   == nullptr || gReducedResolutionUpsamplePostProcess == nullptr ||
+		gDepthOfFieldCoCPostProcess == nullptr || gDepthOfFieldTilesPostProcess == nullptr || gDepthOfFieldGatherPostProcess == nullptr ||
+		gVelocityVertexShader       == nullptr || gVelocityInstancedVertexShader == nullptr ||
+		gVelocityPixelShader        == nullptr || gMotionBlurTilesPostProcess == nullptr ||
+		gTemporalResolvePostProcess == nullptr || gLensStarStreakPostProcess == nullptr)
 	{
 		gLastError = "Error loading shaders";
 		return false;
@@ -140,6 +199,8 @@ void ReleaseShaders()
 	if (gPixelLightingPixelShader)    gPixelLightingPixelShader  ->Release();
 	if (gTintedTexturePixelShader)    gTintedTexturePixelShader  ->Release();
 	if (gPixelLightingVertexShader)   gPixelLightingVertexShader ->Release();
+	if (gPixelLightingInstancedPixelShader)   gPixelLightingInstancedPixelShader ->Release();
+	if (gPixelLightingInstancedVertexShader)  gPixelLightingInstancedVertexShader->Release();
 	if (gBasicTransformVertexShader)  gBasicTransformVertexShader->Release();	
 	if (gVerticalGradientPostProcess) gVerticalGradientPostProcess->Release();
 	if (gBlurPostProcess)			  gBlurPostProcess->Release();
@@ -160,6 +221,28 @@ void ReleaseShaders()
 	if (gSepiaPostProcess)			  gSepiaPostProcess->Release();
 	if (gChromaticDistortionPostProcess)	  gChromaticDistortionPostProcess->Release();
 	if (gDilationPostProcess)		  gDilationPostProcess->Release();
+	if (gPolygonBatchPostProcess)	  gPolygonBatchPostProcess->Release();
+	if (g2DPolygonBatchVertexShader)  g2DPolygonBatchVertexShader->Release();
+	if (gColourTransformPostProcess)  gColourTransformPostProcess->Release();
+	if (gColourLUTPostProcess)        gColourLUTPostProcess->Release();
+	if (gUVRemapPostProcess)          gUVRemapPostProcess->Release();
+	if (gResamplePostProcess)         gResamplePostProcess->Release();
+	if (gBloomDownsamplePostProcess)  gBloomDownsamplePostProcess->Release();
+	if (gBloomUpsamplePostProcess)    gBloomUpsamplePostProcess->Release();
+	if (gLensStarStreakPostProcess)   gLensStarStreakPostProcess->Release();
+	if (gDepthOfFieldCoCPostProcess)    gDepthOfFieldCoCPostProcess->Release();
+	if (gDepthOfFieldTilesPostProcess)  gDepthOfFieldTilesPostProcess->Release();
+	if (gDepthOfFieldGatherPostProcess) gDepthOfFieldGatherPostProcess->Release();
+	if (gMotionBlurTilesPostProcess)    gMotionBlurTilesPostProcess->Release();
+	if (gVelocityPixelShader)           gVelocityPixelShader->Release();
+	if (gVelocityInstancedVertexShader) gVelocityInstancedVertexShader->Release();
+	if (gVelocityVertexShader)          gVelocityVertexShader->Release();
+	if (gReducedResolutionUpsamplePostProcess)  gReducedResolutionUpsamplePostProcess->Release();
+	if (gTemporalResolvePostProcess)            gTemporalResolvePostProcess->Release();
+	if (gSlidingFilterComputeShader)  gSlidingFilterComputeShader->Release();
+	if (gWireframeComputeShader)      gWireframeComputeShader->Release();
+	if (gGaussianHorizontalBlurComputeShader)  gGaussianHorizontalBlurComputeShader->Release();
+	if (gGaussianVerticalBlurComputeShader)    gGaussianVerticalBlurComputeShader->Release();
 }
 
 
@@ -302,6 +385,40 @@ ID3D11PixelShader* LoadPixelShader(std::string shaderName)
 }
 
 
+// Load a compute shader, include the file in the project and pass the name (without the .hlsl extension)
+// to this function. The returned pointer needs to be released before quitting. Returns nullptr on failure. 
+// Basically the same code as above but for compute shaders
+ID3D11ComputeShader* LoadComputeShader(std::string shaderName)
+{
+	// Open compiled shader object file
+	std::ifstream shaderFile(shaderName + ".cso", std::ios::in | std::ios::binary | std::ios::ate);
+	if (!shaderFile.is_open())
+	{
+		return nullptr;
+	}
+
+	// Read file into vector of chars
+	std::streamoff fileSize = shaderFile.tellg();
+	shaderFile.seekg(0, std::ios::beg);
+	std::vector<char>byteCode(fileSize);
+	shaderFile.read(&byteCode[0], fileSize);
+	if (shaderFile.fail())
+	{
+		return nullptr;
+	}
+
+	// Create shader object from loaded file (we will use the object later when rendering)
+	ID3D11ComputeShader* shader;
+	HRESULT hr = gD3DDevice->CreateComputeShader(byteCode.data(), byteCode.size(), nullptr, &shader);
+	if (FAILED(hr))
+	{
+		return nullptr;
+	}
+
+	return shader;
+}
+
+
 
 // Very advanced topic: When creating a vertex layout for geometry (see Scene.cpp), you need the signature
 // (bytecode) of a shader that uses that vertex layout. This is an annoying requirement and tends to create
@@ -379,3 +496,35 @@ ID3D11Buffer* CreateConstantBuffer(int size)
 }
 
 
+// Structured buffers hold an array of structures that shaders can read by index, which allows far more data than a
+// constant buffer. Used here to send the polygons for batched polygon post-processing (see PolygonBatch.h)
+ID3D11Buffer* CreateStructuredBuffer(int elementSize, int numElements, ID3D11ShaderResourceView** bufferSRV)
+{
+	D3D11_BUFFER_DESC sbDesc;
+	sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	sbDesc.ByteWidth = elementSize * numElements;
+	sbDesc.Usage = D3D11_USAGE_DYNAMIC;                   // Updated every frame, as constant buffers above
+	sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	sbDesc.StructureByteStride = elementSize;             // Size of each structure, must match the structure in the shader
+	ID3D11Buffer* structuredBuffer;
+	if (FAILED(gD3DDevice->CreateBuffer(&sbDesc, nullptr, &structuredBuffer)))
+	{
+		return nullptr;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN; // Structured buffers have no format
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = numElements;
+	if (FAILED(gD3DDevice->CreateShaderResourceView(structuredBuffer, &srvDesc, bufferSRV)))
+	{
+		structuredBuffer->Release();
+		return nullptr;
+	}
+
+	return structuredBuffer;
+}
+
+
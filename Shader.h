@@ -20,11 +20,17 @@ extern ID3D11VertexShader*   gBasicTransformVertexShader;
 extern ID3D11VertexShader*   gPixelLightingVertexShader;
 extern ID3D11PixelShader*    gTintedTexturePixelShader;
 extern ID3D11PixelShader*    gPixelLightingPixelShader;
+extern ID3D11VertexShader*   gPixelLightingInstancedVertexShader; // Instanced versions of the two shaders above (see InstanceBatch.h)
+extern ID3D11PixelShader*    gPixelLightingInstancedPixelShader;
+extern ID3D11VertexShader*   gVelocityVertexShader;          // Write the scene's velocity buffer for motion blur (see MotionBlur.h)
+extern ID3D11VertexShader*   gVelocityInstancedVertexShader;
+extern ID3D11PixelShader*    gVelocityPixelShader;
 
 //*******************************
 //**** Post-processing shader DirectX objects
 extern ID3D11VertexShader* g2DQuadVertexShader;
 extern ID3D11VertexShader* g2DPolygonVertexShader;
+extern ID3D11VertexShader* g2DPolygonBatchVertexShader;
 extern ID3D11PixelShader*  gCopyPostProcess;
 extern ID3D11PixelShader*  gTintPostProcess;
 extern ID3D11PixelShader*  gGreyNoisePostProcess;
@@ -51,6 +57,24 @@ extern ID3D11PixelShader*  gGameBoyPostProcess;
 extern ID3D11PixelShader*  gSepiaPostProcess;
 extern ID3D11PixelShader*  gChromaticDistortionPostProcess;
 extern ID3D11PixelShader*  gDilationPostProcess;
+extern ID3D11PixelShader*  gPolygonBatchPostProcess;
+extern ID3D11PixelShader*  gColourTransformPostProcess;
+extern ID3D11PixelShader*  gColourLUTPostProcess;
+extern ID3D11PixelShader*  gUVRemapPostProcess; // Several distortions run as one (see UVRemap.h)
+extern ID3D11PixelShader*  gResamplePostProcess;
+extern ID3D11PixelShader*  gBloomDownsamplePostProcess; // The bloom's downsampled and upsampled images (see Bloom.h)
+extern ID3D11PixelShader*  gBloomUpsamplePostProcess;
+extern ID3D11PixelShader*  gLensStarStreakPostProcess; // The passes of the bloom's lens star streaks (see LensStar.h)
+extern ID3D11PixelShader*  gDepthOfFieldCoCPostProcess;    // The depth of field's passes before its composite (see DepthOfField.h)
+extern ID3D11PixelShader*  gDepthOfFieldTilesPostProcess;
+extern ID3D11PixelShader*  gDepthOfFieldGatherPostProcess;
+extern ID3D11PixelShader*  gMotionBlurTilesPostProcess; // Longest velocity in each tile of the screen (see MotionBlur.h)
+extern ID3D11PixelShader*  gReducedResolutionUpsamplePostProcess; // Finishes effects run on a smaller image (see RenderGraph.h)
+extern ID3D11PixelShader*  gTemporalResolvePostProcess; // Blends an effect's output with last frame's (see TemporalHistory.h)
+extern ID3D11ComputeShader* gSlidingFilterComputeShader; // Full screen dilation and box blur passes (see SlidingFilter.h)
+extern ID3D11ComputeShader* gWireframeComputeShader;     // Full screen neighbourhood effects a tile at a time (see ComputeTile.h)
+extern ID3D11ComputeShader* gGaussianHorizontalBlurComputeShader;
+extern ID3D11ComputeShader* gGaussianVerticalBlurComputeShader;
 
 
 
@@ -73,6 +97,11 @@ void ReleaseShaders();
 // The returned pointer needs to be released before quitting. Returns nullptr on failure
 ID3D11Buffer* CreateConstantBuffer(int size);
 
+// Create and return a structured buffer of the given number of elements, each of the given size, that the CPU updates
+// often. Also creates a shader resource view so shaders can read it. Both need to be released before quitting. Returns
+// nullptr on failure
+ID3D11Buffer* CreateStructuredBuffer(int elementSize, int numElements, ID3D11ShaderResourceView** bufferSRV);
+
 
 //--------------------------------------------------------------------------------------
 // Helper functions
@@ -83,6 +112,7 @@ ID3D11Buffer* CreateConstantBuffer(int size);
 ID3D11VertexShader*   LoadVertexShader  (std::string shaderName);
 ID3D11GeometryShader* LoadGeometryShader(std::string shaderName);
 ID3D11PixelShader*    LoadPixelShader   (std::string shaderName);
+ID3D11ComputeShader*  LoadComputeShader (std::string shaderName);
 
 // Special method to load a geometry shader that can use the stream-out stage, Use like the other functions in this file except
 // also pass the stream out declaration, number of entries in the declaration and the size of each output element. 
@@ -0,0 +1,19 @@
+//--------------------------------------------------------------------------------------
+// Sliding window filters - dilation and box blur at any radius
+//--------------------------------------------------------------------------------------
+
+#include "SlidingFilter.h"
+
+#include <algorithm>
+
+
+SlidingFilterConstants MakeSlidingFilterConstants(PostProcess postProcess, bool columns, const PostProcessEffectConstants& settings)
+{
+	SlidingFilterConstants constants = {};
+	bool isBlur = postProcess == PostProcess::OnePassBlur;
+	int radius = isBlur ? settings.onePassBlur.blurRadius : settings.dilation.kernelRadius;
+	constants.radius  = std::min(std::max(radius, 0), SLIDING_FILTER_MAX_RADIUS);
+	constants.columns = columns ? 1 : 0;
+	constants.average = isBlur ? 1 : 0;
+	return constants;
+}
@@ -0,0 +1,54 @@
+//--------------------------------------------------------------------------------------
+// Sliding window filters - dilation and box blur at any radius
+//--------------------------------------------------------------------------------------
+// The dilation takes the largest value in a square around each pixel, and the box blur the
+// average. Both can be split into a pass along the rows then one down the columns, since the
+// largest (or average) over a square is the largest (or average) of the results along each row
+// of it. The render graph runs full screen dilations, and box blurs whose taps are one pixel
+// apart, as these two passes (see RenderGraph::Compile), with a compute shader on the GPU (SlidingFilter_cs.hlsl) and whole rows
+// at a time on the CPU (CPUSlidingFilter.h). Area and polygon versions still use the pixel shaders,
+// which read every pixel of the square.
+//
+// Each pass costs the same per pixel whatever the radius (van Herk / Gil-Werman). The line is cut
+// into blocks the width of the window, 2 * radius + 1. Within each block a running result is kept
+// from the start of the block and another from the end. A window always covers the end of one
+// block and the start of the next, so its result is the first block's running result from the
+// window's left edge, combined with the next block's running result up to the window's right
+// edge - three steps per pixel rather than one for each pixel in the window. Blocks start at
+// multiples of the width along the whole line, so a pixel gets the same result whichever part
+// of the image is worked on with it.
+//
+// No DirectX here
+
+#ifndef _SLIDING_FILTER_H_INCLUDED_
+#define _SLIDING_FILTER_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Widest radius, in pixels. Must match MaxRadius in SlidingFilter_cs.hlsl
+const int SLIDING_FILTER_MAX_RADIUS = 64;
+
+// Pixels of a line written by each thread group of the compute shader. Must match LineChunk in SlidingFilter_cs.hlsl
+const int SLIDING_FILTER_LINE_CHUNK = 512;
+
+
+// True if full screen box blurs with the given settings run as sliding window passes. Only a true box (taps one pixel apart)
+// can - the original blur spreads a 3x3 square of taps two pixels apart, so runs as its pixel shader
+inline bool BoxBlurIsSliding(const OnePassBlurConstants& settings)
+{
+	return settings.tapSpacing <= 1;
+}
+
+// Settings for one pass of the given effect, which must be declared with slidingFilter, from the settings of the effect
+SlidingFilterConstants MakeSlidingFilterConstants(PostProcess postProcess, bool columns, const PostProcessEffectConstants& settings);
+
+// The block containing position p along a line, for blocks of the given width with one starting at 0
+inline int SlidingFilterBlock(int p, int width)
+{
+	return (p >= 0) ? p / width : -((width - 1 - p) / width);
+}
+
+
+#endif //_SLIDING_FILTER_H_INCLUDED_
@@ -0,0 +1,130 @@
+//--------------------------------------------------------------------------------------
+// Sliding Window Filter Compute Shader
+//--------------------------------------------------------------------------------------
+// One pass of a full screen dilation or box blur, along the rows or down the columns of the
+// image. Each thread group works on part of one line: it loads the part plus the radius either
+// side into group shared memory, keeps running results within blocks the width of the window,
+// then combines two of them for each pixel (see SlidingFilter.h). The cost per pixel is the
+// same whatever the radius.
+//--------------------------------------------------------------------------------------
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this pass, must match SlidingFilterConstants in PostProcessConstants.h
+cbuffer SlidingFilterConstants : register(b2)
+{
+	int gRadius;  // Pixels either side of the centre
+	int gColumns; // 0 to filter along the rows, 1 down the columns
+	int gAverage; // 0 for the largest value (dilation), 1 for the average (box blur)
+	int paddingA;
+}
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+Texture2D<float4>   InputTexture  : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+//--------------------------------------------------------------------------------------
+// Group shared memory
+//--------------------------------------------------------------------------------------
+
+// Must match SLIDING_FILTER_LINE_CHUNK and SLIDING_FILTER_MAX_RADIUS in SlidingFilter.h
+static const int LineChunk = 512; // Pixels written by each thread group
+static const int MaxRadius = 64;
+
+static const int NumThreads   = 256;
+static const int SharedPixels = LineChunk + 2 * MaxRadius;
+
+// Running results from the start of each block up to each pixel, and from each pixel to the end of its block
+groupshared float3 gForward[SharedPixels];
+groupshared float3 gBackward[SharedPixels];
+
+//--------------------------------------------------------------------------------------
+// Helper Functions
+//--------------------------------------------------------------------------------------
+
+float3 Combine(float3 a, float3 b)
+{
+    return gAverage ? a + b : max(a, b);
+}
+
+// Block containing position p along a line, for blocks of the given width with one starting at 0 (rounds down for negative p)
+int BlockOf(int p, int width)
+{
+    return (p >= 0) ? p / width : -((width - 1 - p) / width);
+}
+
+// Pixel at the given position along the given line
+int2 LinePixel(int lineIndex, int position)
+{
+    return gColumns ? int2(lineIndex, position) : int2(position, lineIndex);
+}
+
+//--------------------------------------------------------------------------------------
+// Shader Code
+//--------------------------------------------------------------------------------------
+
+// Dispatched with one group for each chunk along X and one for each line along Y
+[numthreads(NumThreads, 1, 1)]
+void main(uint3 groupID : SV_GroupID, uint threadIndex : SV_GroupIndex)
+{
+    uint imageWidth, imageHeight;
+    InputTexture.GetDimensions(imageWidth, imageHeight);
+    int lineLength = gColumns ? imageHeight : imageWidth;
+    int lineIndex = groupID.y;
+
+    int radius = clamp(gRadius, 0, MaxRadius);
+    int blockWidth = 2 * radius + 1;
+    int chunkStart = groupID.x * LineChunk;
+    int start = chunkStart - radius;       // Position along the line of the first pixel loaded
+    int numPixels = LineChunk + 2 * radius;
+
+    // Load the chunk and the radius either side, reads past the ends of the line give the end pixel
+    for (int i = threadIndex; i < numPixels; i += NumThreads)
+    {
+        float3 colour = InputTexture[LinePixel(lineIndex, clamp(start + i, 0, lineLength - 1))].rgb;
+        gForward[i]  = colour;
+        gBackward[i] = colour;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // One thread for each block, the first and last of which may be cut short by the ends of what was loaded. That only
+    // changes results that aren't used
+    int firstBlock = BlockOf(start, blockWidth);
+    int numBlocks  = BlockOf(start + numPixels - 1, blockWidth) - firstBlock + 1;
+    for (int block = threadIndex; block < numBlocks; block += NumThreads)
+    {
+        int blockStart = max((firstBlock + block) * blockWidth - start, 0);
+        int blockEnd   = min((firstBlock + block + 1) * blockWidth - start, numPixels);
+        for (int f = blockStart + 1; f < blockEnd; f++)
+        {
+            gForward[f] = Combine(gForward[f - 1], gForward[f]);
+        }
+        for (int b = blockEnd - 2; b >= blockStart; b--)
+        {
+            gBackward[b] = Combine(gBackward[b + 1], gBackward[b]);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // The window around each pixel covers the end of one block and the start of the next. A window that lines up with a
+    // block is all in the backward result, and for the box blur adding the forward result would count it twice
+    for (int j = threadIndex; j < LineChunk; j += NumThreads)
+    {
+        int position = chunkStart + j;
+        if (position >= lineLength)  break;
+
+        float3 windowStart = gBackward[j];
+        float3 windowEnd   = gForward[j + 2 * radius];
+        bool   aligned     = (position - radius) - BlockOf(position - radius, blockWidth) * blockWidth == 0;
+        float3 colour = (gAverage && aligned) ? windowStart : Combine(windowStart, windowEnd);
+        if (gAverage)  colour /= blockWidth;
+
+        OutputTexture[LinePixel(lineIndex, position)] = float4(colour, 1.0f);
+    }
+}
@@ -6,6 +6,18 @@
 #include "Common.hlsli"
 
 
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match SpiralConstants in PostProcessConstants.h
+cbuffer SpiralConstants : register(b2)
+{
+	float  gSpiralLevel;
+	float3 paddingA;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 // A sampler state object represents a way to filter textures, such as bilinear or trilinear. We have one object for each method we want to use
 ID3D11SamplerState* gPointSampler         = nullptr;
 ID3D11SamplerState* gTrilinearSampler     = nullptr;
+ID3D11SamplerState* gBilinearClampSampler = nullptr;
 ID3D11SamplerState* gAnisotropic4xSampler = nullptr;
 
 // Blend states allow us to switch between blending modes (none, additive, multiplicative etc.)
@@ -33,10 +34,12 @@ ID3D11BlendState* gAlphaBlendingState    = nullptr;
 ID3D11RasterizerState* gCullBackState  = nullptr;
 ID3D11RasterizerState* gCullFrontState = nullptr;
 ID3D11RasterizerState* gCullNoneState  = nullptr;
+ID3D11RasterizerState* gCullNoneScissorState = nullptr;
 
 // Depth-stencil states allow us change how the depth buffer is used
 ID3D11DepthStencilState* gUseDepthBufferState = nullptr;
 ID3D11DepthStencilState* gDepthReadOnlyState  = nullptr;
+ID3D11DepthStencilState* gDepthPrePassTestState = nullptr;
 ID3D11DepthStencilState* gNoDepthBufferState  = nullptr;
 
 
@@ -90,6 +93,23 @@ bool CreateStates()
 	}
 
 
+	////-------- Bilinear Sampling, clamped (post-process blurs reading between pixels) --------////
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT; // Bilinear filtering, no mip-maps
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;        // Clamp addressing, so blurs don't pull in the other side of the screen
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;        // --"--
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;        // --"--
+	samplerDesc.MaxAnisotropy = 1;
+
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	samplerDesc.MinLOD = 0;
+
+	if (FAILED(gD3DDevice->CreateSamplerState(&samplerDesc, &gBilinearClampSampler)))
+	{
+		gLastError = "Error creating bilinear clamp sampler";
+		return false;
+	}
+
+
 	////-------- Anisotropic filtering --------////
 	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC; // Trilinear filtering
 	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;    // Wrap addressing mode for texture coordinates outside 0->1
@@ -156,6 +176,18 @@ bool CreateStates()
         gLastError = "Error creating cull-none state";
         return false;
     }
+
+
+    ////-------- No culling, scissor test --------////
+    // As above but only draws inside the scissor rectangle - used by area and polygon post-processes
+    rasterizerDesc.ScissorEnable         = TRUE;
+
+    // Create a DirectX object for the description above that can be used by a shader
+    if (FAILED(gD3DDevice->CreateRasterizerState(&rasterizerDesc, &gCullNoneScissorState)))
+    {
+        gLastError = "Error creating cull-none scissor state";
+        return false;
+    }
 	
 	
     //--------------------------------------------------------------------------------------
@@ -264,6 +296,22 @@ bool CreateStates()
     }
 
 
+    ////-------- Test against depth from a pre-pass --------////
+    // Used for the colour pass after a depth-only pre-pass. The depth buffer already holds the nearest surfaces, so
+    // pass pixels that are equal to it (not just nearer) and don't write it again
+    depthStencilDesc.DepthEnable      = TRUE;
+    depthStencilDesc.DepthWriteMask   = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthStencilDesc.DepthFunc        = D3D11_COMPARISON_LESS_EQUAL;
+    depthStencilDesc.StencilEnable    = FALSE;
+
+    // Create a DirectX object for the description above that can be used by a shader
+    if (FAILED(gD3DDevice->CreateDepthStencilState(&depthStencilDesc, &gDepthPrePassTestState)))
+    {
+        gLastError = "Error creating depth-pre-pass-test state";
+        return false;
+    }
+
+
 	////-------- Disable depth buffer --------////
     depthStencilDesc.DepthEnable      = FALSE;
     depthStencilDesc.DepthWriteMask   = D3D11_DEPTH_WRITE_MASK_ALL;
@@ -286,14 +334,17 @@ void ReleaseStates()
 {
     if (gUseDepthBufferState)    gUseDepthBufferState->Release();
     if (gDepthReadOnlyState)     gDepthReadOnlyState->Release();
+    if (gDepthPrePassTestState)  gDepthPrePassTestState->Release();
     if (gNoDepthBufferState)     gNoDepthBufferState->Release();
     if (gCullBackState)          gCullBackState->Release();
     if (gCullFrontState)         gCullFrontState->Release();
+    if (gCullNoneScissorState)   gCullNoneScissorState->Release();
     if (gCullNoneState)          gCullNoneState->Release();
     if (gNoBlendingState)        gNoBlendingState->Release();
     if (gAlphaBlendingState)     gAlphaBlendingState->Release();
     if (gAdditiveBlendingState)  gAdditiveBlendingState->Release();
     if (gAnisotropic4xSampler)   gAnisotropic4xSampler->Release();
+    if (gBilinearClampSampler)   gBilinearClampSampler->Release();
     if (gTrilinearSampler)       gTrilinearSampler->Release();
     if (gPointSampler)           gPointSampler->Release();
 }
@@ -20,6 +20,7 @@
 // GPU "States" //
 extern ID3D11SamplerState* gPointSampler;
 extern ID3D11SamplerState* gTrilinearSampler;
+extern ID3D11SamplerState* gBilinearClampSampler;
 extern ID3D11SamplerState* gAnisotropic4xSampler;
 
 extern ID3D11BlendState* gNoBlendingState;
@@ -29,9 +30,11 @@ extern ID3D11BlendState* gAlphaBlendingState;
 extern ID3D11RasterizerState*   gCullBackState;
 extern ID3D11RasterizerState*   gCullFrontState;
 extern ID3D11RasterizerState*   gCullNoneState;
+extern ID3D11RasterizerState*   gCullNoneScissorState;
 
 extern ID3D11DepthStencilState* gUseDepthBufferState;
 extern ID3D11DepthStencilState* gDepthReadOnlyState;
+extern ID3D11DepthStencilState* gDepthPrePassTestState;
 extern ID3D11DepthStencilState* gNoDepthBufferState;
 
 
@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// Temporal accumulation - spreading an effect's samples over several frames
+//--------------------------------------------------------------------------------------
+
+#include "TemporalHistory.h"
+#include "DepthOfField.h"
+
+#include <algorithm>
+
+
+CMatrix4x4 MakeReprojectionMatrix(const CMatrix4x4& viewMatrix, const CMatrix4x4& projectionMatrix,
+                                  const CMatrix4x4& previousViewProjectionMatrix)
+{
+	// The projection matrices made by the camera only have five values that aren't 0 or 1: x and y scales, and two values
+	// mapping view space z to depth (z' = z * a + b, w' = z). Their inverse is quick to write out directly
+	const CMatrix4x4& p = projectionMatrix;
+	CMatrix4x4 inverseProjection = { 1.0f / p.e00, 0.0f,         0.0f,          0.0f,
+	                                 0.0f,         1.0f / p.e11, 0.0f,          0.0f,
+	                                 0.0f,         0.0f,         0.0f,          1.0f / p.e32,
+	                                 0.0f,         0.0f,         1.0f,         -p.e22 / p.e32 };
+
+	// Clip space back to world space this frame, then forward to clip space last frame
+	return inverseProjection * InverseAffine(viewMatrix) * previousViewProjectionMatrix;
+}
+
+
+TemporalResolveConstants MakeTemporalResolveConstants(const TemporalResolveConstants& settings, int temporalFrames,
+                                                      bool historyValid)
+{
+	TemporalResolveConstants constants = settings;
+
+	// An exponential average over about as many frames as the samples are spread over
+	constants.currentWeight = 1.0f / std::max(temporalFrames, 1);
+	constants.historyValid  = historyValid ? 1 : 0;
+	return constants;
+}
+
+
+TemporalSampleReport ReportTemporalSamples(const RenderGraph& graph, int viewportWidth, int viewportHeight)
+{
+	TemporalSampleReport report;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.temporalFrames <= 1)  continue;
+
+		int sizeDivisor = graph.Resource(pass.output).sizeDivisor;
+		double pixels = static_cast<double>(std::max(viewportWidth / sizeDivisor, 1)) * std::max(viewportHeight / sizeDivisor, 1);
+		if (pass.type == RenderPassType::DepthOfFieldFar || pass.type == RenderPassType::DepthOfFieldNear)
+		{
+			++report.temporalPasses;
+			report.fullSamples  += pixels * DepthOfFieldGatherTaps(1);
+			report.takenSamples += pixels * DepthOfFieldGatherTaps(pass.temporalFrames);
+		}
+		else if (pass.type == RenderPassType::TemporalResolve)
+		{
+			report.takenSamples += pixels * TEMPORAL_RESOLVE_SAMPLES;
+		}
+	}
+	return report;
+}
@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------------------
+// Temporal accumulation - spreading an effect's samples over several frames
+//--------------------------------------------------------------------------------------
+// Effects such as the depth of field gathers read dozens of taps for every pixel, and work them all
+// out again every frame even when the view hardly changes. An effect declared with temporalFrames
+// (see PostProcessDeclaration) can instead take only a share of its taps each frame, a different
+// share each frame, and have the frames before fill in the rest. When the render graph is compiled
+// with temporal accumulation (see RenderGraph::Compile) such an effect is followed by two passes:
+//
+// - Resolve (TemporalResolve_pp.hlsl): the history - the resolved image of the last frame with its
+//   view space depth in alpha - is reprojected to this frame. Each pixel's position is rebuilt from
+//   the scene depth and taken through the camera's inverse view-projection matrix and last frame's
+//   view-projection matrix (see MakeReprojectionMatrix), giving where it was on screen last frame.
+//   The effect's new output is blended into the history found there. The history is thrown away
+//   where it can't be trusted: off screen last frame, or holding a depth that doesn't match where
+//   the pixel was (something else was in front of it, a disocclusion). What is left is clamped to
+//   the range of colours around the pixel in the new output, which rejects stale colours left by
+//   moving objects and changing lighting without needing their velocity.
+// - A copy of the resolved image to the history, ready for the next frame.
+//
+// The history is a 16-bit float image so the small per-frame changes of the blend aren't lost to
+// rounding. Only one effect in a chain keeps a history, the first full screen one declared with
+// temporalFrames - any others take all of their samples every frame. ReportTemporalSamples counts
+// the texture reads saved each frame. The CPU versions are in CPUTemporal.h. No DirectX here
+
+#ifndef _TEMPORAL_HISTORY_H_INCLUDED_
+#define _TEMPORAL_HISTORY_H_INCLUDED_
+
+#include "PostProcessConstants.h"
+#include "RenderGraph.h"
+#include "CMatrix4x4.h"
+
+
+// History is rejected where its depth differs from the depth the pixel had last frame by more than this fraction of it
+const float TEMPORAL_DEPTH_TOLERANCE = 0.05f;
+
+// Texture reads made by the resolve for each pixel: the 3x3 neighbourhood of the new output, the scene depth and the four
+// history pixels blended by bilinear filtering
+const int TEMPORAL_RESOLVE_SAMPLES = 14;
+
+
+// Matrix taking a position in clip space this frame to where it was in clip space last frame, for a camera that hasn't
+// changed its projection. Positions are rows as in the rest of the app, i.e. previousClip = clip * matrix
+CMatrix4x4 MakeReprojectionMatrix(const CMatrix4x4& viewMatrix, const CMatrix4x4& projectionMatrix,
+                                  const CMatrix4x4& previousViewProjectionMatrix);
+
+// Settings for a resolve pass of an effect whose samples are spread over the given number of frames. The reprojection, clip
+// distances, frame index and clamping come from the given settings, historyValid should be false when the history doesn't
+// hold the last frame of the same chain (e.g. the first frame after the chain changed)
+TemporalResolveConstants MakeTemporalResolveConstants(const TemporalResolveConstants& settings, int temporalFrames,
+                                                      bool historyValid);
+
+
+// Texture reads made each frame by the passes of a compiled graph that take part in temporal accumulation. Counts the
+// most they can make, e.g. as if all of the depth of field is out of focus
+struct TemporalSampleReport
+{
+	int    temporalPasses = 0; // Passes taking only a share of their samples each frame
+	double fullSamples    = 0; // Reads those passes would make each frame without temporal accumulation
+	double takenSamples   = 0; // Reads they make with it, plus the reads of the resolve passes
+
+	// Fraction of the reads saved, negative if the resolve costs more than it saves
+	double Savings() const  { return fullSamples > 0 ? 1.0 - takenSamples / fullSamples : 0.0; }
+};
+
+TemporalSampleReport ReportTemporalSamples(const RenderGraph& graph, int viewportWidth, int viewportHeight);
+
+
+#endif //_TEMPORAL_HISTORY_H_INCLUDED_
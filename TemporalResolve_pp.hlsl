@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------------------
+// Temporal Resolve Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Blends the output of an effect that took only a share of its samples this frame into its history,
+// the image this shader wrote last frame (see TemporalHistory.h). The pixel's position is rebuilt
+// from the scene depth and reprojected to where it was on screen last frame. History found there is
+// kept unless it was off screen, or holds a depth that doesn't match the pixel's depth last frame
+// (the pixel was hidden behind something). It is also clamped to the range of colours around the
+// pixel in the new output, so colours that no longer appear nearby can't linger.
+//
+// Writes the blended colour with the pixel's view space depth in alpha, for the next frame's history
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this pass, must match TemporalResolveConstants in PostProcessConstants.h
+cbuffer TemporalResolveConstants : register(b2)
+{
+	float4x4 gReprojection; // Clip space this frame to clip space last frame
+	float    gNearClip;
+	float    gFarClip;
+	float    gCurrentWeight;  // Share of the new output in the blend where the history is kept
+	float    gDepthTolerance; // History is rejected where its depth differs by more than this fraction
+	int      gHistoryValid;
+	int      gNeighbourhoodClamp;
+	int      gFrameIndex;
+	int      padding;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    CurrentTexture : register(t0); // The effect's output this frame
+Texture2D    HistoryTexture : register(t1); // Last frame's result, with its view space depth in alpha
+Texture2D    DepthTexture   : register(t2); // The scene depth
+SamplerState LinearSample   : register(s1); // Bilinear filtering, clamped at the edges
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	int2 viewportSize;
+	CurrentTexture.GetDimensions(viewportSize.x, viewportSize.y);
+	int2 pixel = int2(input.projectedPosition.xy);
+
+	// The range of the new output around this pixel
+	float3 current = CurrentTexture.Load(int3(pixel, 0)).rgb;
+	float3 nearMin = current;
+	float3 nearMax = current;
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			float3 nearColour = CurrentTexture.Load(int3(clamp(pixel + int2(x, y), int2(0, 0), viewportSize - 1), 0)).rgb;
+			nearMin = min(nearMin, nearColour);
+			nearMax = max(nearMax, nearColour);
+		}
+	}
+
+	// Rebuild the pixel's clip space position from its depth - w is the view space depth - and find it last frame
+	float depth = DepthTexture.Load(int3(pixel, 0)).r;
+	float viewDepth = (gNearClip * gFarClip) / (gFarClip - depth * (gFarClip - gNearClip));
+	float2 ndc = input.sceneUV * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+	float4 previousClip = mul(gReprojection, float4(ndc, depth, 1.0f) * viewDepth);
+	float2 previousUV = previousClip.xy / previousClip.w * float2(0.5f, -0.5f) + 0.5f;
+
+	float weight = 1.0f;
+	float3 history = current;
+	if (gHistoryValid && all(previousUV >= 0.0f) && all(previousUV <= 1.0f))
+	{
+		float4 historyPixel = HistoryTexture.Sample(LinearSample, previousUV);
+		if (abs(historyPixel.a - previousClip.w) <= gDepthTolerance * previousClip.w)
+		{
+			history = gNeighbourhoodClamp ? clamp(historyPixel.rgb, nearMin, nearMax) : historyPixel.rgb;
+			weight  = gCurrentWeight;
+		}
+	}
+
+	return float4(lerp(history, current, weight), viewDepth);
+}
@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------
+// Tests of bloom as a chain of smaller images (Bloom.h, CPUBloom.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "Bloom.h"
+#include "LensStar.h"
+
+#include <cmath>
+
+
+static const PostProcessChain FULLSCREEN_BLOOM = { { PostProcess::Bloom, PostProcessMode::Fullscreen } };
+
+
+static float Brightness(const CVector4& colour)
+{
+	return colour.x + colour.y + colour.z;
+}
+
+
+TEST(CPUBloomGraphPasses)
+{
+	// One chain entry makes the downsamples from half size, the upsamples back to half size, the lens star at quarter size and
+	// the composite
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_BLOOM);
+	int downsamples = 0, upsamples = 0, streakPasses = 0, composites = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		int sizeDivisor = (pass.output >= 0) ? graph.Resource(pass.output).sizeDivisor : 0;
+		if (pass.type == RenderPassType::BloomDownsample)
+		{
+			++downsamples;
+			CHECK_EQUAL(2 << (downsamples - 1), sizeDivisor);
+			CHECK(graph.Resource(pass.output).format == TargetFormat::RGBA16F);
+		}
+		else if (pass.type == RenderPassType::BloomUpsample)
+		{
+			++upsamples;
+			CHECK(sizeDivisor >= 2 && sizeDivisor <= 1 << (BLOOM_LEVELS - 1));
+		}
+		else if (pass.type == RenderPassType::LensStarStreak)
+		{
+			++streakPasses;
+			CHECK_EQUAL(BLOOM_STAR_SIZE_DIVISOR, sizeDivisor);
+		}
+		else if (pass.type == RenderPassType::PostProcess && pass.effect == PostProcess::Bloom)
+		{
+			++composites;
+		}
+	}
+	CHECK_EQUAL(BLOOM_LEVELS, downsamples);
+	CHECK_EQUAL(BLOOM_LEVELS - 1, upsamples);
+	CHECK(streakPasses >= LENS_STAR_STREAKS);
+	CHECK_EQUAL(1, composites);
+}
+
+
+TEST(CPUBloomDarkSceneUnchanged)
+{
+	// Nothing is above the bright pass threshold, so there is no glow or star to add
+	TestFrame test(128, 96);
+	test.mScene.Fill(CVector4(0.2f, 0.3f, 0.1f, 1.0f));
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_BLOOM, test.mFrame, output);
+	CHECK(MaxDifference(test.mScene, output) <= 1);
+}
+
+
+TEST(CPUBloomBrightSpotGlows)
+{
+	// A bright spot in a black scene glows around it, evenly on each side, fading with distance
+	TestFrame test(128, 128);
+	test.mScene.Fill(CVector4(0.0f, 0.0f, 0.0f, 1.0f));
+	for (int y = 60; y < 68; ++y)
+	{
+		for (int x = 60; x < 68; ++x)  test.mScene.Pixel(x, y) = CVector4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_BLOOM, test.mFrame, output);
+	CHECK(AllFinite(output));
+
+	float nearSpot = Brightness(output.Pixel(52, 64));
+	float farAway  = Brightness(output.Pixel(4, 4));
+	CHECK(nearSpot > 0.02f);
+	CHECK(nearSpot > farAway);
+	CHECK(std::fabs(Brightness(output.Pixel(52, 64)) - Brightness(output.Pixel(75, 64))) < 0.05f);
+	CHECK(std::fabs(Brightness(output.Pixel(64, 52)) - Brightness(output.Pixel(64, 75))) < 0.05f);
+}
+
+
+TEST(CPUBloomThreadsAgree)
+{
+	TestFrame test(160, 90, TestScene::Smooth);
+	CPUPostProcessDevice oneThread(1), fourThreads(4);
+	CPUImage a, b;
+	oneThread.Run(FULLSCREEN_BLOOM, test.mFrame, a);
+	fourThreads.Run(FULLSCREEN_BLOOM, test.mFrame, b);
+	CHECK_EQUAL(0, MaxDifference(a, b));
+}
@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------------------
+// Tests of baking pure colour effects into colour LUTs (CPU/CPUColourLUT.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "CPUColourLUT.h"
+
+
+static const PostProcess LUT_EFFECTS[] = { PostProcess::Tint, PostProcess::Invert, PostProcess::Sepia };
+
+
+TEST(CPUColourLUTBakesOnlyWhenSettingsChange)
+{
+	PostProcessEffectConstants settings = DefaultPostProcessEffectConstants(640, 360, 1.0f, 10000.0f);
+	ColourLUT lut;
+	CHECK(lut.Update(PostProcess::Tint, settings));
+	CHECK(!lut.Update(PostProcess::Tint, settings));
+	CHECK_EQUAL(1, lut.NumBakes());
+	CHECK_EQUAL(COLOUR_LUT_SIZE * COLOUR_LUT_SIZE * COLOUR_LUT_SIZE, static_cast<int>(lut.Entries().size()));
+
+	settings.tint.tintColour.x *= 0.5f;
+	CHECK(lut.Update(PostProcess::Tint, settings));
+	CHECK(lut.Update(PostProcess::Invert, settings));
+	CHECK_EQUAL(3, lut.NumBakes());
+
+	// The entry at the top corner is white inverted
+	const CVector4& white = lut.Entries().back();
+	CHECK(white.x == 0.0f && white.y == 0.0f && white.z == 0.0f);
+}
+
+
+TEST(CPUColourLUTWithinOneStep)
+{
+	// Every declared effect run from its LUT over random colours is within one 8-bit step of the effect itself
+	TestFrame test(128, 128);
+	test.mFrame.effectConstants.tint.tintColour = { 1.2f, 0.7f, 0.3f }; // Past 1, so the target's clamp is tested
+	CPUPostProcessDevice direct(2), fromLUT(2);
+	fromLUT.SetColourLUTs(true);
+	for (PostProcess effect : LUT_EFFECTS)
+	{
+		CPUImage directOutput, lutOutput;
+		direct.Run({ { effect, PostProcessMode::Fullscreen } }, test.mFrame, directOutput);
+		fromLUT.Run({ { effect, PostProcessMode::Fullscreen } }, test.mFrame, lutOutput);
+		CHECK(fromLUT.FindColourLUT(effect) != nullptr);
+		CHECK(MaxDifference(directOutput, lutOutput) <= 1);
+	}
+	CHECK(direct.FindColourLUT(PostProcess::Tint) == nullptr);
+}
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------------------
+// Tests of the compute tile versions of neighbourhood effects (ComputeTile.h, CPUComputeTile.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "ComputeTile.h"
+#include "GaussianKernel.h"
+
+
+static const std::vector<PostProcess> TILED_EFFECTS = { PostProcess::Wireframe, PostProcess::GaussianBlurHorizontal,
+                                                        PostProcess::GaussianBlurVertical };
+
+
+static int CountComputeTilePasses(const RenderGraph& graph)
+{
+	int count = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.type == RenderPassType::ComputeTile)  ++count;
+	}
+	return count;
+}
+
+
+TEST(CPUComputeTileGraphPasses)
+{
+	// Only full screen passes of the tiled effects, and only when switched on - including the blurs in a blur pyramid
+	PostProcessChain chain = { { PostProcess::Wireframe, PostProcessMode::Fullscreen },
+	                           { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen },
+	                           { PostProcess::GaussianBlurVertical, PostProcessMode::Fullscreen },
+	                           { PostProcess::Wireframe, PostProcessMode::Area } };
+	RenderGraph graph;
+	graph.Compile(chain);
+	CHECK_EQUAL(0, CountComputeTilePasses(graph));
+
+	graph.Compile(chain, 0, true);
+	CHECK_EQUAL(3, CountComputeTilePasses(graph));
+
+	graph.Compile(chain, GaussianBlurLevels(32.0f), true);
+	CHECK_EQUAL(3, CountComputeTilePasses(graph));
+}
+
+
+TEST(CPUComputeTileAprons)
+{
+	// The wireframe reads its step beyond the tile, the blurs their furthest tap and the pixel after it, along their direction
+	PostProcessEffectConstants settings = DefaultPostProcessEffectConstants(256, 128, 1.0f, 1000.0f);
+	SetGaussianBlurKernel(settings.gaussianBlur, 1);
+	PostProcessPassConstants passConstants = {};
+	passConstants.texelSize = { 2.0f / 256.0f, 2.0f / 128.0f };
+
+	ComputeTileShape wireframe = GetComputeTileShape(PostProcess::Wireframe, settings, passConstants, 256, 128);
+	CHECK(wireframe.apronX >= 2 && wireframe.apronY >= 2);
+	CHECK(wireframe.apronX <= COMPUTE_TILE_MAX_WIREFRAME_STEP);
+
+	ComputeTileShape horizontal = GetComputeTileShape(PostProcess::GaussianBlurHorizontal, settings, passConstants, 256, 128);
+	CHECK(horizontal.apronX > 0 && horizontal.apronX <= COMPUTE_TILE_MAX_BLUR_APRON);
+	CHECK_EQUAL(0, horizontal.apronY);
+
+	ComputeTileShape vertical = GetComputeTileShape(PostProcess::GaussianBlurVertical, settings, passConstants, 256, 128);
+	CHECK_EQUAL(0, vertical.apronX);
+	CHECK(vertical.apronY > 0 && vertical.apronY <= COMPUTE_TILE_MAX_BLUR_APRON);
+
+	// Enough groups to cover an image that isn't a whole number of tiles
+	CHECK(ComputeTileGroupsX(horizontal, 250) * horizontal.width >= 250);
+	CHECK(ComputeTileGroupsY(vertical, 125) * vertical.height >= 125);
+}
+
+
+TEST(CPUComputeTileMatchesPixelShaders)
+{
+	// The wireframe exactly, the blurs within an 8-bit step, on an image that isn't a whole number of tiles
+	TestFrame test(100, 70);
+	for (float sigma : { 1.0f, GAUSSIAN_MAX_LEVEL_SIGMA })
+	{
+		test.mFrame.effectConstants.gaussianBlur.blurSigma = sigma;
+		std::vector<CPUComputeTileTiming> timings = MeasureComputeTiles(TILED_EFFECTS, test.mFrame, 2, 1);
+		CHECK_EQUAL(3, static_cast<int>(timings.size()));
+		for (const CPUComputeTileTiming& timing : timings)
+		{
+			CHECK(timing.maxDifference <= (timing.effect == PostProcess::Wireframe ? 0 : 1));
+		}
+	}
+}
+
+
+TEST(CPUComputeTileChainsAgree)
+{
+	// A whole chain with a blur pyramid gives the same image with compute tiles on and off
+	PostProcessChain chain = { { PostProcess::Tint, PostProcessMode::Fullscreen },
+	                           { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen },
+	                           { PostProcess::GaussianBlurVertical, PostProcessMode::Fullscreen },
+	                           { PostProcess::Wireframe, PostProcessMode::Fullscreen } };
+	TestFrame test(96, 64, TestScene::Smooth);
+	test.mFrame.effectConstants.gaussianBlur.blurSigma = 16.0f;
+
+	CPUPostProcessDevice device(2);
+	CPUImage pixelShaders, computeTiles;
+	device.Run(chain, test.mFrame, pixelShaders);
+	device.SetComputeTiles(true);
+	device.Run(chain, test.mFrame, computeTiles);
+	CHECK(MaxDifference(pixelShaders, computeTiles) <= 1);
+}
@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------------------------
+// Tests of depth of field as circle of confusion tiles and half size gathers (DepthOfField.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "DepthOfField.h"
+
+#include <cmath>
+
+
+static const PostProcessChain FULLSCREEN_DEPTH_OF_FIELD = { { PostProcess::DepthOfField, PostProcessMode::Fullscreen } };
+
+
+TEST(CPUDepthOfFieldGraphPasses)
+{
+	// The circle of confusion at full size, its tiles, the far and near fields at half size, then the composite reading them
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_DEPTH_OF_FIELD);
+	int coc = -1, tiles = -1, far = -1, near = -1, composites = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		int sizeDivisor = graph.Resource(pass.output).sizeDivisor;
+		switch (pass.type)
+		{
+		case RenderPassType::DepthOfFieldCoC:
+			coc = pass.output;
+			CHECK_EQUAL(1, sizeDivisor);
+			CHECK(graph.Resource(pass.output).format == TargetFormat::RGBA16F);
+			CHECK_EQUAL(SCENE_DEPTH_RESOURCE, pass.inputs[1]);
+			break;
+		case RenderPassType::DepthOfFieldTiles:
+			tiles = pass.output;
+			CHECK_EQUAL(DOF_TILE_SIZE, sizeDivisor);
+			CHECK_EQUAL(coc, pass.inputs[0]);
+			break;
+		case RenderPassType::DepthOfFieldFar:
+		case RenderPassType::DepthOfFieldNear:
+			(pass.type == RenderPassType::DepthOfFieldFar ? far : near) = pass.output;
+			CHECK_EQUAL(DOF_GATHER_SIZE_DIVISOR, sizeDivisor);
+			CHECK_EQUAL(coc, pass.inputs[0]);
+			CHECK_EQUAL(tiles, pass.inputs[1]);
+			break;
+		case RenderPassType::PostProcess:
+			if (pass.effect != PostProcess::DepthOfField)  break;
+			++composites;
+			CHECK_EQUAL(coc, pass.inputs[0]);
+			CHECK_EQUAL(far, pass.inputs[1]);
+			CHECK_EQUAL(near, pass.inputs[2]);
+			break;
+		default:
+			break;
+		}
+	}
+	CHECK(coc >= 0 && tiles >= 0 && far >= 0 && near >= 0);
+	CHECK_EQUAL(1, composites);
+}
+
+
+TEST(CPUDepthOfFieldGatherTaps)
+{
+	// A centre tap and rings of 8, 16 and 24, or a share of the rings each frame with temporal accumulation
+	CHECK(std::abs(DepthOfFieldGatherTaps(1) - 49.0f) < 1e-4f);
+	CHECK(std::abs(DepthOfFieldGatherTaps(DOF_TEMPORAL_FRAMES) - (1.0f + 48.0f / DOF_TEMPORAL_FRAMES)) < 1e-4f);
+}
+
+
+TEST(CPUDepthOfFieldInFocus)
+{
+	// With no aperture every tile is in focus and the scene comes back unblurred
+	TestFrame test(128, 96);
+	std::vector<CPUDepthOfFieldTiming> timings = MeasureDepthOfField({ 0.0f }, test.mFrame, 2, 1);
+	CHECK_EQUAL(1, static_cast<int>(timings.size()));
+	CHECK(timings[0].inFocusTiles == 1.0f);
+
+	test.mFrame.effectConstants.depthOfField.aperture = 0.0f;
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_DEPTH_OF_FIELD, test.mFrame, output);
+	CHECK(MaxDifference(test.mScene, output) <= 1);
+}
+
+
+TEST(CPUDepthOfFieldBlursOutOfFocus)
+{
+	// A wider aperture puts more of the image out of focus, which is blurred - and a blur of random noise is much smoother
+	TestFrame test(128, 96);
+	std::vector<CPUDepthOfFieldTiming> timings = MeasureDepthOfField({ 1.0f, 5.0f, 50.0f }, test.mFrame, 2, 1);
+	CHECK_EQUAL(3, static_cast<int>(timings.size()));
+	CHECK(timings[0].inFocusTiles >= timings[1].inFocusTiles);
+	CHECK(timings[1].inFocusTiles >= timings[2].inFocusTiles);
+	CHECK(timings[2].inFocusTiles < 1.0f);
+
+	test.mFrame.effectConstants.depthOfField.aperture = 50.0f;
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_DEPTH_OF_FIELD, test.mFrame, output);
+	CHECK(AllFinite(output));
+	CHECK(MaxDifference(test.mScene, output) > 32);
+}
+
+
+TEST(CPUDepthOfFieldThreadsAgree)
+{
+	TestFrame test(160, 90, TestScene::Smooth);
+	test.mFrame.effectConstants.depthOfField.aperture = 20.0f;
+	CPUPostProcessDevice oneThread(1), fourThreads(4);
+	CPUImage a, b;
+	oneThread.Run(FULLSCREEN_DEPTH_OF_FIELD, test.mFrame, a);
+	fourThreads.Run(FULLSCREEN_DEPTH_OF_FIELD, test.mFrame, b);
+	CHECK_EQUAL(0, MaxDifference(a, b));
+}
@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------------
+// Tests of the lens star's streaks as iterative passes (LensStar.h, CPULensStar.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "LensStar.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+
+// Weight of each sample along one side of a streak made by all of its passes, by the sample's number of steps out. The weights
+// of the passes multiply, and their steps add
+static std::map<int, double> StreakKernel(const LensStarConstants& settings, int streak, bool backward, bool& stepsMatch)
+{
+	std::map<int, double> kernel = { { 0, 1.0 } };
+	int numPasses = LensStarPasses(settings.streakLength);
+	CVector2 firstStep = MakeLensStarStreakConstants(settings, streak, 0, backward).tapStep;
+	stepsMatch = true;
+	int spacing = 1;
+	for (int pass = 0; pass < numPasses; ++pass)
+	{
+		LensStarStreakConstants constants = MakeLensStarStreakConstants(settings, streak, pass, backward);
+		float weights[LENS_STAR_MAX_TAPS] = { constants.tapWeights.x, constants.tapWeights.y, constants.tapWeights.z, constants.tapWeights.w };
+
+		// Each pass steps as far as all the passes before reach
+		stepsMatch = stepsMatch && std::fabs(constants.tapStep.x - firstStep.x * spacing) < 1e-6f &&
+		                           std::fabs(constants.tapStep.y - firstStep.y * spacing) < 1e-6f;
+
+		std::map<int, double> next;
+		for (const auto& sample : kernel)
+		{
+			for (int tap = 0; tap < constants.numTaps; ++tap)
+			{
+				next[sample.first + (constants.firstTap + tap) * spacing] += sample.second * weights[tap];
+			}
+		}
+		kernel = next;
+		spacing *= constants.numTaps;
+	}
+	return kernel;
+}
+
+
+TEST(CPULensStarPassTaps)
+{
+	// Lengths are made by up to LENS_STAR_MAX_PASSES passes of up to LENS_STAR_MAX_TAPS taps, rounded up to the next length
+	// the passes can make
+	int maxLength = 1;
+	for (int pass = 0; pass < LENS_STAR_MAX_PASSES; ++pass)  maxLength *= LENS_STAR_MAX_TAPS;
+	for (int length = 1; length <= maxLength; ++length)
+	{
+		std::vector<int> taps = LensStarPassTaps(length);
+		CHECK(!taps.empty() && static_cast<int>(taps.size()) <= LENS_STAR_MAX_PASSES);
+		int product = 1;
+		for (int passTaps : taps)
+		{
+			CHECK(passTaps >= 1 && passTaps <= LENS_STAR_MAX_TAPS);
+			product *= passTaps;
+		}
+		CHECK(product >= length);
+		CHECK_EQUAL(static_cast<int>(taps.size()), LensStarPasses(length));
+	}
+	CHECK(LensStarPassTaps(6) == std::vector<int>({ 3, 2 }));
+	CHECK(LensStarPassTaps(64) == std::vector<int>({ 4, 4, 4 }));
+	CHECK(LensStarPassTaps(5) == std::vector<int>({ 3, 2 })); // Rounded up to 6
+}
+
+
+TEST(CPULensStarExactKernel)
+{
+	// For every length and every streak, the passes together take each sample from 1 to the length once, weighted by
+	// attenuation^i, on both sides - and the tint divides by the sum of all of them
+	LensStarConstants settings = {};
+	settings.stepSize    = 0.007f;
+	settings.attenuation = 0.8f;
+	for (int length = 1; length <= 256; ++length)
+	{
+		settings.streakLength = length;
+		std::vector<int> taps = LensStarPassTaps(length);
+		int madeLength = 1;
+		for (int passTaps : taps)  madeLength *= passTaps;
+
+		for (int streak = 0; streak < LENS_STAR_STREAKS; ++streak)
+		{
+			for (bool backward : { false, true })
+			{
+				bool stepsMatch = false;
+				std::map<int, double> kernel = StreakKernel(settings, streak, backward, stepsMatch);
+				CHECK(stepsMatch);
+				CHECK_EQUAL(madeLength, static_cast<int>(kernel.size()));
+				CHECK(kernel.begin()->first == 1 && kernel.rbegin()->first == madeLength);
+
+				double maxError = 0;
+				for (const auto& sample : kernel)
+				{
+					double expected = std::pow(settings.attenuation, sample.first);
+					maxError = std::max(maxError, std::fabs(sample.second - expected) / expected);
+				}
+				CHECK(maxError < 1e-4);
+			}
+
+			double weightSum = 0;
+			for (int sample = 1; sample <= madeLength; ++sample)  weightSum += 2 * std::pow(settings.attenuation, sample);
+			LensStarStreakConstants last = MakeLensStarStreakConstants(settings, streak, static_cast<int>(taps.size()) - 1, false);
+			CHECK(last.lastPass == (streak == LENS_STAR_STREAKS - 1 ? 2 : 1));
+			double brightest = std::max({ last.tint.x, last.tint.y, last.tint.z }); // Each streak's colour has a channel at 1
+			CHECK(std::fabs(brightest * weightSum - 1.0) < 1e-4);
+		}
+	}
+}
+
+
+TEST(CPULensStarMatchesSinglePass)
+{
+	// The streak passes read bilinearly where the single pass reads whole pixels, so they are close rather than equal
+	TestFrame test(192, 108, TestScene::Smooth);
+	std::vector<CPULensStarTiming> timings = MeasureLensStar({ 6, 16 }, test.mFrame, 2, 1);
+	CHECK_EQUAL(2, static_cast<int>(timings.size()));
+	for (const CPULensStarTiming& timing : timings)
+	{
+		CHECK_EQUAL(LensStarPasses(timing.streakLength), timing.passes);
+		CHECK(timing.psnr >= 40.0);
+	}
+}
@@ -0,0 +1,106 @@
+//--------------------------------------------------------------------------------------
+// Tests of motion blur from the velocity of each pixel (MotionBlur.h, CPUMotionBlur.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "MotionBlur.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+static const PostProcessChain FULLSCREEN_MOTION_BLUR = { { PostProcess::MotionBlur, PostProcessMode::Fullscreen } };
+
+
+// Largest difference in 8-bit steps between two images over the columns from firstX up to lastX
+static int ColumnsDifference(const CPUImage& a, const CPUImage& b, int firstX, int lastX)
+{
+	float maxDifference = 0.0f;
+	for (int y = 0; y < a.Height(); ++y)
+	{
+		for (int x = firstX; x < lastX; ++x)
+		{
+			const CVector4& pixelA = a.Pixel(x, y);
+			const CVector4& pixelB = b.Pixel(x, y);
+			maxDifference = std::max({ maxDifference, std::fabs(pixelA.x - pixelB.x), std::fabs(pixelA.y - pixelB.y),
+			                           std::fabs(pixelA.z - pixelB.z) });
+		}
+	}
+	return static_cast<int>(std::ceil(maxDifference * 255.0f - 0.001f));
+}
+
+
+TEST(CPUMotionBlurGraphPasses)
+{
+	// A tiles pass from the scene velocity, then the blur reading the velocity and the tiles - and no copy of the frame kept
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_MOTION_BLUR);
+	int tiles = -1, blurs = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		CHECK(pass.type != RenderPassType::CopyResource || pass.output != HISTORY_RESOURCE);
+		if (pass.type == RenderPassType::MotionBlurTiles)
+		{
+			tiles = pass.output;
+			CHECK_EQUAL(SCENE_VELOCITY_RESOURCE, pass.inputs[0]);
+			CHECK_EQUAL(MOTION_BLUR_TILE_SIZE, graph.Resource(pass.output).sizeDivisor);
+		}
+		else if (pass.type == RenderPassType::PostProcess && pass.effect == PostProcess::MotionBlur)
+		{
+			++blurs;
+			CHECK_EQUAL(SCENE_VELOCITY_RESOURCE, pass.inputs[1]);
+			CHECK_EQUAL(tiles, pass.inputs[2]);
+		}
+	}
+	CHECK(tiles >= 0);
+	CHECK_EQUAL(1, blurs);
+}
+
+
+TEST(CPUMotionBlurStillImage)
+{
+	// With the shutter closed every tile is still and every pixel is copied unchanged
+	TestFrame test(128, 96);
+	std::vector<CPUMotionBlurTiming> timings = MeasureMotionBlur({ 0.0f }, test.mFrame, 2, 1);
+	CHECK_EQUAL(1, static_cast<int>(timings.size()));
+	CHECK(timings[0].stillTiles == 1.0f);
+
+	test.mFrame.effectConstants.motionBlur.shutter = 0.0f;
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_MOTION_BLUR, test.mFrame, output);
+	CHECK_EQUAL(0, MaxDifference(test.mScene, output));
+}
+
+
+TEST(CPUMotionBlurOnlyMovingPixels)
+{
+	// The left half pans, the right half is still. Pixels more than a tile from anything moving stay exactly as they were
+	TestFrame test(192, 64);
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_MOTION_BLUR, test.mFrame, output);
+	CHECK(AllFinite(output));
+
+	int halfWidth = test.Width() / 2;
+	CHECK(ColumnsDifference(test.mScene, output, 0, halfWidth - MOTION_BLUR_TILE_SIZE) > 16);
+	CHECK_EQUAL(0, ColumnsDifference(test.mScene, output, halfWidth + 2 * MOTION_BLUR_TILE_SIZE, test.Width()));
+
+	// Half of the tiles move, the same whatever the shutter
+	std::vector<CPUMotionBlurTiming> timings = MeasureMotionBlur({ 0.25f, 1.0f }, test.mFrame, 2, 1);
+	CHECK_EQUAL(2, static_cast<int>(timings.size()));
+	CHECK(std::fabs(timings[0].stillTiles - 0.5f) < 0.01f);
+	CHECK(std::fabs(timings[1].stillTiles - 0.5f) < 0.01f);
+}
+
+
+TEST(CPUMotionBlurThreadsAgree)
+{
+	TestFrame test(160, 90, TestScene::Smooth);
+	CPUPostProcessDevice oneThread(1), fourThreads(4);
+	CPUImage a, b;
+	oneThread.Run(FULLSCREEN_MOTION_BLUR, test.mFrame, a);
+	fourThreads.Run(FULLSCREEN_MOTION_BLUR, test.mFrame, b);
+	CHECK_EQUAL(0, MaxDifference(a, b));
+}
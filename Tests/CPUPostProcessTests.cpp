@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------------------------
+// Tests of the CPU post-processing (CPU/CPUPostProcessDevice.h)
+//--------------------------------------------------------------------------------------
+// Small frames, so the whole chain of every effect runs in a moment
+
+#include "Test.h"
+#include "TestImages.h"
+
+
+static const int NUM_EFFECTS = static_cast<int>(PostProcess::OnePassBlur);
+static const int NUM_MODES   = static_cast<int>(PostProcessMode::WindowPolygon) + 1;
+
+
+TEST(CPUPostProcessEveryEffectRuns)
+{
+	TestFrame test(96, 64);
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	for (int effect = 1; effect <= NUM_EFFECTS; ++effect)
+	{
+		for (int mode = 0; mode < NUM_MODES; ++mode)
+		{
+			PostProcessChain chain = { { static_cast<PostProcess>(effect), static_cast<PostProcessMode>(mode) } };
+			PostProcessStats stats = device.Run(chain, test.mFrame, output);
+			bool ran = stats.passes > 0 && output.Width() == test.Width() && output.Height() == test.Height() && AllFinite(output);
+			if (!ran)  ReportFailure(__FILE__, __LINE__, "Effect " + std::to_string(effect) + " mode " + std::to_string(mode) + " failed");
+		}
+	}
+}
+
+
+TEST(CPUPostProcessNoSceneDoesNothing)
+{
+	CPUPostProcessDevice device(1);
+	CPUPostProcessFrame frame;
+	CPUImage output;
+	PostProcessStats stats = device.Run({ { PostProcess::Tint, PostProcessMode::Fullscreen } }, frame, output);
+	CHECK_EQUAL(0, stats.passes);
+}
+
+
+TEST(CPUPostProcessIssuesWhatTheGraphPlans)
+{
+	// The CPU device runs some passes its own way, but must report the same work as a GPU device running the same graph
+	TestFrame test(96, 64);
+	std::vector<PostProcessChain> chains =
+	{
+		{},
+		{ { PostProcess::Tint, PostProcessMode::Fullscreen }, { PostProcess::Sepia, PostProcessMode::Fullscreen } },
+		{ { PostProcess::Bloom, PostProcessMode::Fullscreen }, { PostProcess::MotionBlur, PostProcessMode::Fullscreen } },
+		{ { PostProcess::Burn, PostProcessMode::Area }, { PostProcess::Distort, PostProcessMode::Fullscreen },
+		  { PostProcess::Spiral, PostProcessMode::Fullscreen } },
+		{ { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen }, { PostProcess::GaussianBlurVertical, PostProcessMode::Fullscreen },
+		  { PostProcess::Wireframe, PostProcessMode::Area } },
+		{ { PostProcess::DepthOfField, PostProcessMode::Fullscreen }, { PostProcess::Fog, PostProcessMode::Fullscreen } },
+	};
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	for (const PostProcessChain& chain : chains)
+	{
+		PostProcessStats cpuStats = device.Run(chain, test.mFrame, output);
+		RecordingPostProcessDevice recording;
+		PostProcessStats recordedStats = ExecuteRenderGraph(device.Graph(), recording);
+		CHECK_EQUAL(recordedStats.passes, cpuStats.passes);
+		CHECK_EQUAL(recordedStats.draws, cpuStats.draws);
+		CHECK_EQUAL(recordedStats.copies, cpuStats.copies);
+		CHECK_EQUAL(1, cpuStats.backBufferDraws);
+	}
+}
+
+
+TEST(CPUPostProcessEmptyChainCopiesScene)
+{
+	TestFrame test(64, 48);
+	CPUPostProcessDevice device(1);
+	CPUImage output;
+	device.Run({}, test.mFrame, output);
+	CHECK_EQUAL(0, MaxDifference(test.mScene, output));
+}
+
+
+TEST(CPUPostProcessSimdMatchesPerPixel)
+{
+	// Full screen colour effects run as SIMD rows, an area covering the whole screen runs them pixel by pixel
+	TestFrame test(67, 41); // Odd sizes to leave part filled SIMD registers at the ends of rows
+	test.mFrame.sceneDepth = nullptr;
+	CPUPostProcessDevice device(1);
+	for (PostProcess effect : { PostProcess::Copy, PostProcess::Tint, PostProcess::Invert, PostProcess::Sepia })
+	{
+		CPUImage fullscreen, area;
+		device.Run({ { effect, PostProcessMode::Fullscreen } }, test.mFrame, fullscreen);
+		device.Run({ { effect, PostProcessMode::Area } }, test.mFrame, area);
+		CHECK_EQUAL(0, MaxDifference(fullscreen, area));
+	}
+}
+
+
+TEST(CPUPostProcessHalfFloats)
+{
+	// Every finite half float survives the trip through a float, and conversion rounds as the GPU does
+	int mismatches = 0;
+	for (uint32_t half = 0; half < 0x10000; ++half)
+	{
+		if (((half >> 10) & 0x1f) == 0x1f)  continue; // Infinities and NaNs
+		if (FloatToHalf(HalfToFloat(static_cast<uint16_t>(half))) != half)  ++mismatches;
+	}
+	CHECK_EQUAL(0, mismatches);
+	CHECK_EQUAL(0x7bff, static_cast<int>(FloatToHalf(65519.0f))); // Largest half
+	CHECK_EQUAL(0x7c00, static_cast<int>(FloatToHalf(65520.0f))); // Rounds to infinity
+	CHECK_EQUAL(0, static_cast<int>(FloatToHalf(1e-8f)));          // Below the smallest denormal
+}
+
+
+TEST(CPUPostProcessThreadsAgree)
+{
+	TestFrame test(160, 90);
+	PostProcessChain chain = { { PostProcess::Bloom, PostProcessMode::Fullscreen }, { PostProcess::HeatHaze, PostProcessMode::Fullscreen },
+	                           { PostProcess::NightVision, PostProcessMode::Area } };
+	CPUPostProcessDevice oneThread(1), threeThreads(3);
+	CPUImage outputOne, outputThree;
+	oneThread.Run(chain, test.mFrame, outputOne);
+	threeThreads.Run(chain, test.mFrame, outputThree);
+	CHECK_EQUAL(0, MaxDifference(outputOne, outputThree));
+}
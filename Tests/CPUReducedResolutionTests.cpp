@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------------------
+// Tests of running smooth effects on a smaller image (RenderPassType::ReducedResolutionUpsample)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+
+
+static const PostProcessChain FULLSCREEN_LENS_STAR = { { PostProcess::LensStar, PostProcessMode::Fullscreen } };
+
+
+TEST(CPUReducedResolutionDeclared)
+{
+	// The lens star is the one effect declared - its streaks are smooth and it is costly for every pixel. Effects that already
+	// run on smaller images (blurs, bloom, depth of field) or whose change isn't smooth aren't
+	CHECK_EQUAL(2, GetPostProcessDeclaration(PostProcess::LensStar).reducedResolutionDivisor);
+	for (PostProcess effect : { PostProcess::GaussianBlurHorizontal, PostProcess::Bloom, PostProcess::DepthOfField,
+	                            PostProcess::HeatHaze, PostProcess::Underwater, PostProcess::Tint })
+	{
+		CHECK_EQUAL(1, GetPostProcessDeclaration(effect).reducedResolutionDivisor);
+	}
+}
+
+
+TEST(CPUReducedResolutionGraphPasses)
+{
+	// Only when switched on and full screen: a halving of the image, the effect at half size, then the upsample of its change
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_LENS_STAR);
+	for (const RenderPass& pass : graph.Passes())  CHECK(pass.type != RenderPassType::ReducedResolutionUpsample);
+
+	graph.Compile({ { PostProcess::LensStar, PostProcessMode::Area } }, 0, false, true);
+	for (const RenderPass& pass : graph.Passes())  CHECK(pass.type != RenderPassType::ReducedResolutionUpsample);
+
+	graph.Compile(FULLSCREEN_LENS_STAR, 0, false, true);
+	const std::vector<RenderPass>& passes = graph.Passes();
+	CHECK(passes.size() >= 3);
+	if (passes.size() < 3)  return;
+
+	CHECK(passes[0].type == RenderPassType::Resample);
+	CHECK_EQUAL(2, graph.Resource(passes[0].output).sizeDivisor);
+	CHECK(passes[1].type == RenderPassType::PostProcess && passes[1].effect == PostProcess::LensStar);
+	CHECK_EQUAL(2, graph.Resource(passes[1].output).sizeDivisor);
+	CHECK(passes[2].type == RenderPassType::ReducedResolutionUpsample);
+	CHECK_EQUAL(passes[1].output, passes[2].inputs[1]);
+	CHECK_EQUAL(passes[0].output, passes[2].inputs[2]);
+	CHECK_EQUAL(1, graph.Resource(passes[2].output).sizeDivisor);
+}
+
+
+TEST(CPUReducedResolutionUnchangedPixelsStaySharp)
+{
+	// Where the effect made no change, the upsample gives back the full size image exactly, not a blurred copy
+	TestFrame test(64, 48);
+	CPUImage small(32, 24);
+	for (int y = 0; y < small.Height(); ++y)
+	{
+		for (int x = 0; x < small.Width(); ++x)  small.Pixel(x, y) = test.mScene.Pixel(x * 2, y * 2);
+	}
+
+	CPUPassContext context;
+	context.inputs          = { &test.mScene, &small, &small };
+	context.effectConstants = &test.mFrame.effectConstants;
+	context.viewportWidth   = test.Width();
+	context.viewportHeight  = test.Height();
+	CPUImage output(test.Width(), test.Height());
+	CPUReducedResolutionUpsample(context, output);
+	CHECK_EQUAL(0, MaxDifference(test.mScene, output));
+}
+
+
+TEST(CPUReducedResolutionQuality)
+{
+	// Every declared effect is hard to tell apart from running it at full size on an image like a rendered scene
+	TestFrame test(480, 270, TestScene::Smooth);
+	std::vector<PostProcess> declared;
+	for (int effect = static_cast<int>(PostProcess::Copy); effect <= static_cast<int>(PostProcess::OnePassBlur); ++effect)
+	{
+		if (GetPostProcessDeclaration(static_cast<PostProcess>(effect)).reducedResolutionDivisor > 1)
+		{
+			declared.push_back(static_cast<PostProcess>(effect));
+		}
+	}
+	std::vector<CPUReducedResolutionTiming> timings = MeasureReducedResolution(declared, test.mFrame, 2, 1);
+	CHECK_EQUAL(static_cast<int>(declared.size()), static_cast<int>(timings.size()));
+	for (const CPUReducedResolutionTiming& timing : timings)
+	{
+		CHECK(timing.sizeDivisor > 1);
+		CHECK(timing.psnr >= 40.0);
+	}
+}
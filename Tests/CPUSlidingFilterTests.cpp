@@ -0,0 +1,144 @@
+//--------------------------------------------------------------------------------------
+// Tests of the sliding window dilation and box blur (SlidingFilter.h, CPUSlidingFilter.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "SlidingFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+static const PostProcessChain FULLSCREEN_DILATION = { { PostProcess::Dilation, PostProcessMode::Fullscreen } };
+static const PostProcessChain FULLSCREEN_BLUR     = { { PostProcess::OnePassBlur, PostProcessMode::Fullscreen } };
+
+
+static int CountSlidingPasses(const RenderGraph& graph)
+{
+	int count = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.type == RenderPassType::SlidingFilterRows || pass.type == RenderPassType::SlidingFilterColumns)  ++count;
+	}
+	return count;
+}
+
+
+TEST(CPUSlidingFilterDefaultsAreOriginal)
+{
+	// A 7x7 dilation and a 3x3 blur with its taps two pixels apart, as before the radius could be changed
+	PostProcessEffectConstants settings = DefaultPostProcessEffectConstants(640, 360, 1.0f, 1000.0f);
+	CHECK_EQUAL(3, settings.dilation.kernelRadius);
+	CHECK_EQUAL(1, settings.onePassBlur.blurRadius);
+	CHECK_EQUAL(2, settings.onePassBlur.tapSpacing);
+	CHECK(!BoxBlurIsSliding(settings.onePassBlur));
+
+	settings.onePassBlur.tapSpacing = 1;
+	CHECK(BoxBlurIsSliding(settings.onePassBlur));
+}
+
+
+TEST(CPUSlidingFilterOnlyTrueBoxBlursSlide)
+{
+	// Dilations always run as the two sliding passes, box blurs only when asked for
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_DILATION);
+	CHECK_EQUAL(2, CountSlidingPasses(graph));
+
+	graph.Compile(FULLSCREEN_BLUR);
+	CHECK_EQUAL(0, CountSlidingPasses(graph));
+	CHECK(!graph.IsCompiledFrom(FULLSCREEN_BLUR, 0, false, false, false, 1, true));
+
+	graph.Compile(FULLSCREEN_BLUR, 0, false, false, false, 1, true);
+	CHECK_EQUAL(2, CountSlidingPasses(graph));
+	CHECK(graph.IsCompiledFrom(FULLSCREEN_BLUR, 0, false, false, false, 1, true));
+
+	// Area blurs read every pixel of the square whatever the setting
+	graph.Compile({ { PostProcess::OnePassBlur, PostProcessMode::Area } }, 0, false, false, false, 1, true);
+	CHECK_EQUAL(0, CountSlidingPasses(graph));
+}
+
+
+TEST(CPUSlidingFilterOriginalBlurTaps)
+{
+	// The default blur is the average of 9 pixels two apart, clamped at the edges
+	TestFrame test(48, 32);
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_BLUR, test.mFrame, output);
+
+	int width = test.Width(), height = test.Height();
+	float maxError = 0.0f;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			CVector3 sum = { 0.0f, 0.0f, 0.0f };
+			for (int dy = -2; dy <= 2; dy += 2)
+			{
+				for (int dx = -2; dx <= 2; dx += 2)
+				{
+					const CVector4& pixel = test.mScene.Pixel(std::min(std::max(x + dx, 0), width - 1),
+					                                          std::min(std::max(y + dy, 0), height - 1));
+					sum += CVector3(pixel.x, pixel.y, pixel.z);
+				}
+			}
+			const CVector4& blurred = output.Pixel(x, y);
+			maxError = std::max({ maxError, std::fabs(blurred.x - sum.x / 9.0f), std::fabs(blurred.y - sum.y / 9.0f),
+			                      std::fabs(blurred.z - sum.z / 9.0f) });
+		}
+	}
+	CHECK(maxError * 255.0f <= 1.0f);
+}
+
+
+TEST(CPUSlidingFilterMatchesPerPixel)
+{
+	// The sliding passes give exactly the dilation of the pixel shader, and the box blur to within an 8-bit step, at any radius
+	TestFrame test(80, 48);
+	std::vector<CPUSlidingFilterTiming> timings = MeasureSlidingFilters({ PostProcess::Dilation, PostProcess::OnePassBlur },
+	                                                                    { 1, 2, 5, 16, 40 }, test.mFrame, 2, 1);
+	CHECK_EQUAL(10, static_cast<int>(timings.size()));
+	for (const CPUSlidingFilterTiming& timing : timings)
+	{
+		CHECK(timing.maxDifference <= (timing.effect == PostProcess::Dilation ? 0 : 1));
+	}
+}
+
+
+TEST(CPUSlidingFilterDeviceBoxBlur)
+{
+	// With its taps one pixel apart the device's blur is the average of the (2r+1)^2 square, clamped at the edges
+	TestFrame test(64, 40);
+	const int radius = 4;
+	test.mFrame.effectConstants.onePassBlur.blurRadius = radius;
+	test.mFrame.effectConstants.onePassBlur.tapSpacing = 1;
+	CPUPostProcessDevice device(2);
+	CPUImage output;
+	device.Run(FULLSCREEN_BLUR, test.mFrame, output);
+
+	int width = test.Width(), height = test.Height();
+	float numTaps = static_cast<float>((2 * radius + 1) * (2 * radius + 1));
+	float maxError = 0.0f;
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			CVector3 sum = { 0.0f, 0.0f, 0.0f };
+			for (int dy = -radius; dy <= radius; ++dy)
+			{
+				for (int dx = -radius; dx <= radius; ++dx)
+				{
+					const CVector4& pixel = test.mScene.Pixel(std::min(std::max(x + dx, 0), width - 1),
+					                                          std::min(std::max(y + dy, 0), height - 1));
+					sum += CVector3(pixel.x, pixel.y, pixel.z);
+				}
+			}
+			const CVector4& blurred = output.Pixel(x, y);
+			maxError = std::max({ maxError, std::fabs(blurred.x - sum.x / numTaps), std::fabs(blurred.y - sum.y / numTaps),
+			                      std::fabs(blurred.z - sum.z / numTaps) });
+		}
+	}
+	CHECK(maxError * 255.0f <= 1.0f);
+}
@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------------
+// Tests of temporal accumulation with reprojection (TemporalHistory.h, CPUTemporal.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "TemporalHistory.h"
+#include "DepthOfField.h"
+
+#include <cmath>
+
+
+static const PostProcessChain FULLSCREEN_DEPTH_OF_FIELD = { { PostProcess::DepthOfField, PostProcessMode::Fullscreen } };
+
+
+// A perspective projection as the camera makes, in the row vector convention of the app
+static CMatrix4x4 MakeProjection(float nearClip, float farClip)
+{
+	CMatrix4x4 projection = MatrixIdentity();
+	projection.e00 = 1.2f;
+	projection.e11 = 2.0f;
+	projection.e22 = farClip / (farClip - nearClip);
+	projection.e23 = 1.0f;
+	projection.e32 = -nearClip * farClip / (farClip - nearClip);
+	projection.e33 = 0.0f;
+	return projection;
+}
+
+
+TEST(CPUTemporalGraphPasses)
+{
+	// Only when switched on: the gathers take a share of their taps, then a resolve with the history and a copy to the history.
+	// Only the first effect keeps a history
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_DEPTH_OF_FIELD);
+	for (const RenderPass& pass : graph.Passes())  CHECK(pass.type != RenderPassType::TemporalResolve && pass.temporalFrames == 1);
+
+	graph.Compile({ FULLSCREEN_DEPTH_OF_FIELD[0], FULLSCREEN_DEPTH_OF_FIELD[0] }, 0, false, false, true);
+	int resolves = 0, historyCopies = 0, sharedGathers = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.type == RenderPassType::TemporalResolve)
+		{
+			++resolves;
+			CHECK_EQUAL(HISTORY_RESOURCE, pass.inputs[1]);
+			CHECK_EQUAL(SCENE_DEPTH_RESOURCE, pass.inputs[2]);
+			CHECK(graph.Resource(pass.output).format == TargetFormat::RGBA16F);
+		}
+		if (pass.output == HISTORY_RESOURCE)  ++historyCopies;
+		if ((pass.type == RenderPassType::DepthOfFieldFar || pass.type == RenderPassType::DepthOfFieldNear) && pass.temporalFrames > 1)
+		{
+			++sharedGathers;
+			CHECK_EQUAL(DOF_TEMPORAL_FRAMES, pass.temporalFrames);
+		}
+	}
+	CHECK_EQUAL(1, resolves);
+	CHECK_EQUAL(1, historyCopies);
+	CHECK_EQUAL(2, sharedGathers);
+}
+
+
+TEST(CPUTemporalReprojection)
+{
+	CMatrix4x4 projection = MakeProjection(1.0f, 1000.0f);
+	CMatrix4x4 cameraNow  = MatrixRotationY(0.1f) * MatrixTranslation({ 2.0f, 1.0f, -5.0f });
+	CMatrix4x4 cameraLast = MatrixRotationY(0.08f) * MatrixTranslation({ 1.5f, 1.0f, -5.5f });
+	CMatrix4x4 viewNow  = InverseAffine(cameraNow);
+	CMatrix4x4 viewLast = InverseAffine(cameraLast);
+
+	// A still camera reprojects each position to itself, a moving one to where the same point was last frame
+	CMatrix4x4 still = MakeReprojectionMatrix(viewNow, projection, viewNow * projection);
+	CMatrix4x4 moving = MakeReprojectionMatrix(viewNow, projection, viewLast * projection);
+	for (CVector3 point : { CVector3(0.0f, 0.0f, 10.0f), CVector3(3.0f, -2.0f, 40.0f), CVector3(-8.0f, 5.0f, 200.0f) })
+	{
+		CVector4 world(point.x, point.y, point.z, 1.0f);
+		CVector4 clipNow  = world * viewNow * projection;
+		CVector4 clipLast = world * viewLast * projection;
+
+		CVector4 stillClip = clipNow * still;
+		CHECK(std::fabs(stillClip.x / stillClip.w - clipNow.x / clipNow.w) < 1e-4f);
+		CHECK(std::fabs(stillClip.y / stillClip.w - clipNow.y / clipNow.w) < 1e-4f);
+
+		CVector4 movingClip = clipNow * moving;
+		CHECK(std::fabs(movingClip.x / movingClip.w - clipLast.x / clipLast.w) < 1e-3f);
+		CHECK(std::fabs(movingClip.y / movingClip.w - clipLast.y / clipLast.w) < 1e-3f);
+		CHECK(std::fabs(movingClip.w - clipLast.w) < 1e-2f * clipLast.w);
+	}
+}
+
+
+TEST(CPUTemporalResolveSettings)
+{
+	TemporalResolveConstants settings = {};
+	settings.frameIndex = 7;
+	TemporalResolveConstants constants = MakeTemporalResolveConstants(settings, DOF_TEMPORAL_FRAMES, false);
+	CHECK_EQUAL(0, constants.historyValid);
+	CHECK_EQUAL(7, constants.frameIndex);
+	CHECK(std::fabs(constants.currentWeight - 1.0f / DOF_TEMPORAL_FRAMES) < 1e-6f);
+	CHECK_EQUAL(1, MakeTemporalResolveConstants(settings, DOF_TEMPORAL_FRAMES, true).historyValid);
+}
+
+
+TEST(CPUTemporalSettlesToFullResult)
+{
+	// After a few frames of a still view the depth of field taking a share of its taps each frame looks like taking them all,
+	// and reads fewer samples even counting the resolve
+	TestFrame test(240, 136, TestScene::Smooth);
+	test.mFrame.effectConstants.depthOfField.aperture = 20.0f;
+	std::vector<CPUTemporalTiming> timings = MeasureTemporalAccumulation({ PostProcess::DepthOfField }, test.mFrame, 16, 2, 1);
+	CHECK_EQUAL(1, static_cast<int>(timings.size()));
+	if (timings.empty())  return;
+
+	CHECK(timings[0].psnr >= 35.0);
+	CHECK_EQUAL(2, timings[0].samples.temporalPasses);
+	CHECK(timings[0].samples.Savings() > 0.0);
+}
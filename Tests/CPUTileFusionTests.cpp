@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------------
+// Tests of running chains of full screen passes tile by tile (CPU/CPUTileFusion.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "CPUTileFusion.h"
+
+#include <random>
+
+
+static const PostProcessMode FULLSCREEN = PostProcessMode::Fullscreen;
+
+
+TEST(CPUTileFusionFindsRunsOfFullScreenPasses)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::NightVision, FULLSCREEN },
+	                { PostProcess::Wireframe, FULLSCREEN } });
+	std::vector<CPUFusedGroup> groups = FindFusedGroups(graph);
+	CHECK_EQUAL(1, static_cast<int>(groups.size()));
+	CHECK_EQUAL(0, groups[0].firstPass);
+	CHECK_EQUAL(4, groups[0].numPasses);
+
+	// An area pass can't be fused, it splits the run
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::Invert, PostProcessMode::Area },
+	                { PostProcess::NightVision, FULLSCREEN }, { PostProcess::Wireframe, FULLSCREEN } });
+	groups = FindFusedGroups(graph);
+	CHECK_EQUAL(2, static_cast<int>(groups.size()));
+
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN } });
+	CHECK(FindFusedGroups(graph).empty());
+}
+
+
+TEST(CPUTileFusionGrowsTilesByLaterFootprints)
+{
+	// The wireframe reads the pixels around each one, so the pass before must write a wider rectangle
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::Wireframe, FULLSCREEN } });
+	std::vector<CPUFusedGroup> groups = FindFusedGroups(graph);
+	CHECK_EQUAL(1, static_cast<int>(groups.size()));
+
+	std::vector<PixelRect> rects;
+	FusedPassRects(graph, groups[0], { 64, 64, 96, 96 }, 640, 360, rects);
+	CHECK_EQUAL(2, static_cast<int>(rects.size()));
+	CHECK(rects[1].left == 64 && rects[1].top == 64 && rects[1].right == 96 && rects[1].bottom == 96);
+	CHECK(rects[0].left < 64 && rects[0].top < 64 && rects[0].right > 96 && rects[0].bottom > 96);
+
+	// Clipped to the viewport
+	FusedPassRects(graph, groups[0], { 0, 0, 32, 32 }, 640, 360, rects);
+	CHECK(rects[0].left == 0 && rects[0].top == 0);
+
+	int tileSize = FusedTileSize(graph, groups[0], 640, 360);
+	CHECK(tileSize >= CPU_MIN_FUSED_TILE_SIZE);
+}
+
+
+TEST(CPUTileFusionMatchesPassByPass)
+{
+	// Random chains, mostly full screen, run fused on several threads and pass by pass on one, must match exactly. The
+	// frame is a few tiles across so tile edges are crossed
+	TestFrame test(133, 77);
+	std::mt19937 random(5);
+	int numFused = 0;
+	for (int chainNumber = 0; chainNumber < 60; ++chainNumber)
+	{
+		PostProcessChain chain;
+		int length = 2 + random() % 4;
+		for (int i = 0; i < length; ++i)
+		{
+			PostProcess effect = static_cast<PostProcess>(1 + random() % static_cast<int>(PostProcess::OnePassBlur));
+			PostProcessMode mode = (random() % 5 == 0) ? static_cast<PostProcessMode>(1 + random() % 3) : FULLSCREEN;
+			chain.push_back({ effect, mode });
+		}
+
+		CPUPostProcessDevice fused(3), unfused(1);
+		unfused.SetTileFusion(false);
+		CPUImage fusedOutput, unfusedOutput;
+		PostProcessStats fusedStats, unfusedStats;
+		for (int frame = 0; frame < 2; ++frame) // The second frame has history
+		{
+			fusedStats   = fused.Run(chain, test.mFrame, fusedOutput);
+			unfusedStats = unfused.Run(chain, test.mFrame, unfusedOutput);
+		}
+		if (!fused.FusedGroups().empty())  ++numFused;
+
+		if (MaxDifference(fusedOutput, unfusedOutput) != 0 || fusedStats.passes != unfusedStats.passes ||
+		    fusedStats.draws != unfusedStats.draws)
+		{
+			ReportFailure(__FILE__, __LINE__, "Fused chain " + std::to_string(chainNumber) + " differs");
+		}
+	}
+	CHECK(numFused > 20);
+}
@@ -0,0 +1,121 @@
+//--------------------------------------------------------------------------------------
+// Tests of runs of full screen distortions combined into one pass (UVRemap.h, CPUUVRemap.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "UVRemap.h"
+
+#include <cmath>
+
+
+static PostProcessChain FullScreen(const std::vector<PostProcess>& effects)
+{
+	PostProcessChain chain;
+	for (PostProcess effect : effects)  chain.push_back({ effect, PostProcessMode::Fullscreen });
+	return chain;
+}
+
+// Sizes of the UV remap passes of the compiled chain, in order
+static std::vector<int> RemapSizes(const PostProcessChain& chain)
+{
+	RenderGraph graph;
+	graph.Compile(chain);
+	std::vector<int> sizes;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.type == RenderPassType::UVRemap)  sizes.push_back(pass.batchSize);
+	}
+	return sizes;
+}
+
+// Smooth gradients with no hard edges, where reading with point sampling and with bilinear filtering agree
+static void FillGradient(CPUImage& image)
+{
+	for (int y = 0; y < image.Height(); ++y)
+	{
+		for (int x = 0; x < image.Width(); ++x)
+		{
+			image.Pixel(x, y) = CVector4(std::round(x * 255.0f / (image.Width() - 1)) / 255.0f,
+			                             std::round(y * 255.0f / (image.Height() - 1)) / 255.0f, 0.5f, 1.0f);
+		}
+	}
+}
+
+
+TEST(CPUUVRemapGraphRuns)
+{
+	using P = PostProcess;
+
+	// A lone distortion runs as its own effect, a run of them as one pass of up to MAX_UV_REMAP_EFFECTS
+	CHECK(RemapSizes(FullScreen({ P::Distort })).empty());
+	CHECK(RemapSizes(FullScreen({ P::Distort, P::Spiral, P::HeatHaze })) == std::vector<int>({ 3 }));
+	CHECK(RemapSizes(FullScreen({ P::Distort, P::Spiral, P::HeatHaze, P::Underwater, P::Distort, P::Spiral, P::HeatHaze, P::Underwater }))
+	      == std::vector<int>({ MAX_UV_REMAP_EFFECTS, 2 }));
+
+	// Other effects and area effects end a run, chromatic distortion only starts one
+	CHECK(RemapSizes(FullScreen({ P::Distort, P::Spiral, P::Tint, P::HeatHaze, P::Underwater })) == std::vector<int>({ 2, 2 }));
+	CHECK(RemapSizes(FullScreen({ P::Distort, P::ChromaticDis, P::Spiral })) == std::vector<int>({ 2 }));
+	CHECK(RemapSizes(FullScreen({ P::ChromaticDis, P::Distort, P::Spiral })) == std::vector<int>({ 3 }));
+	CHECK(RemapSizes({ { P::Distort, PostProcessMode::Fullscreen }, { P::Spiral, PostProcessMode::Area } }).empty());
+}
+
+
+TEST(CPUUVRemapStages)
+{
+	// One stage for each effect in chain order
+	PostProcessEffectConstants settings = DefaultPostProcessEffectConstants(320, 180, 1.0f, 1000.0f);
+	PostProcessChain chain = FullScreen({ PostProcess::Tint, PostProcess::Underwater, PostProcess::Spiral, PostProcess::Distort });
+	UVRemapConstants constants = BuildUVRemap(chain, 1, 3, settings);
+	CHECK_EQUAL(3, constants.numStages);
+	CHECK_EQUAL(static_cast<int>(UVRemapKind::Underwater), constants.stages[0].kind);
+	CHECK_EQUAL(static_cast<int>(UVRemapKind::Spiral),     constants.stages[1].kind);
+	CHECK_EQUAL(static_cast<int>(UVRemapKind::Distort),    constants.stages[2].kind);
+	CHECK(std::fabs(constants.stages[1].amount - settings.spiral.spiralLevel * settings.spiral.spiralLevel) < 1e-4f);
+}
+
+
+TEST(CPUUVRemapMatchesEffects)
+{
+	// On a smooth image each effect on its own is within an 8-bit step of the fused pass, and runs are close. Runs starting with
+	// chromatic distortion differ more, at the rim of the black border it leaves
+	TestFrame test(240, 136);
+	FillGradient(test.mScene);
+	using P = PostProcess;
+	std::vector<PostProcessChain> singles = { FullScreen({ P::Distort }), FullScreen({ P::Spiral }), FullScreen({ P::HeatHaze }),
+	                                          FullScreen({ P::Underwater }), FullScreen({ P::ChromaticDis }) };
+	for (const CPUUVRemapTiming& timing : MeasureUVRemap(singles, test.mFrame, 2, 1))
+	{
+		CHECK(timing.maxDifference <= 1);
+	}
+
+	std::vector<PostProcessChain> runs = { FullScreen({ P::Distort, P::Spiral }), FullScreen({ P::Underwater, P::HeatHaze, P::Distort }),
+	                                       FullScreen({ P::Distort, P::Spiral, P::HeatHaze, P::Underwater, P::Distort }) };
+	for (const CPUUVRemapTiming& timing : MeasureUVRemap(runs, test.mFrame, 2, 1))
+	{
+		CHECK(timing.psnr >= 50.0);
+	}
+
+	std::vector<PostProcessChain> chromatic = { FullScreen({ P::ChromaticDis, P::Distort, P::Spiral, P::HeatHaze, P::Underwater, P::Distort }) };
+	std::vector<CPUUVRemapTiming> timings = MeasureUVRemap(chromatic, test.mFrame, 2, 1);
+	CHECK_EQUAL(1, static_cast<int>(timings.size()));
+	CHECK(timings[0].psnr >= 35.0);
+}
+
+
+TEST(CPUUVRemapDeviceMatchesEffects)
+{
+	// The device runs the run as one pass, close to running the effects one at a time
+	TestFrame test(160, 90);
+	FillGradient(test.mScene);
+	PostProcessChain chain = FullScreen({ PostProcess::Underwater, PostProcess::HeatHaze, PostProcess::Distort });
+	CPUPostProcessDevice device(2);
+	CPUImage fused, sequential;
+	PostProcessStats stats = device.Run(chain, test.mFrame, fused);
+	CHECK_EQUAL(1, stats.passes);
+
+	PostProcessChain separate = { chain[0], { PostProcess::Copy, PostProcessMode::Fullscreen }, chain[1],
+	                              { PostProcess::Copy, PostProcessMode::Fullscreen }, chain[2] };
+	device.Run(separate, test.mFrame, sequential);
+	CHECK(MaxDifference(fused, sequential) <= 2);
+}
@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------------------
+// Tests of combining runs of full screen colour effects (ColourTransform.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "ColourTransform.h"
+
+#include <random>
+
+
+static const PostProcessMode FULLSCREEN = PostProcessMode::Fullscreen;
+
+static const PostProcess COLOUR_EFFECTS[] = { PostProcess::Copy, PostProcess::Tint, PostProcess::Invert, PostProcess::Sepia,
+                                              PostProcess::VerticalGradient, PostProcess::HueVerticalGradient };
+
+
+static int CountPasses(const RenderGraph& graph, RenderPassType type)
+{
+	int count = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.type == type)  ++count;
+	}
+	return count;
+}
+
+
+TEST(ColourTransformMergesRuns)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Tint, FULLSCREEN }, { PostProcess::Sepia, FULLSCREEN }, { PostProcess::Invert, FULLSCREEN } });
+	CHECK_EQUAL(1, static_cast<int>(graph.Passes().size()));
+	CHECK_EQUAL(1, CountPasses(graph, RenderPassType::ColourTransform));
+	CHECK_EQUAL(3, graph.Passes()[0].batchSize);
+
+	// At most MAX_COLOUR_TRANSFORM_EFFECTS in a pass
+	PostProcessChain longChain(MAX_COLOUR_TRANSFORM_EFFECTS + 1, { PostProcess::Sepia, FULLSCREEN });
+	graph.Compile(longChain);
+	CHECK_EQUAL(2, static_cast<int>(graph.Passes().size()));
+
+	// A gradient ends a run, only the last stage can change down the screen
+	graph.Compile({ { PostProcess::VerticalGradient, FULLSCREEN }, { PostProcess::Tint, FULLSCREEN }, { PostProcess::Sepia, FULLSCREEN } });
+	CHECK_EQUAL(2, static_cast<int>(graph.Passes().size()));
+
+	// Only full screen effects
+	graph.Compile({ { PostProcess::Tint, FULLSCREEN }, { PostProcess::Sepia, PostProcessMode::Area } });
+	CHECK_EQUAL(0, CountPasses(graph, RenderPassType::ColourTransform));
+}
+
+
+TEST(ColourTransformCombinesExactStages)
+{
+	// Copy and invert always give whole 8-bit steps, so share a stage. Sepia doesn't, so has a stage of its own
+	PostProcessEffectConstants settings = DefaultPostProcessEffectConstants(640, 360, 1.0f, 10000.0f);
+	PostProcessChain chain = { { PostProcess::Copy, FULLSCREEN }, { PostProcess::Invert, FULLSCREEN }, { PostProcess::Sepia, FULLSCREEN },
+	                           { PostProcess::Invert, FULLSCREEN } };
+	CHECK_EQUAL(3, BuildColourTransform(chain, 0, 4, settings).numStages);
+	CHECK_EQUAL(1, BuildColourTransform(chain, 0, 2, settings).numStages);
+}
+
+
+TEST(ColourTransformMatchesEffectByEffect)
+{
+	// Random runs of colour effects with random settings, including tints that take channels past 1, run as one pass must
+	// give exactly what running the effects one at a time through 8-bit images gives
+	TestFrame test(64, 64);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> setting(0.0f, 1.3f);
+	for (int chainNumber = 0; chainNumber < 100; ++chainNumber)
+	{
+		PostProcessEffectConstants& settings = test.mFrame.effectConstants;
+		settings.tint.tintColour = { setting(random), setting(random), setting(random) };
+		settings.verticalGradient.topColour    = { setting(random), setting(random), setting(random) };
+		settings.verticalGradient.bottomColour = { setting(random), setting(random), setting(random) };
+		PostProcessChain chain;
+		int length = 2 + random() % 5;
+		for (int i = 0; i < length; ++i)  chain.push_back({ COLOUR_EFFECTS[random() % 6], FULLSCREEN });
+
+		CPUPostProcessDevice device(2);
+		CPUImage fused;
+		device.Run(chain, test.mFrame, fused);
+
+		CPUImage current = test.mScene, next;
+		for (const auto& entry : chain)
+		{
+			CPUPostProcessDevice single(1);
+			CPUPostProcessFrame frame = test.mFrame;
+			frame.sceneColour = &current;
+			single.Run({ entry }, frame, next);
+			current = next;
+		}
+		if (MaxDifference(fused, current) != 0)  ReportFailure(__FILE__, __LINE__, "Chain " + std::to_string(chainNumber) + " differs");
+	}
+}
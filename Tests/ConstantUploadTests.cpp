@@ -0,0 +1,284 @@
+//--------------------------------------------------------------------------------------
+// Tests of the constant buffer ring and uploads (ConstantRing.h, ConstantUpload.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "ConstantRing.h"
+#include "ConstantUpload.h"
+
+#include <cstring>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Ring
+//--------------------------------------------------------------------------------------
+
+TEST(ConstantRingAlignsBlocks)
+{
+	CHECK_EQUAL(256, ConstantRing::AlignedSize(1));
+	CHECK_EQUAL(256, ConstantRing::AlignedSize(256));
+	CHECK_EQUAL(512, ConstantRing::AlignedSize(257));
+
+	ConstantRing ring(4096);
+	ConstantRingAllocation a = ring.Allocate(64);
+	ConstantRingAllocation b = ring.Allocate(300);
+	ConstantRingAllocation c = ring.Allocate(16);
+	CHECK_EQUAL(0, a.offset);
+	CHECK_EQUAL(256, a.size);
+	CHECK_EQUAL(256, b.offset);
+	CHECK_EQUAL(512, b.size);
+	CHECK_EQUAL(768, c.offset);
+	CHECK_EQUAL(4096 - 1024, ring.Remaining());
+}
+
+
+TEST(ConstantRingDiscardsOnlyOnFirstUseAndWrap)
+{
+	ConstantRing ring(1024);
+	CHECK(ring.Allocate(256).discard); // A new buffer must be discarded before use
+	CHECK(!ring.Allocate(256).discard);
+	CHECK(!ring.Allocate(256).discard);
+
+	// Doesn't fit in the last 256 bytes, so starts again at the beginning
+	ConstantRingAllocation wrapped = ring.Allocate(512);
+	CHECK_EQUAL(0, wrapped.offset);
+	CHECK(wrapped.discard);
+	CHECK_EQUAL(1, ring.NumWraps());
+	CHECK(!ring.Allocate(256).discard);
+
+	ring.Wrap();
+	ConstantRingAllocation afterWrap = ring.Allocate(16);
+	CHECK_EQUAL(0, afterWrap.offset);
+	CHECK(afterWrap.discard);
+	CHECK_EQUAL(2, ring.NumWraps());
+}
+
+
+TEST(ConstantRingRejectsBlocksLargerThanBuffer)
+{
+	ConstantRing ring(1024);
+	ConstantRingAllocation allocation = ring.Allocate(1025);
+	CHECK_EQUAL(-1, allocation.offset);
+	CHECK_EQUAL(1280, allocation.size);
+	CHECK_EQUAL(1024, ring.Remaining()); // Nothing reserved
+}
+
+
+TEST(ConstantRingFrameStatistics)
+{
+	ConstantRing ring(4096);
+	ring.Allocate(64);
+	ring.Allocate(100);
+	CHECK_EQUAL(0, ring.LastFrameBlocks()); // Only complete frames are reported
+	ring.BeginFrame();
+	CHECK_EQUAL(2, ring.LastFrameBlocks());
+	CHECK_EQUAL(164, ring.LastFrameBytes()); // Not including alignment
+	ring.BeginFrame();
+	CHECK_EQUAL(0, ring.LastFrameBlocks());
+	CHECK_EQUAL(0, ring.LastFrameBytes());
+}
+
+
+//--------------------------------------------------------------------------------------
+// Uploads
+//--------------------------------------------------------------------------------------
+
+// A stand-in for the GPU buffer, made again when the uploader grows, as FlushConstantUploads does
+struct FakeConstantBuffer
+{
+	std::vector<char> memory;
+
+	void Flush(ConstantUploader& uploader)
+	{
+		if (uploader.FlushNeedsDiscard() && static_cast<int>(memory.size()) != uploader.Capacity())  memory.assign(uploader.Capacity(), 0);
+		uploader.Flush(memory.data());
+	}
+
+	float Read(const ConstantSlot& slot) const
+	{
+		float value;
+		memcpy(&value, memory.data() + slot.offset, sizeof(value));
+		return value;
+	}
+};
+
+
+TEST(ConstantUploadSkipsUnchangedBlocks)
+{
+	ConstantUploader uploader(4096);
+	FakeConstantBuffer buffer;
+	ConstantSlot slot;
+	float data[4] = { 1.0f };
+
+	uploader.BeginFrame();
+	uploader.Upload(slot, data, sizeof(data));
+	CHECK(uploader.NeedsFlush());
+	buffer.Flush(uploader);
+	int offset = slot.offset;
+
+	uploader.BeginFrame();
+	uploader.Upload(slot, data, sizeof(data));
+	CHECK(!uploader.NeedsFlush());
+	CHECK_EQUAL(offset, slot.offset);
+	uploader.BeginFrame();
+	CHECK_EQUAL(1, uploader.LastFrameSkippedBlocks());
+	CHECK_EQUAL(0, uploader.LastFrameWrittenBytes());
+	CHECK_EQUAL(0, uploader.LastFrameMaps());
+	CHECK_EQUAL(1.0f, buffer.Read(slot));
+}
+
+
+TEST(ConstantUploadWritesChangedBlocks)
+{
+	ConstantUploader uploader(4096);
+	FakeConstantBuffer buffer;
+	ConstantSlot slot;
+	float data[4] = { 1.0f };
+
+	uploader.BeginFrame();
+	uploader.Upload(slot, data, sizeof(data));
+	buffer.Flush(uploader);
+	int offset = slot.offset;
+
+	data[0] = 2.0f;
+	uploader.Upload(slot, data, sizeof(data));
+	CHECK(uploader.NeedsFlush());
+	CHECK(!uploader.FlushNeedsDiscard());
+	buffer.Flush(uploader);
+	CHECK(slot.offset != offset); // The old copy may still be in use by an earlier draw
+	CHECK_EQUAL(2.0f, buffer.Read(slot));
+
+	uploader.BeginFrame();
+	CHECK_EQUAL(static_cast<int>(2 * sizeof(data)), uploader.LastFrameRequestedBytes());
+	CHECK_EQUAL(static_cast<int>(2 * sizeof(data)), uploader.LastFrameWrittenBytes());
+	CHECK_EQUAL(2, uploader.LastFrameMaps());
+	CHECK_EQUAL(1, uploader.LastFrameDiscards()); // Only the first use of the buffer
+}
+
+
+TEST(ConstantUploadFlushWithoutBufferOnlyCounts)
+{
+	ConstantUploader uploader(4096);
+	ConstantSlot slots[3];
+	float data[8] = {};
+
+	uploader.BeginFrame();
+	for (ConstantSlot& slot : slots)  uploader.Upload(slot, data, sizeof(data));
+	uploader.Flush(nullptr);
+	CHECK(!uploader.NeedsFlush());
+	uploader.BeginFrame();
+	CHECK_EQUAL(static_cast<int>(3 * sizeof(data)), uploader.LastFrameWrittenBytes());
+	CHECK_EQUAL(1, uploader.LastFrameMaps());
+}
+
+
+TEST(ConstantUploadDiscardWritesFrameBlocksAgain)
+{
+	// A ring of four blocks. Fill most of it, then keep changing one block until the ring wraps part way through a frame
+	ConstantUploader uploader(1024);
+	FakeConstantBuffer buffer;
+	ConstantSlot fixed, changing;
+	float fixedData[4] = { 5.0f };
+
+	uploader.BeginFrame();
+	uploader.Upload(fixed, fixedData, sizeof(fixedData));
+	buffer.Flush(uploader);
+	int generation = uploader.Generation();
+
+	for (int i = 0; i < 4; ++i)
+	{
+		float changingData[4] = { static_cast<float>(i) };
+		uploader.Upload(changing, changingData, sizeof(changingData));
+		buffer.Flush(uploader);
+		CHECK_EQUAL(static_cast<float>(i), buffer.Read(changing));
+		CHECK_EQUAL(5.0f, buffer.Read(fixed)); // Still valid where it is bound now, even after the discard
+	}
+	CHECK_EQUAL(generation + 1, uploader.Generation());
+	CHECK_EQUAL(fixed.generation, uploader.Generation());
+	CHECK_EQUAL(1024, uploader.Capacity()); // Two blocks fit in half the buffer, so no need to grow
+
+	uploader.BeginFrame();
+	CHECK_EQUAL(2, uploader.LastFrameDiscards()); // First use and the wrap
+}
+
+
+TEST(ConstantUploadGrowsWhenFrameOverflows)
+{
+	// Many unchanging blocks (e.g. static models) and one that changes every frame (e.g. the per-frame constants), more than
+	// fit in the buffer. The first frame grows the buffer, after which frames fit and the unchanging blocks are skipped
+	const int numSlots = 5000;
+	const int initialCapacity = 1024 * 1024;
+	ConstantUploader uploader(initialCapacity);
+	FakeConstantBuffer buffer;
+	std::vector<ConstantSlot> slots(numSlots);
+	ConstantSlot perFrame;
+
+	uploader.BeginFrame();
+	for (int frame = 0; frame < 4; ++frame)
+	{
+		float perFrameData[16] = { static_cast<float>(frame) };
+		uploader.Upload(perFrame, perFrameData, sizeof(perFrameData));
+		buffer.Flush(uploader);
+
+		int generation = uploader.Generation();
+		for (int i = 0; i < numSlots; ++i)
+		{
+			float data[48] = { static_cast<float>(i) };
+			uploader.Upload(slots[i], data, sizeof(data));
+			buffer.Flush(uploader);
+
+			// The per-frame block was bound before any of these uploads, it must still hold this frame's data
+			if (buffer.Read(perFrame) != static_cast<float>(frame) || buffer.Read(slots[i]) != static_cast<float>(i))
+			{
+				CHECK(!"Block lost after the buffer filled");
+				return;
+			}
+		}
+		if (frame > 0)  CHECK_EQUAL(generation, uploader.Generation()); // Steady frames don't discard
+		uploader.BeginFrame();
+
+		if (frame == 0)
+		{
+			CHECK(uploader.LastFrameDiscards() > 0);
+			CHECK(uploader.Capacity() >= 2 * (numSlots + 1) * 256);
+		}
+		else
+		{
+			CHECK_EQUAL(0, uploader.LastFrameDiscards());
+			CHECK_EQUAL(numSlots, uploader.LastFrameSkippedBlocks());
+			CHECK_EQUAL(64, uploader.LastFrameWrittenBytes());
+		}
+	}
+	for (int i = 0; i < numSlots; ++i)
+	{
+		if (buffer.Read(slots[i]) != static_cast<float>(i))  { CHECK(!"Skipped block not in the buffer"); break; }
+	}
+}
+
+
+TEST(ConstantUploadSeparateSkeletonBlock)
+{
+	// Sizes of PerModelConstants and PerSkeletonConstants (Common.h). Rigid nodes only send the small block, and a moving
+	// skeleton only rewrites its own bones, not the node blocks around it
+	const int modelBytes    = 80;
+	const int skeletonBytes = 64 * 64;
+	ConstantUploader uploader(64 * 1024);
+	std::vector<ConstantSlot> rigidNodes(10);
+	ConstantSlot skinnedNode, skeleton;
+	std::vector<char> model(modelBytes), bones(skeletonBytes);
+
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		uploader.BeginFrame();
+		for (ConstantSlot& node : rigidNodes)  uploader.Upload(node, model.data(), modelBytes);
+		bones[0] = static_cast<char>(frame); // Animated
+		uploader.Upload(skinnedNode, model.data(), modelBytes);
+		uploader.Upload(skeleton, bones.data(), skeletonBytes);
+		uploader.Flush(nullptr);
+	}
+	uploader.BeginFrame();
+	CHECK_EQUAL(11 * modelBytes + skeletonBytes, uploader.LastFrameRequestedBytes());
+	CHECK_EQUAL(skeletonBytes, uploader.LastFrameWrittenBytes());
+	CHECK_EQUAL(11, uploader.LastFrameSkippedBlocks());
+}
@@ -0,0 +1,132 @@
+//--------------------------------------------------------------------------------------
+// Tests of Gaussian blur kernels of any width (GaussianKernel.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "TestImages.h"
+#include "GaussianKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+static const PostProcessChain FULLSCREEN_BLUR = { { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen },
+                                                  { PostProcess::GaussianBlurVertical, PostProcessMode::Fullscreen } };
+
+
+// Largest difference in 8-bit steps between the blurred image and an exact Gaussian blur of the scene (clamped at the edges),
+// ignoring pixels within 3 sigma of the edges
+static float InteriorError(const CPUImage& scene, const CPUImage& blurred, float sigma)
+{
+	int width = scene.Width(), height = scene.Height();
+	int radius = static_cast<int>(std::ceil(4.0f * sigma));
+	std::vector<double> weights(radius + 1);
+	double total = 0;
+	for (int i = 0; i <= radius; ++i)
+	{
+		weights[i] = std::exp(-i * i / (2.0 * sigma * sigma));
+		total += (i == 0) ? weights[i] : 2 * weights[i];
+	}
+
+	// Rows first, then columns of the rows' results, in each colour channel
+	std::vector<double> rows(static_cast<size_t>(width) * height * 3);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			for (int i = -radius; i <= radius; ++i)
+			{
+				const CVector4& pixel = scene.Pixel(std::min(std::max(x + i, 0), width - 1), y);
+				double weight = weights[std::abs(i)] / total;
+				double* row = &rows[(static_cast<size_t>(y) * width + x) * 3];
+				row[0] += pixel.x * weight;
+				row[1] += pixel.y * weight;
+				row[2] += pixel.z * weight;
+			}
+		}
+	}
+
+	double maxError = 0;
+	int margin = static_cast<int>(3.0f * sigma);
+	for (int y = margin; y < height - margin; ++y)
+	{
+		for (int x = margin; x < width - margin; ++x)
+		{
+			double exact[3] = {};
+			for (int i = -radius; i <= radius; ++i)
+			{
+				const double* row = &rows[(static_cast<size_t>(std::min(std::max(y + i, 0), height - 1)) * width + x) * 3];
+				for (int channel = 0; channel < 3; ++channel)  exact[channel] += row[channel] * weights[std::abs(i)] / total;
+			}
+			const CVector4& pixel = blurred.Pixel(x, y);
+			maxError = std::max({ maxError, std::fabs(pixel.x - exact[0]), std::fabs(pixel.y - exact[1]), std::fabs(pixel.z - exact[2]) });
+		}
+	}
+	return static_cast<float>(maxError * 255.0);
+}
+
+
+TEST(GaussianKernelWeightsSumToOne)
+{
+	for (float sigma : { 0.2f, 0.5f, 1.0f, 2.0f, 4.0f, 5.0f, 8.0f, 32.0f, 256.0f })
+	{
+		GaussianBlurConstants settings = {};
+		settings.blurSigma = sigma;
+		SetGaussianBlurKernel(settings, 1 << GaussianBlurLevels(sigma));
+		float sum = settings.taps[0].y;
+		for (int tap = 1; tap < settings.numTaps; ++tap)  sum += 2.0f * settings.taps[tap].y;
+		CHECK(std::fabs(sum - 1.0f) < 1e-5f);
+		CHECK(settings.numTaps >= 1 && settings.numTaps <= GAUSSIAN_MAX_TAPS);
+	}
+}
+
+
+TEST(GaussianKernelLevels)
+{
+	// Blurs up to GAUSSIAN_MAX_LEVEL_SIGMA run at full size, each doubling of the width halves the image once more
+	CHECK_EQUAL(0, GaussianBlurLevels(1.0f));
+	CHECK_EQUAL(0, GaussianBlurLevels(GAUSSIAN_MAX_LEVEL_SIGMA));
+	CHECK_EQUAL(1, GaussianBlurLevels(8.0f));
+	CHECK_EQUAL(2, GaussianBlurLevels(16.0f));
+	CHECK_EQUAL(GAUSSIAN_MAX_LEVELS, GaussianBlurLevels(10000.0f));
+
+	// The graph halves the image once for each level before the blur, then scales it back up in one go
+	RenderGraph graph;
+	graph.Compile(FULLSCREEN_BLUR, GaussianBlurLevels(16.0f));
+	int resamples = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		if (pass.type == RenderPassType::Resample)  ++resamples;
+	}
+	CHECK_EQUAL(3, resamples);
+}
+
+
+TEST(GaussianKernelMatchesExactBlur)
+{
+	// Within two 8-bit steps of an exact Gaussian away from the edges, at full size and on smaller images
+	TestFrame test(128, 128, TestScene::Smooth);
+	for (float sigma : { 2.0f, 4.0f, 8.0f })
+	{
+		test.mFrame.effectConstants.gaussianBlur.blurSigma = sigma;
+		CPUPostProcessDevice device(2);
+		CPUImage output;
+		device.Run(FULLSCREEN_BLUR, test.mFrame, output);
+		CHECK(InteriorError(test.mScene, output, sigma) <= 2.0f);
+	}
+}
+
+
+TEST(GaussianKernelRowsMatchPerPixel)
+{
+	// Full screen blurs run a row at a time, area blurs pixel by pixel as the shader
+	TestFrame test(96, 64);
+	test.mFrame.sceneDepth = nullptr;
+	test.mFrame.effectConstants.gaussianBlur.blurSigma = GAUSSIAN_MAX_LEVEL_SIGMA;
+	CPUPostProcessDevice device(1);
+	CPUImage rows, perPixel;
+	device.Run(FULLSCREEN_BLUR, test.mFrame, rows);
+	device.Run({ { PostProcess::GaussianBlurHorizontal, PostProcessMode::Area }, { PostProcess::GaussianBlurVertical, PostProcessMode::Area } },
+	           test.mFrame, perPixel);
+	CHECK(MaxDifference(rows, perPixel) <= 1);
+}
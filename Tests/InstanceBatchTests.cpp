@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------
+// Tests of instance packing (InstanceBatch.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "InstanceBatch.h"
+
+
+// Copies of a mesh in a row along x, each tinted by its number
+static std::vector<MeshInstance> Row(int numInstances)
+{
+	std::vector<MeshInstance> instances(numInstances);
+	for (int i = 0; i < numInstances; ++i)
+	{
+		instances[i].worldMatrix = MatrixTranslation({ static_cast<float>(i), 0.0f, 0.0f });
+		instances[i].tint = { static_cast<float>(i), 1.0f, 1.0f };
+	}
+	return instances;
+}
+
+
+TEST(InstanceBatchSplitsDrawsPerNode)
+{
+	// Three nodes, the last with no geometry. 2500 copies need three draws for each of the first two nodes
+	std::vector<CMatrix4x4> nodeMatrices = { MatrixIdentity(), MatrixTranslation({ 0.0f, 5.0f, 0.0f }), MatrixIdentity() };
+	InstanceBatch batch;
+	batch.Build(Row(2500), nodeMatrices, { true, true, false });
+
+	CHECK_EQUAL(5000, static_cast<int>(batch.Instances().size()));
+	const std::vector<InstanceDraw>& draws = batch.Draws();
+	CHECK_EQUAL(6, static_cast<int>(draws.size()));
+	int expectedFirst = 0;
+	for (int i = 0; i < static_cast<int>(draws.size()); ++i)
+	{
+		CHECK_EQUAL(i / 3, draws[i].node);
+		CHECK_EQUAL(expectedFirst, draws[i].firstInstance);
+		CHECK(draws[i].numInstances <= MAX_INSTANCES_PER_DRAW);
+		expectedFirst += draws[i].numInstances;
+	}
+	CHECK_EQUAL(452, draws[2].numInstances);
+}
+
+
+TEST(InstanceBatchCombinesNodeAndCopyMatrices)
+{
+	// The root's own matrix is replaced by the copy's, child nodes are placed relative to the copy
+	std::vector<CMatrix4x4> nodeMatrices = { MatrixTranslation({ 100.0f, 0.0f, 0.0f }), MatrixTranslation({ 0.0f, 5.0f, 0.0f }) };
+	InstanceBatch batch;
+	batch.Build(Row(10), nodeMatrices, { true, true });
+
+	CVector3 root  = batch.Instances()[7].worldMatrix.GetRow(3);
+	CVector3 child = batch.Instances()[10 + 7].worldMatrix.GetRow(3);
+	CHECK(root.x == 7.0f && root.y == 0.0f);
+	CHECK(child.x == 7.0f && child.y == 5.0f);
+	CHECK_EQUAL(7.0f, batch.Instances()[10 + 7].tint.x);
+}
+
+
+TEST(InstanceBatchEmpty)
+{
+	InstanceBatch batch;
+	batch.Build({}, { MatrixIdentity() }, { true });
+	CHECK(batch.Instances().empty());
+	CHECK(batch.Draws().empty());
+
+	batch.Build(Row(5), { MatrixIdentity() }, { true }, 2);
+	CHECK_EQUAL(3, static_cast<int>(batch.Draws().size()));
+}
@@ -0,0 +1,87 @@
+//--------------------------------------------------------------------------------------
+// Tests of the nearest palette colour index (PaletteIndex.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "PaletteIndex.h"
+
+#include <cmath>
+
+
+TEST(PaletteIndexMatchesFullSearch)
+{
+	// Every palette size the retro game effect uses, over a grid of 8-bit colours and on the edges of the index's cells
+	for (int paletteSize = 1; paletteSize <= RETRO_GAME_PALETTE_SIZE; ++paletteSize)
+	{
+		const PaletteIndex& index = RetroGamePaletteIndex(paletteSize);
+		int mismatches = 0;
+		for (int r = 0; r < 256; r += 5)
+		{
+			for (int g = 0; g < 256; g += 5)
+			{
+				for (int b = 0; b < 256; b += 5)
+				{
+					CVector3 colour(r / 255.0f, g / 255.0f, b / 255.0f);
+					if (index.Nearest(colour) != NearestPaletteEntry(RETRO_GAME_PALETTE, paletteSize, colour))  ++mismatches;
+				}
+			}
+		}
+		for (int r = 0; r <= PALETTE_GRID_SIZE; ++r)
+		{
+			for (int g = 0; g <= PALETTE_GRID_SIZE; ++g)
+			{
+				for (int b = 0; b <= PALETTE_GRID_SIZE; ++b)
+				{
+					CVector3 colour(static_cast<float>(r) / PALETTE_GRID_SIZE, static_cast<float>(g) / PALETTE_GRID_SIZE,
+					                static_cast<float>(b) / PALETTE_GRID_SIZE);
+					if (index.Nearest(colour) != NearestPaletteEntry(RETRO_GAME_PALETTE, paletteSize, colour))  ++mismatches;
+				}
+			}
+		}
+		if (mismatches > 0)  ReportFailure(__FILE__, __LINE__, std::to_string(mismatches) + " mismatches with palette size " + std::to_string(paletteSize));
+	}
+}
+
+
+TEST(PaletteIndexOutOfRangeColours)
+{
+	// Colours outside 0->1 aren't in the grid, they fall back to the full search
+	const PaletteIndex& index = RetroGamePaletteIndex(RETRO_GAME_PALETTE_SIZE);
+	for (CVector3 colour : { CVector3(1.5f, 0.2f, 0.2f), CVector3(-0.3f, 0.5f, 2.0f), CVector3(0.5f, 0.5f, -1.0f) })
+	{
+		CHECK_EQUAL(NearestPaletteEntry(RETRO_GAME_PALETTE, RETRO_GAME_PALETTE_SIZE, colour), index.Nearest(colour));
+	}
+
+	PaletteIndex empty;
+	empty.Build(nullptr, 0);
+	CHECK_EQUAL(-1, empty.Nearest(CVector3(0.5f, 0.5f, 0.5f)));
+}
+
+
+TEST(PaletteIndexIsMostlySingleEntries)
+{
+	const PaletteIndex& index = RetroGamePaletteIndex(RETRO_GAME_PALETTE_SIZE);
+	CHECK(index.AverageCandidates() >= 1.0f && index.AverageCandidates() < 2.0f);
+	CHECK(static_cast<int>(index.Data().size()) > PALETTE_GRID_SIZE * PALETTE_GRID_SIZE * PALETTE_GRID_SIZE);
+}
+
+
+TEST(PaletteIndexOrderedDither)
+{
+	// Each step of the 4x4 pattern used once, centred on 0
+	float sum = 0.0f;
+	bool used[16] = {};
+	for (int y = 0; y < 4; ++y)
+	{
+		for (int x = 0; x < 4; ++x)
+		{
+			float dither = OrderedDither(x, y);
+			CHECK(dither > -0.5f && dither < 0.5f);
+			used[static_cast<int>((dither + 0.5f) * 16.0f)] = true;
+			sum += dither;
+			CHECK_EQUAL(dither, OrderedDither(x + 4, y + 8)); // Repeats
+		}
+	}
+	for (bool step : used)  CHECK(step);
+	CHECK(std::fabs(sum) < 1e-5f);
+}
@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------
+// Tests of batching window polygons into instanced draws (PolygonBatch.h)
+//--------------------------------------------------------------------------------------
+// With an identity view-projection matrix the points are already in clip space, so x and y from
+// -1 to 1 cover the viewport
+
+#include "Test.h"
+#include "PolygonBatch.h"
+#include "RenderGraph.h"
+
+
+static const int VIEWPORT_WIDTH  = 1000;
+static const int VIEWPORT_HEIGHT = 500;
+
+
+// A rectangular polygon from (left, top) to (right, bottom) in clip space, in the point order of the 2DPolygon shader
+static PolygonBatchItem Rectangle(PostProcess effect, float left, float top, float right, float bottom)
+{
+	PolygonBatchItem item;
+	item.effect = effect;
+	item.points = { CVector3(left, top, 0.5f), CVector3(left, bottom, 0.5f), CVector3(right, top, 0.5f), CVector3(right, bottom, 0.5f) };
+	item.parameters[0] = { 1, 2, 3, 4 };
+	item.parameters[1] = { 5, 6, 7, 8 };
+	return item;
+}
+
+
+TEST(PolygonBatchNeighboursShareADraw)
+{
+	// Three windows side by side, sharing edges
+	std::vector<PolygonBatchItem> items = { Rectangle(PostProcess::Sepia,   -0.9f, 0.5f, -0.5f, -0.5f),
+	                                        Rectangle(PostProcess::Invert,  -0.5f, 0.5f,  0.0f, -0.5f),
+	                                        Rectangle(PostProcess::GameBoy,  0.0f, 0.5f,  0.5f, -0.5f) };
+	PolygonBatch batch;
+	batch.Build(items, MatrixIdentity(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+
+	CHECK_EQUAL(3, static_cast<int>(batch.Instances().size()));
+	CHECK_EQUAL(1, static_cast<int>(batch.Draws().size()));
+	if (batch.Draws().size() != 1)  return;
+	CHECK_EQUAL(0, batch.Draws()[0].firstInstance);
+	CHECK_EQUAL(3, batch.Draws()[0].numInstances);
+
+	// Each instance has its effect number in the batch shader and its settings
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		CHECK_EQUAL(GetPostProcessDeclaration(items[i].effect).polygonBatchEffect, batch.Instances()[i].effect);
+		CHECK_EQUAL(4.0f, batch.Instances()[i].parameters[0].w);
+		CHECK_EQUAL(5.0f, batch.Instances()[i].parameters[1].x);
+	}
+
+	// The first window covers x from 0.05 to 0.25 of the viewport and y from 0.25 to 0.75
+	const PixelRect& drawRect = batch.Draws()[0].drawRects[0];
+	CHECK_EQUAL(50,  drawRect.left);
+	CHECK_EQUAL(125, drawRect.top);
+	CHECK_EQUAL(250, drawRect.right);
+	CHECK_EQUAL(375, drawRect.bottom);
+}
+
+
+TEST(PolygonBatchOverlapStartsNewDraw)
+{
+	// The second polygon covers part of the first, so it must be drawn after the first has been written
+	std::vector<PolygonBatchItem> items = { Rectangle(PostProcess::Sepia,  -0.5f, 0.5f, 0.5f, -0.5f),
+	                                        Rectangle(PostProcess::Invert,  0.0f, 0.2f, 0.8f, -0.2f),
+	                                        Rectangle(PostProcess::Sepia,   0.8f, 0.2f, 0.9f, -0.2f) };
+	PolygonBatch batch;
+	batch.Build(items, MatrixIdentity(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+
+	CHECK_EQUAL(2, static_cast<int>(batch.Draws().size()));
+	if (batch.Draws().size() != 2)  return;
+	CHECK_EQUAL(1, batch.Draws()[0].numInstances);
+	CHECK_EQUAL(1, batch.Draws()[1].firstInstance);
+	CHECK_EQUAL(2, batch.Draws()[1].numInstances);
+}
+
+
+TEST(PolygonBatchCopiesHalo)
+{
+	// The wireframe reads 2 pixels around what it draws, sepia only its own pixels
+	std::vector<PolygonBatchItem> items = { Rectangle(PostProcess::Wireframe, -0.5f, 0.5f, 0.0f, -0.5f),
+	                                        Rectangle(PostProcess::Sepia,      0.0f, 0.5f, 0.5f, -0.5f) };
+	PolygonBatch batch;
+	batch.Build(items, MatrixIdentity(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	if (batch.Draws().size() != 1)
+	{
+		CHECK_EQUAL(1, static_cast<int>(batch.Draws().size()));
+		return;
+	}
+
+	const PolygonBatchDraw& draw = batch.Draws()[0];
+	CHECK_EQUAL(draw.drawRects[0].left - 2,  draw.copyRects[0].left);
+	CHECK_EQUAL(draw.drawRects[0].right + 2, draw.copyRects[0].right);
+	CHECK_EQUAL(draw.drawRects[1].left,      draw.copyRects[1].left);
+	CHECK_EQUAL(draw.copyRects[0].Area() + draw.copyRects[1].Area(), batch.CopiedPixels());
+}
+
+
+TEST(PolygonBatchSkipsHiddenAndUnbatchedPolygons)
+{
+	// Off screen, and an effect with no version in the batch shader
+	std::vector<PolygonBatchItem> items = { Rectangle(PostProcess::Sepia, 1.5f, 0.5f, 2.0f, -0.5f),
+	                                        Rectangle(PostProcess::Burn, -0.5f, 0.5f, 0.5f, -0.5f),
+	                                        Rectangle(PostProcess::Invert, -0.5f, 0.5f, 0.5f, -0.5f) };
+	PolygonBatch batch;
+	batch.Build(items, MatrixIdentity(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	CHECK_EQUAL(1, static_cast<int>(batch.Instances().size()));
+	CHECK_EQUAL(1, static_cast<int>(batch.Draws().size()));
+
+	batch.Build({}, MatrixIdentity(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	CHECK(batch.Instances().empty());
+	CHECK(batch.Draws().empty());
+}
+
+
+TEST(PolygonBatchSplitsFullDraws)
+{
+	// A row of tiny windows, apart so they don't overlap, one more than fits in a draw
+	std::vector<PolygonBatchItem> items;
+	for (int i = 0; i <= MAX_BATCHED_POLYGONS; ++i)
+	{
+		float left = -0.95f + 0.05f * i;
+		items.push_back(Rectangle(PostProcess::Sepia, left, 0.01f, left + 0.01f, -0.01f));
+	}
+	PolygonBatch batch;
+	batch.Build(items, MatrixIdentity(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	CHECK_EQUAL(2, static_cast<int>(batch.Draws().size()));
+	if (batch.Draws().size() == 2)  CHECK_EQUAL(MAX_BATCHED_POLYGONS, batch.Draws()[0].numInstances);
+}
+
+
+TEST(PolygonBatchFromRenderGraph)
+{
+	// Consecutive window polygons with batched versions compile to one in-place batch pass
+	PostProcessChain chain;
+	for (PostProcess effect : { PostProcess::Sepia, PostProcess::Wireframe, PostProcess::GameBoy, PostProcess::Invert, PostProcess::Distort })
+	{
+		chain.push_back({ effect, PostProcessMode::WindowPolygon });
+	}
+	chain.push_back({ PostProcess::GreyNoise, PostProcessMode::Fullscreen });
+	RenderGraph graph;
+	graph.Compile(chain);
+
+	const RenderPass& batchPass = graph.Passes()[0];
+	CHECK(batchPass.type == RenderPassType::PolygonBatch);
+	CHECK(batchPass.inPlace);
+	CHECK_EQUAL(0, batchPass.chainIndex);
+	CHECK_EQUAL(5, batchPass.batchSize);
+	CHECK_EQUAL(SCENE_COLOUR_RESOURCE, batchPass.output);
+	CHECK_EQUAL(2, static_cast<int>(graph.Passes().size()));
+}
@@ -0,0 +1,544 @@
+//--------------------------------------------------------------------------------------
+// Timings of the CPU post-processing and the planning code
+//--------------------------------------------------------------------------------------
+// Runs the Measure functions of CPUPostProcessDevice.h (and others), and times the render target
+// pool and the instance batching, and prints their tables.
+// Each section is one of the measurements quoted when an optimisation was made, at the frame size
+// it was quoted at, so the figures can be checked on another machine:
+//
+//   PostProcessBenchmark [section] [--quick]
+//
+// Runs every section whose name starts with the given one, or all sections. --quick runs each
+// section once on small frames, to check they all still run (ctest does this), the timings are
+// then meaningless. Build in release for real timings
+
+#include "TestImages.h"
+#include "PaletteIndex.h"
+#include "Bloom.h"
+#include "GaussianKernel.h"
+#include "InstanceBatch.h"
+#include "ConstantUpload.h"
+#include "MathHelpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+
+struct BenchmarkSettings
+{
+	bool quick      = false;
+	int  numRuns    = 3; // Fastest of this many runs is reported
+	int  numThreads = 0; // Threads for the sections that don't compare thread counts, 0 for one per processor core
+};
+
+
+// Size of frame to use for a section measured at the given size, much smaller in a quick run
+static int FrameSize(const BenchmarkSettings& settings, int size)
+{
+	return settings.quick ? std::max(size / 10, 32) : size;
+}
+
+// Time the work the given number of times (at least once) and return the fastest, in milliseconds
+static double FastestRun(int numRuns, const std::function<void()>& work)
+{
+	double best = 0;
+	for (int run = 0; run < std::max(numRuns, 1); ++run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		work();
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (run == 0 || milliseconds < best)  best = milliseconds;
+	}
+	return best;
+}
+
+static const char* EffectName(PostProcess effect)
+{
+	static const char* names[] =
+	{
+		"None", "Copy", "Tint", "GreyNoise", "Burn", "Distort", "Spiral", "HeatHaze", "VerticalGradient", "Underwater",
+		"HueVerticalGradient", "GaussianBlurHorizontal", "GaussianBlurVertical", "MotionBlur", "RetroGame", "BrightPass",
+		"LensStar", "Bloom", "DepthOfField", "Wireframe", "Fog", "Invert", "NightVision", "GameBoy", "Sepia", "ChromaticDis",
+		"Dilation", "OnePassBlur"
+	};
+	return names[static_cast<int>(effect)];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sections
+//--------------------------------------------------------------------------------------
+
+// Render targets for representative chains at 1080p, pooled (see RenderTargetPool.h) and with one texture for each image,
+// then for all of them switched between every frame
+static void BenchmarkRenderTargets(const BenchmarkSettings& settings)
+{
+	const int width = 1920, height = 1080;
+	const int numFrames = settings.quick ? 4 : 100;
+	auto fullScreen = [](std::initializer_list<PostProcess> effects)
+	{
+		PostProcessChain chain;
+		for (PostProcess effect : effects)  chain.push_back({ effect, PostProcessMode::Fullscreen });
+		return chain;
+	};
+	struct Chain
+	{
+		const char*      name;
+		PostProcessChain chain;
+		int              blurLevels;
+	};
+	using P = PostProcess;
+	std::vector<Chain> chains =
+	{
+		{ "Bloom",          fullScreen({ P::Bloom }), 0 },
+		{ "DepthOfField",   fullScreen({ P::DepthOfField }), 0 },
+		{ "Blur sigma 32",  fullScreen({ P::GaussianBlurHorizontal, P::GaussianBlurVertical }), GaussianBlurLevels(32.0f) },
+		{ "Blur sigma 128", fullScreen({ P::GaussianBlurHorizontal, P::GaussianBlurVertical }), GaussianBlurLevels(128.0f) },
+		{ "Mixed",          fullScreen({ P::Tint, P::GaussianBlurHorizontal, P::GaussianBlurVertical, P::Bloom, P::DepthOfField,
+		                                 P::Underwater, P::Sepia }), GaussianBlurLevels(16.0f) },
+	};
+
+	const double bytesPerMB = 1024.0 * 1024.0;
+	printf("%dx%d, %d frames\n", width, height, numFrames);
+	printf("%-16s %8s %8s %12s %12s %12s %12s\n", "Chain", "Images", "Slots", "Unpooled MB", "Peak MB", "Average MB", "Allocate us");
+	for (int chain = 0; chain <= static_cast<int>(chains.size()); ++chain)
+	{
+		// The last row switches to the next chain every frame
+		bool switching = chain == static_cast<int>(chains.size());
+		std::vector<RenderGraph> graphs(switching ? chains.size() : 1);
+		for (unsigned int graph = 0; graph < graphs.size(); ++graph)
+		{
+			const Chain& compiled = chains[switching ? graph : chain];
+			graphs[graph].Compile(compiled.chain, compiled.blurLevels);
+		}
+
+		RenderTargetAllocator allocator;
+		int64_t unpooledBytes = 0;
+		int maxSlots = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			allocator.BeginFrame();
+			graphs[frame % graphs.size()].AllocateTargets(allocator, width, height);
+			allocator.EndFrame();
+			unpooledBytes = std::max(unpooledBytes, allocator.RequestedBytes());
+			maxSlots = std::max(maxSlots, allocator.NumAliveSlots());
+		}
+		double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / numFrames;
+
+		int images = 0;
+		for (const GraphResource& resource : graphs[0].Resources())
+		{
+			if (resource.type == GraphResourceType::SceneColour || (resource.type == GraphResourceType::Transient && resource.firstUse >= 0))  ++images;
+		}
+		printf("%-16s %8s %8d %12.1f %12.1f %12.1f %12.2f\n", switching ? "Switching" : chains[chain].name,
+		       switching ? "-" : std::to_string(images).c_str(), maxSlots, unpooledBytes / bytesPerMB, allocator.PeakBytes() / bytesPerMB,
+		       allocator.AverageBytes() / bytesPerMB, microseconds);
+	}
+}
+
+
+// The stress test's 2500 crates (see Scene.cpp) as a model each and with instancing (see InstanceBatch.h), for meshes of one
+// and of several nodes. A model each, the CPU finds each node's world matrix and uploads its constants with the same
+// skipping of unchanged blocks as the app - with no GPU they are only hashed and counted. Instanced, it packs the batch
+static void BenchmarkInstanceBatch(const BenchmarkSettings& settings)
+{
+	const int rows = 50; // STRESS_CRATE_ROWS
+	std::vector<MeshInstance> crates;
+	for (int row = 0; row < rows; ++row)
+	{
+		for (int column = 0; column < rows; ++column)
+		{
+			MeshInstance crate;
+			crate.worldMatrix = MatrixScaling(1.5f) * MatrixRotationY(ToRadians((row * rows + column) * 7.0f)) *
+			                    MatrixTranslation({ -300.0f + column * 12.0f, 0.0f, 150.0f + row * 12.0f });
+			crate.tint    = { 1, 1, 1 };
+			crate.padding = 0;
+			crates.push_back(crate);
+		}
+	}
+
+	// Same layout as PerModelConstants in Common.h
+	struct ModelConstants
+	{
+		CMatrix4x4 worldMatrix;
+		CVector3   objectColour;
+		float      explodeAmount;
+		CMatrix4x4 previousWorldMatrix;
+	};
+
+	printf("%d copies, one thread\n", static_cast<int>(crates.size()));
+	printf("%8s %14s %12s %16s %10s\n", "Nodes", "Model draws", "Models ms", "Instanced draws", "Build ms");
+	for (int numNodes : { 1, 4, 16 })
+	{
+		// A chain of nodes, each a little above its parent
+		std::vector<CMatrix4x4> nodeMatrices(numNodes, MatrixTranslation({ 0.0f, 1.0f, 0.0f }));
+		std::vector<bool> nodeHasGeometry(numNodes, true);
+
+		// A model each - as Mesh::Render for rigid meshes, then the draws it would make
+		ConstantUploader uploader(1024 * 1024);
+		std::vector<ConstantSlot> nodeSlots(crates.size() * numNodes);
+		ModelConstants constants = {};
+		int modelDraws = 0;
+		auto renderModels = [&]()
+		{
+			uploader.BeginFrame();
+			modelDraws = 0;
+			for (unsigned int crate = 0; crate < crates.size(); ++crate)
+			{
+				std::vector<CMatrix4x4> absoluteMatrices(numNodes);
+				absoluteMatrices[0] = crates[crate].worldMatrix;
+				for (int node = 1; node < numNodes; ++node)  absoluteMatrices[node] = nodeMatrices[node] * absoluteMatrices[node - 1];
+				for (int node = 0; node < numNodes; ++node)
+				{
+					constants.worldMatrix = constants.previousWorldMatrix = absoluteMatrices[node];
+					uploader.Upload(nodeSlots[crate * numNodes + node], &constants, sizeof(constants));
+					uploader.Flush(nullptr);
+					++modelDraws;
+				}
+			}
+		};
+		renderModels(); // The crates don't move, so after the first frame their blocks are unchanged as in the app
+		double modelsMilliseconds = FastestRun(settings.numRuns, renderModels);
+
+		InstanceBatch batch;
+		double buildMilliseconds = FastestRun(settings.numRuns, [&]() { batch.Build(crates, nodeMatrices, nodeHasGeometry); });
+		printf("%8d %14d %12.2f %16d %10.2f\n", numNodes, modelDraws, modelsMilliseconds, static_cast<int>(batch.Draws().size()),
+		       buildMilliseconds);
+	}
+}
+
+
+// Each effect on its own, full screen, as a headless batch job would run it
+static void BenchmarkEffects(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 1920), FrameSize(settings, 1080));
+	CPUPostProcessDevice device(settings.numThreads);
+	CPUImage output;
+	printf("%dx%d, %d threads\n", test.Width(), test.Height(), device.NumThreads());
+	printf("%-24s %10s\n", "Effect", "ms");
+	for (int effect = static_cast<int>(PostProcess::Copy); effect <= static_cast<int>(PostProcess::OnePassBlur); ++effect)
+	{
+		PostProcessChain chain = { { static_cast<PostProcess>(effect), PostProcessMode::Fullscreen } };
+		double milliseconds = FastestRun(settings.numRuns, [&]() { device.Run(chain, test.mFrame, output); });
+		printf("%-24s %10.1f\n", EffectName(static_cast<PostProcess>(effect)), milliseconds);
+	}
+}
+
+
+// A memory-bound colour chain and a blur chain at 4K, pass by pass and fused tile by tile (see CPUTileFusion.h), with 1, 2,
+// 4... threads
+static void BenchmarkThreadScaling(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 3840), FrameSize(settings, 2160));
+	PostProcessChain colourChain = { { PostProcess::Tint, PostProcessMode::Fullscreen }, { PostProcess::Sepia, PostProcessMode::Fullscreen },
+	                                 { PostProcess::Invert, PostProcessMode::Fullscreen }, { PostProcess::Tint, PostProcessMode::Fullscreen },
+	                                 { PostProcess::Copy, PostProcessMode::Fullscreen } };
+	PostProcessChain blurChain = { { PostProcess::Tint, PostProcessMode::Fullscreen },
+	                               { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen },
+	                               { PostProcess::GaussianBlurVertical, PostProcessMode::Fullscreen },
+	                               { PostProcess::Sepia, PostProcessMode::Fullscreen }, { PostProcess::Invert, PostProcessMode::Fullscreen },
+	                               { PostProcess::Copy, PostProcessMode::Fullscreen } };
+	printf("%dx%d\n", test.Width(), test.Height());
+	printf("%-8s %-8s %8s %10s %8s\n", "Chain", "Fusion", "Threads", "ms", "Speed up");
+	for (int chain = 0; chain < 2; ++chain)
+	{
+		for (int fusion = 0; fusion < 2; ++fusion)
+		{
+			std::vector<CPUThreadScaling> scaling = MeasureThreadScaling(chain == 0 ? colourChain : blurChain, test.mFrame, 0,
+			                                                             settings.numRuns, fusion != 0);
+			for (const CPUThreadScaling& threads : scaling)
+			{
+				printf("%-8s %-8s %8d %10.1f %8.2f\n", chain == 0 ? "Colour" : "Blur", fusion ? "Fused" : "Passes",
+				       threads.numThreads, threads.milliseconds, threads.speedUp);
+			}
+		}
+	}
+}
+
+
+// Baking each colour LUT effect, and running it directly and from its LUT
+static void BenchmarkColourLUTs(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 1920), FrameSize(settings, 1080));
+	std::vector<CPUColourLUTTiming> timings = MeasureColourLUTs({ PostProcess::Tint, PostProcess::Invert, PostProcess::Sepia }, test.mFrame,
+	                                                            settings.numThreads, settings.numRuns);
+	printf("%dx%d\n", test.Width(), test.Height());
+	printf("%-12s %10s %10s %10s %10s\n", "Effect", "Bake ms", "Effect ms", "LUT ms", "Max diff");
+	for (const CPUColourLUTTiming& timing : timings)
+	{
+		printf("%-12s %10.1f %10.1f %10.1f %10d\n", EffectName(timing.effect), timing.bakeMilliseconds, timing.effectMilliseconds,
+		       timing.lutMilliseconds, timing.maxDifference);
+	}
+}
+
+
+// Nearest palette colour for every pixel of a random 4K frame, searching the whole palette and with the index
+static void BenchmarkPaletteIndex(const BenchmarkSettings& settings)
+{
+	int width = FrameSize(settings, 3840), height = FrameSize(settings, 2160);
+	printf("%dx%d, one thread\n", width, height);
+	printf("%8s %10s %14s %10s %12s %10s\n", "Colours", "Build ms", "Full search ms", "Index ms", "Candidates", "Mismatches");
+	for (int paletteSize : { 8, 16, RETRO_GAME_PALETTE_SIZE })
+	{
+		PaletteIndexTiming timing = MeasurePaletteIndex(width, height, paletteSize, settings.numRuns);
+		printf("%8d %10.2f %14.1f %10.1f %12.2f %10d\n", paletteSize, timing.buildMilliseconds, timing.bruteForceMilliseconds,
+		       timing.indexMilliseconds, timing.averageCandidates, timing.mismatches);
+	}
+}
+
+
+// Full screen Gaussian blurs from narrow to very wide, the wide ones run on smaller images
+static void BenchmarkGaussianBlur(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 1920), FrameSize(settings, 1080));
+	std::vector<CPUGaussianBlurTiming> timings = MeasureGaussianBlur({ 1, 2, 4, 8, 16, 32, 64, 128 }, test.mFrame,
+	                                                                 settings.numThreads, settings.numRuns);
+	printf("%dx%d\n", test.Width(), test.Height());
+	printf("%8s %8s %8s %10s\n", "Sigma", "Levels", "Taps", "ms");
+	for (const CPUGaussianBlurTiming& timing : timings)
+	{
+		printf("%8.0f %8d %8d %10.1f\n", timing.sigma, timing.levels, timing.numTaps, timing.milliseconds);
+	}
+}
+
+
+// Full screen dilation and box blur from small to the widest radius, by the pixel shader and by the sliding window passes
+static void BenchmarkSlidingFilters(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 480), FrameSize(settings, 270));
+	std::vector<int> radii = { 1, 2, 4, 8, 16, 32, 64 };
+	if (settings.quick)  radii = { 1, 8 };
+	std::vector<CPUSlidingFilterTiming> timings = MeasureSlidingFilters({ PostProcess::Dilation, PostProcess::OnePassBlur }, radii,
+	                                                                    test.mFrame, 1, settings.numRuns);
+	printf("%dx%d, one thread\n", test.Width(), test.Height());
+	printf("%-12s %8s %16s %12s %10s\n", "Effect", "Radius", "Pixel shader ms", "Sliding ms", "Max diff");
+	for (const CPUSlidingFilterTiming& timing : timings)
+	{
+		printf("%-12s %8d %16.1f %12.1f %10d\n", EffectName(timing.effect), timing.radius, timing.pixelShaderMilliseconds,
+		       timing.slidingMilliseconds, timing.maxDifference);
+	}
+}
+
+
+// The wireframe and Gaussian blurs full screen, by their pixel shaders and by their compute shaders a tile at a time
+static void BenchmarkComputeTiles(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 1920), FrameSize(settings, 1080));
+	std::vector<CPUComputeTileTiming> timings = MeasureComputeTiles({ PostProcess::Wireframe, PostProcess::GaussianBlurHorizontal,
+	                                                                  PostProcess::GaussianBlurVertical },
+	                                                                test.mFrame, settings.numThreads, settings.numRuns);
+	printf("%dx%d, blur sigma %.0f\n", test.Width(), test.Height(), test.mFrame.effectConstants.gaussianBlur.blurSigma);
+	printf("%-24s %16s %16s %10s\n", "Effect", "Pixel shader ms", "Compute tile ms", "Max diff");
+	for (const CPUComputeTileTiming& timing : timings)
+	{
+		printf("%-24s %16.1f %16.1f %10d\n", EffectName(timing.effect), timing.pixelShaderMilliseconds,
+		       timing.computeTileMilliseconds, timing.maxDifference);
+	}
+}
+
+
+// Bloom as one effect, against the full size bright pass, blurs and lens star it replaced (without their composite)
+static void BenchmarkBloom(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 960), FrameSize(settings, 540), TestScene::Smooth);
+	PostProcessChain bloom = { { PostProcess::Bloom, PostProcessMode::Fullscreen } };
+	PostProcessChain fullSize = { { PostProcess::BrightPass, PostProcessMode::Fullscreen },
+	                              { PostProcess::GaussianBlurHorizontal, PostProcessMode::Fullscreen },
+	                              { PostProcess::GaussianBlurVertical, PostProcessMode::Fullscreen },
+	                              { PostProcess::LensStar, PostProcessMode::Fullscreen } };
+	CPUPostProcessDevice device(1);
+	CPUImage output;
+	printf("%dx%d, one thread\n", test.Width(), test.Height());
+	printf("%-40s %10s\n", "Chain", "ms");
+	printf("%-40s %10.1f\n", "Bloom", FastestRun(settings.numRuns, [&]() { device.Run(bloom, test.mFrame, output); }));
+	printf("%-40s %10.1f\n", "BrightPass, blurs, LensStar at full size",
+	       FastestRun(settings.numRuns, [&]() { device.Run(fullSize, test.mFrame, output); }));
+}
+
+
+// Each effect declared with a reducedResolutionDivisor at full size and on a smaller image, with the quality of the second
+static void BenchmarkReducedResolution(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 480), FrameSize(settings, 270), TestScene::Smooth);
+	std::vector<PostProcess> declared;
+	for (int effect = static_cast<int>(PostProcess::Copy); effect <= static_cast<int>(PostProcess::OnePassBlur); ++effect)
+	{
+		if (GetPostProcessDeclaration(static_cast<PostProcess>(effect)).reducedResolutionDivisor > 1)
+		{
+			declared.push_back(static_cast<PostProcess>(effect));
+		}
+	}
+	std::vector<CPUReducedResolutionTiming> timings = MeasureReducedResolution(declared, test.mFrame, 1, settings.numRuns);
+	printf("%dx%d, one thread\n", test.Width(), test.Height());
+	printf("%-24s %8s %10s %12s %8s\n", "Effect", "Divisor", "Full ms", "Reduced ms", "PSNR dB");
+	for (const CPUReducedResolutionTiming& timing : timings)
+	{
+		printf("%-24s %8d %10.1f %12.1f %8.1f\n", EffectName(timing.effect), timing.sizeDivisor, timing.fullMilliseconds,
+		       timing.reducedMilliseconds, timing.psnr);
+	}
+}
+
+
+// Depth of field from in focus to a wide aperture, whole and by its stages
+static void BenchmarkDepthOfField(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 480), FrameSize(settings, 270), TestScene::Smooth);
+	std::vector<CPUDepthOfFieldTiming> timings = MeasureDepthOfField({ 0.0f, 1.0f, 5.0f, 20.0f, 50.0f }, test.mFrame, 1,
+	                                                                 settings.numRuns);
+	printf("%dx%d, one thread\n", test.Width(), test.Height());
+	printf("%8s %10s %10s %12s %12s\n", "Aperture", "In focus", "ms", "CoC+tiles ms", "Gathers ms");
+	for (const CPUDepthOfFieldTiming& timing : timings)
+	{
+		printf("%8.1f %9.0f%% %10.1f %12.1f %12.1f\n", timing.aperture, timing.inFocusTiles * 100.0f, timing.milliseconds,
+		       timing.cocMilliseconds, timing.gatherMilliseconds);
+	}
+}
+
+
+// Motion blur from a still image to a long shutter, over a frame whose left half pans
+static void BenchmarkMotionBlur(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 480), FrameSize(settings, 270), TestScene::Smooth);
+	std::vector<CPUMotionBlurTiming> timings = MeasureMotionBlur({ 0.0f, 0.25f, 0.5f, 1.0f }, test.mFrame, 1, settings.numRuns);
+	printf("%dx%d, one thread\n", test.Width(), test.Height());
+	printf("%8s %12s %10s %10s\n", "Shutter", "Still tiles", "ms", "Tiles ms");
+	for (const CPUMotionBlurTiming& timing : timings)
+	{
+		printf("%8.2f %11.0f%% %10.1f %10.1f\n", timing.shutter, timing.stillTiles * 100.0f, timing.milliseconds,
+		       timing.tileMilliseconds);
+	}
+}
+
+
+// Each effect declared with temporalFrames taking all of its samples every frame, and a share of them after settling
+static void BenchmarkTemporalAccumulation(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 480), FrameSize(settings, 270), TestScene::Smooth);
+	std::vector<PostProcess> declared;
+	for (int effect = static_cast<int>(PostProcess::Copy); effect <= static_cast<int>(PostProcess::OnePassBlur); ++effect)
+	{
+		if (GetPostProcessDeclaration(static_cast<PostProcess>(effect)).temporalFrames > 1)
+		{
+			declared.push_back(static_cast<PostProcess>(effect));
+		}
+	}
+	std::vector<CPUTemporalTiming> timings = MeasureTemporalAccumulation(declared, test.mFrame, 16, 1, settings.numRuns);
+	printf("%dx%d, one thread, 16 frames to settle\n", test.Width(), test.Height());
+	printf("%-24s %10s %12s %14s %8s\n", "Effect", "Full ms", "Temporal ms", "Reads saved", "PSNR dB");
+	for (const CPUTemporalTiming& timing : timings)
+	{
+		printf("%-24s %10.1f %12.1f %13.0f%% %8.1f\n", EffectName(timing.effect), timing.fullMilliseconds,
+		       timing.temporalMilliseconds, timing.samples.Savings() * 100.0, timing.psnr);
+	}
+}
+
+
+// Runs of full screen distortions one effect at a time and as one UV remap pass
+static void BenchmarkUVRemap(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 1920), FrameSize(settings, 1080), TestScene::Smooth);
+	auto fullScreen = [](std::initializer_list<PostProcess> effects)
+	{
+		PostProcessChain chain;
+		for (PostProcess effect : effects)  chain.push_back({ effect, PostProcessMode::Fullscreen });
+		return chain;
+	};
+	using P = PostProcess;
+	std::vector<PostProcessChain> chains = { fullScreen({ P::Distort, P::Spiral }),
+	                                         fullScreen({ P::Underwater, P::HeatHaze, P::Distort }),
+	                                         fullScreen({ P::Distort, P::Spiral, P::HeatHaze, P::Underwater, P::Distort }),
+	                                         fullScreen({ P::ChromaticDis, P::Distort, P::Spiral, P::HeatHaze, P::Underwater, P::Distort }) };
+	std::vector<CPUUVRemapTiming> timings = MeasureUVRemap(chains, test.mFrame, 1, settings.numRuns);
+	printf("%dx%d, one thread\n", test.Width(), test.Height());
+	printf("%-60s %10s %10s %8s %9s\n", "Chain", "Effects ms", "Fused ms", "PSNR dB", "Max diff");
+	for (const CPUUVRemapTiming& timing : timings)
+	{
+		std::string names;
+		for (const auto& entry : timing.chain)  names += (names.empty() ? "" : ", ") + std::string(EffectName(entry.first));
+		printf("%-60s %10.1f %10.1f %8.1f %9d\n", names.c_str(), timing.sequentialMilliseconds, timing.fusedMilliseconds,
+		       timing.psnr, timing.maxDifference);
+	}
+}
+
+
+// The lens star read in one pass and made by the streak passes, from short to long streaks, at the quarter size the bloom
+// makes it at
+static void BenchmarkLensStar(const BenchmarkSettings& settings)
+{
+	TestFrame test(FrameSize(settings, 1920), FrameSize(settings, 1080), TestScene::Smooth);
+	std::vector<int> lengths = { 6, 16, 64, 192 };
+	if (settings.quick)  lengths = { 6 };
+	std::vector<CPULensStarTiming> timings = MeasureLensStar(lengths, test.mFrame, 1, settings.numRuns);
+	printf("%dx%d scene, %dx%d star, one thread\n", test.Width(), test.Height(), test.Width() / BLOOM_STAR_SIZE_DIVISOR,
+	       test.Height() / BLOOM_STAR_SIZE_DIVISOR);
+	printf("%8s %8s %16s %16s %8s %9s\n", "Length", "Passes", "Single pass ms", "Streak passes ms", "PSNR dB", "Max diff");
+	for (const CPULensStarTiming& timing : timings)
+	{
+		printf("%8d %8d %16.1f %16.1f %8.1f %9d\n", timing.streakLength, timing.passes, timing.singlePassMilliseconds,
+		       timing.iterativeMilliseconds, timing.psnr, timing.maxDifference);
+	}
+}
+
+
+struct BenchmarkSection
+{
+	const char* name;
+	void (*run)(const BenchmarkSettings& settings);
+};
+
+static const BenchmarkSection SECTIONS[] =
+{
+	{ "RenderTargets",        BenchmarkRenderTargets },
+	{ "InstanceBatch",        BenchmarkInstanceBatch },
+	{ "Effects",              BenchmarkEffects },
+	{ "ThreadScaling",        BenchmarkThreadScaling },
+	{ "ColourLUTs",           BenchmarkColourLUTs },
+	{ "PaletteIndex",         BenchmarkPaletteIndex },
+	{ "GaussianBlur",         BenchmarkGaussianBlur },
+	{ "SlidingFilters",       BenchmarkSlidingFilters },
+	{ "ComputeTiles",         BenchmarkComputeTiles },
+	{ "Bloom",                BenchmarkBloom },
+	{ "ReducedResolution",    BenchmarkReducedResolution },
+	{ "DepthOfField",         BenchmarkDepthOfField },
+	{ "MotionBlur",           BenchmarkMotionBlur },
+	{ "TemporalAccumulation", BenchmarkTemporalAccumulation },
+	{ "UVRemap",              BenchmarkUVRemap },
+	{ "LensStar",             BenchmarkLensStar },
+};
+
+
+//--------------------------------------------------------------------------------------
+// Main
+//--------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	BenchmarkSettings settings;
+	const char* prefix = "";
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (strcmp(argv[arg], "--quick") == 0)  settings.quick = true;
+		else                                    prefix = argv[arg];
+	}
+	if (settings.quick)  settings.numRuns = 1;
+	setvbuf(stdout, nullptr, _IOLBF, BUFSIZ); // Show each line as it is measured, some sections take minutes
+
+	int numRun = 0;
+	for (const BenchmarkSection& section : SECTIONS)
+	{
+		if (strncmp(section.name, prefix, strlen(prefix)) != 0)  continue;
+
+		printf("== %s\n", section.name);
+		section.run(settings);
+		printf("\n");
+		++numRun;
+	}
+	if (numRun == 0)  printf("No section starts with \"%s\"\n", prefix);
+	return numRun > 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+//--------------------------------------------------------------------------------------
+// Tests of running a render graph on a device (PostProcessDevice.h)
+//--------------------------------------------------------------------------------------
+// The recording device keeps a list of what it was asked to do, so the draws and copies a chain
+// costs can be checked without a GPU
+
+#include "Test.h"
+#include "PostProcessDevice.h"
+
+
+static const PostProcessMode FULLSCREEN = PostProcessMode::Fullscreen;
+
+
+// Number of recorded commands of the given type
+static int CountCommands(const RecordingPostProcessDevice& device, PostProcessCommandType type)
+{
+	int count = 0;
+	for (const PostProcessCommand& command : device.Commands())
+	{
+		if (command.type == type)  ++count;
+	}
+	return count;
+}
+
+
+TEST(PostProcessDeviceOneDrawPerEffect)
+{
+	// N full screen effects cost N draws, only the last to the back buffer
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::NightVision, FULLSCREEN } });
+	RecordingPostProcessDevice device;
+	PostProcessStats stats = ExecuteRenderGraph(graph, device);
+
+	CHECK_EQUAL(3, stats.passes);
+	CHECK_EQUAL(3, stats.draws);
+	CHECK_EQUAL(0, stats.copies);
+	CHECK_EQUAL(1, stats.backBufferDraws);
+
+	// Each pass selects its resources then draws
+	CHECK_EQUAL(3, CountCommands(device, PostProcessCommandType::SetPassResources));
+	CHECK_EQUAL(3, CountCommands(device, PostProcessCommandType::DrawFullScreen));
+	CHECK(device.Commands().back().type == PostProcessCommandType::DrawFullScreen);
+	CHECK(device.Commands().back().effect == PostProcess::NightVision);
+	CHECK_EQUAL(BACK_BUFFER_RESOURCE, device.Commands().back().target);
+}
+
+
+TEST(PostProcessDeviceEmptyChainDrawsOnce)
+{
+	RenderGraph graph;
+	graph.Compile({});
+	RecordingPostProcessDevice device;
+	PostProcessStats stats = ExecuteRenderGraph(graph, device);
+
+	CHECK_EQUAL(1, stats.passes);
+	CHECK_EQUAL(1, stats.draws);
+	CHECK_EQUAL(1, stats.backBufferDraws);
+	CHECK(device.Commands().back().effect == PostProcess::Copy);
+}
+
+
+TEST(PostProcessDeviceCommandsFollowPasses)
+{
+	// Running the same graph again records the same commands
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::Tint, FULLSCREEN } });
+	RecordingPostProcessDevice device;
+	ExecuteRenderGraph(graph, device);
+	size_t numCommands = device.Commands().size();
+	device.Clear();
+	ExecuteRenderGraph(graph, device);
+	CHECK_EQUAL(numCommands, device.Commands().size());
+
+	// Each draw writes the output of its pass, reading its first input
+	size_t command = 0;
+	for (const RenderPass& pass : graph.Passes())
+	{
+		CHECK(device.Commands()[command].type == PostProcessCommandType::SetPassResources);
+		CHECK_EQUAL(pass.output, device.Commands()[command + 1].target);
+		CHECK_EQUAL(pass.inputs[0], device.Commands()[command + 1].source);
+		command += 2;
+	}
+}
+
+
+TEST(PostProcessDeviceInPlaceEffectCopiesRegion)
+{
+	// The area effect costs a region copy and a region draw, no full screen copy
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::Burn, PostProcessMode::Area }, { PostProcess::NightVision, FULLSCREEN } });
+	RecordingPostProcessDevice device;
+	PostProcessStats stats = ExecuteRenderGraph(graph, device);
+
+	CHECK_EQUAL(4, stats.passes);
+	CHECK_EQUAL(3, stats.draws);
+	CHECK_EQUAL(1, stats.copies);
+	CHECK_EQUAL(1, CountCommands(device, PostProcessCommandType::CopyRegion));
+	CHECK_EQUAL(1, CountCommands(device, PostProcessCommandType::DrawRegion));
+	CHECK_EQUAL(0, CountCommands(device, PostProcessCommandType::CopyResource));
+}
+
+
+TEST(PostProcessDeviceUnboundedEffectCopiesWholeImage)
+{
+	// A polygon effect that may read anywhere has the rest of its target filled with a full screen copy
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::Spiral, PostProcessMode::Polygon } });
+	RecordingPostProcessDevice device;
+	PostProcessStats stats = ExecuteRenderGraph(graph, device);
+
+	CHECK_EQUAL(2, stats.passes);
+	CHECK_EQUAL(3, stats.draws);
+	CHECK_EQUAL(0, stats.copies);
+	CHECK_EQUAL(1, CountCommands(device, PostProcessCommandType::DrawRegion));
+}
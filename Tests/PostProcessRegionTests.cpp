@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------
+// Tests of the screen regions of area and polygon effects (PostProcessRegion.h)
+//--------------------------------------------------------------------------------------
+// Scene.cpp's CalculatePassRegion projects each pass's area or polygon with the camera and uses
+// these functions for its rectangle of pixels, then ExpandByFootprint for the pixels to copy
+
+#include "Test.h"
+#include "PostProcessRegion.h"
+
+
+static const int VIEWPORT_WIDTH  = 1280;
+static const int VIEWPORT_HEIGHT = 720;
+
+
+static bool SameRect(const PixelRect& a, const PixelRect& b)
+{
+	return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+
+TEST(PostProcessRegionAreaRoundsOutwards)
+{
+	// Partly covered pixels are included
+	PixelRect rect = AreaPixelRect({ 0.1f, 0.25f }, { 0.2f, 0.5f }, 1000, 100);
+	CHECK(SameRect({ 100, 25, 300, 75 }, rect));
+	rect = AreaPixelRect({ 0.1005f, 0.251f }, { 0.1f, 0.1f }, 1000, 100);
+	CHECK(SameRect({ 100, 25, 201, 36 }, rect));
+
+	// Clipped to the viewport, and empty when off screen
+	rect = AreaPixelRect({ -0.5f, 0.75f }, { 1.0f, 1.0f }, 1000, 100);
+	CHECK(SameRect({ 0, 75, 500, 100 }, rect));
+	CHECK(AreaPixelRect({ 1.5f, 0.0f }, { 0.2f, 0.2f }, 1000, 100).IsEmpty());
+}
+
+
+TEST(PostProcessRegionPolygonProjects)
+{
+	// A square from -0.5 to 0.5 in clip space, with w = 2 so the perspective divide halves it
+	CVector4 points[4] = { { -1, 1, 0, 2 }, { -1, -1, 0, 2 }, { 1, 1, 0, 2 }, { 1, -1, 0, 2 } };
+	PixelRect rect = PolygonPixelRect(points, 4, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	CHECK(SameRect({ 320, 180, 960, 540 }, rect));
+}
+
+
+TEST(PostProcessRegionPolygonBehindCamera)
+{
+	// Entirely behind the camera - nothing to draw
+	CVector4 behind[4] = { { -1, 1, 0, -1 }, { -1, -1, 0, -1 }, { 1, 1, 0, -1 }, { 1, -1, 0, -1 } };
+	CHECK(PolygonPixelRect(behind, 4, VIEWPORT_WIDTH, VIEWPORT_HEIGHT).IsEmpty());
+
+	// Partly behind - clipped by the GPU in ways not reproduced, so the whole viewport to be safe
+	CVector4 crossing[4] = { { -1, 1, 0, 2 }, { -1, -1, 0, -1 }, { 1, 1, 0, 2 }, { 1, -1, 0, 2 } };
+	CHECK(SameRect({ 0, 0, VIEWPORT_WIDTH, VIEWPORT_HEIGHT }, PolygonPixelRect(crossing, 4, VIEWPORT_WIDTH, VIEWPORT_HEIGHT)));
+}
+
+
+TEST(PostProcessRegionFootprintAddsHalo)
+{
+	PixelRect rect = { 100, 100, 200, 150 };
+
+	// Halo in pixels plus a fraction of the screen size, rounded up
+	PostProcessDeclaration declaration;
+	declaration.haloPixels = 2;
+	declaration.haloScreenFraction = 0.01f;
+	CHECK(SameRect({ 85, 90, 215, 160 }, ExpandByFootprint(rect, declaration, VIEWPORT_WIDTH, VIEWPORT_HEIGHT)));
+
+	// No halo, no change
+	CHECK(SameRect(rect, ExpandByFootprint(rect, PostProcessDeclaration(), VIEWPORT_WIDTH, VIEWPORT_HEIGHT)));
+
+	// Clipped to the viewport
+	declaration.haloPixels = 150;
+	declaration.haloScreenFraction = 0.0f;
+	CHECK(SameRect({ 0, 0, 350, 300 }, ExpandByFootprint(rect, declaration, VIEWPORT_WIDTH, VIEWPORT_HEIGHT)));
+
+	// An effect that may read anywhere needs the whole viewport, but an empty region still needs nothing
+	declaration.unboundedFootprint = true;
+	CHECK(SameRect({ 0, 0, VIEWPORT_WIDTH, VIEWPORT_HEIGHT }, ExpandByFootprint(rect, declaration, VIEWPORT_WIDTH, VIEWPORT_HEIGHT)));
+	CHECK(ExpandByFootprint(PixelRect(), declaration, VIEWPORT_WIDTH, VIEWPORT_HEIGHT).IsEmpty());
+}
+
+
+TEST(PostProcessRegionDeclaredHalos)
+{
+	// The footprint of each in-place effect must cover what its shader reads, e.g. burn's crinkle offset
+	PixelRect rect = { 600, 300, 700, 400 };
+	PixelRect burn = ExpandByFootprint(rect, GetPostProcessDeclaration(PostProcess::Burn), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	CHECK(burn.left <= rect.left - static_cast<int>(0.075f * VIEWPORT_WIDTH));
+	CHECK(burn.bottom >= rect.bottom + static_cast<int>(0.075f * VIEWPORT_HEIGHT));
+
+	PixelRect wireframe = ExpandByFootprint(rect, GetPostProcessDeclaration(PostProcess::Wireframe), VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+	CHECK(SameRect({ 598, 298, 702, 402 }, wireframe));
+}
+
+
+TEST(PostProcessRegionOverlap)
+{
+	PixelRect a = { 0, 0, 10, 10 };
+	CHECK(RectsOverlap(a, { 9, 9, 20, 20 }));
+	CHECK(!RectsOverlap(a, { 10, 0, 20, 10 })); // Sharing an edge isn't overlapping, right and bottom are exclusive
+	CHECK(!RectsOverlap(a, PixelRect()));
+}
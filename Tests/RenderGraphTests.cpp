@@ -0,0 +1,292 @@
+//--------------------------------------------------------------------------------------
+// Tests of the render graph (RenderGraph.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "RenderGraph.h"
+
+#include <algorithm>
+
+
+static const PostProcessMode FULLSCREEN = PostProcessMode::Fullscreen;
+
+
+// Number of different pooled targets backing the chain's images, after allocating them for one frame
+static int CountTargets(RenderGraph& graph, RenderTargetAllocator& allocator)
+{
+	allocator.BeginFrame();
+	graph.AllocateTargets(allocator, 640, 360);
+	allocator.EndFrame();
+	return allocator.NumAliveSlots();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Building the passes
+//--------------------------------------------------------------------------------------
+
+TEST(RenderGraphChainRunsInOrder)
+{
+	// Effects that can't be combined with each other, so each has a pass of its own
+	PostProcessChain chain = { { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::NightVision, FULLSCREEN } };
+	RenderGraph graph;
+	graph.Compile(chain);
+
+	const std::vector<RenderPass>& passes = graph.Passes();
+	CHECK_EQUAL(3, static_cast<int>(passes.size()));
+	if (passes.size() != 3)  return;
+
+	// Each pass reads what the one before wrote, starting from the scene
+	CHECK_EQUAL(SCENE_COLOUR_RESOURCE, passes[0].inputs[0]);
+	for (int pass = 0; pass < 3; ++pass)
+	{
+		CHECK(passes[pass].type == RenderPassType::PostProcess);
+		CHECK(passes[pass].effect == chain[pass].first);
+		CHECK_EQUAL(pass, passes[pass].chainIndex);
+		if (pass > 0)  CHECK_EQUAL(passes[pass - 1].output, passes[pass].inputs[0]);
+	}
+	CHECK_EQUAL(BACK_BUFFER_RESOURCE, graph.FinalOutput());
+}
+
+
+TEST(RenderGraphFindsResourcesRead)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Tint, FULLSCREEN } });
+	CHECK(!graph.ReadsResource(SCENE_DEPTH_RESOURCE));
+
+	// Fog reads the scene depth in its second slot
+	graph.Compile({ { PostProcess::Tint, FULLSCREEN }, { PostProcess::Fog, FULLSCREEN } });
+	CHECK(graph.ReadsResource(SCENE_DEPTH_RESOURCE));
+	CHECK(!graph.ReadsResource(SCENE_VELOCITY_RESOURCE));
+}
+
+
+TEST(RenderGraphRecompilesOnlyForChanges)
+{
+	PostProcessChain chain = { { PostProcess::Burn, FULLSCREEN } };
+	RenderGraph graph;
+	CHECK(!graph.IsCompiledFrom(chain));
+
+	graph.Compile(chain);
+	CHECK(graph.IsCompiledFrom(chain));
+	CHECK(!graph.IsCompiledFrom(chain, 1));
+	CHECK(!graph.IsCompiledFrom({ { PostProcess::Burn, PostProcessMode::Area } }));
+}
+
+
+//--------------------------------------------------------------------------------------
+// Lifetimes and aliasing
+//--------------------------------------------------------------------------------------
+
+TEST(RenderGraphLifetimesSpanFirstWriteToLastRead)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::NightVision, FULLSCREEN } });
+
+	// The scene exists before the first pass, which is the last to read it
+	CHECK_EQUAL(-1, graph.Resource(SCENE_COLOUR_RESOURCE).firstUse);
+	CHECK_EQUAL(0,  graph.Resource(SCENE_COLOUR_RESOURCE).lastUse);
+
+	// Each intermediate image is written by one pass and read by the next
+	const std::vector<RenderPass>& passes = graph.Passes();
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		const GraphResource& image = graph.Resource(passes[pass].output);
+		CHECK(image.type == GraphResourceType::Transient);
+		CHECK_EQUAL(pass,     image.firstUse);
+		CHECK_EQUAL(pass + 1, image.lastUse);
+	}
+}
+
+
+TEST(RenderGraphAliasesImagesThatDontOverlap)
+{
+	// Three full size images (scene, then two intermediates) but never more than two alive at once
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::NightVision, FULLSCREEN } });
+	RenderTargetAllocator allocator;
+	CHECK_EQUAL(2, CountTargets(graph, allocator));
+
+	// The second intermediate is written after the scene's last read so shares its target, the first can't
+	const std::vector<RenderPass>& passes = graph.Passes();
+	int scene  = graph.Resource(SCENE_COLOUR_RESOURCE).physical;
+	int first  = graph.Resource(passes[0].output).physical;
+	int second = graph.Resource(passes[1].output).physical;
+	CHECK(first != scene);
+	CHECK_EQUAL(scene, second);
+
+	// Any image sharing a target must not be alive at the same time as the other
+	const std::vector<GraphResource>& resources = graph.Resources();
+	for (size_t a = 0; a < resources.size(); ++a)
+	{
+		for (size_t b = a + 1; b < resources.size(); ++b)
+		{
+			if (resources[a].physical < 0 || resources[a].physical != resources[b].physical)  continue;
+			bool overlap = resources[a].firstUse <= resources[b].lastUse && resources[b].firstUse <= resources[a].lastUse;
+			CHECK(!overlap);
+		}
+	}
+}
+
+
+TEST(RenderGraphLongChainNeedsTwoTargets)
+{
+	// However long the chain, ping-ponging between two targets is enough
+	PostProcessChain chain;
+	for (int i = 0; i < 6; ++i)
+	{
+		chain.push_back({ PostProcess::Burn, FULLSCREEN });
+		chain.push_back({ PostProcess::GreyNoise, FULLSCREEN });
+	}
+	RenderGraph graph;
+	graph.Compile(chain);
+	RenderTargetAllocator allocator;
+	CHECK_EQUAL(2, CountTargets(graph, allocator));
+}
+
+
+TEST(RenderGraphEmptyChainOnlyNeedsTheScene)
+{
+	RenderGraph graph;
+	graph.Compile({});
+	RenderTargetAllocator allocator;
+	CHECK_EQUAL(1, CountTargets(graph, allocator));
+}
+
+
+//--------------------------------------------------------------------------------------
+// Present stage
+//--------------------------------------------------------------------------------------
+
+TEST(RenderGraphLastEffectDrawsToBackBuffer)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, FULLSCREEN }, { PostProcess::GreyNoise, FULLSCREEN } });
+
+	// No extra copy - the last effect writes the back buffer itself and only that pass does
+	const std::vector<RenderPass>& passes = graph.Passes();
+	CHECK_EQUAL(2, static_cast<int>(passes.size()));
+	CHECK_EQUAL(BACK_BUFFER_RESOURCE, passes.back().output);
+	CHECK_EQUAL(1, static_cast<int>(std::count_if(passes.begin(), passes.end(),
+	                                              [](const RenderPass& pass) { return pass.output == BACK_BUFFER_RESOURCE; })));
+
+	// The image the last effect would have written is left unused, so gets no target
+	RenderTargetAllocator allocator;
+	CountTargets(graph, allocator);
+	int unused = 0;
+	for (const GraphResource& resource : graph.Resources())
+	{
+		if (resource.type == GraphResourceType::Transient && resource.firstUse < 0)
+		{
+			++unused;
+			CHECK_EQUAL(-1, resource.physical);
+		}
+	}
+	CHECK_EQUAL(1, unused);
+}
+
+
+TEST(RenderGraphEmptyChainCopiesSceneToBackBuffer)
+{
+	RenderGraph graph;
+	graph.Compile({});
+	CHECK_EQUAL(1, static_cast<int>(graph.Passes().size()));
+	if (graph.Passes().empty())  return;
+
+	const RenderPass& pass = graph.Passes()[0];
+	CHECK(pass.effect == PostProcess::Copy);
+	CHECK_EQUAL(SCENE_COLOUR_RESOURCE, pass.inputs[0]);
+	CHECK_EQUAL(BACK_BUFFER_RESOURCE, pass.output);
+}
+
+
+TEST(RenderGraphInPlaceLastEffectIsCopiedToBackBuffer)
+{
+	// An area effect only draws its region into the image it processes, so the whole image is copied to the screen after it
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, PostProcessMode::Area } });
+	const RenderPass& last = graph.Passes().back();
+	CHECK(last.effect == PostProcess::Copy);
+	CHECK(last.type == RenderPassType::PostProcess);
+	CHECK_EQUAL(SCENE_COLOUR_RESOURCE, last.inputs[0]);
+	CHECK_EQUAL(BACK_BUFFER_RESOURCE, last.output);
+}
+
+
+//--------------------------------------------------------------------------------------
+// In-place area and polygon effects
+//--------------------------------------------------------------------------------------
+
+TEST(RenderGraphAreaEffectRunsInPlace)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::Burn, PostProcessMode::Area }, { PostProcess::NightVision, FULLSCREEN } });
+	const std::vector<RenderPass>& passes = graph.Passes();
+	CHECK_EQUAL(4, static_cast<int>(passes.size()));
+	if (passes.size() != 4)  return;
+
+	// The pixels burn reads are copied from the image it processes into a scratch image...
+	int image = passes[0].output;
+	CHECK(passes[1].type == RenderPassType::CopyRegion);
+	CHECK(passes[1].effect == PostProcess::Burn);
+	CHECK_EQUAL(image, passes[1].inputs[0]);
+
+	// ...then burn reads the scratch image and draws its region straight into the image, which the next effect reads
+	CHECK(passes[2].inPlace);
+	CHECK_EQUAL(passes[1].output, passes[2].inputs[0]);
+	CHECK_EQUAL(image, passes[2].output);
+	CHECK_EQUAL(image, passes[3].inputs[0]);
+}
+
+
+TEST(RenderGraphUnboundedEffectIsNotInPlace)
+{
+	// Spiral may read anywhere in the image, so it needs all of it copied rather than a region
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::GreyNoise, FULLSCREEN }, { PostProcess::Spiral, PostProcessMode::Polygon } });
+	for (const RenderPass& pass : graph.Passes())
+	{
+		CHECK(!pass.inPlace);
+		CHECK(pass.type != RenderPassType::CopyRegion);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Scene passes
+//--------------------------------------------------------------------------------------
+
+TEST(RenderGraphScenePassesWithoutDepth)
+{
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Burn, PostProcessMode::Fullscreen } });
+	std::vector<ScenePass> scenePasses = PlanScenePasses(graph, false);
+	CHECK_EQUAL(1, static_cast<int>(scenePasses.size()));
+	CHECK(!scenePasses[0].depthOnly && !scenePasses[0].velocity);
+	CHECK(!scenePasses[0].sceneDepth && !scenePasses[0].depthAlreadyWritten);
+}
+
+
+TEST(RenderGraphScenePassesWithDepthPrePass)
+{
+	// Fog reads the scene depth, so both passes use the readable depth, and the colour pass tests against the pre-pass's
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::Fog, PostProcessMode::Fullscreen } });
+	std::vector<ScenePass> scenePasses = PlanScenePasses(graph, true);
+	CHECK_EQUAL(2, static_cast<int>(scenePasses.size()));
+	CHECK(scenePasses[0].depthOnly && scenePasses[0].sceneDepth);
+	CHECK(!scenePasses[1].depthOnly && scenePasses[1].sceneDepth && scenePasses[1].depthAlreadyWritten);
+}
+
+
+TEST(RenderGraphScenePassesWithVelocity)
+{
+	// Motion blur anywhere in the chain adds a velocity pass after the colour pass
+	RenderGraph graph;
+	graph.Compile({ { PostProcess::MotionBlur, PostProcessMode::Fullscreen }, { PostProcess::Burn, PostProcessMode::Fullscreen } });
+	std::vector<ScenePass> scenePasses = PlanScenePasses(graph, false);
+	CHECK_EQUAL(2, static_cast<int>(scenePasses.size()));
+	CHECK(!scenePasses[0].velocity && !scenePasses[0].depthAlreadyWritten);
+	CHECK(scenePasses[1].velocity && scenePasses[1].depthAlreadyWritten);
+}
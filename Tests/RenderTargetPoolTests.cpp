@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------------
+// Tests of the pool of render targets (RenderTargetPool.h)
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+#include "RenderTargetPool.h"
+#include "RenderGraph.h"
+
+
+static RenderTargetDesc Desc(int width, int height, TargetFormat format = TargetFormat::RGBA8)
+{
+	RenderTargetDesc desc;
+	desc.width  = width;
+	desc.height = height;
+	desc.format = format;
+	return desc;
+}
+
+
+TEST(RenderTargetPoolReusesFinishedTargets)
+{
+	RenderTargetAllocator allocator;
+	allocator.BeginFrame();
+	int a = allocator.Allocate(Desc(64, 64), -1, 1); // Used up to pass 1
+	int b = allocator.Allocate(Desc(64, 64), 0, 2);  // Overlaps a
+	int c = allocator.Allocate(Desc(64, 64), 2, 3);  // Starts after a's last use
+	int d = allocator.Allocate(Desc(64, 64), 3, 4);  // Starts after b's, but c (in a's target) is still busy
+	allocator.EndFrame();
+
+	CHECK(a != b);
+	CHECK_EQUAL(a, c);
+	CHECK_EQUAL(b, d);
+	CHECK_EQUAL(2, allocator.NumAliveSlots());
+}
+
+
+TEST(RenderTargetPoolImageCantShareWithTheOneItReads)
+{
+	// A pass can't write the target it reads from, so an image first written by the last pass to read another can't share
+	RenderTargetAllocator allocator;
+	allocator.BeginFrame();
+	int a = allocator.Allocate(Desc(64, 64), -1, 2);
+	int b = allocator.Allocate(Desc(64, 64), 2, 3);
+	CHECK(a != b);
+}
+
+
+TEST(RenderTargetPoolMatchesDescription)
+{
+	RenderTargetAllocator allocator;
+	allocator.BeginFrame();
+	int a = allocator.Allocate(Desc(64, 64), -1, 0);
+	int b = allocator.Allocate(Desc(32, 32), 1, 2);                        // Different size
+	int c = allocator.Allocate(Desc(64, 64, TargetFormat::RGBA16F), 1, 2); // Different format
+	RenderTargetDesc unordered = Desc(64, 64);
+	unordered.bind |= TARGET_BIND_UNORDERED_ACCESS;
+	int d = allocator.Allocate(unordered, 1, 2);                           // Different binding
+	int e = allocator.Allocate(Desc(64, 64), 1, 2);
+	allocator.EndFrame();
+
+	CHECK(a != b && a != c && a != d);
+	CHECK(b != c && b != d && c != d);
+	CHECK_EQUAL(a, e);
+
+	// Bytes held, and what would be needed without sharing
+	int64_t held = 64 * 64 * 4 + 32 * 32 * 4 + 64 * 64 * 8 + 64 * 64 * 4;
+	CHECK_EQUAL(held, allocator.PooledBytes());
+	CHECK_EQUAL(held + 64 * 64 * 4, allocator.RequestedBytes());
+	CHECK_EQUAL(held, allocator.PeakBytes());
+}
+
+
+TEST(RenderTargetPoolKeepsTargetsBetweenFrames)
+{
+	// The same requests next frame get the same slots, no new targets
+	RenderTargetAllocator allocator;
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		allocator.BeginFrame();
+		CHECK_EQUAL(0, allocator.Allocate(Desc(64, 64), -1, 1));
+		CHECK_EQUAL(1, allocator.Allocate(Desc(64, 64), 0, 2));
+		allocator.EndFrame();
+		CHECK_EQUAL(2, static_cast<int>(allocator.Slots().size()));
+	}
+	CHECK_EQUAL(3, allocator.NumFrames());
+}
+
+
+TEST(RenderTargetPoolReclaimsIdleTargets)
+{
+	RenderTargetAllocator allocator(1); // Reclaimed after more than one idle frame
+	allocator.BeginFrame();
+	allocator.Allocate(Desc(64, 64), -1, 0);
+	allocator.Allocate(Desc(32, 32), -1, 0);
+	allocator.EndFrame();
+
+	// Only the small target used from now on
+	allocator.BeginFrame();
+	allocator.Allocate(Desc(32, 32), -1, 0);
+	allocator.EndFrame();
+	CHECK_EQUAL(2, allocator.NumAliveSlots());
+
+	allocator.BeginFrame();
+	allocator.Allocate(Desc(32, 32), -1, 0);
+	allocator.EndFrame();
+	CHECK_EQUAL(1, allocator.NumAliveSlots());
+	CHECK(!allocator.Slots()[0].alive);
+	CHECK_EQUAL(32 * 32 * 4, allocator.PooledBytes());
+	CHECK_EQUAL(64 * 64 * 4 + 32 * 32 * 4, allocator.PeakBytes());
+
+	// A new target reuses the reclaimed slot's number
+	allocator.BeginFrame();
+	allocator.Allocate(Desc(32, 32), -1, 0);
+	CHECK_EQUAL(0, allocator.Allocate(Desc(16, 16), -1, 0));
+	allocator.EndFrame();
+}
+
+
+TEST(RenderTargetPoolFollowsChainChanges)
+{
+	// Switching from a long chain to an empty one frees all but the scene's target at the end of the frame
+	PostProcessChain chain;
+	for (int i = 0; i < 4; ++i)  chain.push_back({ PostProcess::Burn, PostProcessMode::Fullscreen });
+	RenderGraph graph;
+	RenderTargetAllocator allocator;
+
+	graph.Compile(chain);
+	allocator.BeginFrame();
+	graph.AllocateTargets(allocator, 640, 360);
+	allocator.EndFrame();
+	CHECK_EQUAL(2, allocator.NumAliveSlots());
+
+	graph.Compile({});
+	allocator.BeginFrame();
+	graph.AllocateTargets(allocator, 640, 360);
+	allocator.EndFrame();
+	CHECK_EQUAL(1, allocator.NumAliveSlots());
+	CHECK_EQUAL(640 * 360 * 4, allocator.PooledBytes());
+}
@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// A very small unit test framework for the parts of the project with no DirectX
+//--------------------------------------------------------------------------------------
+// TEST declares a test function and registers it to be run by TestMain.cpp. A failing CHECK
+// reports the file, line and condition and the test carries on, so one run shows every check
+// that fails. The test program runs every test whose name starts with its first argument (all
+// of them with no argument), and returns non-zero if any check failed
+
+#ifndef _TEST_H_INCLUDED_
+#define _TEST_H_INCLUDED_
+
+#include <string>
+
+
+// Add a test to the list run by main, returns true so it can initialise a static. Use through TEST
+bool RegisterTest(const char* name, void (*test)());
+
+// Report a failed check in the test being run. Use through CHECK and CHECK_EQUAL
+void ReportFailure(const char* file, int line, const std::string& message);
+
+
+// Declare and register a test, follow with the body of the test in braces
+#define TEST(name) \
+	static void name(); \
+	static bool name##Registered = RegisterTest(#name, name); \
+	static void name()
+
+// Report a failure if the condition is false
+#define CHECK(condition) \
+	do { if (!(condition))  ReportFailure(__FILE__, __LINE__, #condition); } while (false)
+
+// Report a failure if two numbers (or anything std::to_string accepts) aren't equal, showing both
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		auto expectedValue = (expected); \
+		auto actualValue   = (actual); \
+		if (!(expectedValue == actualValue)) \
+		{ \
+			ReportFailure(__FILE__, __LINE__, std::string(#actual) + " is " + std::to_string(actualValue) + \
+			              ", expected " + std::to_string(expectedValue)); \
+		} \
+	} while (false)
+
+
+#endif //_TEST_H_INCLUDED_
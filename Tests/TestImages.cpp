@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------------------
+// Images and frames for running the CPU post-processing in tests and benchmarks
+//--------------------------------------------------------------------------------------
+
+#include "TestImages.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+TestFrame::TestFrame(int width, int height, TestScene scene, uint32_t seed)
+{
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+	std::mt19937 random(seed);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+			if (scene == TestScene::Noise)
+			{
+				pixel[0] = static_cast<uint8_t>(random());
+				pixel[1] = static_cast<uint8_t>(random());
+				pixel[2] = static_cast<uint8_t>(random());
+			}
+			else
+			{
+				bool checker = ((x * 8 / width) + (y * 8 / height)) % 2 != 0;
+				pixel[0] = static_cast<uint8_t>(x * 255 / std::max(width - 1, 1));
+				pixel[1] = static_cast<uint8_t>(y * 255 / std::max(height - 1, 1));
+				pixel[2] = checker ? 200 : 40;
+			}
+			pixel[3] = 255;
+		}
+	}
+	mScene.LoadRGBA8(pixels.data(), width, height, width * 4);
+
+	std::vector<float> depth(static_cast<size_t>(width) * height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)  depth[static_cast<size_t>(y) * width + x] = 0.9f + 0.1f * x / width;
+	}
+	mDepth.LoadR32F(depth.data(), width, height, width * 4);
+
+	// Movement in UVs in red and green, view space depth in blue (see MotionBlur.h)
+	mVelocity.Resize(width, height, TargetFormat::RGBA16F);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			float movement = (x < width / 2) ? 8.0f / width : 0.0f;
+			mVelocity.Pixel(x, y) = CVector4(movement, 0.0f, 10.0f, 1.0f);
+		}
+	}
+
+	mFrame.sceneColour     = &mScene;
+	mFrame.sceneDepth      = &mDepth;
+	mFrame.sceneVelocity   = &mVelocity;
+	mFrame.timer           = 1.5f;
+	mFrame.effectConstants = DefaultPostProcessEffectConstants(width, height, 1.0f, 10000.0f);
+	mFrame.effectConstants.burn.burnHeight   = 0.4f; // Part way through, so both burnt and unburnt pixels are tested
+	mFrame.effectConstants.spiral.spiralLevel = 3.0f;
+}
+
+
+int MaxDifference(const CPUImage& a, const CPUImage& b)
+{
+	float maxDifference = 0.0f;
+	for (int y = 0; y < a.Height(); ++y)
+	{
+		for (int x = 0; x < a.Width(); ++x)
+		{
+			const CVector4& pixelA = a.Pixel(x, y);
+			const CVector4& pixelB = b.Pixel(x, y);
+			maxDifference = std::max({ maxDifference, std::fabs(pixelA.x - pixelB.x), std::fabs(pixelA.y - pixelB.y),
+			                           std::fabs(pixelA.z - pixelB.z) });
+		}
+	}
+	return static_cast<int>(std::ceil(maxDifference * 255.0f - 0.001f));
+}
+
+
+bool AllFinite(const CPUImage& image)
+{
+	for (int y = 0; y < image.Height(); ++y)
+	{
+		for (int x = 0; x < image.Width(); ++x)
+		{
+			const CVector4& pixel = image.Pixel(x, y);
+			if (!std::isfinite(pixel.x) || !std::isfinite(pixel.y) || !std::isfinite(pixel.z) || !std::isfinite(pixel.w))  return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// Images and frames for running the CPU post-processing in tests and benchmarks
+//--------------------------------------------------------------------------------------
+// A TestFrame owns a made up scene (and its depth and velocity) and a CPUPostProcessFrame set up
+// to post-process it with the settings Scene.cpp starts with. Noise scenes have a random colour
+// in every pixel, to catch any difference between two ways of running an effect. Smooth scenes
+// are gradients with a few hard edges, closer to a rendered image, for measuring quality
+
+#ifndef _TEST_IMAGES_H_INCLUDED_
+#define _TEST_IMAGES_H_INCLUDED_
+
+#include "CPUPostProcessDevice.h"
+
+#include <cstdint>
+
+
+enum class TestScene
+{
+	Noise,  // Random colour in every pixel
+	Smooth, // Gradients in each channel over a coarse checker board
+};
+
+class TestFrame
+{
+public:
+	// A scene of the given size. The depth goes from 0.9 on the left to 1.0 on the right, and the velocity is a slow pan to
+	// the right over the left half of the image, still on the right
+	TestFrame(int width, int height, TestScene scene = TestScene::Noise, uint32_t seed = 5);
+
+	TestFrame(const TestFrame&) = delete;
+	TestFrame& operator=(const TestFrame&) = delete;
+
+	int Width() const   { return mScene.Width(); }
+	int Height() const  { return mScene.Height(); }
+
+	CPUImage            mScene;
+	CPUImage            mDepth;
+	CPUImage            mVelocity;
+	CPUPostProcessFrame mFrame; // Points at the images above, with the default effect settings for the size
+};
+
+
+// Largest difference between two images of the same size in any colour channel of any pixel, in 8-bit steps (rounded up)
+int MaxDifference(const CPUImage& a, const CPUImage& b);
+
+// True if every channel of every pixel is a finite number
+bool AllFinite(const CPUImage& image);
+
+
+#endif //_TEST_IMAGES_H_INCLUDED_
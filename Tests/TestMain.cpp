@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// Runs the registered tests
+//--------------------------------------------------------------------------------------
+
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+
+struct RegisteredTest
+{
+	const char* name;
+	void (*test)();
+};
+
+// A function-local static, so tests registered from other files' statics find it already made
+static std::vector<RegisteredTest>& Tests()
+{
+	static std::vector<RegisteredTest> tests;
+	return tests;
+}
+
+static int gFailures = 0; // Failed checks in the test being run
+
+
+bool RegisterTest(const char* name, void (*test)())
+{
+	Tests().push_back({ name, test });
+	return true;
+}
+
+
+void ReportFailure(const char* file, int line, const std::string& message)
+{
+	printf("  %s(%d): check failed: %s\n", file, line, message.c_str());
+	++gFailures;
+}
+
+
+// Run every test whose name starts with the first argument, or all tests with no argument
+int main(int argc, char* argv[])
+{
+	const char* prefix = (argc > 1) ? argv[1] : "";
+
+	int numRun = 0;
+	int numFailed = 0;
+	for (const RegisteredTest& test : Tests())
+	{
+		if (strncmp(test.name, prefix, strlen(prefix)) != 0)  continue;
+
+		gFailures = 0;
+		test.test();
+		printf("%s %s\n", gFailures == 0 ? "[ pass ]" : "[ FAIL ]", test.name);
+		++numRun;
+		if (gFailures > 0)  ++numFailed;
+	}
+
+	printf("%d tests run, %d failed\n", numRun, numFailed);
+	if (numRun == 0)  return 1; // A misspelt prefix shouldn't look like a pass
+	return numFailed > 0 ? 1 : 0;
+}
@@ -6,6 +6,18 @@
 #include "Common.hlsli"
 
 
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match TintConstants in PostProcessConstants.h
+cbuffer TintConstants : register(b2)
+{
+	float3 gTintColour;
+	float  paddingA;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
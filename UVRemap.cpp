@@ -0,0 +1,51 @@
+//--------------------------------------------------------------------------------------
+// Combining runs of full screen distortions into one pass
+//--------------------------------------------------------------------------------------
+
+#include "UVRemap.h"
+
+#include <algorithm>
+
+
+UVRemapConstants BuildUVRemap(const PostProcessChain& chain, int firstIndex, int count, const PostProcessEffectConstants& settings)
+{
+	UVRemapConstants constants = {};
+	int lastIndex = std::min(firstIndex + std::min(count, MAX_UV_REMAP_EFFECTS), static_cast<int>(chain.size()));
+	for (int chainIndex = firstIndex; chainIndex < lastIndex; ++chainIndex)
+	{
+		UVRemapKind kind = GetPostProcessDeclaration(chain[chainIndex].first).uvRemap;
+		UVRemapStage& stage = constants.stages[constants.numStages++];
+		stage.kind = static_cast<int>(kind);
+
+		switch (kind)
+		{
+		case UVRemapKind::Distort:
+			stage.amount = settings.distort.distortLevel;
+			break;
+
+		case UVRemapKind::Spiral:
+			// Full screen the spiral turns about the centre of the screen
+			stage.amount = settings.spiral.spiralLevel * settings.spiral.spiralLevel;
+			stage.centre = { 0.5f, 0.5f };
+			break;
+
+		case UVRemapKind::HeatHaze:
+			stage.amount = UV_REMAP_HEAT_HAZE_AMOUNT;
+			break;
+
+		case UVRemapKind::Underwater:
+			stage.amount = settings.underwater.amplitude;
+			break;
+
+		case UVRemapKind::ChromaticDistortion:
+			stage.amount  = settings.chromaticDistortion.distortionAmount;
+			stage.chromAb = settings.chromaticDistortion.chromAbAmount;
+			stage.centre  = settings.chromaticDistortion.screenCenter;
+			break;
+
+		default:
+			break;
+		}
+	}
+	return constants;
+}
@@ -0,0 +1,48 @@
+//--------------------------------------------------------------------------------------
+// Combining runs of full screen distortions into one pass
+//--------------------------------------------------------------------------------------
+// Distort, spiral, heat haze, underwater and chromatic distortion each work out a moved UV for the
+// pixel they draw and read the image there (chromatic distortion reads it three times, a UV for
+// each colour channel). Running several in a row reads and writes the whole screen once for every
+// effect. Each also reads the image the effect before wrote with point sampling, snapping its
+// moved UV to the nearest pixel, so the small errors made by each effect add up down the chain.
+//
+// The render graph makes a single UVRemap pass for each such run instead. The UV the last effect
+// reads at is where the effect before it drew, so the pass follows each pixel's UV back through
+// the effects, last first, moving it as each effect would. It then reads the image the run started
+// from once, with bilinear filtering rather than point sampling, and makes each effect's change to
+// the colour on the way back out: distort's darkening and fake lighting, and underwater's tint.
+// Each of these is clamped and rounded just as the 8-bit target between the effects would do it.
+//
+// UVs are clamped to the screen between the effects, as the point sampler clamps them. Chromatic
+// distortion splits the UV in three, and a channel it reads off screen is black from there on. Any
+// effects before it would be followed back once for each channel, costing more than running them
+// on their own, so the graph only puts chromatic distortion at the start of a run.
+//
+// The result differs from running the effects one by one only by the snapping that is no longer
+// done, and bilinear filtering of the one read - MeasureUVRemap (CPUPostProcessDevice.h) compares
+// the two. The pass always takes the full screen path of each effect, so area and polygon effects
+// are never included, and the fake lighting of distort uses the distort map at the UV where distort
+// was run, as the shader does.
+//
+// No DirectX here - Scene.cpp sends the constants to UVRemap_pp.hlsl, CPUUVRemap.h has the CPU version
+
+#ifndef _UV_REMAP_H_INCLUDED_
+#define _UV_REMAP_H_INCLUDED_
+
+#include "PostProcess.h"
+#include "PostProcessConstants.h"
+
+
+// Fixed settings of the effects' shaders, used by the pass in their place
+const float UV_REMAP_DISTORT_LIGHT    = 0.015f; // lightStrength in Distort_pp.hlsl
+const float UV_REMAP_DISTORT_DARKEN   = 0.8f;   // glassDarken
+const float UV_REMAP_HEAT_HAZE_AMOUNT = 0.01f;  // effectStrength in HeatHaze_pp.hlsl
+
+
+// Work out the stages for the given entries of the chain, all of which must have a uvRemap, and at most
+// MAX_UV_REMAP_EFFECTS of them
+UVRemapConstants BuildUVRemap(const PostProcessChain& chain, int firstIndex, int count, const PostProcessEffectConstants& settings);
+
+
+#endif //_UV_REMAP_H_INCLUDED_
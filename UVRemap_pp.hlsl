@@ -0,0 +1,166 @@
+//--------------------------------------------------------------------------------------
+// UV Remap Post-Processing Pixel Shader
+//--------------------------------------------------------------------------------------
+// Several distortions in a row (distort, spiral, heat haze, underwater, chromatic distortion) run
+// as one. The pixel's UV is moved back through the stages, last first, then the image is read once
+// with bilinear filtering and each stage's change to the colour is made on the way back out. See
+// UVRemap.h for the details
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Must match MAX_UV_REMAP_EFFECTS in PostProcess.h
+static const int MaxStages = 6;
+
+// Must match UVRemapKind in PostProcess.h
+static const int StageDistort             = 1;
+static const int StageSpiral              = 2;
+static const int StageHeatHaze            = 3;
+static const int StageUnderwater          = 4;
+static const int StageChromaticDistortion = 5;
+
+// Must match UVRemapStage in PostProcessConstants.h
+struct UVRemapStage
+{
+	int    kind;
+	float  amount;  // Distort level, spiral level squared, heat haze strength, underwater amplitude or lens distortion
+	float  chromAb; // Chromatic aberration of a chromatic distortion stage
+	float  paddingA;
+	float2 centre;  // Centre of a spiral or chromatic distortion stage
+	float2 paddingB;
+};
+
+// Must match UVRemapConstants in PostProcessConstants.h
+cbuffer UVRemapConstants : register(b2)
+{
+	UVRemapStage gStages[MaxStages];
+	int          gNumStages;
+	float3       paddingC;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SceneTexture  : register(t0);
+SamplerState LinearSample  : register(s0); // Bilinear filtering, clamped at the edges
+
+Texture2D    DistortMap    : register(t1); // The distort effect's cut-glass vectors
+SamplerState TrilinearWrap : register(s1);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+// Move a UV back through one stage, for one colour channel (0-2) or for all three together (-1). The fake lighting of a distort
+// stage is written to the channel's part of its entry in lights, or to all three parts. Returns false if a chromatic distortion
+// stage read the channel off screen, where it becomes black
+bool StepBack(int stage, int channel, float2 edgeMin, float2 edgeMax, inout float2 uv, inout float3 lights[MaxStages])
+{
+	UVRemapStage s = gStages[stage];
+	if (s.kind == StageDistort)
+	{
+		float2 distortVector = DistortMap.SampleLevel(TrilinearWrap, uv, 0.0f).gb - float2(0.5f, 0.5f);
+		float light = dot(normalize(distortVector), float2(0.707f, 0.707f)) * 0.015f;
+		if (channel < 0)  lights[stage] = light;
+		else              lights[stage][channel] = light;
+		uv += s.amount * distortVector;
+	}
+	else if (s.kind == StageSpiral)
+	{
+		float2 centreOffsetUV = uv - s.centre;
+		float sn, cs;
+		sincos(length(centreOffsetUV) * s.amount, sn, cs);
+		uv = s.centre + float2(centreOffsetUV.x * cs - centreOffsetUV.y * sn, centreOffsetUV.x * sn + centreOffsetUV.y * cs);
+	}
+	else if (s.kind == StageHeatHaze)
+	{
+		float2 centreVector = uv - float2(0.5f, 0.5f);
+		float alpha = 1.0f - saturate((dot(centreVector, centreVector) - 0.25f + 0.15f) / 0.15f);
+		float SinX = sin(uv.x * radians(1440.0f) + gTimer * 3.0f);
+		float SinY = sin(uv.y * radians(3600.0f) + gTimer * 3.7f);
+		uv += float2(SinY, SinX) * s.amount * alpha;
+	}
+	else if (s.kind == StageUnderwater)
+	{
+		float2 offset = float2(sin(uv.x * radians(360.0f) + gTimer * 3.0f), cos(uv.y * radians(360.0f) + gTimer * 3.0f));
+		uv += offset * s.amount;
+	}
+	else if (s.kind == StageChromaticDistortion)
+	{
+		// Red is pushed out from the centre and blue pulled in, either side of the lens distortion of green
+		float2 offset = uv - s.centre;
+		float dist = length(offset);
+		float2 direction = normalize(offset);
+		uv = s.centre + direction * (dist * (1.0f + s.amount * dist * dist) + (1 - channel) * s.chromAb * dist);
+
+		// Reads off screen are black rather than clamped
+		if (uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f)  return false;
+	}
+
+	// The effect before drew whole pixels, so a read past the edge got the edge pixel
+	uv = clamp(uv, edgeMin, edgeMax);
+	return true;
+}
+
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+	float2 size;
+	SceneTexture.GetDimensions(size.x, size.y);
+	float2 edgeMin = 0.5f / size; // Centres of the edge pixels, where the point sampler of each effect stopped
+	float2 edgeMax = 1.0f - edgeMin;
+
+	float3 lights[MaxStages] = { float3(0, 0, 0), float3(0, 0, 0), float3(0, 0, 0), float3(0, 0, 0), float3(0, 0, 0), float3(0, 0, 0) };
+	int3   startStage = int3(0, 0, 0);
+	float3 colour;
+
+	// Back through the stages, the channels together until a chromatic distortion stage splits them
+	float2 uv = input.sceneUV;
+	int stage = gNumStages - 1;
+	for (; stage >= 0 && gStages[stage].kind != StageChromaticDistortion; --stage)
+	{
+		StepBack(stage, -1, edgeMin, edgeMax, uv, lights);
+	}
+	if (stage < 0)
+	{
+		colour = SceneTexture.Sample(LinearSample, uv).rgb;
+	}
+	else
+	{
+		// From there each channel is followed on its own and read at its own UV
+		[unroll] for (int channel = 0; channel < 3; ++channel)
+		{
+			float2 channelUV = uv;
+			for (int channelStage = stage; channelStage >= 0; --channelStage)
+			{
+				if (!StepBack(channelStage, channel, edgeMin, edgeMax, channelUV, lights))
+				{
+					startStage[channel] = channelStage + 1;
+					break;
+				}
+			}
+			colour[channel] = startStage[channel] == 0 ? SceneTexture.Sample(LinearSample, channelUV)[channel] : 0.0f;
+		}
+	}
+
+	// Each stage's change to the colour, in the order the effects were run. A channel is black up to the stage it starts at
+	for (int forwardStage = 0; forwardStage < gNumStages; ++forwardStage)
+	{
+		int kind = gStages[forwardStage].kind;
+		if      (kind == StageDistort)     colour = colour * 0.8f + lights[forwardStage];
+		else if (kind == StageUnderwater)  colour *= float3(0.0f, 0.3f, 0.6f);
+		colour *= (forwardStage >= startStage);
+
+		// Clamp and round to 8 bits, as writing to the target between the effects did
+		if (forwardStage < gNumStages - 1)  colour = floor(saturate(colour) * 255.0f + 0.5f) / 255.0f;
+	}
+
+	return float4(colour, 1.0f);
+}
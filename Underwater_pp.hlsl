@@ -8,6 +8,19 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match UnderwaterConstants in PostProcessConstants.h
+cbuffer UnderwaterConstants : register(b2)
+{
+	float  gFrequency;
+	float  gAmplitude;
+	float2 paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures (texture maps)
 //--------------------------------------------------------------------------------------
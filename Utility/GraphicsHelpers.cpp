@@ -12,6 +12,120 @@
 #include <cctype>
 #include <atlbase.h> // C-string to unicode conversion function CA2CT
 
+//--------------------------------------------------------------------------------------
+// Constant uploads
+//--------------------------------------------------------------------------------------
+
+// Starting size of the buffer shared by all constant uploads. Large enough for several frames of changes, so the buffer is
+// rarely discarded. gConstantUploader makes it larger if a frame needs more than half of it (e.g. the stress test's models)
+const int CONSTANT_UPLOAD_BUFFER_BYTES = 1024 * 1024;
+
+ConstantUploader gConstantUploader(CONSTANT_UPLOAD_BUFFER_BYTES);
+ID3D11Buffer*    gConstantUploadBuffer = nullptr;
+int              gConstantUploadBufferBytes = 0;
+
+// The slot bound to each constant buffer number of each shader stage (vertex, geometry, pixel, compute) this frame. When the
+// buffer is discarded part way through a frame the blocks move, so they are all bound again
+const int NUM_SHADER_STAGES = 4;
+const ConstantSlot* gBoundConstants[NUM_SHADER_STAGES][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {};
+
+
+bool CreateConstantUploadBuffer()
+{
+    gConstantUploadBuffer = CreateConstantBuffer(gConstantUploader.Capacity());
+    gConstantUploadBufferBytes = gConstantUploader.Capacity();
+    return gConstantUploadBuffer != nullptr;
+}
+
+void ReleaseConstantUploadBuffer()
+{
+    if (gConstantUploadBuffer)  gConstantUploadBuffer->Release();
+    gConstantUploadBuffer = nullptr;
+    gConstantUploadBufferBytes = 0;
+}
+
+
+void BeginConstantUploadFrame()
+{
+    gConstantUploader.BeginFrame();
+    for (auto& stageSlots : gBoundConstants)
+    {
+        for (auto& slot : stageSlots)  slot = nullptr;
+    }
+}
+
+
+// Point a shader stage's constant buffer at a slot's block
+static void SetConstants(const ConstantSlot& slot, int bufferNumber, unsigned int shaderStages)
+{
+    // Offsets and sizes are given in constants (16 bytes each)
+    UINT firstConstant = slot.offset / CONSTANT_BYTES;
+    UINT numConstants  = slot.size   / CONSTANT_BYTES;
+    if (shaderStages & SHADER_STAGE_VERTEX)    gD3DContext1->VSSetConstantBuffers1(bufferNumber, 1, &gConstantUploadBuffer, &firstConstant, &numConstants);
+    if (shaderStages & SHADER_STAGE_GEOMETRY)  gD3DContext1->GSSetConstantBuffers1(bufferNumber, 1, &gConstantUploadBuffer, &firstConstant, &numConstants);
+    if (shaderStages & SHADER_STAGE_PIXEL)     gD3DContext1->PSSetConstantBuffers1(bufferNumber, 1, &gConstantUploadBuffer, &firstConstant, &numConstants);
+    if (shaderStages & SHADER_STAGE_COMPUTE)   gD3DContext1->CSSetConstantBuffers1(bufferNumber, 1, &gConstantUploadBuffer, &firstConstant, &numConstants);
+}
+
+
+void FlushConstantUploads()
+{
+    // Nothing to write (or no buffer to write to), just count and forget the staged blocks
+    if (!gConstantUploader.NeedsFlush() || gConstantUploadBuffer == nullptr)
+    {
+        gConstantUploader.Flush(nullptr);
+        return;
+    }
+
+    // The uploader makes the ring larger when a frame's constants don't fit, which needs a new buffer
+    if (gConstantUploadBufferBytes != gConstantUploader.Capacity())
+    {
+        ReleaseConstantUploadBuffer();
+        if (!CreateConstantUploadBuffer())
+        {
+            gLastError = "Error creating larger constant upload buffer";
+            gConstantUploader.Flush(nullptr);
+            return;
+        }
+    }
+
+    // Only discard the buffer when the ring has wrapped around, otherwise the GPU may still be reading earlier blocks
+    bool discard = gConstantUploader.FlushNeedsDiscard();
+    D3D11_MAP mapType = discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(gD3DContext->Map(gConstantUploadBuffer, 0, mapType, 0, &mapped)))  return;
+    gConstantUploader.Flush(mapped.pData);
+    gD3DContext->Unmap(gConstantUploadBuffer, 0);
+
+    // After a discard every block uploaded this frame has been written again at a new offset (perhaps in a new buffer),
+    // so the blocks bound so far must be bound again - e.g. the per-frame constants bound before drawing all the models
+    if (discard)
+    {
+        for (int stage = 0; stage < NUM_SHADER_STAGES; ++stage)
+        {
+            for (int bufferNumber = 0; bufferNumber < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++bufferNumber)
+            {
+                const ConstantSlot* slot = gBoundConstants[stage][bufferNumber];
+                if (slot && slot->offset >= 0)  SetConstants(*slot, bufferNumber, 1u << stage);
+            }
+        }
+    }
+}
+
+
+void BindConstants(const ConstantSlot& slot, int bufferNumber, unsigned int shaderStages)
+{
+    FlushConstantUploads();
+    if (slot.offset < 0 || gConstantUploadBuffer == nullptr)  return;
+
+    for (int stage = 0; stage < NUM_SHADER_STAGES; ++stage)
+    {
+        if (shaderStages & (1u << stage))  gBoundConstants[stage][bufferNumber] = &slot;
+    }
+    SetConstants(slot, bufferNumber, shaderStages);
+}
+
+
 //--------------------------------------------------------------------------------------
 // Texture Loading
 //--------------------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 
 #include "CMatrix4x4.h"
 #include "../Common.h"
+#include "../ConstantUpload.h"
 #include <d3d11.h>
 
 
@@ -28,6 +29,40 @@ void UpdateConstantBuffer(ID3D11Buffer* buffer, const T& bufferData)
 }
 
 
+// The function above maps the buffer every time it is called, even if the data hasn't changed. The scene and the post-processes
+// instead upload their constants through gConstantUploader, which skips unchanged data and puts all blocks in one large buffer
+// (see ConstantUpload.h). Each block has a ConstantSlot that remembers where it is in the buffer
+extern ConstantUploader gConstantUploader;
+
+// Create the GPU buffer used by gConstantUploader, returns false on failure
+bool CreateConstantUploadBuffer();
+void ReleaseConstantUploadBuffer();
+
+// Start a new frame of constant uploads, call before anything is uploaded for the frame
+void BeginConstantUploadFrame();
+
+// Stage a structure of constants for the given slot. It is written to the GPU when the slot is next bound (or flushed)
+template <class T>
+void UploadConstants(ConstantSlot& slot, const T& constants)
+{
+    gConstantUploader.Upload(slot, &constants, sizeof(T));
+}
+
+// Write all staged constants to the GPU with a single map. Nothing is mapped if none of them changed. If the buffer had to be
+// discarded (or made larger) the blocks bound this frame have moved, so they are bound again
+void FlushConstantUploads();
+
+// Shader stages to bind constants to, combine with |
+const unsigned int SHADER_STAGE_VERTEX   = 1;
+const unsigned int SHADER_STAGE_GEOMETRY = 2;
+const unsigned int SHADER_STAGE_PIXEL    = 4;
+const unsigned int SHADER_STAGE_COMPUTE  = 8;
+
+// Bind the constants in a slot to the given constant buffer number (b0, b1 etc. in the shader) for the given shader stages
+// Flushes any staged constants first, so several uploads followed by a bind only map the buffer once
+void BindConstants(const ConstantSlot& slot, int bufferNumber, unsigned int shaderStages);
+
+
 //--------------------------------------------------------------------------------------
 // Texture Loading
 //--------------------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------------------
+// Instanced Velocity Vertex Shader
+//--------------------------------------------------------------------------------------
+// Same as the Velocity_vs shader, but for meshes drawn with instancing (as PixelLightingInstanced_vs).
+// The copies keep their place from frame to frame, so only the camera's movement is included. This
+// frame's position uses the same 'precise' steps as PixelLightingInstanced_vs for the same depth
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Instances
+//--------------------------------------------------------------------------------------
+
+// The copies to draw, filled in by the C++ side (see InstanceBatch.h)
+StructuredBuffer<MeshInstance> MeshInstances : register(t1);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+VelocityPixelShaderInput main(BasicVertex modelVertex, uint instanceId : SV_InstanceID)
+{
+    VelocityPixelShaderInput output;
+
+    precise float4 worldPosition     = mul(MeshInstances[instanceId].worldMatrix, float4(modelVertex.position, 1));
+    precise float4 viewPosition      = mul(gViewMatrix,       worldPosition);
+    precise float4 projectedPosition = mul(gProjectionMatrix, viewPosition);
+    output.projectedPosition = projectedPosition;
+    output.currentPosition   = projectedPosition;
+    output.previousPosition  = mul(gPreviousViewProjectionMatrix, worldPosition);
+
+    return output;
+}
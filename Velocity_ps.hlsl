@@ -0,0 +1,23 @@
+//--------------------------------------------------------------------------------------
+// Velocity Pixel Shader
+//--------------------------------------------------------------------------------------
+// Writes the velocity of each pixel of the scene for the motion blur (see MotionBlur.h): how far it
+// moved across the screen since the last frame in UVs in red and green, and its view space depth in
+// blue so the blur can tell which of two pixels is in front
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(VelocityPixelShaderInput input) : SV_Target
+{
+    // Perspective divide, then from projection space (-1 to 1, y up) to UVs (0 to 1, y down)
+    float2 currentUV  = input.currentPosition.xy  / input.currentPosition.w  * float2(0.5f, -0.5f);
+    float2 previousUV = input.previousPosition.xy / input.previousPosition.w * float2(0.5f, -0.5f);
+
+    // The w of the projected position is the depth in view space
+    return float4(currentUV - previousUV, input.currentPosition.w, 1.0f);
+}
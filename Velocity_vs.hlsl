@@ -0,0 +1,33 @@
+//--------------------------------------------------------------------------------------
+// Velocity Vertex Shader
+//--------------------------------------------------------------------------------------
+// Used by the velocity pass of the scene (see ScenePass in RenderGraph.h), which writes how far
+// each pixel moved across the screen since the last frame. Each vertex is transformed twice, with
+// this frame's world and view-projection matrices and with last frame's, so the movement of both
+// the camera and the model are included.
+// The pass tests against the depth written by the other scene shaders, without writing its own, so this
+// frame's position must be found with exactly the same world, view, projection steps they use, and all
+// of them marked 'precise'. With the premultiplied view-projection matrix the depth rounds differently
+// and many pixels fail the test
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+VelocityPixelShaderInput main(BasicVertex modelVertex)
+{
+    VelocityPixelShaderInput output;
+
+    float4 modelPosition = float4(modelVertex.position, 1);
+    precise float4 worldPosition     = mul(gWorldMatrix,      modelPosition);
+    precise float4 viewPosition      = mul(gViewMatrix,       worldPosition);
+    precise float4 projectedPosition = mul(gProjectionMatrix, viewPosition);
+    output.projectedPosition = projectedPosition;
+    output.currentPosition   = projectedPosition;
+    output.previousPosition  = mul(gPreviousViewProjectionMatrix, mul(gPreviousWorldMatrix, modelPosition));
+
+    return output;
+}
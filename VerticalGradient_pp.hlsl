@@ -6,6 +6,21 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match VerticalGradientConstants in PostProcessConstants.h
+cbuffer VerticalGradientConstants : register(b2)
+{
+	float3 gTopColour;
+	float  paddingA;
+
+	float3 gBottomColour;
+	float  paddingB;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures and Sampler
 //--------------------------------------------------------------------------------------
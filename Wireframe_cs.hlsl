@@ -0,0 +1,98 @@
+//--------------------------------------------------------------------------------------
+// Wireframe Compute Shader (Sobel Edge Detection)
+//--------------------------------------------------------------------------------------
+// The full screen version of Wireframe_pp.hlsl, giving the same result. Each thread group reads
+// the luminance of its tile and one sample step around it into group shared memory, then each
+// thread runs the Sobel filter for its pixel from there (see ComputeTile.h)
+//--------------------------------------------------------------------------------------
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match WireframeConstants in PostProcessConstants.h
+cbuffer WireframeConstants : register(b2)
+{
+	float  gEdgeThreshold;
+	float  gEdgePower;
+	float2 paddingA;
+}
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+Texture2D<float4>   SceneTexture  : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+//--------------------------------------------------------------------------------------
+// Group shared memory
+//--------------------------------------------------------------------------------------
+
+// Must match GetComputeTileShape in ComputeTile.cpp and COMPUTE_TILE_MAX_WIREFRAME_STEP in ComputeTile.h
+static const int TileSize = 16;
+static const int MaxStep  = 4;
+
+static const int MaxSpan = TileSize + 2 * MaxStep;
+
+// Luminance of the tile and the pixels around it, a row at a time
+groupshared float gLuminance[MaxSpan * MaxSpan];
+
+//--------------------------------------------------------------------------------------
+// Shader Code
+//--------------------------------------------------------------------------------------
+
+[numthreads(TileSize, TileSize, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 groupThreadID : SV_GroupThreadID, uint threadIndex : SV_GroupIndex)
+{
+    uint imageWidth, imageHeight;
+    SceneTexture.GetDimensions(imageWidth, imageHeight);
+    int2 imageSize = int2(imageWidth, imageHeight);
+
+    // The step between samples in pixels, which is also the apron around the tile
+    int2 step = clamp(int2(gTexelSize * float2(imageSize) + 0.5f), 0, MaxStep);
+    int2 span = TileSize + 2 * step;
+    int2 loadStart = int2(groupID.xy) * TileSize - step;
+
+    // Load the luminance of each pixel once, reads past the edges of the image give the edge pixel
+    for (int i = threadIndex; i < span.x * span.y; i += TileSize * TileSize)
+    {
+        int2 pixel = clamp(loadStart + int2(i % span.x, i / span.x), 0, imageSize - 1);
+        gLuminance[i] = dot(SceneTexture[pixel].rgb, float3(0.299f, 0.587f, 0.114f));
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Sobel kernels, used in the same order as the pixel shader
+    const int numKernel = 9;
+    const float kernelX[numKernel] = { -1.0f, 0.0f, 1.0f, -2.0f, 0.0f, 2.0f, -1.0f, 0.0f, 1.0f };
+    const float kernelY[numKernel] = { -1.0f, -2.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 1.0f };
+
+    float gradientX = 0.0f;
+    float gradientY = 0.0f;
+    int index = 0;
+    int2 centre = int2(groupThreadID.xy) + step;
+    for (int x = -1; x <= 1; x++)
+    {
+        for (int y = -1; y <= 1; y++)
+        {
+            int2 tap = centre + int2(x, y) * step;
+            float gray = gLuminance[tap.y * span.x + tap.x];
+            gradientX += gray * kernelX[index];
+            gradientY += gray * kernelY[index];
+            index++;
+        }
+    }
+    float edge = sqrt(gradientX * gradientX + gradientY * gradientY);
+
+    // Enhance and threshold edges, white on black
+    edge = saturate(pow(edge, gEdgePower) * (1.0f / gEdgeThreshold));
+
+    int2 pixel = int2(groupID.xy) * TileSize + int2(groupThreadID.xy);
+    if (all(pixel < imageSize))
+    {
+        OutputTexture[pixel] = float4(edge, edge, edge, 1.0f);
+    }
+}
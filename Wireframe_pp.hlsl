@@ -5,6 +5,19 @@
 
 #include "Common.hlsli"
 
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match WireframeConstants in PostProcessConstants.h
+cbuffer WireframeConstants : register(b2)
+{
+	float  gEdgeThreshold;
+	float  gEdgePower;
+	float2 paddingA;
+}
+
 //--------------------------------------------------------------------------------------
 // Textures
 //--------------------------------------------------------------------------------------